@@ -317,6 +317,8 @@ int  xine_get_param (xine_stream_t *stream, int param) XINE_PROTECTED;
 #define XINE_PARAM_EARLY_FINISHED_EVENT   31 /* send event when demux finish*/
 #define XINE_PARAM_GAPLESS_SWITCH         32 /* next stream only gapless swi*/
 #define XINE_PARAM_DELAY_FINISHED_EVENT   33 /* 1/10sec,0=>disable,-1=>forev*/
+#define XINE_PARAM_AUDIO_CLOCK_DRIFT      34 /* readonly, sound card, ppm   */
+#define XINE_PARAM_AUDIO_CLOCK_JITTER     35 /* readonly, unit: 1/90000 sec */
 
 /*
  * speed values for XINE_PARAM_SPEED parameter.
@@ -1050,6 +1052,39 @@ const char *xine_get_meta_info   (xine_stream_t *stream, int info) XINE_PROTECTE
 /* post-1.1.18.1 */
 #define XINE_META_INFO_DISCNUMBER	   26
 
+/*
+ * pipeline latency
+ *
+ * while the engine.performance.latency_trace config entry is set, buffers
+ * are stamped when they pass each of these stages. the stamps travel with
+ * decoded frames (of the last buffer that went into them) to the outputs.
+ */
+#define XINE_LATENCY_READ                  0 /* buffer allocated by input/demuxer */
+#define XINE_LATENCY_PUT                   1 /* put into the decoder fifo */
+#define XINE_LATENCY_GET                   2 /* taken by the decoder */
+#define XINE_LATENCY_DECODED               3 /* frame handed to the output */
+#define XINE_LATENCY_OUTPUT                4 /* frame shown / samples written to the driver */
+#define XINE_LATENCY_STAGES                5
+
+typedef struct {
+  int64_t   frames;                         /* frames that reached the output */
+  /* [i] is the time from stage i-1 to stage i, [0] from read to output */
+  uint64_t  total_ns[XINE_LATENCY_STAGES];  /* summed over all frames */
+  uint64_t  max_ns[XINE_LATENCY_STAGES];
+  uint64_t  last_ns;                        /* read to output of the latest frame */
+} xine_latency_t;
+
+/*
+ * get the latency breakdown of a stream's video (XINE_LATENCY_VIDEO)
+ * or audio (XINE_LATENCY_AUDIO) since it was opened
+ *
+ * returns 1 on success, 0 if no frame was traced
+ */
+int xine_get_latency (xine_stream_t *stream, int type, xine_latency_t *latency) XINE_PROTECTED;
+
+#define XINE_LATENCY_VIDEO                 0
+#define XINE_LATENCY_AUDIO                 1
+
 
 /*********************************************************************
  * plugin management / autoplay / mrl browsing                       *
@@ -1725,6 +1760,8 @@ void xine_config_reset (xine_t *self) XINE_PROTECTED;
  *    process them and free them using xine_event_free
  * 2) use xine_event_create_listener_thread and specify a callback
  *    which will then be called for each event
+ * 3) use xine_event_create_batch_listener_thread and specify a callback
+ *    which will then be called with all events that arrived meanwhile
  *
  * to send events to every module listening you don't need
  * to register an event queue but simply call xine_event_send.
@@ -2164,6 +2201,20 @@ void xine_event_create_listener_thread (xine_event_queue_t *queue,
 					xine_event_listener_cb_t callback,
 					void *user_data) XINE_PROTECTED;
 
+/*
+ * receive events (batch callback)
+ *
+ * like above, but the callback gets every event that is pending when
+ * the thread wakes up (in order, at least one), which saves wakeups
+ * when events come in bursts. events are freed when it returns.
+ */
+typedef void (*xine_event_batch_listener_cb_t) (void *user_data,
+						const xine_event_t *const *events,
+						int num_events);
+void xine_event_create_batch_listener_thread (xine_event_queue_t *queue,
+					      xine_event_batch_listener_cb_t callback,
+					      void *user_data) XINE_PROTECTED;
+
 /*
  * send an event to all queues
  *
@@ -344,12 +344,15 @@ int _x_ao_channels2mode( int channels ) XINE_PROTECTED;
 #define AO_PROP_BUFS_TOTAL     21 /* read-only */
 #define AO_PROP_BUFS_FREE      22 /* read-only */
 #define AO_PROP_DRIVER_DELAY   23 /* read-only */
-#define AO_NUM_PROPERTIES      24
+#define AO_PROP_CLOCK_DRIFT    24 /* read-only, sound card against master clock, ppm */
+#define AO_PROP_CLOCK_JITTER   25 /* read-only, of the measured drift, pts */
+#define AO_NUM_PROPERTIES      26
 
 /* audio device control ops */
 #define AO_CTRL_PLAY_PAUSE	0
 #define AO_CTRL_PLAY_RESUME	1
 #define AO_CTRL_FLUSH_BUFFERS	2
+#define AO_CTRL_FREE_RUN	3 /* int arg: 1 = don't pace write ()/delay (), the clock follows us */
 
 /* above that value audio frames are discarded */
 #define AO_MAX_GAP              15000
@@ -320,6 +320,9 @@ struct extra_info_s {
 
   int                   invalid;       /**< do not use this extra info to update anything */
   int                   total_time;    /**< duration in miliseconds of the stream */
+
+  uint64_t              latency[5];    /**< monotonic ns when passing the XINE_LATENCY_*
+                                        *   stages, 0 when not traced */
 };
 
 
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * Hash map with open addressing.
+ *
+ * Keys and values are pointers. Keys are compared by identity, unless
+ * hash and compare functions are given (e.g. xine_hash_str for strings).
+ * A set is a map that stores NULL values. Keys must not be NULL.
+ *
+ * Key/value pairs live in one power of 2 sized table, which is searched
+ * by linear probing and grows at 3/4 load. Removed elements leave a mark
+ * behind, so removing the element at an iterator does not disturb the
+ * iteration. Adding an element may invalidate all iterators.
+ *
+ * Exemples:
+ *
+ *   Create a set of pointers:
+ *     xine_hash_t *set = xine_hash_new(0, NULL, NULL);
+ *     xine_hash_put(set, frame, NULL);
+ *     if (xine_hash_find(set, frame)) ...
+ *
+ *   Walk thru a map:
+ *     xine_hash_iterator_t ite = xine_hash_next(map, NULL);
+ *     while (ite) {
+ *       _useful code here_
+ *       ite = xine_hash_next(map, ite);
+ *     }
+ */
+#ifndef XINE_HASH_H
+#define XINE_HASH_H
+
+/* Hash map type */
+typedef struct xine_hash_s xine_hash_t;
+
+/* Hash map iterator */
+typedef void* xine_hash_iterator_t;
+
+/* Key hash function */
+typedef unsigned int (*xine_hash_func_t) (const void *key);
+
+/* Key compare function, returns 0 if equal */
+typedef int (*xine_hash_compare_func_t) (const void *key1, const void *key2);
+
+/* Constructor. Room for initial_size elements without growing,
+   NULL functions for keys compared by identity */
+xine_hash_t *xine_hash_new(unsigned int initial_size,
+                           xine_hash_func_t hash, xine_hash_compare_func_t compare) XINE_MALLOC XINE_PROTECTED;
+
+/* Destructor */
+void xine_hash_delete(xine_hash_t *hash) XINE_PROTECTED;
+
+/* Returns the number of elements stored in the map */
+unsigned int xine_hash_size(const xine_hash_t *hash) XINE_PROTECTED;
+
+/* Removes all elements from a map */
+void xine_hash_clear(xine_hash_t *hash) XINE_PROTECTED;
+
+/* Adds the key with the value, or replaces the value of the key.
+   Returns 1 if added, 0 if replaced and -1 if out of memory */
+int xine_hash_put(xine_hash_t *hash, const void *key, void *value) XINE_PROTECTED;
+
+/* Returns an iterator that references the key, or NULL if not found */
+xine_hash_iterator_t xine_hash_find(xine_hash_t *hash, const void *key) XINE_PROTECTED;
+
+/* Returns the value of the key, or NULL if not found */
+void *xine_hash_get(xine_hash_t *hash, const void *key) XINE_PROTECTED;
+
+/* Removes the key. Returns 1 if found, 0 otherwise */
+int xine_hash_remove(xine_hash_t *hash, const void *key) XINE_PROTECTED;
+
+/* Removes the element at the iterator's position, which stays valid
+   for xine_hash_next() */
+void xine_hash_remove_at(xine_hash_t *hash, xine_hash_iterator_t ite) XINE_PROTECTED;
+
+/* Returns an iterator that references the element following ite, the
+   first one if ite is NULL, or NULL at the end. The order is arbitrary. */
+xine_hash_iterator_t xine_hash_next(xine_hash_t *hash, xine_hash_iterator_t ite) XINE_PROTECTED;
+
+/* Returns the key and the value at the position specified by the iterator */
+const void *xine_hash_get_key(xine_hash_t *hash, xine_hash_iterator_t ite) XINE_PROTECTED;
+void *xine_hash_get_value(xine_hash_t *hash, xine_hash_iterator_t ite) XINE_PROTECTED;
+
+/* Hash and compare functions for string keys */
+unsigned int xine_hash_str(const void *key) XINE_PROTECTED;
+int xine_hash_str_compare(const void *key1, const void *key2) XINE_PROTECTED;
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * Intrusive doubly-linked list.
+ *
+ * The elements embed the list node, so adding and removing never
+ * allocates, and an element removes itself without searching the list.
+ * An element is in one list per node at a time.
+ *
+ * Exemples:
+ *
+ *   typedef struct {
+ *     xine_ilist_node_t node;
+ *     ...
+ *   } foo_t;
+ *
+ *   Create a list:
+ *     xine_ilist_t list;
+ *     xine_ilist_init(&list);
+ *
+ *   Add and remove an element:
+ *     xine_ilist_push_back(&list, &foo->node);
+ *     xine_ilist_remove(&list, &foo->node);
+ *
+ *   Walk thru a list:
+ *     xine_ilist_node_t *node = xine_ilist_front(&list);
+ *     while (node) {
+ *       foo_t *foo = xine_ilist_entry(node, foo_t, node);
+ *       _useful code here_
+ *       node = xine_ilist_next(&list, node);
+ *     }
+ */
+#ifndef XINE_ILIST_H
+#define XINE_ILIST_H
+
+#include <stddef.h>
+
+/* List node, embedded in the elements */
+typedef struct xine_ilist_node_s xine_ilist_node_t;
+struct xine_ilist_node_s {
+  xine_ilist_node_t *next;
+  xine_ilist_node_t *prev;
+};
+
+/* List type, a circle through head */
+typedef struct {
+  xine_ilist_node_t head;
+  unsigned int      size;
+} xine_ilist_t;
+
+/* Returns the element containing node */
+#define xine_ilist_entry(node, type, member) \
+  ((type *) ((char *) (node) - offsetof (type, member)))
+
+/* Constructor */
+static inline void xine_ilist_init(xine_ilist_t *list) {
+  list->head.next = list->head.prev = &list->head;
+  list->size = 0;
+}
+
+/* Returns the number of elements stored in the list */
+static inline unsigned int xine_ilist_size(const xine_ilist_t *list) {
+  return list->size;
+}
+
+/* Returns true if the number of elements is zero, false otherwise */
+static inline int xine_ilist_empty(const xine_ilist_t *list) {
+  return list->head.next == &list->head;
+}
+
+/* Returns true if the node is in a list. Nodes must be cleared
+   (e.g. by calloc) before their first use for that. */
+static inline int xine_ilist_linked(const xine_ilist_node_t *node) {
+  return node->next != NULL;
+}
+
+/* Inserts the node before the position */
+static inline void xine_ilist_insert(xine_ilist_t *list, xine_ilist_node_t *position,
+                                     xine_ilist_node_t *node) {
+  node->next = position;
+  node->prev = position->prev;
+  position->prev->next = node;
+  position->prev = node;
+  list->size++;
+}
+
+/* Adds the node at the end of the list */
+static inline void xine_ilist_push_back(xine_ilist_t *list, xine_ilist_node_t *node) {
+  xine_ilist_insert(list, &list->head, node);
+}
+
+/* Adds the node at the beginning of the list */
+static inline void xine_ilist_push_front(xine_ilist_t *list, xine_ilist_node_t *node) {
+  xine_ilist_insert(list, list->head.next, node);
+}
+
+/* Removes the node from the list, and marks it unlinked */
+static inline void xine_ilist_remove(xine_ilist_t *list, xine_ilist_node_t *node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next = node->prev = NULL;
+  list->size--;
+}
+
+/* Returns the first node, or NULL if the list is empty */
+static inline xine_ilist_node_t *xine_ilist_front(const xine_ilist_t *list) {
+  return list->head.next != &list->head ? list->head.next : NULL;
+}
+
+/* Returns the last node, or NULL if the list is empty */
+static inline xine_ilist_node_t *xine_ilist_back(const xine_ilist_t *list) {
+  return list->head.prev != &list->head ? list->head.prev : NULL;
+}
+
+/* Returns the node following node, or NULL at the end of the list */
+static inline xine_ilist_node_t *xine_ilist_next(const xine_ilist_t *list, const xine_ilist_node_t *node) {
+  return node->next != &list->head ? node->next : NULL;
+}
+
+/* Returns the node preceding node, or NULL at the beginning of the list */
+static inline xine_ilist_node_t *xine_ilist_prev(const xine_ilist_t *list, const xine_ilist_node_t *node) {
+  return node->prev != &list->head ? node->prev : NULL;
+}
+
+/* Removes and returns the first node, or NULL if the list is empty */
+static inline xine_ilist_node_t *xine_ilist_pop_front(xine_ilist_t *list) {
+  xine_ilist_node_t *node = xine_ilist_front(list);
+
+  if (node)
+    xine_ilist_remove(list, node);
+  return node;
+}
+
+#endif
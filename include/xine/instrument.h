@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * Instrumentation
+ *
+ * Named tracepoints count events and time code sections. Every thread
+ * updates counters of its own without locking; snapshots sum them up.
+ * While instrumentation is disabled, a tracepoint costs one load and
+ * one branch.
+ *
+ *   static xine_tracepoint_t tp_decode = XINE_TRACEPOINT ("video_decoder.decode");
+ *   uint64_t t = xine_tp_start ();
+ *   ...
+ *   xine_tp_stop (tp_decode, t);
+ *
+ * The engine enables instrumentation and dumps it to the trace log
+ * periodically when told so by the engine.performance.instrument*
+ * config entries.
+ */
+#ifndef XINE_INSTRUMENT_H
+#define XINE_INSTRUMENT_H
+
+#include <xine/os_types.h>
+#include <xine/attributes.h>
+
+/* number of distinct tracepoint names */
+#define XINE_TRACEPOINTS_MAX  128
+
+/* latency histogram: bucket 0 counts sections shorter than 2^11 ns,
+ * bucket i > 0 those of [2^(i+10), 2^(i+11)) ns, the last one all
+ * longer ones (>= 8.6 s) */
+#define XINE_TP_BUCKETS       24
+
+typedef struct {
+  const char *name;
+  int         id;      /* assigned on first use */
+} xine_tracepoint_t;
+
+#define XINE_TRACEPOINT(name) { name, 0 }
+
+extern int xine_instrument_enabled XINE_PROTECTED;
+
+void xine_tp_hit_int (xine_tracepoint_t *tp, int64_t n) XINE_PROTECTED;
+void xine_tp_time_int (xine_tracepoint_t *tp, uint64_t start) XINE_PROTECTED;
+
+/* monotonic time in ns, never 0 */
+uint64_t xine_instrument_now (void) XINE_PROTECTED;
+
+/* count n events (or units, e.g. bytes) */
+#define xine_tp_hit(tp, n) \
+  do { if (xine_instrument_enabled) xine_tp_hit_int (&(tp), (n)); } while (0)
+
+/* time a section. a section started while disabled is not recorded. */
+#define xine_tp_start()  (xine_instrument_enabled ? xine_instrument_now () : 0)
+#define xine_tp_stop(tp, start) \
+  do { if (start) xine_tp_time_int (&(tp), (start)); } while (0)
+
+typedef struct {
+  const char *name;
+  uint64_t    hits;       /* sum of xine_tp_hit() counts */
+  uint64_t    timed;      /* sections timed */
+  uint64_t    total_ns;
+  uint64_t    max_ns;
+  uint64_t    histogram[XINE_TP_BUCKETS];
+} xine_tp_stats_t;
+
+void xine_instrument_enable (int enable) XINE_PROTECTED;
+
+/* Fills in up to max entries, in order of first use, and returns how many
+ * were filled in. Counters of running threads are read while they change,
+ * so a snapshot is not exact but never blocks them.
+ */
+int xine_instrument_snapshot (xine_tp_stats_t *stats, int max) XINE_PROTECTED;
+
+/* Starts counting from zero again */
+void xine_instrument_reset (void) XINE_PROTECTED;
+
+/* Estimates the duration below which the given fraction (0..1) of
+ * sections stayed, from the histogram.
+ */
+uint64_t xine_tp_stats_percentile (const xine_tp_stats_t *stats, double fraction) XINE_PROTECTED;
+
+/* Formats a snapshot as text, one line per call of print */
+void xine_instrument_dump (void (*print) (void *data, const char *line), void *data) XINE_PROTECTED;
+
+#endif
@@ -311,6 +311,22 @@ struct metronom_clock_s {
 #ifdef METRONOM_CLOCK_INTERNAL
   pthread_mutex_t lock;
   pthread_cond_t  cancel;
+
+  /* free-run mode, see CLOCK_FREE_RUN */
+  pthread_cond_t  free_run_changed;
+  int             free_run;
+  int64_t         free_run_vpts;
+  uint32_t        free_run_clients;  /* slots in use */
+  int64_t         free_run_waiting[32];
+
+  /* slave SCRs against the master, see CLOCK_SCR_DRIFT */
+  int64_t         scr_drift;
+  int64_t         scr_jitter;
+
+  /* between stop_clock () and resume_clock () */
+  int             stopped;
+
+  struct xine_task_s *sync_task;     /* instead of sync_thread on xine->executor */
 #endif
 };
 
@@ -321,6 +337,15 @@ metronom_clock_t *_x_metronom_clock_init(xine_t *xine) XINE_MALLOC XINE_PROTECTE
  */
 
 #define CLOCK_SCR_ADJUSTABLE   1
+/* free-run: the clock no longer follows real time. it stands still until
+ * the output loops are ready for their next frame or sample, and then
+ * jumps right there. outputs neither sleep nor drop in this mode. */
+#define CLOCK_FREE_RUN         2
+/* read-only: slave SCRs are slewed to follow the master continuously.
+ * estimated rate error of the one drifting most (ppm), and the jitter
+ * of its measured offset (pts). */
+#define CLOCK_SCR_DRIFT        3
+#define CLOCK_SCR_JITTER       4
 
 /*
  * SCR (system clock reference) plugins
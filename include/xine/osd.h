@@ -33,6 +33,15 @@ typedef struct osd_object_s osd_object_t;
 typedef struct osd_renderer_s osd_renderer_t;
 typedef struct osd_font_s osd_font_t;
 typedef struct osd_ft2context_s osd_ft2context_t;
+typedef struct osd_rle_band_s osd_rle_band_t;
+typedef struct osd_ft2cache_s osd_ft2cache_t;
+
+/* freetype glyph and text cache counters, see get_cache_stats () */
+typedef struct {
+  unsigned glyph_hits, glyph_misses;
+  unsigned text_hits, text_misses;
+  unsigned glyphs;      /* glyphs cached right now */
+} osd_cache_stats_t;
 
 struct osd_object_s {
   osd_object_t *next;
@@ -68,10 +77,16 @@ struct osd_object_s {
 
   /* this holds an optional ARGB overlay, which
    * is only be used by supported video_out modules.
-   * right now this is only vdpau */
+   * right now these are vdpau, xv and xcbxv */
   argb_layer_t *argb_layer;
 
   int32_t handle;
+
+  /* rle code of the work area, kept in bands of lines so that only
+   * lines painted on since the last show are encoded again.
+   * code writing to area directly must reset rle_x2 to 0. */
+  osd_rle_band_t *rle_bands;
+  int rle_x1, rle_x2;           /* columns the bands were encoded for */
 };
 
 /* this one is public */
@@ -256,7 +271,14 @@ struct osd_renderer_s {
   osd_object_t               *osds;          /* instances of osd */
   osd_font_t                 *fonts;         /* loaded fonts */
   int                        textpalette;    /* default textpalette */
+  osd_ft2cache_t             *ft2caches;     /* glyph caches of freetype fonts */
+  osd_cache_stats_t           ft2stats;      /* counters of released caches */
 
+  /*
+   * get the freetype cache counters of all fonts since the renderer was
+   * initialized. everything stays 0 without freetype support.
+   */
+  void (*get_cache_stats) (osd_renderer_t *this, osd_cache_stats_t *stats);
 };
 
 /*
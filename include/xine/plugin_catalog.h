@@ -56,6 +56,11 @@ struct plugin_catalog_s {
   xine_sarray_t   *cache_list;
   xine_list_t     *file_list;
 
+  /* cache_list index: first node of a file by file name,
+   * next node of the same file by node */
+  xine_hash_t     *cache_files;
+  xine_hash_t     *cache_next;
+
   plugin_node_t   *audio_decoder_map[DECODER_MAX][PLUGINS_PER_TYPE];
   plugin_node_t   *video_decoder_map[DECODER_MAX][PLUGINS_PER_TYPE];
   plugin_node_t   *spu_decoder_map[DECODER_MAX][PLUGINS_PER_TYPE];
@@ -465,8 +465,19 @@ typedef struct argb_layer_s {
   int x1, y1;
   int x2, y2;
   int ref_count;
+  /* buffer size, the pitch is width pixels */
+  int width, height;
+  /* buffer position of the overlay's top left pixel */
+  int ovl_x, ovl_y;
+  /* serial of the last update of each ARGB_TILE_SIZE square tile (row major),
+   * used by software blending to convert only what has changed.
+   * serials are unique across all layers. */
+  uint32_t serial;
+  uint32_t *tile_serial;
 } argb_layer_t;
 
+#define ARGB_TILE_SIZE 64
+
 struct vo_overlay_s {
 
   rle_elem_t       *rle;           /* rle code buffer                  */
@@ -29,6 +29,10 @@
 #define CLUT_Y_CR_CB_INIT(_y,_cr,_cb)	{ (_cb), (_cr), (_y) }
 #endif
 
+/* The overlay manager grows its tables as needed and does not enforce
+ * these limits any more. Decoders still use them to size their own
+ * handle arrays.
+ */
 #define MAX_OBJECTS   50
 #define MAX_EVENTS    50
 #define MAX_SHOWING   (5 + 16)
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * Worker Pool
+ *
+ * A small set of persistent threads used to split a piece of work
+ * (typically an image) into independent slices. The calling thread takes
+ * part in the work, so a pool without threads simply runs every slice
+ * inline.
+ */
+#ifndef XINE_WORKER_POOL_H
+#define XINE_WORKER_POOL_H
+
+typedef struct xine_worker_pool_s xine_worker_pool_t;
+
+/* Slice callback
+ *   data:       the pointer given to xine_worker_pool_run()
+ *   slice:      index of the slice to process, 0 <= slice < num_slices
+ *   num_slices: total number of slices of this run
+ */
+typedef void (*xine_worker_job_t)(void *data, int slice, int num_slices);
+
+/* Creates a new pool
+ *   num_threads: number of helper threads, 0 picks one less than the
+ *                number of online cpus.
+ */
+xine_worker_pool_t *xine_worker_pool_new(int num_threads) XINE_MALLOC XINE_PROTECTED;
+
+/* Deletes a pool, waiting for the helper threads to terminate */
+void xine_worker_pool_delete(xine_worker_pool_t *pool) XINE_PROTECTED;
+
+/* Returns the number of threads working on a run, including the caller.
+ * This is a good default for the number of slices.
+ */
+int xine_worker_pool_size(xine_worker_pool_t *pool) XINE_PROTECTED;
+
+/* Calls job for every slice in [0, num_slices) and waits until all of
+ * them are done. Concurrent runs on the same pool are serialized.
+ */
+void xine_worker_pool_run(xine_worker_pool_t *pool, int num_slices,
+                          xine_worker_job_t job, void *data) XINE_PROTECTED;
+
+#endif
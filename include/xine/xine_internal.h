@@ -47,6 +47,7 @@ extern "C" {
 #include <xine/io_helper.h>
 #include <xine/info_helper.h>
 #include <xine/alphablend.h>
+#include <xine/ilist.h>
 
 #define XINE_MAX_EVENT_LISTENERS         50
 #define XINE_MAX_EVENT_TYPES             100
@@ -104,8 +105,24 @@ struct xine_s {
   xine_ticket_t             *port_ticket;
   pthread_mutex_t            log_lock;
 
+  /* shared engine threads, NULL if every stream has its own */
+  struct xine_executor_s    *executor;
+
   xine_log_cb_t              log_cb;
   void                      *log_cb_user_data;
+
+  /* periodic dump of instrumentation counters to the trace log */
+  pthread_t                  instrument_thread;
+  pthread_mutex_t            instrument_lock;
+  pthread_cond_t             instrument_wake;
+  int                        instrument_interval;  /* seconds, 0 = off */
+  int                        instrument_running;
+  int                        instrument_quit;
+
+  /* chrome trace of the pipeline latency, see latency.c */
+  FILE                      *latency_trace;
+  pthread_mutex_t            latency_lock;
+  int                        latency_streams;
 #endif
 };
 
@@ -278,6 +295,7 @@ struct xine_stream_s {
 
 /*  vo_driver_t               *video_driver;*/
   pthread_t                  video_thread;
+  struct xine_task_s        *video_decoder_task;   /*< instead of video_thread on xine->executor */
   video_decoder_t           *video_decoder_plugin;
   extra_info_t              *video_decoder_extra_info;
   int                        video_decoder_streamtype;
@@ -288,6 +306,7 @@ struct xine_stream_s {
 
   int                        audio_decoder_streamtype;
   pthread_t                  audio_thread;
+  struct xine_task_s        *audio_decoder_task;   /*< instead of audio_thread on xine->executor */
   audio_decoder_t           *audio_decoder_plugin;
   extra_info_t              *audio_decoder_extra_info;
 
@@ -334,11 +353,12 @@ struct xine_stream_s {
   int                        finished_count_video;
 
   /* event mechanism */
-  xine_list_t               *event_queues;
+  xine_ilist_t               event_queues;
   pthread_mutex_t            event_queues_lock;
 
   /* demux thread stuff */
   pthread_t                  demux_thread;
+  struct xine_task_s        *demux_task;           /*< instead of demux_thread on xine->executor */
   pthread_mutex_t            demux_lock;
   pthread_mutex_t            demux_action_lock;
   pthread_cond_t             demux_resume;
@@ -360,6 +380,10 @@ struct xine_stream_s {
   broadcaster_t             *broadcaster;
 
   refcounter_t              *refcounter;
+
+  /* pipeline latency, XINE_LATENCY_VIDEO/AUDIO (see latency.c) */
+  xine_latency_t             latency[2];
+  int                        latency_id;        /* pid in the trace file */
 #endif
 };
 
@@ -37,10 +37,13 @@ extern "C" {
 #include <xine/os_types.h>
 #include <xine/attributes.h>
 #include <xine/compat.h>
+#include <xine/instrument.h>
 #include <xine/xmlparser.h>
 #include <xine/xine_buffer.h>
 #include <xine/configfile.h>
 #include <xine/list.h>
+#include <xine/ilist.h>
+#include <xine/hash.h>
 #include <xine/array.h>
 #include <xine/sorted_array.h>
 
@@ -97,6 +100,7 @@ extern "C" {
 #define MM_ACCEL_X86_SSE4       0x01000000
 #define MM_ACCEL_X86_SSE42      0x00800000
 #define MM_ACCEL_X86_AVX        0x00400000
+#define MM_ACCEL_X86_AVX2       0x00200000
 
 /* powerpc accelerations and features */
 #define MM_ACCEL_PPC_ALTIVEC    0x04000000
@@ -126,7 +130,8 @@ extern void *(* xine_fast_memcpy)(void *to, const void *from, size_t len) XINE_P
  * Debug stuff
  */
 /*
- * profiling (unworkable in non DEBUG isn't defined)
+ * profiling, the old interface to the tracepoints of instrument.h.
+ * xine_profiler_init() enables instrumentation.
  */
 void xine_profiler_init (void) XINE_PROTECTED;
 int xine_profiler_allocate_slot (const char *label) XINE_PROTECTED;
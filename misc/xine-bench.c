@@ -0,0 +1,567 @@
+/*
+ * Copyright (C) 2010 the xine-project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * xine-bench: headless throughput benchmark for the decode pipeline.
+ *
+ * Streams are decoded into framegrab ports. Those have no output
+ * thread: nothing is synced to the clock and no frame is dropped or
+ * skipped, the pipeline runs as fast as the consumer threads here pick
+ * up frames, which is immediately. Reported are input bytes, decoded
+ * frames per second, fill levels of the demuxer -> decoder fifos and
+ * CPU time per thread (Linux only).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define XINE_ENABLE_EXPERIMENTAL_FEATURES
+#include <xine/xine_internal.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/syscall.h>
+#endif
+
+#define XINE_BENCH_VERSION_N(x,y) #x"."#y
+#define XINE_BENCH_VERSION XINE_BENCH_VERSION_N(XINE_MAJOR_VERSION,XINE_MINOR_VERSION)
+
+#define MAX_POSTS   8
+#define MAX_THREADS 64
+
+typedef struct {
+  int       samples;
+  int64_t   sum;
+  int       max;
+  int       min_free;
+} queue_stats_t;
+
+typedef struct {
+  int       tid;
+  char      name[24];
+  long      start, last;  /* clock ticks */
+} thread_stats_t;
+
+typedef struct {
+  xine_stream_t      *stream;
+  xine_video_port_t  *vo;
+  xine_audio_port_t  *ao;
+
+  volatile int        done;
+  int                 interval;  /* ms */
+
+  int64_t             video_frames;
+  int64_t             audio_frames;
+  int64_t             audio_samples;
+  double              video_last;  /* time of the last frame */
+  double              audio_last;
+
+  pthread_mutex_t     lock;      /* for the stats below */
+  queue_stats_t       video_fifo;
+  queue_stats_t       audio_fifo;
+  thread_stats_t      threads[MAX_THREADS];
+  int                 num_threads;
+} bench_t;
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double cpu_time (void)
+{
+  struct rusage ru;
+  getrusage (RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static int gettid_ (void)
+{
+#if defined(__linux__) && defined(SYS_gettid)
+  return syscall (SYS_gettid);
+#else
+  return 0;
+#endif
+}
+
+/*
+ * per thread cpu time from /proc/self/task. threads are kept after they
+ * terminate, with the last value seen.
+ */
+static thread_stats_t *thread_find (bench_t *this, int tid)
+{
+  int i;
+
+  for (i = 0; i < this->num_threads; i++)
+    if (this->threads[i].tid == tid)
+      return &this->threads[i];
+  if (this->num_threads >= MAX_THREADS)
+    return NULL;
+  i = this->num_threads++;
+  this->threads[i].tid = tid;
+  this->threads[i].start = -1;
+  strcpy (this->threads[i].name, "engine");
+  return &this->threads[i];
+}
+
+static void thread_name (bench_t *this, const char *name)
+{
+  thread_stats_t *t;
+
+  pthread_mutex_lock (&this->lock);
+  if ((t = thread_find (this, gettid_ ())))
+    snprintf (t->name, sizeof (t->name), "%s", name);
+  pthread_mutex_unlock (&this->lock);
+}
+
+static void threads_sample (bench_t *this)
+{
+#ifdef __linux__
+  DIR *dir;
+  struct dirent *ent;
+
+  if (!(dir = opendir ("/proc/self/task")))
+    return;
+
+  while ((ent = readdir (dir))) {
+    char path[64], buf[512], *p;
+    unsigned long utime, stime;
+    thread_stats_t *t;
+    FILE *f;
+    int tid = atoi (ent->d_name);
+
+    if (tid <= 0)
+      continue;
+    snprintf (path, sizeof (path), "/proc/self/task/%d/stat", tid);
+    if (!(f = fopen (path, "r")))
+      continue;
+    p = fgets (buf, sizeof (buf), f);
+    fclose (f);
+    /* the command may contain spaces, fields are counted after it */
+    if (!p || !(p = strrchr (buf, ')')))
+      continue;
+    if (sscanf (p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                &utime, &stime) != 2)
+      continue;
+
+    if ((t = thread_find (this, tid))) {
+      if (t->start < 0)
+        t->start = utime + stime;
+      t->last = utime + stime;
+    }
+  }
+  closedir (dir);
+#endif
+}
+
+static void queue_sample (queue_stats_t *q, fifo_buffer_t *fifo)
+{
+  int size, free_bufs;
+
+  if (!fifo)
+    return;
+  size      = fifo->fifo_size;
+  free_bufs = fifo->buffer_pool_num_free;
+  q->samples++;
+  q->sum += size;
+  if (size > q->max)
+    q->max = size;
+  if (q->samples == 1 || free_bufs < q->min_free)
+    q->min_free = free_bufs;
+}
+
+static void *sampler_loop (void *this_gen)
+{
+  bench_t *this = (bench_t *) this_gen;
+
+  thread_name (this, "bench sampler");
+
+  while (!this->done) {
+    pthread_mutex_lock (&this->lock);
+    queue_sample (&this->video_fifo, this->stream->video_fifo);
+    queue_sample (&this->audio_fifo, this->stream->audio_fifo);
+    threads_sample (this);
+    pthread_mutex_unlock (&this->lock);
+    xine_usec_sleep (this->interval * 1000);
+  }
+  return NULL;
+}
+
+/*
+ * frames are picked up as soon as they are there. xine_get_next_*_frame()
+ * return 0 whenever the queue is empty and the demuxer has finished, so
+ * the consumers keep asking until playback has finished for sure.
+ */
+static void *video_loop (void *this_gen)
+{
+  bench_t *this = (bench_t *) this_gen;
+  xine_video_frame_t frame;
+
+  thread_name (this, "bench video consumer");
+
+  while (1) {
+    int done = this->done;
+
+    /* the port does not know the stream before the decoder opened it */
+    if (this->vo->get_property (this->vo, VO_PROP_NUM_STREAMS) > 0 &&
+        xine_get_next_video_frame (this->vo, &frame)) {
+      xine_free_video_frame (this->vo, &frame);
+      this->video_frames++;
+      this->video_last = now ();
+      continue;
+    }
+    if (done)
+      break;
+    xine_usec_sleep (1000);
+  }
+  return NULL;
+}
+
+static void *audio_loop (void *this_gen)
+{
+  bench_t *this = (bench_t *) this_gen;
+  xine_audio_frame_t frame;
+
+  thread_name (this, "bench audio consumer");
+
+  while (1) {
+    int done = this->done;
+
+    if (this->ao->get_property (this->ao, AO_PROP_NUM_STREAMS) > 0 &&
+        xine_get_next_audio_frame (this->ao, &frame)) {
+      this->audio_samples += frame.num_samples;
+      xine_free_audio_frame (this->ao, &frame);
+      this->audio_frames++;
+      this->audio_last = now ();
+      continue;
+    }
+    if (done)
+      break;
+    xine_usec_sleep (1000);
+  }
+  return NULL;
+}
+
+static void report_queue (const char *name, const queue_stats_t *q, const fifo_buffer_t *fifo)
+{
+  if (!q->samples || !fifo)
+    return;
+  printf ("  queue  %-24s avg %6.1f  max %4d  of %4d bufs, min free %d\n", name,
+          (double) q->sum / q->samples, q->max, fifo->buffer_pool_capacity, q->min_free);
+}
+
+static void report_latency (const char *name, xine_stream_t *stream, int type)
+{
+  xine_latency_t l;
+
+  if (!xine_get_latency (stream, type, &l))
+    return;
+  printf ("  latency %-5s ms avg/max: demux %.2f/%.2f  fifo %.2f/%.2f  decode %.2f/%.2f"
+          "  output %.2f/%.2f  total %.2f/%.2f\n", name,
+          l.total_ns[XINE_LATENCY_PUT] / 1e6 / l.frames, l.max_ns[XINE_LATENCY_PUT] / 1e6,
+          l.total_ns[XINE_LATENCY_GET] / 1e6 / l.frames, l.max_ns[XINE_LATENCY_GET] / 1e6,
+          l.total_ns[XINE_LATENCY_DECODED] / 1e6 / l.frames, l.max_ns[XINE_LATENCY_DECODED] / 1e6,
+          l.total_ns[XINE_LATENCY_OUTPUT] / 1e6 / l.frames, l.max_ns[XINE_LATENCY_OUTPUT] / 1e6,
+          l.total_ns[0] / 1e6 / l.frames, l.max_ns[0] / 1e6);
+}
+
+static int bench_mrl (xine_t *xine, const char *mrl, char **posts, int num_posts,
+                      int ignore_video, int ignore_audio, int interval)
+{
+  bench_t              bench;
+  xine_post_t         *post[MAX_POSTS];
+  xine_video_port_t   *vo_in;
+  xine_event_queue_t  *queue;
+  xine_event_t        *event;
+  pthread_t            sampler, video, audio;
+  double               t0, t1, t2, c0, c1;
+  off_t                bytes = 0;
+  const char          *codec;
+  long                 hz;
+  int                  i, ret = 1;
+
+  memset (&bench, 0, sizeof (bench));
+  pthread_mutex_init (&bench.lock, NULL);
+  bench.interval = interval;
+  thread_name (&bench, "main");
+
+  bench.vo = xine_new_framegrab_video_port (xine);
+  bench.ao = xine_new_framegrab_audio_port (xine);
+  if (!bench.vo || !bench.ao) {
+    fputs ("xine-bench: cannot open framegrab ports\n", stderr);
+    goto fail_ports;
+  }
+
+  /* video post chain, first named plugin gets the decoded frames */
+  vo_in = bench.vo;
+  for (i = num_posts - 1; i >= 0; i--) {
+    post[i] = xine_post_init (xine, posts[i], 0, NULL, &vo_in);
+    if (!post[i] || !post[i]->video_input[0]) {
+      fprintf (stderr, "xine-bench: cannot use post plugin %s\n", posts[i]);
+      if (post[i])
+        xine_post_dispose (xine, post[i]);
+      while (++i < num_posts)
+        xine_post_dispose (xine, post[i]);
+      goto fail_ports;
+    }
+    vo_in = post[i]->video_input[0];
+  }
+
+  bench.stream = xine_stream_new (xine, bench.ao, vo_in);
+  if (!bench.stream)
+    goto fail_stream;
+  xine_set_param (bench.stream, XINE_PARAM_IGNORE_VIDEO, ignore_video);
+  xine_set_param (bench.stream, XINE_PARAM_IGNORE_AUDIO, ignore_audio);
+  queue = xine_event_new_queue (bench.stream);
+
+  if (!xine_open (bench.stream, mrl)) {
+    fprintf (stderr, "xine-bench: cannot open %s\n", mrl);
+    goto fail_open;
+  }
+
+  printf ("%s\n", mrl);
+
+  pthread_create (&sampler, NULL, sampler_loop, &bench);
+  pthread_create (&video, NULL, video_loop, &bench);
+  pthread_create (&audio, NULL, audio_loop, &bench);
+
+  t0 = now ();
+  c0 = cpu_time ();
+
+  if (xine_play (bench.stream, 0, 0)) {
+    while ((event = xine_event_wait (queue))) {
+      int type = event->type;
+      xine_event_free (event);
+      if (type == XINE_EVENT_UI_PLAYBACK_FINISHED)
+        break;
+    }
+    ret = 0;
+  } else
+    fprintf (stderr, "xine-bench: cannot play %s\n", mrl);
+
+  t1 = now ();
+  c1 = cpu_time ();
+
+  bench.done = 1;
+  pthread_join (video, NULL);
+  pthread_join (audio, NULL);
+  pthread_join (sampler, NULL);
+
+  if (bench.stream->input_plugin) {
+    bytes = bench.stream->input_plugin->get_current_pos (bench.stream->input_plugin);
+    if (bytes <= 0)
+      bytes = bench.stream->input_plugin->get_length (bench.stream->input_plugin);
+  }
+
+  if (t1 <= t0)
+    t1 = t0 + 1e-6;
+
+  /* the engine polls for the end of stream in steps of 0.1 s, rates
+   * are taken up to the last frame instead */
+  t2 = bench.video_last > bench.audio_last ? bench.video_last : bench.audio_last;
+  if (t2 <= t0 || t2 > t1)
+    t2 = t1;
+
+  printf ("  time   %.3f s wall, %.3f s to last frame, %.3f s cpu (%.0f%%)\n",
+          t1 - t0, t2 - t0, c1 - c0, 100.0 * (c1 - c0) / (t1 - t0));
+  t1 = t2;
+  if (bytes > 0)
+    printf ("  demux  %.2f MB, %.2f MB/s\n", bytes / 1048576.0, bytes / 1048576.0 / (t1 - t0));
+
+  codec = xine_get_meta_info (bench.stream, XINE_META_INFO_VIDEOCODEC);
+  if (bench.video_frames || codec)
+    printf ("  video  %-24s %8" PRId64 " frames, %.1f frames/s\n", codec ? codec : "?",
+            bench.video_frames, bench.video_frames / (t1 - t0));
+  codec = xine_get_meta_info (bench.stream, XINE_META_INFO_AUDIOCODEC);
+  if (bench.audio_frames || codec)
+    printf ("  audio  %-24s %8" PRId64 " frames, %.1f frames/s, %.0f samples/s\n", codec ? codec : "?",
+            bench.audio_frames, bench.audio_frames / (t1 - t0), bench.audio_samples / (t1 - t0));
+
+  report_queue ("demux -> video decoder", &bench.video_fifo, bench.stream->video_fifo);
+  report_queue ("demux -> audio decoder", &bench.audio_fifo, bench.stream->audio_fifo);
+  report_latency ("video", bench.stream, XINE_LATENCY_VIDEO);
+  report_latency ("audio", bench.stream, XINE_LATENCY_AUDIO);
+
+  hz = sysconf (_SC_CLK_TCK);
+  for (i = 0; i < bench.num_threads; i++) {
+    thread_stats_t *t = &bench.threads[i];
+    if (t->start >= 0 && t->last > t->start && hz > 0)
+      printf ("  thread %-24s %6d %8.3f s cpu\n", t->name, t->tid, (double) (t->last - t->start) / hz);
+  }
+
+  xine_close (bench.stream);
+ fail_open:
+  xine_event_dispose_queue (queue);
+  xine_dispose (bench.stream);
+ fail_stream:
+  for (i = 0; i < num_posts; i++)
+    xine_post_dispose (xine, post[i]);
+ fail_ports:
+  if (bench.vo)
+    xine_close_video_driver (xine, bench.vo);
+  if (bench.ao)
+    xine_close_audio_driver (xine, bench.ao);
+  pthread_mutex_destroy (&bench.lock);
+  return ret;
+}
+
+int main (int argc, char *argv[])
+{
+  int optstate = 0;
+  int repeat = 1, interval = 10;
+  int ignore_video = 0, ignore_audio = 0, latency = 0;
+  const char *config = NULL;
+  char *posts[MAX_POSTS];
+  int num_posts = 0;
+  int ret = 0;
+  int i, n;
+
+  for (;;)
+  {
+#define OPTS "hvc:n:i:p:lAV"
+#ifdef HAVE_GETOPT_LONG
+    static const struct option longopts[] = {
+      { "help", no_argument, NULL, 'h' },
+      { "version", no_argument, NULL, 'v' },
+      { "config", required_argument, NULL, 'c' },
+      { "repeat", required_argument, NULL, 'n' },
+      { "interval", required_argument, NULL, 'i' },
+      { "post", required_argument, NULL, 'p' },
+      { "latency", no_argument, NULL, 'l' },
+      { "no-audio", no_argument, NULL, 'A' },
+      { "no-video", no_argument, NULL, 'V' },
+      { NULL }
+    };
+    int index = 0;
+    int opt = getopt_long (argc, argv, OPTS, longopts, &index);
+#else
+    int opt = getopt(argc, argv, OPTS);
+#endif
+    if (opt == -1)
+      break;
+
+    switch (opt)
+    {
+    case 'h':
+      optstate |= 1;
+      break;
+    case 'v':
+      optstate |= 4;
+      break;
+    case 'c':
+      config = optarg;
+      break;
+    case 'n':
+      repeat = atoi (optarg);
+      if (repeat < 1)
+        optstate |= 2;
+      break;
+    case 'i':
+      interval = atoi (optarg);
+      if (interval < 1)
+        optstate |= 2;
+      break;
+    case 'p':
+      if (num_posts < MAX_POSTS)
+        posts[num_posts++] = optarg;
+      else
+        optstate |= 2;
+      break;
+    case 'l':
+      latency = 1;
+      break;
+    case 'A':
+      ignore_audio = 1;
+      break;
+    case 'V':
+      ignore_video = 1;
+      break;
+    default:
+      optstate |= 2;
+      break;
+    }
+  }
+
+  if (optstate & 1)
+    printf ("\
+xine-bench-"XINE_BENCH_VERSION" %s\n\
+using xine-lib %s\n\
+usage: %s [options] mrl...\n\
+options:\n\
+  -h, --help		this help text\n\
+  -c, --config FILE	load this config file (default: none)\n\
+  -n, --repeat N	decode each mrl N times\n\
+  -i, --interval MS	queue and thread sampling interval (default: 10)\n\
+  -p, --post NAME	add a video post plugin, may be given %d times\n\
+  -l, --latency		trace and report the latency of every frame\n\
+  -A, --no-audio	do not decode audio\n\
+  -V, --no-video	do not decode video\n\
+\n", XINE_VERSION, xine_get_version_string (), argv[0], MAX_POSTS);
+  else if (optstate & 4)
+    printf ("\
+xine-bench %s\n\
+using xine-lib %s\n\
+(c) 2010 the xine project team\n\
+This is free software; see the source for copying conditions.  There is NO\n\
+warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE,\n\
+to the extent permitted by law.\n",
+	     XINE_VERSION, xine_get_version_string ());
+
+  if ((optstate & 2) || (!optstate && optind >= argc))
+  {
+    fputs ("xine-bench: invalid option or no mrl (try -h or --help)\n", stderr);
+    return 1;
+  }
+
+  if (optstate)
+    return 0;
+
+  xine_t *xine = xine_new ();
+  xine_set_flags (xine, XINE_FLAG_NO_WRITE_CACHE);
+  /* defaults unless asked otherwise, results should not depend on
+   * whoever happens to run this */
+  if (config)
+    xine_config_load (xine, config);
+  xine_init (xine);
+
+  if (latency) {
+    xine_cfg_entry_t entry;
+    if (xine_config_lookup_entry (xine, "engine.performance.latency_trace", &entry)) {
+      entry.num_value = 1;
+      xine_config_update_entry (xine, &entry);
+    }
+  }
+
+  for (i = optind; i < argc; i++)
+    for (n = 0; n < repeat; n++)
+      ret |= bench_mrl (xine, argv[i], posts, num_posts, ignore_video, ignore_audio, interval);
+
+  xine_exit (xine);
+  return ret;
+}
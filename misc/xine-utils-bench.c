@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2010 the xine-project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * xine-utils-bench: microbenchmark of the xine-utils containers.
+ *
+ * Compares xine_list_t with xine_hash_t and xine_ilist_t for the access
+ * patterns they replaced in the engine: a set of frame pointers that is
+ * searched on every release (ffmpeg direct rendering), elements that
+ * unlink themselves (event queues) and lookups by file name (plugin
+ * catalog). Reported is the time per operation for each size.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <xine.h>
+#include <xine/xineutils.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#define MAX_SIZES 16
+
+typedef struct {
+  xine_ilist_node_t node;
+  int               n;
+} elem_t;
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* the same pseudo random sequence for every container */
+static unsigned int next_rand (unsigned int *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+static void report (const char *what, int size, int ops, double list_s, double other_s)
+{
+  printf ("  %-28s %6d   list %9.1f ns   new %9.1f ns   %6.1fx\n", what, size,
+          list_s * 1e9 / ops, other_s * 1e9 / ops, other_s > 0 ? list_s / other_s : 0.0);
+}
+
+/* release a random frame: find it, remove it, add it again */
+static void bench_pointer_set (elem_t *elems, int size, int ops)
+{
+  xine_list_t *list = xine_list_new ();
+  xine_hash_t *hash = xine_hash_new (0, NULL, NULL);
+  unsigned int seed;
+  double t0, t1, t2;
+  int i;
+
+  for (i = 0; i < size; i++) {
+    xine_list_push_back (list, &elems[i]);
+    xine_hash_put (hash, &elems[i], NULL);
+  }
+
+  seed = 1;
+  t0 = now ();
+  for (i = 0; i < ops; i++) {
+    elem_t *e = &elems[next_rand (&seed) % size];
+    xine_list_iterator_t ite = xine_list_find (list, e);
+    if (ite) {
+      xine_list_remove (list, ite);
+      xine_list_push_back (list, e);
+    }
+  }
+  t1 = now ();
+  seed = 1;
+  for (i = 0; i < ops; i++) {
+    elem_t *e = &elems[next_rand (&seed) % size];
+    if (xine_hash_remove (hash, e))
+      xine_hash_put (hash, e, NULL);
+  }
+  t2 = now ();
+
+  report ("pointer set find/remove/add", size, ops, t1 - t0, t2 - t1);
+
+  xine_hash_delete (hash);
+  xine_list_delete (list);
+}
+
+/* a random element leaves its list and joins again */
+static void bench_unlink (elem_t *elems, int size, int ops)
+{
+  xine_list_t *list = xine_list_new ();
+  xine_ilist_t ilist;
+  unsigned int seed;
+  double t0, t1, t2;
+  int i;
+
+  xine_ilist_init (&ilist);
+  for (i = 0; i < size; i++) {
+    xine_list_push_back (list, &elems[i]);
+    xine_ilist_push_back (&ilist, &elems[i].node);
+  }
+
+  seed = 2;
+  t0 = now ();
+  for (i = 0; i < ops; i++) {
+    elem_t *e = &elems[next_rand (&seed) % size];
+    xine_list_remove (list, xine_list_find (list, e));
+    xine_list_push_back (list, e);
+  }
+  t1 = now ();
+  seed = 2;
+  for (i = 0; i < ops; i++) {
+    elem_t *e = &elems[next_rand (&seed) % size];
+    xine_ilist_remove (&ilist, &e->node);
+    xine_ilist_push_back (&ilist, &e->node);
+  }
+  t2 = now ();
+
+  report ("unlink/add", size, ops, t1 - t0, t2 - t1);
+
+  while (xine_ilist_pop_front (&ilist))
+    ;
+  xine_list_delete (list);
+}
+
+/* look up a random file name */
+static void bench_names (int size, int ops)
+{
+  xine_list_t *list = xine_list_new ();
+  xine_hash_t *hash = xine_hash_new (0, xine_hash_str, xine_hash_str_compare);
+  char **names = calloc (size, sizeof (char *));
+  char name[64];
+  unsigned int seed;
+  double t0, t1, t2;
+  int i, found = 0;
+
+  if (!names || !list || !hash)
+    goto out;
+
+  for (i = 0; i < size; i++) {
+    snprintf (name, sizeof (name), "/usr/lib/xine/plugins/2.0/xineplug_%06d.so", i);
+    names[i] = strdup (name);
+    if (!names[i])
+      goto out;
+    xine_list_push_back (list, names[i]);
+    xine_hash_put (hash, names[i], names[i]);
+  }
+
+  /* look up copies, not the stored pointers */
+  seed = 3;
+  t0 = now ();
+  for (i = 0; i < ops; i++) {
+    xine_list_iterator_t ite;
+    snprintf (name, sizeof (name), "/usr/lib/xine/plugins/2.0/xineplug_%06u.so", next_rand (&seed) % size);
+    for (ite = xine_list_front (list); ite; ite = xine_list_next (list, ite))
+      if (!strcmp (xine_list_get_value (list, ite), name)) {
+        found++;
+        break;
+      }
+  }
+  t1 = now ();
+  seed = 3;
+  for (i = 0; i < ops; i++) {
+    snprintf (name, sizeof (name), "/usr/lib/xine/plugins/2.0/xineplug_%06u.so", next_rand (&seed) % size);
+    if (xine_hash_get (hash, name))
+      found--;
+  }
+  t2 = now ();
+
+  report ("file name lookup", size, ops, t1 - t0, t2 - t1);
+  if (found)
+    fputs ("xine-utils-bench: lookups differ\n", stderr);
+
+out:
+  if (names)
+    for (i = 0; i < size; i++)
+      free (names[i]);
+  free (names);
+  if (hash)
+    xine_hash_delete (hash);
+  if (list)
+    xine_list_delete (list);
+}
+
+int main (int argc, char *argv[])
+{
+  int sizes[MAX_SIZES] = { 4, 16, 64, 256, 1024 };
+  int num_sizes = 5, user_sizes = 0;
+  int ops = 1000000;
+  int opt, i;
+
+  while ((opt = getopt (argc, argv, "hn:s:")) != -1) {
+    switch (opt) {
+    case 'n':
+      ops = atoi (optarg);
+      if (ops < 1)
+        goto usage;
+      break;
+    case 's':
+      if (!user_sizes)
+        num_sizes = 0;
+      user_sizes = 1;
+      if (num_sizes >= MAX_SIZES || (sizes[num_sizes++] = atoi (optarg)) < 1)
+        goto usage;
+      break;
+    default:
+      goto usage;
+    }
+  }
+  if (optind < argc)
+    goto usage;
+
+  printf ("xine-utils-bench, using xine-lib %s, %d operations each\n",
+          xine_get_version_string (), ops);
+
+  for (i = 0; i < num_sizes; i++) {
+    elem_t *elems = calloc (sizes[i], sizeof (elem_t));
+    if (!elems) {
+      fputs ("xine-utils-bench: out of memory\n", stderr);
+      return 1;
+    }
+    bench_pointer_set (elems, sizes[i], ops);
+    bench_unlink (elems, sizes[i], ops);
+    bench_names (sizes[i], ops);
+    free (elems);
+  }
+  return 0;
+
+usage:
+  fprintf (stderr, "\
+usage: %s [options]\n\
+options:\n\
+  -h		this help text\n\
+  -n OPS	operations per test (default: 1000000)\n\
+  -s SIZE	container size, may be given %d times (default: 4 ... 1024)\n",
+           argv[0], MAX_SIZES);
+  return opt == 'h' ? 0 : 1;
+}
@@ -31,6 +31,7 @@
 #include <unistd.h>
 #include <inttypes.h>
 #include <sys/stat.h>
+#include <stdarg.h>
 
 #include <xine/xine_internal.h>
 #include <xine/xineutils.h>
@@ -89,6 +90,7 @@ typedef struct file_driver_s {
 	int            fd;
 	size_t         bytes_written;
 	struct timeval endtime;
+	int            free_run;
 } file_driver_t;
 
 typedef struct {
@@ -247,6 +249,12 @@ static int ao_file_delay (ao_driver_t *this_gen)
 	   time we've already taken */
 	xine_monotonic_clock(&now, NULL);
 
+	if (this->free_run) {
+		/* write as fast as we get the data */
+		this->endtime = now;
+		return 0;
+	}
+
 	if (now.tv_sec > this->endtime.tv_sec) {
 		/* We slipped. Compensate */
 		this->endtime = now;
@@ -320,7 +328,8 @@ static int ao_file_set_property (ao_driver_t *this_gen, int property, int value)
 }
 
 static int ao_file_ctrl(ao_driver_t *this_gen, int cmd, ...) {
-	/*file_driver_t *this = (file_driver_t *) this_gen;*/
+	file_driver_t *this = (file_driver_t *) this_gen;
+	va_list args;
 
 	switch (cmd) {
 
@@ -332,6 +341,12 @@ static int ao_file_ctrl(ao_driver_t *this_gen, int cmd, ...) {
 
 	case AO_CTRL_FLUSH_BUFFERS:
 		break;
+
+	case AO_CTRL_FREE_RUN:
+		va_start (args, cmd);
+		this->free_run = va_arg (args, int);
+		va_end (args);
+		break;
 	}
 
 	return 0;
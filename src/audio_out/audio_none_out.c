@@ -30,6 +30,7 @@
 #include <math.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <stdarg.h>
 
 #include <xine/xine_internal.h>
 #include <xine/xineutils.h>
@@ -58,6 +59,8 @@ typedef struct none_driver_s {
 
   uint32_t       latency;
 
+  int            free_run;
+
 } none_driver_t;
 
 typedef struct {
@@ -119,7 +122,7 @@ static int ao_none_write(ao_driver_t *this_gen, int16_t *data,
   /* take some time to pretend we are doing something.
    * avoids burning cpu.
    */
-  if( (1000 * num_frames / this->sample_rate) > 10 )
+  if( !this->free_run && (1000 * num_frames / this->sample_rate) > 10 )
     xine_usec_sleep ((1000 * num_frames / this->sample_rate)*1000/2);
 
   return 1;
@@ -160,7 +163,8 @@ static int ao_none_set_property (ao_driver_t *this_gen, int property, int value)
 }
 
 static int ao_none_ctrl(ao_driver_t *this_gen, int cmd, ...) {
-  /*none_driver_t *this = (none_driver_t *) this_gen;*/
+  none_driver_t *this = (none_driver_t *) this_gen;
+  va_list args;
 
   switch (cmd) {
 
@@ -172,6 +176,12 @@ static int ao_none_ctrl(ao_driver_t *this_gen, int cmd, ...) {
 
   case AO_CTRL_FLUSH_BUFFERS:
     break;
+
+  case AO_CTRL_FREE_RUN:
+    va_start (args, cmd);
+    this->free_run = va_arg (args, int);
+    va_end (args);
+    break;
   }
 
   return 0;
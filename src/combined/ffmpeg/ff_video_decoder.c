@@ -124,7 +124,7 @@ struct ff_video_decoder_s {
 
   int               output_format;
 
-  xine_list_t       *dr1_frames;
+  xine_hash_t       *dr1_frames;
 
   yuv_planes_t      yuv;
 
@@ -283,7 +283,7 @@ static int get_buffer(AVCodecContext *context, AVFrame *av_frame){
   /* take over pts for this frame to have it reordered */
   av_frame->reordered_opaque = context->reordered_opaque;
 
-  xine_list_push_back(this->dr1_frames, img);
+  xine_hash_put(this->dr1_frames, img, NULL);
 
   return 0;
 }
@@ -298,13 +298,8 @@ static void release_buffer(struct AVCodecContext *context, AVFrame *av_frame){
       img->free(img);
     }
 
-    xine_list_iterator_t it;
-
-    it = xine_list_find(this->dr1_frames, av_frame->opaque);
-    assert(it);
-    if( it != NULL ) {
-      xine_list_remove(this->dr1_frames, it);
-    }
+    if (!xine_hash_remove(this->dr1_frames, av_frame->opaque))
+      assert(0);
   } else {
     avcodec_default_release_buffer(context, av_frame);
   }
@@ -1734,19 +1729,18 @@ static void ff_reset (video_decoder_t *this_gen) {
 
   if(this->context && this->decoder_ok)
   {
-    xine_list_iterator_t it = NULL;
+    xine_hash_iterator_t it = NULL;
 
     avcodec_flush_buffers(this->context);
 
     /* frame garbage collector here - workaround for buggy ffmpeg codecs that
      * don't release their DR1 frames */
-    while ((it = xine_list_next (this->dr1_frames, it)) != NULL)
+    while ((it = xine_hash_next (this->dr1_frames, it)) != NULL)
     {
-      vo_frame_t *img = (vo_frame_t *)xine_list_get_value(this->dr1_frames, it);
-      if (img)
-        img->free(img);
+      vo_frame_t *img = (vo_frame_t *)xine_hash_get_key(this->dr1_frames, it);
+      img->free(img);
     }
-    xine_list_clear(this->dr1_frames);
+    xine_hash_clear(this->dr1_frames);
   }
 
   if (this->is_mpeg12)
@@ -1804,7 +1798,7 @@ static void ff_dispose (video_decoder_t *this_gen) {
   lprintf ("ff_dispose\n");
 
   if (this->decoder_ok) {
-    xine_list_iterator_t it = NULL;
+    xine_hash_iterator_t it = NULL;
 
     pthread_mutex_lock(&ffmpeg_lock);
     avcodec_close (this->context);
@@ -1812,11 +1806,10 @@ static void ff_dispose (video_decoder_t *this_gen) {
 
     /* frame garbage collector here - workaround for buggy ffmpeg codecs that
      * don't release their DR1 frames */
-    while ((it = xine_list_next (this->dr1_frames, it)) != NULL)
+    while ((it = xine_hash_next (this->dr1_frames, it)) != NULL)
     {
-      vo_frame_t *img = (vo_frame_t *)xine_list_get_value(this->dr1_frames, it);
-      if (img)
-        img->free(img);
+      vo_frame_t *img = (vo_frame_t *)xine_hash_get_key(this->dr1_frames, it);
+      img->free(img);
     }
 
     this->stream->video_out->close(this->stream->video_out, this->stream);
@@ -1850,7 +1843,7 @@ static void ff_dispose (video_decoder_t *this_gen) {
 
   mpeg_parser_dispose(this->mpeg_parser);
 
-  xine_list_delete(this->dr1_frames);
+  xine_hash_delete(this->dr1_frames);
 
   free (this_gen);
 }
@@ -1894,7 +1887,7 @@ static video_decoder_t *ff_video_open_plugin (video_decoder_class_t *class_gen,
 
   this->mpeg_parser       = NULL;
 
-  this->dr1_frames        = xine_list_new();
+  this->dr1_frames        = xine_hash_new(0, NULL, NULL);
 
 #ifdef LOG
   this->debug_fmt = -1;
@@ -219,7 +219,8 @@ static int dxr3_scr_set_speed(scr_plugin_t *scr, int speed)
   pthread_mutex_unlock(&this->mutex);
 
   lprintf("speed set to mode %d\n", speed);
-  return speed;
+  /* the card only does steps of 1/0x900, tell what we really got */
+  return (int64_t)em_speed * XINE_FINE_SPEED_NORMAL / 0x900;
 }
 
 static void dxr3_scr_exit(scr_plugin_t *scr)
@@ -169,6 +169,7 @@ static void clear_overlay(xine_osd_t *osd)
   osd->osd.y1 = osd->osd.height;
   osd->osd.x2 = 0;
   osd->osd.y2 = 0;
+  osd->osd.rle_x2 = 0;
 }
 
 static xine_osd_t *get_overlay(bluray_input_plugin_t *this, int plane)
@@ -115,6 +115,23 @@ typedef void (*deinterlace_frame_t)( uint8_t *output, int outstride,
                                      int width, int height );
 
 
+/**
+ * Optional variant of the frame function that only builds part of the
+ * output frame, so the work can be split between several threads.
+ *
+ * The output is built in height/2 steps, one per scanline of the field
+ * being deinterlaced.  Only the output scanlines belonging to steps
+ * first_pair up to (but not including) last_pair may be written; the
+ * scanlines before the first step belong to step 0, the ones after the
+ * last step belong to step height/2 - 1.  Different slices therefore
+ * never write the same scanline.
+ */
+typedef void (*deinterlace_frame_slice_t)( uint8_t *output, int outstride,
+                                           deinterlace_frame_data_t *data,
+                                           int bottom_field, int second_field,
+                                           int width, int height,
+                                           int first_pair, int last_pair );
+
 /**
  * This structure defines the deinterlacer plugin.
  */
@@ -131,6 +148,7 @@ struct deinterlace_method_s
     deinterlace_frame_t deinterlace_frame;
     int delaysfield; /* xine: this method delays output by one field relative to input */
     const char *description;
+    deinterlace_frame_slice_t deinterlace_frame_slice; /* xine: may be NULL */
 };
 
 /**
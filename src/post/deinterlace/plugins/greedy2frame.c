@@ -54,9 +54,10 @@
 
 #include "greedy2frame_template_sse2.c"
 
-static void DeinterlaceGreedy2Frame(uint8_t *output, int outstride,
-                                    deinterlace_frame_data_t *data,
-                                    int bottom_field, int second_field, int width, int height )
+static void DeinterlaceGreedy2FrameSlice(uint8_t *output, int outstride,
+                                         deinterlace_frame_data_t *data,
+                                         int bottom_field, int second_field, int width, int height,
+                                         int first_pair, int last_pair )
 
 {
     if (xine_mm_accel() & MM_ACCEL_X86_SSE2) {
@@ -71,19 +72,32 @@ static void DeinterlaceGreedy2Frame(uint8_t *output, int outstride,
              * the inability to use streaming stores).
              */
             DeinterlaceGreedy2Frame_MMXEXT(output, outstride, data,
-                                           bottom_field, second_field, width, height );
+                                           bottom_field, second_field, width, height,
+                                           first_pair, last_pair );
         } else {
             DeinterlaceGreedy2Frame_SSE2(output, outstride, data,
-                                         bottom_field, second_field, width, height );
+                                         bottom_field, second_field, width, height,
+                                         first_pair, last_pair );
         }
     }
     else {
         DeinterlaceGreedy2Frame_MMXEXT(output, outstride, data,
-                                       bottom_field, second_field, width, height );
+                                       bottom_field, second_field, width, height,
+                                       first_pair, last_pair );
         /* could fall back to 3dnow/mmx here too */
     }
 }
 
+static void DeinterlaceGreedy2Frame(uint8_t *output, int outstride,
+                                    deinterlace_frame_data_t *data,
+                                    int bottom_field, int second_field, int width, int height )
+
+{
+    DeinterlaceGreedy2FrameSlice(output, outstride, data,
+                                 bottom_field, second_field, width, height,
+                                 0, height / 2 );
+}
+
 
 static deinterlace_method_t greedy2framemethod =
 {
@@ -97,7 +111,8 @@ static deinterlace_method_t greedy2framemethod =
     0,
     DeinterlaceGreedy2Frame,
     1,
-    NULL
+    NULL,
+    DeinterlaceGreedy2FrameSlice
 };
 
 deinterlace_method_t *greedy2frame_get_method( void )
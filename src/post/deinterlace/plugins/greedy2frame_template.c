@@ -98,19 +98,23 @@ static const mmx_t GreedyTwoFrameThreshold = { ub: {TP, TP, TP, TP} };
 #if defined(IS_MMXEXT)
 static void DeinterlaceGreedy2Frame_MMXEXT(uint8_t *output, int outstride,
                                  deinterlace_frame_data_t *data,
-                                 int bottom_field, int second_field, int width, int height )
+                                 int bottom_field, int second_field, int width, int height,
+                                 int first_pair, int last_pair )
 #elif defined(IS_3DNOW)
 static void DeinterlaceGreedy2Frame_3DNOW(uint8_t *output, int outstride,
                                    deinterlace_frame_data_t *data,
-                                   int bottom_field, int second_field, int width, int height )
+                                   int bottom_field, int second_field, int width, int height,
+                                   int first_pair, int last_pair )
 #else
 static void DeinterlaceGreedy2Frame_MMX(uint8_t *output, int outstride,
                                  deinterlace_frame_data_t *data,
-                                 int bottom_field, int second_field, int width, int height )
+                                 int bottom_field, int second_field, int width, int height,
+                                 int first_pair, int last_pair )
 #endif
 {
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
     int Line;
+    int LastLine;
     int stride = width * 2;
     register uint8_t* M1;
     register uint8_t* M0;
@@ -152,11 +156,25 @@ static void DeinterlaceGreedy2Frame_MMX(uint8_t *output, int outstride,
         T0 += stride;
         B0 = T0 + Pitch;
 
-        xine_fast_memcpy(Dest, M1, LineLength);
+        if( !first_pair )
+            xine_fast_memcpy(Dest, M1, LineLength);
         Dest += outstride;
     }
 
-    for (Line = 0; Line < (height / 2) - 1; ++Line)
+    /* Skip to the first line pair of this slice. */
+    M1 += first_pair * Pitch;
+    T1 += first_pair * Pitch;
+    B1 += first_pair * Pitch;
+    M0 += first_pair * Pitch;
+    T0 += first_pair * Pitch;
+    B0 += first_pair * Pitch;
+    Dest += first_pair * 2 * outstride;
+
+    LastLine = last_pair;
+    if( LastLine > (height / 2) - 1 )
+        LastLine = (height / 2) - 1;
+
+    for (Line = first_pair; Line < LastLine; ++Line)
     {
       /* Always use the most recent data verbatim.  By definition it's correct
        * (it'd be shown on an interlaced display) and our job is to fill in
@@ -323,15 +341,19 @@ static void DeinterlaceGreedy2Frame_MMX(uint8_t *output, int outstride,
     asm("sfence\n\t");
 #endif
 
-    if( bottom_field )
+    /* The last lines are only written by the final slice. */
+    if( last_pair >= height / 2 )
     {
-        xine_fast_memcpy(Dest, T1, stride);
-        Dest += outstride;
-        xine_fast_memcpy(Dest, M1, stride);
-    }
-    else
-    {
-        xine_fast_memcpy(Dest, T1, stride);
+        if( bottom_field )
+        {
+            xine_fast_memcpy(Dest, T1, stride);
+            Dest += outstride;
+            xine_fast_memcpy(Dest, M1, stride);
+        }
+        else
+        {
+            xine_fast_memcpy(Dest, T1, stride);
+        }
     }
 
     /* clear out the MMX registers ready for doing floating point again */
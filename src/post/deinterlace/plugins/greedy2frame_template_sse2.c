@@ -94,10 +94,12 @@ static const sse_t GreedyTwoFrameThreshold128 = { ub: {TP, TP, TP, TP, TP, TP, T
 static void DeinterlaceGreedy2Frame_SSE2(uint8_t *output, int outstride,
                                          deinterlace_frame_data_t *data,
                                          int bottom_field, int second_field,
-                                         int width, int height )
+                                         int width, int height,
+                                         int first_pair, int last_pair )
 {
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
     int Line;
+    int LastLine;
     int stride = width * 2;
     register uint8_t* M1;
     register uint8_t* M0;
@@ -134,11 +136,23 @@ static void DeinterlaceGreedy2Frame_SSE2(uint8_t *output, int outstride,
         M0 += Pitch;
         T0 += stride;
 
-        xine_fast_memcpy(Dest, M1, LineLength);
+        if( !first_pair )
+            xine_fast_memcpy(Dest, M1, LineLength);
         Dest += outstride;
     }
 
-    for (Line = 0; Line < (height / 2) - 1; ++Line)
+    /* Skip to the first line pair of this slice. */
+    M1 += first_pair * Pitch;
+    T1 += first_pair * Pitch;
+    M0 += first_pair * Pitch;
+    T0 += first_pair * Pitch;
+    Dest += first_pair * 2 * outstride;
+
+    LastLine = last_pair;
+    if( LastLine > (height / 2) - 1 )
+        LastLine = (height / 2) - 1;
+
+    for (Line = first_pair; Line < LastLine; ++Line)
     {
       /* Always use the most recent data verbatim.  By definition it's correct
        * (it'd be shown on an interlaced display) and our job is to fill in
@@ -278,15 +292,19 @@ static void DeinterlaceGreedy2Frame_SSE2(uint8_t *output, int outstride,
 
     asm("sfence\n\t");
 
-    if( bottom_field )
-    {
-        xine_fast_memcpy(Dest, T1, stride);
-        Dest += outstride;
-        xine_fast_memcpy(Dest, M1, stride);
-    }
-    else
+    /* The last lines are only written by the final slice. */
+    if( last_pair >= height / 2 )
     {
-        xine_fast_memcpy(Dest, T1, stride);
+        if( bottom_field )
+        {
+            xine_fast_memcpy(Dest, T1, stride);
+            Dest += outstride;
+            xine_fast_memcpy(Dest, M1, stride);
+        }
+        else
+        {
+            xine_fast_memcpy(Dest, T1, stride);
+        }
     }
 #endif
 }
@@ -92,30 +92,45 @@ static int UseStrangeBob=UseStrangeBobDefault;
 
 #endif
 
-static void deinterlace_frame_di_tomsmocomp( uint8_t *output, int outstride,
+/*
+ * Line pair n of the output is the copied field line n and the
+ * interpolated line next to it, i.e. output scanlines 2n and 2n+1.
+ */
+static void deinterlace_slice_di_tomsmocomp( uint8_t *output, int outstride,
                                              deinterlace_frame_data_t *data,
                                              int bottom_field, int second_field,
-                                             int width, int height )
+                                             int width, int height,
+                                             int first_pair, int last_pair )
 {
 #if defined (ARCH_X86) || defined (ARCH_X86_64)
 
     if( xine_mm_accel() & MM_ACCEL_X86_MMXEXT ) {
         tomsmocomp_filter_sse( output, outstride, data,
                                bottom_field, second_field,
-                               width, height );
+                               width, height, first_pair, last_pair );
     } else if( xine_mm_accel() & MM_ACCEL_X86_3DNOW ) {
         tomsmocomp_filter_3dnow( output, outstride, data,
                                  bottom_field, second_field,
-                                 width, height );
+                                 width, height, first_pair, last_pair );
     } else {
         tomsmocomp_filter_mmx( output, outstride, data,
                                bottom_field, second_field,
-                               width, height );
+                               width, height, first_pair, last_pair );
     }
 
 #endif
 }
 
+static void deinterlace_frame_di_tomsmocomp( uint8_t *output, int outstride,
+                                             deinterlace_frame_data_t *data,
+                                             int bottom_field, int second_field,
+                                             int width, int height )
+{
+    deinterlace_slice_di_tomsmocomp( output, outstride, data,
+                                     bottom_field, second_field,
+                                     width, height, 0, height / 2 );
+}
+
 static deinterlace_method_t tomsmocompmethod =
 {
     "Tom's Motion Compensated (DScaler)",
@@ -137,7 +152,8 @@ static deinterlace_method_t tomsmocompmethod =
     "on monitors set to an arbitrary refresh rate.\n"
     "\n"
     "Motion search mode finds and follows motion vectors for accurate "
-    "interpolation.  This is the TomsMoComp deinterlacer from DScaler."
+    "interpolation.  This is the TomsMoComp deinterlacer from DScaler.",
+    deinterlace_slice_di_tomsmocomp
 };
 
 deinterlace_method_t *dscaler_tomsmocomp_get_method( void )
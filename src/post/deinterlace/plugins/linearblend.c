@@ -311,6 +311,84 @@ static void deinterlace_scanline_linear_blend2_mmxext( uint8_t *output,
     emms();
 }
 
+/* SSE2 version, 16 bytes per iteration.  Bit exact to the versions above. */
+
+static void linear_blend_scanline_sse2( uint8_t *output, uint8_t *t,
+                                        uint8_t *b, uint8_t *m, int width )
+{
+    int i;
+
+    // Get width in bytes.
+    width *= 2;
+    i = width / 16;
+    width -= i * 16;
+
+    pxor_r2r( xmm7, xmm7 );
+    while( i-- ) {
+        movq_m2r( *(t+0), xmm0 );
+        movq_m2r( *(b+0), xmm1 );
+        movq_m2r( *(m+0), xmm2 );
+        punpcklbw_r2r( xmm7, xmm0 );
+        punpcklbw_r2r( xmm7, xmm1 );
+        punpcklbw_r2r( xmm7, xmm2 );
+        psllw_i2r( 1, xmm2 );
+        paddw_r2r( xmm0, xmm2 );
+        paddw_r2r( xmm1, xmm2 );
+        psrlw_i2r( 2, xmm2 );
+        movdqa_r2r( xmm2, xmm3 );
+
+        movq_m2r( *(t+8), xmm0 );
+        movq_m2r( *(b+8), xmm1 );
+        movq_m2r( *(m+8), xmm2 );
+        punpcklbw_r2r( xmm7, xmm0 );
+        punpcklbw_r2r( xmm7, xmm1 );
+        punpcklbw_r2r( xmm7, xmm2 );
+        psllw_i2r( 1, xmm2 );
+        paddw_r2r( xmm0, xmm2 );
+        paddw_r2r( xmm1, xmm2 );
+        psrlw_i2r( 2, xmm2 );
+        packuswb_r2r( xmm2, xmm3 );
+        movdqu_r2m( xmm3, *output );
+
+        output += 16;
+        t += 16;
+        b += 16;
+        m += 16;
+    }
+    while( width-- ) {
+        *output++ = (*t++ + *b++ + (*m++ << 1)) >> 2;
+    }
+}
+
+static void deinterlace_scanline_linear_blend_sse2( uint8_t *output,
+                                                    deinterlace_scanline_data_t *data,
+                                                    int width )
+{
+    linear_blend_scanline_sse2( output, data->t0, data->b0, data->m1, width );
+}
+
+static void deinterlace_scanline_linear_blend2_sse2( uint8_t *output,
+                                                     deinterlace_scanline_data_t *data,
+                                                     int width )
+{
+    linear_blend_scanline_sse2( output, data->t1, data->b1, data->m0, width );
+}
+
+static deinterlace_method_t linearblendmethod_sse2 =
+{
+    "Linear Blend (mplayer)",
+    "LinearBlend",
+    2,
+    MM_ACCEL_X86_SSE2,
+    0,
+    1,
+    deinterlace_scanline_linear_blend_sse2,
+    deinterlace_scanline_linear_blend2_sse2,
+    0,
+    0,
+    linearblendmethod_help
+};
+
 static deinterlace_method_t linearblendmethod_mmxext =
 {
     "Linear Blend (mplayer)",
@@ -354,7 +432,9 @@ static deinterlace_method_t linearblendmethod =
 deinterlace_method_t *linearblend_get_method( void )
 {
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
-    if( xine_mm_accel() & MM_ACCEL_X86_MMXEXT )
+    if( xine_mm_accel() & MM_ACCEL_X86_SSE2 )
+      return &linearblendmethod_sse2;
+    else if( xine_mm_accel() & MM_ACCEL_X86_MMXEXT )
       return &linearblendmethod_mmxext;
     else
 #endif
@@ -42,5 +42,6 @@ deinterlace_method_t *greedy_get_method( void );
 deinterlace_method_t *weave_get_method( void );
 deinterlace_method_t *weavetff_get_method( void );
 deinterlace_method_t *weavebff_get_method( void );
+deinterlace_method_t *yadif_get_method( void );
 
 #endif /* TVTIME_PLUGINS_H_INCLUDED */
@@ -0,0 +1,462 @@
+/**
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * Spatial/temporal interpolation after the yadif filter by
+ * Michael Niedermayer.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif
+
+#include <xine/attributes.h>
+#include <xine/xineutils.h>
+#include "xine_mmx.h"
+#include "deinterlace.h"
+#include "speedtools.h"
+#include "speedy.h"
+#include "plugins.h"
+
+/**
+ * This method delays output by one field, so both the field before and
+ * the field after the one being deinterlaced are known.  Field diagram,
+ * where the field being deinterlaced is the kept field at time t:
+ *
+ *   t-2      t-1      t        t+1
+ *   prev              cur
+ *            prev2             next2
+ *
+ * The missing lines are predicted from the kept lines above and below,
+ * following the direction of the best matching edge.  The prediction is
+ * then clipped to the temporal average of prev2 and next2, by an amount
+ * that depends on how much the picture moved.  Unlike the original there
+ * is no field at t+2, so motion is only measured against prev.
+ *
+ * tvtime hands us packed 4:2:2 lines (and planar lines that look like
+ * them), so edges are searched in steps of 4 bytes: that always
+ * compares samples of the same kind, for YUY2 as well as for planes.
+ */
+
+#define YADIF_UNIT 4
+
+typedef struct {
+    uint8_t *dst;
+    uint8_t *cur_up, *cur_dn;       /* kept field at t, lines above and below */
+    uint8_t *prev_up, *prev_dn;     /* the same lines at t-2 */
+    uint8_t *prev2, *next2;         /* the missing line at t-1 and t+1 */
+    uint8_t *prev2_up, *prev2_dn;   /* two lines above/below the missing line */
+    uint8_t *next2_up, *next2_dn;
+} yadif_line_t;
+
+typedef void (*yadif_filter_line_t)( yadif_line_t *l, int bytes );
+
+#define YADIF_ABS(a) (((a) < 0) ? -(a) : (a))
+#define YADIF_MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define YADIF_MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+#define YADIF_SCORE(j) \
+    ( YADIF_ABS( cu[ x + ((j) - 1) * YADIF_UNIT ] - cd[ x - ((j) + 1) * YADIF_UNIT ] ) \
+    + YADIF_ABS( cu[ x + (j) * YADIF_UNIT ]       - cd[ x - (j) * YADIF_UNIT ] ) \
+    + YADIF_ABS( cu[ x + ((j) + 1) * YADIF_UNIT ] - cd[ x - ((j) - 1) * YADIF_UNIT ] ) )
+
+#define YADIF_CHECK(j) \
+    { int score = YADIF_SCORE(j); \
+      if( score < spatial_score ) { \
+          spatial_score = score; \
+          spatial_pred = (cu[ x + (j) * YADIF_UNIT ] + cd[ x - (j) * YADIF_UNIT ]) >> 1;
+
+static void yadif_filter_pixels_c( yadif_line_t *l, int start, int end, int bytes )
+{
+    uint8_t *cu = l->cur_up;
+    uint8_t *cd = l->cur_dn;
+    int x;
+
+    for( x = start; x < end; x++ ) {
+        int c = cu[ x ];
+        int e = cd[ x ];
+        int d = (l->prev2[ x ] + l->next2[ x ]) >> 1;
+        int temporal_diff0 = YADIF_ABS( l->prev2[ x ] - l->next2[ x ] );
+        int temporal_diff1 = (YADIF_ABS( l->prev_up[ x ] - c ) + YADIF_ABS( l->prev_dn[ x ] - e )) >> 1;
+        int diff = YADIF_MAX( temporal_diff0 >> 1, temporal_diff1 );
+        int spatial_pred = (c + e) >> 1;
+        int b, f, dmax, dmin;
+
+        if( x >= 3 * YADIF_UNIT && x < bytes - 3 * YADIF_UNIT ) {
+            int spatial_score = YADIF_SCORE( 0 ) - 1;
+
+            YADIF_CHECK( -1 ) YADIF_CHECK( -2 ) }} }}
+            YADIF_CHECK( 1 ) YADIF_CHECK( 2 ) }} }}
+        }
+
+        /* Don't clip too hard where the field itself looks interlaced. */
+        b = (l->prev2_up[ x ] + l->next2_up[ x ]) >> 1;
+        f = (l->prev2_dn[ x ] + l->next2_dn[ x ]) >> 1;
+        dmax = YADIF_MAX( YADIF_MAX( d - e, d - c ), YADIF_MIN( b - c, f - e ) );
+        dmin = YADIF_MIN( YADIF_MIN( d - e, d - c ), YADIF_MAX( b - c, f - e ) );
+        diff = YADIF_MAX( YADIF_MAX( diff, dmin ), -dmax );
+
+        if( spatial_pred > d + diff ) {
+            spatial_pred = d + diff;
+        } else if( spatial_pred < d - diff ) {
+            spatial_pred = d - diff;
+        }
+
+        l->dst[ x ] = spatial_pred;
+    }
+}
+
+static void yadif_filter_line_c( yadif_line_t *l, int bytes )
+{
+    yadif_filter_pixels_c( l, 0, bytes, bytes );
+}
+
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+
+/* Loads 8 bytes as words, xmm7 must be zero. */
+#define YADIF_LOADW(mem, reg) \
+    movq_m2r( (mem), reg ); \
+    punpcklbw_r2r( xmm7, reg );
+
+/* dst = |a - b| as words, tmp is clobbered. */
+#define YADIF_ABSDIFFW(a, b, dst, tmp) \
+    movq_m2r( (a), tmp ); \
+    movq_m2r( (b), dst ); \
+    movdqa_r2r( tmp, xmm6 ); \
+    psubusb_r2r( dst, xmm6 ); \
+    psubusb_r2r( tmp, dst ); \
+    por_r2r( xmm6, dst ); \
+    punpcklbw_r2r( xmm7, dst );
+
+/* xmm0 = score of direction j, clobbers xmm1 - xmm3 and xmm6. */
+#define YADIF_SCORE_SSE2(j) \
+    YADIF_ABSDIFFW( cu[ x + ((j) - 1) * YADIF_UNIT ], cd[ x - ((j) + 1) * YADIF_UNIT ], xmm0, xmm1 ) \
+    YADIF_ABSDIFFW( cu[ x + (j) * YADIF_UNIT ],       cd[ x - (j) * YADIF_UNIT ],       xmm2, xmm1 ) \
+    paddw_r2r( xmm2, xmm0 ); \
+    YADIF_ABSDIFFW( cu[ x + ((j) + 1) * YADIF_UNIT ], cd[ x - ((j) - 1) * YADIF_UNIT ], xmm3, xmm1 ) \
+    paddw_r2r( xmm3, xmm0 );
+
+/**
+ * Same as YADIF_CHECK, using lane masks instead of branches.  The second
+ * check of each direction only applies to lanes where the first one won,
+ * which is what the nested flag is for.
+ */
+#define YADIF_CHECK_SSE2(j, nested) \
+    YADIF_SCORE_SSE2( j ) \
+    YADIF_LOADW( cu[ x + (j) * YADIF_UNIT ], xmm1 ) \
+    YADIF_LOADW( cd[ x - (j) * YADIF_UNIT ], xmm3 ) \
+    paddw_r2r( xmm3, xmm1 ); \
+    psrlw_i2r( 1, xmm1 ); \
+    movdqu_m2r( spatial_score, xmm4 ); \
+    pcmpgtw_r2r( xmm0, xmm4 ); \
+    if( nested ) { \
+        movdqu_m2r( mask, xmm5 ); \
+        pand_r2r( xmm5, xmm4 ); \
+    } \
+    movdqu_r2m( xmm4, mask ); \
+    movdqu_m2r( spatial_score, xmm5 ); \
+    movdqa_r2r( xmm4, xmm6 ); \
+    pand_r2r( xmm4, xmm0 ); \
+    pandn_r2r( xmm5, xmm6 ); \
+    por_r2r( xmm6, xmm0 ); \
+    movdqu_r2m( xmm0, spatial_score ); \
+    movdqu_m2r( spatial_pred, xmm5 ); \
+    movdqa_r2r( xmm4, xmm6 ); \
+    pand_r2r( xmm4, xmm1 ); \
+    pandn_r2r( xmm5, xmm6 ); \
+    por_r2r( xmm6, xmm1 ); \
+    movdqu_r2m( xmm1, spatial_pred );
+
+static void yadif_filter_line_sse2( yadif_line_t *l, int bytes )
+{
+    static const sse_t ones = { uw: { 1, 1, 1, 1, 1, 1, 1, 1 } };
+    sse_t c, e, d, diff, spatial_pred, spatial_score, mask;
+    uint8_t *cu = l->cur_up;
+    uint8_t *cd = l->cur_dn;
+    int x = 3 * YADIF_UNIT;
+
+    /* The edge search reads up to 3 units left and right. */
+    if( bytes < 3 * YADIF_UNIT + 8 + 3 * YADIF_UNIT ) {
+        yadif_filter_pixels_c( l, 0, bytes, bytes );
+        return;
+    }
+
+    yadif_filter_pixels_c( l, 0, x, bytes );
+
+    pxor_r2r( xmm7, xmm7 );
+
+    for( ; x + 8 + 3 * YADIF_UNIT <= bytes; x += 8 ) {
+        YADIF_LOADW( cu[ x ], xmm0 )
+        movdqu_r2m( xmm0, c );
+        YADIF_LOADW( cd[ x ], xmm1 )
+        movdqu_r2m( xmm1, e );
+
+        /* d and temporal_diff0 / 2 */
+        YADIF_LOADW( l->prev2[ x ], xmm2 )
+        YADIF_LOADW( l->next2[ x ], xmm3 )
+        movdqa_r2r( xmm2, xmm4 );
+        paddw_r2r( xmm3, xmm4 );
+        psrlw_i2r( 1, xmm4 );
+        movdqu_r2m( xmm4, d );
+        movdqa_r2r( xmm2, xmm5 );
+        psubw_r2r( xmm3, xmm5 );
+        psubw_r2r( xmm2, xmm3 );
+        pmaxsw_r2r( xmm5, xmm3 );
+        psrlw_i2r( 1, xmm3 );
+
+        /* temporal_diff1 */
+        YADIF_LOADW( l->prev_up[ x ], xmm2 )
+        movdqa_r2r( xmm2, xmm5 );
+        psubw_r2r( xmm0, xmm5 );
+        movdqa_r2r( xmm0, xmm6 );
+        psubw_r2r( xmm2, xmm6 );
+        pmaxsw_r2r( xmm5, xmm6 );
+        YADIF_LOADW( l->prev_dn[ x ], xmm2 )
+        movdqa_r2r( xmm2, xmm5 );
+        psubw_r2r( xmm1, xmm5 );
+        movdqa_r2r( xmm1, xmm4 );
+        psubw_r2r( xmm2, xmm4 );
+        pmaxsw_r2r( xmm5, xmm4 );
+        paddw_r2r( xmm4, xmm6 );
+        psrlw_i2r( 1, xmm6 );
+        pmaxsw_r2r( xmm3, xmm6 );
+        movdqu_r2m( xmm6, diff );
+
+        /* vertical prediction, then look for a better edge */
+        paddw_r2r( xmm1, xmm0 );
+        psrlw_i2r( 1, xmm0 );
+        movdqu_r2m( xmm0, spatial_pred );
+
+        YADIF_SCORE_SSE2( 0 )
+        psubw_m2r( ones, xmm0 );
+        movdqu_r2m( xmm0, spatial_score );
+
+        YADIF_CHECK_SSE2( -1, 0 )
+        YADIF_CHECK_SSE2( -2, 1 )
+        YADIF_CHECK_SSE2( 1, 0 )
+        YADIF_CHECK_SSE2( 2, 1 )
+
+        /* b - c and f - e */
+        YADIF_LOADW( l->prev2_up[ x ], xmm0 )
+        YADIF_LOADW( l->next2_up[ x ], xmm2 )
+        paddw_r2r( xmm2, xmm0 );
+        psrlw_i2r( 1, xmm0 );
+        YADIF_LOADW( l->prev2_dn[ x ], xmm1 )
+        YADIF_LOADW( l->next2_dn[ x ], xmm2 )
+        paddw_r2r( xmm2, xmm1 );
+        psrlw_i2r( 1, xmm1 );
+        movdqu_m2r( c, xmm2 );
+        movdqu_m2r( e, xmm3 );
+        movdqu_m2r( d, xmm4 );
+        psubw_r2r( xmm2, xmm0 );
+        psubw_r2r( xmm3, xmm1 );
+        movdqa_r2r( xmm0, xmm5 );
+        pminsw_r2r( xmm1, xmm5 );
+        pmaxsw_r2r( xmm1, xmm0 );
+
+        /* d - e and d - c */
+        movdqa_r2r( xmm4, xmm6 );
+        psubw_r2r( xmm3, xmm6 );
+        movdqa_r2r( xmm4, xmm1 );
+        psubw_r2r( xmm2, xmm1 );
+
+        /* dmax in xmm5, dmin in xmm0 */
+        pmaxsw_r2r( xmm6, xmm5 );
+        pmaxsw_r2r( xmm1, xmm5 );
+        pminsw_r2r( xmm6, xmm0 );
+        pminsw_r2r( xmm1, xmm0 );
+
+        /* diff = max( diff, dmin, -dmax ) */
+        pxor_r2r( xmm1, xmm1 );
+        psubw_r2r( xmm5, xmm1 );
+        pmaxsw_r2r( xmm1, xmm0 );
+        movdqu_m2r( diff, xmm1 );
+        pmaxsw_r2r( xmm1, xmm0 );
+
+        /* clip the prediction to [d - diff, d + diff] */
+        movdqa_r2r( xmm4, xmm1 );
+        psubw_r2r( xmm0, xmm1 );
+        paddw_r2r( xmm0, xmm4 );
+        movdqu_m2r( spatial_pred, xmm2 );
+        pmaxsw_r2r( xmm1, xmm2 );
+        pminsw_r2r( xmm4, xmm2 );
+        packuswb_r2r( xmm2, xmm2 );
+        movq_r2m( xmm2, l->dst[ x ] );
+    }
+
+    yadif_filter_pixels_c( l, x, bytes, bytes );
+}
+
+#endif
+
+/**
+ * Output scanlines 2 * first_pair up to 2 * last_pair are built, the
+ * last slice also takes care of a trailing odd scanline.
+ */
+static void deinterlace_frame_di_yadif_slice( uint8_t *output, int outstride,
+                                              deinterlace_frame_data_t *data,
+                                              int bottom_field, int second_field,
+                                              int width, int height,
+                                              int first_pair, int last_pair,
+                                              yadif_filter_line_t filter_line )
+{
+    int stride = width * 2;
+    uint8_t *cur  = second_field ? data->f0 : data->f1;
+    uint8_t *prev = second_field ? data->f1 : data->f2;
+    uint8_t *prev2 = data->f1;
+    uint8_t *next2 = data->f0;
+    int y, end;
+
+    end = (last_pair >= height / 2) ? height : last_pair * 2;
+
+    for( y = first_pair * 2; y < end; y++ ) {
+        yadif_line_t line;
+        int up, dn, up2, dn2;
+
+        if( (y & 1) != bottom_field ) {
+            blit_packed422_scanline( output + y * outstride, cur + y * stride, width );
+            continue;
+        }
+
+        /* Mirror the neighbour lines at the picture edges. */
+        up  = (y > 0) ? y - 1 : y + 1;
+        dn  = (y < height - 1) ? y + 1 : y - 1;
+        up2 = (y > 1) ? y - 2 : y;
+        dn2 = (y < height - 2) ? y + 2 : y;
+        if( up >= height || dn < 0 ) {
+            blit_packed422_scanline( output + y * outstride, next2 + y * stride, width );
+            continue;
+        }
+
+        line.dst      = output + y * outstride;
+        line.cur_up   = cur + up * stride;
+        line.cur_dn   = cur + dn * stride;
+        line.prev_up  = prev + up * stride;
+        line.prev_dn  = prev + dn * stride;
+        line.prev2    = prev2 + y * stride;
+        line.next2    = next2 + y * stride;
+        line.prev2_up = prev2 + up2 * stride;
+        line.prev2_dn = prev2 + dn2 * stride;
+        line.next2_up = next2 + up2 * stride;
+        line.next2_dn = next2 + dn2 * stride;
+
+        filter_line( &line, stride );
+    }
+}
+
+static void deinterlace_frame_di_yadif_c_slice( uint8_t *output, int outstride,
+                                                deinterlace_frame_data_t *data,
+                                                int bottom_field, int second_field,
+                                                int width, int height,
+                                                int first_pair, int last_pair )
+{
+    deinterlace_frame_di_yadif_slice( output, outstride, data, bottom_field, second_field,
+                                      width, height, first_pair, last_pair,
+                                      yadif_filter_line_c );
+}
+
+static void deinterlace_frame_di_yadif_c( uint8_t *output, int outstride,
+                                          deinterlace_frame_data_t *data,
+                                          int bottom_field, int second_field,
+                                          int width, int height )
+{
+    deinterlace_frame_di_yadif_c_slice( output, outstride, data, bottom_field, second_field,
+                                        width, height, 0, height / 2 );
+}
+
+#define YADIF_DESCRIPTION \
+    "Uses heuristics to detect motion in the input frames and reconstruct " \
+    "image detail where possible.  Use this for high quality output even " \
+    "on monitors set to an arbitrary refresh rate.\n" \
+    "\n" \
+    "Missing lines are interpolated along the direction of the strongest " \
+    "edge and limited by the fields before and after, which keeps still " \
+    "areas sharp without combing on motion.  This method delays output by " \
+    "one field.  Based on the yadif deinterlacer by Michael Niedermayer."
+
+static deinterlace_method_t yadifmethod =
+{
+    "Yet Another DeInterlacing Filter",
+    "Yadif",
+    4,
+    0,
+    0,
+    0,
+    0,
+    0,
+    deinterlace_frame_di_yadif_c,
+    1,
+    YADIF_DESCRIPTION,
+    deinterlace_frame_di_yadif_c_slice
+};
+
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+
+static void deinterlace_frame_di_yadif_sse2_slice( uint8_t *output, int outstride,
+                                                   deinterlace_frame_data_t *data,
+                                                   int bottom_field, int second_field,
+                                                   int width, int height,
+                                                   int first_pair, int last_pair )
+{
+    deinterlace_frame_di_yadif_slice( output, outstride, data, bottom_field, second_field,
+                                      width, height, first_pair, last_pair,
+                                      yadif_filter_line_sse2 );
+}
+
+static void deinterlace_frame_di_yadif_sse2( uint8_t *output, int outstride,
+                                             deinterlace_frame_data_t *data,
+                                             int bottom_field, int second_field,
+                                             int width, int height )
+{
+    deinterlace_frame_di_yadif_sse2_slice( output, outstride, data, bottom_field, second_field,
+                                           width, height, 0, height / 2 );
+}
+
+static deinterlace_method_t yadifmethod_sse2 =
+{
+    "Yet Another DeInterlacing Filter",
+    "Yadif",
+    4,
+    MM_ACCEL_X86_SSE2,
+    0,
+    0,
+    0,
+    0,
+    deinterlace_frame_di_yadif_sse2,
+    1,
+    YADIF_DESCRIPTION,
+    deinterlace_frame_di_yadif_sse2_slice
+};
+
+#endif
+
+deinterlace_method_t *yadif_get_method( void )
+{
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+    if( xine_mm_accel() & MM_ACCEL_X86_SSE2 )
+        return &yadifmethod_sse2;
+#endif
+    return &yadifmethod;
+}
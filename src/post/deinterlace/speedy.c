@@ -1213,6 +1213,45 @@ static void interpolate_packed422_scanline_mmxext( uint8_t *output, uint8_t *top
 }
 #endif
 
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+static void interpolate_packed422_scanline_sse2( uint8_t *output, uint8_t *top,
+                                                 uint8_t *bot, int width )
+{
+    int i;
+
+    for( i = width/16; i; --i ) {
+        movdqu_m2r( *bot, xmm0 );
+        movdqu_m2r( *top, xmm1 );
+        movdqu_m2r( *(bot + 16), xmm2 );
+        movdqu_m2r( *(top + 16), xmm3 );
+        pavgb_r2r( xmm1, xmm0 );
+        pavgb_r2r( xmm3, xmm2 );
+        movdqu_r2m( xmm0, *output );
+        movdqu_r2m( xmm2, *(output + 16) );
+        output += 32;
+        top += 32;
+        bot += 32;
+    }
+    width = (width & 0xf);
+
+    for( i = width/4; i; --i ) {
+        movq_m2r( *bot, xmm0 );
+        movq_m2r( *top, xmm1 );
+        pavgb_r2r( xmm1, xmm0 );
+        movq_r2m( xmm0, *output );
+        output += 8;
+        top += 8;
+        bot += 8;
+    }
+    width = width & 0x3;
+
+    /* Handle last few pixels. */
+    for( i = width * 2; i; --i ) {
+        *output++ = ((*top++) + (*bot++)) >> 1;
+    }
+}
+#endif
+
 static void blit_colour_packed422_scanline_c( uint8_t *output, int width, int y, int cb, int cr )
 {
     uint32_t colour = cr << 24 | y << 16 | cb << 8 | y;
@@ -2671,6 +2710,7 @@ void setup_speedy_calls( uint32_t accel, int verbose )
         if( verbose ) {
             printf( "speedycode: Using SSE2 optimized functions.\n" );
         }
+        interpolate_packed422_scanline = interpolate_packed422_scanline_sse2;
         diff_factor_packed422_scanline = diff_factor_packed422_scanline_sse2;
         vfilter_chroma_332_packed422_scanline = vfilter_chroma_332_packed422_scanline_sse2;
     }
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2010 the xine-project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * tvtime-bench: deinterlacing throughput of the tvtime methods.
+ *
+ * Every usable method deinterlaces the same synthetic fields, once in a
+ * single slice and once split on a worker pool. Reported are fields per
+ * second for both, and whether the two outputs differ (they must not).
+ * Build with "make tvtime-bench" in this directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <xine.h>
+#include <xine/xineutils.h>
+#include <xine/worker_pool.h>
+#include "tvtime.h"
+#include "speedy.h"
+#include "deinterlace.h"
+#include "plugins/plugins.h"
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* packed 4:2:2 with noise and a few edges moving by 3 pixels per frame */
+static void fill_frame (uint8_t *frame, int width, int height, int n)
+{
+  unsigned int seed = 1 + n;
+  int x, y;
+
+  for (y = 0; y < height; y++) {
+    uint8_t *p = frame + y * width * 2;
+    for (x = 0; x < width; x++) {
+      seed = seed * 1103515245 + 12345;
+      p[2 * x]     = (((x + 3 * n) / 24 + y / 24) & 1 ? 180 : 60) + ((seed >> 16) & 15);
+      p[2 * x + 1] = 128 + (((x + 3 * n) / 48) & 1 ? 20 : -20);
+    }
+  }
+}
+
+/* returns fields per second */
+static double run (tvtime_t *tvtime, uint8_t *output, uint8_t **frames,
+                   int width, int height, int fields)
+{
+  double t0 = now ();
+  int i;
+
+  for (i = 0; i < fields; i++) {
+    /* the same field order as the post plugin: both fields of a frame */
+    int bottom_field = i & 1;
+    int second_field = i & 1;
+
+    tvtime_build_deinterlaced_frame (tvtime, output,
+                                     frames[0], frames[1], frames[2],
+                                     bottom_field, second_field,
+                                     width, height, width * 2, width * 2);
+  }
+  return fields / (now () - t0);
+}
+
+/* returns 1 if single slice and pooled output are the same for both fields */
+static int check (tvtime_t *tvtime, xine_worker_pool_t *pool, uint8_t *out_single, uint8_t *out_pool,
+                  uint8_t **frames, int width, int height)
+{
+  int field;
+
+  for (field = 0; field < 2; field++) {
+    tvtime->pool = NULL;
+    tvtime_build_deinterlaced_frame (tvtime, out_single, frames[0], frames[1], frames[2],
+                                     field, field, width, height, width * 2, width * 2);
+    tvtime->pool = pool;
+    tvtime_build_deinterlaced_frame (tvtime, out_pool, frames[0], frames[1], frames[2],
+                                     field, field, width, height, width * 2, width * 2);
+    if (memcmp (out_single, out_pool, width * height * 2))
+      return 0;
+  }
+  return 1;
+}
+
+int main (int argc, char *argv[])
+{
+  int width = 720, height = 576, fields = 200, threads = 0;
+  const char *only = NULL;
+  xine_t *xine;
+  tvtime_t *tvtime;
+  xine_worker_pool_t *pool;
+  uint8_t *frames[3], *out_single, *out_pool;
+  int opt, i, ret = 0;
+
+  while ((opt = getopt (argc, argv, "w:h:n:t:m:")) != -1) {
+    switch (opt) {
+    case 'w':
+      width = atoi (optarg) & ~7;
+      break;
+    case 'h':
+      height = atoi (optarg) & ~1;
+      break;
+    case 'n':
+      fields = atoi (optarg) & ~1;
+      break;
+    case 't':
+      threads = atoi (optarg);
+      break;
+    case 'm':
+      only = optarg;
+      break;
+    default:
+      fprintf (stderr, "\
+usage: %s [options]\n\
+options:\n\
+  -w WIDTH	frame width (default: 720)\n\
+  -h HEIGHT	frame height (default: 576)\n\
+  -n FIELDS	fields per run (default: 200)\n\
+  -t THREADS	helper threads of the pool (default: one less than cpus)\n\
+  -m METHOD	only this method (short name)\n", argv[0]);
+      return 1;
+    }
+  }
+  if (width < 64 || height < 64 || fields < 2 || threads < 0) {
+    fputs ("tvtime-bench: invalid option\n", stderr);
+    return 1;
+  }
+
+  /* for xine_fast_memcpy () */
+  xine = xine_new ();
+  xine_set_flags (xine, XINE_FLAG_NO_WRITE_CACHE);
+  xine_init (xine);
+
+  setup_speedy_calls (xine_mm_accel (), 0);
+
+  register_deinterlace_method (linear_get_method ());
+  register_deinterlace_method (linearblend_get_method ());
+  register_deinterlace_method (greedy_get_method ());
+  register_deinterlace_method (greedy2frame_get_method ());
+  register_deinterlace_method (weave_get_method ());
+  register_deinterlace_method (double_get_method ());
+  register_deinterlace_method (vfir_get_method ());
+  register_deinterlace_method (scalerbob_get_method ());
+  register_deinterlace_method (dscaler_greedyh_get_method ());
+  register_deinterlace_method (dscaler_tomsmocomp_get_method ());
+  register_deinterlace_method (yadif_get_method ());
+  filter_deinterlace_methods (xine_mm_accel (), 5);
+
+  for (i = 0; i < 3; i++) {
+    frames[i] = malloc (width * height * 2);
+    if (!frames[i])
+      return 1;
+    fill_frame (frames[i], width, height, 2 - i);
+  }
+  out_single = calloc (1, width * height * 2);
+  out_pool   = calloc (1, width * height * 2);
+  if (!out_single || !out_pool)
+    return 1;
+  tvtime = tvtime_new_context ();
+  pool = xine_worker_pool_new (threads);
+
+  printf ("tvtime-bench: %dx%d, %d fields per run, %d threads\n",
+          width, height, fields, xine_worker_pool_size (pool));
+
+  for (i = 0; i < get_num_deinterlace_methods (); i++) {
+    deinterlace_method_t *method = get_deinterlace_method (i);
+    double single, pooled;
+    int same;
+
+    if (only && strcasecmp (only, method->short_name))
+      continue;
+    if (method->doscalerbob)
+      continue;
+
+    tvtime->curmethod = method;
+    tvtime->pool = NULL;
+    single = run (tvtime, out_single, frames, width, height, fields);
+    tvtime->pool = pool;
+    pooled = run (tvtime, out_pool, frames, width, height, fields);
+
+    same = check (tvtime, pool, out_single, out_pool, frames, width, height);
+    if (!same)
+      ret = 1;
+    printf ("  %-16s %-8s %8.1f fields/s single %8.1f fields/s pooled  %s\n",
+            method->short_name,
+            method->deinterlace_frame_slice ? "sliced" :
+            method->scanlinemode ? "scanline" : "frame",
+            single, pooled, same ? "same" : "DIFFERENT");
+  }
+
+  xine_worker_pool_delete (pool);
+  free (tvtime);
+  for (i = 0; i < 3; i++)
+    free (frames[i]);
+  free (out_single);
+  free (out_pool);
+  xine_exit (xine);
+  return ret;
+}
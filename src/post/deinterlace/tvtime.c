@@ -149,6 +149,196 @@ static void calculate_pulldown_score_vektor( tvtime_t *tvtime,
 }
 
 
+/**
+ * Builds the part of a deinterlaced frame that belongs to the field
+ * scanlines [first_pair, last_pair).  See deinterlace_frame_slice_t for
+ * how scanlines are assigned to slices.
+ */
+static void tvtime_build_deinterlaced_slice( tvtime_t *tvtime, uint8_t *output,
+                                             uint8_t *curframe,
+                                             uint8_t *lastframe,
+                                             uint8_t *secondlastframe,
+                                             int bottom_field, int second_field,
+                                             int width,
+                                             int frame_height,
+                                             int instride,
+                                             int outstride,
+                                             int first_pair, int last_pair )
+{
+    int i, loop_end;
+    int loop_size;
+
+    if( !tvtime->curmethod->scanlinemode ) {
+        deinterlace_frame_data_t data;
+
+        data.f0 = curframe;
+        data.f1 = lastframe;
+        data.f2 = secondlastframe;
+
+        if( tvtime->curmethod->deinterlace_frame_slice ) {
+            tvtime->curmethod->deinterlace_frame_slice( output, outstride, &data,
+                                                        bottom_field, second_field,
+                                                        width, frame_height,
+                                                        first_pair, last_pair );
+        } else if( !first_pair ) {
+            tvtime->curmethod->deinterlace_frame( output, outstride, &data,
+                                                  bottom_field, second_field,
+                                                  width, frame_height );
+        }
+        return;
+    }
+
+    if( bottom_field ) {
+        /* Advance frame pointers to the next input line. */
+        curframe += instride;
+        lastframe += instride;
+        secondlastframe += instride;
+
+        /* Double the top scanline a scanline. */
+        if( !first_pair )
+            blit_packed422_scanline( output, curframe, width );
+
+        output += outstride;
+    }
+
+    /* Copy a scanline. */
+    if( !first_pair )
+        blit_packed422_scanline( output, curframe, width );
+
+    output += outstride;
+
+    /* Skip to the first scanline pair of this slice. */
+    curframe += first_pair * instride * 2;
+    lastframe += first_pair * instride * 2;
+    secondlastframe += first_pair * instride * 2;
+    output += first_pair * outstride * 2;
+
+    /* Something is wrong here. -Billy */
+    loop_size = ((frame_height - 2) / 2);
+    loop_end = loop_size - last_pair;
+    if( loop_end < 0 )
+        loop_end = 0;
+    for( i = loop_size - first_pair; i > loop_end; --i ) {
+        deinterlace_scanline_data_t data;
+
+        data.bottom_field = bottom_field;
+
+        data.t0 = curframe;
+        data.b0 = curframe + (instride*2);
+
+        if( second_field ) {
+            data.tt1 = (i < loop_size) ? (curframe - instride) : (curframe + instride);
+            data.m1  = curframe + instride;
+            data.bb1 = (i > 1) ? (curframe + (instride*3)) : (curframe + instride);
+        } else {
+            data.tt1 = (i < loop_size) ? (lastframe - instride) : (lastframe + instride);
+            data.m1  = lastframe + instride;
+            data.bb1 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
+        }
+
+        data.t2 = lastframe;
+        data.b2 = lastframe + (instride*2);
+
+        if( second_field ) {
+            data.tt3 = (i < loop_size) ? (lastframe - instride) : (lastframe + instride);
+            data.m3  = lastframe + instride;
+            data.bb3 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
+        } else {
+            data.tt3 = (i < loop_size) ? (secondlastframe - instride) : (secondlastframe + instride);
+            data.m3  = secondlastframe + instride;
+            data.bb3 = (i > 1) ? (secondlastframe + (instride*3)) : (secondlastframe + instride);
+        }
+
+        tvtime->curmethod->interpolate_scanline( output, &data, width );
+
+        output += outstride;
+
+        data.tt0 = curframe;
+        data.m0  = curframe + (instride*2);
+        data.bb0 = (i > 1) ? (curframe + (instride*4)) : (curframe + (instride*2));
+
+        if( second_field ) {
+            data.t1 = curframe + instride;
+            data.b1 = (i > 1) ? (curframe + (instride*3)) : (curframe + instride);
+        } else {
+            data.t1 = lastframe + instride;
+            data.b1 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
+        }
+
+        data.tt2 = lastframe;
+        data.m2  = lastframe + (instride*2);
+        data.bb2 = (i > 1) ? (lastframe + (instride*4)) : (lastframe + (instride*2));
+
+        if( second_field ) {
+            data.t2 = lastframe + instride;
+            data.b2 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
+        } else {
+            data.t2 = secondlastframe + instride;
+            data.b2 = (i > 1) ? (secondlastframe + (instride*3)) : (secondlastframe + instride);
+        }
+
+        /* Copy a scanline. */
+        tvtime->curmethod->copy_scanline( output, &data, width );
+        curframe += instride * 2;
+        lastframe += instride * 2;
+        secondlastframe += instride * 2;
+
+        output += outstride;
+    }
+
+    if( !bottom_field && last_pair > loop_size ) {
+        /* Double the bottom scanline. */
+        blit_packed422_scanline( output, curframe, width );
+    }
+}
+
+typedef struct {
+    tvtime_t *tvtime;
+    uint8_t *output;
+    uint8_t *curframe;
+    uint8_t *lastframe;
+    uint8_t *secondlastframe;
+    int bottom_field;
+    int second_field;
+    int width;
+    int frame_height;
+    int instride;
+    int outstride;
+} tvtime_slice_job_t;
+
+static void tvtime_slice_job( void *data, int slice, int num_slices )
+{
+    tvtime_slice_job_t *job = (tvtime_slice_job_t *) data;
+    int pairs = job->frame_height / 2;
+
+    tvtime_build_deinterlaced_slice( job->tvtime, job->output, job->curframe,
+                                     job->lastframe, job->secondlastframe,
+                                     job->bottom_field, job->second_field,
+                                     job->width, job->frame_height,
+                                     job->instride, job->outstride,
+                                     pairs * slice / num_slices,
+                                     pairs * (slice + 1) / num_slices );
+}
+
+/**
+ * Frame methods that can't build parts of a frame run in a single slice.
+ * Very small planes are not worth the thread handover either.
+ */
+static int tvtime_num_slices( tvtime_t *tvtime, int frame_height )
+{
+    int slices;
+
+    if( !tvtime->curmethod->scanlinemode && !tvtime->curmethod->deinterlace_frame_slice )
+        return 1;
+
+    slices = xine_worker_pool_size( tvtime->pool );
+    if( slices > frame_height / 32 )
+        slices = frame_height / 32;
+
+    return slices > 0 ? slices : 1;
+}
+
+
 int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
                                              uint8_t *curframe,
                                              uint8_t *lastframe,
@@ -159,8 +349,6 @@ int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
                                              int instride,
                                              int outstride )
 {
-    int i;
-
     if( tvtime->pulldown_alg != PULLDOWN_VEKTOR ) {
         /* If we leave vektor pulldown mode, lose our state. */
         tvtime->filmmode = 0;
@@ -244,118 +432,28 @@ int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
         }
     }
 
-    if( !tvtime->curmethod->scanlinemode ) {
-        deinterlace_frame_data_t data;
-
-        data.f0 = curframe;
-        data.f1 = lastframe;
-        data.f2 = secondlastframe;
-
-        tvtime->curmethod->deinterlace_frame( output, outstride, &data, bottom_field, second_field,
-                                      width, frame_height );
-
+    if( tvtime->pool ) {
+        tvtime_slice_job_t job;
+
+        job.tvtime = tvtime;
+        job.output = output;
+        job.curframe = curframe;
+        job.lastframe = lastframe;
+        job.secondlastframe = secondlastframe;
+        job.bottom_field = bottom_field;
+        job.second_field = second_field;
+        job.width = width;
+        job.frame_height = frame_height;
+        job.instride = instride;
+        job.outstride = outstride;
+
+        xine_worker_pool_run( tvtime->pool, tvtime_num_slices( tvtime, frame_height ),
+                              tvtime_slice_job, &job );
     } else {
-        int loop_size;
-        int scanline = 0;
-
-        if( bottom_field ) {
-            /* Advance frame pointers to the next input line. */
-            curframe += instride;
-            lastframe += instride;
-            secondlastframe += instride;
-
-            /* Double the top scanline a scanline. */
-            blit_packed422_scanline( output, curframe, width );
-
-            output += outstride;
-            scanline++;
-        }
-
-        /* Copy a scanline. */
-        blit_packed422_scanline( output, curframe, width );
-
-        output += outstride;
-        scanline++;
-
-        /* Something is wrong here. -Billy */
-        loop_size = ((frame_height - 2) / 2);
-        for( i = loop_size; i; --i ) {
-            deinterlace_scanline_data_t data;
-
-            data.bottom_field = bottom_field;
-
-            data.t0 = curframe;
-            data.b0 = curframe + (instride*2);
-
-            if( second_field ) {
-                data.tt1 = (i < loop_size) ? (curframe - instride) : (curframe + instride);
-                data.m1  = curframe + instride;
-                data.bb1 = (i > 1) ? (curframe + (instride*3)) : (curframe + instride);
-            } else {
-                data.tt1 = (i < loop_size) ? (lastframe - instride) : (lastframe + instride);
-                data.m1  = lastframe + instride;
-                data.bb1 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
-            }
-
-            data.t2 = lastframe;
-            data.b2 = lastframe + (instride*2);
-
-            if( second_field ) {
-                data.tt3 = (i < loop_size) ? (lastframe - instride) : (lastframe + instride);
-                data.m3  = lastframe + instride;
-                data.bb3 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
-            } else {
-                data.tt3 = (i < loop_size) ? (secondlastframe - instride) : (secondlastframe + instride);
-                data.m3  = secondlastframe + instride;
-                data.bb3 = (i > 1) ? (secondlastframe + (instride*3)) : (secondlastframe + instride);
-            }
-
-            tvtime->curmethod->interpolate_scanline( output, &data, width );
-
-            output += outstride;
-            scanline++;
-
-            data.tt0 = curframe;
-            data.m0  = curframe + (instride*2);
-            data.bb0 = (i > 1) ? (curframe + (instride*4)) : (curframe + (instride*2));
-
-            if( second_field ) {
-                data.t1 = curframe + instride;
-                data.b1 = (i > 1) ? (curframe + (instride*3)) : (curframe + instride);
-            } else {
-                data.t1 = lastframe + instride;
-                data.b1 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
-            }
-
-            data.tt2 = lastframe;
-            data.m2  = lastframe + (instride*2);
-            data.bb2 = (i > 1) ? (lastframe + (instride*4)) : (lastframe + (instride*2));
-
-            if( second_field ) {
-                data.t2 = lastframe + instride;
-                data.b2 = (i > 1) ? (lastframe + (instride*3)) : (lastframe + instride);
-            } else {
-                data.t2 = secondlastframe + instride;
-                data.b2 = (i > 1) ? (secondlastframe + (instride*3)) : (secondlastframe + instride);
-            }
-
-            /* Copy a scanline. */
-            tvtime->curmethod->copy_scanline( output, &data, width );
-            curframe += instride * 2;
-            lastframe += instride * 2;
-            secondlastframe += instride * 2;
-
-            output += outstride;
-            scanline++;
-        }
-
-        if( !bottom_field ) {
-            /* Double the bottom scanline. */
-            blit_packed422_scanline( output, curframe, width );
-
-            output += outstride;
-            scanline++;
-        }
+        tvtime_build_deinterlaced_slice( tvtime, output, curframe, lastframe,
+                                         secondlastframe, bottom_field, second_field,
+                                         width, frame_height, instride, outstride,
+                                         0, frame_height / 2 );
     }
 
     return 1;
@@ -418,6 +516,8 @@ tvtime_t *tvtime_new_context(void)
 
   tvtime->curmethod = NULL;
 
+  tvtime->pool = NULL;
+
   tvtime_reset_context(tvtime);
 
   return tvtime;
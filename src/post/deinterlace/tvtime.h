@@ -25,6 +25,9 @@
 #include <stdint.h>
 #endif
 
+#include <xine/attributes.h>
+#include <xine/worker_pool.h>
+
 #include "deinterlace.h"
 
 /**
@@ -62,6 +65,12 @@ typedef struct {
    */
   unsigned int pulldown_error_wait;
 
+  /**
+   * xine: if set, the deinterlacing work is split into horizontal bands
+   * which are processed in parallel by this pool.
+   */
+  xine_worker_pool_t *pool;
+
   /* internal data */
   int last_topdiff;
   int last_botdiff;
@@ -65,6 +65,11 @@ static const char *const enum_framerate[] = { "full", "half_top", "half_bottom",
 
 static void *help_string;
 
+/* one pool for the deinterlacers of all instances */
+static pthread_mutex_t     pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static xine_worker_pool_t *pool_shared;
+static int                 pool_refs;
+
 /*
  * this is the struct used by "parameters api"
  */
@@ -326,6 +331,7 @@ static void *deinterlace_init_plugin(xine_t *xine, void *data)
   register_deinterlace_method( scalerbob_get_method() );
   register_deinterlace_method( dscaler_greedyh_get_method() );
   register_deinterlace_method( dscaler_tomsmocomp_get_method() );
+  register_deinterlace_method( yadif_get_method() );
 
   filter_deinterlace_methods( config_flags, 5 /*fieldsavailable*/ );
   if( !get_num_deinterlace_methods() ) {
@@ -390,6 +396,13 @@ static post_plugin_t *deinterlace_open_plugin(post_class_t *class_gen, int input
   _x_post_init(&this->post, 0, 1);
 
   this->tvtime = tvtime_new_context();
+
+  pthread_mutex_lock(&pool_lock);
+  if (!pool_refs++)
+    pool_shared = xine_worker_pool_new(0);
+  this->tvtime->pool = pool_shared;
+  pthread_mutex_unlock(&pool_lock);
+
   this->tvtime_changed++;
   this->tvtime_last_filmmode = 0;
 
@@ -437,6 +450,14 @@ static void deinterlace_dispose(post_plugin_t *this_gen)
   if (_x_post_dispose(this_gen)) {
     _flush_frames(this);
     pthread_mutex_destroy(&this->lock);
+
+    pthread_mutex_lock(&pool_lock);
+    if (!--pool_refs) {
+      xine_worker_pool_delete(pool_shared);
+      pool_shared = NULL;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
     free(this->tvtime);
     free(this);
   }
@@ -34,6 +34,8 @@
 
 #include <xine/xine_internal.h>
 #include <xine/post.h>
+#include <xine/worker_pool.h>
+#include "xine_mmx.h"
 
 /* FIXME: This plugin needs to handle overlays as well. */
 
@@ -75,12 +77,37 @@ struct post_class_mosaico_s {
   xine_t         *xine;
 };
 
+/* one output pixel of a tile line averages n source pixels from x on */
+typedef struct {
+  unsigned int  x, n, recip;
+} mosaico_span_t;
+
+/* scale job for one plane of a tile */
+typedef struct {
+  const uint8_t        *src;
+  int                   src_pitch, src_width, src_height;
+  uint8_t              *dst;
+  int                   dst_pitch, dst_width, dst_height;
+  const mosaico_span_t *spans;
+} mosaico_scale_t;
+
 /* plugin structures */
 typedef struct mosaico_pip_s mosaico_pip_t;
 struct mosaico_pip_s {
   unsigned int  x, y, w, h;
   vo_frame_t   *frame;
   char         *input_name;
+
+  /* frame scaled to w x h.  It is scaled again only when a new frame
+   * arrived or the geometry changed, and pasted from here otherwise. */
+  int             dirty;
+  int             tile_valid;
+  unsigned int    tile_w, tile_h;
+  uint8_t        *tile;
+  uint8_t        *tile_base[3];
+  int             tile_pitch[3];
+  mosaico_span_t *spans[2];        /* luma, chroma */
+  int             spans_width[2];  /* source width they were made for */
 };
 
 struct post_mosaico_s {
@@ -94,8 +121,32 @@ struct post_mosaico_s {
   int              skip;
   pthread_mutex_t  mutex;
   unsigned int     pip_count;
+
+  xine_worker_pool_t *pool;
+  mosaico_scale_t *scales;         /* 3 per pip */
+  int              num_scales;
+  uint8_t         *lines;          /* one source line per slice */
+  int              line_size;
 };
 
+/* composition of the output frame, done in bands of lines */
+typedef struct {
+  post_mosaico_t  *this;
+  vo_frame_t      *to, *from;
+} mosaico_compose_t;
+
+/* line averaging, picked at open time */
+static void average_lines_c(uint8_t *line, const uint8_t *src, int pitch, int width, int count);
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+static void average_lines_sse2(uint8_t *line, const uint8_t *src, int pitch, int width, int count);
+#endif
+static void (*average_lines)(uint8_t *line, const uint8_t *src, int pitch, int width, int count);
+
+/* one pool for the scalers and composers of all instances */
+static pthread_mutex_t     pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static xine_worker_pool_t *pool_shared;
+static int                 pool_refs;
+
 /* plugin class functions */
 static post_plugin_t *mosaico_open_plugin(post_class_t *class_gen, int inputs,
 					 xine_audio_port_t **audio_target,
@@ -159,8 +210,21 @@ static post_plugin_t *mosaico_open_plugin(post_class_t *class_gen, int inputs,
 
   _x_post_init(&this->post, 0, inputs);
 
+  average_lines = average_lines_c;
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+  if (xine_mm_accel() & MM_ACCEL_X86_SSE2)
+    average_lines = average_lines_sse2;
+#endif
+
   this->pip       = (mosaico_pip_t *)calloc((inputs - 1), sizeof(mosaico_pip_t));
   this->pip_count = inputs - 1;
+  this->scales    = (mosaico_scale_t *)calloc(3 * (inputs - 1), sizeof(mosaico_scale_t));
+
+  pthread_mutex_lock(&pool_lock);
+  if (!pool_refs++)
+    pool_shared = xine_worker_pool_new(0);
+  this->pool = pool_shared;
+  pthread_mutex_unlock(&pool_lock);
 
   pthread_cond_init(&this->vpts_limit_changed, NULL);
   pthread_mutex_init(&this->mutex, NULL);
@@ -208,9 +272,21 @@ static void mosaico_dispose(post_plugin_t *this_gen)
 
   if (_x_post_dispose(this_gen)) {
     int i;
-    for (i = 0; i < this->pip_count; i++)
+    for (i = 0; i < this->pip_count; i++) {
       free(this->pip[i].input_name);
+      free(this->pip[i].tile);
+      free(this->pip[i].spans[0]);
+      free(this->pip[i].spans[1]);
+    }
     free(this->pip);
+    free(this->scales);
+    free(this->lines);
+    pthread_mutex_lock(&pool_lock);
+    if (!--pool_refs) {
+      xine_worker_pool_delete(pool_shared);
+      pool_shared = NULL;
+    }
+    pthread_mutex_unlock(&pool_lock);
     pthread_cond_destroy(&this->vpts_limit_changed);
     pthread_mutex_destroy(&this->mutex);
     free(this);
@@ -228,11 +304,14 @@ static int mosaico_set_parameters(xine_post_t *this_gen, void *param_gen)
   post_mosaico_t *this = (post_mosaico_t *)this_gen;
   mosaico_parameters_t *param = (mosaico_parameters_t *)param_gen;
 
-  if (param->pip_num > this->pip_count) return 0;
+  if (param->pip_num > this->pip_count || param->pip_num < 1) return 0;
+  pthread_mutex_lock(&this->mutex);
   this->pip[param->pip_num - 1].x = param->x;
   this->pip[param->pip_num - 1].y = param->y;
   this->pip[param->pip_num - 1].w = param->w;
   this->pip[param->pip_num - 1].h = param->h;
+  this->pip[param->pip_num - 1].dirty = 1;
+  pthread_mutex_unlock(&this->mutex);
   return 1;
 }
 
@@ -293,94 +372,281 @@ static int mosaico_intercept_frame(post_video_port_t *port, vo_frame_t *frame)
 }
 
 
-static void frame_copy_content(vo_frame_t *to, vo_frame_t *from)
+/* Vertical box average of count (2..256) lines into line.  Sums stay
+ * below 65536, and ((sum + count/2) * (65536/count)) >> 16 never exceeds
+ * the rounded average.
+ */
+static void average_lines_c(uint8_t *line, const uint8_t *src, int pitch, int width, int count)
 {
-  int size;
-
-  switch (from->format) {
-  case XINE_IMGFMT_YUY2:
-    /* TODO: implement conversion to YV12 or implement support to paste
-     * frames of different types together */
-    break;
-
-  case XINE_IMGFMT_YV12:
-    /* Y */
-    size = to->pitches[0] * to->height;
-    xine_fast_memcpy(to->base[0], from->base[0], size);
-
-    /* U */
-    size = to->pitches[1] * ((to->height + 1) / 2);
-    xine_fast_memcpy(to->base[1], from->base[1], size);
-
-    /* V */
-    size = to->pitches[2] * ((to->height + 1) / 2);
-    xine_fast_memcpy(to->base[2], from->base[2], size);
+  unsigned int recip = 65536 / count;
+  int x, k;
+
+  for (x = 0; x < width; x++) {
+    const uint8_t *s = src + x;
+    unsigned int sum = count >> 1;
+
+    for (k = 0; k < count; k++, s += pitch)
+      sum += *s;
+    line[x] = (sum * recip) >> 16;
   }
 }
 
-static void frame_paste(post_mosaico_t *this, vo_frame_t *background, int pip_num)
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+/* Same as average_lines_c(), 16 pixels at a time in two word registers */
+static void average_lines_sse2(uint8_t *line, const uint8_t *src, int pitch, int width, int count)
 {
-  unsigned long target_width, target_height;
-  unsigned long source_width, source_height;
-  unsigned long background_width;
-  unsigned long scale_x, scale_y;
-  const int shift_x = 3, shift_y = 3;
-  unsigned long pos_x, pos_y, pos;
-  unsigned long target_offset, source_offset;
-  unsigned long i, j;
-
-  if (!this->pip[pip_num].frame) return;
-
-  target_width  = this->pip[pip_num].w;
-  target_height = this->pip[pip_num].h;
-  background_width = background->width;
-  source_width = this->pip[pip_num].frame->width;
-  source_height = this->pip[pip_num].frame->height;
-  scale_x = (source_width << shift_x) / target_width;
-  scale_y = (source_height << shift_y) / target_height;
-  pos_x = this->pip[pip_num].x;
-  pos_y = this->pip[pip_num].y;
-  pos = pos_y * background_width + pos_x;
-
-  switch (this->pip[pip_num].frame->format) {
-  case XINE_IMGFMT_YUY2:
-    /* TODO: implement YUY2 */
-    break;
-
-  case XINE_IMGFMT_YV12:
-    /* Y */
-    target_offset = 0;
-    for (j = 0; j < target_height; j++, target_offset += (background_width - target_width))
-      for (i = 0; i < target_width; i++, target_offset++) {
-	source_offset = ((i * scale_x) >> shift_x) + (((j * scale_y) >> shift_y) * source_width);
-	background->base[0][pos + target_offset] = this->pip[pip_num].frame->base[0][source_offset];
-      }
-
-    background_width = (background_width + 1) / 2;
-    source_width = (source_width + 1) / 2;
-    pos_x = (pos_x + 1) / 2;
-    pos_y = (pos_y + 1) / 2;
-    pos = pos_y * background_width + pos_x;
-    target_width = (target_width + 1) / 2;
-    target_height = (target_height + 1) / 2;
-
-    /* U */
-    target_offset = 0;
-    for (j = 0; j < target_height; j++, target_offset += (background_width - target_width))
-      for (i = 0; i < target_width; i++, target_offset++) {
-	source_offset = ((i * scale_x) >> shift_x) + (((j * scale_y) >> shift_y) * source_width);
-	background->base[1][pos + target_offset] = this->pip[pip_num].frame->base[1][source_offset];
-      }
-
-    /* V */
-    target_offset = 0;
-    for (j = 0; j < target_height; j++, target_offset += (background_width - target_width))
-      for (i = 0; i < target_width; i++, target_offset++) {
-	source_offset = ((i * scale_x) >> shift_x) + (((j * scale_y) >> shift_y) * source_width);
-	background->base[2][pos + target_offset] = this->pip[pip_num].frame->base[2][source_offset];
-      }
-
-    break;
+  sse_t half, recip;
+  int x, k, i;
+
+  for (i = 0; i < 8; i++) {
+    half.w[i]  = count >> 1;
+    recip.w[i] = 65536 / count;
+  }
+
+  for (x = 0; x + 16 <= width; x += 16) {
+    const uint8_t *s = src + x;
+
+    pxor_r2r(xmm7, xmm7);
+    movdqu_m2r(half, xmm0);
+    movdqa_r2r(xmm0, xmm1);
+    for (k = 0; k < count; k++, s += pitch) {
+      movdqu_m2r(*(sse_t *)s, xmm2);
+      movdqa_r2r(xmm2, xmm3);
+      punpcklbw_r2r(xmm7, xmm2);
+      punpckhbw_r2r(xmm7, xmm3);
+      paddw_r2r(xmm2, xmm0);
+      paddw_r2r(xmm3, xmm1);
+    }
+    movdqu_m2r(recip, xmm4);
+    pmulhuw_r2r(xmm4, xmm0);
+    pmulhuw_r2r(xmm4, xmm1);
+    packuswb_r2r(xmm1, xmm0);
+    movdqu_r2m(xmm0, *(sse_t *)(line + x));
+  }
+
+  if (x < width)
+    average_lines_c(line + x, src + x, pitch, width - x, count);
+}
+#endif
+
+/* Box of source pixels for every output pixel of a dst_width line. */
+static void make_spans(mosaico_span_t *spans, int src_width, int dst_width)
+{
+  int x;
+
+  for (x = 0; x < dst_width; x++) {
+    int x1 = x * src_width / dst_width;
+    int x2 = (x + 1) * src_width / dst_width;
+
+    if (x2 <= x1)
+      x2 = x1 + 1;
+    spans[x].x     = x1;
+    spans[x].n     = x2 - x1;
+    spans[x].recip = 65536 / spans[x].n;
+  }
+}
+
+/* area averaging downscale of dst lines [first, last) */
+static void scale_lines(const mosaico_scale_t *sc, int first, int last, uint8_t *line)
+{
+  int y, x;
+
+  for (y = first; y < last; y++) {
+    int y1 = y * sc->src_height / sc->dst_height;
+    int y2 = (y + 1) * sc->src_height / sc->dst_height;
+    const uint8_t *src = sc->src + y1 * sc->src_pitch;
+    uint8_t *dst = sc->dst + y * sc->dst_pitch;
+
+    if (y2 > y1 + 256)
+      y2 = y1 + 256;
+    if (y2 > y1 + 1) {
+      average_lines(line, src, sc->src_pitch, sc->src_width, y2 - y1);
+      src = line;
+    }
+
+    for (x = 0; x < sc->dst_width; x++) {
+      const mosaico_span_t *span = &sc->spans[x];
+      const uint8_t *s = src + span->x;
+      unsigned int sum = span->n >> 1;
+      unsigned int n;
+
+      for (n = 0; n < span->n; n++)
+        sum += s[n];
+      dst[x] = (sum * span->recip) >> 16;
+    }
+  }
+}
+
+static void scale_slice(void *data, int slice, int num_slices)
+{
+  post_mosaico_t *this = (post_mosaico_t *)data;
+  uint8_t *line = this->lines + slice * this->line_size;
+  int i;
+
+  for (i = 0; i < this->num_scales; i++) {
+    const mosaico_scale_t *sc = &this->scales[i];
+    int first = sc->dst_height * slice / num_slices;
+    int last  = sc->dst_height * (slice + 1) / num_slices;
+
+    if (last > first)
+      scale_lines(sc, first, last, line);
+  }
+}
+
+/* (re)allocates the tile of a pip and queues scale jobs for its planes */
+static int tile_prepare(post_mosaico_t *this, mosaico_pip_t *pip)
+{
+  vo_frame_t *frame = pip->frame;
+  int plane;
+
+  if (!pip->w || !pip->h || frame->width <= 0 || frame->height <= 0) {
+    pip->tile_valid = 0;
+    return 0;
+  }
+
+  if (!pip->tile || pip->tile_w != pip->w || pip->tile_h != pip->h) {
+    int cw = (pip->w + 1) / 2, ch = (pip->h + 1) / 2;
+
+    free(pip->tile);
+    free(pip->spans[0]);
+    free(pip->spans[1]);
+    pip->tile     = malloc(pip->w * pip->h + 2 * cw * ch);
+    pip->spans[0] = malloc(pip->w * sizeof(mosaico_span_t));
+    pip->spans[1] = malloc(cw * sizeof(mosaico_span_t));
+    pip->spans_width[0] = pip->spans_width[1] = 0;
+    pip->tile_valid = 0;
+    if (!pip->tile || !pip->spans[0] || !pip->spans[1]) {
+      free(pip->tile);
+      free(pip->spans[0]);
+      free(pip->spans[1]);
+      pip->tile = NULL;
+      pip->spans[0] = pip->spans[1] = NULL;
+      return 0;
+    }
+    pip->tile_w = pip->w;
+    pip->tile_h = pip->h;
+    pip->tile_pitch[0] = pip->w;
+    pip->tile_pitch[1] = pip->tile_pitch[2] = cw;
+    pip->tile_base[0] = pip->tile;
+    pip->tile_base[1] = pip->tile_base[0] + pip->w * pip->h;
+    pip->tile_base[2] = pip->tile_base[1] + cw * ch;
+  }
+
+  for (plane = 0; plane < 3; plane++) {
+    mosaico_scale_t *sc = &this->scales[this->num_scales++];
+    int sh = plane ? 1 : 0;
+
+    sc->src        = frame->base[plane];
+    sc->src_pitch  = frame->pitches[plane];
+    sc->src_width  = (frame->width + sh) >> sh;
+    sc->src_height = (frame->height + sh) >> sh;
+    sc->dst        = pip->tile_base[plane];
+    sc->dst_pitch  = pip->tile_pitch[plane];
+    sc->dst_width  = (pip->w + sh) >> sh;
+    sc->dst_height = (pip->h + sh) >> sh;
+
+    if (pip->spans_width[sh] != sc->src_width) {
+      make_spans(pip->spans[sh], sc->src_width, sc->dst_width);
+      pip->spans_width[sh] = sc->src_width;
+    }
+    sc->spans = pip->spans[sh];
+  }
+
+  return 1;
+}
+
+/* scales all pips that got a new frame, spread over the worker pool */
+static void tiles_update(post_mosaico_t *this)
+{
+  int pip_num, slices, line_size = 0;
+
+  this->num_scales = 0;
+  for (pip_num = 0; pip_num < this->pip_count; pip_num++) {
+    mosaico_pip_t *pip = &this->pip[pip_num];
+
+    if (!pip->frame || !pip->dirty)
+      continue;
+    pip->dirty = 0;
+    pip->tile_valid = tile_prepare(this, pip);
+    if (pip->tile_valid && pip->frame->width > line_size)
+      line_size = pip->frame->width;
+  }
+  if (!this->num_scales)
+    return;
+
+  slices = xine_worker_pool_size(this->pool);
+  line_size = (line_size + 15) & ~15;
+  if (line_size > this->line_size) {
+    free(this->lines);
+    this->lines = malloc(slices * line_size);
+    this->line_size = this->lines ? line_size : 0;
+    if (!this->lines) {
+      for (pip_num = 0; pip_num < this->pip_count; pip_num++)
+        this->pip[pip_num].tile_valid = 0;
+      return;
+    }
+  }
+
+  xine_worker_pool_run(this->pool, slices, scale_slice, this);
+}
+
+/* copies lines [first, last) of one plane of the background and pastes
+ * the parts of the tiles that fall into them */
+static void compose_lines(post_mosaico_t *this, vo_frame_t *to, vo_frame_t *from,
+                          int plane, int first, int last)
+{
+  int sh = plane ? 1 : 0;
+  int width = (to->width + sh) >> sh;
+  int height = (to->height + sh) >> sh;
+  int y, pip_num;
+
+  if (to->pitches[plane] == from->pitches[plane])
+    xine_fast_memcpy(to->base[plane] + first * to->pitches[plane],
+                     from->base[plane] + first * from->pitches[plane],
+                     (last - first) * to->pitches[plane]);
+  else
+    for (y = first; y < last; y++)
+      xine_fast_memcpy(to->base[plane] + y * to->pitches[plane],
+                       from->base[plane] + y * from->pitches[plane], width);
+
+  for (pip_num = 0; pip_num < this->pip_count; pip_num++) {
+    mosaico_pip_t *pip = &this->pip[pip_num];
+    int x1, y1, w, y2;
+
+    if (!pip->frame || !pip->tile_valid)
+      continue;
+
+    /* clip the tile to the background */
+    x1 = (pip->x + sh) >> sh;
+    y1 = (pip->y + sh) >> sh;
+    w  = (pip->tile_w + sh) >> sh;
+    y2 = y1 + ((pip->tile_h + sh) >> sh);
+    if (x1 >= width || y1 >= height)
+      continue;
+    if (w > width - x1)
+      w = width - x1;
+    if (y2 > height)
+      y2 = height;
+
+    for (y = MAX(y1, first); y < MIN(y2, last); y++)
+      xine_fast_memcpy(to->base[plane] + y * to->pitches[plane] + x1,
+                       pip->tile_base[plane] + (y - y1) * pip->tile_pitch[plane], w);
+  }
+}
+
+static void compose_slice(void *data, int slice, int num_slices)
+{
+  mosaico_compose_t *job = (mosaico_compose_t *)data;
+  int plane;
+
+  for (plane = 0; plane < 3; plane++) {
+    int sh = plane ? 1 : 0;
+    int height = (job->to->height + sh) >> sh;
+    int first = height * slice / num_slices;
+    int last  = height * (slice + 1) / num_slices;
+
+    if (last > first)
+      compose_lines(job->this, job->to, job->from, plane, first, last);
   }
 }
 
@@ -389,7 +655,8 @@ static int mosaico_draw_background(vo_frame_t *frame, xine_stream_t *stream)
   post_video_port_t *port = (post_video_port_t *)frame->port;
   post_mosaico_t *this = (post_mosaico_t *)port->post;
   vo_frame_t *background;
-  int pip_num, skip;
+  mosaico_compose_t job;
+  int skip;
 
   pthread_mutex_lock(&this->mutex);
 
@@ -414,10 +681,12 @@ static int mosaico_draw_background(vo_frame_t *frame, xine_stream_t *stream)
   background = port->original_port->get_frame(port->original_port,
     frame->width, frame->height, frame->ratio, frame->format, frame->flags | VO_BOTH_FIELDS);
   _x_post_frame_copy_down(frame, background);
-  frame_copy_content(background, frame);
 
-  for (pip_num = 0; pip_num < this->pip_count; pip_num++)
-    frame_paste(this, background, pip_num);
+  tiles_update(this);
+  job.this = this;
+  job.to   = background;
+  job.from = frame;
+  xine_worker_pool_run(this->pool, xine_worker_pool_size(this->pool), compose_slice, &job);
 
   skip = background->draw(background, stream);
   _x_post_frame_copy_up(frame, background);
@@ -457,8 +726,10 @@ static int mosaico_draw(vo_frame_t *frame, xine_stream_t *stream)
     /* we are too early */
     pthread_cond_wait(&this->vpts_limit_changed, &this->mutex);
   free_frame = this->pip[pip_num].frame;
-  if (port->stream)
+  if (port->stream) {
     this->pip[pip_num].frame = frame;
+    this->pip[pip_num].dirty = 1;
+  }
 
   if (this->skip && frame->vpts <= this->skip_vpts)
     skip = this->skip;
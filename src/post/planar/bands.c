@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * band processing shared by the planar post plugins
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+#include <xine/attributes.h>
+#include "planar.h"
+
+/* don't bother other threads with less than this many lines */
+#define MIN_BAND_LINES 16
+
+/* longest chain of stages run in one pass */
+#define MAX_FUSED_STAGES 4
+
+static pthread_mutex_t     pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static xine_worker_pool_t *pool_shared;
+static int                 pool_refs;
+
+typedef struct {
+  int                 num_planes;
+  const int          *lines;
+  planar_band_func_t  func;
+  void               *data;
+
+  int                 num_stages;
+  planar_stage_t     *stages[MAX_FUSED_STAGES];
+  vo_frame_t         *frames[MAX_FUSED_STAGES];
+} bands_job_t;
+
+xine_worker_pool_t *planar_pool_ref(void)
+{
+  xine_worker_pool_t *pool;
+
+  pthread_mutex_lock(&pool_lock);
+  if (!pool_refs++)
+    pool_shared = xine_worker_pool_new(0);
+  pool = pool_shared;
+  pthread_mutex_unlock(&pool_lock);
+
+  return pool;
+}
+
+void planar_pool_unref(void)
+{
+  pthread_mutex_lock(&pool_lock);
+  if (!--pool_refs) {
+    xine_worker_pool_delete(pool_shared);
+    pool_shared = NULL;
+  }
+  pthread_mutex_unlock(&pool_lock);
+}
+
+int planar_max_bands(xine_worker_pool_t *pool)
+{
+  return xine_worker_pool_size(pool);
+}
+
+static void bands_slice(void *data, int slice, int num_slices)
+{
+  bands_job_t *job = (bands_job_t *)data;
+  int plane;
+
+  for (plane = 0; plane < job->num_planes; plane++) {
+    int lines = job->lines[plane];
+    int start = lines * slice / num_slices;
+    int end   = lines * (slice + 1) / num_slices;
+
+    if (end > start) {
+      int i;
+
+      job->func(job->data, plane, start, end, slice);
+      for (i = 0; i < job->num_stages; i++)
+        job->stages[i]->band(job->stages[i]->data, job->frames[i], plane, start, end);
+    }
+  }
+}
+
+static int bands_count(xine_worker_pool_t *pool, const int *lines)
+{
+  int bands;
+
+  bands = planar_max_bands(pool);
+  if (bands > lines[0] / MIN_BAND_LINES)
+    bands = lines[0] / MIN_BAND_LINES;
+  if (bands < 1)
+    bands = 1;
+
+  return bands;
+}
+
+void planar_run_bands(xine_worker_pool_t *pool, int num_planes, const int *lines,
+                      planar_band_func_t func, void *data)
+{
+  bands_job_t job;
+  int bands;
+
+  bands = bands_count(pool, lines);
+
+  job.num_planes = num_planes;
+  job.lines      = lines;
+  job.func       = func;
+  job.data       = data;
+  job.num_stages = 0;
+
+  xine_worker_pool_run(pool, bands, bands_slice, &job);
+}
+
+/* draw of all stage ports, marks their frames */
+static int stage_draw(vo_frame_t *frame, xine_stream_t *stream)
+{
+  post_video_port_t *port  = (post_video_port_t *)frame->port;
+  planar_stage_t    *stage = (planar_stage_t *)port->user_data;
+
+  return stage->draw(frame, stream);
+}
+
+void planar_stage_register(planar_stage_t *stage, post_video_port_t *port)
+{
+  stage->draw  = port->new_frame->draw;
+  stage->fused = NULL;
+
+  port->user_data       = stage;
+  port->new_frame->draw = stage_draw;
+}
+
+int planar_stage_fused(planar_stage_t *stage, vo_frame_t *frame)
+{
+  /* set and cleared by the thread that draws the frame */
+  if (stage->fused != frame)
+    return 0;
+  stage->fused = NULL;
+  return 1;
+}
+
+/* the stage that will filter frame when it is drawn, if any */
+static planar_stage_t *stage_of_frame(vo_frame_t *frame)
+{
+  if (frame->draw != stage_draw)
+    return NULL;
+  return (planar_stage_t *)((post_video_port_t *)frame->port)->user_data;
+}
+
+void planar_run_bands_fused(xine_worker_pool_t *pool, const int *lines,
+                            planar_band_func_t func, void *data, vo_frame_t *dst)
+{
+  bands_job_t job;
+  int bands, i;
+
+  bands = bands_count(pool, lines);
+
+  job.num_planes = 3;
+  job.lines      = lines;
+  job.func       = func;
+  job.data       = data;
+  job.num_stages = 0;
+
+  /* a frame intercepted by a stage passes on its next frame,
+   * which may belong to another stage */
+  if (!dst->bad_frame && dst->format == XINE_IMGFMT_YV12) {
+    vo_frame_t *frame = dst;
+
+    while (frame && job.num_stages < MAX_FUSED_STAGES) {
+      planar_stage_t *stage = stage_of_frame(frame);
+
+      if (!stage || !stage->prepare(stage->data))
+        break;
+      job.stages[job.num_stages] = stage;
+      job.frames[job.num_stages] = frame;
+      job.num_stages++;
+      frame = frame->next;
+    }
+  }
+
+  xine_worker_pool_run(pool, bands, bands_slice, &job);
+
+  for (i = job.num_stages - 1; i >= 0; i--) {
+    job.stages[i]->fused = job.frames[i];
+    job.stages[i]->release(job.stages[i]->data);
+  }
+}
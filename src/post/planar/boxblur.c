@@ -29,6 +29,7 @@
 #include <xine/post.h>
 #include <xine/xineutils.h>
 #include <pthread.h>
+#include "planar.h"
 
 /* plugin class initialization function */
 void *boxblur_init_plugin(xine_t *xine, void *);
@@ -70,6 +71,8 @@ struct post_plugin_boxblur_s {
   boxblur_parameters_t params;
   xine_post_in_t       params_input;
 
+  xine_worker_pool_t  *pool;
+
   pthread_mutex_t      lock;
 };
 
@@ -175,6 +178,8 @@ static post_plugin_t *boxblur_open_plugin(post_class_t *class_gen, int inputs,
 
   pthread_mutex_init(&this->lock, NULL);
 
+  this->pool = planar_pool_ref();
+
   port = _x_post_intercept_video_port(&this->post, video_target[0], &input, &output);
   port->intercept_frame = boxblur_intercept_frame;
   port->new_frame->draw = boxblur_draw;
@@ -200,6 +205,7 @@ static void boxblur_dispose(post_plugin_t *this_gen)
   post_plugin_boxblur_t *this = (post_plugin_boxblur_t *)this_gen;
 
   if (_x_post_dispose(this_gen)) {
+    planar_pool_unref();
     pthread_mutex_destroy(&this->lock);
     free(this);
   }
@@ -285,6 +291,35 @@ static void vBlur(uint8_t *dst, uint8_t *src, int w, int h, int dstStride, int s
 	}
 }
 
+typedef struct {
+  vo_frame_t *src;
+  vo_frame_t *dst;
+  int         width[3];
+  int         height[3];
+  int         radius[3];
+  int         power[3];
+} boxblur_band_t;
+
+/* horizontal pass, bands of rows */
+static void boxblur_band_h(void *data, int plane, int start, int end, int band)
+{
+  boxblur_band_t *b = (boxblur_band_t *)data;
+
+  hBlur(b->dst->base[plane] + start * b->dst->pitches[plane],
+        b->src->base[plane] + start * b->src->pitches[plane],
+        b->width[plane], end - start,
+        b->dst->pitches[plane], b->src->pitches[plane], b->radius[plane], b->power[plane]);
+}
+
+/* vertical pass in place, bands of columns */
+static void boxblur_band_v(void *data, int plane, int start, int end, int band)
+{
+  boxblur_band_t *b = (boxblur_band_t *)data;
+
+  vBlur(b->dst->base[plane] + start, b->dst->base[plane] + start,
+        end - start, b->height[plane],
+        b->dst->pitches[plane], b->dst->pitches[plane], b->radius[plane], b->power[plane]);
+}
 
 static int boxblur_draw(vo_frame_t *frame, xine_stream_t *stream)
 {
@@ -292,6 +327,7 @@ static int boxblur_draw(vo_frame_t *frame, xine_stream_t *stream)
   post_plugin_boxblur_t *this = (post_plugin_boxblur_t *)port->post;
   vo_frame_t *out_frame;
   vo_frame_t *yv12_frame;
+  boxblur_band_t band;
   int chroma_radius, chroma_power;
   int cw, ch;
   int skip;
@@ -333,19 +369,19 @@ static int boxblur_draw(vo_frame_t *frame, xine_stream_t *stream)
     cw = yv12_frame->width/2;
     ch = yv12_frame->height/2;
 
-    hBlur(out_frame->base[0], yv12_frame->base[0], yv12_frame->width, yv12_frame->height,
-          out_frame->pitches[0], yv12_frame->pitches[0], this->params.luma_radius, this->params.luma_power);
-    hBlur(out_frame->base[1], yv12_frame->base[1], cw,ch,
-          out_frame->pitches[1], yv12_frame->pitches[1], chroma_radius, chroma_power);
-    hBlur(out_frame->base[2], yv12_frame->base[2], cw,ch,
-          out_frame->pitches[2], yv12_frame->pitches[2], chroma_radius, chroma_power);
-
-    vBlur(out_frame->base[0], out_frame->base[0], yv12_frame->width, yv12_frame->height,
-          out_frame->pitches[0], out_frame->pitches[0], this->params.luma_radius, this->params.luma_power);
-    vBlur(out_frame->base[1], out_frame->base[1], cw,ch,
-          out_frame->pitches[1], out_frame->pitches[1], chroma_radius, chroma_power);
-    vBlur(out_frame->base[2], out_frame->base[2], cw,ch,
-          out_frame->pitches[2], out_frame->pitches[2], chroma_radius, chroma_power);
+    band.src       = yv12_frame;
+    band.dst       = out_frame;
+    band.width[0]  = yv12_frame->width;
+    band.height[0] = yv12_frame->height;
+    band.radius[0] = this->params.luma_radius;
+    band.power[0]  = this->params.luma_power;
+    band.width[1]  = band.width[2]  = cw;
+    band.height[1] = band.height[2] = ch;
+    band.radius[1] = band.radius[2] = chroma_radius;
+    band.power[1]  = band.power[2]  = chroma_power;
+
+    planar_run_bands(this->pool, 3, band.height, boxblur_band_h, &band);
+    planar_run_bands(this->pool, 3, band.width, boxblur_band_v, &band);
 
     pthread_mutex_unlock (&this->lock);
 
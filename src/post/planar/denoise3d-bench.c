@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2010 the xine-project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * denoise3d-bench: checks and times the denoise3d lowpass.
+ *
+ * The lowpass tables are checked against the original two multiply and
+ * divide lowpass for all pixel pairs at a range of strengths.  Then the
+ * original filter and the plugin's single pass and banded versions
+ * denoise a sequence of synthetic YV12 pictures at 1280x720 and
+ * 1920x1080.  Reported are frames per second and whether the output
+ * differs from the original (it must not).
+ * Build with "make denoise3d-bench" in this directory.
+ */
+
+/* the filters are static */
+#include "denoise3d.c"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+/* the filter as it was before the lowpass tables were folded */
+
+#define LowPassOrig(Prev, Curr, Coef) (((Prev)*Coef[Prev - Curr] + (Curr)*(65536-(Coef[Prev - Curr]))) / 65536)
+
+static void PrecalcCoefsOrig(int *Ct, double Dist25)
+{
+    int i;
+    double Gamma, Simil;
+
+    Gamma = log(0.25) / log(1.0 - Dist25/255.0);
+
+    for (i = -255; i <= 255; i++)
+    {
+        Simil = 1.0 - ABS(i) / 255.0;
+        Ct[256+i] = pow(Simil, Gamma) * 65536;
+    }
+}
+
+static void deNoiseOrig(unsigned char *Frame,
+                        unsigned char *FramePrev,
+                        unsigned char *FrameDest,
+                        unsigned char *LineAnt,
+                        int W, int H, int sStride, int pStride, int dStride,
+                        int *Horizontal, int *Vertical, int *Temporal)
+{
+    int X, Y;
+    int sLineOffs = 0, pLineOffs = 0, dLineOffs = 0;
+    unsigned char PixelAnt;
+
+    LineAnt[0] = PixelAnt = Frame[0];
+    FrameDest[0] = LowPassOrig(FramePrev[0], LineAnt[0], Temporal);
+
+    for (X = 1; X < W; X++)
+    {
+        PixelAnt = LowPassOrig(PixelAnt, Frame[X], Horizontal);
+        LineAnt[X] = PixelAnt;
+        FrameDest[X] = LowPassOrig(FramePrev[X], LineAnt[X], Temporal);
+    }
+
+    for (Y = 1; Y < H; Y++)
+    {
+        sLineOffs += sStride, pLineOffs += pStride, dLineOffs += dStride;
+        PixelAnt = Frame[sLineOffs];
+        LineAnt[0] = LowPassOrig(LineAnt[0], PixelAnt, Vertical);
+        FrameDest[dLineOffs] = LowPassOrig(FramePrev[pLineOffs], LineAnt[0], Temporal);
+
+        for (X = 1; X < W; X++)
+        {
+            PixelAnt = LowPassOrig(PixelAnt, Frame[sLineOffs+X], Horizontal);
+            LineAnt[X] = LowPassOrig(LineAnt[X], PixelAnt, Vertical);
+            FrameDest[dLineOffs+X] = LowPassOrig(FramePrev[pLineOffs+X], LineAnt[X], Temporal);
+        }
+    }
+}
+
+/* what one frame is denoised with */
+typedef struct {
+  post_plugin_denoise3d_t  this;
+  int                      coefs_orig[4][512];
+  xine_worker_pool_t      *pool;
+} bench_filter_t;
+
+typedef void (*bench_func_t)(bench_filter_t *f, vo_frame_t *dst, vo_frame_t *src, vo_frame_t *prev);
+
+static void denoise_orig (bench_filter_t *f, vo_frame_t *dst, vo_frame_t *src, vo_frame_t *prev)
+{
+  int plane;
+
+  for (plane = 0; plane < 3; plane++) {
+    int *spatial = f->coefs_orig[plane ? 2 : 0] + 256;
+
+    deNoiseOrig (src->base[plane], prev->base[plane], dst->base[plane], f->this.Line[0],
+                 plane ? src->width / 2 : src->width, plane ? src->height / 2 : src->height,
+                 src->pitches[plane], prev->pitches[plane], dst->pitches[plane],
+                 spatial, spatial, f->coefs_orig[plane ? 3 : 1] + 256);
+  }
+}
+
+static void denoise_single (bench_filter_t *f, vo_frame_t *dst, vo_frame_t *src, vo_frame_t *prev)
+{
+  int plane;
+
+  for (plane = 0; plane < 3; plane++) {
+    int *spatial = f->this.Coefs[plane ? 2 : 0] + 256;
+
+    deNoise (src->base[plane], prev->base[plane], dst->base[plane], f->this.Line[0],
+             plane ? src->width / 2 : src->width, plane ? src->height / 2 : src->height,
+             src->pitches[plane], prev->pitches[plane], dst->pitches[plane],
+             spatial, spatial, f->this.Coefs[plane ? 3 : 1] + 256);
+  }
+}
+
+/* the same as denoise3d_draw () with more than one band */
+static void denoise_bands (bench_filter_t *f, vo_frame_t *dst, vo_frame_t *src, vo_frame_t *prev)
+{
+  denoise3d_band_t band;
+
+  band.this      = &f->this;
+  band.src       = src;
+  band.prev      = prev;
+  band.dst       = dst;
+  band.width[0]  = src->width;
+  band.height[0] = src->height;
+  band.width[1]  = band.width[2]  = src->width / 2;
+  band.height[1] = band.height[2] = src->height / 2;
+
+  planar_run_bands (f->pool, 3, band.height, denoise3d_band_rows, &band);
+  planar_run_bands (f->pool, 3, band.width, denoise3d_band_columns, &band);
+}
+
+typedef struct {
+  const char   *name;
+  bench_func_t  func;
+} bench_impl_t;
+
+static const bench_impl_t impls[] = {
+  { "original", denoise_orig },
+  { "single",   denoise_single },
+  { "bands",    denoise_bands },
+};
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* returns 1 if the folded lowpass equals the original for all pixel pairs */
+static int check_lowpass (double strength)
+{
+  int orig[512], coef[512];
+  int *o = orig + 256, *c = coef + 256;
+  int prev, curr;
+
+  PrecalcCoefsOrig (orig, strength);
+  PrecalcCoefs (coef, strength);
+  for (prev = 0; prev < 256; prev++)
+    for (curr = 0; curr < 256; curr++)
+      if (LowPassOrig (prev, curr, o) != LowPass (prev, curr, c))
+        return 0;
+  return 1;
+}
+
+static vo_frame_t *frame_new (int width, int height)
+{
+  vo_frame_t *frame = calloc (1, sizeof (*frame));
+  int plane;
+
+  if (!frame)
+    return NULL;
+  frame->width  = width;
+  frame->height = height;
+  for (plane = 0; plane < 3; plane++) {
+    frame->pitches[plane] = plane ? width / 2 : width;
+    frame->base[plane] = malloc (frame->pitches[plane] * (plane ? height / 2 : height));
+    if (!frame->base[plane])
+      return NULL;
+  }
+  return frame;
+}
+
+static void frame_free (vo_frame_t *frame)
+{
+  int plane;
+
+  for (plane = 0; plane < 3; plane++)
+    free (frame->base[plane]);
+  free (frame);
+}
+
+/* noisy blocks moving one pixel per frame, so there is something to denoise */
+static void frame_fill (vo_frame_t *frame, int n)
+{
+  unsigned int seed = n + 1;
+  int plane, x, y;
+
+  for (plane = 0; plane < 3; plane++) {
+    int w = plane ? frame->width / 2 : frame->width;
+    int h = plane ? frame->height / 2 : frame->height;
+
+    for (y = 0; y < h; y++)
+      for (x = 0; x < w; x++) {
+        seed = seed * 1103515245 + 12345;
+        frame->base[plane][y * frame->pitches[plane] + x] =
+          (((x + n) / 16 + y / 16) & 1 ? 170 : 70) + ((seed >> 16) & 31) - (plane ? 40 : 0);
+      }
+  }
+}
+
+static int frame_same (vo_frame_t *a, vo_frame_t *b)
+{
+  int plane;
+
+  for (plane = 0; plane < 3; plane++)
+    if (memcmp (a->base[plane], b->base[plane],
+                a->pitches[plane] * (plane ? a->height / 2 : a->height)))
+      return 0;
+  return 1;
+}
+
+#define NUM_PICS 4
+
+/* returns 0 if an implementation differs from the original */
+static int bench_size (bench_filter_t *f, int width, int height, int frames)
+{
+  vo_frame_t *pics[NUM_PICS], *ref[NUM_PICS], *out;
+  int i, n, ret = 1;
+
+  for (n = 0; n < NUM_PICS; n++) {
+    pics[n] = frame_new (width, height);
+    ref[n]  = frame_new (width, height);
+    if (!pics[n] || !ref[n])
+      return 0;
+    frame_fill (pics[n], n);
+  }
+  out = frame_new (width, height);
+  if (!out)
+    return 0;
+
+  /* each picture is denoised against the one before, as in the plugin */
+  for (n = 0; n < NUM_PICS; n++)
+    denoise_orig (f, ref[n], pics[n], pics[(n + NUM_PICS - 1) % NUM_PICS]);
+
+  printf ("  %dx%d:\n", width, height);
+  for (i = 0; i < (int)(sizeof (impls) / sizeof (impls[0])); i++) {
+    double t0, fps;
+    int same = 1;
+
+    for (n = 0; n < NUM_PICS; n++) {
+      impls[i].func (f, out, pics[n], pics[(n + NUM_PICS - 1) % NUM_PICS]);
+      same &= frame_same (out, ref[n]);
+    }
+
+    t0 = now ();
+    for (n = 0; n < frames; n++)
+      impls[i].func (f, out, pics[n % NUM_PICS], pics[(n + NUM_PICS - 1) % NUM_PICS]);
+    fps = frames / (now () - t0);
+
+    if (!same)
+      ret = 0;
+    printf ("    %-8s %8.1f fps  %s\n", impls[i].name, fps, same ? "same" : "DIFFERENT");
+  }
+
+  for (n = 0; n < NUM_PICS; n++) {
+    frame_free (pics[n]);
+    frame_free (ref[n]);
+  }
+  frame_free (out);
+  return ret;
+}
+
+int main (int argc, char *argv[])
+{
+  static const int sizes[][2] = { { 1280, 720 }, { 1920, 1080 } };
+  int width = 0, height = 0, frames = 100;
+  double luma = PARAM1_DEFAULT, chroma = PARAM2_DEFAULT, time = PARAM3_DEFAULT;
+  bench_filter_t f;
+  double strength;
+  xine_t *xine;
+  int opt, i, same, ret = 0;
+
+  while ((opt = getopt (argc, argv, "w:h:n:l:c:t:")) != -1) {
+    switch (opt) {
+    case 'w':
+      width = atoi (optarg) & ~1;
+      break;
+    case 'h':
+      height = atoi (optarg) & ~1;
+      break;
+    case 'n':
+      frames = atoi (optarg);
+      break;
+    case 'l':
+      luma = atof (optarg);
+      break;
+    case 'c':
+      chroma = atof (optarg);
+      break;
+    case 't':
+      time = atof (optarg);
+      break;
+    default:
+      fprintf (stderr, "\
+usage: %s [options]\n\
+options:\n\
+  -w WIDTH	frame width (default: 1280 and 1920)\n\
+  -h HEIGHT	frame height (default: 720 and 1080)\n\
+  -n FRAMES	frames per run (default: 100)\n\
+  -l LUMA	spatial luma strength (default: 4.0)\n\
+  -c CHROMA	spatial chroma strength (default: 3.0)\n\
+  -t TIME	temporal strength (default: 6.0)\n", argv[0]);
+      return 1;
+    }
+  }
+  if ((width || height) && (width < 32 || height < 32 || width > MAX_LINE_WIDTH)) {
+    fputs ("denoise3d-bench: invalid size\n", stderr);
+    return 1;
+  }
+  if (frames < 1 || luma <= 0 || chroma <= 0 || time <= 0 ||
+      luma > 10 || chroma > 10 || time > 10) {
+    fputs ("denoise3d-bench: invalid option\n", stderr);
+    return 1;
+  }
+
+  /* for xine_fast_memcpy () */
+  xine = xine_new ();
+  xine_set_flags (xine, XINE_FLAG_NO_WRITE_CACHE);
+  xine_init (xine);
+
+  same = 1;
+  for (strength = 0.25; strength <= 10.0; strength += 0.25)
+    same &= check_lowpass (strength);
+  if (!same)
+    ret = 1;
+  printf ("denoise3d-bench: lowpass tables, strength 0.25 to 10: %s\n",
+          same ? "same" : "DIFFERENT");
+
+  /* as set_parameters () does it */
+  memset (&f, 0, sizeof (f));
+  pthread_mutex_init (&f.this.lock, NULL);
+  f.this.params.luma   = luma;
+  f.this.params.chroma = chroma;
+  f.this.params.time   = time;
+  set_parameters (&f.this.post.xine_post, &f.this.params);
+  PrecalcCoefsOrig (f.coefs_orig[0], luma);
+  PrecalcCoefsOrig (f.coefs_orig[1], time);
+  PrecalcCoefsOrig (f.coefs_orig[2], chroma);
+  PrecalcCoefsOrig (f.coefs_orig[3], time * chroma / luma);
+  f.pool = planar_pool_ref ();
+
+  printf ("denoise3d-bench: YV12, %d frames per run, luma %.2f chroma %.2f time %.2f, %d bands\n",
+          frames, luma, chroma, time, planar_max_bands (f.pool));
+
+  if (width) {
+    if (!bench_size (&f, width, height, frames))
+      ret = 1;
+  } else {
+    for (i = 0; i < (int)(sizeof (sizes) / sizeof (sizes[0])); i++)
+      if (!bench_size (&f, sizes[i][0], sizes[i][1], frames))
+        ret = 1;
+  }
+
+  planar_pool_unref ();
+  pthread_mutex_destroy (&f.this.lock);
+  xine_exit (xine);
+  return ret;
+}
@@ -30,6 +30,7 @@
 #include <xine/xineutils.h>
 #include <math.h>
 #include <pthread.h>
+#include "planar.h"
 
 #define PARAM1_DEFAULT 4.0
 #define PARAM2_DEFAULT 3.0
@@ -76,25 +77,34 @@ struct post_plugin_denoise3d_s {
   xine_post_in_t         params_input;
 
   int                    Coefs[4][512];
-  unsigned char          Line[MAX_LINE_WIDTH];
+  unsigned char          Line[3][MAX_LINE_WIDTH];
   vo_frame_t            *prev_frame;
 
+  xine_worker_pool_t    *pool;
+
   pthread_mutex_t        lock;
 };
 
 #define ABS(A) ( (A) > 0 ? (A) : -(A) )
 
+/*
+ * The lowpass of Prev and Curr with weight k = 65536 * Simil^Gamma for
+ * Prev - Curr is (Prev*k + Curr*(65536-k)) / 65536.  As that is never
+ * negative, it equals Curr + floor((Prev-Curr)*k / 65536), so the tables
+ * hold that last term: one lookup and add per pixel, same result.
+ */
 static void PrecalcCoefs(int *Ct, double Dist25)
 {
-    int i;
+    int i, k;
     double Gamma, Simil;
 
     Gamma = log(0.25) / log(1.0 - Dist25/255.0);
 
-    for (i = -256; i <= 255; i++)
+    for (i = -255; i <= 255; i++)
     {
         Simil = 1.0 - ABS(i) / 255.0;
-        Ct[256+i] = pow(Simil, Gamma) * 65536;
+        k = pow(Simil, Gamma) * 65536;
+        Ct[256+i] = (i * k) >> 16;
     }
 }
 
@@ -215,6 +225,8 @@ static post_plugin_t *denoise3d_open_plugin(post_class_t *class_gen, int inputs,
 
   pthread_mutex_init(&this->lock, NULL);
 
+  this->pool = planar_pool_ref();
+
   port = _x_post_intercept_video_port(&this->post, video_target[0], &input, &output);
   port->new_port.close  = denoise3d_close;
   port->intercept_frame = denoise3d_intercept_frame;
@@ -243,6 +255,7 @@ static void denoise3d_dispose(post_plugin_t *this_gen)
   post_plugin_denoise3d_t *this = (post_plugin_denoise3d_t *)this_gen;
 
   if (_x_post_dispose(this_gen)) {
+    planar_pool_unref();
     pthread_mutex_destroy(&this->lock);
     free(this);
   }
@@ -271,7 +284,7 @@ static int denoise3d_intercept_frame(post_video_port_t *port, vo_frame_t *frame)
 }
 
 
-#define LowPass(Prev, Curr, Coef) (((Prev)*Coef[Prev - Curr] + (Curr)*(65536-(Coef[Prev - Curr]))) / 65536)
+#define LowPass(Prev, Curr, Coef) ((Curr) + Coef[(Prev) - (Curr)])
 
 static void deNoise(unsigned char *Frame,
                     unsigned char *FramePrev,
@@ -315,6 +328,89 @@ static void deNoise(unsigned char *Frame,
     }
 }
 
+/*
+ * deNoise split in two passes that can run in bands: the horizontal
+ * lowpass only depends on the source line, so it is done on rows first,
+ * writing to FrameDest.  The vertical and temporal lowpasses then run
+ * on columns, in place.  The result is the same as deNoise().
+ */
+static void deNoiseRows(unsigned char *Frame,
+                        unsigned char *FrameDest,
+                        int W, int H, int sStride, int dStride,
+                        int *Horizontal)
+{
+    int X, Y;
+    unsigned char PixelAnt;
+
+    for (Y = 0; Y < H; Y++, Frame += sStride, FrameDest += dStride)
+    {
+        FrameDest[0] = PixelAnt = Frame[0];
+        for (X = 1; X < W; X++)
+        {
+            PixelAnt = LowPass(PixelAnt, Frame[X], Horizontal);
+            FrameDest[X] = PixelAnt;
+        }
+    }
+}
+
+static void deNoiseColumns(unsigned char *FramePrev,
+                           unsigned char *FrameDest,
+                           unsigned char *LineAnt,
+                           int W, int H, int pStride, int dStride,
+                           int *Vertical, int *Temporal)
+{
+    int X, Y;
+
+    /* First line has no top neighbour */
+    for (X = 0; X < W; X++)
+    {
+        LineAnt[X] = FrameDest[X];
+        FrameDest[X] = LowPass(FramePrev[X], LineAnt[X], Temporal);
+    }
+
+    for (Y = 1; Y < H; Y++)
+    {
+        FramePrev += pStride, FrameDest += dStride;
+        for (X = 0; X < W; X++)
+        {
+            LineAnt[X] = LowPass(LineAnt[X], FrameDest[X], Vertical);
+            FrameDest[X] = LowPass(FramePrev[X], LineAnt[X], Temporal);
+        }
+    }
+}
+
+typedef struct {
+  post_plugin_denoise3d_t *this;
+  vo_frame_t              *src;
+  vo_frame_t              *prev;
+  vo_frame_t              *dst;
+  int                      width[3];
+  int                      height[3];
+} denoise3d_band_t;
+
+static void denoise3d_band_rows(void *data, int plane, int start, int end, int band)
+{
+  denoise3d_band_t *b = (denoise3d_band_t *)data;
+
+  deNoiseRows(b->src->base[plane] + start * b->src->pitches[plane],
+              b->dst->base[plane] + start * b->dst->pitches[plane],
+              b->width[plane], end - start,
+              b->src->pitches[plane], b->dst->pitches[plane],
+              b->this->Coefs[plane ? 2 : 0] + 256);
+}
+
+static void denoise3d_band_columns(void *data, int plane, int start, int end, int band)
+{
+  denoise3d_band_t *b = (denoise3d_band_t *)data;
+
+  deNoiseColumns(b->prev->base[plane] + start,
+                 b->dst->base[plane] + start,
+                 b->this->Line[plane] + start,
+                 end - start, b->height[plane],
+                 b->prev->pitches[plane], b->dst->pitches[plane],
+                 b->this->Coefs[plane ? 2 : 0] + 256,
+                 b->this->Coefs[plane ? 3 : 1] + 256);
+}
 
 static int denoise3d_draw(vo_frame_t *frame, xine_stream_t *stream)
 {
@@ -323,6 +419,7 @@ static int denoise3d_draw(vo_frame_t *frame, xine_stream_t *stream)
   vo_frame_t *out_frame;
   vo_frame_t *prev_frame;
   vo_frame_t *yv12_frame;
+  denoise3d_band_t band;
   int cw, ch;
   int skip;
 
@@ -360,24 +457,38 @@ static int denoise3d_draw(vo_frame_t *frame, xine_stream_t *stream)
     ch = yv12_frame->height/2;
     prev_frame = (this->prev_frame) ? this->prev_frame : yv12_frame;
 
-    deNoise(yv12_frame->base[0], prev_frame->base[0], out_frame->base[0],
-            this->Line, yv12_frame->width, yv12_frame->height,
-            yv12_frame->pitches[0], prev_frame->pitches[0], out_frame->pitches[0],
-            this->Coefs[0] + 256,
-            this->Coefs[0] + 256,
-            this->Coefs[1] + 256);
-    deNoise(yv12_frame->base[1], prev_frame->base[1], out_frame->base[1],
-            this->Line, cw, ch,
-            yv12_frame->pitches[1], prev_frame->pitches[1], out_frame->pitches[1],
-            this->Coefs[2] + 256,
-            this->Coefs[2] + 256,
-            this->Coefs[3] + 256);
-    deNoise(yv12_frame->base[2], prev_frame->base[2], out_frame->base[2],
-            this->Line, cw, ch,
-            yv12_frame->pitches[2], prev_frame->pitches[2], out_frame->pitches[2],
-            this->Coefs[2] + 256,
-            this->Coefs[2] + 256,
-            this->Coefs[3] + 256);
+    if( planar_max_bands(this->pool) > 1 ) {
+      band.this      = this;
+      band.src       = yv12_frame;
+      band.prev      = prev_frame;
+      band.dst       = out_frame;
+      band.width[0]  = yv12_frame->width;
+      band.height[0] = yv12_frame->height;
+      band.width[1]  = band.width[2]  = cw;
+      band.height[1] = band.height[2] = ch;
+
+      planar_run_bands(this->pool, 3, band.height, denoise3d_band_rows, &band);
+      planar_run_bands(this->pool, 3, band.width, denoise3d_band_columns, &band);
+    } else {
+      deNoise(yv12_frame->base[0], prev_frame->base[0], out_frame->base[0],
+              this->Line[0], yv12_frame->width, yv12_frame->height,
+              yv12_frame->pitches[0], prev_frame->pitches[0], out_frame->pitches[0],
+              this->Coefs[0] + 256,
+              this->Coefs[0] + 256,
+              this->Coefs[1] + 256);
+      deNoise(yv12_frame->base[1], prev_frame->base[1], out_frame->base[1],
+              this->Line[0], cw, ch,
+              yv12_frame->pitches[1], prev_frame->pitches[1], out_frame->pitches[1],
+              this->Coefs[2] + 256,
+              this->Coefs[2] + 256,
+              this->Coefs[3] + 256);
+      deNoise(yv12_frame->base[2], prev_frame->base[2], out_frame->base[2],
+              this->Line[0], cw, ch,
+              yv12_frame->pitches[2], prev_frame->pitches[2], out_frame->pitches[2],
+              this->Coefs[2] + 256,
+              this->Coefs[2] + 256,
+              this->Coefs[3] + 256);
+    }
 
     pthread_mutex_unlock (&this->lock);
 
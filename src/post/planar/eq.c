@@ -29,6 +29,7 @@
 #include <xine/post.h>
 #include <xine/xineutils.h>
 #include <pthread.h>
+#include "planar.h"
 
 
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
@@ -153,6 +154,9 @@ struct post_plugin_eq_s {
   eq_parameters_t    params;
   xine_post_in_t     params_input;
 
+  xine_worker_pool_t *pool;
+  planar_stage_t     stage;
+
   pthread_mutex_t    lock;
 };
 
@@ -226,6 +230,11 @@ static int            eq_intercept_frame(post_video_port_t *port, vo_frame_t *fr
 /* replaced vo_frame functions */
 static int            eq_draw(vo_frame_t *frame, xine_stream_t *stream);
 
+/* planar stage functions */
+static int            eq_stage_prepare(void *data);
+static void           eq_stage_band(void *data, vo_frame_t *frame, int plane, int start, int end);
+static void           eq_stage_release(void *data);
+
 
 void *eq_init_plugin(xine_t *xine, void *data)
 {
@@ -271,12 +280,20 @@ static post_plugin_t *eq_open_plugin(post_class_t *class_gen, int inputs,
 
   pthread_mutex_init (&this->lock, NULL);
 
+  this->pool = planar_pool_ref();
+
   port = _x_post_intercept_video_port(&this->post, video_target[0], &input, &output);
   port->new_port.get_property = eq_get_property;
   port->new_port.set_property = eq_set_property;
   port->intercept_frame       = eq_intercept_frame;
   port->new_frame->draw       = eq_draw;
 
+  this->stage.prepare = eq_stage_prepare;
+  this->stage.band    = eq_stage_band;
+  this->stage.release = eq_stage_release;
+  this->stage.data    = this;
+  planar_stage_register(&this->stage, port);
+
   input_api       = &this->params_input;
   input_api->name = "parameters";
   input_api->type = XINE_POST_DATA_PARAMETERS;
@@ -298,6 +315,7 @@ static void eq_dispose(post_plugin_t *this_gen)
   post_plugin_eq_t *this = (post_plugin_eq_t *)this_gen;
 
   if (_x_post_dispose(this_gen)) {
+    planar_pool_unref();
     pthread_mutex_destroy(&this->lock);
     free(this);
   }
@@ -339,15 +357,66 @@ static int eq_intercept_frame(post_video_port_t *port, vo_frame_t *frame)
 }
 
 
+typedef struct {
+  vo_frame_t *src;
+  vo_frame_t *dst;
+  int         brightness;
+  int         contrast;
+} eq_band_t;
+
+static void eq_band(void *data, int plane, int start, int end, int band)
+{
+  eq_band_t *b = (eq_band_t *)data;
+  uint8_t   *dst = b->dst->base[plane] + start * b->dst->pitches[plane];
+  uint8_t   *src = b->src->base[plane] + start * b->src->pitches[plane];
+
+  if (plane == 0)
+    process(dst, b->dst->pitches[0], src, b->src->pitches[0],
+            b->src->width, end - start, b->brightness, b->contrast);
+  else
+    xine_fast_memcpy(dst, src, b->src->pitches[plane] * (end - start));
+}
+
+/* the same, in place on the output of a planar plugin in front of us */
+static int eq_stage_prepare(void *data)
+{
+  post_plugin_eq_t *this = (post_plugin_eq_t *)data;
+
+  pthread_mutex_lock (&this->lock);
+  if (this->params.brightness != 0 || this->params.contrast != 0)
+    return 1;
+  pthread_mutex_unlock (&this->lock);
+  return 0;
+}
+
+static void eq_stage_band(void *data, vo_frame_t *frame, int plane, int start, int end)
+{
+  post_plugin_eq_t *this = (post_plugin_eq_t *)data;
+  uint8_t          *p = frame->base[0] + start * frame->pitches[0];
+
+  if (plane == 0)
+    process(p, frame->pitches[0], p, frame->pitches[0],
+            frame->width, end - start, this->params.brightness, this->params.contrast);
+}
+
+static void eq_stage_release(void *data)
+{
+  post_plugin_eq_t *this = (post_plugin_eq_t *)data;
+
+  pthread_mutex_unlock (&this->lock);
+}
+
 static int eq_draw(vo_frame_t *frame, xine_stream_t *stream)
 {
   post_video_port_t *port = (post_video_port_t *)frame->port;
   post_plugin_eq_t *this = (post_plugin_eq_t *)port->post;
   vo_frame_t *out_frame;
   vo_frame_t *yv12_frame;
+  eq_band_t band;
+  int lines[3];
   int skip;
 
-  if( !frame->bad_frame &&
+  if( !planar_stage_fused(&this->stage, frame) && !frame->bad_frame &&
       ((this->params.brightness != 0) || (this->params.contrast != 0)) ) {
 
     /* convert to YV12 if needed */
@@ -377,14 +446,14 @@ static int eq_draw(vo_frame_t *frame, xine_stream_t *stream)
 
     pthread_mutex_lock (&this->lock);
 
-    process(out_frame->base[0], out_frame->pitches[0],
-            yv12_frame->base[0], yv12_frame->pitches[0],
-            frame->width, frame->height,
-            this->params.brightness, this->params.contrast);
-    xine_fast_memcpy(out_frame->base[1],yv12_frame->base[1],
-                     yv12_frame->pitches[1] * frame->height/2);
-    xine_fast_memcpy(out_frame->base[2],yv12_frame->base[2],
-                     yv12_frame->pitches[2] * frame->height/2);
+    band.src        = yv12_frame;
+    band.dst        = out_frame;
+    band.brightness = this->params.brightness;
+    band.contrast   = this->params.contrast;
+
+    lines[0] = frame->height;
+    lines[1] = lines[2] = frame->height/2;
+    planar_run_bands_fused(this->pool, lines, eq_band, &band, out_frame);
 
     pthread_mutex_unlock (&this->lock);
 
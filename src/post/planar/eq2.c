@@ -34,6 +34,7 @@
 #include <xine/xineutils.h>
 #include <math.h>
 #include <pthread.h>
+#include "planar.h"
 
 
 /* Per channel parameters */
@@ -315,6 +316,9 @@ struct post_plugin_eq2_s {
 
   vf_eq2_t           eq2;
 
+  xine_worker_pool_t *pool;
+  planar_stage_t     stage;
+
   pthread_mutex_t    lock;
 };
 
@@ -407,6 +411,11 @@ static int            eq2_intercept_frame(post_video_port_t *port, vo_frame_t *f
 /* replaced vo_frame functions */
 static int            eq2_draw(vo_frame_t *frame, xine_stream_t *stream);
 
+/* planar stage functions */
+static int            eq2_stage_prepare(void *data);
+static void           eq2_stage_band(void *data, vo_frame_t *frame, int plane, int start, int end);
+static void           eq2_stage_release(void *data);
+
 
 void *eq2_init_plugin(xine_t *xine, void *data)
 {
@@ -453,12 +462,20 @@ static post_plugin_t *eq2_open_plugin(post_class_t *class_gen, int inputs,
 
   pthread_mutex_init(&this->lock, NULL);
 
+  this->pool = planar_pool_ref();
+
   port = _x_post_intercept_video_port(&this->post, video_target[0], &input, &output);
   port->new_port.get_property = eq2_get_property;
   port->new_port.set_property = eq2_set_property;
   port->intercept_frame       = eq2_intercept_frame;
   port->new_frame->draw       = eq2_draw;
 
+  this->stage.prepare = eq2_stage_prepare;
+  this->stage.band    = eq2_stage_band;
+  this->stage.release = eq2_stage_release;
+  this->stage.data    = this;
+  planar_stage_register(&this->stage, port);
+
   input_api       = &this->params_input;
   input_api->name = "parameters";
   input_api->type = XINE_POST_DATA_PARAMETERS;
@@ -482,6 +499,7 @@ static void eq2_dispose(post_plugin_t *this_gen)
   post_plugin_eq2_t *this = (post_plugin_eq2_t *)this_gen;
 
   if (_x_post_dispose(this_gen)) {
+    planar_pool_unref();
     pthread_mutex_destroy(&this->lock);
     free(this);
   }
@@ -529,6 +547,66 @@ static int eq2_intercept_frame(post_video_port_t *port, vo_frame_t *frame)
 }
 
 
+typedef struct {
+  vf_eq2_t   *eq2;
+  vo_frame_t *src;
+  vo_frame_t *dst;
+} eq2_band_t;
+
+static void eq2_band(void *data, int plane, int start, int end, int band)
+{
+  eq2_band_t    *b = (eq2_band_t *)data;
+  eq2_param_t   *par = &b->eq2->param[plane];
+  unsigned char *dst = b->dst->base[plane] + start * b->dst->pitches[plane];
+  unsigned char *src = b->src->base[plane] + start * b->src->pitches[plane];
+  int            width = (plane == 0) ? b->src->width : b->src->width/2;
+
+  if (par->adjust != NULL) {
+    par->adjust (par, dst, src, width, end - start,
+      b->dst->pitches[plane], b->src->pitches[plane]);
+  }
+  else {
+    xine_fast_memcpy(dst, src, b->src->pitches[plane] * (end - start));
+  }
+}
+
+/* the same, in place on the output of a planar plugin in front of us */
+static int eq2_stage_prepare(void *data)
+{
+  post_plugin_eq2_t *this = (post_plugin_eq2_t *)data;
+  vf_eq2_t          *eq2 = &this->eq2;
+  int                i;
+
+  pthread_mutex_lock (&this->lock);
+  if (!eq2->param[0].adjust && !eq2->param[1].adjust && !eq2->param[2].adjust) {
+    pthread_mutex_unlock (&this->lock);
+    return 0;
+  }
+  for (i = 0; i < 3; i++) {
+    if (eq2->param[i].adjust == &apply_lut && !eq2->param[i].lut_clean)
+      create_lut (&eq2->param[i]);
+  }
+  return 1;
+}
+
+static void eq2_stage_band(void *data, vo_frame_t *frame, int plane, int start, int end)
+{
+  post_plugin_eq2_t *this = (post_plugin_eq2_t *)data;
+  eq2_param_t       *par = &this->eq2.param[plane];
+  unsigned char     *p = frame->base[plane] + start * frame->pitches[plane];
+  int                width = (plane == 0) ? frame->width : frame->width/2;
+
+  if (par->adjust != NULL)
+    par->adjust (par, p, p, width, end - start, frame->pitches[plane], frame->pitches[plane]);
+}
+
+static void eq2_stage_release(void *data)
+{
+  post_plugin_eq2_t *this = (post_plugin_eq2_t *)data;
+
+  pthread_mutex_unlock (&this->lock);
+}
+
 static int eq2_draw(vo_frame_t *frame, xine_stream_t *stream)
 {
   post_video_port_t *port = (post_video_port_t *)frame->port;
@@ -536,10 +614,12 @@ static int eq2_draw(vo_frame_t *frame, xine_stream_t *stream)
   vo_frame_t *out_frame;
   vo_frame_t *yv12_frame;
   vf_eq2_t   *eq2 = &this->eq2;
+  eq2_band_t band;
+  int lines[3];
   int skip;
   int i;
 
-  if( !frame->bad_frame &&
+  if( !planar_stage_fused(&this->stage, frame) && !frame->bad_frame &&
       (eq2->param[0].adjust || eq2->param[1].adjust || eq2->param[2].adjust) ) {
 
     /* convert to YV12 if needed */
@@ -568,20 +648,20 @@ static int eq2_draw(vo_frame_t *frame, xine_stream_t *stream)
 
     pthread_mutex_lock (&this->lock);
 
+    /* build the tables before the bands start using them */
     for (i = 0; i < 3; i++) {
-      int height, width;
-      height = (i==0) ? frame->height : frame->height/2;
-      width = (i==0) ? frame->width : frame->width/2;
-      if (eq2->param[i].adjust != NULL) {
-        eq2->param[i].adjust (&eq2->param[i], out_frame->base[i], yv12_frame->base[i],
-          width, height, out_frame->pitches[i], yv12_frame->pitches[i]);
-      }
-      else {
-        xine_fast_memcpy(out_frame->base[i],yv12_frame->base[i],
-                         yv12_frame->pitches[i] * height);
-      }
+      if (eq2->param[i].adjust == &apply_lut && !eq2->param[i].lut_clean)
+        create_lut (&eq2->param[i]);
     }
 
+    band.eq2 = eq2;
+    band.src = yv12_frame;
+    band.dst = out_frame;
+
+    lines[0] = frame->height;
+    lines[1] = lines[2] = frame->height/2;
+    planar_run_bands_fused(this->pool, lines, eq2_band, &band, out_frame);
+
     pthread_mutex_unlock (&this->lock);
 
     skip = out_frame->draw(out_frame, stream);
@@ -30,6 +30,7 @@
 #include <xine/xineutils.h>
 #include <math.h>
 #include <pthread.h>
+#include "planar.h"
 
 #ifdef HAVE_FFMPEG_AVUTIL_H
 #  include <mem.h>
@@ -66,6 +67,7 @@ typedef struct noise_param_t {
         shiftptr;
     int8_t *noise,
            *prev_shift[MAX_RES][3];
+    int     shift[MAX_RES];
 } noise_param_t;
 
 static int nonTempRandShift[MAX_RES]= {-1};
@@ -269,13 +271,49 @@ static inline void lineNoiseAvg_MMX(uint8_t *dst, uint8_t *src, int len, int8_t
 
 /***************************************************************************/
 
-static void noise(uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height, noise_param_t *fp)
+typedef struct {
+    uint8_t       *dst, *src;
+    int            dstStride, srcStride;
+    int            width;
+    noise_param_t *fp;
+} noise_band_t;
+
+static void noise_band(void *data, int plane, int start, int end, int band)
+{
+    noise_band_t  *b = (noise_band_t *)data;
+    noise_param_t *fp = b->fp;
+    uint8_t       *dst = b->dst + start * b->dstStride;
+    uint8_t       *src = b->src + start * b->srcStride;
+    int y;
+
+    for(y=start; y<end; y++)
+    {
+        if (fp->averaged) {
+            lineNoiseAvg(dst, src, b->width, fp->prev_shift[y]);
+            fp->prev_shift[y][fp->shiftptr] = fp->noise + fp->shift[y];
+        } else {
+            lineNoise(dst, src, fp->noise, b->width, fp->shift[y]);
+        }
+        dst+= b->dstStride;
+        src+= b->srcStride;
+    }
+
+#ifdef ARCH_X86
+    if (xine_mm_accel() & MM_ACCEL_X86_MMX)
+        asm volatile ("emms\n\t");
+    if (xine_mm_accel() & MM_ACCEL_X86_MMXEXT)
+        asm volatile ("sfence\n\t");
+#endif
+}
+
+static void noise(uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height, noise_param_t *fp,
+                  xine_worker_pool_t *pool)
 {
-    int8_t *noise= fp->noise;
+    noise_band_t band;
     int y;
     int shift=0;
 
-    if(!noise)
+    if(!fp->noise)
     {
         if(src==dst) return;
 
@@ -292,21 +330,24 @@ static void noise(uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int
         return;
     }
 
+    /* pick the shifts in line order, so the bands can run in any order */
     for(y=0; y<height; y++)
     {
         if(fp->temporal)    shift=  rand()&(MAX_SHIFT  -1);
         else                shift= nonTempRandShift[y];
 
         if(fp->quality==0) shift&= ~7;
-        if (fp->averaged) {
-            lineNoiseAvg(dst, src, width, fp->prev_shift[y]);
-            fp->prev_shift[y][fp->shiftptr] = noise + shift;
-        } else {
-            lineNoise(dst, src, noise, width, shift);
-        }
-        dst+= dstStride;
-        src+= srcStride;
+        fp->shift[y] = shift;
     }
+
+    band.dst       = dst;
+    band.src       = src;
+    band.dstStride = dstStride;
+    band.srcStride = srcStride;
+    band.width     = width;
+    band.fp        = fp;
+    planar_run_bands(pool, 1, &height, noise_band, &band);
+
     fp->shiftptr++;
     if (fp->shiftptr == 3) fp->shiftptr = 0;
 }
@@ -354,6 +395,8 @@ struct post_plugin_noise_s {
   noise_param_t params[2]; // luma and chroma
   xine_post_in_t     params_input;
 
+  xine_worker_pool_t *pool;
+
   pthread_mutex_t    lock;
 };
 
@@ -498,6 +541,8 @@ static post_plugin_t *noise_open_plugin(post_class_t *class_gen, int inputs,
 
     pthread_mutex_init(&this->lock, NULL);
 
+    this->pool = planar_pool_ref();
+
     port = _x_post_intercept_video_port(&this->post, video_target[0], &input, &output);
     port->intercept_frame       = noise_intercept_frame;
     port->new_frame->draw       = noise_draw;
@@ -525,6 +570,7 @@ static void noise_dispose(post_plugin_t *this_gen)
     post_plugin_noise_t *this = (post_plugin_noise_t *)this_gen;
 
     if (_x_post_dispose(this_gen)) {
+        planar_pool_unref();
         pthread_mutex_destroy(&this->lock);
 	av_free(this->params[0].noise);
 	av_free(this->params[1].noise);
@@ -565,27 +611,20 @@ static int noise_draw(vo_frame_t *frame, xine_stream_t *stream)
     if (frame->format == XINE_IMGFMT_YV12) {
         noise(out_frame->base[0], frame->base[0],
               out_frame->pitches[0], frame->pitches[0],
-              frame->width, frame->height, &this->params[0]);
+              frame->width, frame->height, &this->params[0], this->pool);
         noise(out_frame->base[1], frame->base[1],
               out_frame->pitches[1], frame->pitches[1],
-              frame->width/2, frame->height/2, &this->params[1]);
+              frame->width/2, frame->height/2, &this->params[1], this->pool);
         noise(out_frame->base[2], frame->base[2],
               out_frame->pitches[2], frame->pitches[2],
-              frame->width/2, frame->height/2, &this->params[1]);
+              frame->width/2, frame->height/2, &this->params[1], this->pool);
     } else {
         // Chroma strength is ignored for YUY2.
         noise(out_frame->base[0], frame->base[0],
               out_frame->pitches[0], frame->pitches[0],
-              frame->width * 2, frame->height, &this->params[0]);
+              frame->width * 2, frame->height, &this->params[0], this->pool);
     }
 
-#ifdef ARCH_X86
-    if (xine_mm_accel() & MM_ACCEL_X86_MMX)
-        asm volatile ("emms\n\t");
-    if (xine_mm_accel() & MM_ACCEL_X86_MMXEXT)
-        asm volatile ("sfence\n\t");
-#endif
-
     pthread_mutex_unlock (&this->lock);
     skip = out_frame->draw(out_frame, stream);
     _x_post_frame_copy_up(frame, out_frame);
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * band processing shared by the planar post plugins
+ */
+
+#ifndef XINE_POST_PLANAR_H
+#define XINE_POST_PLANAR_H
+
+#include <xine/video_out.h>
+#include <xine/post.h>
+#include <xine/worker_pool.h>
+
+/*
+ * A filter pass over up to three planes is split into bands of lines
+ * (rows, or columns for vertical passes).  Band n covers the same
+ * fraction of every plane, so one band handles Y, U and V of the same
+ * picture area in a row.  Bands write disjoint lines; context outside
+ * the band (blur radius etc.) must be read from the unmodified source.
+ */
+
+/* Processes lines [start, end) of the given plane.  band identifies the
+ * calling band, 0 <= band < planar_max_bands(), and can be used to pick
+ * private scratch memory.
+ */
+typedef void (*planar_band_func_t)(void *data, int plane, int start, int end, int band);
+
+/* All planar plugins share one pool, referenced from open/dispose. */
+xine_worker_pool_t *planar_pool_ref(void);
+void planar_pool_unref(void);
+
+/* Upper limit for the band index passed to the band function. */
+int planar_max_bands(xine_worker_pool_t *pool);
+
+/* Runs func over all lines[plane] lines of each of num_planes planes and
+ * waits until everything is done.
+ */
+void planar_run_bands(xine_worker_pool_t *pool, int num_planes, const int *lines,
+                      planar_band_func_t func, void *data);
+
+/*
+ * Pointwise filters (eq, eq2) register a stage for their port.  When a
+ * planar plugin writes its output frame in row bands with
+ * planar_run_bands_fused() and that frame goes to such a port, the stage
+ * filters each band in place right after it was written, while it is
+ * still in cache, and the draw of its plugin passes the frame on as is.
+ * Stages further down the chain are fused the same way.
+ *
+ * The stage of a frame is found through the frame itself: frames of a
+ * stage port draw through bands.c, which knows the stage from the port.
+ *
+ * Lock order: the plugin calling planar_run_bands_fused() may hold its
+ * own lock, prepare() then takes the locks of the stages behind it in
+ * chain order.  Locks are thus only ever taken upstream first, and a
+ * stage must not take the lock of a plugin in front of it.
+ */
+typedef struct planar_stage_s planar_stage_t;
+
+struct planar_stage_s {
+  /* Takes the lock of the stage and returns 1 if it has work to do.
+   * Returns 0 with the lock released otherwise.  Called with the locks
+   * of the stages and the plugin in front held. */
+  int  (*prepare)(void *data);
+  /* Filters rows [start, end) of plane in place. */
+  void (*band)(void *data, vo_frame_t *frame, int plane, int start, int end);
+  /* Releases the lock taken by prepare. */
+  void (*release)(void *data);
+  void *data;
+
+  /* private to bands.c */
+  int              (*draw)(vo_frame_t *frame, xine_stream_t *stream);
+  vo_frame_t        *fused;
+};
+
+/* Makes the stage run on frames drawn to the intercepting post port.
+ * Call after setting port->new_frame->draw, the stage lives as long
+ * as the port. */
+void planar_stage_register(planar_stage_t *stage, post_video_port_t *port);
+
+/* Returns 1 if frame was already filtered by a fused run; the draw
+ * function must then pass it on unchanged. */
+int planar_stage_fused(planar_stage_t *stage, vo_frame_t *frame);
+
+/* planar_run_bands() over rows of all three planes of the YV12 frame dst,
+ * which func writes completely, plus the stages dst is drawn to.
+ * Call only right before drawing dst.
+ */
+void planar_run_bands_fused(xine_worker_pool_t *pool, const int *lines,
+                            planar_band_func_t func, void *data, vo_frame_t *dst);
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2010 the xine-project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * unsharp-bench: throughput of the unsharp filter implementations.
+ *
+ * Every implementation the cpu supports sharpens the same synthetic
+ * YV12 picture with a few matrix sizes. Reported are frames per second
+ * and whether the output differs from the C version (it must not).
+ * Build with "make unsharp-bench" in this directory.
+ */
+
+/* the filters are static */
+#include "unsharp.c"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+typedef struct {
+  const char     *name;
+  unsharp_func_t  func;
+  uint32_t        accel;
+} bench_impl_t;
+
+static const bench_impl_t impls[] = {
+  { "C",    unsharp,      0 },
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+  { "SSE2", unsharp_sse2, MM_ACCEL_X86_SSE2 },
+#ifdef HAVE_AVX2
+  { "AVX2", unsharp_avx2, MM_ACCEL_X86_AVX2 },
+#endif
+#endif
+};
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* noise on a checkerboard, so there is something to sharpen */
+static void fill_plane (uint8_t *p, int width, int height)
+{
+  unsigned int seed = 1;
+  int x, y;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++) {
+      seed = seed * 1103515245 + 12345;
+      p[y * width + x] = ((x / 16 + y / 16) & 1 ? 170 : 70) + ((seed >> 16) & 31);
+    }
+}
+
+/* one frame: luma, then both chroma planes */
+static void filter_frame (unsharp_func_t func, uint8_t **dst, uint8_t **src, int width, int height,
+                          FilterParam *luma, FilterParam *chroma, uint32_t *sc)
+{
+  int plane;
+
+  for (plane = 0; plane < 3; plane++) {
+    int w = plane ? width / 2 : width;
+    int h = plane ? height / 2 : height;
+    func (dst[plane], src[plane], w, w, w, h, 0, h, plane ? chroma : luma, sc);
+  }
+}
+
+int main (int argc, char *argv[])
+{
+  static const int sizes[] = { 3, 5, 7, 11 };
+  int width = 1920, height = 1080, frames = 50;
+  double amount = 1.0;
+  uint8_t *src[3], *ref[3], *out[3];
+  uint32_t *sc;
+  uint32_t accel;
+  xine_t *xine;
+  int opt, i, s, ret = 0;
+
+  while ((opt = getopt (argc, argv, "w:h:n:a:")) != -1) {
+    switch (opt) {
+    case 'w':
+      width = atoi (optarg) & ~1;
+      break;
+    case 'h':
+      height = atoi (optarg) & ~1;
+      break;
+    case 'n':
+      frames = atoi (optarg);
+      break;
+    case 'a':
+      amount = atof (optarg);
+      break;
+    default:
+      fprintf (stderr, "\
+usage: %s [options]\n\
+options:\n\
+  -w WIDTH	frame width (default: 1920)\n\
+  -h HEIGHT	frame height (default: 1080)\n\
+  -n FRAMES	frames per run (default: 50)\n\
+  -a AMOUNT	sharpness, < 0 blurs (default: 1.0)\n", argv[0]);
+      return 1;
+    }
+  }
+  if (width < 32 || height < 32 || frames < 1 || !amount) {
+    fputs ("unsharp-bench: invalid option\n", stderr);
+    return 1;
+  }
+
+  /* for xine_fast_memcpy () */
+  xine = xine_new ();
+  xine_set_flags (xine, XINE_FLAG_NO_WRITE_CACHE);
+  xine_init (xine);
+  accel = xine_mm_accel ();
+
+  for (i = 0; i < 3; i++) {
+    int size = i ? (width / 2) * (height / 2) : width * height;
+    src[i] = malloc (size);
+    ref[i] = malloc (size);
+    out[i] = malloc (size);
+    if (!src[i] || !ref[i] || !out[i])
+      return 1;
+    fill_plane (src[i], i ? width / 2 : width, i ? height / 2 : height);
+  }
+  /* enough for unsharp_sse2 () with the largest matrix */
+  sc = malloc (sizeof (*sc) * (MAX_MATRIX_SIZE + 1) * (width + MAX_MATRIX_SIZE));
+  if (!sc)
+    return 1;
+
+  printf ("unsharp-bench: %dx%d YV12, %d frames per run, amount %.2f\n",
+          width, height, frames, amount);
+
+  for (s = 0; s < (int)(sizeof (sizes) / sizeof (sizes[0])); s++) {
+    FilterParam luma   = { sizes[s], sizes[s], amount };
+    FilterParam chroma = { 3, 3, amount };
+
+    filter_frame (unsharp, ref, src, width, height, &luma, &chroma, sc);
+
+    for (i = 0; i < (int)(sizeof (impls) / sizeof (impls[0])); i++) {
+      double t0, fps;
+      int n, same;
+
+      if ((accel & impls[i].accel) != impls[i].accel)
+        continue;
+
+      t0 = now ();
+      for (n = 0; n < frames; n++)
+        filter_frame (impls[i].func, out, src, width, height, &luma, &chroma, sc);
+      fps = frames / (now () - t0);
+
+      same = !memcmp (out[0], ref[0], width * height) &&
+             !memcmp (out[1], ref[1], (width / 2) * (height / 2)) &&
+             !memcmp (out[2], ref[2], (width / 2) * (height / 2));
+      if (!same)
+        ret = 1;
+      printf ("  %2dx%-2d %-5s %8.1f fps  %s\n", sizes[s], sizes[s], impls[i].name, fps,
+              same ? "same" : "DIFFERENT");
+    }
+  }
+
+  for (i = 0; i < 3; i++) {
+    free (src[i]);
+    free (ref[i]);
+    free (out[i]);
+  }
+  free (sc);
+  xine_exit (xine);
+  return ret;
+}
@@ -29,6 +29,8 @@
 #include <xine/post.h>
 #include <xine/xineutils.h>
 #include <pthread.h>
+#include "xine_mmx.h"
+#include "planar.h"
 
 /*===========================================================================*/
 
@@ -38,18 +40,24 @@
 typedef struct FilterParam {
     int msizeX, msizeY;
     double amount;
-    uint32_t *SC[MAX_MATRIX_SIZE-1];
 } FilterParam;
 
 struct vf_priv_s {
     FilterParam lumaParam;
     FilterParam chromaParam;
     int width, height;
+    uint32_t *sc;           /* column sums, sc_size per band */
+    int sc_size;
 };
 
 
 /*===========================================================================*/
 
+typedef void (*unsharp_func_t)( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height,
+                                int first, int last, FilterParam *fp, uint32_t *sc );
+
+static unsharp_func_t unsharp_filter;
+
 /* This code is based on :
 
 An Efficient algorithm for Gaussian blur using finite-state machines
@@ -60,11 +68,16 @@ Originally published Boston, Nov 98
 
 */
 
-static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height, FilterParam *fp ) {
+/* Only output lines [first, last) are written, the lines around them are
+ * read from src as needed.  sc is scratch memory for 2*stepsY column
+ * sums of width+2*stepsX each.
+ */
+static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height,
+                     int first, int last, FilterParam *fp, uint32_t *sc ) {
 
-    uint32_t **SC = fp->SC;
+    uint32_t *SC[MAX_MATRIX_SIZE-1];
     uint32_t SR[MAX_MATRIX_SIZE-1], Tmp1, Tmp2;
-    uint8_t* src2 = src;
+    uint8_t* src2;
 
     int32_t res;
     int x, y, z;
@@ -74,22 +87,31 @@ static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, i
     int scalebits = (stepsX+stepsY)*2;
     int32_t halfscale = 1 << ((stepsX+stepsY)*2-1);
 
+    dst += first*dstStride;
+    src += first*srcStride;
+    height -= first;
+    first = -first;
+    last += first;
+
     if( !fp->amount ) {
 	if( src == dst )
 	    return;
 	if( dstStride == srcStride )
-	    xine_fast_memcpy( dst, src, srcStride*height );
+	    xine_fast_memcpy( dst, src, srcStride*last );
 	else
-	    for( y=0; y<height; y++, dst+=dstStride, src+=srcStride )
+	    for( y=0; y<last; y++, dst+=dstStride, src+=srcStride )
 		xine_fast_memcpy( dst, src, width );
 	return;
     }
 
-    for( y=0; y<2*stepsY; y++ )
+    for( y=0; y<2*stepsY; y++ ) {
+	SC[y] = sc + y * (width+2*stepsX);
 	memset( SC[y], 0, sizeof(SC[y][0]) * (width+2*stepsX) );
+    }
 
-    for( y=-stepsY; y<height+stepsY; y++ ) {
-	if( y < height ) src2 = src;
+    /* the filter runs on lines clamped to [first, height) relative to the band */
+    for( y=-stepsY; y<last+stepsY; y++ ) {
+	src2 = src + (y < first ? first : y >= height ? height-1 : y) * srcStride;
 	memset( SR, 0, sizeof(SR[0]) * (2*stepsX-1) );
 	for( x=-stepsX; x<width+stepsX; x++ ) {
 	    Tmp1 = x<=0 ? src2[0] : x>=width ? src2[width-1] : src2[x];
@@ -102,19 +124,302 @@ static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, i
 		Tmp1 = SC[z+1][x+stepsX] + Tmp2; SC[z+1][x+stepsX] = Tmp2;
 	    }
 	    if( x>=stepsX && y>=stepsY ) {
-		uint8_t* srx = src - stepsY*srcStride + x - stepsX;
-		uint8_t* dsx = dst - stepsY*dstStride + x - stepsX;
+		uint8_t* srx = src + (y-stepsY)*srcStride + x - stepsX;
+		uint8_t* dsx = dst + (y-stepsY)*dstStride + x - stepsX;
 
 		res = (int32_t)*srx + ( ( ( (int32_t)*srx - (int32_t)((Tmp1+halfscale) >> scalebits) ) * amount ) >> 16 );
 		*dsx = res>255 ? 255 : res<0 ? 0 : (uint8_t)res;
 	    }
 	}
-	if( y >= 0 ) {
-	    dst += dstStride;
-	    src += srcStride;
+    }
+}
+
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+/* Same filter as unsharp(), reordered so neighbouring pixels can be done
+ * in parallel: every source line is padded and run through the horizontal
+ * cascade as a whole, then the vertical cascade advances 4 columns at a
+ * time and output pixels are computed 8 at a time.  The horizontal cascade
+ * is a binomial filter, so it is applied as 2*stepsX passes of
+ * sum[x] += sum[x-1].  The result is bit exact to unsharp().
+ * sc needs one more line than for unsharp(): (2*stepsY+1)*(width+2*stepsX).
+ */
+static void unsharp_sse2( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height,
+                          int first, int last, FilterParam *fp, uint32_t *sc ) {
+
+    uint32_t *SC[MAX_MATRIX_SIZE-1], *SR;
+    uint8_t *src2;
+
+    int32_t res;
+    int i, x, y, z;
+    int amount = fp->amount * 65536.0;
+    int stepsX = fp->msizeX/2;
+    int stepsY = fp->msizeY/2;
+    int scalebits = (stepsX+stepsY)*2;
+    int32_t halfscale = 1 << ((stepsX+stepsY)*2-1);
+    int n = width + 2*stepsX;
+    sse_t half, mul_hi, mul_lo;
+
+    dst += first*dstStride;
+    src += first*srcStride;
+    height -= first;
+    first = -first;
+    last += first;
+
+    if( !fp->amount ) {
+	if( src == dst )
+	    return;
+	if( dstStride == srcStride )
+	    xine_fast_memcpy( dst, src, srcStride*last );
+	else
+	    for( y=0; y<last; y++, dst+=dstStride, src+=srcStride )
+		xine_fast_memcpy( dst, src, width );
+	return;
+    }
+
+    for( y=0; y<2*stepsY; y++ ) {
+	SC[y] = sc + y * n;
+	memset( SC[y], 0, sizeof(SC[y][0]) * n );
+    }
+    SR = sc + 2*stepsY * n;
+
+    /* (d*amount) >> 16 == d*mul_hi + ((d*mul_lo) >> 16) using signed 16 bit
+     * words, with the carry of a negative mul_lo folded into mul_hi */
+    for( i=0; i<4; i++ )
+	half.d[i] = halfscale;
+    for( i=0; i<8; i++ ) {
+	mul_lo.w[i] = (int16_t)(amount & 0xffff);
+	mul_hi.w[i] = (amount >> 16) + (mul_lo.w[i] < 0);
+    }
+
+    for( y=-stepsY; y<last+stepsY; y++ ) {
+	src2 = src + (y < first ? first : y >= height ? height-1 : y) * srcStride;
+
+	/* padded line */
+	for( i=0; i<=stepsX; i++ ) {
+	    SR[i] = src2[0];
+	    SR[n-1-i] = src2[width-1];
+	}
+	for( x=1; x+4<width; x+=4 ) {
+	    pxor_r2r( xmm7, xmm7 );
+	    movd_m2r( *(uint32_t *)(src2+x), xmm0 );
+	    punpcklbw_r2r( xmm7, xmm0 );
+	    punpcklwd_r2r( xmm7, xmm0 );
+	    movdqu_r2m( xmm0, *(sse_t *)(SR+stepsX+x) );
+	}
+	for( ; x<width-1; x++ )
+	    SR[stepsX+x] = src2[x];
+
+	/* horizontal cascade, back to front so SR[i-1] is still the old value.
+	 * Only SR[2*stepsX..n) come out complete, the rest is never used. */
+	for( z=0; z<stepsX*2; z++ ) {
+	    for( i=n-4; i>=1; i-=4 ) {
+		movdqu_m2r( *(sse_t *)(SR+i), xmm0 );
+		movdqu_m2r( *(sse_t *)(SR+i-1), xmm1 );
+		paddd_r2r( xmm1, xmm0 );
+		movdqu_r2m( xmm0, *(sse_t *)(SR+i) );
+	    }
+	    for( i+=3; i>=1; i-- )
+		SR[i] += SR[i-1];
+	}
+
+	/* vertical cascade, leaving the complete sums in SR */
+	for( i=2*stepsX; i+4<=n; i+=4 ) {
+	    movdqu_m2r( *(sse_t *)(SR+i), xmm0 );
+	    for( z=0; z<stepsY*2; z+=2 ) {
+		movdqu_m2r( *(sse_t *)(SC[z+0]+i), xmm1 );
+		paddd_r2r( xmm0, xmm1 );
+		movdqu_r2m( xmm0, *(sse_t *)(SC[z+0]+i) );
+		movdqu_m2r( *(sse_t *)(SC[z+1]+i), xmm0 );
+		paddd_r2r( xmm1, xmm0 );
+		movdqu_r2m( xmm1, *(sse_t *)(SC[z+1]+i) );
+	    }
+	    movdqu_r2m( xmm0, *(sse_t *)(SR+i) );
+	}
+	for( ; i<n; i++ ) {
+	    uint32_t Tmp1 = SR[i], Tmp2;
+	    for( z=0; z<stepsY*2; z+=2 ) {
+		Tmp2 = SC[z+0][i] + Tmp1; SC[z+0][i] = Tmp1;
+		Tmp1 = SC[z+1][i] + Tmp2; SC[z+1][i] = Tmp2;
+	    }
+	    SR[i] = Tmp1;
+	}
+
+	if( y>=stepsY ) {
+	    uint8_t *srx = src + (y-stepsY)*srcStride;
+	    uint8_t *dsx = dst + (y-stepsY)*dstStride;
+	    uint32_t *sum = SR + 2*stepsX;
+
+	    for( x=0; x+8<=width; x+=8 ) {
+		movdqu_m2r( half, xmm6 );
+		movd_m2r( scalebits, xmm5 );
+		movdqu_m2r( *(sse_t *)(sum+x), xmm0 );
+		movdqu_m2r( *(sse_t *)(sum+x+4), xmm1 );
+		paddd_r2r( xmm6, xmm0 );
+		paddd_r2r( xmm6, xmm1 );
+		psrld_r2r( xmm5, xmm0 );
+		psrld_r2r( xmm5, xmm1 );
+		packssdw_r2r( xmm1, xmm0 );            /* blurred */
+		pxor_r2r( xmm7, xmm7 );
+		movq_m2r( *(uint64_t *)(srx+x), xmm2 );
+		punpcklbw_r2r( xmm7, xmm2 );           /* src */
+		movdqa_r2r( xmm2, xmm1 );
+		psubw_r2r( xmm0, xmm1 );               /* d = src - blurred */
+		movdqu_m2r( mul_hi, xmm3 );
+		movdqu_m2r( mul_lo, xmm4 );
+		pmullw_r2r( xmm1, xmm3 );
+		pmulhw_r2r( xmm1, xmm4 );
+		paddw_r2r( xmm3, xmm2 );
+		paddw_r2r( xmm4, xmm2 );
+		packuswb_r2r( xmm2, xmm2 );
+		movq_r2m( xmm2, *(uint64_t *)(dsx+x) );
+	    }
+	    for( ; x<width; x++ ) {
+		res = (int32_t)srx[x] + ( ( ( (int32_t)srx[x] - (int32_t)((sum[x]+halfscale) >> scalebits) ) * amount ) >> 16 );
+		dsx[x] = res>255 ? 255 : res<0 ? 0 : (uint8_t)res;
+	    }
+	}
+    }
+}
+
+#ifdef HAVE_AVX2
+/* unsharp_sse2() with 256 bit registers: 8 column sums and 16 output
+ * pixels per step.  Bit exact to unsharp(), same scratch size as
+ * unsharp_sse2().
+ */
+static void unsharp_avx2( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height,
+                          int first, int last, FilterParam *fp, uint32_t *sc ) {
+
+    uint32_t *SC[MAX_MATRIX_SIZE-1], *SR;
+    uint8_t *src2;
+
+    int32_t res;
+    int i, x, y, z;
+    int amount = fp->amount * 65536.0;
+    int stepsX = fp->msizeX/2;
+    int stepsY = fp->msizeY/2;
+    int scalebits = (stepsX+stepsY)*2;
+    int32_t halfscale = 1 << ((stepsX+stepsY)*2-1);
+    int n = width + 2*stepsX;
+    avx_t half, mul_hi, mul_lo;
+
+    dst += first*dstStride;
+    src += first*srcStride;
+    height -= first;
+    first = -first;
+    last += first;
+
+    if( !fp->amount ) {
+	if( src == dst )
+	    return;
+	if( dstStride == srcStride )
+	    xine_fast_memcpy( dst, src, srcStride*last );
+	else
+	    for( y=0; y<last; y++, dst+=dstStride, src+=srcStride )
+		xine_fast_memcpy( dst, src, width );
+	return;
+    }
+
+    for( y=0; y<2*stepsY; y++ ) {
+	SC[y] = sc + y * n;
+	memset( SC[y], 0, sizeof(SC[y][0]) * n );
+    }
+    SR = sc + 2*stepsY * n;
+
+    for( i=0; i<8; i++ )
+	half.d[i] = halfscale;
+    for( i=0; i<16; i++ ) {
+	mul_lo.w[i] = (int16_t)(amount & 0xffff);
+	mul_hi.w[i] = (amount >> 16) + (mul_lo.w[i] < 0);
+    }
+
+    for( y=-stepsY; y<last+stepsY; y++ ) {
+	src2 = src + (y < first ? first : y >= height ? height-1 : y) * srcStride;
+
+	/* padded line */
+	for( i=0; i<=stepsX; i++ ) {
+	    SR[i] = src2[0];
+	    SR[n-1-i] = src2[width-1];
+	}
+	for( x=1; x+8<width; x+=8 ) {
+	    vpmovzxbd_m2r( *(uint64_t *)(src2+x), ymm0 );
+	    vmovdqu_r2m( ymm0, *(avx_t *)(SR+stepsX+x) );
+	}
+	for( ; x<width-1; x++ )
+	    SR[stepsX+x] = src2[x];
+
+	/* horizontal cascade */
+	for( z=0; z<stepsX*2; z++ ) {
+	    for( i=n-8; i>=1; i-=8 ) {
+		vmovdqu_m2r( *(avx_t *)(SR+i), ymm0 );
+		vmovdqu_m2r( *(avx_t *)(SR+i-1), ymm1 );
+		vpaddd_r2r( ymm1, ymm0 );
+		vmovdqu_r2m( ymm0, *(avx_t *)(SR+i) );
+	    }
+	    for( i+=7; i>=1; i-- )
+		SR[i] += SR[i-1];
+	}
+
+	/* vertical cascade */
+	for( i=2*stepsX; i+8<=n; i+=8 ) {
+	    vmovdqu_m2r( *(avx_t *)(SR+i), ymm0 );
+	    for( z=0; z<stepsY*2; z+=2 ) {
+		vmovdqu_m2r( *(avx_t *)(SC[z+0]+i), ymm1 );
+		vpaddd_r2r( ymm0, ymm1 );
+		vmovdqu_r2m( ymm0, *(avx_t *)(SC[z+0]+i) );
+		vmovdqu_m2r( *(avx_t *)(SC[z+1]+i), ymm0 );
+		vpaddd_r2r( ymm1, ymm0 );
+		vmovdqu_r2m( ymm1, *(avx_t *)(SC[z+1]+i) );
+	    }
+	    vmovdqu_r2m( ymm0, *(avx_t *)(SR+i) );
+	}
+	for( ; i<n; i++ ) {
+	    uint32_t Tmp1 = SR[i], Tmp2;
+	    for( z=0; z<stepsY*2; z+=2 ) {
+		Tmp2 = SC[z+0][i] + Tmp1; SC[z+0][i] = Tmp1;
+		Tmp1 = SC[z+1][i] + Tmp2; SC[z+1][i] = Tmp2;
+	    }
+	    SR[i] = Tmp1;
+	}
+
+	if( y>=stepsY ) {
+	    uint8_t *srx = src + (y-stepsY)*srcStride;
+	    uint8_t *dsx = dst + (y-stepsY)*dstStride;
+	    uint32_t *sum = SR + 2*stepsX;
+
+	    for( x=0; x+16<=width; x+=16 ) {
+		vmovdqu_m2r( half, ymm6 );
+		vmovd_m2r( scalebits, xmm5 );
+		vmovdqu_m2r( *(avx_t *)(sum+x), ymm0 );
+		vmovdqu_m2r( *(avx_t *)(sum+x+8), ymm1 );
+		vpaddd_r2r( ymm6, ymm0 );
+		vpaddd_r2r( ymm6, ymm1 );
+		vpsrld_r2r( xmm5, ymm0 );
+		vpsrld_r2r( xmm5, ymm1 );
+		vpackssdw_r2r( ymm1, ymm0 );           /* blurred, per 128 bit lane */
+		vpermq_r2r( ymm0, ymm0, 0xd8 );        /* back in order */
+		vpmovzxbw_m2r( *(sse_t *)(srx+x), ymm2 ); /* src */
+		vmovdqa_r2r( ymm2, ymm1 );
+		vpsubw_r2r( ymm0, ymm1 );              /* d = src - blurred */
+		vmovdqu_m2r( mul_hi, ymm3 );
+		vmovdqu_m2r( mul_lo, ymm4 );
+		vpmullw_r2r( ymm1, ymm3 );
+		vpmulhw_r2r( ymm1, ymm4 );
+		vpaddw_r2r( ymm3, ymm2 );
+		vpaddw_r2r( ymm4, ymm2 );
+		vpackuswb_r2r( ymm2, ymm2 );
+		vpermq_r2r( ymm2, ymm2, 0xd8 );
+		vmovdqu_r2m( xmm2, *(sse_t *)(dsx+x) );
+	    }
+	    for( ; x<width; x++ ) {
+		res = (int32_t)srx[x] + ( ( ( (int32_t)srx[x] - (int32_t)((sum[x]+halfscale) >> scalebits) ) * amount ) >> 16 );
+		dsx[x] = res>255 ? 255 : res<0 ? 0 : (uint8_t)res;
+	    }
 	}
     }
+    vzeroupper();
 }
+#endif /* HAVE_AVX2 */
+#endif
 
 
 /* plugin class initialization function */
@@ -165,6 +470,8 @@ struct post_plugin_unsharp_s {
   xine_post_in_t       params_input;
   struct vf_priv_s     priv;
 
+  xine_worker_pool_t  *pool;
+
   pthread_mutex_t      lock;
 };
 
@@ -304,6 +611,18 @@ static post_plugin_t *unsharp_open_plugin(post_class_t *class_gen, int inputs,
 
   pthread_mutex_init (&this->lock, NULL);
 
+  unsharp_filter = unsharp;
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+  if( xine_mm_accel() & MM_ACCEL_X86_SSE2 )
+    unsharp_filter = unsharp_sse2;
+#ifdef HAVE_AVX2
+  if( xine_mm_accel() & MM_ACCEL_X86_AVX2 )
+    unsharp_filter = unsharp_avx2;
+#endif
+#endif
+
+  this->pool = planar_pool_ref();
+
   port = _x_post_intercept_video_port(&this->post, video_target[0], &input, &output);
   port->intercept_frame = unsharp_intercept_frame;
   port->new_frame->draw = unsharp_draw;
@@ -328,21 +647,8 @@ static post_plugin_t *unsharp_open_plugin(post_class_t *class_gen, int inputs,
 
 static void unsharp_free_SC(post_plugin_unsharp_t *this)
 {
-  int i;
-
-  for( i = 0; i < MAX_MATRIX_SIZE-1; i++ ) {
-    if( this->priv.lumaParam.SC[i] ) {
-      free( this->priv.lumaParam.SC[i] );
-      this->priv.lumaParam.SC[i] = NULL;
-    }
-  }
-
-  for( i = 0; i < MAX_MATRIX_SIZE-1; i++ ) {
-    if( this->priv.chromaParam.SC[i] ) {
-      free( this->priv.chromaParam.SC[i] );
-      this->priv.chromaParam.SC[i] = NULL;
-    }
-  }
+  free( this->priv.sc );
+  this->priv.sc = NULL;
 }
 
 
@@ -352,6 +658,7 @@ static void unsharp_dispose(post_plugin_t *this_gen)
 
   if (_x_post_dispose(this_gen)) {
     unsharp_free_SC(this);
+    planar_pool_unref();
     pthread_mutex_destroy(&this->lock);
     free(this);
   }
@@ -364,12 +671,32 @@ static int unsharp_intercept_frame(post_video_port_t *port, vo_frame_t *frame)
 }
 
 
+typedef struct {
+  struct vf_priv_s *priv;
+  vo_frame_t       *src;
+  vo_frame_t       *dst;
+} unsharp_band_t;
+
+static void unsharp_band(void *data, int plane, int start, int end, int band)
+{
+  unsharp_band_t *b = (unsharp_band_t *)data;
+  int             width  = (plane == 0) ? b->src->width  : b->src->width/2;
+  int             height = (plane == 0) ? b->src->height : b->src->height/2;
+
+  unsharp_filter( b->dst->base[plane], b->src->base[plane], b->dst->pitches[plane], b->src->pitches[plane],
+                  width, height, start, end,
+                  (plane == 0) ? &b->priv->lumaParam : &b->priv->chromaParam,
+                  b->priv->sc + band * b->priv->sc_size );
+}
+
 static int unsharp_draw(vo_frame_t *frame, xine_stream_t *stream)
 {
   post_video_port_t *port = (post_video_port_t *)frame->port;
   post_plugin_unsharp_t *this = (post_plugin_unsharp_t *)port->post;
   vo_frame_t *out_frame;
   vo_frame_t *yv12_frame;
+  unsharp_band_t band;
+  int lines[3];
   int skip;
 
   if( !frame->bad_frame &&
@@ -404,30 +731,42 @@ static int unsharp_draw(vo_frame_t *frame, xine_stream_t *stream)
     pthread_mutex_lock (&this->lock);
 
     if( frame->width != this->priv.width || frame->height != this->priv.height ) {
-       int z, stepsX, stepsY;
-       FilterParam *fp;
+       int stepsX, stepsY;
 
        this->priv.width = frame->width;
        this->priv.height = frame->height;
 
        unsharp_free_SC(this);
 
-       fp = &this->priv.lumaParam;
-       stepsX = fp->msizeX/2;
-       stepsY = fp->msizeY/2;
-       for( z=0; z<2*stepsY; z++ )
-         fp->SC[z] = malloc( sizeof(*(fp->SC[z])) * (frame->width+2*stepsX) );
-
-       fp = &this->priv.chromaParam;
-       stepsX = fp->msizeX/2;
-       stepsY = fp->msizeY/2;
-       for( z=0; z<2*stepsY; z++ )
-         fp->SC[z] = malloc( sizeof(*(fp->SC[z])) * (frame->width+2*stepsX) );
+       /* one set of column sums per band, big enough for luma and chroma,
+        * plus the line buffer of unsharp_sse2() */
+       stepsX = MAX( this->priv.lumaParam.msizeX, this->priv.chromaParam.msizeX ) / 2;
+       stepsY = MAX( this->priv.lumaParam.msizeY, this->priv.chromaParam.msizeY ) / 2;
+       this->priv.sc_size = (2*stepsY+1) * (frame->width+2*stepsX);
+       this->priv.sc = malloc( sizeof(*this->priv.sc) * this->priv.sc_size * planar_max_bands(this->pool) );
+       if( !this->priv.sc ) {
+         /* try again with the next frame */
+         this->priv.width = this->priv.height = 0;
+       }
     }
 
-    unsharp( out_frame->base[0], yv12_frame->base[0], out_frame->pitches[0], yv12_frame->pitches[0], yv12_frame->width,   yv12_frame->height,   &this->priv.lumaParam );
-    unsharp( out_frame->base[1], yv12_frame->base[1], out_frame->pitches[1], yv12_frame->pitches[1], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam );
-    unsharp( out_frame->base[2], yv12_frame->base[2], out_frame->pitches[2], yv12_frame->pitches[2], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam );
+    lines[0] = yv12_frame->height;
+    lines[1] = lines[2] = yv12_frame->height/2;
+
+    if( this->priv.sc ) {
+      band.priv = &this->priv;
+      band.src  = yv12_frame;
+      band.dst  = out_frame;
+      planar_run_bands_fused(this->pool, lines, unsharp_band, &band, out_frame);
+    } else {
+      /* out of memory, pass the picture on unfiltered */
+      int plane, y;
+      for( plane = 0; plane < 3; plane++ )
+        for( y = 0; y < lines[plane]; y++ )
+          xine_fast_memcpy( out_frame->base[plane] + y * out_frame->pitches[plane],
+                            yv12_frame->base[plane] + y * yv12_frame->pitches[plane],
+                            plane ? yv12_frame->width/2 : yv12_frame->width );
+    }
 
     pthread_mutex_unlock (&this->lock);
 
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include <sys/time.h>
 
 #include <inttypes.h>
@@ -332,6 +333,32 @@ static const int parity_table[256] = {
 
 /*---------------- decoder data structures -----------------------*/
 
+/* CC attribute */
+typedef struct cc_attribute_s {
+  uint8_t italic;
+  uint8_t underline;
+  uint8_t foreground;
+  uint8_t background;
+} cc_attribute_t;
+
+/* CC character cell */
+typedef struct cc_char_cell_s {
+  uint8_t c;                   /* character code, not the same as ASCII */
+  cc_attribute_t attributes;   /* attributes of this character, if changed */
+			       /* here */
+  int midrow_attr;             /* true if this cell changes an attribute */
+} cc_char_cell_t;
+
+/* a row as it was last rendered into the caption display object */
+typedef struct cc_painted_row_s {
+  cc_char_cell_t cells[CC_COLUMNS];
+  int num_chars;             /* 0 if nothing was painted */
+  int x1, y1, x2, y2;        /* area covered by the painted boxes */
+} cc_painted_row_t;
+
+/* what the renderer was asked to do since the last flush */
+enum { CC_PENDING_NONE, CC_PENDING_SHOW, CC_PENDING_HIDE };
+
 /* CC renderer */
 struct cc_renderer_s {
   int video_width;            /* video dimensions */
@@ -348,6 +375,18 @@ struct cc_renderer_s {
   osd_object_t *cap_display;  /* caption display object */
   int displayed;              /* true when caption currently is displayed */
 
+  /* Show and hide requests are batched: requests for the same vpts
+     replace each other and only the last one reaches the OSD, when the
+     next vpts is requested or the decoded packet ends. */
+  int pending;                /* CC_PENDING_* */
+  int64_t pending_vpts;
+  struct cc_buffer_s *pending_buf;
+  int on_screen;              /* true when the OSD object was last shown */
+
+  /* contents of cap_display, per caption row. Rows that did not change
+     are not rendered again. */
+  cc_painted_row_t painted[CC_ROWS];
+
   /* the next variable is a hack: hiding a caption with vpts 0 doesn't seem
      to work if the caption has been registered in the SPU event queue, but
      not yet displayed. So we remember the vpts of the show event, and use
@@ -376,22 +415,6 @@ struct cc_renderer_s {
 };
 
 
-/* CC attribute */
-typedef struct cc_attribute_s {
-  uint8_t italic;
-  uint8_t underline;
-  uint8_t foreground;
-  uint8_t background;
-} cc_attribute_t;
-
-/* CC character cell */
-typedef struct cc_char_cell_s {
-  uint8_t c;                   /* character code, not the same as ASCII */
-  cc_attribute_t attributes;   /* attributes of this character, if changed */
-			       /* here */
-  int midrow_attr;             /* true if this cell changes an attribute */
-} cc_char_cell_t;
-
 /* a single row in the closed captioning memory */
 typedef struct cc_row_s {
   cc_char_cell_t cells[CC_COLUMNS];
@@ -577,7 +600,27 @@ static void ccrow_set_attributes(cc_renderer_t *renderer, cc_row_t *this,
 }
 
 
-static void ccrow_render(cc_renderer_t *renderer, cc_row_t *this, int rownum)
+static int ccrow_equal(const cc_painted_row_t *painted, const cc_row_t *this)
+{
+  int i;
+
+  if (painted->num_chars != this->num_chars)
+    return 0;
+  for (i = 0; i < this->num_chars; i++) {
+    const cc_char_cell_t *a = &painted->cells[i], *b = &this->cells[i];
+    if (a->c != b->c || a->midrow_attr != b->midrow_attr ||
+	a->attributes.italic != b->attributes.italic ||
+	a->attributes.underline != b->attributes.underline ||
+	a->attributes.foreground != b->attributes.foreground ||
+	a->attributes.background != b->attributes.background)
+      return 0;
+  }
+  return 1;
+}
+
+
+static void ccrow_render(cc_renderer_t *renderer, cc_row_t *this, int rownum,
+			 cc_painted_row_t *painted)
 {
   char buf[CC_COLUMNS + 1];
   int base_y;
@@ -680,6 +723,12 @@ static void ccrow_render(cc_renderer_t *renderer, cc_row_t *this, int rownum)
       osd_renderer->filled_rect(renderer->cap_display, box_x1, y, box_x2,
 				y + renderer->max_char_height,
 				textcol + CAP_BG_COL);
+      /* filled_rect() shortens boxes reaching out to the left, so
+         remember them clipped to cover the text in any case */
+      painted->x1 = MIN(painted->x1, MAX(box_x1, 0));
+      painted->x2 = MAX(painted->x2, box_x2);
+      painted->y1 = MIN(painted->y1, MAX(y, 0));
+      painted->y2 = MAX(painted->y2, y + renderer->max_char_height);
 
       for (i = seg_pos[seg]; i < seg_pos[seg + 1]; i++)
 	buf[i - seg_pos[seg]] = this->cells[i].c;
@@ -778,6 +827,11 @@ static void ccbuf_apply_attribute(cc_buffer_t *this, cc_attribute_t *attr)
   cc_row_t *rowbuf = &this->rows[this->rowpos];
   int pos = rowbuf->pos;
 
+  if (pos >= CC_COLUMNS) {
+    printf("cc_decoder: ccbuf_apply_attribute: row buffer overflow\n");
+    return;
+  }
+
   rowbuf->attr_chg = 1;
   rowbuf->cells[pos].attributes = *attr;
   /* A midrow attribute always counts as a space */
@@ -802,15 +856,45 @@ static void ccbuf_tab(cc_buffer_t *this, int tabsize)
 
 static void ccbuf_render(cc_renderer_t *renderer, cc_buffer_t *this)
 {
-  int row;
+  int row, reuse = 0;
 
 #ifdef LOG_DEBUG
   printf("cc_decoder: ccbuf_render\n");
 #endif
 
   for (row = 0; row < CC_ROWS; ++row) {
-    if (this->rows[row].num_chars > 0)
-      ccrow_render(renderer, &this->rows[row], row);
+    if (this->rows[row].num_chars > 0 &&
+	ccrow_equal(&renderer->painted[row], &this->rows[row]))
+      reuse++;
+  }
+
+  /* start over when nothing can be kept */
+  if (!reuse) {
+    renderer->osd_renderer->clear(renderer->cap_display);
+    memset(renderer->painted, 0, sizeof(renderer->painted));
+  }
+
+  for (row = 0; row < CC_ROWS; ++row) {
+    cc_painted_row_t *painted = &renderer->painted[row];
+    cc_row_t *rowbuf = &this->rows[row];
+
+    if (ccrow_equal(painted, rowbuf))
+      continue;
+
+    /* remove the old row */
+    if (painted->num_chars > 0)
+      renderer->osd_renderer->filled_rect(renderer->cap_display,
+					  painted->x1, painted->y1,
+					  painted->x2, painted->y2, 0);
+
+    painted->num_chars = rowbuf->num_chars;
+    memcpy(painted->cells, rowbuf->cells, rowbuf->num_chars * sizeof(cc_char_cell_t));
+    painted->x1 = painted->y1 = INT_MAX;
+    painted->x2 = painted->y2 = INT_MIN;
+    if (rowbuf->num_chars > 0)
+      ccrow_render(renderer, rowbuf, row, painted);
+    if (painted->x1 > painted->x2)
+      painted->num_chars = 0;
   }
 }
 
@@ -896,11 +980,47 @@ static int cc_renderer_on_display(cc_renderer_t *this)
 }
 
 
+/* sends the last show or hide request to the OSD */
+static void cc_renderer_flush(cc_renderer_t *this)
+{
+  int64_t vpts = this->pending_vpts;
+
+  switch (this->pending) {
+  case CC_PENDING_SHOW:
+    ccbuf_render(this, this->pending_buf);
+    this->osd_renderer->set_position(this->cap_display,
+				     this->x,
+				     this->y);
+    this->osd_renderer->show(this->cap_display, vpts);
+    this->on_screen = 1;
+    this->display_vpts = vpts;
+    break;
+
+  case CC_PENDING_HIDE:
+    if (this->on_screen)
+      this->osd_renderer->hide(this->cap_display, vpts);
+    this->on_screen = 0;
+    break;
+  }
+
+  this->pending = CC_PENDING_NONE;
+}
+
+
+static void cc_renderer_request(cc_renderer_t *this, int what, int64_t vpts)
+{
+  if (this->pending != CC_PENDING_NONE && this->pending_vpts != vpts)
+    cc_renderer_flush(this);
+  this->pending = what;
+  this->pending_vpts = vpts;
+}
+
+
 static void cc_renderer_hide_caption(cc_renderer_t *this, int64_t vpts)
 {
   if ( ! this->displayed ) return;
 
-  this->osd_renderer->hide(this->cap_display, vpts);
+  cc_renderer_request(this, CC_PENDING_HIDE, vpts);
   this->displayed = 0;
   this->last_hide_vpts = vpts;
 }
@@ -918,16 +1038,11 @@ static void cc_renderer_show_caption(cc_renderer_t *this, cc_buffer_t *buf,
     printf("spucc: cc_renderer: show: OOPS - caption was already displayed!\n");
   }
 
-  this->osd_renderer->clear(this->cap_display);
-  ccbuf_render(this, buf);
-  this->osd_renderer->set_position(this->cap_display,
-				   this->x,
-				   this->y);
   vpts = MAX(vpts, this->last_hide_vpts);
-  this->osd_renderer->show(this->cap_display, vpts);
+  cc_renderer_request(this, CC_PENDING_SHOW, vpts);
+  this->pending_buf = buf;
 
   this->displayed = 1;
-  this->display_vpts = vpts;
 }
 
 
@@ -936,9 +1051,14 @@ static void cc_renderer_free_osd_object(cc_renderer_t *this)
   /* hide and free old displayed caption object if necessary */
   if ( ! this->cap_display ) return;
 
-  cc_renderer_hide_caption(this, this->display_vpts);
+  this->pending = CC_PENDING_NONE;
+  if (this->on_screen)
+    this->osd_renderer->hide(this->cap_display, this->display_vpts);
+  this->on_screen = 0;
+  this->displayed = 0;
   this->osd_renderer->free_object(this->cap_display);
   this->cap_display = NULL;
+  memset(this->painted, 0, sizeof(this->painted));
 }
 
 
@@ -1476,6 +1596,9 @@ void decode_cc(cc_decoder_t *this, uint8_t *buffer, uint32_t buf_len,
     current += skip;
     curbytes += skip;
   }
+
+  /* one OSD update per packet at most */
+  cc_renderer_flush(this->cc_state->renderer);
 }
 
 
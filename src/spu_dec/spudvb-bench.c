@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2010 the xine-project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * spudvb-bench: the table driven pixel code decoder of spudvb.
+ *
+ * Random pixel data sub-blocks, mostly made of 2, 4 and 8 bit pixel code
+ * strings, map tables and end of line codes, are decoded into a region
+ * by the decoder and by the bit at a time decoder it replaced. Reported
+ * are sub-blocks per second for both and whether the regions or the end
+ * positions differ (they must not).
+ * Build with "make spudvb-bench" in this directory.
+ */
+
+/* the decoder functions are static */
+#include "spudvb_decoder.c"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#define MAX_BLOCK  512
+#define MAX_WIDTH  256
+#define MAX_HEIGHT 128
+
+typedef void (*decode_block_t) (dvb_spu_decoder_t *this, int r, int o, int ofs, int n);
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static unsigned int next_rand (unsigned int *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+/*
+ * the decoder as it was, reading one field at a time
+ */
+
+static int ref_bits;
+
+static unsigned char ref_next_datum (dvb_spu_decoder_t * this, int width)
+{
+  dvbsub_func_t *dvbsub = this->dvbsub;
+  unsigned char x = 0;
+
+  if (!ref_bits)
+    ref_bits = 8;
+
+  if (ref_bits < width)
+  {
+    /* need to read from more than one byte; split it up */
+    width -= ref_bits;
+    x = dvbsub->buf[dvbsub->i++] & ((1 << ref_bits) - 1);
+    ref_bits = 8;
+    return x << width | ref_next_datum (this, width);
+  }
+
+  ref_bits = (ref_bits - width) & 7;
+  x = (dvbsub->buf[dvbsub->i] >> ref_bits) & ((1 << width) - 1);
+
+  if (!ref_bits)
+    ++dvbsub->i;
+
+  return x;
+}
+
+static void ref_decode_2bit_pixel_code_string (dvb_spu_decoder_t * this, int r, int n)
+{
+  dvbsub_func_t *dvbsub = this->dvbsub;
+  int j;
+  const uint8_t *lut = lookup_lut (dvbsub, r);
+
+  if (dvbsub->in_scanline == 0)
+    dvbsub->in_scanline = 1;
+
+  ref_bits = 0;
+  j = dvbsub->i + n;
+
+  while (dvbsub->i < j)
+  {
+    int next_bits = ref_next_datum (this, 2);
+    int run_length;
+
+    if (next_bits)
+    {
+      /* single pixel */
+      plot (this, r, 1, lut[next_bits]);
+      continue;
+    }
+
+    /* switch 1 */
+    if (ref_next_datum (this, 1) == 0)
+    {
+      /* run length, 3 to 10 pixels, colour given */
+      run_length = ref_next_datum (this, 3);
+      plot (this, r, run_length + 3, lut[ref_next_datum (this, 2)]);
+      continue;
+    }
+
+    /* switch 2 */
+    if (ref_next_datum (this, 1) == 1)
+    {
+      /* single pixel, colour 0 */
+      plot (this, r, 1, lut[0]);
+      continue;
+    }
+
+    /* switch 3 */
+    switch (ref_next_datum (this, 2))
+    {
+    case 0: /* end-of-string */
+      j = dvbsub->i; /* set the while cause FALSE */
+      break;
+    case 1: /* two pixels, colour 0 */
+      plot (this, r, 2, lut[0]);
+      break;
+    case 2: /* run length, 12 to 27 pixels (4-bit), colour given */
+      run_length = ref_next_datum (this, 4);
+      plot (this, r, run_length + 12, lut[ref_next_datum (this, 2)]);
+      break;
+    case 3: /* run length, 29 to 284 pixels (8-bit), colour given */
+      run_length = ref_next_datum (this, 8);
+      plot (this, r, run_length + 29, lut[ref_next_datum (this, 2)]);
+    }
+  }
+
+  if (ref_bits) {
+    dvbsub->i++;
+    ref_bits = 0;
+  }
+}
+
+static void ref_decode_4bit_pixel_code_string (dvb_spu_decoder_t * this, int r, int n)
+{
+  dvbsub_func_t *dvbsub = this->dvbsub;
+  int j;
+  const uint8_t *lut = lookup_lut (dvbsub, r);
+
+  if (dvbsub->in_scanline == 0)
+    dvbsub->in_scanline = 1;
+
+  ref_bits = 0;
+  j = dvbsub->i + n;
+
+  while (dvbsub->i < j)
+  {
+    int next_bits = ref_next_datum (this, 4);
+    int run_length;
+
+    if (next_bits)
+    {
+      /* single pixel */
+      plot (this, r, 1, lut[next_bits]);
+      continue;
+    }
+
+    /* switch 1 */
+    if (ref_next_datum (this, 1) == 0)
+    {
+      run_length = ref_next_datum (this, 3);
+      if (!run_length)
+	/* end-of-string */
+	break;
+
+      /* run length, 3 to 9 pixels, colour 0 */
+      plot (this, r, run_length + 2, lut[0]);
+      continue;
+    }
+
+    /* switch 2 */
+    if (ref_next_datum (this, 1) == 0)
+    {
+      /* run length, 4 to 7 pixels, colour given */
+      run_length = ref_next_datum (this, 2);
+      plot (this, r, run_length + 4, lut[ref_next_datum (this, 4)]);
+      continue;
+    }
+
+    /* switch 3 */
+    switch (ref_next_datum (this, 2))
+    {
+    case 0: /* single pixel, colour 0 */
+      plot (this, r, 1, lut[0]);
+      break;
+    case 1: /* two pixels, colour 0 */
+      plot (this, r, 2, lut[0]);
+      break;
+    case 2: /* run length, 9 to 24 pixels (4-bit), colour given */
+      run_length = ref_next_datum (this, 4);
+      plot (this, r, run_length + 9, lut[ref_next_datum (this, 4)]);
+      break;
+    case 3: /* run length, 25 to 280 pixels (8-bit), colour given */
+      run_length = ref_next_datum (this, 8);
+      plot (this, r, run_length + 25, lut[ref_next_datum (this, 4)]);
+    }
+  }
+
+  if (ref_bits) {
+    dvbsub->i++;
+    ref_bits = 0;
+  }
+}
+
+/* process_pixel_data_sub_block () with the decoders above */
+static void ref_pixel_data_sub_block (dvb_spu_decoder_t * this, int r, int o, int ofs, int n)
+{
+  int data_type;
+  int j;
+
+  dvbsub_func_t *dvbsub = this->dvbsub;
+
+  j = dvbsub->i + n;
+
+  dvbsub->x = (dvbsub->regions[r].object_pos[o]) >> 16;
+  dvbsub->y = ((dvbsub->regions[r].object_pos[o]) & 0xffff) + ofs;
+  while (dvbsub->i < j) {
+    data_type = dvbsub->buf[dvbsub->i++];
+
+    switch (data_type) {
+    case 0:
+      dvbsub->i++;
+    case 0x10:
+      ref_decode_2bit_pixel_code_string (this, r, n - 1);
+      break;
+    case 0x11:
+      ref_decode_4bit_pixel_code_string (this, r, n - 1);
+      break;
+    case 0x12:
+      decode_8bit_pixel_code_string (this, r, n - 1);
+      break;
+    case 0x20:
+      dvbsub->lut[r].lut24[0] = dvbsub->buf[dvbsub->i    ] >> 4;
+      dvbsub->lut[r].lut24[1] = dvbsub->buf[dvbsub->i    ] & 0x0f;
+      dvbsub->lut[r].lut24[2] = dvbsub->buf[dvbsub->i + 1] >> 4;
+      dvbsub->lut[r].lut24[3] = dvbsub->buf[dvbsub->i + 1] & 0x0f;
+      dvbsub->i += 2;
+      break;
+    case 0x21:
+      memcpy (dvbsub->lut[r].lut28, dvbsub->buf + dvbsub->i, 4);
+      dvbsub->i += 4;
+      break;
+    case 0x22:
+      memcpy (dvbsub->lut[r].lut48, dvbsub->buf + dvbsub->i, 16);
+      dvbsub->i += 16;
+      break;
+    case 0xf0:
+      dvbsub->in_scanline = 0;
+      dvbsub->x = (dvbsub->regions[r].object_pos[o]) >> 16;
+      dvbsub->y += 2;
+      break;
+    }
+  }
+
+  dvbsub->i = j;
+}
+
+/*
+ * test data
+ */
+
+typedef struct {
+  uint8_t  buf[MAX_BLOCK + 8];  /* the decoders may read a little past the end */
+  int      n;
+  int      width, height, depth;
+} block_t;
+
+static void make_block (block_t *b, unsigned int *seed)
+{
+  static const uint8_t types[] = { 0x10, 0x11, 0x12, 0xf0, 0x20, 0x21, 0x22 };
+  static const int depths[] = { 0, 012, 013, 023 };
+  int k;
+
+  b->n      = 1 + next_rand (seed) % (MAX_BLOCK - 1);
+  b->width  = 1 + next_rand (seed) % MAX_WIDTH;
+  b->height = 1 + next_rand (seed) % MAX_HEIGHT;
+  b->depth  = depths[next_rand (seed) % 4];
+
+  for (k = 0; k < b->n + 8; k++)
+    b->buf[k] = next_rand (seed);
+  /* mostly pixel code strings and line ends */
+  for (k = 0; k < b->n; k += 1 + next_rand (seed) % 40)
+    b->buf[k] = types[next_rand (seed) % 7];
+  if (next_rand (seed) % 3 == 0)
+    b->buf[0] = 0x10 + next_rand (seed) % 3;
+}
+
+static void decoder_init (dvb_spu_decoder_t *this, dvbsub_func_t *dvbsub, uint8_t *img)
+{
+  memset (this, 0, sizeof (*this));
+  memset (dvbsub, 0, sizeof (*dvbsub));
+  this->dvbsub = dvbsub;
+  dvbsub->regions[0].img = img;
+  dvbsub->regions[0].object_pos[0] = (3 << 16) | 2;
+}
+
+/* returns the end position, the region is in img */
+static int decode (dvb_spu_decoder_t *this, decode_block_t func, block_t *b, int *empty)
+{
+  dvbsub_func_t *dvbsub = this->dvbsub;
+  region_t *reg = &dvbsub->regions[0];
+
+  memset (reg->img, 7, b->width * b->height);
+  memset (dvbsub->lut, 0, sizeof (dvbsub->lut));
+  reg->width  = b->width;
+  reg->height = b->height;
+  reg->empty  = 1;
+  dvbsub->compat_depth = b->depth;
+  dvbsub->in_scanline  = 0;
+  dvbsub->buf = b->buf;
+  dvbsub->i   = 0;
+
+  func (this, 0, 0, 0, b->n);
+
+  *empty = reg->empty;
+  return dvbsub->i;
+}
+
+int main (int argc, char *argv[])
+{
+  static const struct {
+    const char     *name;
+    decode_block_t  func;
+  } impls[] = {
+    { "tables", process_pixel_data_sub_block },
+    { "bits",   ref_pixel_data_sub_block },
+  };
+  static uint8_t img[2][MAX_WIDTH * MAX_HEIGHT];
+  dvb_spu_decoder_t decoder[2];
+  dvbsub_func_t dvbsub[2];
+  block_t *blocks;
+  int num_blocks = 1000, runs = 200;
+  unsigned int seed = 1;
+  int opt, i, k, same = 1;
+
+  while ((opt = getopt (argc, argv, "b:n:s:")) != -1) {
+    switch (opt) {
+    case 'b':
+      num_blocks = atoi (optarg);
+      break;
+    case 'n':
+      runs = atoi (optarg);
+      break;
+    case 's':
+      seed = atoi (optarg);
+      break;
+    default:
+      fprintf (stderr, "\
+usage: %s [options]\n\
+options:\n\
+  -b BLOCKS	random sub-blocks (default: 1000)\n\
+  -n RUNS	timed runs over all sub-blocks (default: 200)\n\
+  -s SEED	random seed (default: 1)\n", argv[0]);
+      return 1;
+    }
+  }
+  if (num_blocks < 1 || runs < 1) {
+    fputs ("spudvb-bench: invalid option\n", stderr);
+    return 1;
+  }
+
+  blocks = malloc (num_blocks * sizeof (block_t));
+  if (!blocks) {
+    fputs ("spudvb-bench: out of memory\n", stderr);
+    return 1;
+  }
+  for (i = 0; i < num_blocks; i++)
+    make_block (&blocks[i], &seed);
+
+  init_pixel_codes ();
+  for (k = 0; k < 2; k++)
+    decoder_init (&decoder[k], &dvbsub[k], img[k]);
+
+  for (i = 0; i < num_blocks; i++) {
+    int end[2], empty[2];
+
+    for (k = 0; k < 2; k++)
+      end[k] = decode (&decoder[k], impls[k].func, &blocks[i], &empty[k]);
+    if (end[0] != end[1] || empty[0] != empty[1] || memcmp (img[0], img[1], sizeof (img[0])))
+      same = 0;
+  }
+
+  printf ("spudvb-bench: %d sub-blocks, %d runs\n", num_blocks, runs);
+
+  for (k = 0; k < 2; k++) {
+    double t = now ();
+    int run, empty;
+
+    for (run = 0; run < runs; run++)
+      for (i = 0; i < num_blocks; i++)
+        decode (&decoder[k], impls[k].func, &blocks[i], &empty);
+    t = now () - t;
+    printf ("    %-8s %10.0f sub-blocks/s\n", impls[k].name, runs * num_blocks / t);
+  }
+
+  printf ("spudvb-bench: regions: %s\n", same ? "same" : "DIFFERENT");
+
+  free (blocks);
+  return same ? 0 : 1;
+}
@@ -64,6 +64,13 @@ typedef struct {
   unsigned int		object_pos[65536];
   unsigned char	*img;
   osd_object_t          *osd;
+  /* osd cache: img is only rendered again when it was decoded, its CLUT
+     changed or it needs different scaling; show only when redrawn or moved */
+  int			redraw;
+  int			reshow;
+  int			drawn_width;
+  unsigned int		drawn_clut_serial;
+  int			shown, shown_x, shown_y;
 } region_t;
 
 typedef struct {
@@ -74,13 +81,17 @@ typedef struct {
   unsigned int		curr_reg[64];
   uint8_t	       *buf;
   int			i;
-  int			i_bits;
   int			in_scanline;
   int			compat_depth;
   page_t		page;
   region_t		regions[MAX_REGIONS];
   clut_t		colours[MAX_REGIONS*256];
   unsigned char		trans[MAX_REGIONS*256];
+  int			clut_version[MAX_REGIONS];
+  /* bumped on every CLUT change, trans is valid for trans_serial */
+  unsigned int		clut_serial[MAX_REGIONS];
+  unsigned int		trans_serial[MAX_REGIONS];
+  xine_spu_opacity_t	opacity;
   struct {
     unsigned char	  lut24[4], lut28[4], lut48[16];
   }			lut[MAX_REGIONS];
@@ -119,8 +130,21 @@ typedef struct dvb_spu_decoder_s {
   int			show;
 } dvb_spu_decoder_t;
 
+/* One entry per 8 bit prefix of a 2 or 4 bit pixel code: after len bits
+ * follow run_bits of run length extension and colour_bits of colour.
+ * run == 0 is end of string.
+ */
+typedef struct {
+  uint8_t		len;
+  uint8_t		run;
+  uint8_t		run_bits;
+  uint8_t		colour_bits;
+  uint8_t		colour;
+} pixel_code_t;
+
 static clut_t default_clut[256];
 static unsigned char default_trans[256];
+static pixel_code_t pixel_codes_2bit[256], pixel_codes_4bit[256];
 static int default_colours_init = 0;
 
 static void reset_clut (dvbsub_func_t *dvbsub)
@@ -132,6 +156,8 @@ static void reset_clut (dvbsub_func_t *dvbsub)
   {
     memcpy (dvbsub->colours + r * 256, default_clut, sizeof (default_clut));
     memcpy (dvbsub->trans + r * 256, default_trans, sizeof (default_trans));
+    dvbsub->clut_version[r] = -1;
+    dvbsub->clut_serial[r]++;
   }
 
   /* Reset the colour index LUTs */
@@ -174,8 +200,10 @@ static void update_osd(dvb_spu_decoder_t *this, int region_id)
     }
   }
 
-  if ( !reg->osd )
+  if ( !reg->osd ) {
     reg->osd = this->stream->osd_renderer->new_object( this->stream->osd_renderer, reg->width, reg->height );
+    reg->redraw = 1;
+  }
 }
 
 static void update_region (dvb_spu_decoder_t * this, int region_id, int region_width, int region_height, int fill, int fill_color)
@@ -220,30 +248,61 @@ static void update_region (dvb_spu_decoder_t * this, int region_id, int region_w
 }
 
 
-static void do_plot (dvb_spu_decoder_t * this, int r, int x, int y, unsigned char pixel)
+static void plot (dvb_spu_decoder_t * this, int r, int run_length, unsigned char pixel)
 {
-  int i;
   dvbsub_func_t *dvbsub = this->dvbsub;
+  region_t *reg = &dvbsub->regions[r];
+  int size = reg->width * reg->height;
+  int i = (dvbsub->y * reg->width) + dvbsub->x;
+
+  dvbsub->x += run_length;
 
-  i = (y * dvbsub->regions[r].width) + x;
   /* do some clipping */
-  if ( i<(dvbsub->regions[r].width*dvbsub->regions[r].height) ) {
-    dvbsub->regions[r].img[i] = pixel;
-    dvbsub->regions[r].empty = 0;
-  }
+  if ( i>=size )
+    return;
+  if ( run_length>size-i )
+    run_length = size - i;
+  memset( reg->img + i, pixel, run_length );
+  reg->empty = 0;
 }
 
-static void plot (dvb_spu_decoder_t * this, int r, int run_length, unsigned char pixel)
+static void init_pixel_codes (void)
 {
+  int i;
 
-  dvbsub_func_t *dvbsub = this->dvbsub;
-
-  int x2 = dvbsub->x + run_length;
+#define CODE(l, r, rb, cb, col) (pixel_code_t) { l, r, rb, cb, col }
+
+  for (i = 0; i < 256; i++) {
+    /* 2-bit/pixel code string */
+    if (i >> 6)
+      pixel_codes_2bit[i] = CODE (2, 1, 0, 0, i >> 6);              /* single pixel */
+    else if (!(i & 0x20))
+      pixel_codes_2bit[i] = CODE (8, ((i >> 2) & 7) + 3, 0, 0, i & 3); /* 3 to 10 pixels */
+    else if (i & 0x10)
+      pixel_codes_2bit[i] = CODE (4, 1, 0, 0, 0);                  /* single pixel, colour 0 */
+    else switch ((i >> 2) & 3) {
+    case 0: pixel_codes_2bit[i] = CODE (6, 0, 0, 0, 0); break;    /* end-of-string */
+    case 1: pixel_codes_2bit[i] = CODE (6, 2, 0, 0, 0); break;    /* two pixels, colour 0 */
+    case 2: pixel_codes_2bit[i] = CODE (6, 12, 4, 2, 0); break;   /* 12 to 27 pixels */
+    case 3: pixel_codes_2bit[i] = CODE (6, 29, 8, 2, 0); break;   /* 29 to 284 pixels */
+    }
 
-  while (dvbsub->x < x2) {
-    do_plot (this, r, dvbsub->x, dvbsub->y, pixel);
-    dvbsub->x++;
+    /* 4-bit/pixel code string */
+    if (i >> 4)
+      pixel_codes_4bit[i] = CODE (4, 1, 0, 0, i >> 4);              /* single pixel */
+    else if (!(i & 8))
+      pixel_codes_4bit[i] = CODE (8, (i & 7) ? (i & 7) + 2 : 0, 0, 0, 0); /* 3 to 9 pixels, colour 0 / end-of-string */
+    else if (!(i & 4))
+      pixel_codes_4bit[i] = CODE (8, (i & 3) + 4, 0, 4, 0);        /* 4 to 7 pixels */
+    else switch (i & 3) {
+    case 0: pixel_codes_4bit[i] = CODE (8, 1, 0, 0, 0); break;    /* single pixel, colour 0 */
+    case 1: pixel_codes_4bit[i] = CODE (8, 2, 0, 0, 0); break;    /* two pixels, colour 0 */
+    case 2: pixel_codes_4bit[i] = CODE (8, 9, 4, 4, 0); break;    /* 9 to 24 pixels */
+    case 3: pixel_codes_4bit[i] = CODE (8, 25, 8, 4, 0); break;   /* 25 to 280 pixels */
+    }
   }
+
+#undef CODE
 }
 
 static const uint8_t *lookup_lut (const dvbsub_func_t *dvbsub, int r)
@@ -259,170 +318,52 @@ static const uint8_t *lookup_lut (const dvbsub_func_t *dvbsub, int r)
   }
 }
 
-static unsigned char next_datum (dvb_spu_decoder_t * this, int width)
+/* up to 8 bits starting at bit position pos */
+static inline unsigned int peek_bits (const uint8_t *buf, unsigned int pos, int width)
 {
-  dvbsub_func_t *dvbsub = this->dvbsub;
-  unsigned char x = 0;
-
-  if (!dvbsub->i_bits)
-    dvbsub->i_bits = 8;
-
-  if (dvbsub->i_bits < width)
-  {
-    /* need to read from more than one byte; split it up */
-    width -= dvbsub->i_bits;
-    x = dvbsub->buf[dvbsub->i++] & ((1 << dvbsub->i_bits) - 1);
-    dvbsub->i_bits = 8;
-    return x << width | next_datum (this, width);
-  }
-
-  dvbsub->i_bits = (dvbsub->i_bits - width) & 7;
-  x = (dvbsub->buf[dvbsub->i] >> dvbsub->i_bits) & ((1 << width) - 1);
+  unsigned int v = (buf[pos >> 3] << 8) | buf[(pos >> 3) + 1];
 
-  if (!dvbsub->i_bits)
-    ++dvbsub->i;
-
-  return x;
+  return (v >> (16 - (pos & 7) - width)) & ((1 << width) - 1);
 }
 
-static void decode_2bit_pixel_code_string (dvb_spu_decoder_t * this, int r, int object_id, int ofs, int n)
+static void decode_vlc_pixel_code_string (dvb_spu_decoder_t * this, int r, const pixel_code_t *codes, int n)
 {
   dvbsub_func_t *dvbsub = this->dvbsub;
-  int j;
   const uint8_t *lut = lookup_lut (dvbsub, r);
+  const uint8_t *buf = dvbsub->buf;
+  unsigned int pos = dvbsub->i << 3;
+  unsigned int end = (dvbsub->i + n) << 3;
 
   if (dvbsub->in_scanline == 0)
     dvbsub->in_scanline = 1;
 
-  dvbsub->i_bits = 0;
-  j = dvbsub->i + n;
-
-  while (dvbsub->i < j)
+  while (pos < end)
   {
-    int next_bits = next_datum (this, 2);
-    int run_length;
+    const pixel_code_t *code = &codes[peek_bits (buf, pos, 8)];
+    int run_length = code->run;
+    int colour = code->colour;
 
-    if (next_bits)
-    {
-      /* single pixel */
-      plot (this, r, 1, lut[next_bits]);
-      continue;
-    }
-
-    /* switch 1 */
-    if (next_datum (this, 1) == 0)
-    {
-      /* run length, 3 to 10 pixels, colour given */
-      run_length = next_datum (this, 3);
-      plot (this, r, run_length + 3, lut[next_datum (this, 2)]);
-      continue;
-    }
-
-    /* switch 2 */
-    if (next_datum (this, 1) == 1)
-    {
-      /* single pixel, colour 0 */
-      plot (this, r, 1, lut[0]);
-      continue;
-    }
-
-    /* switch 3 */
-    switch (next_datum (this, 2))
-    {
-    case 0: /* end-of-string */
-      j = dvbsub->i; /* set the while cause FALSE */
-      break;
-    case 1: /* two pixels, colour 0 */
-      plot (this, r, 2, lut[0]);
-      break;
-    case 2: /* run length, 12 to 27 pixels (4-bit), colour given */
-      run_length = next_datum (this, 4);
-      plot (this, r, run_length + 12, lut[next_datum (this, 2)]);
+    pos += code->len;
+    if (!run_length)
+      /* end-of-string */
       break;
-    case 3: /* run length, 29 to 284 pixels (8-bit), colour given */
-      run_length = next_datum (this, 8);
-      plot (this, r, run_length + 29, lut[next_datum (this, 2)]);
-    }
-  }
 
-  if (dvbsub->i_bits) {
-    dvbsub->i++;
-    dvbsub->i_bits = 0;
-  }
-}
-
-static void decode_4bit_pixel_code_string (dvb_spu_decoder_t * this, int r, int object_id, int ofs, int n)
-{
-  dvbsub_func_t *dvbsub = this->dvbsub;
-  int j;
-  const uint8_t *lut = lookup_lut (dvbsub, r);
-
-  if (dvbsub->in_scanline == 0)
-    dvbsub->in_scanline = 1;
-
-  dvbsub->i_bits = 0;
-  j = dvbsub->i + n;
-
-  while (dvbsub->i < j)
-  {
-    int next_bits = next_datum (this, 4);
-    int run_length;
-
-    if (next_bits)
-    {
-      /* single pixel */
-      plot (this, r, 1, lut[next_bits]);
-      continue;
-    }
-
-    /* switch 1 */
-    if (next_datum (this, 1) == 0)
-    {
-      run_length = next_datum (this, 3);
-      if (!run_length)
-	/* end-of-string */
-	break;
-
-      /* run length, 3 to 9 pixels, colour 0 */
-      plot (this, r, run_length + 2, lut[0]);
-      continue;
+    if (code->run_bits) {
+      run_length += peek_bits (buf, pos, code->run_bits);
+      pos += code->run_bits;
     }
-
-    /* switch 2 */
-    if (next_datum (this, 1) == 0)
-    {
-      /* run length, 4 to 7 pixels, colour given */
-      run_length = next_datum (this, 2);
-      plot (this, r, run_length + 4, lut[next_datum (this, 4)]);
-      continue;
-    }
-
-    /* switch 3 */
-    switch (next_datum (this, 2))
-    {
-    case 0: /* single pixel, colour 0 */
-      plot (this, r, 1, lut[0]);
-      break;
-    case 1: /* two pixels, colour 0 */
-      plot (this, r, 2, lut[0]);
-      break;
-    case 2: /* run length, 9 to 24 pixels (4-bit), colour given */
-      run_length = next_datum (this, 4);
-      plot (this, r, run_length + 9, lut[next_datum (this, 4)]);
-      break;
-    case 3: /* run length, 25 to 280 pixels (8-bit), colour given */
-      run_length = next_datum (this, 8);
-      plot (this, r, run_length + 25, lut[next_datum (this, 4)]);
+    if (code->colour_bits) {
+      colour = peek_bits (buf, pos, code->colour_bits);
+      pos += code->colour_bits;
     }
+    plot (this, r, run_length, lut[colour]);
   }
 
-  if (dvbsub->i_bits) {
-    dvbsub->i++;
-    dvbsub->i_bits = 0;
-  }
+  /* strings end byte aligned */
+  dvbsub->i = (pos + 7) >> 3;
 }
 
-static void decode_8bit_pixel_code_string (dvb_spu_decoder_t * this, int r, int object_id, int ofs, int n)
+static void decode_8bit_pixel_code_string (dvb_spu_decoder_t * this, int r, int n)
 {
   dvbsub_func_t *dvbsub = this->dvbsub;
   int j;
@@ -468,33 +409,49 @@ static void recalculate_trans (dvb_spu_decoder_t *this)
 {
   dvbsub_func_t *const dvbsub = this->dvbsub;
   xine_spu_opacity_t opacity;
-  int i;
+  int c, i;
 
   _x_spu_get_opacity (this->stream->xine, &opacity);
-  for (i = 0; i < MAX_REGIONS * 256; ++i) {
-    /* ETSI-300-743 says "full transparency if Y == 0". */
-    if (dvbsub->colours[i].y == 0)
-      dvbsub->trans[i] = 0;
-    else {
-      int v = _x_spu_calculate_opacity (&dvbsub->colours[i], dvbsub->colours[i].foo, &opacity);
-      dvbsub->trans[i] = v * 14 / 255 + 1;
-    }
+  if (opacity.black != dvbsub->opacity.black || opacity.colour != dvbsub->opacity.colour) {
+    dvbsub->opacity = opacity;
+    for (c = 0; c < MAX_REGIONS; ++c)
+      dvbsub->clut_serial[c]++;
   }
 
+  for (c = 0; c < MAX_REGIONS; ++c) {
+    if (dvbsub->trans_serial[c] == dvbsub->clut_serial[c])
+      continue;
+    dvbsub->trans_serial[c] = dvbsub->clut_serial[c];
+    for (i = c * 256; i < (c + 1) * 256; ++i) {
+      /* ETSI-300-743 says "full transparency if Y == 0". */
+      if (dvbsub->colours[i].y == 0)
+        dvbsub->trans[i] = 0;
+      else {
+        int v = _x_spu_calculate_opacity (&dvbsub->colours[i], dvbsub->colours[i].foo, &opacity);
+        dvbsub->trans[i] = v * 14 / 255 + 1;
+      }
+    }
+  }
 }
 
 static void set_clut(dvb_spu_decoder_t *this,int CLUT_id,int CLUT_entry_id,int Y_value, int Cr_value, int Cb_value, int T_value) {
 
   dvbsub_func_t *dvbsub = this->dvbsub;
+  clut_t *colour;
 
   if ((CLUT_id>=MAX_REGIONS) || (CLUT_entry_id>255)) {
     return;
   }
 
-  dvbsub->colours[(CLUT_id*256)+CLUT_entry_id].y=Y_value;
-  dvbsub->colours[(CLUT_id*256)+CLUT_entry_id].cr=Cr_value;
-  dvbsub->colours[(CLUT_id*256)+CLUT_entry_id].cb=Cb_value;
-  dvbsub->colours[(CLUT_id*256)+CLUT_entry_id].foo = T_value;
+  colour = &dvbsub->colours[(CLUT_id*256)+CLUT_entry_id];
+  if (colour->y == Y_value && colour->cr == Cr_value && colour->cb == Cb_value && colour->foo == T_value)
+    return;
+
+  colour->y=Y_value;
+  colour->cr=Cr_value;
+  colour->cb=Cb_value;
+  colour->foo = T_value;
+  dvbsub->clut_serial[CLUT_id]++;
 }
 
 static void process_CLUT_definition_segment(dvb_spu_decoder_t *this) {
@@ -524,6 +481,12 @@ static void process_CLUT_definition_segment(dvb_spu_decoder_t *this) {
   CLUT_version_number=(dvbsub->buf[dvbsub->i]&0xf0)>>4;
   dvbsub->i++;
 
+  if (CLUT_id < MAX_REGIONS) {
+    if (CLUT_version_number == dvbsub->clut_version[CLUT_id])
+      return;
+    dvbsub->clut_version[CLUT_id] = CLUT_version_number;
+  }
+
   while (dvbsub->i < j) {
     CLUT_entry_id=dvbsub->buf[dvbsub->i++];
 
@@ -567,13 +530,13 @@ static void process_pixel_data_sub_block (dvb_spu_decoder_t * this, int r, int o
     case 0:
       dvbsub->i++;
     case 0x10:
-      decode_2bit_pixel_code_string (this, r, o, ofs, n - 1);
+      decode_vlc_pixel_code_string (this, r, pixel_codes_2bit, n - 1);
       break;
     case 0x11:
-      decode_4bit_pixel_code_string (this, r, o, ofs, n - 1);
+      decode_vlc_pixel_code_string (this, r, pixel_codes_4bit, n - 1);
       break;
     case 0x12:
-      decode_8bit_pixel_code_string (this, r, o, ofs, n - 1);
+      decode_8bit_pixel_code_string (this, r, n - 1);
       break;
     case 0x20: /* 2-to-4bit colour index map */
       /* should this be implemented since we have an 8-bit overlay? */
@@ -690,6 +653,7 @@ static void process_region_composition_segment (dvb_spu_decoder_t * this)
     return;
 
   dvbsub->regions[region_id].version_number = region_version_number;
+  dvbsub->regions[region_id].redraw = 1;
 
   /* Check if region size has changed and fill background. */
   update_region (this, region_id, region_width, region_height, region_fill_flag, region_4_bit_pixel_code);
@@ -754,6 +718,7 @@ static void process_object_data_segment (dvb_spu_decoder_t * this)
     if (dvbsub->regions[r].img) {
       if (dvbsub->regions[r].object_pos[object_id] != 0xffffffff) {
 	dvbsub->i = old_i;
+	dvbsub->regions[r].redraw = 1;
 	if (object_coding_method == 0) {
 	  top_field_data_block_length = (dvbsub->buf[dvbsub->i] << 8) | dvbsub->buf[dvbsub->i + 1];
 	  dvbsub->i += 2;
@@ -828,6 +793,7 @@ static void* dvbsub_timer_func(void *this_gen)
 	for ( i=0; i<MAX_REGIONS; i++ ) {
 	  if ( this->dvbsub->regions[i].osd ) {
 	    this->stream->osd_renderer->hide( this->dvbsub->regions[i].osd, 0 );
+	    this->dvbsub->regions[i].shown = 0;
 	    lprintf("thread hiding = %d\n",i);
 	  }
 	}
@@ -874,40 +840,64 @@ static void draw_subtitles (dvb_spu_decoder_t * this)
     return;
 
   for (r = 0; r < MAX_REGIONS; r++) {
-    if (this->dvbsub->regions[r].img) {
-      if (this->dvbsub->page.regions[r].is_visible && !this->dvbsub->regions[r].empty) {
-        update_osd( this, r );
-	if ( !this->dvbsub->regions[r].osd )
-	  continue;
-        /* clear osd */
-        this->stream->osd_renderer->clear( this->dvbsub->regions[r].osd );
-        if ( this->dvbsub->regions[r].width>dest_width && !(this->stream->video_driver->get_capabilities(this->stream->video_driver) & VO_CAP_CUSTOM_EXTENT_OVERLAY)) {
-	  downscale_region_image(&this->dvbsub->regions[r], tmp, dest_width);
-	  reg = tmp;
-	  reg_width = dest_width;
-	}
-	else {
-	  reg = this->dvbsub->regions[r].img;
-	  reg_width = this->dvbsub->regions[r].width;
-	}
-	this->stream->osd_renderer->set_palette( this->dvbsub->regions[r].osd, (uint32_t*)(&this->dvbsub->colours[this->dvbsub->regions[r].CLUT_id*256]), &this->dvbsub->trans[this->dvbsub->regions[r].CLUT_id*256]);
-	this->stream->osd_renderer->draw_bitmap( this->dvbsub->regions[r].osd, reg, 0, 0, reg_width, this->dvbsub->regions[r].height, NULL );
-      }
+    region_t *region = &this->dvbsub->regions[r];
+    unsigned int clut_serial;
+
+    if (!region->img || !this->dvbsub->page.regions[r].is_visible || region->empty)
+      continue;
+    update_osd( this, r );
+    if ( !region->osd )
+      continue;
+    if ( region->width>dest_width && !(this->stream->video_driver->get_capabilities(this->stream->video_driver) & VO_CAP_CUSTOM_EXTENT_OVERLAY))
+      reg_width = dest_width;
+    else
+      reg_width = region->width;
+
+    /* unchanged regions keep what was rendered into their osd last time */
+    clut_serial = this->dvbsub->clut_serial[region->CLUT_id];
+    if ( !region->redraw && region->drawn_width==reg_width && region->drawn_clut_serial==clut_serial )
+      continue;
+
+    /* clear osd */
+    this->stream->osd_renderer->clear( region->osd );
+    if ( reg_width!=region->width ) {
+      downscale_region_image(region, tmp, dest_width);
+      reg = tmp;
     }
+    else
+      reg = region->img;
+    this->stream->osd_renderer->set_palette( region->osd, (uint32_t*)(&this->dvbsub->colours[region->CLUT_id*256]), &this->dvbsub->trans[region->CLUT_id*256]);
+    this->stream->osd_renderer->draw_bitmap( region->osd, reg, 0, 0, reg_width, region->height, NULL );
+
+    region->redraw = 0;
+    region->drawn_width = reg_width;
+    region->drawn_clut_serial = clut_serial;
+    region->reshow = 1;
   }
 
   pthread_mutex_lock(&this->dvbsub_osd_mutex);
   lprintf("this->vpts=%"PRId64"\n",this->vpts);
   for ( r=0; r<MAX_REGIONS; r++ ) {
-    lprintf("region=%d, visible=%d, osd=%d, empty=%d\n", r, this->dvbsub->page.regions[r].is_visible, this->dvbsub->regions[r].osd?1:0, this->dvbsub->regions[r].empty );
-    if ( this->dvbsub->page.regions[r].is_visible && this->dvbsub->regions[r].osd && !this->dvbsub->regions[r].empty ) {
-      this->stream->osd_renderer->set_position( this->dvbsub->regions[r].osd, this->dvbsub->page.regions[r].x, this->dvbsub->page.regions[r].y );
-      this->stream->osd_renderer->show( this->dvbsub->regions[r].osd, this->vpts );
+    region_t *region = &this->dvbsub->regions[r];
+    visible_region_t *page_region = &this->dvbsub->page.regions[r];
+
+    lprintf("region=%d, visible=%d, osd=%d, empty=%d\n", r, page_region->is_visible, region->osd?1:0, region->empty );
+    if ( page_region->is_visible && region->osd && !region->empty ) {
+      /* already on screen as it is */
+      if ( region->shown && !region->reshow && region->shown_x==page_region->x && region->shown_y==page_region->y )
+        continue;
+      this->stream->osd_renderer->set_position( region->osd, page_region->x, page_region->y );
+      this->stream->osd_renderer->show( region->osd, this->vpts );
+      region->shown = 1;
+      region->reshow = 0;
+      region->shown_x = page_region->x;
+      region->shown_y = page_region->y;
       lprintf("show region = %d\n",r);
     }
     else {
-      if ( this->dvbsub->regions[r].osd ) {
-        this->stream->osd_renderer->hide( this->dvbsub->regions[r].osd, this->vpts );
+      if ( region->osd && region->shown ) {
+        this->stream->osd_renderer->hide( region->osd, this->vpts );
+        region->shown = 0;
         lprintf("hide region = %d\n",r);
       }
     }
@@ -939,6 +929,7 @@ static void spudec_decode_data (spu_decoder_t * this_gen, buf_element_t * buf)
 	for ( i=0; i<MAX_REGIONS; i++ ) {
 	  if ( this->dvbsub->regions[i].osd )
 	    this->stream->osd_renderer->hide( this->dvbsub->regions[i].osd, 0 );
+	  this->dvbsub->regions[i].shown = 0;
 	}
         pthread_mutex_unlock(&this->dvbsub_osd_mutex);
       }
@@ -1055,6 +1046,7 @@ static void spudec_reset (spu_decoder_t * this_gen)
   for ( i=0; i<MAX_REGIONS; i++ ) {
     if ( this->dvbsub->regions[i].osd )
       this->stream->osd_renderer->hide(this->dvbsub->regions[i].osd, 0);
+    this->dvbsub->regions[i].shown = 0;
     this->dvbsub->regions[i].version_number = -1;
   }
   this->dvbsub->page.page_version_number = -1;
@@ -1128,6 +1120,7 @@ static spu_decoder_t *dvb_spu_class_open_plugin (spu_decoder_class_t * class_gen
       default_trans[i] = a;
       default_clut[i] = YUVA(r, g, b, a);
     }
+    init_pixel_codes ();
     default_colours_init = 1;
   }
 
@@ -1153,6 +1146,8 @@ static spu_decoder_t *dvb_spu_class_open_plugin (spu_decoder_class_t * class_gen
     this->dvbsub->regions[i].img = NULL;
     this->dvbsub->regions[i].osd = NULL;
     this->dvbsub->regions[i].CLUT_id = 0;
+    this->dvbsub->clut_version[i] = -1;
+    this->dvbsub->clut_serial[i] = 1;
   }
 
   {
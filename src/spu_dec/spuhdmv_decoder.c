@@ -61,19 +61,25 @@ enum {
 typedef struct subtitle_clut_s subtitle_clut_t;
 struct subtitle_clut_s {
   uint8_t          id;
+  uint8_t          version;
   uint32_t         color[256];
   uint8_t          trans[256];
   subtitle_clut_t *next;
 
-  int shown;
+  unsigned int serial;  /* changes with content, see overlay_state_t */
 };
 
 /*
  * cached RLE image (xine-lib format)
+ *
+ * Objects stay decoded for the whole epoch.  An object segment carrying
+ * an id and version we already have is not decoded again, so acquisition
+ * points and repeated display sets reuse the cached image.
  */
 typedef struct subtitle_object_s subtitle_object_t;
 struct subtitle_object_s {
   uint16_t    id;
+  uint8_t     version;
   uint16_t    xpos, ypos;
   uint16_t    width, height;
 
@@ -90,7 +96,7 @@ struct subtitle_object_s {
 
   subtitle_object_t *next;
 
-  int shown;
+  unsigned int serial;
 };
 
 /*
@@ -103,8 +109,6 @@ struct window_def_s {
   uint16_t  width, height;
 
   window_def_t *next;
-
-  int shown;
 };
 
 
@@ -124,8 +128,6 @@ struct composition_object_s {
   uint16_t    crop_width, crop_height;
 
   composition_object_t *next;
-
-  int shown;
 };
 
 typedef struct composition_descriptor_s composition_descriptor_t;
@@ -344,7 +346,7 @@ static uint32_t segbuf_get_u24(segment_buffer_t *buf)
  * decode segments
  */
 
-static subtitle_clut_t *segbuf_decode_palette(segment_buffer_t *buf)
+static subtitle_clut_t *segbuf_decode_palette(segment_buffer_t *buf, subtitle_clut_t *cluts)
 {
   uint8_t palette_id             = segbuf_get_u8 (buf);
   uint8_t palette_version_number = segbuf_get_u8 (buf);
@@ -364,9 +366,18 @@ static subtitle_clut_t *segbuf_decode_palette(segment_buffer_t *buf)
   XINE_HDMV_TRACE("decode_palette: %zd items (id %d, version %d)\n",
                   entries, palette_id, palette_version_number);
 
+  /* same version within an epoch means same content */
+  while (cluts && cluts->id != palette_id)
+    cluts = cluts->next;
+  if (cluts && cluts->version == palette_version_number) {
+    XINE_HDMV_TRACE("    palette unchanged, using cached one\n");
+    return NULL;
+  }
+
   /* convert to xine-lib clut */
   subtitle_clut_t *clut = calloc(1, sizeof(subtitle_clut_t));
-  clut->id = palette_id;
+  clut->id      = palette_id;
+  clut->version = palette_version_number;
 
   for (i = 0; i < entries; i++) {
     uint8_t index = segbuf_get_u8 (buf);
@@ -384,7 +395,7 @@ static subtitle_clut_t *segbuf_decode_palette(segment_buffer_t *buf)
 static int segbuf_decode_rle(segment_buffer_t *buf, subtitle_object_t *obj)
 {
   int x = 0, y = 0;
-  int rle_size = sizeof(rle_elem_t) * obj->width / 16 * obj->height + 1;
+  int rle_size = sizeof(rle_elem_t) * (obj->width / 16 * obj->height + 1);
   rle_elem_t *rlep = malloc(rle_size);
 
   free (obj->rle);
@@ -460,6 +471,7 @@ static subtitle_object_t *segbuf_decode_object(segment_buffer_t *buf, subtitle_o
     subtitle_object_t *obj = calloc(1, sizeof(subtitle_object_t));
 
     obj->id       = object_id;
+    obj->version  = version;
     obj->data_len = segbuf_get_u24(buf);
     obj->width    = segbuf_get_u16(buf);
     obj->height   = segbuf_get_u16(buf);
@@ -472,6 +484,19 @@ static subtitle_object_t *segbuf_decode_object(segment_buffer_t *buf, subtitle_o
 
     obj->data_len -= 4; /* width, height parsed */
 
+    /* already have this one decoded ? */
+    while (objects && objects->id != object_id)
+      objects = objects->next;
+    if (objects && objects->rle && !objects->raw_data &&
+        objects->version  == obj->version  &&
+        objects->width    == obj->width    &&
+        objects->height   == obj->height   &&
+        objects->data_len == obj->data_len) {
+      XINE_HDMV_TRACE("    object %d version %d cached, skipping RLE data\n", object_id, version);
+      free_subtitle_object(obj);
+      return NULL;
+    }
+
     XINE_HDMV_TRACE("    object length %d bytes, size %dx%d\n", obj->data_len, obj->width, obj->height);
 
     if (obj->data_len > segbuf_data_length(buf)) {
@@ -512,6 +537,12 @@ static subtitle_object_t *segbuf_decode_object(segment_buffer_t *buf, subtitle_o
     return NULL;
   }
 
+  /* rest of a cached object */
+  if (!objects->raw_data) {
+    XINE_HDMV_TRACE("    object %d already decoded, discarding segment\n", object_id);
+    return NULL;
+  }
+
   /* store partial RLE data in HDMV format */
   if (objects->raw_data_size < objects->raw_data_len + segbuf_data_length(buf)) {
     XINE_HDMV_ERROR("object larger than object size !\n");
@@ -652,8 +683,9 @@ static rle_elem_t *copy_crop_rle(subtitle_object_t *obj, composition_object_t *c
 {
   /* TODO: cropping (w,h sized image from pos x,y) */
 
-  rle_elem_t *rle = calloc (obj->num_rle, sizeof(rle_elem_t));
-  memcpy (rle, obj->rle, obj->num_rle * sizeof(rle_elem_t));
+  rle_elem_t *rle = malloc (obj->num_rle * sizeof(rle_elem_t));
+  if (rle)
+    memcpy (rle, obj->rle, obj->num_rle * sizeof(rle_elem_t));
   return rle;
 }
 
@@ -666,6 +698,19 @@ typedef struct {
   spu_decoder_class_t decoder_class;
 } spuhdmv_class_t;
 
+/*
+ * what is on screen for one overlay handle.  Serials identify object
+ * and palette content, so a display set that only repeats what is
+ * already shown does not send anything to the overlay manager.
+ */
+typedef struct {
+  int          visible;
+  unsigned int object_serial;
+  unsigned int clut_serial;
+  uint16_t     object_id;
+  uint16_t     x, y;
+} overlay_state_t;
+
 typedef struct spuhdmv_decoder_s {
   spu_decoder_t    spu_decoder;
 
@@ -680,6 +725,9 @@ typedef struct spuhdmv_decoder_s {
   presentation_segment_t *segments;
 
   int overlay_handles[MAX_OBJECTS];
+  overlay_state_t overlays[MAX_OBJECTS];
+
+  unsigned int serial;
 
   int64_t               pts;
 
@@ -696,10 +744,12 @@ static void free_objs(spuhdmv_decoder_t *this)
 static int decode_palette(spuhdmv_decoder_t *this)
 {
   /* decode */
-  subtitle_clut_t *clut = segbuf_decode_palette(this->buf);
+  subtitle_clut_t *clut = segbuf_decode_palette(this->buf, this->cluts);
   if (!clut)
     return 1;
 
+  clut->serial = ++this->serial;
+
   LIST_REPLACE (this->cluts, clut, free);
 
   return 0;
@@ -712,6 +762,8 @@ static int decode_object(spuhdmv_decoder_t *this)
   if (!obj)
     return 1;
 
+  obj->serial = ++this->serial;
+
   LIST_REPLACE (this->objects, obj, free_subtitle_object);
 
   return 0;
@@ -738,8 +790,11 @@ static int decode_presentation_segment(spuhdmv_decoder_t *this)
 
   seg->pts = this->pts;
 
-  /* epoch start or acquistion point -> drop cached objects */
-  if (seg->comp_descr.state) {
+  /* epoch start -> drop cached objects.
+   * acquisition points repeat the epoch's palettes and objects with
+   * unchanged versions, keep them so they need not be decoded again.
+   */
+  if (seg->comp_descr.state & 0x80) {
     free_objs(this);
   }
 
@@ -751,67 +806,67 @@ static int decode_presentation_segment(spuhdmv_decoder_t *this)
   return 0;
 }
 
-static int show_overlay(spuhdmv_decoder_t *this, composition_object_t *cobj, unsigned int palette_id_ref,
-                        int overlay_index, int64_t pts, int force_update)
+static subtitle_clut_t *find_clut(spuhdmv_decoder_t *this, unsigned int palette_id_ref)
 {
-  video_overlay_manager_t *ovl_manager = this->stream->video_out->get_overlay_manager(this->stream->video_out);
-  metronom_t              *metronom    = this->stream->metronom;
-  video_overlay_event_t    event       = {0};
-  vo_overlay_t             overlay     = {0};
-
-  /* find palette */
   subtitle_clut_t *clut = this->cluts;
   while (clut && clut->id != palette_id_ref)
     clut = clut->next;
-  if (!clut) {
+  if (!clut)
     XINE_HDMV_TRACE("  show_overlay: clut %d not found !\n", palette_id_ref);
-    return -1;
-  }
+  return clut;
+}
 
-  /* find RLE image */
+static subtitle_object_t *find_object(spuhdmv_decoder_t *this, unsigned int object_id_ref)
+{
   subtitle_object_t *obj = this->objects;
-  while (obj && obj->id != cobj->object_id_ref)
+  while (obj && obj->id != object_id_ref)
     obj = obj->next;
   if (!obj) {
-    XINE_HDMV_TRACE("  show_overlay: object %d not found !\n", cobj->object_id_ref);
-    return -1;
+    XINE_HDMV_TRACE("  show_overlay: object %d not found !\n", object_id_ref);
+    return NULL;
   }
   if (!obj->rle) {
-    XINE_HDMV_TRACE("  show_overlay: object %d RLE data not decoded !\n", cobj->object_id_ref);
-    return -1;
+    XINE_HDMV_TRACE("  show_overlay: object %d RLE data not decoded !\n", object_id_ref);
+    return NULL;
   }
+  return obj;
+}
 
-  /* find window */
-  window_def_t *wnd = this->windows;
-  while (wnd && wnd->id != cobj->window_id_ref)
-    wnd = wnd->next;
-  if (!wnd) {
-    XINE_HDMV_TRACE("  show_overlay: window %d not found !\n", cobj->window_id_ref);
-    return -1;
-  }
+static void send_overlay(spuhdmv_decoder_t *this, subtitle_clut_t *clut, subtitle_object_t *obj,
+                         composition_object_t *cobj, int x, int y, int overlay_index, int64_t pts)
+{
+  video_overlay_manager_t *ovl_manager = this->stream->video_out->get_overlay_manager(this->stream->video_out);
+  metronom_t              *metronom    = this->stream->metronom;
+  overlay_state_t         *state       = &this->overlays[overlay_index];
+  video_overlay_event_t    event       = {0};
+  vo_overlay_t             overlay     = {0};
 
   /* do not show again if all elements are unchanged */
-  if (!force_update && clut->shown && obj->shown && wnd->shown && cobj->shown)
-    return 0;
-  clut->shown = obj->shown = wnd->shown = cobj->shown = 1;
+  if (state->visible &&
+      state->object_serial == obj->serial && state->clut_serial == clut->serial &&
+      state->x == x && state->y == y)
+    return;
 
   /* copy palette to xine overlay */
   overlay.rgb_clut = 0;
   memcpy(overlay.color, clut->color, sizeof(uint32_t) * 256);
   memcpy(overlay.trans, clut->trans, sizeof(uint8_t)  * 256);
 
-  /* copy and crop RLE image to xine overlay */
+  /* copy and crop RLE image to xine overlay.
+   * the overlay manager takes the copy, our decoded object stays cached. */
   overlay.width     = obj->width;
   overlay.height    = obj->height;
 
   overlay.rle       = copy_crop_rle (obj, cobj);
+  if (!overlay.rle)
+    return;
   overlay.num_rle   = obj->num_rle;
   overlay.data_size = obj->num_rle * sizeof(rle_elem_t);
 
   /* */
 
-  overlay.x = /*wnd->xpos +*/ cobj->xpos;
-  overlay.y = /*wnd->ypos +*/ cobj->ypos;
+  overlay.x = /*wnd->xpos +*/ x;
+  overlay.y = /*wnd->ypos +*/ y;
 
   overlay.unscaled    = 0;
   overlay.hili_top    = -1;
@@ -845,31 +900,88 @@ static int show_overlay(spuhdmv_decoder_t *this, composition_object_t *cobj, uns
 
   ovl_manager->add_event (ovl_manager, (void *)&event);
 
+  state->visible       = 1;
+  state->object_serial = obj->serial;
+  state->clut_serial   = clut->serial;
+  state->object_id     = obj->id;
+  state->x             = x;
+  state->y             = y;
+}
+
+static int show_overlay(spuhdmv_decoder_t *this, composition_object_t *cobj, unsigned int palette_id_ref,
+                        int overlay_index, int64_t pts)
+{
+  /* find palette */
+  subtitle_clut_t *clut = find_clut(this, palette_id_ref);
+  if (!clut)
+    return -1;
+
+  /* find RLE image */
+  subtitle_object_t *obj = find_object(this, cobj->object_id_ref);
+  if (!obj)
+    return -1;
+
+  /* find window */
+  window_def_t *wnd = this->windows;
+  while (wnd && wnd->id != cobj->window_id_ref)
+    wnd = wnd->next;
+  if (!wnd) {
+    XINE_HDMV_TRACE("  show_overlay: window %d not found !\n", cobj->window_id_ref);
+    return -1;
+  }
+
+  send_overlay(this, clut, obj, cobj, cobj->xpos, cobj->ypos, overlay_index, pts);
+
   return 0;
 }
 
-static void hide_overlays(spuhdmv_decoder_t *this, int64_t pts)
+/*
+ * palette update only (fades, colour cycling): composition and objects
+ * are the ones on screen, just send them again with the new palette.
+ */
+static void update_palette(spuhdmv_decoder_t *this, presentation_segment_t *pseg)
+{
+  subtitle_clut_t *clut = find_clut(this, pseg->palette_id_ref);
+  int i;
+
+  if (!clut)
+    return;
+
+  for (i = 0; i < MAX_OBJECTS; i++) {
+    overlay_state_t *state = &this->overlays[i];
+    subtitle_object_t *obj;
+
+    if (!state->visible || state->clut_serial == clut->serial)
+      continue;
+
+    obj = find_object(this, state->object_id);
+    if (obj)
+      send_overlay(this, clut, obj, NULL, state->x, state->y, i, pseg->pts);
+  }
+}
+
+static void hide_overlays(spuhdmv_decoder_t *this, int first, int64_t pts)
 {
   video_overlay_event_t event = {0};
-  int i = 0;
+  int i;
+
+  for (i = first; i < MAX_OBJECTS && this->overlay_handles[i] >= 0; i++) {
+
+    if (!this->overlays[i].visible)
+      continue;
 
-  while (this->overlay_handles[i] >= 0) {
     XINE_HDMV_TRACE("    -> HIDE %d\n", i);
 
     video_overlay_manager_t *ovl_manager = this->stream->video_out->get_overlay_manager(this->stream->video_out);
     metronom_t              *metronom    = this->stream->metronom;
 
     event.object.handle = this->overlay_handles[i];
-    if (this)
-      event.vpts = metronom->got_spu_packet (metronom, pts);
-    else
-      event.vpts = 0;
+    event.vpts = metronom->got_spu_packet (metronom, pts);
     event.event_type = OVERLAY_EVENT_HIDE;
     event.object.overlay = NULL;
     ovl_manager->add_event (ovl_manager, (void *)&event);
 
-    //this->overlay_handles[i] = -1;
-    i++;
+    this->overlays[i].visible = 0;
   }
 }
 
@@ -883,7 +995,13 @@ static void update_overlays(spuhdmv_decoder_t *this)
 
       /* HIDE */
       if (!pseg->shown)
-        hide_overlays (this, pseg->pts);
+        hide_overlays (this, 0, pseg->pts);
+
+    } else if (pseg->palette_update_flag) {
+
+      /* palette only. the palette segment follows the presentation
+       * segment, so check again after each segment. */
+      update_palette (this, pseg);
 
     } else {
 
@@ -891,14 +1009,17 @@ static void update_overlays(spuhdmv_decoder_t *this)
       composition_object_t *cobj = pseg->comp_objs;
       int i;
 
-      for (i = 0; i < pseg->object_number; i++) {
+      for (i = 0; i < pseg->object_number && i < MAX_OBJECTS; i++) {
         if (!cobj) {
           XINE_HDMV_ERROR("show_overlays: composition object %d missing !\n", i);
         } else {
-          show_overlay(this, cobj, pseg->palette_id_ref, i, pseg->pts, !pseg->shown);
+          show_overlay(this, cobj, pseg->palette_id_ref, i, pseg->pts);
           cobj = cobj->next;
         }
       }
+
+      /* objects left over from a previous composition */
+      hide_overlays (this, i, pseg->pts);
     }
 
     pseg->shown = 1;
@@ -955,9 +1076,10 @@ static void close_osd(spuhdmv_decoder_t *this)
   video_overlay_manager_t *ovl_manager = this->stream->video_out->get_overlay_manager (this->stream->video_out);
 
   int i = 0;
-  while (this->overlay_handles[i] >= 0) {
+  while (i < MAX_OBJECTS && this->overlay_handles[i] >= 0) {
     ovl_manager->free_handle(ovl_manager, this->overlay_handles[i]);
     this->overlay_handles[i] = -1;
+    this->overlays[i].visible = 0;
     i++;
   }
 }
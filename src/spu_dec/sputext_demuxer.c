@@ -40,6 +40,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
 
 #define LOG_MODULE "demux_sputext"
 #define LOG_VERBOSE
@@ -56,6 +58,8 @@
 #define SUB_BUFSIZE   1024
 #define LINE_LEN      1000
 #define LINE_LEN_QUOT "1000"
+#define SUB_READ_SIZE 16384 /* input is read in blocks of this size */
+#define SUB_CACHE_MAX 4     /* parsed files kept after their last user closed */
 
 /*
  *  Demuxer typedefs
@@ -72,6 +76,29 @@ typedef struct {
 
 } subtitle_t;
 
+/*
+ * a parsed subtitle file, possibly shared by several streams
+ */
+typedef struct sub_data_s {
+
+  struct sub_data_s *next;
+  int                refs;
+  int                cached;         /* linked into the class cache */
+
+  char              *mrl;
+  off_t              size;
+  time_t             mtime;
+  int                timeout;
+
+  int                uses_time;
+  int                errs;
+  int                num;            /* number of subtitle structs */
+  subtitle_t        *subtitles;      /* in file order              */
+  long              *end_max;        /* latest end of subtitles[0..n], for seeking */
+  long               length;
+
+} sub_data_t;
+
 
 typedef struct {
 
@@ -81,8 +108,10 @@ typedef struct {
 
   int                status;
 
-  char               buf[SUB_BUFSIZE];
-  off_t              buflen;
+  char              *buf;            /* input read ahead */
+  size_t             bufsize, buflen, bufpos;
+  int                eof;
+  int                detecting;      /* keep everything read for the parser */
 
   float              mpsub_position;
 
@@ -94,6 +123,8 @@ typedef struct {
   int                format;         /* constants see below        */
   char               next_line[SUB_BUFSIZE]; /* a buffer for next line read from file */
 
+  sub_data_t        *data;
+
 } demux_sputext_t;
 
 typedef struct demux_sputext_class_s {
@@ -102,6 +133,10 @@ typedef struct demux_sputext_class_s {
 
   int                max_timeout;  /* default timeout of hidding subtitles */
 
+  int                use_cache;
+  pthread_mutex_t    cache_lock;
+  sub_data_t        *cache;        /* most recently used first */
+
 } demux_sputext_class_t;
 
 /*
@@ -142,40 +177,61 @@ static inline void trail_space(char *s) {
 }
 
 /*
- * Reimplementation of fgets() using the input->read() method.
+ * read the next block of input
  */
-static char *read_line_from_input(demux_sputext_t *this, char *line, off_t len) {
-  off_t nread = 0;
-  char *s;
-  int linelen;
-
-  if ((len - this->buflen) > 512 && len < SUB_BUFSIZE) {
-    if((nread = this->input->read(this->input,
-				  &this->buf[this->buflen], len - this->buflen)) < 0) {
-      xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG, "read failed.\n");
-      return NULL;
-    }
+static void sub_fill_buffer(demux_sputext_t *this) {
+  off_t nread;
+
+  if (this->bufpos && !this->detecting) {
+    memmove(this->buf, this->buf + this->bufpos, this->buflen - this->bufpos);
+    this->buflen -= this->bufpos;
+    this->bufpos = 0;
   }
 
-  this->buflen += nread;
-  this->buf[this->buflen] = '\0';
+  if (this->bufsize < this->buflen + SUB_READ_SIZE) {
+    char *buf = realloc(this->buf, this->buflen + SUB_READ_SIZE);
+    if (!buf) {
+      this->eof = 1;
+      return;
+    }
+    this->buf = buf;
+    this->bufsize = this->buflen + SUB_READ_SIZE;
+  }
 
-  s = strchr(this->buf, '\n');
+  nread = this->input->read(this->input, this->buf + this->buflen, SUB_READ_SIZE);
+  if (nread < 0)
+    xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG, "read failed.\n");
+  if (nread <= 0)
+    this->eof = 1;
+  else
+    this->buflen += nread;
+}
 
-  if (line && (s || this->buflen)) {
+/*
+ * Reimplementation of fgets() using the input->read() method.
+ * Lines longer than len are returned in pieces.
+ */
+static char *read_line_from_input(demux_sputext_t *this, char *line, off_t len) {
+  char *start, *s;
+  size_t avail;
+  off_t linelen;
 
-    linelen = s ? (s - this->buf) + 1 : this->buflen;
+  while (this->buflen - this->bufpos < (size_t)len && !this->eof)
+    sub_fill_buffer(this);
 
-    memcpy(line, this->buf, linelen);
-    line[linelen] = '\0';
+  avail = this->buflen - this->bufpos;
+  if (!line || !avail)
+    return NULL;
 
-    memmove(this->buf, &this->buf[linelen], SUB_BUFSIZE - linelen);
-    this->buflen -= linelen;
+  start = this->buf + this->bufpos;
+  s = memchr(start, '\n', avail < (size_t)len ? avail : (size_t)len);
+  linelen = s ? (s - start) + 1 : (avail < (size_t)len ? (off_t)avail : len);
 
-    return line;
-  }
+  memcpy(line, start, linelen);
+  line[linelen] = '\0';
+  this->bufpos += linelen;
 
-  return NULL;
+  return line;
 }
 
 
@@ -700,7 +756,7 @@ static subtitle_t *sub_read_line_aqt (demux_sputext_t *this, subtitle_t *current
 }
 
 static subtitle_t *sub_read_line_jacobsub(demux_sputext_t *this, subtitle_t *current) {
-    char line1[LINE_LEN], line2[LINE_LEN], directive[LINE_LEN], *p, *q;
+    char line1[LINE_LEN + 1], line2[LINE_LEN + 1], directive[LINE_LEN + 1], *p, *q;
     unsigned a1, a2, a3, a4, b1, b2, b3, b4, comment = 0;
     static unsigned jacoTimeres = 30;
     static int jacoShift = 0;
@@ -1131,9 +1187,16 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
     xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "seek failed.\n");
     return NULL;
   }
-  this->buflen = 0;
+  this->buflen = this->bufpos = 0;
+  this->eof = 0;
 
+  /* the lines looked at for detection stay buffered, so the parser can
+   * start over without reading the input again
+   */
+  this->detecting = 1;
   this->format=sub_autodetect (this);
+  this->detecting = 0;
+  this->bufpos = 0;
   if (this->format==FORMAT_UNKNOWN) {
     xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "Could not determine file format\n");
     return NULL;
@@ -1141,13 +1204,6 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
 
   xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "Detected subtitle file format: %d\n",this->format);
 
-  /* Rewind */
-  if(this->input->seek(this->input, 0, SEEK_SET) == -1) {
-    xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "seek failed.\n");
-    return NULL;
-  }
-  this->buflen = 0;
-
   this->num=0;n_max=32;
   first = calloc(n_max, sizeof(subtitle_t));
   if(!first) return NULL;
@@ -1210,18 +1266,171 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
   return first;
 }
 
+static void sub_data_free (sub_data_t *data) {
+  int i, l;
+
+  for (i = 0; i < data->num; i++) {
+    for (l = 0; l < data->subtitles[i].lines; l++)
+      free(data->subtitles[i].text[l]);
+  }
+  free(data->subtitles);
+  free(data->end_max);
+  free(data->mrl);
+  free(data);
+}
+
+/*
+ * take over the subtitles just read and index them for seeking
+ */
+static sub_data_t *sub_data_new (demux_sputext_t *this, subtitle_t *subtitles,
+                                 const char *mrl, off_t size, time_t mtime, int timeout) {
+  sub_data_t *data;
+  long end_max;
+  int i;
+
+  data = calloc(1, sizeof(sub_data_t));
+  if (!data)
+    return NULL;
+  data->mrl       = strdup(mrl);
+  data->size      = size;
+  data->mtime     = mtime;
+  data->timeout   = timeout;
+  data->uses_time = this->uses_time;
+  data->errs      = this->errs;
+  data->num       = this->num;
+  data->subtitles = subtitles;
+  data->end_max   = malloc((this->num + 1) * sizeof(long));
+  data->refs      = 1;
+  if (!data->mrl || !data->end_max) {
+    sub_data_free(data);
+    return NULL;
+  }
+
+  /* end_max never decreases, even for unsorted files.
+   * a subtitle without end time stays until the end */
+  end_max = -1;
+  for (i = 0; i < data->num; i++) {
+    long end = data->subtitles[i].end;
+    if (end > data->length)
+      data->length = end;
+    if (end == -1)
+      end = LONG_MAX;
+    if (end > end_max)
+      end_max = end;
+    data->end_max[i] = end_max;
+  }
+
+  return data;
+}
+
+/*
+ * modification time of the file behind mrl, 0 if it is not a local file.
+ * the mrl is decoded like input_file does.
+ */
+static time_t sub_mrl_mtime (const char *mrl) {
+  struct stat st;
+  char *filename;
+  int ret;
+
+  if (strncasecmp (mrl, "file:/", 6) == 0) {
+    if ((strncasecmp (mrl, "file://localhost/", 16) == 0) ||
+        (strncasecmp (mrl, "file://127.0.0.1/", 16) == 0))
+      filename = strdup(mrl + 16);
+    else
+      filename = strdup(mrl + 5);
+    if (filename)
+      _x_mrl_unescape (filename);
+  } else
+    filename = strdup(mrl);
+  if (!filename)
+    return 0;
+
+  ret = stat(filename, &st);
+  free(filename);
+  if (ret || !S_ISREG(st.st_mode))
+    return 0;
+  return st.st_mtime ? st.st_mtime : 1;
+}
+
+static sub_data_t *sub_cache_get (demux_sputext_class_t *class, const char *mrl, off_t size,
+                                  time_t mtime, int timeout) {
+  sub_data_t *data, **prev;
+
+  pthread_mutex_lock(&class->cache_lock);
+  for (prev = &class->cache; (data = *prev); prev = &data->next) {
+    if (data->size == size && data->mtime == mtime && data->timeout == timeout &&
+        !strcmp(data->mrl, mrl)) {
+      data->refs++;
+      /* move to front */
+      *prev = data->next;
+      data->next = class->cache;
+      class->cache = data;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&class->cache_lock);
+
+  return data;
+}
+
+/*
+ * add freshly read subtitles to the cache, returns what is to be used
+ * if another stream was faster
+ */
+static sub_data_t *sub_cache_add (demux_sputext_class_t *class, sub_data_t *data) {
+  sub_data_t *cached = sub_cache_get(class, data->mrl, data->size, data->mtime, data->timeout);
+
+  if (cached) {
+    sub_data_free(data);
+    return cached;
+  }
+
+  pthread_mutex_lock(&class->cache_lock);
+  data->cached = 1;
+  data->next = class->cache;
+  class->cache = data;
+  pthread_mutex_unlock(&class->cache_lock);
+
+  return data;
+}
+
+static void sub_data_release (demux_sputext_class_t *class, sub_data_t *data) {
+  sub_data_t **prev;
+  int unused = 0;
+
+  pthread_mutex_lock(&class->cache_lock);
+  if (--data->refs || !data->cached) {
+    pthread_mutex_unlock(&class->cache_lock);
+    if (!data->refs)
+      sub_data_free(data);
+    return;
+  }
+
+  /* drop the least recently used files nobody plays */
+  prev = &class->cache;
+  while ((data = *prev)) {
+    if (!data->refs && ++unused > SUB_CACHE_MAX) {
+      *prev = data->next;
+      sub_data_free(data);
+    } else
+      prev = &data->next;
+  }
+  pthread_mutex_unlock(&class->cache_lock);
+}
+
 static int demux_sputext_next (demux_sputext_t *this_gen) {
   demux_sputext_t *this = (demux_sputext_t *) this_gen;
+  sub_data_t *data = this->data;
   buf_element_t *buf;
   uint32_t *val;
   char *str;
   subtitle_t *sub;
   int line;
 
-  if (this->cur >= this->num)
+  if (this->cur >= data->num)
     return 0;
 
-  sub = &this->subtitles[this->cur];
+  sub = &data->subtitles[this->cur];
 
   buf = this->stream->video_fifo->buffer_pool_alloc(this->stream->video_fifo);
   buf->type = BUF_SPU_TEXT;
@@ -1229,9 +1438,9 @@ static int demux_sputext_next (demux_sputext_t *this_gen) {
 
   val = (uint32_t * )buf->content;
   *val++ = sub->lines;
-  *val++ = this->uses_time;
-  *val++ = (this->uses_time) ? sub->start * 10 : sub->start;
-  *val++ = (this->uses_time) ? sub->end * 10 : sub->end;
+  *val++ = data->uses_time;
+  *val++ = (data->uses_time) ? sub->start * 10 : sub->start;
+  *val++ = (data->uses_time) ? sub->end * 10 : sub->end;
   str = (char *)val;
   for (line = 0; line < sub->lines; line++, str+=strlen(str)+1) {
     strncpy(str, sub->text[line], SUB_BUFSIZE-1);
@@ -1246,13 +1455,8 @@ static int demux_sputext_next (demux_sputext_t *this_gen) {
 
 static void demux_sputext_dispose (demux_plugin_t *this_gen) {
   demux_sputext_t *this = (demux_sputext_t *) this_gen;
-  int i, l;
 
-  for (i = 0; i < this->num; i++) {
-    for (l = 0; l < this->subtitles[i].lines; l++)
-      free(this->subtitles[i].text[l]);
-  }
-  free(this->subtitles);
+  sub_data_release((demux_sputext_class_t *)this->demux_plugin.demux_class, this->data);
   free(this);
 }
 
@@ -1264,8 +1468,8 @@ static int demux_sputext_get_status (demux_plugin_t *this_gen) {
 static int demux_sputext_get_stream_length (demux_plugin_t *this_gen) {
   demux_sputext_t   *this = (demux_sputext_t *) this_gen;
 
-  if( this->uses_time && this->num ) {
-    return this->subtitles[this->num-1].end * 10;
+  if( this->data->uses_time && this->data->num ) {
+    return this->data->length * 10;
   } else {
     return 0;
   }
@@ -1284,13 +1488,31 @@ static int demux_sputext_send_chunk (demux_plugin_t *this_gen) {
 static int demux_sputext_seek (demux_plugin_t *this_gen,
                             off_t start_pos, int start_time, int playing) {
   demux_sputext_t *this = (demux_sputext_t*)this_gen;
+  sub_data_t *data = this->data;
 
   lprintf("seek() called\n");
 
-  /* simple seeking approach: just go back to start.
+  /* skip the subtitles that all ended before the seek target.
    * decoder will discard subtitles until the desired position.
+   * frame based formats need the video frame rate, go back to start.
    */
   this->cur = 0;
+  if (data->uses_time && data->num) {
+    long time = start_time / 10;
+    int lo = 0, hi = data->num;
+
+    if (!start_time && start_pos)
+      time = (int64_t)data->length * start_pos / 65535;
+
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (data->end_max[mid] > time)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    this->cur = lo;
+  }
   this->status = DEMUX_OK;
 
   _x_demux_flush_engine (this->stream);
@@ -1360,8 +1582,6 @@ static demux_plugin_t *open_demux_plugin (demux_class_t *class_gen, xine_stream_
   this->demux_plugin.get_optional_data = demux_sputext_get_optional_data;
   this->demux_plugin.demux_class       = class_gen;
 
-  this->buflen = 0;
-
   switch (stream->content_detection_method) {
   case METHOD_BY_MRL:
     {
@@ -1392,17 +1612,36 @@ static demux_plugin_t *open_demux_plugin (demux_class_t *class_gen, xine_stream_
      */
 
     if ((input->get_capabilities(input) & INPUT_CAP_SEEKABLE) != 0) {
-
-      this->subtitles = sub_read_file (this);
+      demux_sputext_class_t *class = (demux_sputext_class_t *)class_gen;
+      const char *mrl = input->get_mrl(input);
+      off_t size = input->get_length(input);
+      int timeout = class->max_timeout;
+      /* only local files can be checked for changes */
+      time_t mtime = class->use_cache ? sub_mrl_mtime(mrl) : 0;
 
       this->cur = 0;
 
+      if (mtime && (this->data = sub_cache_get(class, mrl, size, mtime, timeout))) {
+        xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "using cached subtitles.\n");
+        return &this->demux_plugin;
+      }
+
+      this->subtitles = sub_read_file (this);
+      free (this->buf);
+      this->buf = NULL;
+
       if (this->subtitles) {
         xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "subtitle format %s time.\n",
 		 this->uses_time ? "uses" : "doesn't use");
         xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG,
 		 "read %i subtitles, %i errors.\n", this->num, this->errs);
-        return &this->demux_plugin;
+
+        this->data = sub_data_new (this, this->subtitles, mrl, size, mtime, timeout);
+        if (this->data) {
+          if (mtime)
+            this->data = sub_cache_add (class, this->data);
+          return &this->demux_plugin;
+        }
       }
     }
     /* falling through is intended */
@@ -1418,6 +1657,25 @@ static void config_timeout_cb(void *this_gen, xine_cfg_entry_t *entry) {
   this->max_timeout = entry->num_value;
 }
 
+static void config_cache_cb(void *this_gen, xine_cfg_entry_t *entry) {
+  demux_sputext_class_t *this = (demux_sputext_class_t *)this_gen;
+
+  this->use_cache = entry->num_value;
+}
+
+static void demux_sputext_class_dispose(demux_class_t *this_gen) {
+  demux_sputext_class_t *this = (demux_sputext_class_t *)this_gen;
+
+  while (this->cache) {
+    sub_data_t *data = this->cache;
+    this->cache = data->next;
+    sub_data_free(data);
+  }
+  pthread_mutex_destroy(&this->cache_lock);
+
+  free(this);
+}
+
 void *init_sputext_demux_class (xine_t *xine, void *data) {
 
   demux_sputext_class_t *this ;
@@ -1433,7 +1691,9 @@ void *init_sputext_demux_class (xine_t *xine, void *data) {
   /* "text/plain: asc txt sub srt: VIDEO subtitles;" */
   this->demux_class.mimetypes       = NULL;
   this->demux_class.extensions      = "asc txt sub srt smi ssa ass";
-  this->demux_class.dispose         = default_demux_class_dispose;
+  this->demux_class.dispose         = demux_sputext_class_dispose;
+
+  pthread_mutex_init(&this->cache_lock, NULL);
 
   /*
    * Some subtitling formats, namely AQT and Subrip09, define the end of a
@@ -1448,5 +1708,14 @@ void *init_sputext_demux_class (xine_t *xine, void *data) {
 			   "in the subtitle being shown until the next one takes over."),
 			 20, config_timeout_cb, this);
 
+  this->use_cache = xine->config->register_bool(xine->config,
+                         "subtitles.separate.cache", 1,
+			 _("keep parsed subtitle files in memory"),
+			 _("Parsed local subtitle files are shared by all streams playing the same file, "
+			   "and a few of them are kept after playback, so they need not be read "
+			   "and parsed again. A file is read again when its size or modification "
+			   "time changed."),
+			 20, config_cache_cb, this);
+
   return this;
 }
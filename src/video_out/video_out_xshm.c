@@ -1105,6 +1105,7 @@ static void xshm_dispose (vo_driver_t *this_gen) {
   if (this->cur_frame)
     this->cur_frame->vo_frame.dispose (&this->cur_frame->vo_frame);
 
+  yuv2rgb_unregister_scaler_config (this->yuv2rgb_factory, this->xine->config);
   this->yuv2rgb_factory->dispose (this->yuv2rgb_factory);
 
   cm_close (this);
@@ -1372,6 +1373,7 @@ static vo_driver_t *xshm_open_plugin_2 (video_driver_class_t *class_gen, const v
   this->saturation = 128;
 
   this->yuv2rgb_factory = yuv2rgb_factory_init (mode, swapped, this->yuv2rgb_cmap);
+  yuv2rgb_register_scaler_config (this->yuv2rgb_factory, config);
 
   LOCK_DISPLAY(this);
   this->xoverlay = x11osd_create (this->xine, this->display, this->screen,
@@ -583,8 +583,9 @@ static void xv_overlay_blend (vo_driver_t *this_gen,
   xv_driver_t  *this = (xv_driver_t *) this_gen;
   xv_frame_t   *frame = (xv_frame_t *) frame_gen;
 
-  if (overlay->rle) {
-    if( overlay->unscaled ) {
+  /* argb layers are always blended into the frame */
+  if (overlay->rle || overlay->argb_layer) {
+    if( overlay->unscaled && overlay->rle ) {
       if( this->ovl_changed && this->xoverlay ) {
         LOCK_DISPLAY(this);
         x11osd_blend(this->xoverlay, overlay);
@@ -1597,6 +1598,7 @@ static vo_driver_t *open_plugin_2 (video_driver_class_t *class_gen, const void *
 
   if( this->xoverlay )
     this->capabilities |= VO_CAP_UNSCALED_OVERLAY;
+  this->capabilities |= VO_CAP_ARGB_LAYER_OVERLAY;
 
   return &this->vo_driver;
 }
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 #ifdef HAVE_FFMPEG_AVUTIL_H
 #  include <mem.h>
@@ -39,6 +40,10 @@
 
 #include "yuv2rgb.h"
 
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+#include "xine_mmx.h"
+#endif
+
 #define LOG_MODULE "yuv2rgb"
 #define LOG_VERBOSE
 /*
@@ -46,10 +51,19 @@
 */
 
 #include <xine/xineutils.h>
+#include <xine/xineintl.h>
+#include <xine/instrument.h>
+
+static xine_tracepoint_t tp_scale = XINE_TRACEPOINT ("yuv2rgb.scale");
 
-static int prof_scale_line = -1;
+/* one pool for the converters of all factories */
+static pthread_mutex_t     pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static xine_worker_pool_t *pool_shared;
+static int                 pool_refs;
 
-static scale_line_func_t find_scale_line_func(int step);
+static int yuv2rgb_setup_scaler (yuv2rgb_t *this);
+static void yuv2rgb_scaled (yuv2rgb_t *this, uint8_t * _dst,
+                            uint8_t * _py, uint8_t * _pu, uint8_t * _pv);
 
 
 const int32_t Inverse_Table_6_9[8][4] = {
@@ -113,6 +127,11 @@ static void yuv2rgb_dispose (yuv2rgb_t *this)
 #ifdef HAVE_MLIB
   free (this->mlib_chunk);
 #endif
+  free (this->filter_y.chunk);
+  free (this->filter_uv.chunk);
+  free (this->filter_vy.chunk);
+  free (this->filter_vuv.chunk);
+  free (this->band_chunk);
   free (this);
 }
 
@@ -125,9 +144,6 @@ static int yuv2rgb_configure (yuv2rgb_t *this,
   printf ("yuv2rgb setup (%d x %d => %d x %d)\n", source_width, source_height,
 	  dest_width, dest_height);
 */
-  if (prof_scale_line == -1)
-    prof_scale_line = xine_profiler_allocate_slot("xshm scale line");
-
   this->source_width  = source_width;
   this->source_height = source_height;
   this->y_stride      = y_stride;
@@ -168,8 +184,6 @@ static int yuv2rgb_configure (yuv2rgb_t *this,
   printf("yuv2rgb config: src_ht=%i, dst_ht=%i\n",source_height, dest_height);
   printf("yuv2rgb config: step_dy=%i %f\n",this->step_dy, (float)this->step_dy / 32768.0);
 */
-  this->scale_line = find_scale_line_func(this->step_dx);
-
   if ((source_width == dest_width) && (source_height == dest_height)) {
     this->do_scale = 0;
 
@@ -216,1131 +230,463 @@ static int yuv2rgb_configure (yuv2rgb_t *this,
       return 0;
     }
 #endif
+
+    if (this->row_fun && !yuv2rgb_setup_scaler (this))
+      return 0;
   }
-  return 1;
-}
 
-static void scale_line_gen (uint8_t *source, uint8_t *dest,
-			    int width, int step) {
+  /* scaled yv12 goes through the scaler unless mlib handles it */
+  this->yuv2rgb_fun = (this->do_scale && this->row_fun) ? yuv2rgb_scaled : this->factory->yuv2rgb_fun;
 
-  /*
-   * scales a yuv source row to a dest row, with interpolation
-   * (good quality, but slow)
-   */
-  int p1;
-  int p2;
-  int dx;
+  return 1;
+}
 
-  xine_profiler_start_count(prof_scale_line);
+/*
+ * scaled yv12 conversion
+ *
+ * Lines are scaled horizontally with filter tables made by configure()
+ * (see yuv2rgb_filter_t) into per band line buffers, then converted by
+ * row_fun.  Vertically, 2 (bilinear) or 4 (bicubic) horizontally scaled
+ * lines are blended using a second pair of tables that count output
+ * lines instead of pixels.  Without vertical scaling, source lines are
+ * converted as they are.  An output line needing source lines below the
+ * current slice is left for a later one, and slices are collected until
+ * their output lines make enough bands for all threads of the factory's
+ * worker pool.
+ */
 
-  p1 = *source++;
-  p2 = *source++;
-  dx = 0;
+/* don't bother other threads with less than this many output lines */
+#define MIN_BAND_LINES 8
 
-  /*
-   * the following code has been optimized by Scott Smith <ssmith@akamai.com>:
-   *
-   * ok now I have a meaningful optimization for yuv2rgb.c:scale_line_gen.
-   * it removes the loop from within the while() loop by separating it out
-   * into 3 cases: where you are enlarging the line (<32768), where you are
-   * between 50% and 100% of the original line (<=65536), and where you are
-   * shrinking it by a lot.  anyways, I went from 200 delivered / 100+
-   * skipped to 200 delivered / 80 skipped for the enlarging case.  I
-   * noticed when looking at the assembly that the compiler was able to
-   * unroll these while(width) loops, whereas before it was trying to
-   * unroll the while(dx>32768) loops.  so the compiler is better able to
-   * deal with this code.
-   */
+static void scale_weights_cubic (int frac, int *w)
+{
+  /* Catmull-Rom spline, frac in 1/32768 */
+  double f = frac / 32768.0, f2 = f * f, f3 = f2 * f;
 
+  w[0] = (int)(8192.0 * (-f3 + 2.0 * f2 - f) - 0.5);
+  w[1] = (int)(8192.0 * (3.0 * f3 - 5.0 * f2 + 2.0) + 0.5);
+  w[2] = (int)(8192.0 * (-3.0 * f3 + 4.0 * f2 + f) + 0.5);
+  w[3] = (1 << 14) - w[0] - w[1] - w[2];
+}
 
-  if (step < 32768) {
-    while (width) {
-      *dest = p1 + (((p2-p1) * dx)>>15);
+/* source position of output pixel i is i * step >> shift */
+static int yuv2rgb_filter_setup (yuv2rgb_filter_t *f, int filter,
+                                 int source_width, int dest_width, int step, int shift)
+{
+  int i, j, n;
 
-      dx += step;
-      if (dx > 32768) {
-	dx -= 32768;
-	p1 = p2;
-	p2 = *source++;
-      }
+  n = (dest_width + 7) & ~7;
+  f->taps = (filter == SCALE_BICUBIC && source_width >= 4) ? 4 : 2;
+  f->width = n;
 
-      dest ++;
-      width --;
+  free (f->chunk);
+  f->pos = my_malloc_aligned (16, n * (sizeof (int32_t) + f->taps * sizeof (int16_t)), &f->chunk);
+  if (!f->chunk)
+    return 0;
+  f->coef = (int16_t *)(f->pos + n);
+
+  for (i = 0; i < n; i++) {
+    int64_t x = (int64_t)i * step;
+    int     k = x >> shift, frac = (x >> (shift - 15)) & 32767;
+    int     w[4], c[4] = {0, 0, 0, 0};
+    int     first, pos;
+    int16_t *coef;
+
+    if (f->taps == 4) {
+      scale_weights_cubic (frac, w);
+      first = k - 1;
+    } else {
+      w[1] = frac >> 1;
+      w[0] = (1 << 14) - w[1];
+      first = k;
     }
-  } else if (step <= 65536) {
-    while (width) {
-      *dest = p1 + (((p2-p1) * dx)>>15);
-
-      dx += step;
-      if (dx > 65536) {
-	dx -= 65536;
-	p1 = *source++;
-	p2 = *source++;
-      } else {
-	dx -= 32768;
-	p1 = p2;
-	p2 = *source++;
-      }
 
-      dest ++;
-      width --;
+    /* fold taps outside the line into the border pixels */
+    pos = first;
+    if (pos > source_width - f->taps)
+      pos = source_width - f->taps;
+    if (pos < 0)
+      pos = 0;
+    for (j = 0; j < f->taps; j++) {
+      int p = first + j;
+      p = (p < 0) ? 0 : (p >= source_width) ? source_width - 1 : p;
+      c[p - pos] += w[j];
     }
-  } else {
-    while (width) {
-      int offs;
-
-      *dest = p1 + (((p2-p1) * dx)>>15);
-
-      dx += step;
-      offs=((dx-1)>>15);
-      dx-=offs<<15;
-      source+=offs-2;
-      p1=*source++;
-      p2=*source++;
-      dest ++;
-      width --;
+
+    f->pos[i] = pos;
+    coef = f->coef + (i & ~7) * f->taps + 2 * (i & 7);
+    coef[0] = c[0];
+    coef[1] = c[1];
+    if (f->taps == 4) {
+      coef[16] = c[2];
+      coef[17] = c[3];
     }
   }
-  xine_profiler_stop_count(prof_scale_line);
-
-
-
-
+  return 1;
 }
 
-/*
- * Interpolates 16 output pixels from 15 source pixels using shifts.
- * Useful for scaling a PAL mpeg2 dvd input source to 4:3 format on
- * a monitor using square pixels.
- * (720 x 576 ==> 768 x 576)
- */
-static void scale_line_15_16 (uint8_t *source, uint8_t *dest,
-			      int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 16) >= 0) {
-    p1 = source[0];
-    dest[0] = p1;
-    p2 = source[1];
-    dest[1] = (1*p1 + 7*p2) >> 3;
-    p1 = source[2];
-    dest[2] = (1*p2 + 7*p1) >> 3;
-    p2 = source[3];
-    dest[3] = (1*p1 + 3*p2) >> 2;
-    p1 = source[4];
-    dest[4] = (1*p2 + 3*p1) >> 2;
-    p2 = source[5];
-    dest[5] = (3*p1 + 5*p2) >> 3;
-    p1 = source[6];
-    dest[6] = (3*p2 + 5*p1) >> 3;
-    p2 = source[7];
-    dest[7] = (1*p1 + 1*p1) >> 1;
-    p1 = source[8];
-    dest[8] = (1*p2 + 1*p1) >> 1;
-    p2 = source[9];
-    dest[9] = (5*p1 + 3*p2) >> 3;
-    p1 = source[10];
-    dest[10] = (5*p2 + 3*p1) >> 3;
-    p2 = source[11];
-    dest[11] = (3*p1 + 1*p2) >> 2;
-    p1 = source[12];
-    dest[12] = (3*p2 + 1*p1) >> 2;
-    p2 = source[13];
-    dest[13] = (7*p1 + 1*p2) >> 3;
-    p1 = source[14];
-    dest[14] = (7*p2 + 1*p1) >> 3;
-    dest[15] = p1;
-    source += 15;
-    dest += 16;
+static void scale_line_filter_c (const yuv2rgb_filter_t *f, uint8_t *source, uint8_t *dest)
+{
+  const int32_t *pos  = f->pos;
+  const int16_t *coef = f->coef;
+  int i, j, sum;
+
+  for (i = 0; i < f->width; i += 8) {
+    for (j = 0; j < 8; j++) {
+      uint8_t *p = source + pos[i + j];
+
+      sum = coef[2*j] * p[0] + coef[2*j + 1] * p[1];
+      if (f->taps == 4)
+        sum += coef[16 + 2*j] * p[2] + coef[16 + 2*j + 1] * p[3];
+      sum = (sum + 8192) >> 14;
+      dest[i + j] = (sum < 0) ? 0 : (sum > 255) ? 255 : sum;
+    }
+    coef += 8 * f->taps;
   }
-
-  if ((width += 16) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 7*source[1]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[1] + 7*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[2] + 3*source[3]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[3] + 3*source[4]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[4] + 5*source[5]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[5] + 5*source[6]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[6] + 1*source[7]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[7] + 1*source[8]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[8] + 3*source[9]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[9] + 3*source[10]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[10] + 1*source[11]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[11] + 1*source[12]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[12] + 1*source[13]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[13] + 1*source[14]) >> 3;
- done:
-  xine_profiler_stop_count(prof_scale_line);
 }
 
-
-/*
- * Interpolates 53 output pixels from 45 source pixels using shifts.
- * Useful for scaling a NTSC mpeg2 dvd input source to 16:9 display
- * resulution
- * fullscreen resolution, or to 16:9 format on a monitor using square
- * pixels.
- * (720 x 480 ==> 848 x 480)
- */
-static void scale_line_45_53 (uint8_t *source, uint8_t *dest,
-			      int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 53) >= 0) {
-    p1 = source[0];
-    p2 = source[1];
-    dest[0] = p1;
-    dest[1] = (1*p1 + 7*p2) >> 3;
-    p1 = source[2];
-    dest[2] = (1*p2 + 3*p1) >> 2;
-    p2 = source[3];
-    dest[3] = (1*p1 + 1*p2) >> 1;
-    p1 = source[4];
-    dest[4] = (5*p2 + 3*p1) >> 3;
-    p2 = source[5];
-    dest[5] = (3*p1 + 1*p2) >> 2;
-    p1 = source[6];
-    dest[6] = (7*p2 + 1*p1) >> 3;
-    dest[7] = p1;
-    p2 = source[7];
-    dest[8] = (1*p1 + 3*p2) >> 2;
-    p1 = source[8];
-    dest[9] = (3*p2 + 5*p1) >> 3;
-    p2 = source[9];
-    dest[10] = (1*p1 + 1*p2) >> 1;
-    p1 = source[10];
-    dest[11] = (5*p2 + 3*p1) >> 3;
-    p2 = source[11];
-    dest[12] = (3*p1 + 1*p2) >> 2;
-    p1 = source[12];
-    dest[13] = p2;
-    dest[14] = (1*p2 + 7*p1) >> 3;
-    p2 = source[13];
-    dest[15] = (1*p1 + 3*p2) >> 2;
-    p1 = source[14];
-    dest[16] = (3*p2 + 5*p1) >> 3;
-    p2 = source[15];
-    dest[17] = (5*p1 + 3*p2) >> 3;
-    p1 = source[16];
-    dest[18] = (3*p2 + 1*p1) >> 2;
-    p2 = source[17];
-    dest[19] = (7*p1 + 1*p2) >> 3;
-    dest[20] = p2;
-    p1 = source[18];
-    dest[21] = (1*p2 + 7*p1) >> 3;
-    p2 = source[19];
-    dest[22] = (3*p1 + 5*p2) >> 3;
-    p1 = source[20];
-    dest[23] = (1*p2 + 1*p1) >> 1;
-    p2 = source[21];
-    dest[24] = (5*p1 + 3*p2) >> 3;
-    p1 = source[22];
-    dest[25] = (3*p2 + 1*p1) >> 2;
-    p2 = source[23];
-    dest[26] = (7*p1 + 1*p2) >> 3;
-    dest[27] = (1*p1 + 7*p2) >> 3;
-    p1 = source[24];
-    dest[28] = (1*p2 + 3*p1) >> 2;
-    p2 = source[25];
-    dest[29] = (3*p1 + 5*p2) >> 3;
-    p1 = source[26];
-    dest[30] = (1*p2 + 1*p1) >> 1;
-    p2 = source[27];
-    dest[31] = (5*p1 + 3*p2) >> 3;
-    p1 = source[28];
-    dest[32] = (7*p2 + 1*p1) >> 3;
-    p2 = source[29];
-    dest[33] = p1;
-    dest[34] = (1*p1 + 7*p2) >> 3;
-    p1 = source[30];
-    dest[35] = (1*p2 + 3*p1) >> 2;
-    p2 = source[31];
-    dest[36] = (3*p1 + 5*p2) >> 3;
-    p1 = source[32];
-    dest[37] = (5*p2 + 3*p1) >> 3;
-    p2 = source[33];
-    dest[38] = (3*p1 + 1*p2) >> 2;
-    p1 = source[34];
-    dest[39] = (7*p2 + 1*p1) >> 3;
-    dest[40] = p1;
-    p2 = source[35];
-    dest[41] = (1*p1 + 3*p2) >> 2;
-    p1 = source[36];
-    dest[42] = (3*p2 + 5*p1) >> 3;
-    p2 = source[37];
-    dest[43] = (1*p1 + 1*p2) >> 1;
-    p1 = source[38];
-    dest[44] = (5*p2 + 3*p1) >> 3;
-    p2 = source[39];
-    dest[45] = (3*p1 + 1*p2) >> 2;
-    p1 = source[40];
-    dest[46] = p2;
-    dest[47] = (1*p2 + 7*p1) >> 3;
-    p2 = source[41];
-    dest[48] = (1*p1 + 3*p2) >> 2;
-    p1 = source[42];
-    dest[49] = (3*p2 + 5*p1) >> 3;
-    p2 = source[43];
-    dest[50] = (1*p1 + 1*p2) >> 1;
-    p1 = source[44];
-    dest[51] = (3*p2 + 1*p1) >> 2;
-    p2 = source[45];
-    dest[52] = (7*p1 + 1*p2) >> 3;
-    source += 45;
-    dest += 53;
+static void blend_lines_c (uint8_t *dest, uint8_t **lines, const int *w, int taps, int width)
+{
+  int i, sum;
+
+  for (i = 0; i < width; i++) {
+    sum = w[0] * lines[0][i] + w[1] * lines[1][i];
+    if (taps == 4)
+      sum += w[2] * lines[2][i] + w[3] * lines[3][i];
+    sum = (sum + 8192) >> 14;
+    dest[i] = (sum < 0) ? 0 : (sum > 255) ? 255 : sum;
   }
-
-  if ((width += 53) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 7*source[1]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[1] + 3*source[2]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[2] + 1*source[3]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[3] + 3*source[4]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[4] + 1*source[5]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[5] + 1*source[6]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[6];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[6] + 3*source[7]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[7] + 5*source[8]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[8] + 1*source[9]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[9] + 3*source[10]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[10] + 1*source[11]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = source[11];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[11] + 7*source[12]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[12] + 3*source[13]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[13] + 5*source[14]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[14] + 3*source[15]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[15] + 1*source[16]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[16] + 1*source[17]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[17];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[17] + 7*source[18]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[18] + 5*source[19]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[19] + 1*source[20]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[20] + 3*source[21]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[21] + 1*source[22]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[22] + 1*source[23]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[22] + 7*source[23]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[23] + 3*source[24]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[24] + 5*source[25]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[25] + 1*source[26]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[26] + 3*source[27]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[27] + 1*source[28]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[28];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[28] + 7*source[29]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[29] + 3*source[30]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[30] + 5*source[31]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[31] + 3*source[32]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[32] + 1*source[33]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[33] + 1*source[34]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[34];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[34] + 3*source[35]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[35] + 5*source[36]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[36] + 1*source[37]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[37] + 3*source[38]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[38] + 1*source[39]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = source[39];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[39] + 7*source[40]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[40] + 3*source[41]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[41] + 5*source[42]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[42] + 1*source[43]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[43] + 1*source[44]) >> 2;
- done:
-
-  xine_profiler_stop_count(prof_scale_line);
 }
 
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+static void scale_line_filter_sse2 (const yuv2rgb_filter_t *f, uint8_t *source, uint8_t *dest)
+{
+  static const sse_t round = { d: { 8192, 8192, 8192, 8192 } };
+  const int32_t *pos  = f->pos;
+  const int16_t *coef = f->coef;
+  sse_t lo, hi;
+  int i, j;
+
+  for (i = 0; i < f->width; i += 8) {
+    /* gather source pixel pairs, pmaddwd does the rest */
+    for (j = 0; j < 8; j++)
+      lo.uw[j] = *(uint16_t *)(source + pos[i + j]);
+
+    pxor_r2r (xmm7, xmm7);
+    movdqu_m2r (lo, xmm0);
+    movdqa_r2r (xmm0, xmm1);
+    punpcklbw_r2r (xmm7, xmm0);
+    punpckhbw_r2r (xmm7, xmm1);
+    movdqu_m2r (*(sse_t *)coef, xmm2);
+    movdqu_m2r (*(sse_t *)(coef + 8), xmm3);
+    pmaddwd_r2r (xmm2, xmm0);
+    pmaddwd_r2r (xmm3, xmm1);
+
+    if (f->taps == 4) {
+      for (j = 0; j < 8; j++)
+        hi.uw[j] = *(uint16_t *)(source + pos[i + j] + 2);
+
+      movdqu_m2r (hi, xmm2);
+      movdqa_r2r (xmm2, xmm3);
+      punpcklbw_r2r (xmm7, xmm2);
+      punpckhbw_r2r (xmm7, xmm3);
+      movdqu_m2r (*(sse_t *)(coef + 16), xmm4);
+      movdqu_m2r (*(sse_t *)(coef + 24), xmm5);
+      pmaddwd_r2r (xmm4, xmm2);
+      pmaddwd_r2r (xmm5, xmm3);
+      paddd_r2r (xmm2, xmm0);
+      paddd_r2r (xmm3, xmm1);
+    }
 
-/*
- * Interpolates 64 output pixels from 45 source pixels using shifts.
- * Useful for scaling a PAL mpeg2 dvd input source to 1024x768
- * fullscreen resolution, or to 16:9 format on a monitor using square
- * pixels.
- * (720 x 576 ==> 1024 x 576)
- */
-static void scale_line_45_64 (uint8_t *source, uint8_t *dest,
-			     int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 64) >= 0) {
-    p1 = source[0];
-    p2 = source[1];
-    dest[0] = p1;
-    dest[1] = (1*p1 + 3*p2) >> 2;
-    p1 = source[2];
-    dest[2] = (5*p2 + 3*p1) >> 3;
-    p2 = source[3];
-    dest[3] = (7*p1 + 1*p2) >> 3;
-    dest[4] = (1*p1 + 3*p2) >> 2;
-    p1 = source[4];
-    dest[5] = (1*p2 + 1*p1) >> 1;
-    p2 = source[5];
-    dest[6] = (3*p1 + 1*p2) >> 2;
-    dest[7] = (1*p1 + 7*p2) >> 3;
-    p1 = source[6];
-    dest[8] = (3*p2 + 5*p1) >> 3;
-    p2 = source[7];
-    dest[9] = (5*p1 + 3*p2) >> 3;
-    p1 = source[8];
-    dest[10] = p2;
-    dest[11] = (1*p2 + 3*p1) >> 2;
-    p2 = source[9];
-    dest[12] = (5*p1 + 3*p2) >> 3;
-    p1 = source[10];
-    dest[13] = (7*p2 + 1*p1) >> 3;
-    dest[14] = (1*p2 + 7*p1) >> 3;
-    p2 = source[11];
-    dest[15] = (1*p1 + 1*p2) >> 1;
-    p1 = source[12];
-    dest[16] = (3*p2 + 1*p1) >> 2;
-    dest[17] = p1;
-    p2 = source[13];
-    dest[18] = (3*p1 + 5*p2) >> 3;
-    p1 = source[14];
-    dest[19] = (5*p2 + 3*p1) >> 3;
-    p2 = source[15];
-    dest[20] = p1;
-    dest[21] = (1*p1 + 3*p2) >> 2;
-    p1 = source[16];
-    dest[22] = (1*p2 + 1*p1) >> 1;
-    p2 = source[17];
-    dest[23] = (7*p1 + 1*p2) >> 3;
-    dest[24] = (1*p1 + 7*p2) >> 3;
-    p1 = source[18];
-    dest[25] = (3*p2 + 5*p1) >> 3;
-    p2 = source[19];
-    dest[26] = (3*p1 + 1*p2) >> 2;
-    dest[27] = p2;
-    p1 = source[20];
-    dest[28] = (3*p2 + 5*p1) >> 3;
-    p2 = source[21];
-    dest[29] = (5*p1 + 3*p2) >> 3;
-    p1 = source[22];
-    dest[30] = (7*p2 + 1*p1) >> 3;
-    dest[31] = (1*p2 + 3*p1) >> 2;
-    p2 = source[23];
-    dest[32] = (1*p1 + 1*p2) >> 1;
-    p1 = source[24];
-    dest[33] = (3*p2 + 1*p1) >> 2;
-    dest[34] = (1*p2 + 7*p1) >> 3;
-    p2 = source[25];
-    dest[35] = (3*p1 + 5*p2) >> 3;
-    p1 = source[26];
-    dest[36] = (3*p2 + 1*p1) >> 2;
-    p2 = source[27];
-    dest[37] = p1;
-    dest[38] = (1*p1 + 3*p2) >> 2;
-    p1 = source[28];
-    dest[39] = (5*p2 + 3*p1) >> 3;
-    p2 = source[29];
-    dest[40] = (7*p1 + 1*p2) >> 3;
-    dest[41] = (1*p1 + 7*p2) >> 3;
-    p1 = source[30];
-    dest[42] = (1*p2 + 1*p1) >> 1;
-    p2 = source[31];
-    dest[43] = (3*p1 + 1*p2) >> 2;
-    dest[44] = (1*p1 + 7*p2) >> 3;
-    p1 = source[32];
-    dest[45] = (3*p2 + 5*p1) >> 3;
-    p2 = source[33];
-    dest[46] = (5*p1 + 3*p2) >> 3;
-    p1 = source[34];
-    dest[47] = p2;
-    dest[48] = (1*p2 + 3*p1) >> 2;
-    p2 = source[35];
-    dest[49] = (1*p1 + 1*p2) >> 1;
-    p1 = source[36];
-    dest[50] = (7*p2 + 1*p1) >> 3;
-    dest[51] = (1*p2 + 7*p1) >> 3;
-    p2 = source[37];
-    dest[52] = (1*p1 + 1*p2) >> 1;
-    p1 = source[38];
-    dest[53] = (3*p2 + 1*p1) >> 2;
-    dest[54] = p1;
-    p2 = source[39];
-    dest[55] = (3*p1 + 5*p2) >> 3;
-    p1 = source[40];
-    dest[56] = (5*p2 + 3*p1) >> 3;
-    p2 = source[41];
-    dest[57] = (7*p1 + 1*p2) >> 3;
-    dest[58] = (1*p1 + 3*p2) >> 2;
-    p1 = source[42];
-    dest[59] = (1*p2 + 1*p1) >> 1;
-    p2 = source[43];
-    dest[60] = (7*p1 + 1*p2) >> 3;
-    dest[61] = (1*p1 + 7*p2) >> 3;
-    p1 = source[44];
-    dest[62] = (3*p2 + 5*p1) >> 3;
-    p2 = source[45];
-    dest[63] = (3*p1 + 1*p2) >> 2;
-    source += 45;
-    dest += 64;
-  }
+    movdqu_m2r (round, xmm6);
+    paddd_r2r (xmm6, xmm0);
+    paddd_r2r (xmm6, xmm1);
+    psrad_i2r (14, xmm0);
+    psrad_i2r (14, xmm1);
+    packssdw_r2r (xmm1, xmm0);
+    packuswb_r2r (xmm0, xmm0);
+    movq_r2m (xmm0, *(uint64_t *)(dest + i));
 
-  if ((width += 64) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 3*source[1]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[1] + 3*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[2] + 1*source[3]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[2] + 3*source[3]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[3] + 1*source[4]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[4] + 1*source[5]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[4] + 7*source[5]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[5] + 5*source[6]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[6] + 3*source[7]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[7];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[7] + 3*source[8]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[8] + 3*source[9]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[9] + 1*source[10]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[9] + 7*source[10]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[10] + 1*source[11]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[11] + 1*source[12]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = source[12];
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[12] + 5*source[13]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[13] + 3*source[14]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[14];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[14] + 3*source[15]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[15] + 1*source[16]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[16] + 1*source[17]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[16] + 7*source[17]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[17] + 5*source[18]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[18] + 1*source[19]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = source[19];
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[19] + 5*source[20]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[20] + 3*source[21]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[21] + 1*source[22]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[21] + 3*source[22]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[22] + 1*source[23]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[23] + 1*source[24]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[23] + 7*source[24]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[24] + 5*source[25]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[25] + 1*source[26]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = source[26];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[26] + 3*source[27]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[27] + 3*source[28]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[28] + 1*source[29]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[28] + 7*source[29]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[29] + 1*source[30]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[30] + 1*source[31]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[30] + 7*source[31]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[31] + 5*source[32]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[32] + 3*source[33]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[33];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[33] + 3*source[34]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[34] + 1*source[35]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[35] + 1*source[36]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[35] + 7*source[36]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[36] + 1*source[37]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[37] + 1*source[38]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = source[38];
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[38] + 5*source[39]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[39] + 3*source[40]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[40] + 1*source[41]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[40] + 3*source[41]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[41] + 1*source[42]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[42] + 1*source[43]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[42] + 7*source[43]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[43] + 5*source[44]) >> 3;
- done:
-
-  xine_profiler_stop_count(prof_scale_line);
+    coef += 8 * f->taps;
+  }
 }
 
+static void blend_lines_sse2 (uint8_t *dest, uint8_t **lines, const int *w, int taps, int width)
+{
+  static const sse_t round = { d: { 8192, 8192, 8192, 8192 } };
+  sse_t w01, w23;
+  int i;
 
-/*
- * Interpolates 16 output pixels from 9 source pixels using shifts.
- * Useful for scaling a PAL mpeg2 dvd input source to 1280x1024 fullscreen
- * (720 x 576 ==> 1280 x XXX)
- */
-static void scale_line_9_16 (uint8_t *source, uint8_t *dest,
-			     int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 16) >= 0) {
-    p1 = source[0];
-    p2 = source[1];
-    dest[0] = p1;
-    dest[1] = (1*p1 + 1*p2) >> 1;
-    p1 = source[2];
-    dest[2] = (7*p2 + 1*p1) >> 3;
-    dest[3] = (3*p2 + 5*p1) >> 3;
-    p2 = source[3];
-    dest[4] = (3*p1 + 1*p2) >> 2;
-    dest[5] = (1*p1 + 3*p2) >> 2;
-    p1 = source[4];
-    dest[6] = (5*p2 + 3*p1) >> 3;
-    dest[7] = (1*p2 + 7*p1) >> 3;
-    p2 = source[5];
-    dest[8] = (1*p1 + 1*p2) >> 1;
-    p1 = source[6];
-    dest[9] = p2;
-    dest[10] = (3*p2 + 5*p1) >> 3;
-    p2 = source[7];
-    dest[11] = (7*p1 + 1*p2) >> 3;
-    dest[12] = (1*p1 + 3*p2) >> 2;
-    p1 = source[8];
-    dest[13] = (3*p2 + 1*p1) >> 2;
-    dest[14] = (1*p2 + 7*p1) >> 3;
-    p2 = source[9];
-    dest[15] = (5*p1 + 3*p2) >> 3;
-    source += 9;
-    dest += 16;
+  /* weight pairs for pmaddwd on interleaved lines */
+  for (i = 0; i < 4; i++) {
+    w01.w[2*i] = w[0];
+    w01.w[2*i + 1] = w[1];
+    w23.w[2*i] = (taps == 4) ? w[2] : 0;
+    w23.w[2*i + 1] = (taps == 4) ? w[3] : 0;
   }
 
-  if ((width += 16) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 1*source[1]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[1] + 1*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[1] + 5*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[2] + 1*source[3]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[2] + 3*source[3]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[3] + 3*source[4]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[3] + 7*source[4]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[4] + 1*source[5]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = source[5];
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[5] + 5*source[6]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[6] + 1*source[7]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[6] + 3*source[7]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[7] + 1*source[8]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[7] + 7*source[8]) >> 3;
-done:
-  xine_profiler_stop_count(prof_scale_line);
-}
-
+  for (i = 0; i < width; i += 8) {
+    pxor_r2r (xmm7, xmm7);
+    movq_m2r (*(uint64_t *)(lines[0] + i), xmm0);
+    movq_m2r (*(uint64_t *)(lines[1] + i), xmm2);
+    punpcklbw_r2r (xmm7, xmm0);
+    punpcklbw_r2r (xmm7, xmm2);
+    movdqa_r2r (xmm0, xmm1);
+    punpcklwd_r2r (xmm2, xmm0);
+    punpckhwd_r2r (xmm2, xmm1);
+    movdqu_m2r (w01, xmm6);
+    pmaddwd_r2r (xmm6, xmm0);
+    pmaddwd_r2r (xmm6, xmm1);
+
+    if (taps == 4) {
+      movq_m2r (*(uint64_t *)(lines[2] + i), xmm2);
+      movq_m2r (*(uint64_t *)(lines[3] + i), xmm4);
+      punpcklbw_r2r (xmm7, xmm2);
+      punpcklbw_r2r (xmm7, xmm4);
+      movdqa_r2r (xmm2, xmm3);
+      punpcklwd_r2r (xmm4, xmm2);
+      punpckhwd_r2r (xmm4, xmm3);
+      movdqu_m2r (w23, xmm6);
+      pmaddwd_r2r (xmm6, xmm2);
+      pmaddwd_r2r (xmm6, xmm3);
+      paddd_r2r (xmm2, xmm0);
+      paddd_r2r (xmm3, xmm1);
+    }
 
-/*
- * Interpolates 12 output pixels from 11 source pixels using shifts.
- * Useful for scaling a PAL vcd input source to 4:3 display format.
- */
-static void scale_line_11_12 (uint8_t *source, uint8_t *dest,
-			     int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 12) >= 0) {
-    p1 = source[0];
-    p2 = source[1];
-    dest[0] = p1;
-    dest[1] = (1*p1 + 7*p2) >> 3;
-    p1 = source[2];
-    dest[2] = (1*p2 + 7*p1) >> 3;
-    p2 = source[3];
-    dest[3] = (1*p1 + 3*p2) >> 2;
-    p1 = source[4];
-    dest[4] = (3*p2 + 5*p1) >> 3;
-    p2 = source[5];
-    dest[5] = (3*p1 + 5*p2) >> 3;
-    p1 = source[6];
-    dest[6] = (1*p2 + 1*p1) >> 1;
-    p2 = source[7];
-    dest[7] = (5*p1 + 3*p2) >> 3;
-    p1 = source[8];
-    dest[8] = (5*p2 + 3*p1) >> 3;
-    p2 = source[9];
-    dest[9] = (3*p1 + 1*p2) >> 2;
-    p1 = source[10];
-    dest[10] = (7*p2 + 1*p1) >> 3;
-    p2 = source[11];
-    dest[11] = (7*p1 + 1*p2) >> 3;
-    source += 11;
-    dest += 12;
+    movdqu_m2r (round, xmm6);
+    paddd_r2r (xmm6, xmm0);
+    paddd_r2r (xmm6, xmm1);
+    psrad_i2r (14, xmm0);
+    psrad_i2r (14, xmm1);
+    packssdw_r2r (xmm1, xmm0);
+    packuswb_r2r (xmm0, xmm0);
+    movq_r2m (xmm0, *(uint64_t *)(dest + i));
   }
-
-  if ((width += 12) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 7*source[1]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[1] + 7*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[2] + 3*source[3]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[3] + 5*source[4]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[4] + 5*source[5]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[5] + 1*source[6]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[6] + 3*source[7]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[7] + 3*source[8]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[8] + 1*source[9]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[9] + 1*source[10]) >> 3;
-done:
-
-  xine_profiler_stop_count(prof_scale_line);
 }
+#endif
 
+static int yuv2rgb_setup_scaler (yuv2rgb_t *this)
+{
+  int bands = xine_worker_pool_size (this->factory->pool);
+  int filter = this->factory->scale_filter;
 
-/*
- * Interpolates 24 output pixels from 11 source pixels using shifts.
- * Useful for scaling a PAL vcd input source to 4:3 display format
- * at 2*zoom.
- */
-static void scale_line_11_24 (uint8_t *source, uint8_t *dest,
-			     int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 24) >= 0) {
-    p1 = source[0];
-    p2 = source[1];
-    dest[0] = p1;
-    dest[1] = (1*p1 + 1*p2) >> 1;
-    dest[2] = (1*p1 + 7*p2) >> 3;
-    p1 = source[2];
-    dest[3] = (5*p2 + 3*p1) >> 3;
-    dest[4] = (1*p2 + 7*p1) >> 3;
-    p2 = source[3];
-    dest[5] = (3*p1 + 1*p2) >> 2;
-    dest[6] = (1*p1 + 3*p2) >> 2;
-    p1 = source[4];
-    dest[7] = (3*p2 + 1*p1) >> 2;
-    dest[8] = (3*p2 + 5*p1) >> 3;
-    p2 = source[5];
-    dest[9] = (7*p1 + 1*p2) >> 3;
-    dest[10] = (3*p1 + 5*p2) >> 3;
-    p1 = source[6];
-    dest[11] = p2;
-    dest[12] = (1*p2 + 1*p1) >> 1;
-    dest[13] = p1;
-    p2 = source[7];
-    dest[14] = (5*p1 + 3*p2) >> 3;
-    dest[15] = (1*p1 + 7*p2) >> 3;
-    p1 = source[8];
-    dest[16] = (5*p2 + 3*p1) >> 3;
-    dest[17] = (1*p2 + 3*p1) >> 2;
-    p2 = source[9];
-    dest[18] = (3*p1 + 1*p2) >> 2;
-    dest[19] = (1*p1 + 3*p2) >> 2;
-    p1 = source[10];
-    dest[20] = (7*p2 + 1*p1) >> 3;
-    dest[21] = (3*p2 + 5*p1) >> 3;
-    p2 = source[11];
-    dest[22] = (7*p1 + 1*p2) >> 3;
-    dest[23] = (1*p1 + 1*p2) >> 1;
-    source += 11;
-    dest += 24;
-  }
-
-  if ((width += 24) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 1*source[1]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 7*source[1]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[1] + 3*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[1] + 7*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[2] + 1*source[3]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[2] + 3*source[3]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[3] + 1*source[4]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[3] + 5*source[4]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[4] + 1*source[5]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[4] + 5*source[5]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = source[5];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[5] + 1*source[6]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = source[6];
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[6] + 3*source[7]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[6] + 7*source[7]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (5*source[7] + 3*source[8]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[7] + 3*source[8]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[8] + 1*source[9]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[8] + 3*source[9]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[9] + 1*source[10]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[9] + 5*source[10]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[10] + 1*source[11]) >> 3;
-done:
-
-  xine_profiler_stop_count(prof_scale_line);
-}
+  this->scale_filter = -1;
 
+  if (!yuv2rgb_filter_setup (&this->filter_y, filter,
+                             this->source_width, this->dest_width, this->step_dx, 15))
+    return 0;
+  if (!yuv2rgb_filter_setup (&this->filter_uv, filter,
+                             (this->source_width + 1) >> 1, this->dest_width >> 1, this->step_dx, 15))
+    return 0;
 
-/*
- * Interpolates 8 output pixels from 5 source pixels using shifts.
- * Useful for scaling a PAL svcd input source to 4:3 display format.
- */
-static void scale_line_5_8 (uint8_t *source, uint8_t *dest,
-			    int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 8) >= 0) {
-    p1 = source[0];
-    p2 = source[1];
-    dest[0] = p1;
-    dest[1] = (3*p1 + 5*p2) >> 3;
-    p1 = source[2];
-    dest[2] = (3*p2 + 1*p1) >> 2;
-    dest[3] = (1*p2 + 7*p1) >> 3;
-    p2 = source[3];
-    dest[4] = (1*p1 + 1*p2) >> 1;
-    p1 = source[4];
-    dest[5] = (7*p2 + 1*p1) >> 3;
-    dest[6] = (1*p2 + 3*p1) >> 2;
-    p2 = source[5];
-    dest[7] = (5*p1 + 3*p2) >> 3;
-    source += 5;
-    dest += 8;
+  if (this->step_dy != (1 << 15) && this->source_height >= 4) {
+    /* chroma lines are half as many, at half the step */
+    if (!yuv2rgb_filter_setup (&this->filter_vy, filter,
+                               this->source_height, this->dest_height, this->step_dy, 15))
+      return 0;
+    if (!yuv2rgb_filter_setup (&this->filter_vuv, filter,
+                               (this->source_height + 1) >> 1, this->dest_height, this->step_dy, 16))
+      return 0;
+  } else {
+    this->filter_vy.taps = this->filter_vuv.taps = 0;
   }
+  this->v_row = 0;
+
+  /* y, u and v line per band, and up to 4 more of each to blend vertically */
+  free (this->band_chunk);
+  this->band_size = this->filter_y.width + 2 * this->filter_uv.width;
+  if (this->filter_vy.taps)
+    this->band_size *= 5;
+  this->band_buffer = my_malloc_aligned (16, bands * this->band_size, &this->band_chunk);
+  if (!this->band_chunk)
+    return 0;
 
-  if ((width += 8) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[0] + 5*source[1]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (3*source[1] + 1*source[2]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[1] + 7*source[2]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[2] + 1*source[3]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = (7*source[3] + 1*source[4]) >> 3;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[3] + 3*source[4]) >> 2;
-done:
-
-  xine_profiler_stop_count(prof_scale_line);
+  this->scale_filter = filter;
+  return 1;
 }
 
+/* dst, py, pu and pv point to line 0 of the frame, output lines
+ * [dst_first, dst_first + dst_height) are done */
+typedef struct {
+  yuv2rgb_t *this;
+  uint8_t   *dst, *py, *pu, *pv;
+  int        dst_height;
+  int        dst_first;
+} yuv2rgb_scale_job_t;
 
 /*
- * Interpolates 4 output pixels from 3 source pixels using shifts.
- * Useful for scaling a NTSC svcd input source to 4:3 display format.
+ * with vertical filter: the last 4 horizontally scaled lines of each
+ * plane are kept in the band buffer, indexed by source line & 3.
  */
-static void scale_line_3_4 (uint8_t *source, uint8_t *dest,
-			    int width, int step) {
-
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 4) >= 0) {
-    p1 = source[0];
-    p2 = source[1];
-    dest[0] = p1;
-    dest[1] = (1*p1 + 3*p2) >> 2;
-    p1 = source[2];
-    dest[2] = (1*p2 + 1*p1) >> 1;
-    p2 = source[3];
-    dest[3] = (3*p1 + 1*p2) >> 2;
-    source += 3;
-    dest += 4;
-  }
-
-  if ((width += 4) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[0] + 3*source[1]) >> 2;
-  if (--width <= 0) goto done;
-  *dest++ = (1*source[1] + 1*source[2]) >> 1;
-done:
+static void yuv2rgb_scale_band_v (void *data, int band, int num_bands)
+{
+  yuv2rgb_scale_job_t *job = (yuv2rgb_scale_job_t *)data;
+  yuv2rgb_t *this = job->this;
+  yuv2rgb_factory_t *factory = this->factory;
+  int first = job->dst_first + job->dst_height * band / num_bands;
+  int last  = job->dst_first + job->dst_height * (band + 1) / num_bands;
+  int y_width = this->filter_y.width, uv_width = this->filter_uv.width;
+  uint8_t *y_buf = this->band_buffer + band * this->band_size;
+  uint8_t *u_buf = y_buf + y_width;
+  uint8_t *v_buf = u_buf + uv_width;
+  uint8_t *y_lines = v_buf + uv_width;
+  uint8_t *u_lines = y_lines + 4 * y_width;
+  uint8_t *v_lines = u_lines + 4 * uv_width;
+  uint8_t *dst = job->dst + first * this->rgb_stride;
+  uint8_t *lines[4], *lines_v[4];
+  int y_tag[4] = { -1, -1, -1, -1 }, uv_tag[4] = { -1, -1, -1, -1 };
+  int row, j, w[4];
+
+  for (row = first; row < last; row++, dst += this->rgb_stride) {
+    const yuv2rgb_filter_t *f = &this->filter_vy;
+    const int16_t *coef = f->coef + (row & ~7) * f->taps + 2 * (row & 7);
+
+    for (j = 0; j < f->taps; j++) {
+      int line = f->pos[row] + j;
+      lines[j] = y_lines + (line & 3) * y_width;
+      if (y_tag[line & 3] != line) {
+        y_tag[line & 3] = line;
+        factory->scale_line_fun (&this->filter_y, job->py + line * this->y_stride, lines[j]);
+      }
+    }
+    w[0] = coef[0]; w[1] = coef[1];
+    if (f->taps == 4) {
+      w[2] = coef[16]; w[3] = coef[17];
+    }
+    factory->blend_lines_fun (y_buf, lines, w, f->taps, y_width);
+
+    f = &this->filter_vuv;
+    coef = f->coef + (row & ~7) * f->taps + 2 * (row & 7);
+    for (j = 0; j < f->taps; j++) {
+      int line = f->pos[row] + j;
+      lines[j]   = u_lines + (line & 3) * uv_width;
+      lines_v[j] = v_lines + (line & 3) * uv_width;
+      if (uv_tag[line & 3] != line) {
+        uv_tag[line & 3] = line;
+        factory->scale_line_fun (&this->filter_uv, job->pu + line * this->uv_stride, lines[j]);
+        factory->scale_line_fun (&this->filter_uv, job->pv + line * this->uv_stride, lines_v[j]);
+      }
+    }
+    w[0] = coef[0]; w[1] = coef[1];
+    if (f->taps == 4) {
+      w[2] = coef[16]; w[3] = coef[17];
+    }
+    factory->blend_lines_fun (u_buf, lines, w, f->taps, uv_width);
+    factory->blend_lines_fun (v_buf, lines_v, w, f->taps, uv_width);
 
-  xine_profiler_stop_count(prof_scale_line);
+    this->row_fun (this, dst, y_buf, u_buf, v_buf);
+  }
 }
 
-
-/* Interpolate 2 output pixels from one source pixel. */
-
-static void scale_line_1_2 (uint8_t *source, uint8_t *dest,
-			    int width, int step) {
-  int p1, p2;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  p1 = *source;
-  while ((width -= 4) >= 0) {
-    *dest++ = p1;
-    p2 = *++source;
-    *dest++ = (p1 + p2) >> 1;
-    *dest++ = p2;
-    p1 = *++source;
-    *dest++ = (p2 + p1) >> 1;
+static void yuv2rgb_scale_band (void *data, int band, int num_bands)
+{
+  yuv2rgb_scale_job_t *job = (yuv2rgb_scale_job_t *)data;
+  yuv2rgb_t *this = job->this;
+  int first = job->dst_first + job->dst_height * band / num_bands;
+  int last  = job->dst_first + job->dst_height * (band + 1) / num_bands;
+  uint8_t *y_buf = this->band_buffer + band * this->band_size;
+  uint8_t *u_buf = y_buf + this->filter_y.width;
+  uint8_t *v_buf = u_buf + this->filter_uv.width;
+  uint8_t *dst = job->dst + first * this->rgb_stride;
+  int row, line, y_line = -1, uv_line = -1;
+
+  for (row = first; row < last; row++, dst += this->rgb_stride) {
+    line = ((int64_t)row * this->step_dy) >> 15;
+
+    if (line == y_line) {
+      /* same source line as the one above, short frames only */
+      xine_fast_memcpy (dst, dst - this->rgb_stride, this->dest_width * this->bytes_per_pixel);
+      continue;
+    }
+    y_line = line;
+    this->factory->scale_line_fun (&this->filter_y, job->py + line * this->y_stride, y_buf);
+    if ((line >> 1) != uv_line) {
+      uv_line = line >> 1;
+      this->factory->scale_line_fun (&this->filter_uv, job->pu + uv_line * this->uv_stride, u_buf);
+      this->factory->scale_line_fun (&this->filter_uv, job->pv + uv_line * this->uv_stride, v_buf);
+    }
+    this->row_fun (this, dst, y_buf, u_buf, v_buf);
   }
-
-  if ((width += 4) <= 0) goto done;
-  *dest++ = source[0];
-  if (--width <= 0) goto done;
-  *dest++ = (source[0] + source[1]) >> 1;
-  if (--width <= 0) goto done;
-  *dest++ = source[1];
- done:
-
-  xine_profiler_stop_count(prof_scale_line);
 }
 
-/* Interpolate 4 output pixels from 5 source pixels (1280x720 -> 1024x576). */
-/* *   *   *   *   * */
-/* *    *    *    *  */
-
-static void scale_line_5_4 (uint8_t *source, uint8_t *dest, int width, int step) {
-  int p1, p2, p3, p4, p5;
-
-  xine_profiler_start_count(prof_scale_line);
-
-  while ((width -= 4) >= 0) {
-    *dest++ = *source++;
-    p1 = *source++;
-    p2 = *source++;
-    *dest++ = p1 + ((p2 - p1) >> 2);
-    p3 = *source++;
-    p4 = *source++;
-    /* the middle pixel loses most sharpness, so do that one cubic */
-    p5 = (9 * (p2 + p3) - p1 - p4) >> 4;
-    *dest++ = p5 & 0x100 ? ~(p5 >> 9) : p5;
-    *dest++ = p4 + ((p3 - p4) >> 2);
+/* sets up job for the output lines the source lines up to this slice
+ * allow, if they are enough to keep the pool busy or the frame ends */
+static void yuv2rgb_scale_rows (yuv2rgb_t *this, yuv2rgb_scale_job_t *job)
+{
+  int offset = this->slice_offset, avail = this->source_height, last;
+  uint8_t *dst = job->dst;
+
+  if (this->slice_height != this->source_height) {
+    if (!offset)
+      this->v_row = 0;
+    job->py -= offset * this->y_stride;
+    job->pu -= (offset >> 1) * this->uv_stride;
+    job->pv -= (offset >> 1) * this->uv_stride;
+    if (offset + this->slice_height < this->source_height)
+      avail = offset + this->slice_height;
+    /* just advances slice_offset */
+    this->next_slice (this, &dst);
+  } else {
+    this->v_row = 0;
   }
 
-  if ((width += 4) <= 0) goto done;
-  *dest++ = *source++;
-  if (--width <= 0) goto done;
-  p1 = *source++;
-  p2 = *source++;
-  *dest++ = p1 + ((p2 - p1) >> 2);
-  if (--width <= 0) goto done;
-  p1 = *source;
-  *dest++ = (p1 + p2) >> 1;
- done:
-
-  xine_profiler_stop_count(prof_scale_line);
-}
-
+  last = this->v_row;
+  if (avail >= this->source_height) {
+    last = this->dest_height;
+  } else if (this->filter_vy.taps) {
+    while ((last < this->dest_height)
+      && (this->filter_vy.pos[last] + this->filter_vy.taps <= avail)
+      && (this->filter_vuv.pos[last] + this->filter_vuv.taps <= (avail >> 1)))
+      last++;
+  } else {
+    while ((last < this->dest_height) && ((((int64_t)last * this->step_dy) >> 15) < avail))
+      last++;
+  }
 
-/*
- * Scale line with no horizontal scaling. For NTSC mpeg2 dvd input in
- * 4:3 output format (720x480 -> 720x540)
- */
-static void scale_line_1_1 (uint8_t *source, uint8_t *dest,
-			    int width, int step) {
+  if ((avail < this->source_height)
+    && (last - this->v_row < xine_worker_pool_size (this->factory->pool) * MIN_BAND_LINES)) {
+    /* wait for more slices */
+    job->dst_height = 0;
+    return;
+  }
 
-  xine_profiler_start_count(prof_scale_line);
-  xine_fast_memcpy(dest, source, width);
-  xine_profiler_stop_count(prof_scale_line);
+  job->dst_first  = this->v_row;
+  job->dst_height = last - this->v_row;
+  this->v_row = last;
 }
 
+static void yuv2rgb_scaled (yuv2rgb_t *this, uint8_t * _dst,
+                            uint8_t * _py, uint8_t * _pu, uint8_t * _pv)
+{
+  yuv2rgb_scale_job_t job;
+  uint64_t t;
+  int bands;
 
-static scale_line_func_t find_scale_line_func(int step) {
-  static struct {
-    int			src_step;
-    int			dest_step;
-    scale_line_func_t	func;
-    const char	       *desc; /* FIXME: consider moving this to a char[] to avoid reloc */
-  } scale_line[] = {
-    { 15, 16, scale_line_15_16, "dvd 4:3(pal)" },
-    { 45, 64, scale_line_45_64, "dvd 16:9(pal), fullscreen(1024x768)" },
-    {  9, 16, scale_line_9_16,  "dvd fullscreen(1280x1024)" },
-    { 45, 53, scale_line_45_53, "dvd 16:9(ntsc)" },
-    { 11, 12, scale_line_11_12, "vcd 4:3(pal)" },
-    { 11, 24, scale_line_11_24, "vcd 4:3(pal) 2*zoom" },
-    {  5,  8, scale_line_5_8,   "svcd 4:3(pal)" },
-    {  3,  4, scale_line_3_4,   "svcd 4:3(ntsc)" },
-    {  1,  2, scale_line_1_2,   "2*zoom" },
-    {  1,  1, scale_line_1_1,   "non-scaled" },
-    {  5,  4, scale_line_5_4,   "hd720p, fullscreen(1024x576)" },
-  };
-  size_t i;
-#ifdef	LOG
-  /* to filter out multiple messages about the scale_line variant we're using */
-  static int reported_for_step;
-#endif
-
-  for (i = 0; i < sizeof(scale_line)/sizeof(scale_line[0]); i++) {
-    if (step == scale_line[i].src_step*32768/scale_line[i].dest_step) {
-#ifdef	LOG
-      if (step != reported_for_step)
-	printf("yuv2rgb: using %s optimized scale_line\n", scale_line[i].desc);
-      reported_for_step = step;
-#endif
-      return scale_line[i].func;
-    }
+  if (this->scale_filter != this->factory->scale_filter) {
+    if (!yuv2rgb_setup_scaler (this))
+      return;
   }
 
-#ifdef	LOG
-  if (step != reported_for_step)
-    printf("yuv2rgb: using generic scale_line with interpolation\n");
-  reported_for_step = step;
-#endif
+  job.this = this;
+  job.dst  = _dst;
+  job.py   = _py;
+  job.pu   = _pu;
+  job.pv   = _pv;
+  yuv2rgb_scale_rows (this, &job);
+  if (job.dst_height <= 0)
+    return;
 
-  return scale_line_gen;
+  bands = xine_worker_pool_size (this->factory->pool);
+  if (bands > job.dst_height / MIN_BAND_LINES)
+    bands = job.dst_height / MIN_BAND_LINES;
+  if (bands < 1)
+    bands = 1;
+
+  t = xine_tp_start ();
+  xine_worker_pool_run (this->factory->pool, bands,
+                        this->filter_vy.taps ? yuv2rgb_scale_band_v : yuv2rgb_scale_band, &job);
+  xine_tp_stop (tp_scale, t);
+  xine_tp_hit (tp_scale, job.dst_height);
 }
 
 
@@ -1454,395 +800,335 @@ static void scale_line_4 (uint8_t *source, uint8_t *dest,
 	Y = py_2[2*i+1];						\
 	dst_2[2*i+1] = this->cmap[r[Y] + g[Y] + b[Y]];
 
-static void yuv2rgb_c_32 (yuv2rgb_t *this, uint8_t * _dst,
-			  uint8_t * _py, uint8_t * _pu, uint8_t * _pv)
+/*
+ * single line converters for scaled output
+ */
+
+static void yuv2rgb_row_c_32 (yuv2rgb_t *this, uint8_t * _dst,
+			      uint8_t * py_1, uint8_t * pu, uint8_t * pv)
 {
   int U, V, Y;
-  uint8_t  * py_1, * py_2, * pu, * pv;
   uint32_t * r, * g, * b;
-  uint32_t * dst_1, * dst_2;
-  int width, height, dst_height;
-  int dy;
+  uint32_t * dst_1 = (uint32_t*)_dst;
+  int width;
 
-  if (this->do_scale) {
-    scale_line_func_t scale_line = this->scale_line;
+  for (width = this->dest_width >> 3; width > 0; width--) {
+    X_RGB(0);
+    DST1(0);
 
-    scale_line (_pu, this->u_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_pv, this->v_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_py, this->y_buffer,
-		this->dest_width, this->step_dx);
+    X_RGB(1);
+    DST1(1);
 
-    dy = 0;
-    dst_height = this->next_slice (this, &_dst);
+    X_RGB(2);
+    DST1(2);
 
-    for (height = 0;; ) {
-      dst_1 = (uint32_t*)_dst;
-      py_1  = this->y_buffer;
-      pu    = this->u_buffer;
-      pv    = this->v_buffer;
+    X_RGB(3);
+    DST1(3);
 
-      width = this->dest_width >> 3;
+    pu += 4;
+    pv += 4;
+    py_1 += 8;
+    dst_1 += 8;
+  }
+}
 
-      do {
-	  X_RGB(0);
-	  DST1(0);
+static void yuv2rgb_row_c_24_rgb (yuv2rgb_t *this, uint8_t * dst_1,
+				  uint8_t * py_1, uint8_t * pu, uint8_t * pv)
+{
+  int U, V, Y;
+  uint8_t * r, * g, * b;
+  int width;
 
-	  X_RGB(1);
-	  DST1(1);
+  for (width = this->dest_width >> 3; width > 0; width--) {
+    X_RGB(0);
+    DST1RGB(0);
 
-	  X_RGB(2);
-	  DST1(2);
+    X_RGB(1);
+    DST1RGB(1);
 
-	  X_RGB(3);
-	  DST1(3);
+    X_RGB(2);
+    DST1RGB(2);
 
-	  pu += 4;
-	  pv += 4;
-	  py_1 += 8;
-	  dst_1 += 8;
-      } while (--width);
+    X_RGB(3);
+    DST1RGB(3);
 
-      dy += this->step_dy;
-      _dst += this->rgb_stride;
+    pu += 4;
+    pv += 4;
+    py_1 += 8;
+    dst_1 += 24;
+  }
+}
 
-      while (--dst_height > 0 && dy < 32768) {
+static void yuv2rgb_row_c_24_bgr (yuv2rgb_t *this, uint8_t * dst_1,
+				  uint8_t * py_1, uint8_t * pu, uint8_t * pv)
+{
+  int U, V, Y;
+  uint8_t * r, * g, * b;
+  int width;
 
-	xine_fast_memcpy (_dst, (uint8_t*)_dst-this->rgb_stride, this->dest_width*4);
+  for (width = this->dest_width >> 3; width > 0; width--) {
+    X_RGB(0);
+    DST1BGR(0);
 
-	dy += this->step_dy;
-	_dst += this->rgb_stride;
-      }
+    X_RGB(1);
+    DST1BGR(1);
 
-      if (dst_height <= 0)
-	break;
+    X_RGB(2);
+    DST1BGR(2);
 
-      do {
-          dy -= 32768;
-          _py += this->y_stride;
+    X_RGB(3);
+    DST1BGR(3);
 
-          scale_line (_py, this->y_buffer,
-                      this->dest_width, this->step_dx);
+    pu += 4;
+    pv += 4;
+    py_1 += 8;
+    dst_1 += 24;
+  }
+}
 
-          if (height & 1) {
-              _pu += this->uv_stride;
-              _pv += this->uv_stride;
+static void yuv2rgb_row_c_16 (yuv2rgb_t *this, uint8_t * _dst,
+			      uint8_t * py_1, uint8_t * pu, uint8_t * pv)
+{
+  int U, V, Y;
+  uint16_t * r, * g, * b;
+  uint16_t * dst_1 = (uint16_t*)_dst;
+  int width;
 
-              scale_line (_pu, this->u_buffer,
-                          this->dest_width >> 1, this->step_dx);
-              scale_line (_pv, this->v_buffer,
-                          this->dest_width >> 1, this->step_dx);
+  for (width = this->dest_width >> 3; width > 0; width--) {
+    X_RGB(0);
+    DST1(0);
 
-          }
-          height++;
-      } while( dy>=32768);
-    }
-  } else {
-    height = this->next_slice (this, &_dst) >> 1;
-    do {
-      dst_1 = (uint32_t*)_dst;
-      dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
-      py_1 = _py;
-      py_2 = _py + this->y_stride;
-      pu   = _pu;
-      pv   = _pv;
-
-      width = this->source_width >> 3;
-      do {
-	X_RGB(0);
-	DST1(0);
-	DST2(0);
-
-	X_RGB(1);
-	DST2(1);
-	DST1(1);
-
-	X_RGB(2);
-	DST1(2);
-	DST2(2);
-
-	X_RGB(3);
-	DST2(3);
-	DST1(3);
-
-	pu += 4;
-	pv += 4;
-	py_1 += 8;
-	py_2 += 8;
-	dst_1 += 8;
-	dst_2 += 8;
-      } while (--width);
-
-      _dst += 2 * this->rgb_stride;
-      _py += 2 * this->y_stride;
-      _pu += this->uv_stride;
-      _pv += this->uv_stride;
-
-    } while (--height);
+    X_RGB(1);
+    DST1(1);
+
+    X_RGB(2);
+    DST1(2);
+
+    X_RGB(3);
+    DST1(3);
+
+    pu += 4;
+    pv += 4;
+    py_1 += 8;
+    dst_1 += 8;
   }
 }
 
-/* This is very near from the yuv2rgb_c_32 code */
-static void yuv2rgb_c_24_rgb (yuv2rgb_t *this, uint8_t * _dst,
-			      uint8_t * _py, uint8_t * _pu, uint8_t * _pv)
+static void yuv2rgb_row_c_8 (yuv2rgb_t *this, uint8_t * dst_1,
+			     uint8_t * py_1, uint8_t * pu, uint8_t * pv)
 {
   int U, V, Y;
-  uint8_t * py_1, * py_2, * pu, * pv;
   uint8_t * r, * g, * b;
-  uint8_t * dst_1, * dst_2;
-  int width, height, dst_height;
-  int dy;
+  int width;
 
-  if (this->do_scale) {
+  for (width = this->dest_width >> 3; width > 0; width--) {
+    X_RGB(0);
+    DST1(0);
 
-    scale_line_func_t scale_line = this->scale_line;
+    X_RGB(1);
+    DST1(1);
 
-    scale_line (_pu, this->u_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_pv, this->v_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_py, this->y_buffer,
-		this->dest_width, this->step_dx);
+    X_RGB(2);
+    DST1(2);
 
-    dy = 0;
-    dst_height = this->next_slice (this, &_dst);
+    X_RGB(3);
+    DST1(3);
 
-    for (height = 0;; ) {
-      dst_1 = _dst;
-      py_1  = this->y_buffer;
-      pu    = this->u_buffer;
-      pv    = this->v_buffer;
+    pu += 4;
+    pv += 4;
+    py_1 += 8;
+    dst_1 += 8;
+  }
+}
 
-      width = this->dest_width >> 3;
+static void yuv2rgb_row_c_gray (yuv2rgb_t *this, uint8_t * dst_1,
+				uint8_t * py_1, uint8_t * pu, uint8_t * pv)
+{
+  xine_fast_memcpy (dst_1, py_1, this->dest_width);
+}
 
-      do {
-	  X_RGB(0);
-	  DST1RGB(0);
+static void yuv2rgb_row_c_palette (yuv2rgb_t *this, uint8_t * dst_1,
+				   uint8_t * py_1, uint8_t * pu, uint8_t * pv)
+{
+  int U, V, Y;
+  uint16_t * r, * g, * b;
+  int width;
 
-	  X_RGB(1);
-	  DST1RGB(1);
+  for (width = this->dest_width >> 3; width > 0; width--) {
+    X_RGB(0);
+    DST1CMAP(0);
 
-	  X_RGB(2);
-	  DST1RGB(2);
+    X_RGB(1);
+    DST1CMAP(1);
 
-	  X_RGB(3);
-	  DST1RGB(3);
+    X_RGB(2);
+    DST1CMAP(2);
 
-	  pu += 4;
-	  pv += 4;
-	  py_1 += 8;
-	  dst_1 += 24;
-      } while (--width);
+    X_RGB(3);
+    DST1CMAP(3);
 
-      dy += this->step_dy;
-      _dst += this->rgb_stride;
+    pu += 4;
+    pv += 4;
+    py_1 += 8;
+    dst_1 += 8;
+  }
+}
 
-      while (--dst_height > 0 && dy < 32768) {
+static void yuv2rgb_c_32 (yuv2rgb_t *this, uint8_t * _dst,
+			  uint8_t * _py, uint8_t * _pu, uint8_t * _pv)
+{
+  int U, V, Y;
+  uint8_t  * py_1, * py_2, * pu, * pv;
+  uint32_t * r, * g, * b;
+  uint32_t * dst_1, * dst_2;
+  int width, height;
 
-	xine_fast_memcpy (_dst, _dst-this->rgb_stride, this->dest_width*3);
+  height = this->next_slice (this, &_dst) >> 1;
+  do {
+    dst_1 = (uint32_t*)_dst;
+    dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
+    py_1 = _py;
+    py_2 = _py + this->y_stride;
+    pu   = _pu;
+    pv   = _pv;
 
-	dy += this->step_dy;
-	_dst += this->rgb_stride;
-      }
+    width = this->source_width >> 3;
+    do {
+      X_RGB(0);
+      DST1(0);
+      DST2(0);
 
-      if (dst_height <= 0)
-	break;
+      X_RGB(1);
+      DST2(1);
+      DST1(1);
 
-      do {
-          dy -= 32768;
-          _py += this->y_stride;
+      X_RGB(2);
+      DST1(2);
+      DST2(2);
 
-          scale_line (_py, this->y_buffer,
-                      this->dest_width, this->step_dx);
+      X_RGB(3);
+      DST2(3);
+      DST1(3);
 
-          if (height & 1) {
-              _pu += this->uv_stride;
-              _pv += this->uv_stride;
+      pu += 4;
+      pv += 4;
+      py_1 += 8;
+      py_2 += 8;
+      dst_1 += 8;
+      dst_2 += 8;
+    } while (--width);
 
-              scale_line (_pu, this->u_buffer,
-                          this->dest_width >> 1, this->step_dx);
-              scale_line (_pv, this->v_buffer,
-                          this->dest_width >> 1, this->step_dx);
+    _dst += 2 * this->rgb_stride;
+    _py += 2 * this->y_stride;
+    _pu += this->uv_stride;
+    _pv += this->uv_stride;
 
-          }
-          height++;
-      } while (dy>=32768);
-    }
-  } else {
-    height = this->next_slice (this, &_dst) >> 1;
-    do {
-      dst_1 = _dst;
-      dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
-      py_1  = _py;
-      py_2  = _py + this->y_stride;
-      pu    = _pu;
-      pv    = _pv;
-
-      width = this->source_width >> 3;
-      do {
-	X_RGB(0);
-	DST1RGB(0);
-	DST2RGB(0);
-
-	X_RGB(1);
-	DST2RGB(1);
-	DST1RGB(1);
-
-	X_RGB(2);
-	DST1RGB(2);
-	DST2RGB(2);
-
-	X_RGB(3);
-	DST2RGB(3);
-	DST1RGB(3);
-
-	pu += 4;
-	pv += 4;
-	py_1 += 8;
-	py_2 += 8;
-	dst_1 += 24;
-	dst_2 += 24;
-      } while (--width);
-
-      _dst += 2 * this->rgb_stride;
-      _py += 2 * this->y_stride;
-      _pu += this->uv_stride;
-      _pv += this->uv_stride;
-
-    } while (--height);
-  }
+  } while (--height);
 }
 
-/* only trivial mods from yuv2rgb_c_24_rgb */
-static void yuv2rgb_c_24_bgr (yuv2rgb_t *this, uint8_t * _dst,
+/* This is very near from the yuv2rgb_c_32 code */
+static void yuv2rgb_c_24_rgb (yuv2rgb_t *this, uint8_t * _dst,
 			      uint8_t * _py, uint8_t * _pu, uint8_t * _pv)
 {
   int U, V, Y;
   uint8_t * py_1, * py_2, * pu, * pv;
   uint8_t * r, * g, * b;
   uint8_t * dst_1, * dst_2;
-  int width, height, dst_height;
-  int dy;
-
-  if (this->do_scale) {
-
-    scale_line_func_t scale_line = this->scale_line;
-
-    scale_line (_pu, this->u_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_pv, this->v_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_py, this->y_buffer,
-		this->dest_width, this->step_dx);
-
-    dy = 0;
-    dst_height = this->next_slice (this, &_dst);
-
-    for (height = 0;; ) {
-      dst_1 = _dst;
-      py_1  = this->y_buffer;
-      pu    = this->u_buffer;
-      pv    = this->v_buffer;
-
-      width = this->dest_width >> 3;
+  int width, height;
 
-      do {
-	  X_RGB(0);
-	  DST1BGR(0);
+  height = this->next_slice (this, &_dst) >> 1;
+  do {
+    dst_1 = _dst;
+    dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
+    py_1  = _py;
+    py_2  = _py + this->y_stride;
+    pu    = _pu;
+    pv    = _pv;
 
-	  X_RGB(1);
-	  DST1BGR(1);
+    width = this->source_width >> 3;
+    do {
+      X_RGB(0);
+      DST1RGB(0);
+      DST2RGB(0);
 
-	  X_RGB(2);
-	  DST1BGR(2);
+      X_RGB(1);
+      DST2RGB(1);
+      DST1RGB(1);
 
-	  X_RGB(3);
-	  DST1BGR(3);
+      X_RGB(2);
+      DST1RGB(2);
+      DST2RGB(2);
 
-	  pu += 4;
-	  pv += 4;
-	  py_1 += 8;
-	  dst_1 += 24;
-      } while (--width);
+      X_RGB(3);
+      DST2RGB(3);
+      DST1RGB(3);
 
-      dy += this->step_dy;
-      _dst += this->rgb_stride;
+      pu += 4;
+      pv += 4;
+      py_1 += 8;
+      py_2 += 8;
+      dst_1 += 24;
+      dst_2 += 24;
+    } while (--width);
 
-      while (--dst_height > 0 && dy < 32768) {
+    _dst += 2 * this->rgb_stride;
+    _py += 2 * this->y_stride;
+    _pu += this->uv_stride;
+    _pv += this->uv_stride;
 
-	xine_fast_memcpy (_dst, _dst-this->rgb_stride, this->dest_width*3);
+  } while (--height);
+}
 
-	dy += this->step_dy;
-	_dst += this->rgb_stride;
-      }
+/* only trivial mods from yuv2rgb_c_24_rgb */
+static void yuv2rgb_c_24_bgr (yuv2rgb_t *this, uint8_t * _dst,
+			      uint8_t * _py, uint8_t * _pu, uint8_t * _pv)
+{
+  int U, V, Y;
+  uint8_t * py_1, * py_2, * pu, * pv;
+  uint8_t * r, * g, * b;
+  uint8_t * dst_1, * dst_2;
+  int width, height;
 
-      if (dst_height <= 0)
-	break;
+  height = this->next_slice (this, &_dst) >> 1;
+  do {
+    dst_1 = _dst;
+    dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
+    py_1 = _py;
+    py_2 = _py + this->y_stride;
+    pu   = _pu;
+    pv   = _pv;
+    width = this->source_width >> 3;
+    do {
+      X_RGB(0);
+      DST1BGR(0);
+      DST2BGR(0);
 
-      do {
-          dy -= 32768;
-          _py += this->y_stride;
+      X_RGB(1);
+      DST2BGR(1);
+      DST1BGR(1);
 
-          scale_line (_py, this->y_buffer,
-                      this->dest_width, this->step_dx);
+      X_RGB(2);
+      DST1BGR(2);
+      DST2BGR(2);
 
-          if (height & 1) {
-              _pu += this->uv_stride;
-              _pv += this->uv_stride;
+      X_RGB(3);
+      DST2BGR(3);
+      DST1BGR(3);
 
-              scale_line (_pu, this->u_buffer,
-                          this->dest_width >> 1, this->step_dx);
-              scale_line (_pv, this->v_buffer,
-                          this->dest_width >> 1, this->step_dx);
+      pu += 4;
+      pv += 4;
+      py_1 += 8;
+      py_2 += 8;
+      dst_1 += 24;
+      dst_2 += 24;
+    } while (--width);
 
-          }
-          height++;
-      } while( dy>=32768 );
-    }
+    _dst += 2 * this->rgb_stride;
+    _py += 2 * this->y_stride;
+    _pu += this->uv_stride;
+    _pv += this->uv_stride;
 
-  } else {
-    height = this->next_slice (this, &_dst) >> 1;
-    do {
-      dst_1 = _dst;
-      dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
-      py_1 = _py;
-      py_2 = _py + this->y_stride;
-      pu   = _pu;
-      pv   = _pv;
-      width = this->source_width >> 3;
-      do {
-	X_RGB(0);
-	DST1BGR(0);
-	DST2BGR(0);
-
-	X_RGB(1);
-	DST2BGR(1);
-	DST1BGR(1);
-
-	X_RGB(2);
-	DST1BGR(2);
-	DST2BGR(2);
-
-	X_RGB(3);
-	DST2BGR(3);
-	DST1BGR(3);
-
-	pu += 4;
-	pv += 4;
-	py_1 += 8;
-	py_2 += 8;
-	dst_1 += 24;
-	dst_2 += 24;
-      } while (--width);
-
-      _dst += 2 * this->rgb_stride;
-      _py += 2 * this->y_stride;
-      _pu += this->uv_stride;
-      _pv += this->uv_stride;
-
-    } while (--height);
-  }
+  } while (--height);
 }
 
 /* This is exactly the same code as yuv2rgb_c_32 except for the types of */
@@ -1854,125 +1140,48 @@ static void yuv2rgb_c_16 (yuv2rgb_t *this, uint8_t * _dst,
   uint8_t * py_1, * py_2, * pu, * pv;
   uint16_t * r, * g, * b;
   uint16_t * dst_1, * dst_2;
-  int width, height, dst_height;
-  int dy;
-
-  if (this->do_scale) {
-    scale_line_func_t scale_line = this->scale_line;
-
-    scale_line (_pu, this->u_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_pv, this->v_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_py, this->y_buffer,
-		this->dest_width, this->step_dx);
-
-    dy = 0;
-    dst_height = this->next_slice (this, &_dst);
-
-    for (height = 0;; ) {
-      dst_1 = (uint16_t*)_dst;
-      py_1  = this->y_buffer;
-      pu    = this->u_buffer;
-      pv    = this->v_buffer;
-
-      width = this->dest_width >> 3;
-
-      do {
-	  X_RGB(0);
-	  DST1(0);
-
-	  X_RGB(1);
-	  DST1(1);
-
-	  X_RGB(2);
-	  DST1(2);
-
-	  X_RGB(3);
-	  DST1(3);
-
-	  pu += 4;
-	  pv += 4;
-	  py_1 += 8;
-	  dst_1 += 8;
-      } while (--width);
-
-      dy += this->step_dy;
-      _dst += this->rgb_stride;
-
-      while (--dst_height > 0 && dy < 32768) {
-
-	xine_fast_memcpy (_dst, (uint8_t*)_dst-this->rgb_stride, this->dest_width*2);
+  int width, height;
 
-	dy += this->step_dy;
-	_dst += this->rgb_stride;
-      }
+  height = this->next_slice (this, &_dst) >> 1;
+  do {
+    dst_1 = (uint16_t*)_dst;
+    dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
+    py_1 = _py;
+    py_2 = _py + this->y_stride;
+    pu   = _pu;
+    pv   = _pv;
+    width = this->source_width >> 3;
+    do {
+      X_RGB(0);
+      DST1(0);
+      DST2(0);
 
-      if (dst_height <= 0)
-	break;
+      X_RGB(1);
+      DST2(1);
+      DST1(1);
 
-      do {
-          dy -= 32768;
-          _py += this->y_stride;
+      X_RGB(2);
+      DST1(2);
+      DST2(2);
 
-          scale_line (_py, this->y_buffer,
-                      this->dest_width, this->step_dx);
+      X_RGB(3);
+      DST2(3);
+      DST1(3);
 
-          if (height & 1) {
-              _pu += this->uv_stride;
-              _pv += this->uv_stride;
+      pu += 4;
+      pv += 4;
+      py_1 += 8;
+      py_2 += 8;
+      dst_1 += 8;
+      dst_2 += 8;
+    } while (--width);
 
-              scale_line (_pu, this->u_buffer,
-                          this->dest_width >> 1, this->step_dx);
-              scale_line (_pv, this->v_buffer,
-                          this->dest_width >> 1, this->step_dx);
+    _dst += 2 * this->rgb_stride;
+    _py += 2 * this->y_stride;
+    _pu += this->uv_stride;
+    _pv += this->uv_stride;
 
-          }
-          height++;
-      } while( dy>=32768);
-    }
-  } else {
-    height = this->next_slice (this, &_dst) >> 1;
-    do {
-      dst_1 = (uint16_t*)_dst;
-      dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
-      py_1 = _py;
-      py_2 = _py + this->y_stride;
-      pu   = _pu;
-      pv   = _pv;
-      width = this->source_width >> 3;
-      do {
-	X_RGB(0);
-	DST1(0);
-	DST2(0);
-
-	X_RGB(1);
-	DST2(1);
-	DST1(1);
-
-	X_RGB(2);
-	DST1(2);
-	DST2(2);
-
-	X_RGB(3);
-	DST2(3);
-	DST1(3);
-
-	pu += 4;
-	pv += 4;
-	py_1 += 8;
-	py_2 += 8;
-	dst_1 += 8;
-	dst_2 += 8;
-      } while (--width);
-
-      _dst += 2 * this->rgb_stride;
-      _py += 2 * this->y_stride;
-      _pu += this->uv_stride;
-      _pv += this->uv_stride;
-
-    } while (--height);
-  }
+  } while (--height);
 }
 
 /* This is exactly the same code as yuv2rgb_c_32 except for the types of */
@@ -1984,170 +1193,61 @@ static void yuv2rgb_c_8 (yuv2rgb_t *this, uint8_t * _dst,
   uint8_t  * py_1, * py_2, * pu, * pv;
   uint8_t * r, * g, * b;
   uint8_t * dst_1, * dst_2;
-  int width, height, dst_height;
-  int dy;
-
-  if (this->do_scale) {
-    scale_line_func_t scale_line = this->scale_line;
-
-    scale_line (_pu, this->u_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_pv, this->v_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_py, this->y_buffer,
-		this->dest_width, this->step_dx);
-
-    dy = 0;
-    dst_height = this->next_slice (this, &_dst);
-
-    for (height = 0;; ) {
-      dst_1 = (uint8_t*)_dst;
-      py_1  = this->y_buffer;
-      pu    = this->u_buffer;
-      pv    = this->v_buffer;
-
-      width = this->dest_width >> 3;
-
-      do {
-	  X_RGB(0);
-	  DST1(0);
-
-	  X_RGB(1);
-	  DST1(1);
-
-	  X_RGB(2);
-	  DST1(2);
-
-	  X_RGB(3);
-	  DST1(3);
-
-	  pu += 4;
-	  pv += 4;
-	  py_1 += 8;
-	  dst_1 += 8;
-      } while (--width);
-
-      dy += this->step_dy;
-      _dst += this->rgb_stride;
+  int width, height;
 
-      while (--dst_height > 0 && dy < 32768) {
+  height = this->next_slice (this, &_dst) >> 1;
+  do {
+    dst_1 = (uint8_t*)_dst;
+    dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
+    py_1 = _py;
+    py_2 = _py + this->y_stride;
+    pu   = _pu;
+    pv   = _pv;
 
-	xine_fast_memcpy (_dst, (uint8_t*)_dst-this->rgb_stride, this->dest_width);
-
-	dy += this->step_dy;
-	_dst += this->rgb_stride;
-      }
+    width = this->source_width >> 3;
+    do {
+      X_RGB(0);
+      DST1(0);
+      DST2(0);
 
-      if (dst_height <= 0)
-	break;
+      X_RGB(1);
+      DST2(1);
+      DST1(1);
 
-      do {
-          dy -= 32768;
-          _py += this->y_stride;
+      X_RGB(2);
+      DST1(2);
+      DST2(2);
 
-          scale_line (_py, this->y_buffer,
-                      this->dest_width, this->step_dx);
+      X_RGB(3);
+      DST2(3);
+      DST1(3);
 
-          if (height & 1) {
-              _pu += this->uv_stride;
-              _pv += this->uv_stride;
+      pu += 4;
+      pv += 4;
+      py_1 += 8;
+      py_2 += 8;
+      dst_1 += 8;
+      dst_2 += 8;
+    } while (--width);
 
-              scale_line (_pu, this->u_buffer,
-                          this->dest_width >> 1, this->step_dx);
-              scale_line (_pv, this->v_buffer,
-                          this->dest_width >> 1, this->step_dx);
+    _dst += 2 * this->rgb_stride;
+    _py += 2 * this->y_stride;
+    _pu += this->uv_stride;
+    _pv += this->uv_stride;
 
-          }
-          height++;
-      } while( dy>=32768 );
-    }
-  } else {
-    height = this->next_slice (this, &_dst) >> 1;
-    do {
-      dst_1 = (uint8_t*)_dst;
-      dst_2 = (void*)( (uint8_t *)_dst + this->rgb_stride );
-      py_1 = _py;
-      py_2 = _py + this->y_stride;
-      pu   = _pu;
-      pv   = _pv;
-
-      width = this->source_width >> 3;
-      do {
-	X_RGB(0);
-	DST1(0);
-	DST2(0);
-
-	X_RGB(1);
-	DST2(1);
-	DST1(1);
-
-	X_RGB(2);
-	DST1(2);
-	DST2(2);
-
-	X_RGB(3);
-	DST2(3);
-	DST1(3);
-
-	pu += 4;
-	pv += 4;
-	py_1 += 8;
-	py_2 += 8;
-	dst_1 += 8;
-	dst_2 += 8;
-      } while (--width);
-
-      _dst += 2 * this->rgb_stride;
-      _py += 2 * this->y_stride;
-      _pu += this->uv_stride;
-      _pv += this->uv_stride;
-
-    } while (--height);
-  }
+  } while (--height);
 }
 
 /* now for something different: 256 grayscale mode */
 static void yuv2rgb_c_gray (yuv2rgb_t *this, uint8_t * _dst,
 			    uint8_t * _py, uint8_t * _pu, uint8_t * _pv)
 {
-  int height, dst_height;
-  int dy;
-
-  if (this->do_scale) {
-    scale_line_func_t scale_line = this->scale_line;
-
-    dy = 0;
-    dst_height = this->next_slice (this, &_dst);
-
-    for (;;) {
-      scale_line (_py, _dst, this->dest_width, this->step_dx);
-
-      dy += this->step_dy;
-      _dst += this->rgb_stride;
+  int height;
 
-      while (--dst_height > 0 && dy < 32768) {
-
-	xine_fast_memcpy (_dst, (uint8_t*)_dst-this->rgb_stride, this->dest_width);
-
-	dy += this->step_dy;
-	_dst += this->rgb_stride;
-      }
-
-      if (dst_height <= 0)
-	break;
-
-      _py += this->y_stride*(dy>>15);
-      dy &= 32767;
-      /* dy -= 32768;
-	 _py += this->y_stride;
-      */
-    }
-  } else {
-    for (height = this->next_slice (this, &_dst); --height >= 0; ) {
-      xine_fast_memcpy(_dst, _py, this->dest_width);
-      _dst += this->rgb_stride;
-      _py += this->y_stride;
-    }
+  for (height = this->next_slice (this, &_dst); --height >= 0; ) {
+    xine_fast_memcpy(_dst, _py, this->dest_width);
+    _dst += this->rgb_stride;
+    _py += this->y_stride;
   }
 }
 
@@ -2159,125 +1259,48 @@ static void yuv2rgb_c_palette (yuv2rgb_t *this, uint8_t * _dst,
   uint8_t * py_1, * py_2, * pu, * pv;
   uint16_t * r, * g, * b;
   uint8_t * dst_1, * dst_2;
-  int width, height, dst_height;
-  int dy;
-
-  if (this->do_scale) {
-    scale_line_func_t scale_line = this->scale_line;
-
-    scale_line (_pu, this->u_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_pv, this->v_buffer,
-		this->dest_width >> 1, this->step_dx);
-    scale_line (_py, this->y_buffer,
-		this->dest_width, this->step_dx);
-
-    dy = 0;
-    dst_height = this->next_slice (this, &_dst);
-
-    for (height = 0;; ) {
-      dst_1 = _dst;
-      py_1  = this->y_buffer;
-      pu    = this->u_buffer;
-      pv    = this->v_buffer;
-
-      width = this->dest_width >> 3;
-
-      do {
-	  X_RGB(0);
-	  DST1CMAP(0);
-
-	  X_RGB(1);
-	  DST1CMAP(1);
-
-	  X_RGB(2);
-	  DST1CMAP(2);
-
-	  X_RGB(3);
-	  DST1CMAP(3);
-
-	  pu += 4;
-	  pv += 4;
-	  py_1 += 8;
-	  dst_1 += 8;
-      } while (--width);
-
-      dy += this->step_dy;
-      _dst += this->rgb_stride;
-
-      while (--dst_height > 0 && dy < 32768) {
-
-	xine_fast_memcpy (_dst, (uint8_t*)_dst-this->rgb_stride, this->dest_width);
+  int width, height;
 
-	dy += this->step_dy;
-	_dst += this->rgb_stride;
-      }
+  height = this->next_slice (this, &_dst) >> 1;
+  do {
+    dst_1 = _dst;
+    dst_2 = _dst + this->rgb_stride;
+    py_1 = _py;
+    py_2 = _py + this->y_stride;
+    pu   = _pu;
+    pv   = _pv;
+    width = this->source_width >> 3;
+    do {
+      X_RGB(0);
+      DST1CMAP(0);
+      DST2CMAP(0);
 
-      if (dst_height <= 0)
-	break;
+      X_RGB(1);
+      DST2CMAP(1);
+      DST1CMAP(1);
 
-      do {
-          dy -= 32768;
-          _py += this->y_stride;
+      X_RGB(2);
+      DST1CMAP(2);
+      DST2CMAP(2);
 
-          scale_line (_py, this->y_buffer,
-                      this->dest_width, this->step_dx);
+      X_RGB(3);
+      DST2CMAP(3);
+      DST1CMAP(3);
 
-          if (height & 1) {
-              _pu += this->uv_stride;
-              _pv += this->uv_stride;
+      pu += 4;
+      pv += 4;
+      py_1 += 8;
+      py_2 += 8;
+      dst_1 += 8;
+      dst_2 += 8;
+    } while (--width);
 
-              scale_line (_pu, this->u_buffer,
-                          this->dest_width >> 1, this->step_dx);
-              scale_line (_pv, this->v_buffer,
-                          this->dest_width >> 1, this->step_dx);
+    _dst += 2 * this->rgb_stride;
+    _py += 2 * this->y_stride;
+    _pu += this->uv_stride;
+    _pv += this->uv_stride;
 
-          }
-          height++;
-      } while( dy>=32768 );
-    }
-  } else {
-    height = this->next_slice (this, &_dst) >> 1;
-    do {
-      dst_1 = _dst;
-      dst_2 = _dst + this->rgb_stride;
-      py_1 = _py;
-      py_2 = _py + this->y_stride;
-      pu   = _pu;
-      pv   = _pv;
-      width = this->source_width >> 3;
-      do {
-	X_RGB(0);
-	DST1CMAP(0);
-	DST2CMAP(0);
-
-	X_RGB(1);
-	DST2CMAP(1);
-	DST1CMAP(1);
-
-	X_RGB(2);
-	DST1CMAP(2);
-	DST2CMAP(2);
-
-	X_RGB(3);
-	DST2CMAP(3);
-	DST1CMAP(3);
-
-	pu += 4;
-	pv += 4;
-	py_1 += 8;
-	py_2 += 8;
-	dst_1 += 8;
-	dst_2 += 8;
-      } while (--width);
-
-      _dst += 2 * this->rgb_stride;
-      _py += 2 * this->y_stride;
-      _pu += this->uv_stride;
-      _pv += this->uv_stride;
-
-    } while (--height);
-  }
+  } while (--height);
 }
 
 static int div_round (int dividend, int divisor)
@@ -2587,14 +1610,18 @@ static void yuv2rgb_c_init (yuv2rgb_factory_t *this)
   case MODE_32_RGB:
   case MODE_32_BGR:
     this->yuv2rgb_fun = yuv2rgb_c_32;
+    this->yuv2rgb_row_fun = yuv2rgb_row_c_32;
     break;
 
   case MODE_24_RGB:
   case MODE_24_BGR:
-    this->yuv2rgb_fun =
-	(this->mode==MODE_24_RGB && !this->swapped) || (this->mode==MODE_24_BGR && this->swapped)
-	    ? yuv2rgb_c_24_rgb
-	    : yuv2rgb_c_24_bgr;
+    if ((this->mode==MODE_24_RGB && !this->swapped) || (this->mode==MODE_24_BGR && this->swapped)) {
+      this->yuv2rgb_fun = yuv2rgb_c_24_rgb;
+      this->yuv2rgb_row_fun = yuv2rgb_row_c_24_rgb;
+    } else {
+      this->yuv2rgb_fun = yuv2rgb_c_24_bgr;
+      this->yuv2rgb_row_fun = yuv2rgb_row_c_24_bgr;
+    }
     break;
 
   case MODE_15_BGR:
@@ -2602,19 +1629,23 @@ static void yuv2rgb_c_init (yuv2rgb_factory_t *this)
   case MODE_15_RGB:
   case MODE_16_RGB:
     this->yuv2rgb_fun = yuv2rgb_c_16;
+    this->yuv2rgb_row_fun = yuv2rgb_row_c_16;
     break;
 
   case MODE_8_RGB:
   case MODE_8_BGR:
     this->yuv2rgb_fun = yuv2rgb_c_8;
+    this->yuv2rgb_row_fun = yuv2rgb_row_c_8;
     break;
 
   case MODE_8_GRAY:
     this->yuv2rgb_fun = yuv2rgb_c_gray;
+    this->yuv2rgb_row_fun = yuv2rgb_row_c_gray;
     break;
 
   case MODE_PALETTE:
     this->yuv2rgb_fun = yuv2rgb_c_palette;
+    this->yuv2rgb_row_fun = yuv2rgb_row_c_palette;
     break;
 
   default:
@@ -3230,13 +2261,36 @@ static yuv2rgb_t *yuv2rgb_create_converter (yuv2rgb_factory_t *factory) {
   this->table_bU                 = factory->table_bU;
   this->table_mmx                = factory->table_mmx;
 
+  this->factory                  = factory;
   this->yuv2rgb_fun              = factory->yuv2rgb_fun;
+  this->row_fun                  = factory->yuv2rgb_row_fun;
   this->yuy22rgb_fun             = factory->yuy22rgb_fun;
   this->yuv2rgb_single_pixel_fun = factory->yuv2rgb_single_pixel_fun;
 
   this->configure                = yuv2rgb_configure;
   this->next_slice               = yuv2rgb_next_slice;
   this->dispose                  = yuv2rgb_dispose;
+
+  switch (factory->mode) {
+  case MODE_32_RGB:
+  case MODE_32_BGR:
+    this->bytes_per_pixel = 4;
+    break;
+  case MODE_24_RGB:
+  case MODE_24_BGR:
+    this->bytes_per_pixel = 3;
+    break;
+  case MODE_15_BGR:
+  case MODE_16_BGR:
+  case MODE_15_RGB:
+  case MODE_16_RGB:
+    this->bytes_per_pixel = 2;
+    break;
+  default:
+    this->bytes_per_pixel = 1;
+  }
+  this->scale_filter = -1;
+
   return this;
 }
 
@@ -3246,6 +2300,14 @@ static yuv2rgb_t *yuv2rgb_create_converter (yuv2rgb_factory_t *factory) {
 
 static void yuv2rgb_factory_dispose (yuv2rgb_factory_t *this) {
 
+  pthread_mutex_lock (&pool_lock);
+  if (!--pool_refs) {
+    xine_worker_pool_delete (pool_shared);
+    pool_shared = NULL;
+  }
+  pthread_mutex_unlock (&pool_lock);
+
+
   free (this->table_base);
   av_free(this->table_mmx);
   free (this);
@@ -3267,7 +2329,15 @@ yuv2rgb_factory_t* yuv2rgb_factory_init (int mode, int swapped,
   this->dispose             = yuv2rgb_factory_dispose;
   this->table_base          = NULL;
   this->table_mmx           = NULL;
+  this->scale_filter        = SCALE_BILINEAR;
+  this->scale_line_fun      = scale_line_filter_c;
+  this->blend_lines_fun     = blend_lines_c;
 
+  pthread_mutex_lock (&pool_lock);
+  if (!pool_refs++)
+    pool_shared = xine_worker_pool_new (0);
+  this->pool = pool_shared;
+  pthread_mutex_unlock (&pool_lock);
 
   yuv2rgb_set_csc_levels (this, 0, 128, 128, CM_DEFAULT);
 
@@ -3276,7 +2346,13 @@ yuv2rgb_factory_t* yuv2rgb_factory_init (int mode, int swapped,
    */
 
   this->yuv2rgb_fun = NULL;
+  this->yuv2rgb_row_fun = NULL;
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
+  if (mm & MM_ACCEL_X86_SSE2) {
+    this->scale_line_fun  = scale_line_filter_sse2;
+    this->blend_lines_fun = blend_lines_sse2;
+  }
+
   if ((this->yuv2rgb_fun == NULL) && (mm & MM_ACCEL_X86_MMXEXT)) {
 
     yuv2rgb_init_mmxext (this);
@@ -3329,3 +2405,36 @@ yuv2rgb_factory_t* yuv2rgb_factory_init (int mode, int swapped,
 
   return this;
 }
+
+/*
+ * software scaler setting, shared by the drivers using yuv2rgb
+ */
+
+static const char * const scaler_labels[] = {
+  "bilinear", "bicubic", NULL
+};
+
+static void yuv2rgb_scaler_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  yuv2rgb_factory_t *this = (yuv2rgb_factory_t *) this_gen;
+
+  /* converters pick this up with their next frame */
+  this->scale_filter = entry->num_value;
+}
+
+void yuv2rgb_register_scaler_config (yuv2rgb_factory_t *this, config_values_t *config) {
+
+  this->scale_filter =
+    config->register_enum (config, "video.output.software_scaler", SCALE_BILINEAR,
+                           (char **)scaler_labels,
+                           _("Software scaling filter"),
+                           _("How the image is resized when the video driver has to scale in software.\n\n"
+                             "bilinear: fast, slightly soft.\n"
+                             "bicubic:  sharper, needs more CPU time.\n"),
+                           10, yuv2rgb_scaler_cb, this);
+}
+
+void yuv2rgb_unregister_scaler_config (yuv2rgb_factory_t *this, config_values_t *config) {
+
+  (void)this;
+  config->unregister_callback (config, "video.output.software_scaler");
+}
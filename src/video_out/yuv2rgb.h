@@ -9,6 +9,9 @@
 #endif
 
 #include <inttypes.h>
+#include <xine/attributes.h>
+#include <xine/worker_pool.h>
+#include <xine/configfile.h>
 
 typedef struct yuv2rgb_s yuv2rgb_t;
 
@@ -19,11 +22,11 @@ typedef struct yuv2rgb_factory_s yuv2rgb_factory_t;
  * by hardware-accelerated versions
  */
 
-/* internal function use to scale yuv data */
-typedef void (*scale_line_func_t) (uint8_t *source, uint8_t *dest, int width, int step);
-
 typedef void (*yuv2rgb_fun_t) (yuv2rgb_t *this, uint8_t * image, uint8_t * py, uint8_t * pu, uint8_t * pv) ;
 
+/* converts one line of dest_width pixels, used for scaled output */
+typedef void (*yuv2rgb_row_fun_t) (yuv2rgb_t *this, uint8_t * image, uint8_t * py, uint8_t * pu, uint8_t * pv) ;
+
 typedef void (*yuy22rgb_fun_t) (yuv2rgb_t *this, uint8_t * image, uint8_t * p);
 
 typedef uint32_t (*yuv2rgb_single_pixel_fun_t) (yuv2rgb_t *this, uint8_t y, uint8_t u, uint8_t v);
@@ -54,6 +57,29 @@ typedef uint32_t (*yuv2rgb_single_pixel_fun_t) (yuv2rgb_t *this, uint8_t y, uint
 #define CM_HD         2
 #define CM_FULLRANGE  1
 
+/* filters for scaled output, see yuv2rgb_factory_t.scale_filter */
+#define SCALE_BILINEAR 0
+#define SCALE_BICUBIC  1
+
+/*
+ * filter table for scaling one line: for each output pixel the first
+ * source pixel and taps weights summing up to 1 << 14.  Weights are
+ * stored in groups of 8 pixels, first taps 0/1 of all 8, then taps 2/3.
+ */
+typedef struct {
+  int               width;      /* output pixels, multiple of 8 */
+  int               taps;       /* 2 or 4 */
+  int32_t          *pos;
+  int16_t          *coef;
+  void             *chunk;
+} yuv2rgb_filter_t;
+
+/* scales one line with a filter table */
+typedef void (*yuv2rgb_scale_fun_t) (const yuv2rgb_filter_t *f, uint8_t *source, uint8_t *dest);
+
+/* blends taps lines of width pixels with weights summing up to 1 << 14 */
+typedef void (*yuv2rgb_blend_fun_t) (uint8_t *dest, uint8_t **lines, const int *weights, int taps, int width);
+
 struct yuv2rgb_s {
   /*
    * configure converter for scaling factors
@@ -123,7 +149,18 @@ struct yuv2rgb_s {
   void             *table_mmx;
 
   uint8_t          *cmap;
-  scale_line_func_t scale_line;
+
+  /* scaled yv12 conversion runs in bands of lines on the factory's pool */
+  yuv2rgb_factory_t *factory;
+  yuv2rgb_row_fun_t row_fun;
+  int               bytes_per_pixel;
+  int               scale_filter;       /* filter the tables were made for */
+  yuv2rgb_filter_t  filter_y, filter_uv;
+  yuv2rgb_filter_t  filter_vy, filter_vuv; /* vertical, no taps when not scaled */
+  int               v_row;              /* next output line of a sliced frame */
+  uint8_t          *band_buffer;        /* line buffers, band_size per band */
+  void             *band_chunk;
+  int               band_size;
 } ;
 
 /*
@@ -145,6 +182,11 @@ struct yuv2rgb_factory_s {
    */
   void (*dispose) (yuv2rgb_factory_t *this);
 
+  /*
+   * SCALE_BILINEAR or SCALE_BICUBIC, may be changed at any time
+   */
+  int      scale_filter;
+
   /* private data */
 
   int      mode;
@@ -159,14 +201,26 @@ struct yuv2rgb_factory_s {
   void    *table_mmx_base;
   void    *table_mmx;
 
+  xine_worker_pool_t *pool;
+
   /* preselected functions for mode/swap/hardware */
+  yuv2rgb_scale_fun_t         scale_line_fun;
+  yuv2rgb_blend_fun_t         blend_lines_fun;
   yuv2rgb_fun_t               yuv2rgb_fun;
+  yuv2rgb_row_fun_t           yuv2rgb_row_fun;
   yuy22rgb_fun_t              yuy22rgb_fun;
   yuv2rgb_single_pixel_fun_t  yuv2rgb_single_pixel_fun;
 };
 
 yuv2rgb_factory_t *yuv2rgb_factory_init (int mode, int swapped, uint8_t *colormap);
 
+/*
+ * registers "video.output.software_scaler" and keeps scale_filter of
+ * the factory up to date. Unregister before disposing the factory.
+ */
+void yuv2rgb_register_scaler_config (yuv2rgb_factory_t *this, config_values_t *config);
+void yuv2rgb_unregister_scaler_config (yuv2rgb_factory_t *this, config_values_t *config);
+
 
 /*
  * internal stuff below this line
@@ -461,7 +461,7 @@ static inline void yuv420_rgb16 (yuv2rgb_t *this,
 				 uint8_t * py, uint8_t * pu, uint8_t * pv,
 				 int cpu)
 {
-    int i, height, dst_height;
+    int i, height;
     int rgb_stride = this->rgb_stride;
     int y_stride   = this->y_stride;
     int uv_stride  = this->uv_stride;
@@ -470,12 +470,11 @@ static inline void yuv420_rgb16 (yuv2rgb_t *this,
 
     width >>= 3;
 
-    if (!this->do_scale) {
-      height = this->next_slice (this, &image);
-      y_stride -= 8 * width;
-      uv_stride -= 4 * width;
+    height = this->next_slice (this, &image);
+    y_stride -= 8 * width;
+    uv_stride -= 4 * width;
 
-      do {
+    do {
 
 	i = width; img = image;
 	do {
@@ -496,76 +495,23 @@ static inline void yuv420_rgb16 (yuv2rgb_t *this,
 	  pu -= 4 * width;
 	  pv -= 4 * width;
 	}
-      } while (--height);
-
-    } else {
-
-      scale_line_func_t scale_line = this->scale_line;
-      uint8_t *y_buf, *u_buf, *v_buf;
-      int      dy = 0;
-
-      scale_line (pu, this->u_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (pv, this->v_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (py, this->y_buffer,
-		  this->dest_width, this->step_dx);
-
-      dst_height = this->next_slice (this, &image);
-
-      for (height = 0;; ) {
-
-	y_buf = this->y_buffer;
-	u_buf = this->u_buffer;
-	v_buf = this->v_buffer;
-
-	i = this->dest_width >> 3; img = image;
-	do {
-	  /* printf ("i : %d\n",i); */
-
-	  mmx_yuv2rgb (y_buf, u_buf, v_buf, this->table_mmx);
-	  mmx_unpack_16rgb (img, cpu);
-	  y_buf += 8;
-	  u_buf += 4;
-	  v_buf += 4;
-	  img += 16;
-	} while (--i);
-
-	dy += this->step_dy;
-	image += rgb_stride;
-
-	while (--dst_height > 0 && dy < 32768) {
-
-	  xine_fast_memcpy (image, image-rgb_stride, this->dest_width*2);
-
-	  dy += this->step_dy;
-	  image += rgb_stride;
-	}
-
-	if (dst_height <= 0)
-	  break;
-
-        do {
-            dy -= 32768;
-
-            py += y_stride;
-
-            scale_line (py, this->y_buffer,
-                        this->dest_width, this->step_dx);
-
-            if (height & 1) {
-                pu += uv_stride;
-                pv += uv_stride;
-
-                scale_line (pu, this->u_buffer,
-                            this->dest_width >> 1, this->step_dx);
-                scale_line (pv, this->v_buffer,
-                            this->dest_width >> 1, this->step_dx);
+    } while (--height);
+}
 
-            }
-            height++;
-        } while( dy>=32768);
-      }
+static inline void row_rgb16 (yuv2rgb_t *this,
+                              uint8_t * image,
+                              uint8_t * py, uint8_t * pu, uint8_t * pv,
+                              int cpu)
+{
+    int i = this->dest_width >> 3;
+
+    while (i--) {
+      mmx_yuv2rgb (py, pu, pv, this->table_mmx);
+      mmx_unpack_16rgb (image, cpu);
+      py += 8;
+      pu += 4;
+      pv += 4;
+      image += 16;
     }
 }
 
@@ -574,7 +520,7 @@ static inline void yuv420_rgb15 (yuv2rgb_t *this,
 				 uint8_t * py, uint8_t * pu, uint8_t * pv,
 				 int cpu)
 {
-    int i, height, dst_height;
+    int i, height;
     int rgb_stride = this->rgb_stride;
     int y_stride   = this->y_stride;
     int uv_stride  = this->uv_stride;
@@ -583,12 +529,11 @@ static inline void yuv420_rgb15 (yuv2rgb_t *this,
 
     width >>= 3;
 
-    if (!this->do_scale) {
-      height = this->next_slice (this, &image);
-      y_stride -= 8 * width;
-      uv_stride -= 4 * width;
+    height = this->next_slice (this, &image);
+    y_stride -= 8 * width;
+    uv_stride -= 4 * width;
 
-      do {
+    do {
 
 	i = width; img = image;
 	do {
@@ -609,75 +554,23 @@ static inline void yuv420_rgb15 (yuv2rgb_t *this,
 	  pu -= 4 * width;
 	  pv -= 4 * width;
 	}
-      } while (--height);
-
-    } else {
-
-      scale_line_func_t scale_line = this->scale_line;
-      uint8_t *y_buf, *u_buf, *v_buf;
-      int      dy = 0;
-
-      scale_line (pu, this->u_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (pv, this->v_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (py, this->y_buffer,
-		  this->dest_width, this->step_dx);
-
-      dst_height = this->next_slice (this, &image);
-
-      for (height = 0;; ) {
-
-	y_buf = this->y_buffer;
-	u_buf = this->u_buffer;
-	v_buf = this->v_buffer;
-
-	i = this->dest_width >> 3; img = image;
-	do {
-	  /* printf ("i : %d\n",i); */
-
-	  mmx_yuv2rgb (y_buf, u_buf, v_buf, this->table_mmx);
-	  mmx_unpack_15rgb (img, cpu);
-	  y_buf += 8;
-	  u_buf += 4;
-	  v_buf += 4;
-	  img += 16;
-	} while (--i);
-
-	dy += this->step_dy;
-	image += rgb_stride;
-
-	while (--dst_height > 0 && dy < 32768) {
-
-	  xine_fast_memcpy (image, image-rgb_stride, this->dest_width*2);
-
-	  dy += this->step_dy;
-	  image += rgb_stride;
-	}
-
-	if (dst_height <= 0)
-	  break;
-
-        do {
-            dy -= 32768;
-            py += y_stride;
-
-            scale_line (py, this->y_buffer,
-                        this->dest_width, this->step_dx);
-
-            if (height & 1) {
-                pu += uv_stride;
-                pv += uv_stride;
-
-                scale_line (pu, this->u_buffer,
-                            this->dest_width >> 1, this->step_dx);
-                scale_line (pv, this->v_buffer,
-                            this->dest_width >> 1, this->step_dx);
+    } while (--height);
+}
 
-            }
-            height++;
-        } while( dy>=32768 );
-      }
+static inline void row_rgb15 (yuv2rgb_t *this,
+                              uint8_t * image,
+                              uint8_t * py, uint8_t * pu, uint8_t * pv,
+                              int cpu)
+{
+    int i = this->dest_width >> 3;
+
+    while (i--) {
+      mmx_yuv2rgb (py, pu, pv, this->table_mmx);
+      mmx_unpack_15rgb (image, cpu);
+      py += 8;
+      pu += 4;
+      pv += 4;
+      image += 16;
     }
 }
 
@@ -685,7 +578,7 @@ static inline void yuv420_rgb24 (yuv2rgb_t *this,
 				 uint8_t * image, uint8_t * py,
 				 uint8_t * pu, uint8_t * pv, int cpu)
 {
-    int i, height, dst_height;
+    int i, height;
     int rgb_stride = this->rgb_stride;
     int y_stride   = this->y_stride;
     int uv_stride  = this->uv_stride;
@@ -695,12 +588,11 @@ static inline void yuv420_rgb24 (yuv2rgb_t *this,
     /* rgb_stride -= 4 * this->dest_width; */
     width >>= 3;
 
-    if (!this->do_scale) {
-      height = this->next_slice (this, &image);
-      y_stride -= 8 * width;
-      uv_stride -= 4 * width;
+    height = this->next_slice (this, &image);
+    y_stride -= 8 * width;
+    uv_stride -= 4 * width;
 
-      do {
+    do {
 	i = width; img = image;
 	do {
 	  mmx_yuv2rgb (py, pu, pv, this->table_mmx);
@@ -720,76 +612,23 @@ static inline void yuv420_rgb24 (yuv2rgb_t *this,
 	  pu -= 4 * width;
 	  pv -= 4 * width;
 	}
-      } while (--height);
-    } else {
-
-      scale_line_func_t scale_line = this->scale_line;
-      uint8_t *y_buf, *u_buf, *v_buf;
-      int      dy = 0;
-
-      scale_line (pu, this->u_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (pv, this->v_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (py, this->y_buffer,
-		  this->dest_width, this->step_dx);
-
-      dst_height = this->next_slice (this, &image);
-
-      for (height = 0;; ) {
-
-	y_buf = this->y_buffer;
-	u_buf = this->u_buffer;
-	v_buf = this->v_buffer;
-
-
-	i = this->dest_width >> 3; img=image;
-	do {
-	  /* printf ("i : %d\n",i); */
-
-	  mmx_yuv2rgb (y_buf, u_buf, v_buf, this->table_mmx);
-	  mmx_unpack_24rgb (img, cpu);
-	  y_buf += 8;
-	  u_buf += 4;
-	  v_buf += 4;
-	  img += 24;
-	} while (--i);
-
-	dy += this->step_dy;
-	image += rgb_stride;
-
-	while (--dst_height > 0 && dy < 32768) {
-
-	  xine_fast_memcpy (image, image-rgb_stride, this->dest_width*3);
-
-	  dy += this->step_dy;
-	  image += rgb_stride;
-	}
-
-	if (dst_height <= 0)
-	  break;
-
-        do {
-            dy -= 32768;
-            py += y_stride;
-
-            scale_line (py, this->y_buffer,
-                        this->dest_width, this->step_dx);
-
-            if (height & 1) {
-                pu += uv_stride;
-                pv += uv_stride;
-
-                scale_line (pu, this->u_buffer,
-                            this->dest_width >> 1, this->step_dx);
-                scale_line (pv, this->v_buffer,
-                            this->dest_width >> 1, this->step_dx);
-            }
-            height++;
-        } while( dy>=32768 );
-
-      }
+    } while (--height);
+}
 
+static inline void row_rgb24 (yuv2rgb_t *this,
+                              uint8_t * image,
+                              uint8_t * py, uint8_t * pu, uint8_t * pv,
+                              int cpu)
+{
+    int i = this->dest_width >> 3;
+
+    while (i--) {
+      mmx_yuv2rgb (py, pu, pv, this->table_mmx);
+      mmx_unpack_24rgb (image, cpu);
+      py += 8;
+      pu += 4;
+      pv += 4;
+      image += 24;
     }
 }
 
@@ -797,7 +636,7 @@ static inline void yuv420_argb32 (yuv2rgb_t *this,
 				  uint8_t * image, uint8_t * py,
 				  uint8_t * pu, uint8_t * pv, int cpu)
 {
-    int i, height, dst_height;
+    int i, height;
     int rgb_stride = this->rgb_stride;
     int y_stride   = this->y_stride;
     int uv_stride  = this->uv_stride;
@@ -807,12 +646,11 @@ static inline void yuv420_argb32 (yuv2rgb_t *this,
     /* rgb_stride -= 4 * this->dest_width; */
     width >>= 3;
 
-    if (!this->do_scale) {
-      height = this->next_slice (this, &image);
-      y_stride -= 8 * width;
-      uv_stride -= 4 * width;
+    height = this->next_slice (this, &image);
+    y_stride -= 8 * width;
+    uv_stride -= 4 * width;
 
-      do {
+    do {
 	i = width; img = image;
 	do {
 	  mmx_yuv2rgb (py, pu, pv, this->table_mmx);
@@ -832,75 +670,23 @@ static inline void yuv420_argb32 (yuv2rgb_t *this,
 	  pu -= 4 * width;
 	  pv -= 4 * width;
 	}
-      } while (--height);
-    } else {
-
-      scale_line_func_t scale_line = this->scale_line;
-      uint8_t *y_buf, *u_buf, *v_buf;
-      int      dy = 0;
-
-      scale_line (pu, this->u_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (pv, this->v_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (py, this->y_buffer,
-		  this->dest_width, this->step_dx);
-
-      dst_height = this->next_slice (this, &image);
-
-      for (height = 0;; ) {
-
-	y_buf = this->y_buffer;
-	u_buf = this->u_buffer;
-	v_buf = this->v_buffer;
-
-
-	i = this->dest_width >> 3; img=image;
-	do {
-	  /* printf ("i : %d\n",i); */
-
-	  mmx_yuv2rgb (y_buf, u_buf, v_buf, this->table_mmx);
-	  mmx_unpack_32rgb (img, cpu);
-	  y_buf += 8;
-	  u_buf += 4;
-	  v_buf += 4;
-	  img += 32;
-	} while (--i);
-
-	dy += this->step_dy;
-	image += rgb_stride;
-
-	while (--dst_height > 0 && dy < 32768) {
-
-	  xine_fast_memcpy (image, image-rgb_stride, this->dest_width*4);
-
-	  dy += this->step_dy;
-	  image += rgb_stride;
-	}
-
-	if (dst_height <= 0)
-	  break;
-
-        do {
-            dy -= 32768;
-            py += y_stride;
-
-            scale_line (py, this->y_buffer,
-                        this->dest_width, this->step_dx);
-
-            if (height & 1) {
-                pu += uv_stride;
-                pv += uv_stride;
-
-                scale_line (pu, this->u_buffer,
-                            this->dest_width >> 1, this->step_dx);
-                scale_line (pv, this->v_buffer,
-                            this->dest_width >> 1, this->step_dx);
-            }
-            height++;
-        } while( dy>=32768 );
-      }
+    } while (--height);
+}
 
+static inline void row_argb32 (yuv2rgb_t *this,
+                               uint8_t * image,
+                               uint8_t * py, uint8_t * pu, uint8_t * pv,
+                               int cpu)
+{
+    int i = this->dest_width >> 3;
+
+    while (i--) {
+      mmx_yuv2rgb (py, pu, pv, this->table_mmx);
+      mmx_unpack_32rgb (image, cpu);
+      py += 8;
+      pu += 4;
+      pv += 4;
+      image += 32;
     }
 }
 
@@ -908,7 +694,7 @@ static inline void yuv420_abgr32 (yuv2rgb_t *this,
 				  uint8_t * image, uint8_t * py,
 				  uint8_t * pu, uint8_t * pv, int cpu)
 {
-    int i, height, dst_height;
+    int i, height;
     int rgb_stride = this->rgb_stride;
     int y_stride   = this->y_stride;
     int uv_stride  = this->uv_stride;
@@ -918,12 +704,11 @@ static inline void yuv420_abgr32 (yuv2rgb_t *this,
     /* rgb_stride -= 4 * this->dest_width; */
     width >>= 3;
 
-    if (!this->do_scale) {
-      height = this->next_slice (this, &image);
-      y_stride -= 8 * width;
-      uv_stride -= 4 * width;
+    height = this->next_slice (this, &image);
+    y_stride -= 8 * width;
+    uv_stride -= 4 * width;
 
-      do {
+    do {
 	i = width; img = image;
 	do {
 	  mmx_yuv2rgb (py, pu, pv, this->table_mmx);
@@ -943,76 +728,23 @@ static inline void yuv420_abgr32 (yuv2rgb_t *this,
 	  pu -= 4 * width;
 	  pv -= 4 * width;
 	}
-      } while (--height);
-    } else {
-
-      scale_line_func_t scale_line = this->scale_line;
-      uint8_t *y_buf, *u_buf, *v_buf;
-      int      dy = 0;
-
-      scale_line (pu, this->u_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (pv, this->v_buffer,
-		  this->dest_width >> 1, this->step_dx);
-      scale_line (py, this->y_buffer,
-		  this->dest_width, this->step_dx);
-
-      dst_height = this->next_slice (this, &image);
-
-      for (height = 0;; ) {
-
-	y_buf = this->y_buffer;
-	u_buf = this->u_buffer;
-	v_buf = this->v_buffer;
-
-
-	i = this->dest_width >> 3; img=image;
-	do {
-	  /* printf ("i : %d\n",i); */
-
-	  mmx_yuv2rgb (y_buf, u_buf, v_buf, this->table_mmx);
-	  mmx_unpack_32bgr (img, cpu);
-	  y_buf += 8;
-	  u_buf += 4;
-	  v_buf += 4;
-	  img += 32;
-	} while (--i);
-
-	dy += this->step_dy;
-	image += rgb_stride;
-
-	while (--dst_height > 0 && dy < 32768) {
-
-	  xine_fast_memcpy (image, image-rgb_stride, this->dest_width*4);
-
-	  dy += this->step_dy;
-	  image += rgb_stride;
-	}
-
-	if (dst_height <= 0)
-	  break;
-
-        do {
-            dy -= 32768;
-            py += y_stride;
-
-            scale_line (py, this->y_buffer,
-                        this->dest_width, this->step_dx);
-
-            if (height & 1) {
-                pu += uv_stride;
-                pv += uv_stride;
-
-                scale_line (pu, this->u_buffer,
-                            this->dest_width >> 1, this->step_dx);
-                scale_line (pv, this->v_buffer,
-                            this->dest_width >> 1, this->step_dx);
-            }
-            height++;
-        } while( dy>=32768 );
-
-      }
+    } while (--height);
+}
 
+static inline void row_abgr32 (yuv2rgb_t *this,
+                               uint8_t * image,
+                               uint8_t * py, uint8_t * pu, uint8_t * pv,
+                               int cpu)
+{
+    int i = this->dest_width >> 3;
+
+    while (i--) {
+      mmx_yuv2rgb (py, pu, pv, this->table_mmx);
+      mmx_unpack_32bgr (image, cpu);
+      py += 8;
+      pu += 4;
+      pv += 4;
+      image += 32;
     }
 }
 
@@ -1086,6 +818,76 @@ static void mmx_abgr32 (yuv2rgb_t *this, uint8_t * image,
     emms();	/* re-initialize x86 FPU after MMX use */
 }
 
+static void mmxext_row_rgb16 (yuv2rgb_t *this, uint8_t * image,
+                              uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_rgb16 (this, image, py, pu, pv, CPU_MMXEXT);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmxext_row_rgb15 (yuv2rgb_t *this, uint8_t * image,
+                              uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_rgb15 (this, image, py, pu, pv, CPU_MMXEXT);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmxext_row_rgb24 (yuv2rgb_t *this, uint8_t * image,
+                              uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_rgb24 (this, image, py, pu, pv, CPU_MMXEXT);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmxext_row_argb32 (yuv2rgb_t *this, uint8_t * image,
+                               uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_argb32 (this, image, py, pu, pv, CPU_MMXEXT);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmxext_row_abgr32 (yuv2rgb_t *this, uint8_t * image,
+                               uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_abgr32 (this, image, py, pu, pv, CPU_MMXEXT);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmx_row_rgb16 (yuv2rgb_t *this, uint8_t * image,
+                           uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_rgb16 (this, image, py, pu, pv, CPU_MMX);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmx_row_rgb15 (yuv2rgb_t *this, uint8_t * image,
+                           uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_rgb15 (this, image, py, pu, pv, CPU_MMX);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmx_row_rgb24 (yuv2rgb_t *this, uint8_t * image,
+                           uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_rgb24 (this, image, py, pu, pv, CPU_MMX);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmx_row_argb32 (yuv2rgb_t *this, uint8_t * image,
+                            uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_argb32 (this, image, py, pu, pv, CPU_MMX);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
+static void mmx_row_abgr32 (yuv2rgb_t *this, uint8_t * image,
+                            uint8_t * py, uint8_t * pu, uint8_t * pv)
+{
+    row_abgr32 (this, image, py, pu, pv, CPU_MMX);
+    emms();	/* re-initialize x86 FPU after MMX use */
+}
+
 void yuv2rgb_init_mmxext (yuv2rgb_factory_t *this) {
 
   if (this->swapped)
@@ -1094,18 +896,23 @@ void yuv2rgb_init_mmxext (yuv2rgb_factory_t *this) {
   switch (this->mode) {
   case MODE_15_RGB:
     this->yuv2rgb_fun = mmxext_rgb15;
+    this->yuv2rgb_row_fun = mmxext_row_rgb15;
     break;
   case MODE_16_RGB:
     this->yuv2rgb_fun = mmxext_rgb16;
+    this->yuv2rgb_row_fun = mmxext_row_rgb16;
     break;
   case MODE_24_RGB:
     this->yuv2rgb_fun = mmxext_rgb24;
+    this->yuv2rgb_row_fun = mmxext_row_rgb24;
     break;
   case MODE_32_RGB:
     this->yuv2rgb_fun = mmxext_argb32;
+    this->yuv2rgb_row_fun = mmxext_row_argb32;
     break;
   case MODE_32_BGR:
     this->yuv2rgb_fun = mmxext_abgr32;
+    this->yuv2rgb_row_fun = mmxext_row_abgr32;
     break;
   }
 }
@@ -1118,18 +925,23 @@ void yuv2rgb_init_mmx (yuv2rgb_factory_t *this) {
   switch (this->mode) {
   case MODE_15_RGB:
     this->yuv2rgb_fun = mmx_rgb15;
+    this->yuv2rgb_row_fun = mmx_row_rgb15;
     break;
   case MODE_16_RGB:
     this->yuv2rgb_fun = mmx_rgb16;
+    this->yuv2rgb_row_fun = mmx_row_rgb16;
     break;
   case MODE_24_RGB:
     this->yuv2rgb_fun = mmx_rgb24;
+    this->yuv2rgb_row_fun = mmx_row_rgb24;
     break;
   case MODE_32_RGB:
     this->yuv2rgb_fun = mmx_argb32;
+    this->yuv2rgb_row_fun = mmx_row_argb32;
     break;
   case MODE_32_BGR:
     this->yuv2rgb_fun = mmx_abgr32;
+    this->yuv2rgb_row_fun = mmx_row_abgr32;
     break;
   }
 }
@@ -40,6 +40,9 @@
 #include <xine/video_out.h>
 #include <xine/alphablend.h>
 #include "bswap.h"
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+#include "xine_mmx.h"
+#endif
 
 
 #define BLEND_COLOR(dst, src, mask, o) ((((((src&mask)-(dst&mask))*(o*0x111+1))>>12)+(dst&mask))&mask)
@@ -1056,6 +1059,834 @@ void _x_blend_rgb32 (uint8_t * img, vo_overlay_t * img_overl,
   }
 }
 
+/*
+ * cached yuv blending
+ *
+ * Decoding the rle image and looking up palette entries for every
+ * displayed frame is wasted work as long as the overlay does not change.
+ * Instead, the overlay is decoded once into tables holding, for every
+ * destination byte, the weight of the background t and the premultiplied
+ * overlay value p, so that blending boils down to
+ *
+ *   dst = ((dst * t + p) / 0xf) >> shift
+ *
+ * using the exact division explained in blend_yuy2_exact().  A line is
+ * only blended within the span the overlay actually covers.  Chroma
+ * averaging over the pixels sharing a sample depends on the parity of
+ * the overlay position, which is therefore part of the cache key.
+ * Decoders may rewrite an overlay in place, so an entry keeps a copy of
+ * the rle data and palettes it was made from and is only used when they
+ * still compare equal.  The cache lives behind alphablend_t.buffer.
+ *
+ * Overlays without rle but with an argb layer are converted to the same
+ * tables with 8 bit alpha, dividing by 0xff instead.  The osd marks the
+ * tiles of the layer it updates, so only changed tiles are converted
+ * again.  Chroma is always averaged over the pixels sharing a sample.
+ */
+
+#define BLEND_CACHE_ENTRIES 4
+
+typedef struct {
+  int       width, height;     /* destination bytes and lines covered */
+  int       pitch;
+  int       mul, shift;        /* division by the maximum opacity */
+  int       ident;             /* t value leaving the destination alone */
+  int       first, last;       /* lines with a non-empty span */
+  uint8_t  *t;
+  uint16_t *p;
+  int      *span;              /* first and last + 1 byte to blend, per line */
+} blend_plane_t;
+
+typedef struct {
+  int            rle_valid;    /* decoded from the rle overlay below */
+  int            width, height, num_rle;
+  int            key;
+  /* what the planes were decoded from, compared on lookup */
+  rle_elem_t    *rle;
+  int            rle_size;
+  int            hili_top, hili_bottom, hili_left, hili_right;
+  uint32_t       color[OVL_PALETTE_SIZE], hili_color[OVL_PALETTE_SIZE];
+  uint8_t        trans[OVL_PALETTE_SIZE], hili_trans[OVL_PALETTE_SIZE];
+  argb_layer_t  *argb;         /* converted layer, NULL for rle */
+  int            argb_x, argb_y;
+  uint32_t       serial;       /* layer serial at last conversion */
+  unsigned       used;
+  int            num_planes;
+  blend_plane_t  plane[3];
+  void          *chunk;
+  size_t         chunk_size;
+} blend_cache_entry_t;
+
+typedef struct {
+  unsigned             stamp;
+  blend_cache_entry_t  entry[BLEND_CACHE_ENTRIES];
+} blend_cache_t;
+
+/* alphablend_t.buffer starts with this, the line buffers of the rle walkers follow */
+typedef struct {
+  blend_cache_t *cache;
+  int            id;
+  int            max_width;
+} blend_buffer_t;
+
+/* one decoded overlay line */
+typedef struct {
+  uint8_t *o, *y, *cb, *cr;
+} blend_line_t;
+
+typedef struct {
+  rle_elem_t *rle, *limit;
+  int         left, color;
+} blend_rle_t;
+
+#define BLEND_KEY_YUY2   1
+#define BLEND_KEY_EXACT  2
+#define BLEND_KEY_X_ODD  4
+#define BLEND_KEY_Y_ODD  8
+#define BLEND_KEY_ARGB   16
+
+#define BLEND_MUL_15     0x1112      /* (x * 0x1112) >> 16 == x / 15 for x < 0x8000 */
+#define BLEND_MUL_255    0x8081      /* (x * 0x8081) >> 23 == x / 255 for x < 0x10000 */
+
+static void blend_line_c (uint8_t *dst, const uint8_t *t, const uint16_t *p, int n, int mul, int shift)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    dst[i] = (((unsigned)(dst[i] * t[i] + p[i]) * mul) >> 16) >> shift;
+}
+
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+static void blend_line_sse2 (uint8_t *dst, const uint8_t *t, const uint16_t *p, int n, int mul, int shift)
+{
+  sse_t div;
+  int i;
+
+  for (i = 0; i < 8; i++)
+    div.uw[i] = mul;
+
+  /* dst * t + p stays below 0x10000 */
+  for (i = 0; i + 16 <= n; i += 16) {
+    pxor_r2r (xmm7, xmm7);
+    movd_m2r (shift, xmm6);
+    movdqu_m2r (div, xmm5);
+    movdqu_m2r (*(sse_t *)(dst + i), xmm0);
+    movdqu_m2r (*(sse_t *)(t + i), xmm2);
+    movdqa_r2r (xmm0, xmm1);
+    movdqa_r2r (xmm2, xmm3);
+    punpcklbw_r2r (xmm7, xmm0);
+    punpckhbw_r2r (xmm7, xmm1);
+    punpcklbw_r2r (xmm7, xmm2);
+    punpckhbw_r2r (xmm7, xmm3);
+    pmullw_r2r (xmm2, xmm0);
+    pmullw_r2r (xmm3, xmm1);
+    movdqu_m2r (*(sse_t *)(p + i), xmm2);
+    movdqu_m2r (*(sse_t *)(p + i + 8), xmm3);
+    paddw_r2r (xmm2, xmm0);
+    paddw_r2r (xmm3, xmm1);
+    pmulhuw_r2r (xmm5, xmm0);
+    pmulhuw_r2r (xmm5, xmm1);
+    psrlw_r2r (xmm6, xmm0);
+    psrlw_r2r (xmm6, xmm1);
+    packuswb_r2r (xmm1, xmm0);
+    movdqu_r2m (xmm0, *(sse_t *)(dst + i));
+  }
+
+  blend_line_c (dst + i, t + i, p + i, n - i, mul, shift);
+}
+#endif
+
+static void (*blend_line) (uint8_t *dst, const uint8_t *t, const uint16_t *p, int n, int mul, int shift) = blend_line_c;
+
+/* returns 1 if the entry was decoded from this overlay */
+static int blend_cache_match (blend_cache_entry_t *e, vo_overlay_t *img_overl, int key)
+{
+  return e->rle_valid && e->key == key &&
+    e->width == img_overl->width && e->height == img_overl->height &&
+    e->num_rle == img_overl->num_rle &&
+    e->hili_top == img_overl->hili_top && e->hili_bottom == img_overl->hili_bottom &&
+    e->hili_left == img_overl->hili_left && e->hili_right == img_overl->hili_right &&
+    !memcmp (e->trans, img_overl->trans, sizeof (e->trans)) &&
+    !memcmp (e->hili_trans, img_overl->hili_trans, sizeof (e->hili_trans)) &&
+    !memcmp (e->color, img_overl->color, sizeof (e->color)) &&
+    !memcmp (e->hili_color, img_overl->hili_color, sizeof (e->hili_color)) &&
+    (!e->num_rle || !memcmp (e->rle, img_overl->rle, e->num_rle * sizeof (rle_elem_t)));
+}
+
+/* keeps what the entry is decoded from for blend_cache_match () */
+static int blend_cache_remember (blend_cache_entry_t *e, vo_overlay_t *img_overl)
+{
+  if (e->rle_size < img_overl->num_rle) {
+    free (e->rle);
+    e->rle_size = 0;
+    e->rle = malloc (img_overl->num_rle * sizeof (rle_elem_t));
+    if (!e->rle)
+      return 0;
+    e->rle_size = img_overl->num_rle;
+  }
+  if (img_overl->num_rle)
+    memcpy (e->rle, img_overl->rle, img_overl->num_rle * sizeof (rle_elem_t));
+
+  e->width       = img_overl->width;
+  e->height      = img_overl->height;
+  e->num_rle     = img_overl->num_rle;
+  e->hili_top    = img_overl->hili_top;
+  e->hili_bottom = img_overl->hili_bottom;
+  e->hili_left   = img_overl->hili_left;
+  e->hili_right  = img_overl->hili_right;
+  memcpy (e->trans, img_overl->trans, sizeof (e->trans));
+  memcpy (e->hili_trans, img_overl->hili_trans, sizeof (e->hili_trans));
+  memcpy (e->color, img_overl->color, sizeof (e->color));
+  memcpy (e->hili_color, img_overl->hili_color, sizeof (e->hili_color));
+  e->rle_valid = 1;
+  return 1;
+}
+
+/* decodes the next line of the rle stream, runs may continue on the next line */
+static void blend_decode_line (vo_overlay_t *img_overl, int y, blend_rle_t *r, blend_line_t *l)
+{
+  int hili = (y >= img_overl->hili_top) && (y < img_overl->hili_bottom);
+  int width = img_overl->width;
+  int x = 0;
+
+  while (x < width) {
+    int end;
+
+    if (!r->left) {
+      if (r->rle >= r->limit)
+        break;
+      r->left  = r->rle->len;
+      r->color = r->rle->color;
+      r->rle++;
+      continue;
+    }
+
+    end = x + r->left;
+    if (end > width)
+      end = width;
+    r->left -= end - x;
+
+    while (x < end) {
+      clut_t  *clut  = (clut_t *) img_overl->color;
+      uint8_t *trans = img_overl->trans;
+      int      stop  = end;
+      int      o;
+
+      if (hili) {
+        if (x < img_overl->hili_left) {
+          if (stop > img_overl->hili_left)
+            stop = img_overl->hili_left;
+        } else if (x < img_overl->hili_right) {
+          if (stop > img_overl->hili_right)
+            stop = img_overl->hili_right;
+          clut  = (clut_t *) img_overl->hili_color;
+          trans = img_overl->hili_trans;
+        }
+      }
+
+      o = trans[r->color];
+      if (o > OVL_MAX_OPACITY)
+        o = OVL_MAX_OPACITY;
+      memset (l->o + x, o, stop - x);
+      memset (l->y + x, clut[r->color].y, stop - x);
+      memset (l->cb + x, clut[r->color].cb, stop - x);
+      memset (l->cr + x, clut[r->color].cr, stop - x);
+      x = stop;
+    }
+  }
+
+  /* rest is transparent */
+  if (x < width)
+    memset (l->o + x, 0, width - x);
+}
+
+static void blend_plane_span (blend_plane_t *pl, int line, int ident)
+{
+  const uint8_t *t = pl->t + line * pl->pitch;
+  int first = 0, last = pl->width;
+
+  while (first < last && t[first] == ident)
+    first++;
+  while (last > first && t[last - 1] == ident)
+    last--;
+
+  pl->span[2 * line]     = first;
+  pl->span[2 * line + 1] = last;
+  if (first < last) {
+    if (pl->first > line)
+      pl->first = line;
+    if (pl->last < line + 1)
+      pl->last = line + 1;
+  }
+}
+
+/* luma of one overlay line, scale is 2 for yuy2 */
+static void blend_fill_luma (uint8_t *t, uint16_t *p, const blend_line_t *l, int width, int step, int scale)
+{
+  int x;
+
+  for (x = 0; x < width; x++) {
+    int o = l->o[x];
+    t[x * step] = scale * (OVL_MAX_OPACITY - o);
+    p[x * step] = scale * l->y[x] * o;
+  }
+}
+
+/* chroma of the pixel pairs/blocks of up to two overlay lines, line pointers
+ * may be NULL.  x_odd shifts the overlay right by one pixel within the pairs.
+ * For yuy2, cb and cr go to alternate bytes.
+ */
+static void blend_fill_chroma (blend_plane_t *cb, blend_plane_t *cr, int line,
+                               const blend_line_t *l0, const blend_line_t *l1,
+                               int width, int x_odd, int exact, int yuy2)
+{
+  int step = yuy2 ? 4 : 1;
+  int scale = yuy2 ? 2 : 1;
+  uint8_t  *t_cb = cb->t + line * cb->pitch, *t_cr = cr->t + line * cr->pitch;
+  uint16_t *p_cb = cb->p + line * cb->pitch, *p_cr = cr->p + line * cr->pitch;
+  int bx, blocks = (width + x_odd + 1) >> 1;
+
+  if (yuy2) {
+    t_cb += 1; p_cb += 1;
+    t_cr += 3; p_cr += 3;
+  }
+
+  for (bx = 0; bx < blocks; bx++) {
+    int x0 = 2 * bx - x_odd, x1 = x0 + 1, i, j;
+    const blend_line_t *ls[2];
+    int xs[2];
+    int o = 0, s_cb = 0, s_cr = 0;
+
+    ls[0] = l0;
+    ls[1] = l1;
+    xs[0] = x0;
+    xs[1] = x1;
+
+    if (exact) {
+      for (j = 0; j < 2; j++) {
+        if (!ls[j])
+          continue;
+        for (i = 0; i < 2; i++) {
+          int x = xs[i], a;
+          if (x < 0 || x >= width)
+            continue;
+          a = ls[j]->o[x];
+          o    += a;
+          s_cb += ls[j]->cb[x] * a;
+          s_cr += ls[j]->cr[x] * a;
+        }
+      }
+      /* 2 or 4 pixels share a sample, the divisor comes from the shift */
+      t_cb[bx * step] = t_cr[bx * step] = (yuy2 ? 2 : 4) * OVL_MAX_OPACITY - o;
+      p_cb[bx * step] = s_cb;
+      p_cr[bx * step] = s_cr;
+    } else {
+      /* like the unexact path: take the chroma of a single pixel, from the
+       * lower line for yv12 and cb/cr from the even/odd pixel for yuy2 */
+      const blend_line_t *lc = yuy2 ? l0 : l1;
+      int xc_cb = (yuy2 || x0 >= 0) ? x0 : x1;
+      int xc_cr = yuy2 ? x1 : xc_cb;
+      int a_cb = 0, a_cr = 0;
+
+      if (lc && xc_cb >= 0 && xc_cb < width)
+        a_cb = lc->o[xc_cb];
+      if (lc && xc_cr >= 0 && xc_cr < width)
+        a_cr = lc->o[xc_cr];
+      t_cb[bx * step] = scale * (OVL_MAX_OPACITY - a_cb);
+      t_cr[bx * step] = scale * (OVL_MAX_OPACITY - a_cr);
+      p_cb[bx * step] = a_cb ? scale * lc->cb[xc_cb] * a_cb : 0;
+      p_cr[bx * step] = a_cr ? scale * lc->cr[xc_cr] * a_cr : 0;
+    }
+  }
+}
+
+/* sets up the planes of a cache entry for a width x height overlay,
+ * followed by extra bytes of scratch memory, which is returned */
+static uint8_t *blend_cache_alloc (blend_cache_entry_t *e, int width, int height, int key, size_t extra)
+{
+  int yuy2  = key & BLEND_KEY_YUY2;
+  int exact = key & BLEND_KEY_EXACT;
+  int x_odd = (key & BLEND_KEY_X_ODD) ? 1 : 0;
+  int y_odd = (key & BLEND_KEY_Y_ODD) ? 1 : 0;
+  int cw = (width + x_odd + 1) >> 1;
+  int ch = (height + y_odd + 1) >> 1;
+  int i;
+  size_t size = 0;
+  uint8_t *mem;
+
+  if (yuy2) {
+    e->num_planes = 1;
+    e->plane[0].width  = 4 * cw;
+    e->plane[0].height = height;
+    e->plane[0].shift  = 1;
+    e->plane[0].ident  = 2 * OVL_MAX_OPACITY;
+  } else {
+    e->num_planes = 3;
+    e->plane[0].width  = width;
+    e->plane[0].height = height;
+    e->plane[0].shift  = 0;
+    e->plane[0].ident  = OVL_MAX_OPACITY;
+    for (i = 1; i < 3; i++) {
+      e->plane[i].width  = cw;
+      e->plane[i].height = ch;
+      e->plane[i].shift  = exact ? 2 : 0;
+      e->plane[i].ident  = exact ? 4 * OVL_MAX_OPACITY : OVL_MAX_OPACITY;
+    }
+  }
+
+  for (i = 0; i < e->num_planes; i++) {
+    blend_plane_t *pl = &e->plane[i];
+    if (key & BLEND_KEY_ARGB) {
+      pl->mul   = BLEND_MUL_255;
+      pl->shift = 7;
+      pl->ident = 0xff;
+    } else {
+      pl->mul   = BLEND_MUL_15;
+    }
+    pl->pitch = (pl->width + 15) & ~15;
+    size += (size_t)pl->pitch * pl->height * 3 + pl->height * 2 * sizeof (int);
+  }
+  size += 16 + extra;
+
+  if (e->chunk_size < size) {
+    free (e->chunk);
+    e->chunk_size = 0;
+    e->chunk = malloc (size);
+    if (!e->chunk)
+      return NULL;
+    e->chunk_size = size;
+  }
+
+  mem = (uint8_t *)(((uintptr_t)e->chunk + 15) & ~(uintptr_t)15);
+  for (i = 0; i < e->num_planes; i++) {
+    blend_plane_t *pl = &e->plane[i];
+    pl->p = (uint16_t *)mem;
+    mem += pl->pitch * pl->height * 2;
+    pl->t = mem;
+    mem += pl->pitch * pl->height;
+    pl->span = (int *)mem;
+    mem += pl->height * 2 * sizeof (int);
+    pl->first = pl->height;
+    pl->last  = 0;
+  }
+  e->key = key;
+
+  return mem;
+}
+
+static int blend_cache_fill (blend_cache_entry_t *e, vo_overlay_t *img_overl, int key)
+{
+  int yuy2  = key & BLEND_KEY_YUY2;
+  int exact = key & BLEND_KEY_EXACT;
+  int x_odd = (key & BLEND_KEY_X_ODD) ? 1 : 0;
+  int y_odd = (key & BLEND_KEY_Y_ODD) ? 1 : 0;
+  int width = img_overl->width, height = img_overl->height;
+  int cw = (width + x_odd + 1) >> 1;
+  int i, y, ident_y, ident_c;
+  uint8_t *lines;
+  blend_line_t l[2];
+  blend_rle_t r;
+
+  lines = blend_cache_alloc (e, width, height, key, 2 * 4 * ((width + 15) & ~15));
+  if (!lines)
+    return 0;
+  ident_y = e->plane[0].ident;
+  ident_c = e->plane[e->num_planes - 1].ident;
+
+  for (i = 0; i < 2; i++) {
+    l[i].o  = lines + (4 * i + 0) * ((width + 15) & ~15);
+    l[i].y  = lines + (4 * i + 1) * ((width + 15) & ~15);
+    l[i].cb = lines + (4 * i + 2) * ((width + 15) & ~15);
+    l[i].cr = lines + (4 * i + 3) * ((width + 15) & ~15);
+  }
+
+  r.rle   = img_overl->rle;
+  r.limit = img_overl->rle + img_overl->num_rle;
+  r.left  = 0;
+  r.color = 0;
+
+  for (y = 0; y < height; y++) {
+    int pos = (y + y_odd) & 1;
+
+    blend_decode_line (img_overl, y, &r, &l[pos]);
+
+    if (yuy2) {
+      blend_plane_t *pl = &e->plane[0];
+      uint8_t  *t = pl->t + y * pl->pitch;
+      uint16_t *p = pl->p + y * pl->pitch;
+
+      /* bytes of pixels outside the overlay stay untouched */
+      t[0] = t[2 * (2 * cw - 1)] = ident_y;
+      p[0] = p[2 * (2 * cw - 1)] = 0;
+      blend_fill_luma (t + 2 * x_odd, p + 2 * x_odd, &l[pos], width, 2, 2);
+      blend_fill_chroma (pl, pl, y, &l[pos], NULL, width, x_odd, exact, 1);
+      blend_plane_span (pl, y, ident_y);
+    } else {
+      blend_plane_t *pl = &e->plane[0];
+
+      blend_fill_luma (pl->t + y * pl->pitch, pl->p + y * pl->pitch, &l[pos], width, 1, 1);
+      blend_plane_span (pl, y, ident_y);
+
+      /* chroma line is complete, the first overlay line may be a lower one */
+      if (pos || y == height - 1) {
+        int line = (y + y_odd) >> 1;
+
+        blend_fill_chroma (&e->plane[1], &e->plane[2], line,
+                           (pos && y == 0) ? NULL : &l[0], pos ? &l[1] : NULL,
+                           width, x_odd, exact, 0);
+        blend_plane_span (&e->plane[1], line, ident_c);
+        blend_plane_span (&e->plane[2], line, ident_c);
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* premultiplied value and t of a chroma sample shared by n pixels, the sum
+ * of c * a never exceeds 0xff * the rounded average alpha */
+#define ARGB_CHROMA(t, p, sum_a, sum_c, n) do {                 \
+    int _a = ((sum_a) + (n) / 2) / (n);                         \
+    int _c = ((sum_c) + (n) / 2) / (n);                         \
+    (t) = 0xff - _a;                                            \
+    (p) = ((_c < 0xff * _a) ? _c : 0xff * _a) + 127;            \
+  } while (0)
+
+/* converts the overlay pixels x0..x1-1, y0..y1-1 of an argb layer, widened
+ * to whole chroma samples.  src points to the pixel at overlay 0/0. */
+static void blend_argb_convert (blend_cache_entry_t *e, const uint32_t *src, int src_pitch,
+                                int width, int height, int x0, int y0, int x1, int y1)
+{
+  int yuy2  = e->key & BLEND_KEY_YUY2;
+  int x_odd = (e->key & BLEND_KEY_X_ODD) ? 1 : 0;
+  int y_odd = (e->key & BLEND_KEY_Y_ODD) ? 1 : 0;
+  blend_plane_t *pl = &e->plane[0];
+  int x, y, bx, by, bx0, bx1, by0, by1, i, j;
+
+  x0 = ((x0 + x_odd) & ~1) - x_odd;
+  x1 = ((x1 + x_odd + 1) & ~1) - x_odd;
+  if (x0 < 0)
+    x0 = 0;
+  if (x1 > width)
+    x1 = width;
+  bx0 = (x0 + x_odd) >> 1;
+  bx1 = (x1 + x_odd + 1) >> 1;
+  if (!yuy2) {
+    y0 = ((y0 + y_odd) & ~1) - y_odd;
+    y1 = ((y1 + y_odd + 1) & ~1) - y_odd;
+  }
+  if (y0 < 0)
+    y0 = 0;
+  if (y1 > height)
+    y1 = height;
+  by0 = (y0 + y_odd) >> 1;
+  by1 = (y1 + y_odd + 1) >> 1;
+
+  /* luma */
+  for (y = y0; y < y1; y++) {
+    const uint32_t *s = src + y * src_pitch;
+    uint8_t  *t = pl->t + y * pl->pitch;
+    uint16_t *p = pl->p + y * pl->pitch;
+    int step = yuy2 ? 2 : 1;
+
+    if (yuy2) {
+      t += 2 * x_odd;
+      p += 2 * x_odd;
+    }
+    for (x = x0; x < x1; x++) {
+      uint32_t argb = s[x];
+      int a = argb >> 24, r = (argb >> 16) & 0xff, g = (argb >> 8) & 0xff, b = argb & 0xff;
+      t[x * step] = 0xff - a;
+      p[x * step] = COMPUTE_Y (r, g, b) * a + 127;
+    }
+  }
+
+  /* chroma, from the pixels of a sample that lie within the overlay */
+  for (by = yuy2 ? y0 : by0; by < (yuy2 ? y1 : by1); by++) {
+    blend_plane_t *cb = yuy2 ? pl : &e->plane[1];
+    blend_plane_t *cr = yuy2 ? pl : &e->plane[2];
+    uint8_t  *t_cb = cb->t + by * cb->pitch, *t_cr = cr->t + by * cr->pitch;
+    uint16_t *p_cb = cb->p + by * cb->pitch, *p_cr = cr->p + by * cr->pitch;
+    int step = yuy2 ? 4 : 1;
+    int rows = yuy2 ? 1 : 2;
+
+    if (yuy2) {
+      t_cb += 1; p_cb += 1;
+      t_cr += 3; p_cr += 3;
+    }
+    for (bx = bx0; bx < bx1; bx++) {
+      int sum_a = 0, sum_cb = 0, sum_cr = 0;
+
+      for (j = 0; j < rows; j++) {
+        const uint32_t *s;
+
+        y = yuy2 ? by : 2 * by - y_odd + j;
+        if (y < 0 || y >= height)
+          continue;
+        s = src + y * src_pitch;
+        for (i = 0; i < 2; i++) {
+          uint32_t argb;
+          int a, r, g, b;
+
+          x = 2 * bx - x_odd + i;
+          if (x < 0 || x >= width)
+            continue;
+          argb = s[x];
+          a = argb >> 24;
+          if (!a)
+            continue;
+          r = (argb >> 16) & 0xff;
+          g = (argb >> 8) & 0xff;
+          b = argb & 0xff;
+          sum_a  += a;
+          sum_cb += COMPUTE_U (r, g, b) * a;
+          sum_cr += COMPUTE_V (r, g, b) * a;
+        }
+      }
+      ARGB_CHROMA (t_cb[bx * step], p_cb[bx * step], sum_a, sum_cb, 2 * rows);
+      ARGB_CHROMA (t_cr[bx * step], p_cr[bx * step], sum_a, sum_cr, 2 * rows);
+    }
+  }
+
+  for (y = y0; y < y1; y++)
+    blend_plane_span (pl, y, pl->ident);
+  if (!yuy2) {
+    for (by = by0; by < by1; by++) {
+      blend_plane_span (&e->plane[1], by, e->plane[1].ident);
+      blend_plane_span (&e->plane[2], by, e->plane[2].ident);
+    }
+  }
+}
+
+/* returns the cache entry for an argb overlay, converting the tiles
+ * updated since the entry was filled */
+static blend_cache_entry_t *blend_argb_get (blend_cache_t *cache, vo_overlay_t *img_overl, int key)
+{
+  argb_layer_t *layer = img_overl->argb_layer;
+  int width = img_overl->width, height = img_overl->height;
+  blend_cache_entry_t *e, *lru;
+  const uint32_t *src;
+  int i;
+
+  pthread_mutex_lock (&layer->mutex);
+
+  if (!layer->buffer || !layer->tile_serial || layer->ovl_x < 0 || layer->ovl_y < 0 ||
+      layer->ovl_x + width > layer->width || layer->ovl_y + height > layer->height) {
+    pthread_mutex_unlock (&layer->mutex);
+    return NULL;
+  }
+  src = layer->buffer + layer->ovl_y * layer->width + layer->ovl_x;
+
+  lru = &cache->entry[0];
+  for (i = 0; i < BLEND_CACHE_ENTRIES; i++) {
+    e = &cache->entry[i];
+    if (e->argb == layer && e->key == key && e->width == width && e->height == height &&
+        e->argb_x == layer->ovl_x && e->argb_y == layer->ovl_y)
+      break;
+    if (e->used < lru->used)
+      lru = e;
+  }
+
+  if (i < BLEND_CACHE_ENTRIES) {
+    int tiles_x = (layer->width + ARGB_TILE_SIZE - 1) / ARGB_TILE_SIZE;
+    int tx0 = layer->ovl_x / ARGB_TILE_SIZE, tx1 = (layer->ovl_x + width - 1) / ARGB_TILE_SIZE;
+    int ty0 = layer->ovl_y / ARGB_TILE_SIZE, ty1 = (layer->ovl_y + height - 1) / ARGB_TILE_SIZE;
+    int tx, ty;
+
+    /* one rectangle per row of tiles */
+    for (ty = ty0; ty <= ty1 && e->serial != layer->serial; ty++) {
+      int first = -1, last = -1;
+
+      for (tx = tx0; tx <= tx1; tx++) {
+        if ((int32_t)(layer->tile_serial[ty * tiles_x + tx] - e->serial) > 0) {
+          if (first < 0)
+            first = tx;
+          last = tx;
+        }
+      }
+      if (first >= 0)
+        blend_argb_convert (e, src, layer->width, width, height,
+                            first * ARGB_TILE_SIZE - layer->ovl_x, ty * ARGB_TILE_SIZE - layer->ovl_y,
+                            (last + 1) * ARGB_TILE_SIZE - layer->ovl_x, (ty + 1) * ARGB_TILE_SIZE - layer->ovl_y);
+    }
+  } else {
+    e = lru;
+    e->rle_valid = 0;
+    e->argb = NULL;
+    if (!blend_cache_alloc (e, width, height, key, 0)) {
+      pthread_mutex_unlock (&layer->mutex);
+      return NULL;
+    }
+    if (key & BLEND_KEY_YUY2) {
+      /* bytes of pixels outside the overlay stay untouched */
+      blend_plane_t *pl = &e->plane[0];
+      int y, last = 2 * (pl->width / 2 - 1);
+
+      for (y = 0; y < height; y++) {
+        pl->t[y * pl->pitch] = pl->t[y * pl->pitch + last] = pl->ident;
+        pl->p[y * pl->pitch] = pl->p[y * pl->pitch + last] = 0;
+      }
+    }
+    blend_argb_convert (e, src, layer->width, width, height, 0, 0, width, height);
+    e->argb   = layer;
+    e->argb_x = layer->ovl_x;
+    e->argb_y = layer->ovl_y;
+    e->width  = width;
+    e->height = height;
+  }
+  e->serial = layer->serial;
+  e->used   = cache->stamp;
+
+  pthread_mutex_unlock (&layer->mutex);
+  return e;
+}
+
+static void blend_cache_free (blend_cache_t *cache)
+{
+  int i;
+
+  if (!cache)
+    return;
+  for (i = 0; i < BLEND_CACHE_ENTRIES; i++) {
+    free (cache->entry[i].chunk);
+    free (cache->entry[i].rle);
+  }
+  free (cache);
+}
+
+/* makes alphablend_t.buffer at least size bytes, keeping the cache */
+static blend_buffer_t *blend_grow_buffer (alphablend_t *extra_data, size_t size)
+{
+  blend_buffer_t *buffer = (blend_buffer_t *)extra_data->buffer;
+
+  if (extra_data->buffer_size < size) {
+    blend_buffer_t *grown = calloc (1, size);
+
+    if (!grown)
+      return NULL;
+    if (buffer)
+      grown->cache = buffer->cache;
+    free (buffer);
+    extra_data->buffer      = buffer = grown;
+    extra_data->buffer_size = size;
+  }
+  return buffer;
+}
+
+/* returns the cache entry for the overlay, decoding it if needed */
+static blend_cache_entry_t *blend_cache_get (alphablend_t *extra_data, vo_overlay_t *img_overl, int key)
+{
+  blend_buffer_t *buffer = blend_grow_buffer (extra_data, sizeof (blend_buffer_t));
+  blend_cache_t *cache;
+  blend_cache_entry_t *e, *lru;
+  int i;
+
+  if (!buffer)
+    return NULL;
+  cache = buffer->cache;
+  if (!cache) {
+    cache = calloc (1, sizeof (*cache));
+    if (!cache)
+      return NULL;
+    buffer->cache = cache;
+  }
+
+  cache->stamp++;
+
+  if (!img_overl->rle && img_overl->argb_layer)
+    return blend_argb_get (cache, img_overl, (key & ~BLEND_KEY_EXACT) | BLEND_KEY_ARGB);
+
+  lru = &cache->entry[0];
+  for (i = 0; i < BLEND_CACHE_ENTRIES; i++) {
+    e = &cache->entry[i];
+    if (blend_cache_match (e, img_overl, key)) {
+      e->used = cache->stamp;
+      return e;
+    }
+    if (e->used < lru->used)
+      lru = e;
+  }
+
+  e = lru;
+  e->rle_valid = 0;
+  e->argb = NULL;
+  if (!blend_cache_fill (e, img_overl, key) || !blend_cache_remember (e, img_overl))
+    return NULL;
+  e->used = cache->stamp;
+  return e;
+}
+
+/* blends a cached plane placed at x0/y0 (bytes/lines) onto a destination of dst_w x dst_h */
+static void blend_cache_plane (blend_plane_t *pl, uint8_t *dst, int pitch,
+                               int x0, int y0, int dst_w, int dst_h)
+{
+  int y, first = pl->first, last = pl->last;
+  int left = (x0 < 0) ? -x0 : 0;
+  int right = (x0 + pl->width > dst_w) ? dst_w - x0 : pl->width;
+
+  if (first < -y0)
+    first = -y0;
+  if (last > dst_h - y0)
+    last = dst_h - y0;
+
+  for (y = first; y < last; y++) {
+    int s = pl->span[2 * y], e = pl->span[2 * y + 1];
+
+    if (s < left)
+      s = left;
+    if (e > right)
+      e = right;
+    if (s < e)
+      blend_line (dst + (y0 + y) * pitch + x0 + s,
+                  pl->t + y * pl->pitch + s, pl->p + y * pl->pitch + s, e - s, pl->mul, pl->shift);
+  }
+}
+
+static int blend_yuv_cached (uint8_t *dst_base[3], vo_overlay_t *img_overl,
+                             int dst_width, int dst_height, int dst_pitches[3],
+                             alphablend_t *extra_data)
+{
+  int x_off = img_overl->x + extra_data->offset_x;
+  int y_off = img_overl->y + extra_data->offset_y;
+  int key = (extra_data->disable_exact_blending ? 0 : BLEND_KEY_EXACT) |
+            ((x_off & 1) ? BLEND_KEY_X_ODD : 0) | ((y_off & 1) ? BLEND_KEY_Y_ODD : 0);
+  blend_cache_entry_t *e;
+
+  e = blend_cache_get (extra_data, img_overl, key);
+  if (!e)
+    return 0;
+
+  blend_cache_plane (&e->plane[0], dst_base[0], dst_pitches[0],
+                     x_off, y_off, dst_width, dst_height);
+  /* x_off - (x_off & 1) is even, so these are exact for negative offsets too */
+  x_off = (x_off - (x_off & 1)) / 2;
+  y_off = (y_off - (y_off & 1)) / 2;
+  blend_cache_plane (&e->plane[1], dst_base[1], dst_pitches[1],
+                     x_off, y_off, (dst_width + 1) >> 1, (dst_height + 1) >> 1);
+  blend_cache_plane (&e->plane[2], dst_base[2], dst_pitches[2],
+                     x_off, y_off, (dst_width + 1) >> 1, (dst_height + 1) >> 1);
+  return 1;
+}
+
+static int blend_yuy2_cached (uint8_t *dst_img, vo_overlay_t *img_overl,
+                              int dst_width, int dst_height, int dst_pitch,
+                              alphablend_t *extra_data)
+{
+  int x_off = img_overl->x + extra_data->offset_x;
+  int y_off = img_overl->y + extra_data->offset_y;
+  int key = BLEND_KEY_YUY2 | (extra_data->disable_exact_blending ? 0 : BLEND_KEY_EXACT) |
+            ((x_off & 1) ? BLEND_KEY_X_ODD : 0);
+  blend_cache_entry_t *e;
+
+  e = blend_cache_get (extra_data, img_overl, key);
+  if (!e)
+    return 0;
+
+  blend_cache_plane (&e->plane[0], dst_img, dst_pitch,
+                     2 * (x_off - (x_off & 1)), y_off, 2 * dst_width, dst_height);
+  return 1;
+}
+
 static void blend_yuv_exact(uint8_t *dst_cr, uint8_t *dst_cb, int src_width,
                             uint8_t *(*blend_yuv_data)[ 3 ][ 2 ])
 {
@@ -1109,32 +1940,22 @@ static void blend_yuv_exact(uint8_t *dst_cr, uint8_t *dst_cb, int src_width,
 static uint8_t *(*blend_yuv_grow_extra_data(alphablend_t *extra_data, int osd_width))[ 3 ][ 2 ]
 {
   struct XINE_PACKED header_s {
-    int id;
-    int max_width;
+    blend_buffer_t b;
     uint8_t *data[ 3 ][ 2 ];
-  } *header = (struct header_s *)extra_data->buffer;
+  } *header;
 
   /* align buffers to 16 bytes */
   size_t header_size = (sizeof(*header) + 15) & (~15);
   size_t alloc_width = (osd_width + 15) & (~15);
   size_t needed_buffer_size = 16 + header_size + alloc_width * sizeof (uint8_t[ 3 ][ 2 ]);
 
-  if (extra_data->buffer_size < needed_buffer_size) {
+  header = (struct header_s *)blend_grow_buffer(extra_data, needed_buffer_size);
+  if (!header)
+    return 0;
 
-    free(extra_data->buffer);
-    header = calloc(1, needed_buffer_size);
-    if (!header) {
-      extra_data->buffer_size = 0;
-      return 0;
-    }
-    extra_data->buffer_size = needed_buffer_size;
-    extra_data->buffer = header;
-    header->max_width = 0;
-  }
-
-  if (header->id != ME_FOURCC('y', 'u', 'v', 0) || header->max_width < osd_width) {
-    header->id = ME_FOURCC('y', 'u', 'v', 0);
-    header->max_width = osd_width;
+  if (header->b.id != ME_FOURCC('y', 'u', 'v', 0) || header->b.max_width < osd_width) {
+    header->b.id = ME_FOURCC('y', 'u', 'v', 0);
+    header->b.max_width = osd_width;
 
     header->data[ 0 ][ 0 ] = ((uint8_t *)extra_data->buffer) + header_size;
     header->data[ 0 ][ 1 ] = header->data[ 0 ][ 0 ] + alloc_width;
@@ -1183,6 +2004,10 @@ void _x_blend_yuv (uint8_t *dst_base[3], vo_overlay_t * img_overl,
 #ifdef LOG_BLEND_YUV
   printf("overlay_blend started x=%d, y=%d, w=%d h=%d\n",img_overl->x,img_overl->y,img_overl->width,img_overl->height);
 #endif
+
+  if (blend_yuv_cached(dst_base, img_overl, dst_width, dst_height, dst_pitches, extra_data))
+    return;
+
   my_clut = (clut_t*) img_overl->hili_color;
   my_trans = img_overl->hili_trans;
 
@@ -1554,32 +2379,22 @@ static void blend_yuy2_exact(uint8_t *dst_cr, uint8_t *dst_cb, int src_width,
 static uint8_t *(*blend_yuy2_grow_extra_data(alphablend_t *extra_data, int osd_width))[ 3 ]
 {
   struct XINE_PACKED header_s {
-    int id;
-    int max_width;
+    blend_buffer_t b;
     uint8_t *data[ 3 ];
-  } *header = (struct header_s *)extra_data->buffer;
+  } *header;
 
   /* align buffers to 16 bytes */
   size_t header_size = (sizeof(*header) + 15) & (~15);
   size_t alloc_width = (osd_width + 15) & (~15);
   size_t needed_buffer_size = 16 + header_size + alloc_width * sizeof (uint8_t[ 3 ]);
 
-  if (extra_data->buffer_size < needed_buffer_size) {
+  header = (struct header_s *)blend_grow_buffer(extra_data, needed_buffer_size);
+  if (!header)
+    return 0;
 
-    free(extra_data->buffer);
-    header = calloc(1, needed_buffer_size);
-    if (!header) {
-      extra_data->buffer_size = 0;
-      return 0;
-    }
-    extra_data->buffer_size = needed_buffer_size;
-    extra_data->buffer = header;
-    header->max_width = 0;
-  }
-
-  if (header->id != ME_FOURCC('y', 'u', 'y', '2') || header->max_width < osd_width) {
-    header->id = ME_FOURCC('y', 'u', 'y', '2');
-    header->max_width = osd_width;
+  if (header->b.id != ME_FOURCC('y', 'u', 'y', '2') || header->b.max_width < osd_width) {
+    header->b.id = ME_FOURCC('y', 'u', 'y', '2');
+    header->b.max_width = osd_width;
 
     header->data[ 0 ] = ((uint8_t *)extra_data->buffer) + header_size;
     header->data[ 1 ] = header->data[ 0 ] + alloc_width;
@@ -1629,6 +2444,9 @@ void _x_blend_yuy2 (uint8_t * dst_img, vo_overlay_t * img_overl,
   uint8_t *dst_y = dst_img + dst_pitch * y_off + 2 * x_off;
   uint8_t *dst;
 
+  if (blend_yuy2_cached(dst_img, img_overl, dst_width, dst_height, dst_pitch, extra_data))
+    return;
+
   my_clut = (clut_t*) img_overl->hili_color;
   my_trans = img_overl->hili_trans;
 
@@ -2151,6 +2969,11 @@ void _x_alphablend_init(alphablend_t *extra_data, xine_t *xine)
   extra_data->offset_x = 0;
   extra_data->offset_y = 0;
 
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+  if (xine_mm_accel() & MM_ACCEL_X86_SSE2)
+    blend_line = blend_line_sse2;
+#endif
+
   extra_data->disable_exact_blending =
     config->register_bool(config, "video.output.disable_exact_alphablend", 0,
       _("disable exact alpha blending of overlays"),
@@ -2164,6 +2987,7 @@ void _x_alphablend_init(alphablend_t *extra_data, xine_t *xine)
 void _x_alphablend_free(alphablend_t *extra_data)
 {
   if (extra_data->buffer) {
+    blend_cache_free(((blend_buffer_t *)extra_data->buffer)->cache);
     free(extra_data->buffer);
     extra_data->buffer = NULL;
   }
@@ -43,28 +43,61 @@
 #include <xine/xineutils.h>
 #include "xine_private.h"
 
-static void *audio_decoder_loop (void *stream_gen) {
+/* buffers a decoder task handles before giving other streams a turn */
+#define TASK_BATCH 16
+
+/*
+ * decoder state that lives as long as the decoder thread, or the task
+ * when running on the shared decoder threads
+ */
+typedef struct {
+  xine_task_t      task;   /* must be first, see audio_decoder_task_run() */
+  xine_stream_t   *stream;
+  int              running;
+  int              batch;
+  buf_element_t   *first_header;
+  buf_element_t   *last_header;
+  int              replaying_headers;
+  uint32_t         buftype_unknown;
+  int              audio_channel_user;
+} audio_decoder_state_t;
+
+static xine_tracepoint_t tp_audio_decode = XINE_TRACEPOINT ("audio_decoder.decode");
+
+static void audio_decoder_state_init (audio_decoder_state_t *this, xine_stream_t *stream) {
+
+  this->stream             = stream;
+  this->running            = 1;
+  this->audio_channel_user = stream->audio_channel_user;
+}
+
+/*
+ * handles buffers until BUF_CONTROL_QUIT. as a task, returns early
+ * when the fifo is empty or the batch is used up.
+ */
+static void audio_decoder_run (audio_decoder_state_t *this) {
 
   buf_element_t   *buf = NULL;
-  buf_element_t   *first_header = NULL;
-  buf_element_t   *last_header = NULL;
-  int              replaying_headers = 0;
-  xine_stream_t   *stream = (xine_stream_t *) stream_gen;
+  xine_stream_t   *stream = this->stream;
   xine_ticket_t   *running_ticket = stream->xine->port_ticket;
-  int              running = 1;
-  int              prof_audio_decode = -1;
-  uint32_t         buftype_unknown = 0;
-  int              audio_channel_user = stream->audio_channel_user;
-
-  if (prof_audio_decode == -1)
-    prof_audio_decode = xine_profiler_allocate_slot ("audio decoder/output");
+  uint64_t         t;
 
-  while (running) {
+  while (this->running) {
 
     lprintf ("audio_loop: waiting for package...\n");
 
-    if( !replaying_headers )
-      buf = stream->audio_fifo->get (stream->audio_fifo);
+    if( !this->replaying_headers ) {
+      if (this->task.executor) {
+        if (!this->batch--) {
+          _x_task_wake (&this->task);
+          break;
+        }
+        buf = _x_fifo_buffer_try_get (stream->audio_fifo);
+        if (!buf)
+          break;
+      } else
+        buf = stream->audio_fifo->get (stream->audio_fifo);
+    }
 
     lprintf ("audio_loop: got package pts = %"PRId64", type = %08x\n", buf->pts, buf->type);
 
@@ -104,22 +137,22 @@ static void *audio_decoder_loop (void *stream_gen) {
       if( !(buf->decoder_flags & BUF_FLAG_GAPLESS_SW) )
         stream->metronom->handle_audio_discontinuity (stream->metronom, DISC_STREAMSTART, 0);
 
-      buftype_unknown = 0;
+      this->buftype_unknown = 0;
       break;
 
     case BUF_CONTROL_END:
 
       /* free all held header buffers, see comments below */
-      if( first_header ) {
+      if( this->first_header ) {
         buf_element_t  *cur, *next;
 
-        cur = first_header;
+        cur = this->first_header;
         while( cur ) {
           next = cur->next;
           cur->free_buffer (cur);
           cur = next;
         }
-        first_header = last_header = NULL;
+        this->first_header = this->last_header = NULL;
       }
 
       /*
@@ -127,6 +160,7 @@ static void *audio_decoder_loop (void *stream_gen) {
        * to the frontend. this test is only valid if there is only a single
        * stream attached to the current output port.
        */
+      _x_executor_block_enter ();
       while(1) {
         int num_bufs, num_streams;
 
@@ -149,6 +183,8 @@ static void *audio_decoder_loop (void *stream_gen) {
       lprintf ("reached end marker # %d\n", stream->finished_count_audio);
 
       pthread_cond_broadcast (&stream->counter_changed);
+      if (stream->demux_task)
+        _x_task_wake (stream->demux_task);
 
       if (stream->video_thread_created) {
         while (stream->finished_count_video < stream->finished_count_audio) {
@@ -162,6 +198,7 @@ static void *audio_decoder_loop (void *stream_gen) {
         }
       }
       pthread_mutex_unlock (&stream->counter_lock);
+      _x_executor_block_leave ();
       stream->audio_channel_auto = -1;
 
       break;
@@ -178,7 +215,7 @@ static void *audio_decoder_loop (void *stream_gen) {
       }
 
       running_ticket->release(running_ticket, 0);
-      running = 0;
+      this->running = 0;
       break;
 
     case BUF_CONTROL_NOP:
@@ -246,7 +283,7 @@ static void *audio_decoder_loop (void *stream_gen) {
       if (_x_stream_info_get(stream, XINE_STREAM_INFO_IGNORE_AUDIO))
         break;
 
-      xine_profiler_start_count (prof_audio_decode);
+      t = xine_tp_start ();
 
       running_ticket->acquire(running_ticket, 0);
 
@@ -285,7 +322,7 @@ static void *audio_decoder_loop (void *stream_gen) {
           stream->audio_track_map[i] = buf->type;
           stream->audio_track_map_entries++;
           /* implicit channel change - reopen decoder below */
-          if ((i == 0) && (audio_channel_user == -1) && (stream->audio_channel_auto < 0))
+          if ((i == 0) && (this->audio_channel_user == -1) && (stream->audio_channel_auto < 0))
             stream->audio_decoder_streamtype = -1;
 
 	  ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
@@ -296,12 +333,12 @@ static void *audio_decoder_loop (void *stream_gen) {
 	/* find out which audio type to decode */
 
 	lprintf ("audio_channel_user = %d, map[0]=%08x\n",
-		 audio_channel_user,
+		 this->audio_channel_user,
 		 stream->audio_track_map[0]);
 
-	if (audio_channel_user > -2) {
+	if (this->audio_channel_user > -2) {
 
-	  if (audio_channel_user == -1) {
+	  if (this->audio_channel_user == -1) {
 
 	    /* auto */
 
@@ -318,8 +355,8 @@ static void *audio_decoder_loop (void *stream_gen) {
 	      audio_type = stream->audio_track_map[0];
 
 	  } else {
-	    if (audio_channel_user <= stream->audio_track_map_entries)
-	      audio_type = stream->audio_track_map[audio_channel_user];
+	    if (this->audio_channel_user <= stream->audio_track_map_entries)
+	      audio_type = stream->audio_track_map[this->audio_channel_user];
 	    else
 	      audio_type = -1;
 	  }
@@ -332,7 +369,7 @@ static void *audio_decoder_loop (void *stream_gen) {
 
 	    /* close old decoder of audio type has changed */
 
-            if( buf->type != buftype_unknown &&
+            if( buf->type != this->buftype_unknown &&
                 (stream->audio_decoder_streamtype != streamtype ||
                 !stream->audio_decoder_plugin) ) {
 
@@ -365,7 +402,7 @@ static void *audio_decoder_loop (void *stream_gen) {
 	    if (stream->audio_decoder_plugin)
 	      stream->audio_decoder_plugin->decode_data (stream->audio_decoder_plugin, buf);
 
-	    if (buf->type != buftype_unknown &&
+	    if (buf->type != this->buftype_unknown &&
 	        !_x_stream_info_get(stream, XINE_STREAM_INFO_AUDIO_HANDLED)) {
 	      xine_log (stream->xine, XINE_LOG_MSG,
 			_("audio_decoder: no plugin available to handle '%s'\n"), _x_buf_audio_name( buf->type ) );
@@ -373,7 +410,7 @@ static void *audio_decoder_loop (void *stream_gen) {
               if( !_x_meta_info_get(stream, XINE_META_INFO_AUDIOCODEC) )
                 _x_meta_info_set_utf8(stream, XINE_META_INFO_AUDIOCODEC, _x_buf_audio_name( buf->type ));
 
-	      buftype_unknown = buf->type;
+	      this->buftype_unknown = buf->type;
 
 	      /* fatal error - dispose plugin */
 	      if (stream->audio_decoder_plugin) {
@@ -383,17 +420,17 @@ static void *audio_decoder_loop (void *stream_gen) {
 	    }
 	  }
 	}
-      } else if( buf->type != buftype_unknown ) {
+      } else if( buf->type != this->buftype_unknown ) {
 	  xine_log (stream->xine, XINE_LOG_MSG,
 		    _("audio_decoder: error, unknown buffer type: %08x\n"), buf->type );
-	  buftype_unknown = buf->type;
+	  this->buftype_unknown = buf->type;
       }
 
       if (running_ticket->ticket_revoked)
         running_ticket->renew(running_ticket, 0);
       running_ticket->release(running_ticket, 0);
 
-      xine_profiler_stop_count (prof_audio_decode);
+      xine_tp_stop (tp_audio_decode, t);
     }
 
     /* some decoders require a full reinitialization when audio
@@ -403,9 +440,9 @@ static void *audio_decoder_loop (void *stream_gen) {
      * we must close the old decoder and process all the headers
      * again, since they are needed for decoder initialization.
      */
-    if( audio_channel_user != stream->audio_channel_user &&
-        !replaying_headers ) {
-      audio_channel_user = stream->audio_channel_user;
+    if( this->audio_channel_user != stream->audio_channel_user &&
+        !this->replaying_headers ) {
+      this->audio_channel_user = stream->audio_channel_user;
 
       if (stream->audio_decoder_plugin) {
 	/* decoder dispose might call port functions */
@@ -419,51 +456,72 @@ static void *audio_decoder_loop (void *stream_gen) {
       }
 
       buf->free_buffer (buf);
-      if( first_header ) {
-        replaying_headers = 1;
-        buf = first_header;
+      if( this->first_header ) {
+        this->replaying_headers = 1;
+        buf = this->first_header;
       } else {
-        replaying_headers = 0;
+        this->replaying_headers = 0;
       }
-    } else if( !replaying_headers ) {
+    } else if( !this->replaying_headers ) {
 
       /* header buffers are never freed. instead they
        * are added to a list to allow replaying them
        * in case of a channel change.
        */
       if( (buf->decoder_flags & BUF_FLAG_HEADER) ) {
-        if( last_header )
-          last_header->next = buf;
+        if( this->last_header )
+          this->last_header->next = buf;
         else
-          first_header = buf;
+          this->first_header = buf;
         buf->next = NULL;
-        last_header = buf;
+        this->last_header = buf;
       } else {
         buf->free_buffer (buf);
       }
     } else {
       buf = buf->next;
       if( !buf )
-        replaying_headers = 0;
+        this->replaying_headers = 0;
     }
   }
 
+  /* task returning for now */
+  if (this->running)
+    return;
+
   /* free all held header buffers */
-  if( first_header ) {
+  if( this->first_header ) {
     buf_element_t  *cur, *next;
 
-    cur = first_header;
+    cur = this->first_header;
     while( cur ) {
       next = cur->next;
       cur->free_buffer (cur);
       cur = next;
     }
-    first_header = last_header = NULL;
+    this->first_header = this->last_header = NULL;
   }
+}
+
+static void *audio_decoder_loop (void *stream_gen) {
+
+  audio_decoder_state_t state;
+
+  memset (&state, 0, sizeof (state));
+  audio_decoder_state_init (&state, (xine_stream_t *) stream_gen);
+  audio_decoder_run (&state);
 
   return NULL;
 }
 
+static void audio_decoder_task_run (xine_task_t *task) {
+
+  audio_decoder_state_t *this = (audio_decoder_state_t *) task;
+
+  this->batch = TASK_BATCH;
+  audio_decoder_run (this);
+}
+
 int _x_audio_decoder_init (xine_stream_t *stream) {
 
   pthread_attr_t       pth_attrs;
@@ -506,6 +564,20 @@ int _x_audio_decoder_init (xine_stream_t *stream) {
      * stream->audio_temp = lrb_new (100, stream->audio_fifo);
      */
 
+    /* run as a task on the shared decoder threads */
+    if (stream->xine->executor) {
+      audio_decoder_state_t *state = calloc (1, sizeof (audio_decoder_state_t));
+      if (!state)
+        return 0;
+      audio_decoder_state_init (state, stream);
+      _x_task_init (&state->task, stream->xine->executor, audio_decoder_task_run);
+      stream->audio_decoder_task   = &state->task;
+      /* the decoder is there, other stages test this */
+      stream->audio_thread_created = 1;
+      _x_fifo_buffer_set_task (stream->audio_fifo, stream->audio_decoder_task);
+      return 1;
+    }
+
     pthread_attr_init(&pth_attrs);
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
     pthread_attr_getschedparam(&pth_attrs, &pth_params);
@@ -541,7 +613,13 @@ void _x_audio_decoder_shutdown (xine_stream_t *stream) {
     buf->type = BUF_CONTROL_QUIT;
     stream->audio_fifo->put (stream->audio_fifo, buf);
 
-    pthread_join (stream->audio_thread, &p);
+    if (stream->audio_decoder_task) {
+      _x_task_wait (stream->audio_decoder_task);
+      _x_fifo_buffer_set_task (stream->audio_fifo, NULL);
+      free (stream->audio_decoder_task);
+      stream->audio_decoder_task = NULL;
+    } else
+      pthread_join (stream->audio_thread, &p);
     stream->audio_thread_created = 0;
   }
 
@@ -68,6 +68,7 @@
 #include "config.h"
 #endif
 
+#include <stddef.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
@@ -94,6 +95,7 @@
 #include <xine/audio_out.h>
 #include <xine/resample.h>
 #include <xine/metronom.h>
+#include "xine_private.h"
 
 
 #define NUM_AUDIO_BUFFERS       32
@@ -112,20 +114,20 @@
  *
  * Unfortunately audio fifo adds a large delay to our closed loop.
  *
- * The defines below are designed to avoid updating the metronom too fast.
- * - it will only be updated 1 time per second (so it has a chance of
- *   distributing the error for several frames).
- * - it will only be updated 2 times for the whole audio fifo size
- *   length (so the control will wait to see the feedback effect)
- * - each update will be of gap/SYNC_GAP_RATE.
+ * So the gap is not fed back as it is. A clock recovery filter estimates
+ * the sound card drift from it and yields a correction rate, which follows
+ * the drift and slowly pulls gaps beyond gap_tolerance/2 back (see
+ * clock_recovery.c). The metronom is adjusted by that rate in small steps
+ * every SYNC_TIME_INVERVAL, instead of jumps by a part of the gap.
  *
  * Sound card clock correction can only provide smooth playback for
- * errors < 1% nominal rate. For bigger errors (bad streams) audio
+ * errors < 0.5% nominal rate. For bigger errors (bad streams) audio
  * buffers may be dropped or gaps filled with silence.
  */
-#define SYNC_TIME_INVERVAL  (1 * 90000)
-#define SYNC_BUF_INTERVAL   NUM_AUDIO_BUFFERS / 2
-#define SYNC_GAP_RATE       4
+#define SYNC_TIME_INVERVAL  (90000 / 4)
+#define SYNC_TAU            (10 * 90000)
+#define SYNC_PULL           (20 * 90000)
+#define SYNC_MAX_RATE       0.005
 
 /* Alternative for metronom feedback: fix sound card clock drift
  * by resampling all audio data, so that the sound card keeps in
@@ -135,21 +137,11 @@
  * want smooth playback). Resampling then avoids A/V sync problems,
  * gaps filled with 0-frames and jerky video playback due to different
  * clock speeds of the sound card and DXR3/H+.
+ *
+ * The correction rate of the same filter is the resampling factor then.
+ * Gaps up to RESAMPLE_DEADBAND are left alone.
  */
-#define RESAMPLE_SYNC_WINDOW 50
-#define RESAMPLE_MAX_GAP_DIFF 150
-#define RESAMPLE_REDUCE_GAP_THRESHOLD 200
-
-
-
-typedef struct {
-  double   last_factor;
-  int      window;
-  int      reduce_gap;
-  uint64_t window_duration, last_vpts;
-  int64_t  recent_gap[8], last_avg_gap;
-  int      valid;
-} resample_sync_t;
+#define RESAMPLE_DEADBAND   200
 
 /*
  * equalizer stuff
@@ -232,7 +224,11 @@ typedef struct {
   int32_t         frames_per_kpts;      /* frames per 1024/90000 sec                  */
 
   int             av_sync_method_conf;
-  resample_sync_t resample_sync_info;
+  xine_clock_recovery_t sync;           /* sound card against master clock, audio thread only */
+  int             sync_reset;           /* forget the sync estimate */
+  int64_t         sync_time;            /* last update */
+  int64_t         sync_adjust_time;     /* last metronom feedback */
+  double          sync_pending;         /* metronom feedback not yet passed on, pts */
   double          resample_sync_factor; /* correct buffer length by this factor
                                          * to sync audio hardware to (dxr3) clock */
   int             resample_sync_method; /* fix sound card clock drift by resampling */
@@ -282,8 +278,21 @@ typedef struct {
 
   int             last_gap;
 
+  /* see _x_clock_free_run_wait() */
+  int             clock_client;
+  int             free_run;     /* as last told to the driver */
+
+  /* output loop state, see ao_loop_step() */
+  xine_task_t     task;         /* instead of audio_thread on xine->executor */
+  audio_buffer_t *loop_buf;     /* taken from out_fifo, not yet played */
+
 } aos_t;
 
+static xine_tracepoint_t tp_write       = XINE_TRACEPOINT ("audio_out.write");
+static xine_tracepoint_t tp_dropped     = XINE_TRACEPOINT ("audio_out.dropped");
+static xine_tracepoint_t tp_gap_filled  = XINE_TRACEPOINT ("audio_out.gap_filled");
+static xine_tracepoint_t tp_sync_adjust = XINE_TRACEPOINT ("audio_out.sync_adjust");
+
 struct audio_fifo_s {
   audio_buffer_t    *first;
   audio_buffer_t    *last;
@@ -294,6 +303,8 @@ struct audio_fifo_s {
 
   int                num_buffers;
   int                num_buffers_max;
+
+  xine_task_t       *task;      /* woken on append */
 };
 
 static int ao_get_property (xine_audio_port_t *this_gen, int property);
@@ -343,6 +354,8 @@ static void fifo_append_int (audio_fifo_t *fifo,
     fifo->num_buffers_max = fifo->num_buffers;
 
   pthread_cond_signal (&fifo->not_empty);
+  if (fifo->task)
+    _x_task_wake (fifo->task);
 }
 
 static void fifo_append (audio_fifo_t *fifo,
@@ -425,6 +438,19 @@ static audio_buffer_t *fifo_remove_nonblock (audio_fifo_t *fifo) {
   return buf;
 }
 
+/* never waits */
+static audio_buffer_t *fifo_try_remove (audio_fifo_t *fifo) {
+
+  audio_buffer_t *buf = NULL;
+
+  pthread_mutex_lock (&fifo->mutex);
+  if (fifo->first)
+    buf = fifo_remove_int(fifo, 0);
+  pthread_mutex_unlock (&fifo->mutex);
+
+  return buf;
+}
+
 /* This function is currently not needed */
 #if 0
 static int fifo_num_buffers (audio_fifo_t *fifo) {
@@ -442,11 +468,15 @@ static int fifo_num_buffers (audio_fifo_t *fifo) {
 static void fifo_wait_empty (audio_fifo_t *fifo) {
 
   pthread_mutex_lock (&fifo->mutex);
-  while (fifo->first) {
-    /* i think it's strange to send not_empty signal here (beside the enqueue
-     * function), but it should do no harm. [MF] */
-    pthread_cond_signal (&fifo->not_empty);
-    pthread_cond_wait (&fifo->empty, &fifo->mutex);
+  if (fifo->first) {
+    _x_executor_block_enter ();
+    while (fifo->first) {
+      /* i think it's strange to send not_empty signal here (beside the enqueue
+       * function), but it should do no harm. [MF] */
+      pthread_cond_signal (&fifo->not_empty);
+      pthread_cond_wait (&fifo->empty, &fifo->mutex);
+    }
+    _x_executor_block_leave ();
   }
   pthread_mutex_unlock (&fifo->mutex);
 }
@@ -480,11 +510,15 @@ static void ao_fill_gap (aos_t *this, int64_t pts_len) {
   xprintf (this->xine, XINE_VERBOSITY_DEBUG,
            "audio_out: inserting %" PRId64 " 0-frames to fill a gap of %" PRId64 " pts\n", num_frames, pts_len);
 
+  xine_tp_hit (tp_gap_filled, num_frames);
+
   if ((this->output.mode == AO_CAP_MODE_A52) || (this->output.mode == AO_CAP_MODE_AC5)) {
     write_pause_burst(this,num_frames);
     return;
   }
 
+  /* the driver blocks while the device is busy */
+  _x_executor_block_enter ();
   while (num_frames > 0 && !this->discard_buffers) {
     if (num_frames > ZERO_BUF_SIZE) {
       pthread_mutex_lock( &this->driver_lock );
@@ -500,6 +534,7 @@ static void ao_fill_gap (aos_t *this, int64_t pts_len) {
       num_frames = 0;
     }
   }
+  _x_executor_block_leave ();
 }
 
 static void ensure_buffer_size (audio_buffer_t *buf, int bytes_per_frame,
@@ -864,128 +899,66 @@ static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
 }
 
 
-static int resample_rate_adjust(aos_t *this, int64_t gap, audio_buffer_t *buf) {
-
-  /* Calculates the drift factor used to resample the audio data to
-   * keep in sync with system (or dxr3) clock.
-   *
-   * To compensate the sound card drift it is necessary to know, how many audio
-   * frames need to be added (or removed) via resampling. This function waits for
-   * RESAMPLE_SYNC_WINDOW audio buffers to be sent to the card and keeps track
-   * of their total duration in vpts. With the measured gap difference between
-   * the reported gap values at the beginning and at the end of this window the
-   * required resampling factor is calculated:
-   *
-   * resample_factor = (duration + gap_difference) / duration
-   *
-   * This factor is then used in prepare_samples() to resample the audio
-   * buffers as needed so we keep in sync with the system (or dxr3) clock.
-   */
-
-  resample_sync_t *info = &this->resample_sync_info;
-  int64_t avg_gap = 0;
-  double factor;
-  double diff;
-  double duration;
-  int i;
-
-  if (abs(gap) > AO_MAX_GAP) {
-    /* drop buffers or insert 0-frames in audio out loop */
-    info->valid = 0;
-    return -1;
-  }
+/*
+ * Keep the sound card in sync with the master clock: feed the gap to the
+ * clock recovery, and apply its correction rate by resampling or through
+ * the metronom. Gaps too big for that are dropped or padded by the caller.
+ */
+static void ao_sync_update (aos_t *this, int64_t cur_time, int64_t gap) {
+  xine_list_iterator_t ite;
+  double               rate, factor;
+  int64_t              adjust;
 
-  if ( ! info->valid) {
-    this->resample_sync_factor = 1.0;
-    info->window = 0;
-    info->reduce_gap = 0;
-    info->last_avg_gap = gap;
-    info->last_factor = 0;
-    info->window_duration = info->last_vpts = 0;
-    info->valid = 1;
+  if (this->sync_reset) {
+    this->sync_reset = 0;
+    _x_clock_recovery_reset (&this->sync, 0);
+    this->sync_pending = 0;
   }
 
-  /* calc average gap (to compensate small errors during measurement) */
-  for (i = 0; i < 7; i++) info->recent_gap[i] = info->recent_gap[i + 1];
-  info->recent_gap[i] = gap;
-  for (i = 0; i < 8; i++) avg_gap += info->recent_gap[i];
-  avg_gap /= 8;
-
-
-  /* gap too big? Change sample rate so that gap converges towards 0. */
-
-  if (abs(avg_gap) > RESAMPLE_REDUCE_GAP_THRESHOLD && !info->reduce_gap) {
-    info->reduce_gap = 1;
-    this->resample_sync_factor = (avg_gap < 0) ? 0.995 : 1.005;
-
-    llprintf (LOG_RESAMPLE_SYNC,
-              "sample rate adjusted to reduce gap: gap=%" PRId64 "\n", avg_gap);
-    return 0;
-
-  } else if (info->reduce_gap && abs(avg_gap) < 50) {
-    info->reduce_gap = 0;
-    info->valid = 0;
-    llprintf (LOG_RESAMPLE_SYNC, "gap successfully reduced\n");
-    return 0;
-
-  } else if (info->reduce_gap) {
-    /* re-check, because the gap might suddenly change its sign,
-     * also slow down, when getting close to zero (-300<gap<300) */
-    if (abs(avg_gap) > 300)
-      this->resample_sync_factor = (avg_gap < 0) ? 0.995 : 1.005;
-    else
-      this->resample_sync_factor = (avg_gap < 0) ? 0.998 : 1.002;
-    return 0;
+  if (this->resample_sync_method) {
+    this->sync.deadband = RESAMPLE_DEADBAND;
+    rate   = _x_clock_recovery_update (&this->sync, cur_time, gap);
+    factor = 1.0 + rate;
+    if (factor != this->resample_sync_factor) {
+      this->resample_sync_factor = factor;
+      xine_tp_hit (tp_sync_adjust, 1);
+      llprintf (LOG_RESAMPLE_SYNC,
+                "gap=%5" PRId64 " drift=%.0f ppm jitter=%.0f pts factor=%f\n",
+                gap, this->sync.drift * 1000000.0, this->sync.jitter, factor);
+    }
+    this->sync_time = cur_time;
+    return;
   }
+  this->resample_sync_factor = 1.0;
 
+  /* drivers syncing on their own tolerate any gap */
+  if (this->gap_tolerance >= AO_MAX_GAP)
+    return;
 
-  if (info->window > RESAMPLE_SYNC_WINDOW) {
-
-    /* adjust drift correction */
-
-    int64_t gap_diff = avg_gap - info->last_avg_gap;
-
-    if (gap_diff < RESAMPLE_MAX_GAP_DIFF) {
-#if LOG_RESAMPLE_SYNC
-      int num_frames;
-
-      /* if we are already resampling to a different output rate, consider
-       * this during calculation */
-      num_frames = (this->do_resample) ? (buf->num_frames * this->frame_rate_factor)
-        : buf->num_frames;
-      printf("audio_out: gap=%5" PRId64 ";  gap_diff=%5" PRId64 ";  frame_diff=%3.0f;  drift_factor=%f\n",
-             avg_gap, gap_diff, num_frames * info->window * info->last_factor,
-             this->resample_sync_factor);
-#endif
-      /* we want to add factor * num_frames to each buffer */
-      diff = gap_diff;
-#if _MSCVER <= 1200
-      /* ugly hack needed by old Visual C++ 6.0 */
-      duration = (int64_t)info->window_duration;
-#else
-      duration = info->window_duration;
-#endif
-      factor = diff / duration + info->last_factor;
-
-      info->last_factor = factor;
-      this->resample_sync_factor = 1.0 + factor;
+  this->sync.deadband = this->gap_tolerance / 2;
+  rate = _x_clock_recovery_update (&this->sync, cur_time, gap);
 
-      info->last_avg_gap = avg_gap;
-      info->window_duration = 0;
-      info->window = 0;
-    } else
-      info->valid = 0;
+  /* the rate applies since the last update */
+  if (this->sync_time && cur_time > this->sync_time)
+    this->sync_pending -= rate * (cur_time - this->sync_time);
+  this->sync_time = cur_time;
 
-  } else {
+  adjust = this->sync_pending;
+  if (!adjust || cur_time < this->sync_adjust_time + SYNC_TIME_INVERVAL)
+    return;
+  this->sync_pending   -= adjust;
+  this->sync_adjust_time = cur_time;
 
-    /* collect data for next adjustment */
-    if (info->window > 0)
-      info->window_duration += buf->vpts - info->last_vpts;
-    info->last_vpts = buf->vpts;
-    info->window++;
+  lprintf ("audio_loop: ADJ_VPTS\n");
+  xine_tp_hit (tp_sync_adjust, 1);
+  pthread_mutex_lock(&this->streams_lock);
+  for (ite = xine_list_front(this->streams); ite;
+       ite = xine_list_next(this->streams, ite)) {
+    xine_stream_t *stream = xine_list_get_value(this->streams, ite);
+    if (stream == XINE_ANON_STREAM) continue;
+    stream->metronom->set_option(stream->metronom, METRONOM_ADJ_VPTS_OFFSET, adjust);
   }
-
-  return 0;
+  pthread_mutex_unlock(&this->streams_lock);
 }
 
 static int ao_change_settings(aos_t *this, uint32_t bits, uint32_t rate, int mode);
@@ -996,325 +969,392 @@ static int ao_change_settings(aos_t *this, uint32_t bits, uint32_t rate, int mod
  * 3) Get delay
  * 4) Do drop, 0-fill or output samples.
  * 5) Go round loop again.
+ *
+ * ao_loop_step() is one round for this->loop_buf. it returns usec to
+ * wait before the next round, 0 to go on now.
  */
-static void *ao_loop (void *this_gen) {
+static int ao_loop_step (aos_t *this) {
 
-  aos_t *this = (aos_t *) this_gen;
+  audio_buffer_t *in_buf = this->loop_buf, *out_buf;
   int64_t         hw_vpts;
-  audio_buffer_t *in_buf, *out_buf;
   int64_t         gap;
   int64_t         delay;
   int64_t         cur_time;
-  int64_t         last_sync_time;
-  int             bufs_since_sync;
   int             result;
+  int             free_run;
 
-  last_sync_time = bufs_since_sync = 0;
-  in_buf = NULL;
-  cur_time = -1;
+  pthread_mutex_lock(&this->flush_audio_driver_lock);
+  if (this->flush_audio_driver) {
+    this->ao.control(&this->ao, AO_CTRL_FLUSH_BUFFERS, NULL);
+    this->flush_audio_driver--;
+    pthread_cond_broadcast(&this->flush_audio_driver_reached);
+  }
 
-  while ((this->audio_loop_running) ||
-	 (!this->audio_loop_running && this->out_fifo->first)) {
+  if (this->discard_buffers) {
+    fifo_remove (this->out_fifo);
+    if (in_buf->stream)
+      _x_refcounter_dec(in_buf->stream->refcounter);
+    fifo_append (this->free_fifo, in_buf);
+    this->loop_buf = NULL;
+    pthread_mutex_unlock(&this->flush_audio_driver_lock);
+    return 0;
+  }
+  pthread_mutex_unlock(&this->flush_audio_driver_lock);
 
-    /*
-     * get buffer to process for this loop iteration
-     */
 
-    if (!in_buf) {
-      lprintf ("loop: get buf from fifo\n");
-      in_buf = fifo_peek (this->out_fifo);
-      bufs_since_sync++;
-      lprintf ("got a buffer\n");
-    }
+  /*
+   * wait until user unpauses stream
+   * if we are playing at a different speed (without slow_fast_audio flag)
+   * we must process/free buffers otherwise the entire engine will stop.
+   */
 
-    pthread_mutex_lock(&this->flush_audio_driver_lock);
-    if (this->flush_audio_driver) {
-      this->ao.control(&this->ao, AO_CTRL_FLUSH_BUFFERS, NULL);
-      this->flush_audio_driver--;
-      pthread_cond_broadcast(&this->flush_audio_driver_reached);
-    }
+  pthread_mutex_lock(&this->current_speed_lock);
+  if ( this->audio_loop_running &&
+       (this->clock->speed == XINE_SPEED_PAUSE ||
+        (this->clock->speed != XINE_FINE_SPEED_NORMAL &&
+         !this->slow_fast_audio) ) )  {
+
+    if (this->clock->speed != XINE_SPEED_PAUSE) {
+
+      cur_time = this->clock->get_current_time (this->clock);
+      if (in_buf->vpts < cur_time ) {
+        lprintf ("loop: next fifo\n");
+        fifo_remove (this->out_fifo);
+        if (in_buf->stream)
+          _x_refcounter_dec(in_buf->stream->refcounter);
+        fifo_append (this->free_fifo, in_buf);
+        this->loop_buf = NULL;
+        pthread_mutex_unlock(&this->current_speed_lock);
+        return 0;
+      }
 
-    if (this->discard_buffers) {
-      fifo_remove (this->out_fifo);
-      if (in_buf->stream)
-	_x_refcounter_dec(in_buf->stream->refcounter);
-      fifo_append (this->free_fifo, in_buf);
-      in_buf = NULL;
-      pthread_mutex_unlock(&this->flush_audio_driver_lock);
-      continue;
+      if ((in_buf->vpts - cur_time) > 2 * 90000)
+        xprintf (this->xine, XINE_VERBOSITY_DEBUG,
+               "audio_out: vpts/clock error, in_buf->vpts=%" PRId64 " cur_time=%" PRId64 "\n",
+               in_buf->vpts, cur_time);
     }
-    pthread_mutex_unlock(&this->flush_audio_driver_lock);
 
+    _x_clock_free_run_idle (this->clock, this->clock_client);
+    lprintf ("loop:pause: I feel sleepy (%d buffers).\n", this->out_fifo->num_buffers);
+    pthread_mutex_unlock(&this->current_speed_lock);
+    return 10000;
+  }
 
-    /*
-     * wait until user unpauses stream
-     * if we are playing at a different speed (without slow_fast_audio flag)
-     * we must process/free buffers otherwise the entire engine will stop.
-     */
+  /* change driver's settings as needed */
+  pthread_mutex_lock( &this->driver_lock );
+  if( in_buf && in_buf->num_frames ) {
+    if( !this->driver_open ||
+       in_buf->format.bits != this->input.bits ||
+       in_buf->format.rate != this->input.rate ||
+       in_buf->format.mode != this->input.mode ) {
+       lprintf("audio format has changed\n");
+       if( !in_buf->stream->emergency_brake &&
+           ao_change_settings(this,
+                              in_buf->format.bits,
+                              in_buf->format.rate,
+                              in_buf->format.mode) == 0 ) {
+           in_buf->stream->emergency_brake = 1;
+           _x_message (in_buf->stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
+       }
+    }
+  }
 
-    pthread_mutex_lock(&this->current_speed_lock);
-    if ( this->audio_loop_running &&
-         (this->clock->speed == XINE_SPEED_PAUSE ||
-          (this->clock->speed != XINE_FINE_SPEED_NORMAL &&
-           !this->slow_fast_audio) ) )  {
-
-      if (this->clock->speed != XINE_SPEED_PAUSE) {
-
-	cur_time = this->clock->get_current_time (this->clock);
-	if (in_buf->vpts < cur_time ) {
-	  lprintf ("loop: next fifo\n");
-	  fifo_remove (this->out_fifo);
-	  if (in_buf->stream)
-	    _x_refcounter_dec(in_buf->stream->refcounter);
-	  fifo_append (this->free_fifo, in_buf);
-	  in_buf = NULL;
-	  pthread_mutex_unlock(&this->current_speed_lock);
-	  continue;
-	}
-
-        if ((in_buf->vpts - cur_time) > 2 * 90000)
-	  xprintf (this->xine, XINE_VERBOSITY_DEBUG,
-		 "audio_out: vpts/clock error, in_buf->vpts=%" PRId64 " cur_time=%" PRId64 "\n",
-		 in_buf->vpts, cur_time);
-      }
+  free_run = this->clock->get_option (this->clock, CLOCK_FREE_RUN);
+  if (this->driver_open && free_run != this->free_run) {
+    this->driver->control (this->driver, AO_CTRL_FREE_RUN, free_run);
+    this->free_run = free_run;
+  }
 
-      lprintf ("loop:pause: I feel sleepy (%d buffers).\n", this->out_fifo->num_buffers);
-      pthread_mutex_unlock(&this->current_speed_lock);
-      xine_usec_sleep (10000);
-      lprintf ("loop:pause: I wake up.\n");
-      continue;
+  if(this->driver_open) {
+    delay = this->driver->delay(this->driver);
+    while (delay < 0 && this->audio_loop_running) {
+      /* Get the audio card into RUNNING state. */
+      ao_fill_gap (this, 10000); /* FIXME, this PTS of 1000 should == period size */
+      delay = this->driver->delay(this->driver);
     }
+    pthread_mutex_unlock( &this->driver_lock );
+  } else {
+    xine_stream_t *stream;
+    delay = 0;
 
-    /* change driver's settings as needed */
-    pthread_mutex_lock( &this->driver_lock );
-    if( in_buf && in_buf->num_frames ) {
-      if( !this->driver_open ||
-         in_buf->format.bits != this->input.bits ||
-         in_buf->format.rate != this->input.rate ||
-         in_buf->format.mode != this->input.mode ) {
-         lprintf("audio format has changed\n");
-         if( !in_buf->stream->emergency_brake &&
-             ao_change_settings(this,
-                                in_buf->format.bits,
-                                in_buf->format.rate,
-                                in_buf->format.mode) == 0 ) {
-             in_buf->stream->emergency_brake = 1;
-             _x_message (in_buf->stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
-         }
-      }
-    }
+    pthread_mutex_unlock( &this->driver_lock );
 
-    if(this->driver_open) {
-      delay = this->driver->delay(this->driver);
-      while (delay < 0 && this->audio_loop_running) {
-        /* Get the audio card into RUNNING state. */
-        ao_fill_gap (this, 10000); /* FIXME, this PTS of 1000 should == period size */
-        delay = this->driver->delay(this->driver);
-      }
-      pthread_mutex_unlock( &this->driver_lock );
-    } else {
-      xine_stream_t *stream;
-      delay = 0;
+    if (in_buf && in_buf->num_frames) {
+      xine_list_iterator_t ite;
 
-      pthread_mutex_unlock( &this->driver_lock );
+      xprintf(this->xine, XINE_VERBOSITY_LOG,
+              _("audio_out: delay calculation impossible with an unavailable audio device\n"));
 
-      if (in_buf && in_buf->num_frames) {
-	xine_list_iterator_t ite;
-
-	xprintf(this->xine, XINE_VERBOSITY_LOG,
-		_("audio_out: delay calculation impossible with an unavailable audio device\n"));
-
-	pthread_mutex_lock(&this->streams_lock);
-	for (ite = xine_list_front(this->streams);
-	     ite; ite = xine_list_next(this->streams, ite)) {
-	  stream = xine_list_get_value (this->streams, ite);
-          if( !stream->emergency_brake ) {
-            stream->emergency_brake = 1;
-            _x_message (stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
-          }
-	}
-	pthread_mutex_unlock(&this->streams_lock);
+      pthread_mutex_lock(&this->streams_lock);
+      for (ite = xine_list_front(this->streams);
+           ite; ite = xine_list_next(this->streams, ite)) {
+        stream = xine_list_get_value (this->streams, ite);
+        if( !stream->emergency_brake ) {
+          stream->emergency_brake = 1;
+          _x_message (stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
+        }
       }
+      pthread_mutex_unlock(&this->streams_lock);
     }
+  }
 
-    cur_time = this->clock->get_current_time (this->clock);
+  /*
+   * free-run: no need to sync to the clock, the clock syncs to us.
+   * play the buffer when the clock gets there, nothing is dropped
+   * or padded.
+   */
+  if (free_run && in_buf->num_frames &&
+      _x_clock_free_run_wait (this->clock, this->clock_client, in_buf->vpts, 10000) < 0) {
+    pthread_mutex_unlock(&this->current_speed_lock);
+    return 0;
+  }
 
-    /* we update current_extra_info if either there is no video stream that could do that
-     * or if the current_extra_info is getting too much out of date */
-    if( in_buf && in_buf->stream && (!in_buf->stream->video_decoder_plugin ||
-        (cur_time - in_buf->stream->current_extra_info->vpts) > 30000 )) {
+  cur_time = this->clock->get_current_time (this->clock);
 
-      pthread_mutex_lock( &in_buf->stream->current_extra_info_lock );
-      _x_extra_info_merge( in_buf->stream->current_extra_info, in_buf->extra_info );
-      pthread_mutex_unlock( &in_buf->stream->current_extra_info_lock );
-    }
+  /* we update current_extra_info if either there is no video stream that could do that
+   * or if the current_extra_info is getting too much out of date */
+  if( in_buf && in_buf->stream && (!in_buf->stream->video_decoder_plugin ||
+      (cur_time - in_buf->stream->current_extra_info->vpts) > 30000 )) {
 
-    /*
-     * where, in the timeline is the "end" of the
-     * hardware audio buffer at the moment?
-     */
+    pthread_mutex_lock( &in_buf->stream->current_extra_info_lock );
+    _x_extra_info_merge( in_buf->stream->current_extra_info, in_buf->extra_info );
+    pthread_mutex_unlock( &in_buf->stream->current_extra_info_lock );
+  }
 
-    hw_vpts = cur_time;
-    lprintf ("current delay is %" PRId64 ", current time is %" PRId64 "\n", delay, cur_time);
+  /*
+   * where, in the timeline is the "end" of the
+   * hardware audio buffer at the moment?
+   */
 
-    /* External A52 decoder delay correction */
-    if ((this->output.mode==AO_CAP_MODE_A52) || (this->output.mode==AO_CAP_MODE_AC5))
-      delay += this->passthrough_offset;
+  hw_vpts = cur_time;
+  lprintf ("current delay is %" PRId64 ", current time is %" PRId64 "\n", delay, cur_time);
 
-    if(this->frames_per_kpts)
-      hw_vpts += (delay * 1024) / this->frames_per_kpts;
+  /* External A52 decoder delay correction */
+  if ((this->output.mode==AO_CAP_MODE_A52) || (this->output.mode==AO_CAP_MODE_AC5))
+    delay += this->passthrough_offset;
 
-    /*
-     * calculate gap:
-     */
-    gap = in_buf->vpts - hw_vpts;
-    this->last_gap = gap;
-    lprintf ("hw_vpts : %" PRId64 " buffer_vpts : %" PRId64 " gap : %" PRId64 "\n",
-             hw_vpts, in_buf->vpts, gap);
-
-    if (this->resample_sync_method) {
-      /* Correct sound card drift via resampling. If gap is too big to
-       * be corrected this way, we use the fallback: drop/insert frames.
-       * This function only calculates the drift correction factor. The
-       * actual resampling is done by prepare_samples().
-       */
-      resample_rate_adjust(this, gap, in_buf);
-    } else {
-      this->resample_sync_factor = 1.0;
-    }
+  if(this->frames_per_kpts)
+    hw_vpts += (delay * 1024) / this->frames_per_kpts;
 
-    /*
-     * output audio data synced to master clock
+  /*
+   * calculate gap:
+   */
+  gap = free_run ? 0 : in_buf->vpts - hw_vpts;
+  this->last_gap = gap;
+  lprintf ("hw_vpts : %" PRId64 " buffer_vpts : %" PRId64 " gap : %" PRId64 "\n",
+           hw_vpts, in_buf->vpts, gap);
+
+  if (!free_run && abs(gap) <= AO_MAX_GAP) {
+    /* Correct sound card drift via resampling or metronom feedback.
+     * If gap is too big to be corrected this way, we use the fallback:
+     * drop/insert frames. The actual resampling is done by
+     * prepare_samples().
      */
+    if (in_buf->num_frames)
+      ao_sync_update (this, cur_time, gap);
+  } else {
+    /* the clocks did not change, just the offset */
+    _x_clock_recovery_reset (&this->sync, 1);
+    this->sync_time = this->sync_adjust_time = 0;
+    this->resample_sync_factor = 1.0;
+  }
 
-    if (gap < (-1 * AO_MAX_GAP) || !in_buf->num_frames ) {
+  /*
+   * output audio data synced to master clock
+   */
 
-      /* drop package */
-      lprintf ("loop: drop package, next fifo\n");
-      fifo_remove (this->out_fifo);
-      if (in_buf->stream)
-	_x_refcounter_dec(in_buf->stream->refcounter);
-      fifo_append (this->free_fifo, in_buf);
+  if (gap < (-1 * AO_MAX_GAP) || !in_buf->num_frames ) {
 
-      lprintf ("audio package (vpts = %" PRId64 ", gap = %" PRId64 ") dropped\n",
-               in_buf->vpts, gap);
-      in_buf = NULL;
+    /* drop package */
+    lprintf ("loop: drop package, next fifo\n");
+    xine_tp_hit (tp_dropped, 1);
+    fifo_remove (this->out_fifo);
+    if (in_buf->stream)
+      _x_refcounter_dec(in_buf->stream->refcounter);
+    fifo_append (this->free_fifo, in_buf);
 
+    lprintf ("audio package (vpts = %" PRId64 ", gap = %" PRId64 ") dropped\n",
+             in_buf->vpts, gap);
+    this->loop_buf = NULL;
 
-      /* for small gaps ( tolerance < abs(gap) < AO_MAX_GAP )
-       * feedback them into metronom's vpts_offset (when using
-       * metronom feedback for A/V sync)
-       */
-    } else if ( abs(gap) < AO_MAX_GAP && abs(gap) > this->gap_tolerance &&
-                cur_time > (last_sync_time + SYNC_TIME_INVERVAL) &&
-                bufs_since_sync >= SYNC_BUF_INTERVAL &&
-                !this->resample_sync_method ) {
-	xine_list_iterator_t *ite;
-        lprintf ("audio_loop: ADJ_VPTS\n");
-	pthread_mutex_lock(&this->streams_lock);
-	for (ite = xine_list_front(this->streams); ite;
-	     ite = xine_list_next(this->streams, ite)) {
-	  xine_stream_t *stream = xine_list_get_value(this->streams, ite);
-	  if (stream == XINE_ANON_STREAM) continue;
-	  stream->metronom->set_option(stream->metronom, METRONOM_ADJ_VPTS_OFFSET,
-                                       -gap/SYNC_GAP_RATE );
-          last_sync_time = cur_time;
-          bufs_since_sync = 0;
-	}
-	pthread_mutex_unlock(&this->streams_lock);
-
-    } else if ( gap > AO_MAX_GAP ) {
-      /* for big gaps output silence */
-      ao_fill_gap (this, gap);
-    } else {
+  } else if ( gap > AO_MAX_GAP ) {
+    /* for big gaps output silence */
+    ao_fill_gap (this, gap);
+  } else {
 #if 0
-      {
-        int count;
-        printf("Audio data\n");
-        for (count=0;count < 10;count++) {
-          printf("%x ",buf->mem[count]);
-        }
-        printf("\n");
+    {
+      int count;
+      printf("Audio data\n");
+      for (count=0;count < 10;count++) {
+        printf("%x ",buf->mem[count]);
       }
+      printf("\n");
+    }
 #endif
-      out_buf = prepare_samples (this, in_buf);
+    out_buf = prepare_samples (this, in_buf);
 #if 0
-      {
-        int count;
-        printf("Audio data2\n");
-        for (count=0;count < 10;count++) {
-          printf("%x ",out_buf->mem[count]);
-        }
-        printf("\n");
+    {
+      int count;
+      printf("Audio data2\n");
+      for (count=0;count < 10;count++) {
+        printf("%x ",out_buf->mem[count]);
       }
+      printf("\n");
+    }
 #endif
 
-      lprintf ("loop: writing %d samples to sound device\n", out_buf->num_frames);
-
-      if (this->driver_open) {
-        pthread_mutex_lock( &this->driver_lock );
-        result = this->driver_open ? this->driver->write (this->driver, out_buf->mem, out_buf->num_frames ) : 0;
-        pthread_mutex_unlock( &this->driver_lock );
-      } else {
-        result = 0;
-      }
-      fifo_remove (this->out_fifo);
-
-      if( result < 0 ) {
-        /* device unplugged. */
-        xprintf(this->xine, XINE_VERBOSITY_LOG, _("write to sound card failed. Assuming the device was unplugged.\n"));
-        _x_message (in_buf->stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
-
-        pthread_mutex_lock( &this->driver_lock );
-        if(this->driver_open) {
-          this->driver->close(this->driver);
-          this->driver_open = 0;
-          this->driver->exit(this->driver);
-          this->driver = _x_load_audio_output_plugin (this->xine, "none");
-          if (this->driver && !in_buf->stream->emergency_brake &&
-              ao_change_settings(this,
-                in_buf->format.bits,
-                in_buf->format.rate,
-                in_buf->format.mode) == 0) {
-            in_buf->stream->emergency_brake = 1;
-            _x_message (in_buf->stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
-          }
-        }
-        pthread_mutex_unlock( &this->driver_lock );
-        /* closing the driver will result in XINE_MSG_AUDIO_OUT_UNAVAILABLE to be emitted */
-      }
+    lprintf ("loop: writing %d samples to sound device\n", out_buf->num_frames);
 
-      lprintf ("loop: next buf from fifo\n");
-      if (in_buf->stream)
-	_x_refcounter_dec(in_buf->stream->refcounter);
-      fifo_append (this->free_fifo, in_buf);
-      in_buf = NULL;
+    if (this->driver_open) {
+      uint64_t t = xine_tp_start ();
+      _x_executor_block_enter ();
+      pthread_mutex_lock( &this->driver_lock );
+      result = this->driver_open ? this->driver->write (this->driver, out_buf->mem, out_buf->num_frames ) : 0;
+      pthread_mutex_unlock( &this->driver_lock );
+      _x_executor_block_leave ();
+      xine_tp_stop (tp_write, t);
+    } else {
+      result = 0;
     }
-    pthread_mutex_unlock(&this->current_speed_lock);
+    fifo_remove (this->out_fifo);
+
+    if (in_buf->stream)
+      _x_latency_record (in_buf->stream, XINE_LATENCY_AUDIO, in_buf->extra_info);
 
-    /* Give other threads a chance to use functions which require this->driver_lock to
-     * be available. This is needed when using NPTL on Linux (and probably PThreads
-     * on Solaris as well). */
-    if (this->num_driver_actions > 0) {
-      /* calling sched_yield() is not sufficient on multicore systems */
-      /* sched_yield(); */
-      /* instead wait for the other thread to acquire this->driver_lock */
-      pthread_mutex_lock(&this->driver_action_lock);
-      if (this->num_driver_actions > 0)
-        pthread_cond_wait(&this->driver_action_cond, &this->driver_action_lock);
-      pthread_mutex_unlock(&this->driver_action_lock);
+    if( result < 0 ) {
+      /* device unplugged. */
+      xprintf(this->xine, XINE_VERBOSITY_LOG, _("write to sound card failed. Assuming the device was unplugged.\n"));
+      _x_message (in_buf->stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
+
+      pthread_mutex_lock( &this->driver_lock );
+      if(this->driver_open) {
+        this->driver->close(this->driver);
+        this->driver_open = 0;
+        this->driver->exit(this->driver);
+        this->driver = _x_load_audio_output_plugin (this->xine, "none");
+        if (this->driver && !in_buf->stream->emergency_brake &&
+            ao_change_settings(this,
+              in_buf->format.bits,
+              in_buf->format.rate,
+              in_buf->format.mode) == 0) {
+          in_buf->stream->emergency_brake = 1;
+          _x_message (in_buf->stream, XINE_MSG_AUDIO_OUT_UNAVAILABLE, NULL);
+        }
+      }
+      pthread_mutex_unlock( &this->driver_lock );
+      /* closing the driver will result in XINE_MSG_AUDIO_OUT_UNAVAILABLE to be emitted */
     }
-  }
 
-  if (in_buf) {
+    lprintf ("loop: next buf from fifo\n");
     if (in_buf->stream)
       _x_refcounter_dec(in_buf->stream->refcounter);
     fifo_append (this->free_fifo, in_buf);
+    this->loop_buf = NULL;
+  }
+  pthread_mutex_unlock(&this->current_speed_lock);
+
+  /* Give other threads a chance to use functions which require this->driver_lock to
+   * be available. This is needed when using NPTL on Linux (and probably PThreads
+   * on Solaris as well). */
+  if (this->num_driver_actions > 0) {
+    /* calling sched_yield() is not sufficient on multicore systems */
+    /* sched_yield(); */
+    /* instead wait for the other thread to acquire this->driver_lock */
+    _x_executor_block_enter ();
+    pthread_mutex_lock(&this->driver_action_lock);
+    if (this->num_driver_actions > 0)
+      pthread_cond_wait(&this->driver_action_cond, &this->driver_action_lock);
+    pthread_mutex_unlock(&this->driver_action_lock);
+    _x_executor_block_leave ();
+  }
+
+  return 0;
+}
+
+/* the loop has been stopped */
+static void ao_loop_done (aos_t *this) {
+
+  if (this->loop_buf) {
+    if (this->loop_buf->stream)
+      _x_refcounter_dec(this->loop_buf->stream->refcounter);
+    fifo_append (this->free_fifo, this->loop_buf);
+    this->loop_buf = NULL;
   }
+}
+
+static void *ao_loop (void *this_gen) {
+
+  aos_t *this = (aos_t *) this_gen;
+  int    usec_to_sleep;
+
+  while ((this->audio_loop_running) ||
+	 (!this->audio_loop_running && this->out_fifo->first)) {
+
+    /*
+     * get buffer to process for this loop iteration
+     */
+
+    if (!this->loop_buf) {
+      lprintf ("loop: get buf from fifo\n");
+      /* don't hold a free running clock while waiting for data */
+      if (!this->out_fifo->first)
+        _x_clock_free_run_idle (this->clock, this->clock_client);
+      this->loop_buf = fifo_peek (this->out_fifo);
+      lprintf ("got a buffer\n");
+    }
+
+    usec_to_sleep = ao_loop_step (this);
+    if (usec_to_sleep) {
+      xine_usec_sleep (usec_to_sleep);
+      lprintf ("loop:pause: I wake up.\n");
+    }
+  }
+
+  ao_loop_done (this);
 
   return NULL;
 }
 
+/* buffers an output task plays before giving other streams a turn */
+#define AO_TASK_BUFFERS 8
+
+/* the output loop as a task on xine->executor, woken by fifo_append() */
+static void ao_task_run (xine_task_t *task) {
+
+  aos_t *this = (aos_t *) ((char *) task - offsetof (aos_t, task));
+  int    usec_to_sleep, n;
+
+  for (n = 0; n < AO_TASK_BUFFERS; n++) {
+
+    if (!this->audio_loop_running && !this->out_fifo->first) {
+      ao_loop_done (this);
+      return;
+    }
+
+    if (!this->loop_buf) {
+      pthread_mutex_lock (&this->out_fifo->mutex);
+      this->loop_buf = this->out_fifo->first;
+      if (!this->loop_buf)
+        pthread_cond_signal (&this->out_fifo->empty);
+      pthread_mutex_unlock (&this->out_fifo->mutex);
+
+      if (!this->loop_buf) {
+        /* don't hold a free running clock while waiting for data */
+        _x_clock_free_run_idle (this->clock, this->clock_client);
+        return;
+      }
+    }
+
+    usec_to_sleep = ao_loop_step (this);
+    if (usec_to_sleep) {
+      _x_task_wake_after (task, usec_to_sleep);
+      return;
+    }
+  }
+
+  _x_task_wake (task);
+}
+
 /*
  * public a/v processing interface
  */
@@ -1337,17 +1377,29 @@ int xine_get_next_audio_frame (xine_audio_port_t *this_gen,
     }
     stream = xine_list_get_value(this->streams, ite);
 
-    /* FIXME: ugly, use conditions and locks instead? */
-
     pthread_mutex_lock (&this->out_fifo->mutex);
     in_buf = this->out_fifo->first;
     if (!in_buf) {
-      pthread_mutex_unlock(&this->out_fifo->mutex);
+      struct timeval  tv;
+      struct timespec ts;
+
       if (stream != XINE_ANON_STREAM && stream->audio_fifo->fifo_size == 0 &&
-	  stream->demux_plugin->get_status(stream->demux_plugin) !=DEMUX_OK)
+	  stream->demux_plugin->get_status(stream->demux_plugin) !=DEMUX_OK) {
         /* no further data can be expected here */
+        pthread_mutex_unlock(&this->out_fifo->mutex);
         return 0;
-      xine_usec_sleep (5000);
+      }
+
+      /* wake up with the next buffer, look at the demuxer again after 5ms */
+      gettimeofday(&tv, NULL);
+      ts.tv_sec  = tv.tv_sec;
+      ts.tv_nsec = (tv.tv_usec + 5000) * 1000;
+      if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+      }
+      pthread_cond_timedwait (&this->out_fifo->not_empty, &this->out_fifo->mutex, &ts);
+      pthread_mutex_unlock(&this->out_fifo->mutex);
       continue;
     }
   }
@@ -1355,6 +1407,9 @@ int xine_get_next_audio_frame (xine_audio_port_t *this_gen,
   in_buf = fifo_remove_int (this->out_fifo, 1);
   pthread_mutex_unlock(&this->out_fifo->mutex);
 
+  if (in_buf->stream)
+    _x_latency_record (in_buf->stream, XINE_LATENCY_AUDIO, in_buf->extra_info);
+
   out_buf = prepare_samples (this, in_buf);
 
   if (out_buf != in_buf) {
@@ -1469,6 +1524,8 @@ static int ao_change_settings(aos_t *this, uint32_t bits, uint32_t rate, int mod
     return 0;
   } else {
     this->driver_open = 1;
+    /* tell the driver about free-run again */
+    this->free_run = -1;
   }
 
   xprintf (this->xine, XINE_VERBOSITY_DEBUG, "output sample rate %d\n", output_sample_rate);
@@ -1561,9 +1618,15 @@ static audio_buffer_t *ao_get_buffer (xine_audio_port_t *this_gen) {
   aos_t *this = (aos_t *) this_gen;
   audio_buffer_t *buf;
 
-  while (!(buf = fifo_remove_nonblock (this->free_fifo)))
-    if (this->xine->port_ticket->ticket_revoked)
-      this->xine->port_ticket->renew(this->xine->port_ticket, 1);
+  buf = fifo_try_remove (this->free_fifo);
+  if (!buf) {
+    _x_executor_block_enter ();
+    do {
+      if (this->xine->port_ticket->ticket_revoked)
+        this->xine->port_ticket->renew(this->xine->port_ticket, 1);
+    } while (!(buf = fifo_remove_nonblock (this->free_fifo)));
+    _x_executor_block_leave ();
+  }
 
   _x_extra_info_reset( buf->extra_info );
   buf->stream = NULL;
@@ -1594,6 +1657,7 @@ static void ao_put_buffer (xine_audio_port_t *this_gen,
     buf->format.rate = _x_stream_info_get(stream, XINE_STREAM_INFO_AUDIO_SAMPLERATE);
     buf->format.mode = _x_stream_info_get(stream, XINE_STREAM_INFO_AUDIO_MODE);
     _x_extra_info_merge( buf->extra_info, stream->audio_decoder_extra_info );
+    _x_latency_stamp (buf->extra_info, XINE_LATENCY_DECODED);
     buf->vpts = stream->metronom->got_audio_samples(stream->metronom, pts, buf->num_frames);
   }
 
@@ -1677,10 +1741,17 @@ static void ao_exit(xine_audio_port_t *this_gen) {
     buf->stream = NULL;
     fifo_append (this->out_fifo, buf);
 
-    pthread_join (this->audio_thread, &p);
+    if (this->task.executor) {
+      _x_task_wait (&this->task);
+      this->out_fifo->task = NULL;
+    } else {
+      pthread_join (this->audio_thread, &p);
+    }
     this->audio_thread_created = 0;
   }
 
+  _x_clock_client_free (this->clock, this->clock_client);
+
   if (!this->grab_only) {
     pthread_mutex_lock( &this->driver_lock );
 
@@ -1796,6 +1867,15 @@ static int ao_get_property (xine_audio_port_t *this_gen, int property) {
     ret = this->audio_loop_running ? this->free_fifo->num_buffers_max : -1;
     break;
 
+  case AO_PROP_CLOCK_DRIFT:
+    /* written by the audio thread, a torn read is just as good */
+    ret = this->sync.drift * 1000000.0;
+    break;
+
+  case AO_PROP_CLOCK_JITTER:
+    ret = this->sync.jitter;
+    break;
+
   case AO_PROP_NUM_STREAMS:
     pthread_mutex_lock(&this->streams_lock);
     ret = xine_list_size(this->streams);
@@ -2016,6 +2096,7 @@ static void ao_flush (xine_audio_port_t *this_gen) {
     this->flush_audio_driver++;
 
     /* do not try this in paused mode */
+    _x_executor_block_enter ();
     while( this->flush_audio_driver && this->clock->speed != XINE_SPEED_PAUSE) {
       struct timeval  tv;
       struct timespec ts;
@@ -2040,6 +2121,7 @@ static void ao_flush (xine_audio_port_t *this_gen) {
         pthread_cond_timedwait(&this->flush_audio_driver_reached, &this->flush_audio_driver_lock, &ts);
       }
     }
+    _x_executor_block_leave ();
     this->discard_buffers--;
 
     pthread_mutex_unlock(&this->flush_audio_driver_lock);
@@ -2089,7 +2171,7 @@ static void ao_update_av_sync_method(void *this_gen, xine_cfg_entry_t *entry) {
     this->resample_sync_method = 0;
     break;
   }
-  this->resample_sync_info.valid = 0;
+  this->sync_reset = 1;
 }
 
 xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
@@ -2108,6 +2190,7 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
   this->driver                = driver;
   this->xine                  = xine;
   this->clock                 = xine->clock;
+  this->clock_client          = grab_only ? -1 : _x_clock_client_new (xine->clock);
   this->current_speed         = xine->clock->speed;
   this->streams               = xine_list_new();
 
@@ -2148,6 +2231,9 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
   if (!grab_only)
     this->gap_tolerance          = driver->get_gap_tolerance (this->driver);
 
+  _x_clock_recovery_init (&this->sync, SYNC_TAU, SYNC_PULL, SYNC_MAX_RATE);
+  this->resample_sync_factor     = 1.0;
+
   this->av_sync_method_conf = config->register_enum(config, "audio.synchronization.av_sync_method", 0,
                                                     av_sync_methods,
                                                     _("method to sync audio and video"),
@@ -2306,25 +2392,32 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
 
     this->audio_loop_running = 1;
 
-    pthread_attr_init(&pth_attrs);
+    /* run as a task on the shared engine threads */
+    if (xine->executor) {
+      _x_task_init (&this->task, xine->executor, ao_task_run);
+      this->out_fifo->task = &this->task;
+      this->audio_thread_created = 1;
+    } else {
+      pthread_attr_init(&pth_attrs);
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
-    pthread_attr_setscope(&pth_attrs, PTHREAD_SCOPE_SYSTEM);
+      pthread_attr_setscope(&pth_attrs, PTHREAD_SCOPE_SYSTEM);
 #endif
 
-    this->audio_thread_created = 1;
-    if ((err = pthread_create (&this->audio_thread,
-			       &pth_attrs, ao_loop, this)) != 0) {
+      this->audio_thread_created = 1;
+      if ((err = pthread_create (&this->audio_thread,
+			         &pth_attrs, ao_loop, this)) != 0) {
 
-      xprintf (this->xine, XINE_VERBOSITY_NONE,
-	       "audio_out: can't create thread (%s)\n", strerror(err));
-      xprintf (this->xine, XINE_VERBOSITY_LOG,
-	       _("audio_out: sorry, this should not happen. please restart xine.\n"));
-      _x_abort();
+        xprintf (this->xine, XINE_VERBOSITY_NONE,
+	         "audio_out: can't create thread (%s)\n", strerror(err));
+        xprintf (this->xine, XINE_VERBOSITY_LOG,
+	         _("audio_out: sorry, this should not happen. please restart xine.\n"));
+        _x_abort();
 
-    } else
-      xprintf (this->xine, XINE_VERBOSITY_DEBUG, "audio_out: thread created\n");
+      } else
+        xprintf (this->xine, XINE_VERBOSITY_DEBUG, "audio_out: thread created\n");
 
-    pthread_attr_destroy(&pth_attrs);
+      pthread_attr_destroy(&pth_attrs);
+    }
   }
 
   return &this->ao;
@@ -52,6 +52,21 @@
 #include <xine/buffer.h>
 #include <xine/xineutils.h>
 #include <xine/xine_internal.h>
+#include "xine_private.h"
+
+/* engine side of a fifo, see _x_fifo_buffer_set_task() */
+typedef struct {
+  fifo_buffer_t   fifo;
+
+  xine_task_t    *task;     /* woken on put and insert */
+  xine_task_t    *producer; /* woken when producer_free buffers are free */
+  int             producer_free;
+} fifo_buffer_private_t;
+
+static xine_tracepoint_t tp_put        = XINE_TRACEPOINT ("fifo.put");
+static xine_tracepoint_t tp_put_bytes  = XINE_TRACEPOINT ("fifo.put.bytes");
+static xine_tracepoint_t tp_get_wait   = XINE_TRACEPOINT ("fifo.get.wait");
+static xine_tracepoint_t tp_alloc_wait = XINE_TRACEPOINT ("fifo.alloc.wait");
 
 /*
  * put a previously allocated buffer element back into the buffer pool
@@ -59,6 +74,7 @@
 static void buffer_pool_free (buf_element_t *element) {
 
   fifo_buffer_t *this = (fifo_buffer_t *) element->source;
+  fifo_buffer_private_t *priv = (fifo_buffer_private_t *) this;
 
   pthread_mutex_lock (&this->buffer_pool_mutex);
 
@@ -72,6 +88,10 @@ static void buffer_pool_free (buf_element_t *element) {
   }
 
   pthread_cond_signal (&this->buffer_pool_cond_not_empty);
+  if (priv->producer && this->buffer_pool_num_free >= priv->producer_free) {
+    _x_task_wake (priv->producer);
+    priv->producer = NULL;
+  }
 
   pthread_mutex_unlock (&this->buffer_pool_mutex);
 }
@@ -92,8 +112,14 @@ static buf_element_t *buffer_pool_alloc (fifo_buffer_t *this) {
 
   /* we always keep one free buffer for emergency situations like
    * decoder flushes that would need a buffer in buffer_pool_try_alloc() */
-  while (this->buffer_pool_num_free < 2) {
-    pthread_cond_wait (&this->buffer_pool_cond_not_empty, &this->buffer_pool_mutex);
+  if (this->buffer_pool_num_free < 2) {
+    uint64_t t = xine_tp_start ();
+    _x_executor_block_enter ();
+    while (this->buffer_pool_num_free < 2) {
+      pthread_cond_wait (&this->buffer_pool_cond_not_empty, &this->buffer_pool_mutex);
+    }
+    _x_executor_block_leave ();
+    xine_tp_stop (tp_alloc_wait, t);
   }
 
   buf = this->buffer_pool_top;
@@ -110,6 +136,7 @@ static buf_element_t *buffer_pool_alloc (fifo_buffer_t *this) {
   memset(buf->decoder_info, 0, sizeof(buf->decoder_info));
   memset(buf->decoder_info_ptr, 0, sizeof(buf->decoder_info_ptr));
   _x_extra_info_reset( buf->extra_info );
+  _x_latency_stamp (buf->extra_info, XINE_LATENCY_READ);
 
   return buf;
 }
@@ -147,6 +174,7 @@ static buf_element_t *buffer_pool_try_alloc (fifo_buffer_t *this) {
     memset(buf->decoder_info, 0, sizeof(buf->decoder_info));
     memset(buf->decoder_info_ptr, 0, sizeof(buf->decoder_info_ptr));
     _x_extra_info_reset( buf->extra_info );
+    _x_latency_stamp (buf->extra_info, XINE_LATENCY_READ);
   }
   return buf;
 }
@@ -156,8 +184,11 @@ static buf_element_t *buffer_pool_try_alloc (fifo_buffer_t *this) {
  * append buffer element to fifo buffer
  */
 static void fifo_buffer_put (fifo_buffer_t *fifo, buf_element_t *element) {
+  fifo_buffer_private_t *priv = (fifo_buffer_private_t *) fifo;
   int i;
 
+  _x_latency_stamp (element->extra_info, XINE_LATENCY_PUT);
+
   pthread_mutex_lock (&fifo->mutex);
 
   for(i = 0; fifo->put_cb[i]; i++)
@@ -174,8 +205,13 @@ static void fifo_buffer_put (fifo_buffer_t *fifo, buf_element_t *element) {
   fifo->fifo_data_size += element->size;
 
   pthread_cond_signal (&fifo->not_empty);
+  if (priv->task)
+    _x_task_wake (priv->task);
 
   pthread_mutex_unlock (&fifo->mutex);
+
+  xine_tp_hit (tp_put, 1);
+  xine_tp_hit (tp_put_bytes, element->size);
 }
 
 /*
@@ -198,6 +234,7 @@ static void dummy_fifo_buffer_put (fifo_buffer_t *fifo, buf_element_t *element)
  * insert buffer element to fifo buffer (demuxers MUST NOT call this one)
  */
 static void fifo_buffer_insert (fifo_buffer_t *fifo, buf_element_t *element) {
+  fifo_buffer_private_t *priv = (fifo_buffer_private_t *) fifo;
 
   pthread_mutex_lock (&fifo->mutex);
 
@@ -211,6 +248,8 @@ static void fifo_buffer_insert (fifo_buffer_t *fifo, buf_element_t *element) {
   fifo->fifo_data_size += element->size;
 
   pthread_cond_signal (&fifo->not_empty);
+  if (priv->task)
+    _x_task_wake (priv->task);
 
   pthread_mutex_unlock (&fifo->mutex);
 }
@@ -224,18 +263,12 @@ static void dummy_fifo_buffer_insert (fifo_buffer_t *fifo, buf_element_t *elemen
 }
 
 /*
- * get element from fifo buffer
+ * take the first element, called with fifo->mutex held
  */
-static buf_element_t *fifo_buffer_get (fifo_buffer_t *fifo) {
+static buf_element_t *fifo_buffer_remove_first (fifo_buffer_t *fifo) {
   int i;
   buf_element_t *buf;
 
-  pthread_mutex_lock (&fifo->mutex);
-
-  while (fifo->first==NULL) {
-    pthread_cond_wait (&fifo->not_empty, &fifo->mutex);
-  }
-
   buf = fifo->first;
 
   fifo->first = fifo->first->next;
@@ -248,11 +281,82 @@ static buf_element_t *fifo_buffer_get (fifo_buffer_t *fifo) {
   for(i = 0; fifo->get_cb[i]; i++)
     fifo->get_cb[i](fifo, buf, fifo->get_cb_data[i]);
 
+  _x_latency_stamp (buf->extra_info, XINE_LATENCY_GET);
+
+  return buf;
+}
+
+/*
+ * get element from fifo buffer
+ */
+static buf_element_t *fifo_buffer_get (fifo_buffer_t *fifo) {
+  buf_element_t *buf;
+
+  pthread_mutex_lock (&fifo->mutex);
+
+  if (fifo->first==NULL) {
+    uint64_t t = xine_tp_start ();
+    while (fifo->first==NULL) {
+      pthread_cond_wait (&fifo->not_empty, &fifo->mutex);
+    }
+    xine_tp_stop (tp_get_wait, t);
+  }
+
+  buf = fifo_buffer_remove_first (fifo);
+
+  pthread_mutex_unlock (&fifo->mutex);
+
+  return buf;
+}
+
+buf_element_t *_x_fifo_buffer_try_get (fifo_buffer_t *fifo) {
+  buf_element_t *buf = NULL;
+
+  pthread_mutex_lock (&fifo->mutex);
+
+  if (fifo->first)
+    buf = fifo_buffer_remove_first (fifo);
+
   pthread_mutex_unlock (&fifo->mutex);
 
   return buf;
 }
 
+void _x_fifo_buffer_set_task (fifo_buffer_t *fifo, xine_task_t *task) {
+  fifo_buffer_private_t *priv = (fifo_buffer_private_t *) fifo;
+
+  pthread_mutex_lock (&fifo->mutex);
+  priv->task = task;
+  pthread_mutex_unlock (&fifo->mutex);
+}
+
+int _x_fifo_buffer_wait_free (fifo_buffer_t *fifo, int num, xine_task_t *task) {
+  fifo_buffer_private_t *priv = (fifo_buffer_private_t *) fifo;
+  int i, ready = 1;
+
+  pthread_mutex_lock (&fifo->buffer_pool_mutex);
+
+  priv->producer = NULL;
+  if (task && fifo->buffer_pool_num_free < 2) {
+    /* as buffer_pool_alloc () does before it waits, net_buf_ctrl
+     * relies on seeing the pool run dry */
+    for (i = 0; fifo->alloc_cb[i]; i++)
+      fifo->alloc_cb[i] (fifo, fifo->alloc_cb_data[i]);
+
+    if (fifo->buffer_pool_num_free < 2) {
+      priv->producer      = task;
+      priv->producer_free = num < fifo->buffer_pool_capacity ? num : fifo->buffer_pool_capacity;
+      if (priv->producer_free < 2)
+        priv->producer_free = 2;
+      ready = 0;
+    }
+  }
+
+  pthread_mutex_unlock (&fifo->buffer_pool_mutex);
+
+  return ready;
+}
+
 /*
  * clear buffer (put all contained buffer elements back into buffer pool)
  */
@@ -505,7 +609,7 @@ fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
   int            i;
   unsigned char *multi_buffer = NULL;
 
-  this = calloc(1, sizeof(fifo_buffer_t));
+  this = calloc(1, sizeof(fifo_buffer_private_t));
 
   this->first               = NULL;
   this->last                = NULL;
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * clock recovery - follow a clock that drifts against the master clock
+ *
+ * The offset between two clocks is measured now and then (e.g. the gap
+ * between the audio buffer and the sound card). An alpha-beta filter, the
+ * steady state form of a Kalman filter for offset and rate, estimates the
+ * offset and the rate error (drift) from these noisy measurements. It
+ * starts with growing memory (least squares fit) and fades to a memory of
+ * about tau.
+ *
+ * The correction rate follows the estimated drift, plus whatever it takes
+ * to pull the offset back to zero within "pull". It changes by at most
+ * max_slew per pts and never exceeds max_rate, so applying it is neither
+ * audible nor visible. Measurements far off the prediction are ignored,
+ * unless they keep coming: then the clock jumped, and the offset is taken
+ * over as it is.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <limits.h>
+
+#define LOG_MODULE "clock_recovery"
+
+#include <xine/xineutils.h>
+#include "xine_private.h"
+
+/* measurements that far from the prediction (plus 4 times the jitter)
+ * are outliers */
+#define CR_OUTLIER          4500.0
+/* that many in a row mean that the clock jumped */
+#define CR_OUTLIERS_MAX          3
+/* trust the drift estimate after that many measurements */
+#define CR_SETTLE               16
+
+void _x_clock_recovery_init (xine_clock_recovery_t *cr, int64_t tau, int64_t pull, double max_rate) {
+  cr->tau      = tau;
+  cr->pull     = pull;
+  cr->deadband = 0;
+  cr->max_rate = max_rate;
+  /* from zero to max_rate within a quarter of pull */
+  cr->max_slew = 4.0 * max_rate / pull;
+
+  _x_clock_recovery_reset (cr, 0);
+}
+
+void _x_clock_recovery_reset (xine_clock_recovery_t *cr, int keep_drift) {
+  if (keep_drift && cr->samples) {
+    /* the clocks stay the same, just the offset is unknown */
+    cr->acquire = 1;
+    return;
+  }
+  cr->offset   = 0;
+  cr->drift    = 0;
+  cr->jitter   = 0;
+  cr->rate     = 0;
+  cr->span     = 0;
+  cr->samples  = 0;
+  cr->outliers = 0;
+  cr->acquire  = 1;
+}
+
+static void cr_control (xine_clock_recovery_t *cr, double dt) {
+  double target, step;
+
+  /* a young drift estimate is mostly noise */
+  target = (cr->samples >= CR_SETTLE && cr->span >= cr->tau) ? cr->drift : 0;
+
+  if (cr->offset > cr->deadband)
+    target += (cr->offset - cr->deadband) / cr->pull;
+  else if (cr->offset < -cr->deadband)
+    target += (cr->offset + cr->deadband) / cr->pull;
+
+  if (target > cr->max_rate)
+    target = cr->max_rate;
+  else if (target < -cr->max_rate)
+    target = -cr->max_rate;
+
+  step = cr->max_slew * dt;
+  if (target > cr->rate + step)
+    target = cr->rate + step;
+  else if (target < cr->rate - step)
+    target = cr->rate - step;
+
+  cr->rate = target;
+}
+
+double _x_clock_recovery_update (xine_clock_recovery_t *cr, int64_t time, int64_t error) {
+  double dt, predicted, residual, alpha, beta, a, k;
+
+  dt = time - cr->last_time;
+
+  /* first measurement, after a jump, or after a long break */
+  if (cr->acquire || dt > cr->tau) {
+    cr->offset    = error;
+    cr->last_time = time;
+    cr->outliers  = 0;
+    cr->acquire   = 0;
+    if (!cr->samples)
+      cr->samples = 1;
+    return cr->rate;
+  }
+  /* clock stands still */
+  if (dt <= 0)
+    return cr->rate;
+
+  predicted = cr->offset + (cr->drift - cr->rate) * dt;
+  residual  = error - predicted;
+
+  if (cr->samples >= CR_SETTLE && fabs (residual) > 4.0 * cr->jitter + CR_OUTLIER) {
+    if (++cr->outliers >= CR_OUTLIERS_MAX) {
+      cr->acquire = 1;
+      return _x_clock_recovery_update (cr, time, error);
+    }
+    cr->offset    = predicted;
+    cr->last_time = time;
+    return cr->rate;
+  }
+  cr->outliers = 0;
+
+  /* growing memory gains for the k-th measurement ... */
+  k     = cr->samples + 1;
+  alpha = 2.0 * (2.0 * k - 1.0) / (k * (k + 1.0));
+  beta  = 6.0 / (k * (k + 1.0));
+  /* ... until the fading memory ones are larger */
+  a = 1.0 - exp (-dt / cr->tau);
+  if (alpha < a) {
+    alpha = a;
+    beta  = a * a / (2.0 - a);
+  }
+
+  cr->offset = predicted + alpha * residual;
+  cr->drift += beta * residual / dt;
+  if (cr->drift > 2.0 * cr->max_rate)
+    cr->drift = 2.0 * cr->max_rate;
+  else if (cr->drift < -2.0 * cr->max_rate)
+    cr->drift = -2.0 * cr->max_rate;
+
+  if (cr->samples == 1)
+    cr->jitter = fabs (residual);
+  else
+    cr->jitter += (fabs (residual) - cr->jitter) / 16.0;
+
+  if (cr->samples < INT_MAX)
+    cr->samples++;
+  if (cr->span < cr->tau)
+    cr->span += dt;
+  cr->last_time = time;
+
+  cr_control (cr, dt);
+
+  return cr->rate;
+}
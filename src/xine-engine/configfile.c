@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <xine/configfile.h>
 #include "bswap.h"
 #ifdef HAVE_FFMPEG_AVUTIL_H
@@ -49,6 +50,31 @@
 #include <xine/xineutils.h>
 #include <xine/xine_internal.h>
 
+/*
+ * entries are kept in a sorted list for saving and enumeration, and
+ * indexed by key for lookups. the index is a hash table with linear
+ * probing. it also holds old key names that were found through
+ * translation, pointing to the entry of the new name. entries are
+ * never removed from the index, only all of them at dispose.
+ */
+typedef struct {
+  const char      *key;    /* entry->key, or a strdup()ed old name */
+  cfg_entry_t     *entry;  /* NULL: free slot */
+  uint32_t         hash;
+  int              alias;
+} config_slot_t;
+
+typedef struct {
+  config_values_t  v;
+
+  config_slot_t   *index;
+  uint32_t         index_mask;   /* size - 1, size is a power of 2 */
+  uint32_t         index_used;
+  int              index_partial; /* some entries did not fit, search the list too */
+} config_private_t;
+
+#define CONFIG_INDEX_SIZE 512
+
 static const xine_config_entry_translation_t *config_entry_translation_user = NULL;
 static const xine_config_entry_translation_t config_entry_translation[] = {
   { "audio.a52_pass_through",			"" },
@@ -211,7 +237,77 @@ static const xine_config_entry_translation_t config_entry_translation[] = {
 };
 
 
-static int config_section_enum(const char *sect) {
+static uint32_t config_key_hash (const char *key) {
+  uint32_t hash = 5381;
+
+  while (*key)
+    hash = hash * 33 + (uint8_t)*key++;
+  return hash;
+}
+
+static cfg_entry_t *config_index_find (config_private_t *this, const char *key, uint32_t hash) {
+  config_slot_t *slot;
+  cfg_entry_t   *entry;
+  uint32_t       i;
+
+  for (i = hash & this->index_mask; (slot = &this->index[i])->entry; i = (i + 1) & this->index_mask)
+    if (slot->hash == hash && !strcmp (slot->key, key))
+      return slot->entry;
+
+  /* the index could not grow, newer entries are only in the list */
+  if (this->index_partial) {
+    for (entry = this->v.first; entry; entry = entry->next)
+      if (!strcmp (entry->key, key))
+        return entry;
+  }
+  return NULL;
+}
+
+static void config_index_put (config_private_t *this, const char *key, uint32_t hash,
+                              cfg_entry_t *entry, int alias) {
+  config_slot_t *slot;
+  uint32_t       i;
+
+  for (i = hash & this->index_mask; (slot = &this->index[i])->entry; i = (i + 1) & this->index_mask)
+    ;
+  slot->key   = key;
+  slot->entry = entry;
+  slot->hash  = hash;
+  slot->alias = alias;
+  this->index_used++;
+}
+
+/* returns 0 if the key was not indexed */
+static int config_index_add (config_private_t *this, const char *key, uint32_t hash,
+                             cfg_entry_t *entry, int alias) {
+
+  /* keep at least half of the slots free */
+  if ((this->index_used + 1) * 2 > this->index_mask + 1) {
+    config_slot_t *old = this->index;
+    uint32_t       old_size = this->index_mask + 1, i;
+    config_slot_t *index = calloc (old_size * 2, sizeof (config_slot_t));
+
+    if (index) {
+      this->index      = index;
+      this->index_mask = old_size * 2 - 1;
+      this->index_used = 0;
+      for (i = 0; i < old_size; i++)
+        if (old[i].entry)
+          config_index_put (this, old[i].key, old[i].hash, old[i].entry, old[i].alias);
+      free (old);
+    } else if (this->index_used + 2 > old_size) {
+      /* keep the old table, it needs one free slot to end searches */
+      if (!alias)
+        this->index_partial = 1;
+      return 0;
+    }
+  }
+
+  config_index_put (this, key, hash, entry, alias);
+  return 1;
+}
+
+static int config_section_enum(const char *sect, int len) {
   static const char *const known_section[] = {
     "gui",
     "ui",
@@ -229,70 +325,80 @@ static int config_section_enum(const char *sect) {
     "misc",
     NULL
   };
-  int i = 0;
+  int i;
 
-  while (known_section[i])
-    if (strcmp(sect, known_section[i++]) == 0)
-      return i;
+  for (i = 0; known_section[i]; i++)
+    if (!strncmp(sect, known_section[i], len) && !known_section[i][len])
+      return i + 1;
   return i + 1;
 }
 
-static void config_key_split(const char *key, char **base, char **section, char **subsect, char **name) {
-  char *parse;
+/* parts of a key "section.subsection.name", pointing into the key */
+typedef struct {
+  const char *section, *subsect, *name;  /* NULL if missing */
+  int         section_len, subsect_len;
+  int         section_num;
+} config_key_parts_t;
+
+static void config_key_split(const char *key, config_key_parts_t *parts) {
+  const char *parse;
 
-  *base = strdup(key);
-  if ((parse = strchr(*base, '.'))) {
-    *section = *base;
-    *parse   = '\0';
+  if ((parse = strchr(key, '.'))) {
+    parts->section     = key;
+    parts->section_len = parse - key;
+    parts->section_num = config_section_enum(key, parts->section_len);
     parse++;
-    if ((*name = strchr(parse, '.'))) {
-      *subsect = parse;
-      **name   = '\0';
-      (*name)++;
+    if ((parts->name = strchr(parse, '.'))) {
+      parts->subsect     = parse;
+      parts->subsect_len = parts->name - parse;
+      parts->name++;
     } else {
-      *subsect = NULL;
-      *name    = parse;
+      parts->subsect = NULL;
+      parts->name    = parse;
     }
   } else {
-    *section = NULL;
-    *subsect = NULL;
-    *name    = parse;
+    parts->section = NULL;
+    parts->subsect = NULL;
+    parts->name    = NULL;
   }
 }
 
+/* like strcmp() on the parts alone */
+static int config_part_cmp(const char *a, int a_len, const char *b, int b_len) {
+  int cmp = memcmp(a, b, a_len < b_len ? a_len : b_len);
+
+  return cmp ? cmp : a_len - b_len;
+}
+
 static void config_insert(config_values_t *this, cfg_entry_t *new_entry) {
   cfg_entry_t *cur, *prev;
-  char *new_base, *new_section, *new_subsect, *new_name;
-  char *cur_base, *cur_section, *cur_subsect, *cur_name;
+  config_key_parts_t new_key, cur_key;
 
   /* extract parts of the new key */
-  config_key_split(new_entry->key, &new_base, &new_section, &new_subsect, &new_name);
+  config_key_split(new_entry->key, &new_key);
 
   /* search right position */
-  cur_base = NULL;
   for (cur = this->first, prev = NULL; cur; prev = cur, cur = cur->next) {
     /* extract parts of the cur key */
-    if (cur_base)
-      free(cur_base);
-    config_key_split(cur->key, &cur_base, &cur_section, &cur_subsect, &cur_name);
+    config_key_split(cur->key, &cur_key);
 
     /* sort by section name */
-    if (!new_section &&  cur_section) break;
-    if ( new_section && !cur_section) continue;
-    if ( new_section &&  cur_section) {
-      int new_sec_num = config_section_enum(new_section);
-      int cur_sec_num = config_section_enum(cur_section);
-      int cmp         = strcmp(new_section, cur_section);
-      if (new_sec_num < cur_sec_num) break;
-      if (new_sec_num > cur_sec_num) continue;
+    if (!new_key.section &&  cur_key.section) break;
+    if ( new_key.section && !cur_key.section) continue;
+    if ( new_key.section &&  cur_key.section) {
+      int cmp = config_part_cmp(new_key.section, new_key.section_len,
+                                cur_key.section, cur_key.section_len);
+      if (new_key.section_num < cur_key.section_num) break;
+      if (new_key.section_num > cur_key.section_num) continue;
       if (cmp < 0) break;
       if (cmp > 0) continue;
     }
     /* sort by subsection name */
-    if (!new_subsect &&  cur_subsect) break;
-    if ( new_subsect && !cur_subsect) continue;
-    if ( new_subsect &&  cur_subsect) {
-      int cmp = strcmp(new_subsect, cur_subsect);
+    if (!new_key.subsect &&  cur_key.subsect) break;
+    if ( new_key.subsect && !cur_key.subsect) continue;
+    if ( new_key.subsect &&  cur_key.subsect) {
+      int cmp = config_part_cmp(new_key.subsect, new_key.subsect_len,
+                                cur_key.subsect, cur_key.subsect_len);
       if (cmp < 0) break;
       if (cmp > 0) continue;
     }
@@ -300,20 +406,16 @@ static void config_insert(config_values_t *this, cfg_entry_t *new_entry) {
     if (new_entry->exp_level < cur->exp_level) break;
     if (new_entry->exp_level > cur->exp_level) continue;
     /* sort by entry name */
-    if (!new_name &&  cur_name) break;
-    if ( new_name && !cur_name) continue;
-    if ( new_name &&  cur_name) {
-      int cmp = strcmp(new_name, cur_name);
+    if (!new_key.name &&  cur_key.name) break;
+    if ( new_key.name && !cur_key.name) continue;
+    if ( new_key.name &&  cur_key.name) {
+      int cmp = strcmp(new_key.name, cur_key.name);
       if (cmp < 0) break;
       if (cmp > 0) continue;
     }
 
     break;
   }
-  if (new_base)
-    free(new_base);
-  if (cur_base)
-    free(cur_base);
 
   new_entry->next = cur;
   if (!cur)
@@ -337,13 +439,19 @@ static cfg_entry_t *XINE_MALLOC config_add (config_values_t *this, const char *k
   entry->exp_level     = exp_level;
 
   config_insert(this, entry);
+  config_index_add ((config_private_t *) this, entry->key, config_key_hash (entry->key), entry, 0);
 
   lprintf ("add entry key=%s\n", key);
 
   return entry;
 }
 
-static void config_remove(config_values_t *this, cfg_entry_t *entry, cfg_entry_t *prev) {
+static void config_remove(config_values_t *this, cfg_entry_t *entry) {
+  cfg_entry_t *prev = NULL, *cur;
+
+  for (cur = this->first; cur != entry; cur = cur->next)
+    prev = cur;
+
   if (!entry->next)
     this->last = prev;
   if (!prev)
@@ -361,6 +469,39 @@ static const char *config_xlate_internal (const char *key, const xine_config_ent
   return NULL;
 }
 
+/* the builtin translation table, indexed by old name. slots hold table
+ * position + 1, 0 is free. */
+#define CONFIG_XLATE_INDEX_SIZE 512
+static uint16_t       config_xlate_index[CONFIG_XLATE_INDEX_SIZE];
+static pthread_once_t config_xlate_once = PTHREAD_ONCE_INIT;
+
+static void config_xlate_index_init (void) {
+  const xine_config_entry_translation_t *trans;
+  uint32_t i;
+
+  for (trans = config_entry_translation; trans->old_name; trans++) {
+    if (!trans->new_name[0])
+      continue;
+    for (i = config_key_hash (trans->old_name); config_xlate_index[i & (CONFIG_XLATE_INDEX_SIZE - 1)]; i++)
+      ;
+    config_xlate_index[i & (CONFIG_XLATE_INDEX_SIZE - 1)] = trans - config_entry_translation + 1;
+  }
+}
+
+static const char *config_xlate_builtin (const char *key) {
+  const xine_config_entry_translation_t *trans;
+  uint32_t i;
+
+  pthread_once (&config_xlate_once, config_xlate_index_init);
+
+  for (i = config_key_hash (key); config_xlate_index[i & (CONFIG_XLATE_INDEX_SIZE - 1)]; i++) {
+    trans = &config_entry_translation[config_xlate_index[i & (CONFIG_XLATE_INDEX_SIZE - 1)] - 1];
+    if (!strcmp (key, trans->old_name))
+      return trans->new_name;
+  }
+  return NULL;
+}
+
 static const char *config_translate_key (const char *key, char **tmp) {
   /* Returns translated key or, if no translation found, NULL.
    * Translated key may be in a static buffer allocated within this function.
@@ -380,42 +521,41 @@ static const char *config_translate_key (const char *key, char **tmp) {
   }
 
   /* search the translation table... */
-  newkey = config_xlate_internal (key, config_entry_translation);
+  newkey = config_xlate_builtin (key);
   if (!newkey && config_entry_translation_user)
     newkey = config_xlate_internal (key, config_entry_translation_user);
 
   return newkey;
 }
 
-static void config_lookup_entry_int (config_values_t *this, const char *key,
-				       cfg_entry_t **entry, cfg_entry_t **prev) {
-
-  int trans;
-  char *tmp = NULL;
-
-  /* try twice at most (second time with translation from old key name) */
-  for (trans = 2; trans; --trans) {
-    *entry = this->first;
-    *prev  = NULL;
+static cfg_entry_t *config_lookup_entry_int (config_values_t *this, const char *key) {
 
-    while (*entry && strcmp((*entry)->key, key)) {
-      *prev  = *entry;
-      *entry = (*entry)->next;
-    }
+  config_private_t *priv = (config_private_t *) this;
+  cfg_entry_t      *entry;
+  const char       *newkey;
+  char             *tmp;
+  uint32_t          hash = config_key_hash (key);
 
-    if (*entry) {
-      free(tmp);
-      return;
-    }
+  entry = config_index_find (priv, key, hash);
+  if (entry)
+    return entry;
 
-    /* we did not find a match, maybe this is an old config entry name
-     * trying to translate */
-    key = config_translate_key(key, &tmp);
-    if (!key) {
-      free(tmp);
-      return;
+  /* we did not find a match, maybe this is an old config entry name
+   * trying to translate */
+  newkey = config_translate_key(key, &tmp);
+  if (newkey) {
+    entry = config_index_find (priv, newkey, config_key_hash (newkey));
+    /* find it directly next time */
+    if (entry) {
+      char *alias = strdup (key);
+
+      if (alias && !config_index_add (priv, alias, hash, entry, 1))
+        free (alias);
     }
   }
+  free(tmp);
+
+  return entry;
 }
 
 
@@ -424,10 +564,10 @@ static void config_lookup_entry_int (config_values_t *this, const char *key,
  */
 
 static cfg_entry_t *config_lookup_entry(config_values_t *this, const char *key) {
-  cfg_entry_t *entry, *prev;
+  cfg_entry_t *entry;
 
   pthread_mutex_lock(&this->config_lock);
-  config_lookup_entry_int(this, key, &entry, &prev);
+  entry = config_lookup_entry_int(this, key);
   pthread_mutex_unlock(&this->config_lock);
 
   return entry;
@@ -472,20 +612,20 @@ static cfg_entry_t *config_register_key (config_values_t *this,
 					 int exp_level,
 					 xine_config_cb_t changed_cb,
 					 void *cb_data) {
-  cfg_entry_t *entry, *prev;
+  cfg_entry_t *entry;
 
   _x_assert(this);
   _x_assert(key);
 
   lprintf ("registering %s\n", key);
-  config_lookup_entry_int(this, key, &entry, &prev);
+  entry = config_lookup_entry_int(this, key);
 
   if (!entry) {
     /* new entry */
     entry = config_add (this, key, exp_level);
   } else {
     if (entry->exp_level != exp_level) {
-      config_remove(this, entry, prev);
+      config_remove(this, entry);
       entry->exp_level = exp_level;
       config_insert(this, entry);
     }
@@ -1182,7 +1322,9 @@ void xine_config_save (xine_t *xine, const char *filename) {
 
 static void config_dispose (config_values_t *this) {
 
+  config_private_t *priv = (config_private_t *) this;
   cfg_entry_t *entry, *last;
+  uint32_t i;
 
   pthread_mutex_lock(&this->config_lock);
   entry = this->first;
@@ -1202,6 +1344,11 @@ static void config_dispose (config_values_t *this) {
 
     free (last);
   }
+
+  for (i = 0; i <= priv->index_mask; i++)
+    if (priv->index[i].alias)
+      free ((char *) priv->index[i].key);
+  free (priv->index);
   pthread_mutex_unlock(&this->config_lock);
 
   pthread_mutex_destroy(&this->config_lock);
@@ -1259,10 +1406,10 @@ static int put_string(uint8_t *buffer, int pos, const char *value, int value_len
 
 static char* config_get_serialized_entry (config_values_t *this, const char *key) {
   char *output = NULL;
-  cfg_entry_t *entry, *prev;
+  cfg_entry_t *entry;
 
   pthread_mutex_lock(&this->config_lock);
-  config_lookup_entry_int(this, key, &entry, &prev);
+  entry = config_lookup_entry_int(this, key);
 
   if (entry) {
     /* now serialize this stuff
@@ -1554,13 +1701,17 @@ config_values_t *_x_config_init (void) {
   volatile /* is this a (old, 2.91.66) irix gcc bug?!? */
 #endif
   config_values_t *this;
+  config_private_t *priv;
   pthread_mutexattr_t attr;
 
-  if (!(this = calloc(1, sizeof(config_values_t)))) {
+  if (!(priv = calloc(1, sizeof(config_private_t))) ||
+      !(priv->index = calloc(CONFIG_INDEX_SIZE, sizeof(config_slot_t)))) {
 
     printf ("configfile: could not allocate config object\n");
     _x_abort();
   }
+  priv->index_mask = CONFIG_INDEX_SIZE - 1;
+  this = &priv->v;
 
   this->first = NULL;
   this->last  = NULL;
@@ -45,6 +45,7 @@
 #include <xine/xine_internal.h>
 #include <xine/demux.h>
 #include <xine/buffer.h>
+#include "xine_private.h"
 
 #ifdef WIN32
 #include <winsock.h>
@@ -254,6 +255,8 @@ void _x_demux_control_headers_done (xine_stream_t *stream) {
 
   _x_action_lower(stream);
   pthread_cond_signal(&stream->demux_resume);
+  if (stream->demux_task)
+    _x_task_wake (stream->demux_task);
 
   lprintf ("headers processed.\n");
 
@@ -423,6 +426,210 @@ static void *demux_loop (void *stream_gen) {
   return NULL;
 }
 
+/*
+ * demux loop as a task on xine->executor. the phases follow demux_loop (),
+ * its waits become timers, and a full fifo makes the task return until
+ * the decoders freed some buffers.
+ */
+
+/* chunks a demux task sends before giving other streams a turn */
+#define DEMUX_TASK_CHUNKS  8
+/* after a fifo ran full, resume when this part of its pool is free */
+#define DEMUX_TASK_REFILL  4
+
+enum {
+  DEMUX_TASK_IDLE = 0,
+  DEMUX_TASK_START,
+  DEMUX_TASK_RUN,       /* main demuxer loop */
+  DEMUX_TASK_DRAIN,     /* wait before sending end buffers */
+  DEMUX_TASK_DELAY,     /* delay sending finished event */
+  DEMUX_TASK_FINISH     /* wait for the decoders to see the end */
+};
+
+typedef struct {
+  xine_task_t    task;   /* must be first, see demux_task_run() */
+  xine_stream_t *stream;
+
+  int            phase;
+  int            status;
+  int            non_user;
+  int            finished_count_audio;
+  int            finished_count_video;
+  int64_t        finish_timeout;
+  unsigned int   max_iterations;
+} demux_task_t;
+
+static int64_t demux_task_now (void) {
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* nonzero while the decoders could take another chunk without waiting */
+static int demux_task_fifos_ready (demux_task_t *this) {
+  fifo_buffer_t *video_fifo = this->stream->video_fifo;
+  fifo_buffer_t *audio_fifo = this->stream->audio_fifo;
+
+  return
+    _x_fifo_buffer_wait_free (video_fifo, video_fifo->buffer_pool_capacity / DEMUX_TASK_REFILL, &this->task) &&
+    _x_fifo_buffer_wait_free (audio_fifo, audio_fifo->buffer_pool_capacity / DEMUX_TASK_REFILL, &this->task);
+}
+
+static void demux_task_finish (demux_task_t *this) {
+  xine_stream_t *stream = this->stream;
+  int64_t        now;
+  int            done;
+
+  pthread_mutex_lock (&stream->counter_lock);
+  done = stream->finished_count_audio >= this->finished_count_audio &&
+         stream->finished_count_video >= this->finished_count_video;
+  pthread_mutex_unlock (&stream->counter_lock);
+
+  if (!done) {
+    /* the decoders wake us when they count, check every second else */
+    now = demux_task_now ();
+    if (now >= this->finish_timeout) {
+      if (demux_unstick_ao_loop (stream) && ++this->max_iterations > 4) {
+        xine_log(stream->xine,
+          XINE_LOG_MSG,_("Stuck in demux_loop(). Taking the emergency exit\n"));
+        stream->emergency_brake = 1;
+        done = 1;
+      }
+      this->finish_timeout = now + 1000000;
+    }
+    if (!done) {
+      _x_task_wake_after (&this->task, this->finish_timeout - now);
+      return;
+    }
+  }
+
+  this->phase = DEMUX_TASK_IDLE;
+  _x_handle_stream_end (stream, this->non_user);
+}
+
+static void demux_task_run (xine_task_t *task) {
+
+  demux_task_t  *this   = (demux_task_t *) task;
+  xine_stream_t *stream = this->stream;
+  int            n;
+
+  switch (this->phase) {
+  case DEMUX_TASK_IDLE:
+    return;
+  case DEMUX_TASK_FINISH:
+    demux_task_finish (this);
+    return;
+  }
+
+  /* xine_stop () holds the lock while it flushes the output tasks */
+  if (pthread_mutex_trylock (&stream->demux_lock)) {
+    _x_executor_block_enter ();
+    pthread_mutex_lock( &stream->demux_lock );
+    _x_executor_block_leave ();
+  }
+
+  switch (this->phase) {
+  case DEMUX_TASK_START:
+    stream->emergency_brake = 0;
+    this->status = stream->demux_plugin->get_status(stream->demux_plugin);
+    this->phase  = DEMUX_TASK_RUN;
+    break;
+  case DEMUX_TASK_DELAY:
+    if( stream->delay_finish_event > 0 )
+      stream->delay_finish_event--;
+    /* fall through */
+  case DEMUX_TASK_DRAIN:
+    this->status = stream->demux_plugin->get_status(stream->demux_plugin);
+    break;
+  }
+
+  while (1) {
+
+    if (this->phase == DEMUX_TASK_RUN) {
+
+      for (n = 0; this->status == DEMUX_OK && stream->demux_thread_running &&
+                  !stream->emergency_brake; n++) {
+
+        if (!demux_task_fifos_ready (this))
+          goto out;
+        if (n == DEMUX_TASK_CHUNKS) {
+          _x_task_wake (task);
+          goto out;
+        }
+
+        /* input plugins may wait for the network */
+        _x_executor_block_enter ();
+        this->status = stream->demux_plugin->send_chunk(stream->demux_plugin);
+        _x_executor_block_leave ();
+
+        /* someone may want to interrupt us */
+        if (_x_action_pending(stream)) {
+          _x_task_wake_after (task, 100000);
+          goto out;
+        }
+      }
+
+      lprintf ("main demuxer loop finished (status: %d)\n", this->status);
+
+      _x_fifo_buffer_wait_free (stream->video_fifo, 0, NULL);
+      _x_fifo_buffer_wait_free (stream->audio_fifo, 0, NULL);
+
+      _x_demux_control_nop(stream, BUF_FLAG_END_STREAM);
+      this->phase = DEMUX_TASK_DRAIN;
+    }
+
+    if (this->phase == DEMUX_TASK_DRAIN) {
+      if (stream->demux_thread_running &&
+          ((stream->video_fifo->size(stream->video_fifo)) ||
+           (stream->audio_fifo->size(stream->audio_fifo))) &&
+          this->status == DEMUX_FINISHED && !stream->emergency_brake) {
+        _x_task_wake_after (task, 100000);
+        goto out;
+      }
+      this->phase = DEMUX_TASK_DELAY;
+    }
+
+    if (stream->demux_thread_running &&
+        this->status == DEMUX_FINISHED && stream->delay_finish_event != 0) {
+      _x_task_wake_after (task, 100000);
+      goto out;
+    }
+
+    /* seek after demux finished */
+    if (this->status != DEMUX_OK || !stream->demux_thread_running ||
+        stream->emergency_brake)
+      break;
+    this->phase = DEMUX_TASK_RUN;
+  }
+
+  lprintf ("loop finished (status: %d)\n", this->status);
+
+  pthread_mutex_lock (&stream->counter_lock);
+  this->finished_count_audio = stream->audio_thread_created ? stream->finished_count_audio + 1 : 0;
+  this->finished_count_video = stream->video_thread_created ? stream->finished_count_video + 1 : 0;
+  pthread_mutex_unlock (&stream->counter_lock);
+
+  /* demux_thread_running is zero if demux loop has been stopped by user */
+  this->non_user = stream->demux_thread_running;
+  stream->demux_thread_running = 0;
+
+  _x_demux_control_end(stream, this->non_user);
+
+  lprintf ("loop finished, end buffer sent\n");
+
+  pthread_mutex_unlock( &stream->demux_lock );
+
+  this->phase          = DEMUX_TASK_FINISH;
+  this->finish_timeout = demux_task_now () + 1000000;
+  this->max_iterations = 0;
+  demux_task_finish (this);
+  return;
+
+out:
+  pthread_mutex_unlock( &stream->demux_lock );
+}
+
 int _x_demux_start_thread (xine_stream_t *stream) {
 
   int err;
@@ -434,20 +641,36 @@ int _x_demux_start_thread (xine_stream_t *stream) {
   _x_action_lower(stream);
   pthread_cond_signal(&stream->demux_resume);
 
+  if (!stream->demux_task && stream->xine->executor) {
+    demux_task_t *task = calloc (1, sizeof (demux_task_t));
+    if (task) {
+      _x_task_init (&task->task, stream->xine->executor, demux_task_run);
+      task->stream       = stream;
+      stream->demux_task = &task->task;
+    }
+  }
+
   if( !stream->demux_thread_running ) {
 
-    if (stream->demux_thread_created) {
+    if (stream->demux_task) {
+      _x_task_wait (stream->demux_task);
+      ((demux_task_t *) stream->demux_task)->phase = DEMUX_TASK_START;
+    } else if (stream->demux_thread_created) {
       void *p;
       pthread_join(stream->demux_thread, &p);
     }
 
     stream->demux_thread_running = 1;
     stream->demux_thread_created = 1;
-    if ((err = pthread_create (&stream->demux_thread,
+    if (stream->demux_task) {
+      _x_task_wake (stream->demux_task);
+    } else if ((err = pthread_create (&stream->demux_thread,
 			       NULL, demux_loop, (void *)stream)) != 0) {
       printf ("demux: can't create new thread (%s)\n", strerror(err));
       _x_abort();
     }
+  } else if (stream->demux_task) {
+    _x_task_wake (stream->demux_task);
   }
 
   pthread_mutex_unlock( &stream->demux_lock );
@@ -475,7 +698,12 @@ int _x_demux_stop_thread (xine_stream_t *stream) {
   lprintf ("joining thread %ld\n", stream->demux_thread );
 
   if( stream->demux_thread_created ) {
-    pthread_join (stream->demux_thread, &p);
+    if (stream->demux_task) {
+      _x_task_wake (stream->demux_task);
+      _x_task_wait (stream->demux_task);
+    } else {
+      pthread_join (stream->demux_thread, &p);
+    }
     stream->demux_thread_created = 0;
   }
 
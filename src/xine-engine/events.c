@@ -27,80 +27,178 @@
 #define XINE_ENGINE_INTERNAL
 
 #include <xine/xine_internal.h>
+#include "xine_private.h"
 
-xine_event_t *xine_event_get  (xine_event_queue_t *queue) {
+/*
+ * events handed out by queues come from a pool. data up to
+ * EVENT_INLINE_DATA bytes is stored in the slot itself, so most
+ * events take no allocation at all once the pool is warm.
+ */
+#define EVENT_INLINE_DATA   64
+#define EVENT_POOL_MAX      256
+
+typedef struct event_slot_s event_slot_t;
+struct event_slot_s {
+  xine_event_t   event;     /* first, xine_event_free() gets a pointer to it */
+  event_slot_t  *next;      /* in the pool */
+  union {
+    uint8_t      bytes[EVENT_INLINE_DATA];
+    void        *align_ptr;
+    int64_t      align_int;
+    double       align_double;
+  } data;
+};
+
+static pthread_mutex_t  event_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static event_slot_t    *event_pool;
+static int              event_pool_size;
+
+static xine_event_t *event_new (xine_stream_t *stream, int type, const void *data, int data_length) {
+  event_slot_t *slot;
+
+  pthread_mutex_lock (&event_pool_lock);
+  if ((slot = event_pool)) {
+    event_pool = slot->next;
+    event_pool_size--;
+  }
+  pthread_mutex_unlock (&event_pool_lock);
+
+  if (!slot && !(slot = malloc (sizeof (event_slot_t))))
+    return NULL;
+
+  slot->event.type        = type;
+  slot->event.stream      = stream;
+  slot->event.data_length = data_length;
+  slot->event.data        = NULL;
+  if ((data_length > 0) && data) {
+    if (data_length <= EVENT_INLINE_DATA)
+      slot->event.data = slot->data.bytes;
+    else if (!(slot->event.data = malloc (data_length))) {
+      free (slot);
+      return NULL;
+    }
+    memcpy (slot->event.data, data, data_length);
+  }
+  gettimeofday (&slot->event.tv, NULL);
 
-  xine_event_t  *event = NULL;
-  xine_list_iterator_t ite;
+  return &slot->event;
+}
 
-  pthread_mutex_lock (&queue->lock);
-  ite = xine_list_front (queue->events);
-  if (ite) {
-    event = xine_list_get_value (queue->events, ite);
-    if (event)
-      xine_list_remove (queue->events, ite);
+void xine_event_free (xine_event_t *event) {
+  event_slot_t *slot = (event_slot_t *) event;
+
+  if (event->data && event->data_length > 0 && event->data != slot->data.bytes)
+    free (event->data);
+
+  pthread_mutex_lock (&event_pool_lock);
+  if (event_pool_size < EVENT_POOL_MAX) {
+    slot->next = event_pool;
+    event_pool = slot;
+    event_pool_size++;
+    slot = NULL;
   }
-  pthread_mutex_unlock (&queue->lock);
+  pthread_mutex_unlock (&event_pool_lock);
 
-  return event;
+  free (slot);
 }
 
-xine_event_t *xine_event_wait (xine_event_queue_t *queue) {
+/*
+ * pending events are kept in a ring that grows as needed.
+ * called with queue->lock held.
+ */
+static void queue_put (xine_event_queue_private_t *priv, xine_event_t *event) {
 
-  xine_event_t  *event;
-  xine_list_iterator_t ite;
+  if (priv->events_count == priv->events_size) {
+    int            size = priv->events_size ? priv->events_size * 2 : 16;
+    xine_event_t **events = malloc (size * sizeof (xine_event_t *));
+    int            i;
 
-  pthread_mutex_lock (&queue->lock);
+    if (!events) {
+      xine_event_free (event);
+      return;
+    }
+    for (i = 0; i < priv->events_count; i++)
+      events[i] = priv->events[(priv->events_first + i) & (priv->events_size - 1)];
+    free (priv->events);
+    priv->events       = events;
+    priv->events_size  = size;
+    priv->events_first = 0;
+  }
+
+  priv->events[(priv->events_first + priv->events_count) & (priv->events_size - 1)] = event;
+  priv->events_count++;
+
+  /* a busy listener picks it up when done, no need to wake anyone */
+  if (priv->waiting)
+    pthread_cond_signal (&priv->queue.new_event);
+}
+
+/* called with queue->lock held */
+static int queue_take (xine_event_queue_private_t *priv, xine_event_t **events, int max) {
+  int n;
 
-  while ( !(ite = xine_list_front (queue->events)) ) {
-    pthread_cond_wait (&queue->new_event, &queue->lock);
+  for (n = 0; n < max && priv->events_count; n++) {
+    events[n] = priv->events[priv->events_first];
+    priv->events_first = (priv->events_first + 1) & (priv->events_size - 1);
+    priv->events_count--;
   }
+  return n;
+}
 
-  event = xine_list_get_value (queue->events, ite);
+/* called with queue->lock held */
+static void queue_wait (xine_event_queue_private_t *priv) {
 
-  xine_list_remove (queue->events, ite);
+  priv->waiting++;
+  while (!priv->events_count)
+    pthread_cond_wait (&priv->queue.new_event, &priv->queue.lock);
+  priv->waiting--;
+}
 
+xine_event_t *xine_event_get  (xine_event_queue_t *queue) {
+
+  xine_event_t  *event = NULL;
+
+  pthread_mutex_lock (&queue->lock);
+  queue_take ((xine_event_queue_private_t *)queue, &event, 1);
   pthread_mutex_unlock (&queue->lock);
 
   return event;
 }
 
-void xine_event_free (xine_event_t *event) {
-  if (event->data && event->data_length > 0) free (event->data);
-  free (event);
+xine_event_t *xine_event_wait (xine_event_queue_t *queue) {
+
+  xine_event_t  *event;
+
+  pthread_mutex_lock (&queue->lock);
+  queue_wait ((xine_event_queue_private_t *)queue);
+  queue_take ((xine_event_queue_private_t *)queue, &event, 1);
+  pthread_mutex_unlock (&queue->lock);
+
+  return event;
 }
 
 void xine_event_send (xine_stream_t *stream, const xine_event_t *event) {
 
-  xine_list_iterator_t ite;
+  xine_ilist_node_t *node;
 
   pthread_mutex_lock (&stream->event_queues_lock);
 
-  ite = xine_list_front (stream->event_queues);
+  node = xine_ilist_front (&stream->event_queues);
 
-  while (ite) {
-    xine_event_queue_t *queue;
+  while (node) {
+    xine_event_queue_private_t *priv;
     xine_event_t *cevent;
 
-    queue = xine_list_get_value(stream->event_queues, ite);
-    cevent = malloc (sizeof (xine_event_t));
-    cevent->type        = event->type;
-    cevent->stream      = stream;
-    cevent->data_length = event->data_length;
-    if ((event->data_length > 0) && (event->data) ) {
-      cevent->data = malloc (event->data_length);
-      memcpy (cevent->data, event->data, event->data_length);
-    } else {
-      cevent->data = NULL;
-    }
-    gettimeofday (&cevent->tv, NULL);
+    priv = xine_ilist_entry (node, xine_event_queue_private_t, node);
+    cevent = event_new (stream, event->type, event->data, event->data_length);
 
-    pthread_mutex_lock (&queue->lock);
-    xine_list_push_back (queue->events, cevent);
-    pthread_cond_signal (&queue->new_event);
-    pthread_mutex_unlock (&queue->lock);
+    if (cevent) {
+      pthread_mutex_lock (&priv->queue.lock);
+      queue_put (priv, cevent);
+      pthread_mutex_unlock (&priv->queue.lock);
+    }
 
-    ite = xine_list_next (stream->event_queues, ite);
+    node = xine_ilist_next (&stream->event_queues, node);
   }
 
   pthread_mutex_unlock (&stream->event_queues_lock);
@@ -109,22 +207,25 @@ void xine_event_send (xine_stream_t *stream, const xine_event_t *event) {
 
 xine_event_queue_t *xine_event_new_queue (xine_stream_t *stream) {
 
-  xine_event_queue_t *queue;
+  xine_event_queue_private_t *priv;
+  xine_event_queue_t         *queue;
 
   _x_refcounter_inc(stream->refcounter);
 
-  queue = malloc (sizeof (xine_event_queue_t));
+  priv = calloc (1, sizeof (xine_event_queue_private_t));
+  queue = &priv->queue;
 
   pthread_mutex_init (&queue->lock, NULL);
   pthread_cond_init (&queue->new_event, NULL);
   pthread_cond_init (&queue->events_processed, NULL);
-  queue->events = xine_list_new ();
+  queue->events = NULL;
   queue->stream = stream;
   queue->listener_thread = NULL;
+  queue->callback = NULL;
   queue->callback_running = 0;
 
   pthread_mutex_lock (&stream->event_queues_lock);
-  xine_list_push_back (stream->event_queues, queue);
+  xine_ilist_push_back (&stream->event_queues, &priv->node);
   pthread_mutex_unlock (&stream->event_queues_lock);
 
   return queue;
@@ -132,50 +233,31 @@ xine_event_queue_t *xine_event_new_queue (xine_stream_t *stream) {
 
 void xine_event_dispose_queue (xine_event_queue_t *queue) {
 
+  xine_event_queue_private_t *priv = (xine_event_queue_private_t *)queue;
   xine_stream_t        *stream = queue->stream;
   xine_event_t         *event;
   xine_event_t         *qevent;
-  xine_event_queue_t   *q;
-  xine_list_iterator_t  ite;
 
   pthread_mutex_lock (&stream->event_queues_lock);
 
-  ite = xine_list_front (stream->event_queues);
-
-  q = NULL;
-  if ( ite ) {
-    do {
-      q = xine_list_get_value (stream->event_queues, ite);
-
-      if ( q == queue )
-	break;
-    } while( (ite = xine_list_next (stream->event_queues, ite)) );
-  }
-
-  if (q != queue) {
+  if (!xine_ilist_linked (&priv->node)) {
     xprintf (stream->xine, XINE_VERBOSITY_DEBUG, "events: tried to dispose queue which is not in list\n");
 
     pthread_mutex_unlock (&stream->event_queues_lock);
     return;
   }
 
-  xine_list_remove (stream->event_queues, ite);
+  xine_ilist_remove (&stream->event_queues, &priv->node);
   pthread_mutex_unlock (&stream->event_queues_lock);
 
   /*
    * send quit event
    */
-  qevent = (xine_event_t *)malloc(sizeof(xine_event_t));
-
-  qevent->type        = XINE_EVENT_QUIT;
-  qevent->stream      = stream;
-  qevent->data        = NULL;
-  qevent->data_length = 0;
-  gettimeofday (&qevent->tv, NULL);
+  qevent = event_new (stream, XINE_EVENT_QUIT, NULL, 0);
 
   pthread_mutex_lock (&queue->lock);
-  xine_list_push_back (queue->events, qevent);
-  pthread_cond_signal (&queue->new_event);
+  if (qevent)
+    queue_put (priv, qevent);
   pthread_mutex_unlock (&queue->lock);
 
   /*
@@ -197,38 +279,51 @@ void xine_event_dispose_queue (xine_event_queue_t *queue) {
   while ( (event = xine_event_get (queue)) ) {
     xine_event_free (event);
   }
-  xine_list_delete(queue->events);
+  free (priv->events);
 
   pthread_mutex_destroy(&queue->lock);
   pthread_cond_destroy(&queue->new_event);
   pthread_cond_destroy(&queue->events_processed);
 
-  free (queue);
+  free (priv);
 }
 
 
+/* events passed to the callback at once */
+#define LISTENER_BATCH 64
+
 static void *listener_loop (void *queue_gen) {
 
-  xine_event_queue_t *queue = (xine_event_queue_t *) queue_gen;
-  int running = 1;
+  xine_event_queue_private_t *priv = (xine_event_queue_private_t *) queue_gen;
+  xine_event_queue_t         *queue = &priv->queue;
+  xine_event_t               *events[LISTENER_BATCH];
+  int                         running = 1;
+  int                         n, i;
 
   while (running) {
 
-    xine_event_t *event;
-
-    event = xine_event_wait (queue);
+    pthread_mutex_lock (&queue->lock);
+    queue_wait (priv);
+    n = queue_take (priv, events, LISTENER_BATCH);
+    queue->callback_running = 1;
+    pthread_mutex_unlock (&queue->lock);
 
-    if (event->type == XINE_EVENT_QUIT)
-      running = 0;
+    for (i = 0; i < n; i++)
+      if (events[i]->type == XINE_EVENT_QUIT)
+        running = 0;
 
-    queue->callback_running = 1;
-    queue->callback (queue->user_data, event);
-    queue->callback_running = 0;
+    if (priv->batch_callback)
+      priv->batch_callback (queue->user_data, (const xine_event_t *const *) events, n);
+    else
+      for (i = 0; i < n; i++)
+        queue->callback (queue->user_data, events[i]);
 
-    xine_event_free (event);
+    for (i = 0; i < n; i++)
+      xine_event_free (events[i]);
 
     pthread_mutex_lock (&queue->lock);
-    if (xine_list_empty (queue->events)) {
+    queue->callback_running = 0;
+    if (!priv->events_count) {
       pthread_cond_signal (&queue->events_processed);
     }
     pthread_mutex_unlock (&queue->lock);
@@ -238,14 +333,10 @@ static void *listener_loop (void *queue_gen) {
 }
 
 
-void xine_event_create_listener_thread (xine_event_queue_t *queue,
-					xine_event_listener_cb_t callback,
-					void *user_data) {
+static void create_listener_thread (xine_event_queue_t *queue) {
   int err;
 
   queue->listener_thread = malloc (sizeof (pthread_t));
-  queue->callback        = callback;
-  queue->user_data       = user_data;
 
   if ((err = pthread_create (queue->listener_thread,
 			     NULL, listener_loop, queue)) != 0) {
@@ -254,3 +345,23 @@ void xine_event_create_listener_thread (xine_event_queue_t *queue,
     _x_abort();
   }
 }
+
+void xine_event_create_listener_thread (xine_event_queue_t *queue,
+					xine_event_listener_cb_t callback,
+					void *user_data) {
+
+  queue->callback        = callback;
+  queue->user_data       = user_data;
+
+  create_listener_thread (queue);
+}
+
+void xine_event_create_batch_listener_thread (xine_event_queue_t *queue,
+					      xine_event_batch_listener_cb_t callback,
+					      void *user_data) {
+
+  ((xine_event_queue_private_t *)queue)->batch_callback = callback;
+  queue->user_data       = user_data;
+
+  create_listener_thread (queue);
+}
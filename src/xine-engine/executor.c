@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * executor - runs the stages of many streams on a few shared threads
+ *
+ * A task is woken whenever there is work for it (a buffer was put into
+ * its fifo, or space came free in the fifo it fills).  Woken tasks are
+ * queued and run by the next free thread; a task is never queued twice
+ * and never runs on two threads at once, waking a running task makes it
+ * run once more afterwards.
+ *
+ * At most max_running tasks run at the same time.  Tasks may still
+ * block, sometimes on each other (e.g. video waiting for audio to reach
+ * a discontinuity).  Such waits are bracketed by _x_executor_block_enter()
+ * and _x_executor_block_leave(), which hand the slot of the blocked thread
+ * to another one.  Threads are started on demand, and those that are
+ * left over when blocked ones come back terminate.
+ *
+ * Output loops and demuxers also wait for time to pass.  They arm a timer
+ * with _x_task_wake_after(); idle threads sleep until the earliest timer
+ * is due and then queue its task.  An ordinary wake cancels the timer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#define LOG_MODULE "executor"
+/*
+#define LOG
+*/
+
+#include <xine/xineutils.h>
+#include "xine_private.h"
+
+enum {
+  TASK_IDLE = 0,
+  TASK_QUEUED,
+  TASK_RUNNING,
+  TASK_RERUN,      /* running, and woken again meanwhile */
+  TASK_TIMED       /* idle, waiting for its timer */
+};
+
+struct xine_executor_s {
+  pthread_mutex_t  lock;
+  pthread_cond_t   work;         /* task queued, or quit */
+  pthread_cond_t   done;         /* task went idle, or thread terminated */
+
+  xine_task_t     *first, *last; /* run queue */
+  xine_task_t     *timers;       /* sorted by due */
+
+  int              max_running;
+  int              running;      /* threads running a task and not blocked */
+  int              waiting;      /* threads looking for work */
+  int              threads;      /* threads alive */
+
+  int              quit;
+};
+
+/* per thread, for _x_executor_block_enter() */
+typedef struct {
+  xine_executor_t *executor;
+  int              blocked;
+} executor_thread_t;
+
+static pthread_key_t  executor_key;
+static pthread_once_t executor_key_once = PTHREAD_ONCE_INIT;
+
+static void executor_key_init (void) {
+  pthread_key_create (&executor_key, NULL);
+}
+
+static void *executor_loop (void *this_gen);
+
+static int64_t executor_now (void) {
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* called with this->lock held */
+static void executor_enqueue (xine_executor_t *this, xine_task_t *task) {
+  task->state = TASK_QUEUED;
+  task->next  = NULL;
+  if (this->last)
+    this->last->next = task;
+  else
+    this->first = task;
+  this->last = task;
+}
+
+/* called with this->lock held */
+static void executor_timer_add (xine_executor_t *this, xine_task_t *task) {
+  xine_task_t **p = &this->timers;
+
+  while (*p && (*p)->due <= task->due)
+    p = &(*p)->next;
+  task->next  = *p;
+  *p          = task;
+  task->state = TASK_TIMED;
+}
+
+/* called with this->lock held */
+static void executor_timer_remove (xine_executor_t *this, xine_task_t *task) {
+  xine_task_t **p = &this->timers;
+
+  while (*p != task)
+    p = &(*p)->next;
+  *p         = task->next;
+  task->next = NULL;
+}
+
+/* queue the tasks whose timers are due. called with this->lock held */
+static void executor_timer_fire (xine_executor_t *this) {
+  int64_t now;
+
+  if (!this->timers)
+    return;
+
+  now = executor_now ();
+  while (this->timers && this->timers->due <= now) {
+    xine_task_t *task = this->timers;
+    this->timers = task->next;
+    executor_enqueue (this, task);
+  }
+}
+
+/*
+ * make sure someone picks up queued tasks while there is a free slot,
+ * and that someone watches the timers. called with this->lock held.
+ */
+static void executor_kick (xine_executor_t *this) {
+  pthread_t thread;
+
+  if ((!this->first && !this->timers) || this->running >= this->max_running)
+    return;
+
+  if (this->waiting) {
+    pthread_cond_signal (&this->work);
+    return;
+  }
+
+  /* counts as waiting until it enters the loop */
+  this->waiting++;
+  this->threads++;
+  if (pthread_create (&thread, NULL, executor_loop, this)) {
+    this->waiting--;
+    this->threads--;
+    return;
+  }
+  pthread_detach (thread);
+}
+
+static void *executor_loop (void *this_gen) {
+  xine_executor_t   *this = (xine_executor_t *) this_gen;
+  executor_thread_t  self = { this, 0 };
+  xine_task_t       *task;
+
+  pthread_setspecific (executor_key, &self);
+
+  pthread_mutex_lock (&this->lock);
+  this->waiting--;
+
+  while (1) {
+
+    executor_timer_fire (this);
+
+    if (this->first && this->running < this->max_running) {
+
+      task = this->first;
+      this->first = task->next;
+      if (!this->first)
+        this->last = NULL;
+      task->next  = NULL;
+      task->state = TASK_RUNNING;
+      task->due   = 0;
+      this->running++;
+
+      pthread_mutex_unlock (&this->lock);
+      task->run (task);
+      pthread_mutex_lock (&this->lock);
+
+      this->running--;
+      if (task->state == TASK_RERUN) {
+        executor_enqueue (this, task);
+      } else if (task->due) {
+        executor_timer_add (this, task);
+        /* this thread may be a spare about to leave */
+        if (this->timers == task && this->waiting)
+          pthread_cond_signal (&this->work);
+      } else {
+        task->state = TASK_IDLE;
+        pthread_cond_broadcast (&this->done);
+      }
+      continue;
+    }
+
+    /* keep max_running threads around, the others were spares
+     * started while some thread was blocked */
+    if (this->quit || this->waiting >= this->max_running)
+      break;
+
+    this->waiting++;
+    if (this->timers) {
+      struct timespec ts;
+      ts.tv_sec  = this->timers->due / 1000000;
+      ts.tv_nsec = (this->timers->due % 1000000) * 1000;
+      pthread_cond_timedwait (&this->work, &this->lock, &ts);
+    } else {
+      pthread_cond_wait (&this->work, &this->lock);
+    }
+    this->waiting--;
+  }
+
+  this->threads--;
+  pthread_cond_broadcast (&this->done);
+  pthread_mutex_unlock (&this->lock);
+
+  pthread_setspecific (executor_key, NULL);
+  return NULL;
+}
+
+xine_executor_t *_x_executor_new (int max_running) {
+  xine_executor_t *this;
+
+  pthread_once (&executor_key_once, executor_key_init);
+
+  this = calloc (1, sizeof (xine_executor_t));
+  if (!this)
+    return NULL;
+
+  pthread_mutex_init (&this->lock, NULL);
+  pthread_cond_init (&this->work, NULL);
+  pthread_cond_init (&this->done, NULL);
+
+  this->max_running = max_running > 0 ? max_running : 1;
+
+  return this;
+}
+
+void _x_executor_delete (xine_executor_t *this) {
+
+  if (!this)
+    return;
+
+  pthread_mutex_lock (&this->lock);
+  _x_assert (!this->first && !this->timers);
+  this->quit = 1;
+  pthread_cond_broadcast (&this->work);
+  while (this->threads)
+    pthread_cond_wait (&this->done, &this->lock);
+  pthread_mutex_unlock (&this->lock);
+
+  pthread_cond_destroy (&this->done);
+  pthread_cond_destroy (&this->work);
+  pthread_mutex_destroy (&this->lock);
+  free (this);
+}
+
+void _x_task_init (xine_task_t *task, xine_executor_t *executor, void (*run) (xine_task_t *task)) {
+  task->run      = run;
+  task->executor = executor;
+  task->state    = TASK_IDLE;
+  task->due      = 0;
+  task->next     = NULL;
+}
+
+void _x_task_wake (xine_task_t *task) {
+  xine_executor_t *this = task->executor;
+
+  pthread_mutex_lock (&this->lock);
+
+  switch (task->state) {
+  case TASK_TIMED:
+    executor_timer_remove (this, task);
+    /* fall through */
+  case TASK_IDLE:
+    executor_enqueue (this, task);
+    executor_kick (this);
+    break;
+  case TASK_RUNNING:
+    task->state = TASK_RERUN;
+    break;
+  default:
+    break;
+  }
+
+  pthread_mutex_unlock (&this->lock);
+}
+
+void _x_task_wake_after (xine_task_t *task, int usec) {
+  xine_executor_t *this = task->executor;
+  int64_t          due  = executor_now () + (usec > 0 ? usec : 0);
+
+  pthread_mutex_lock (&this->lock);
+
+  switch (task->state) {
+  case TASK_TIMED:
+    if (due >= task->due)
+      break;
+    executor_timer_remove (this, task);
+    /* fall through */
+  case TASK_IDLE:
+    task->due = due;
+    executor_timer_add (this, task);
+    /* a waiting thread may sleep until a later timer */
+    if (this->timers == task)
+      executor_kick (this);
+    break;
+  case TASK_RUNNING:
+    /* armed when the run returns */
+    if (!task->due || due < task->due)
+      task->due = due;
+    break;
+  default:
+    break;
+  }
+
+  pthread_mutex_unlock (&this->lock);
+}
+
+void _x_task_wait (xine_task_t *task) {
+  xine_executor_t *this = task->executor;
+
+  pthread_mutex_lock (&this->lock);
+  while (task->state != TASK_IDLE)
+    pthread_cond_wait (&this->done, &this->lock);
+  pthread_mutex_unlock (&this->lock);
+}
+
+void _x_executor_block_enter (void) {
+  executor_thread_t *self;
+  xine_executor_t   *this;
+
+  pthread_once (&executor_key_once, executor_key_init);
+
+  /* not an executor thread */
+  if (!(self = pthread_getspecific (executor_key)))
+    return;
+  if (self->blocked++)
+    return;
+
+  this = self->executor;
+  pthread_mutex_lock (&this->lock);
+  this->running--;
+  executor_kick (this);
+  pthread_mutex_unlock (&this->lock);
+}
+
+void _x_executor_block_leave (void) {
+  executor_thread_t *self;
+  xine_executor_t   *this;
+
+  pthread_once (&executor_key_once, executor_key_init);
+
+  if (!(self = pthread_getspecific (executor_key)))
+    return;
+  if (--self->blocked)
+    return;
+
+  this = self->executor;
+  pthread_mutex_lock (&this->lock);
+  this->running++;
+  pthread_mutex_unlock (&this->lock);
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * latency - pipeline latency tracing
+ *
+ * Buffers get stamped in extra_info->latency[] when they are allocated,
+ * put into and taken from a fifo (buffer.c). The decoder merges them into
+ * its extra info, which is copied into frames and audio buffers as they
+ * are handed to the output (stamped again). When the output shows or
+ * writes them, the stamps are summed up per stream and, optionally,
+ * written as async events to a chrome trace file (chrome://tracing,
+ * ui.perfetto.dev).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#define LOG_MODULE "latency"
+
+#define XINE_ENGINE_INTERNAL
+
+#include <xine/xine_internal.h>
+#include <xine/xineutils.h>
+#include "xine_private.h"
+
+int _x_latency_enabled = 0;
+
+static const char *const stage_names[XINE_LATENCY_STAGES] = {
+  "frame", "demux", "fifo", "decode", "output"
+};
+
+static const char *const type_names[2] = { "video", "audio" };
+
+static void trace_event (FILE *f, const xine_stream_t *stream, int type, const char *name,
+                         char phase, int64_t id, uint64_t ns) {
+  fprintf (f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"id\":%" PRId64
+           ",\"pid\":%d,\"tid\":%d,\"ts\":%" PRIu64 ".%03d}",
+           name, type_names[type], phase, id, stream->latency_id, type + 1,
+           ns / 1000, (int) (ns % 1000));
+}
+
+static void trace_frame (xine_stream_t *stream, int type, int64_t id, const uint64_t *stamp) {
+  xine_t *xine = stream->xine;
+  FILE   *f;
+  int     i;
+
+  pthread_mutex_lock (&xine->latency_lock);
+
+  if ((f = xine->latency_trace)) {
+    if (id == 0) {
+      fprintf (f, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"stream %d\"}}",
+               stream->latency_id, stream->latency_id);
+      fprintf (f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+               stream->latency_id, type + 1, type_names[type]);
+    }
+    trace_event (f, stream, type, stage_names[0], 'b', id, stamp[XINE_LATENCY_READ]);
+    for (i = 1; i < XINE_LATENCY_STAGES; i++) {
+      trace_event (f, stream, type, stage_names[i], 'b', id, stamp[i - 1]);
+      trace_event (f, stream, type, stage_names[i], 'e', id, stamp[i]);
+    }
+    trace_event (f, stream, type, stage_names[0], 'e', id, stamp[XINE_LATENCY_OUTPUT]);
+  }
+
+  pthread_mutex_unlock (&xine->latency_lock);
+}
+
+void _x_latency_record (xine_stream_t *stream, int type, extra_info_t *info) {
+  xine_latency_t *lat;
+  uint64_t       *stamp = info->latency;
+  uint64_t        ns;
+  int             i;
+
+  /* not traced, or already shown (repeated frame) */
+  if (!stamp[XINE_LATENCY_READ] || stamp[XINE_LATENCY_OUTPUT])
+    return;
+
+  stamp[XINE_LATENCY_OUTPUT] = xine_instrument_now ();
+
+  lat = &stream->latency[type];
+
+  for (i = 1; i < XINE_LATENCY_STAGES; i++) {
+    /* tracing was switched on in between, or the buffer took a shortcut */
+    if (stamp[i] < stamp[i - 1])
+      stamp[i] = stamp[i - 1];
+    ns = stamp[i] - stamp[i - 1];
+    lat->total_ns[i] += ns;
+    if (ns > lat->max_ns[i])
+      lat->max_ns[i] = ns;
+  }
+
+  ns = stamp[XINE_LATENCY_OUTPUT] - stamp[XINE_LATENCY_READ];
+  lat->total_ns[0] += ns;
+  if (ns > lat->max_ns[0])
+    lat->max_ns[0] = ns;
+  lat->last_ns = ns;
+
+  if (stream->xine->latency_trace)
+    trace_frame (stream, type, lat->frames, stamp);
+
+  lat->frames++;
+}
+
+void _x_latency_stream_init (xine_stream_t *stream) {
+  xine_t *xine = stream->xine;
+
+  memset (stream->latency, 0, sizeof (stream->latency));
+
+  pthread_mutex_lock (&xine->latency_lock);
+  stream->latency_id = ++xine->latency_streams;
+  pthread_mutex_unlock (&xine->latency_lock);
+}
+
+void _x_latency_trace_open (xine_t *xine, const char *filename) {
+  FILE *f = NULL;
+
+  if (filename && *filename) {
+    f = fopen (filename, "w");
+    if (f)
+      /* every event starts with a comma, the first one separates this */
+      fprintf (f, "[{\"name\":\"xine\",\"ph\":\"M\",\"pid\":0,\"args\":{}}");
+    else
+      xprintf (xine, XINE_VERBOSITY_LOG,
+               _("latency: cannot open trace file %s\n"), filename);
+  }
+
+  pthread_mutex_lock (&xine->latency_lock);
+  if (xine->latency_trace) {
+    fprintf (xine->latency_trace, "\n]\n");
+    fclose (xine->latency_trace);
+  }
+  xine->latency_trace = f;
+  pthread_mutex_unlock (&xine->latency_lock);
+}
+
+int xine_get_latency (xine_stream_t *stream, int type, xine_latency_t *latency) {
+
+  if (type != XINE_LATENCY_VIDEO && type != XINE_LATENCY_AUDIO)
+    return 0;
+
+  /* written by the output thread only, a copy may be slightly torn */
+  memcpy (latency, &stream->latency[type], sizeof (xine_latency_t));
+
+  return latency->frames > 0;
+}
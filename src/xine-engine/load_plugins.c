@@ -256,26 +256,49 @@ static void _decoder_priority_cb(void *data, xine_cfg_entry_t *cfg) {
 static plugin_node_t *_get_cached_node (xine_t *this,
 					char *filename, off_t filesize, time_t filemtime,
 					plugin_node_t *previous_node) {
-  xine_sarray_t *list = this->plugin_catalog->cache_list;
-  int            list_id, list_size;
+  plugin_catalog_t *catalog = this->plugin_catalog;
+  plugin_node_t    *node;
 
-  list_size = xine_sarray_size (list);
-  for (list_id = 0; list_id < list_size; list_id++) {
-    plugin_node_t *node = xine_sarray_get (list, list_id);
-    if( !previous_node &&
-	node->file->filesize == filesize &&
-	node->file->filemtime == filemtime &&
-	!strcmp( node->file->filename, filename )) {
+  if (!catalog->cache_files)
+    return NULL;
+
+  if (previous_node)
+    node = xine_hash_get (catalog->cache_next, previous_node);
+  else
+    node = xine_hash_get (catalog->cache_files, filename);
 
+  for (; node; node = xine_hash_get (catalog->cache_next, node)) {
+    if (node->file->filesize == filesize &&
+	node->file->filemtime == filemtime)
       return node;
-    }
+  }
+  return NULL;
+}
+
+/* chain up the cached nodes of every file, in cache_list order */
+static void _index_cached_nodes (plugin_catalog_t *catalog) {
+  xine_sarray_t *list = catalog->cache_list;
+  int            list_id, list_size;
+
+  list_size = xine_sarray_size (list);
+  catalog->cache_files = xine_hash_new (list_size, xine_hash_str, xine_hash_str_compare);
+  catalog->cache_next  = xine_hash_new (list_size, NULL, NULL);
+  if (!catalog->cache_files || !catalog->cache_next) {
+    xine_hash_delete (catalog->cache_files);
+    xine_hash_delete (catalog->cache_next);
+    catalog->cache_files = catalog->cache_next = NULL;
+    return;
+  }
 
-    /* skip previously returned items */
-    if( node == previous_node )
-      previous_node = NULL;
+  /* backwards, so the first node of a file is put last */
+  for (list_id = list_size - 1; list_id >= 0; list_id--) {
+    plugin_node_t *node = xine_sarray_get (list, list_id);
+    plugin_node_t *next = xine_hash_get (catalog->cache_files, node->file->filename);
 
+    if (next)
+      xine_hash_put (catalog->cache_next, node, next);
+    xine_hash_put (catalog->cache_files, node->file->filename, node);
   }
-  return NULL;
 }
 
 
@@ -1247,6 +1270,7 @@ static void load_cached_catalog (xine_t *this) {
   if( (fp = fopen(cachefile,"r")) != NULL ) {
     load_plugin_list (this, fp, this->plugin_catalog->cache_list);
     fclose(fp);
+    _index_cached_nodes (this->plugin_catalog);
   }
   free(cachefile);
 }
@@ -2839,6 +2863,8 @@ void _x_dispose_plugins (xine_t *this) {
       dispose_plugin_list (this->plugin_catalog->plugin_lists[i], 0);
     }
 
+    xine_hash_delete (this->plugin_catalog->cache_files);
+    xine_hash_delete (this->plugin_catalog->cache_next);
     dispose_plugin_list (this->plugin_catalog->cache_list, 1);
     dispose_plugin_file_list (this->plugin_catalog->file_list);
 
@@ -39,10 +39,12 @@
 */
 #define METRONOM_INTERNAL
 #define METRONOM_CLOCK_INTERNAL
+#define XINE_ENGINE_INTERNAL
 
 #include <xine/xine_internal.h>
 #include <xine/metronom.h>
 #include <xine/xineutils.h>
+#include "xine_private.h"
 
 #define MAX_AUDIO_DELTA        1600
 #define AUDIO_SAMPLE_NUM      32768
@@ -50,8 +52,21 @@
 #define MAX_NUM_WRAP_DIFF        10
 #define MAX_SCR_PROVIDERS        10
 #define VIDEO_DRIFT_TOLERANCE 45000
+#define FREE_RUN_CLIENTS         32
+#define FREE_RUN_IDLE     INT64_MAX
+#define FREE_RUN_GRACE        20000      /* usec */
 #define AUDIO_DRIFT_TOLERANCE 45000
 
+/* slave SCRs are measured against the master every second, and slewed
+ * towards it by up to 0.5% of speed. farther off than SCR_SYNC_MAX_OFFSET,
+ * while not playing at normal speed, or when they can't run at fractional
+ * speeds, they are set to the master. */
+#define SCR_SYNC_INTERVAL         1      /* sec */
+#define SCR_SYNC_MAX_OFFSET    9000
+#define SCR_SYNC_TAU         900000
+#define SCR_SYNC_PULL       1800000
+#define SCR_SYNC_MAX_RATE     0.005
+
 /* metronom video modes */
 #define VIDEO_PREDICTION_MODE     0      /* use pts + frame duration */
 #define VIDEO_PTS_MODE            1      /* use only pts */
@@ -209,32 +224,61 @@ static void metronom_start_clock (metronom_clock_t *this, int64_t pts) {
   for (scr = this->scr_list; scr < this->scr_list+MAX_SCR_PROVIDERS; scr++)
     if (*scr) (*scr)->start(*scr, pts);
 
+  pthread_mutex_lock (&this->lock);
+  this->free_run_vpts = pts;
+  this->stopped = 0;
+  pthread_cond_broadcast (&this->free_run_changed);
+  pthread_mutex_unlock (&this->lock);
+
   this->speed = XINE_FINE_SPEED_NORMAL;
 }
 
 
 static int64_t metronom_get_current_time (metronom_clock_t *this) {
+  if (this->free_run) {
+    int64_t vpts;
+
+    pthread_mutex_lock (&this->lock);
+    vpts = this->free_run ? this->free_run_vpts : this->scr_master->get_current(this->scr_master);
+    pthread_mutex_unlock (&this->lock);
+    return vpts;
+  }
   return this->scr_master->get_current(this->scr_master);
 }
 
 
 static void metronom_stop_clock(metronom_clock_t *this) {
   scr_plugin_t** scr;
+
+  /* keep the sync loop from restarting the slaves */
+  pthread_mutex_lock (&this->lock);
+  this->stopped = 1;
   for (scr = this->scr_list; scr < this->scr_list+MAX_SCR_PROVIDERS; scr++)
     if (*scr) (*scr)->set_fine_speed(*scr, XINE_SPEED_PAUSE);
+  pthread_mutex_unlock (&this->lock);
 }
 
 static void metronom_resume_clock(metronom_clock_t *this) {
   scr_plugin_t** scr;
+
+  pthread_mutex_lock (&this->lock);
+  this->stopped = 0;
   for (scr = this->scr_list; scr < this->scr_list+MAX_SCR_PROVIDERS; scr++)
     if (*scr) (*scr)->set_fine_speed(*scr, XINE_FINE_SPEED_NORMAL);
+  pthread_mutex_unlock (&this->lock);
 }
 
 
 
+static xine_tracepoint_t tp_adjust    = XINE_TRACEPOINT ("metronom.adjust");
+static xine_tracepoint_t tp_disc_wait = XINE_TRACEPOINT ("metronom.discontinuity.wait");
+
 static void metronom_adjust_clock(metronom_clock_t *this, int64_t desired_pts) {
-  if (this->scr_adjustable)
+  /* a free running clock only follows the outputs */
+  if (this->scr_adjustable && !this->free_run) {
+    xine_tp_hit (tp_adjust, 1);
     this->scr_master->adjust(this->scr_master, desired_pts);
+  }
 }
 
 static int metronom_set_speed (metronom_clock_t *this, int speed) {
@@ -242,6 +286,9 @@ static int metronom_set_speed (metronom_clock_t *this, int speed) {
   scr_plugin_t **scr;
   int            true_speed;
 
+  /* not while the sync loop slews a slave */
+  pthread_mutex_lock (&this->lock);
+
   true_speed = this->scr_master->set_fine_speed (this->scr_master, speed);
 
   this->speed = true_speed;
@@ -249,6 +296,8 @@ static int metronom_set_speed (metronom_clock_t *this, int speed) {
   for (scr = this->scr_list; scr < this->scr_list+MAX_SCR_PROVIDERS; scr++)
     if (*scr) (*scr)->set_fine_speed(*scr, true_speed);
 
+  pthread_mutex_unlock (&this->lock);
+
   return true_speed;
 }
 
@@ -395,14 +444,19 @@ static void metronom_handle_video_discontinuity (metronom_t *this, int type,
     this->video_discontinuity_count, type, disc_off);
 
   if (this->have_audio) {
+    uint64_t t = xine_tp_start ();
+
     while (this->audio_discontinuity_count <
 	   this->video_discontinuity_count) {
 
       xprintf(this->xine, XINE_VERBOSITY_DEBUG, "waiting for audio discontinuity #%d\n",
         this->video_discontinuity_count);
 
+      _x_executor_block_enter ();
       pthread_cond_wait (&this->audio_discontinuity_reached, &this->lock);
+      _x_executor_block_leave ();
     }
+    xine_tp_stop (tp_disc_wait, t);
   }
 
   metronom_handle_discontinuity(this, type, disc_off);
@@ -557,6 +611,7 @@ static void metronom_handle_audio_discontinuity (metronom_t *this, int type,
 	  this->audio_discontinuity_count, type, disc_off);
 
   if (this->have_video) {
+    uint64_t t = xine_tp_start ();
 
     /* next_vpts_offset, in_discontinuity is handled in expect_video_discontinuity */
     while ( this->audio_discontinuity_count >
@@ -565,8 +620,11 @@ static void metronom_handle_audio_discontinuity (metronom_t *this, int type,
       xprintf(this->xine, XINE_VERBOSITY_DEBUG, "waiting for in_discontinuity update #%d\n",
 	      this->audio_discontinuity_count);
 
+      _x_executor_block_enter ();
       pthread_cond_wait (&this->video_discontinuity_reached, &this->lock);
+      _x_executor_block_leave ();
     }
+    xine_tp_stop (tp_disc_wait, t);
   } else {
     metronom_handle_discontinuity(this, type, disc_off);
   }
@@ -706,15 +764,13 @@ static void metronom_set_option (metronom_t *this, int option, int64_t value) {
     xprintf(this->xine, XINE_VERBOSITY_LOG, "spu_offset=%" PRId64 " pts\n", this->spu_offset);
     break;
   case METRONOM_ADJ_VPTS_OFFSET:
+    /* small steps several times a second, keep the fractional part */
     this->audio_vpts      += value;
-    this->audio_vpts_rmndr = 0;
 
-    /* that message should be rare, please report otherwise.
-     * when xine is in some sort of "steady state" hearing it
-     * once in a while means a small sound card drift (or system
-     * clock drift -- who knows?). nothing to worry about.
+    /* audio_out follows the sound card drift continuously, this
+     * message is for debugging the feedback loop only.
      */
-    xprintf(this->xine, XINE_VERBOSITY_LOG, "fixing sound card drift by %" PRId64 " pts\n", value);
+    xprintf(this->xine, XINE_VERBOSITY_DEBUG, "fixing sound card drift by %" PRId64 " pts\n", value);
     break;
   case METRONOM_PREBUFFER:
     this->prebuffer = value;
@@ -736,6 +792,22 @@ static void metronom_clock_set_option (metronom_clock_t *this,
   case CLOCK_SCR_ADJUSTABLE:
     this->scr_adjustable = value;
     break;
+  case CLOCK_FREE_RUN:
+    value = !!value;
+    if (value == this->free_run)
+      break;
+    if (value) {
+      this->free_run_vpts = this->scr_master->get_current(this->scr_master);
+    } else {
+      /* continue in real time from where the outputs got */
+      scr_plugin_t **scr;
+      for (scr = this->scr_list; scr < this->scr_list+MAX_SCR_PROVIDERS; scr++)
+        if (*scr) (*scr)->adjust(*scr, this->free_run_vpts);
+    }
+    this->free_run = value;
+    xprintf(this->xine, XINE_VERBOSITY_DEBUG, "free-run clock %s\n", value ? "on" : "off");
+    pthread_cond_broadcast (&this->free_run_changed);
+    break;
   default:
     xprintf(this->xine, XINE_VERBOSITY_NONE, "unknown option in set_option: %d\n", option);
   }
@@ -786,6 +858,12 @@ static int64_t metronom_clock_get_option (metronom_clock_t *this, int option) {
   switch (option) {
   case CLOCK_SCR_ADJUSTABLE:
     return this->scr_adjustable;
+  case CLOCK_FREE_RUN:
+    return this->free_run;
+  case CLOCK_SCR_DRIFT:
+    return this->scr_drift;
+  case CLOCK_SCR_JITTER:
+    return this->scr_jitter;
   }
   xprintf(this->xine, XINE_VERBOSITY_NONE, "unknown option in get_option: %d\n", option);
   return 0;
@@ -824,6 +902,19 @@ static scr_plugin_t* get_master_scr(metronom_clock_t *this) {
   return this->scr_list[select];
 }
 
+/* a slave may have been slewed off normal speed, don't keep that as master.
+ * fresh is a just registered SCR, that never was a slave. */
+static void metronom_update_master (metronom_clock_t *this, scr_plugin_t *fresh) {
+  scr_plugin_t *master;
+
+  pthread_mutex_lock (&this->lock);
+  master = get_master_scr(this);
+  if (master && master != this->scr_master && master != fresh && !this->stopped)
+    master->set_fine_speed (master, this->speed);
+  this->scr_master = master;
+  pthread_mutex_unlock (&this->lock);
+}
+
 static int metronom_register_scr (metronom_clock_t *this, scr_plugin_t *scr) {
   int i;
 
@@ -840,7 +931,7 @@ static int metronom_register_scr (metronom_clock_t *this, scr_plugin_t *scr) {
 
   scr->clock = this;
   this->scr_list[i] = scr;
-  this->scr_master = get_master_scr(this);
+  metronom_update_master (this, scr);
   return 0;
 }
 
@@ -863,36 +954,286 @@ static void metronom_unregister_scr (metronom_clock_t *this, scr_plugin_t *scr)
   for (i=0; i<MAX_SCR_PROVIDERS; i++)
     if (this->scr_list[i]) this->scr_list[i]->adjust(this->scr_list[i], time);
 
-  this->scr_master = get_master_scr(this);
+  metronom_update_master (this, NULL);
+}
+
+/*
+ * follow the master with a slave SCR. returns 1 if the slave was slewed
+ * (its drift estimate is valid), 0 if it was just set to the master.
+ * *coarse is set once the slave turns out not to run at fractional
+ * speeds (e.g. hardware clocks), it is only set to the master after that.
+ * called with this->lock held.
+ */
+static int metronom_sync_scr (metronom_clock_t *this, scr_plugin_t *scr,
+                              xine_clock_recovery_t *cr, int *coarse, int64_t pts) {
+  int64_t offset;
+  double  rate;
+  int     speed;
+
+  /* paused by stop_clock (), leave it that way */
+  if (this->stopped) {
+    cr->rate = 0;
+    _x_clock_recovery_reset (cr, 1);
+    return 0;
+  }
+
+  offset = scr->get_current (scr) - pts;
+
+  if (*coarse || this->free_run || this->speed != XINE_FINE_SPEED_NORMAL ||
+      llabs (offset) > SCR_SYNC_MAX_OFFSET) {
+    if (cr->rate != 0 && this->speed == XINE_FINE_SPEED_NORMAL)
+      scr->set_fine_speed (scr, this->speed);
+    cr->rate = 0;
+    scr->adjust (scr, pts);
+    _x_clock_recovery_reset (cr, 1);
+    return 0;
+  }
+
+  rate  = _x_clock_recovery_update (cr, pts, offset);
+  speed = XINE_FINE_SPEED_NORMAL - lrint (rate * XINE_FINE_SPEED_NORMAL);
+
+  /* set_speed () may have reset the speed meanwhile, so do it every time */
+  if (scr->set_fine_speed (scr, speed) != speed) {
+    xprintf (this->xine, XINE_VERBOSITY_DEBUG,
+             "metronom: scr with priority %d can't be slewed\n", scr->get_priority (scr));
+    *coarse = 1;
+    scr->set_fine_speed (scr, this->speed);
+    cr->rate = 0;
+    scr->adjust (scr, pts);
+    _x_clock_recovery_reset (cr, 1);
+    return 0;
+  }
+
+  return 1;
+}
+
+/* what the sync loop keeps from one pass to the next */
+typedef struct {
+  xine_task_t           task;   /* must be first, see metronom_sync_task_run() */
+  metronom_clock_t     *clock;
+
+  scr_plugin_t         *synced[MAX_SCR_PROVIDERS];
+  xine_clock_recovery_t sync[MAX_SCR_PROVIDERS];
+  int                   coarse[MAX_SCR_PROVIDERS];
+} metronom_sync_t;
+
+/* called with this->lock held */
+static void metronom_sync_step (metronom_clock_t *this, metronom_sync_t *s) {
+
+  int64_t               pts;
+  double                drift, jitter;
+  int                   i;
+
+  pts    = this->scr_master->get_current(this->scr_master);
+  drift  = 0;
+  jitter = 0;
+
+  for (i = 0; i < MAX_SCR_PROVIDERS; i++) {
+    scr_plugin_t *scr = this->scr_list[i];
+
+    if (scr != s->synced[i]) {
+      s->synced[i] = scr;
+      s->coarse[i] = 0;
+      _x_clock_recovery_init (&s->sync[i], SCR_SYNC_TAU, SCR_SYNC_PULL, SCR_SYNC_MAX_RATE);
+    }
+    if (!scr)
+      continue;
+    if (scr == this->scr_master) {
+      /* metronom_update_master () reset its speed */
+      s->sync[i].rate = 0;
+      _x_clock_recovery_reset (&s->sync[i], 1);
+      continue;
+    }
+
+    /* report the worst one */
+    if (metronom_sync_scr (this, scr, &s->sync[i], &s->coarse[i], pts) && fabs (s->sync[i].drift) >= fabs (drift)) {
+      drift  = s->sync[i].drift;
+      jitter = s->sync[i].jitter;
+    }
+  }
+
+  this->scr_drift  = lrint (drift * 1000000.0);
+  this->scr_jitter = lrint (jitter);
 }
 
 static void *metronom_sync_loop (void *const this_gen) {
   metronom_clock_t *const this = (metronom_clock_t *const)this_gen;
 
-  struct timeval tv;
-  struct timespec ts;
-  scr_plugin_t** scr;
-  int64_t        pts;
+  struct timeval        tv;
+  struct timespec       ts;
+  metronom_sync_t       s;
 
-  while (this->thread_running) {
-    /* synchronise every 5 seconds */
-    pthread_mutex_lock (&this->lock);
+  memset (&s, 0, sizeof (s));
 
-    pts = this->scr_master->get_current(this->scr_master);
+  pthread_mutex_lock (&this->lock);
 
-    for (scr = this->scr_list; scr < this->scr_list+MAX_SCR_PROVIDERS; scr++)
-      if (*scr && *scr != this->scr_master) (*scr)->adjust(*scr, pts);
+  while (this->thread_running) {
+
+    metronom_sync_step (this, &s);
 
     gettimeofday(&tv, NULL);
-    ts.tv_sec  = tv.tv_sec + 5;
+    ts.tv_sec  = tv.tv_sec + SCR_SYNC_INTERVAL;
     ts.tv_nsec = tv.tv_usec * 1000;
     pthread_cond_timedwait (&this->cancel, &this->lock, &ts);
-
-    pthread_mutex_unlock (&this->lock);
   }
+
+  pthread_mutex_unlock (&this->lock);
+
   return NULL;
 }
 
+/* the sync loop as a timer task on xine->executor */
+static void metronom_sync_task_run (xine_task_t *task) {
+  metronom_sync_t  *s    = (metronom_sync_t *) task;
+  metronom_clock_t *this = s->clock;
+
+  pthread_mutex_lock (&this->lock);
+  if (this->thread_running) {
+    metronom_sync_step (this, s);
+    _x_task_wake_after (task, SCR_SYNC_INTERVAL * 1000000);
+  }
+  pthread_mutex_unlock (&this->lock);
+}
+
+/*
+ * free-run clock
+ *
+ * every output loop is a client of the clock. a client waiting for vpts
+ * has something to present then; the clock jumps to the earliest vpts
+ * anyone waits for. clients that have nothing to present are idle and
+ * hold nobody up. a client whose wait was just served is busy with its
+ * frame and will tell what it waits for next soon; others give it
+ * FREE_RUN_GRACE for that before the clock moves on without it.
+ */
+
+int _x_clock_client_new (metronom_clock_t *this) {
+  int client;
+
+  pthread_mutex_lock (&this->lock);
+  for (client = 0; client < FREE_RUN_CLIENTS; client++)
+    if (!(this->free_run_clients & (1u << client)))
+      break;
+  if (client < FREE_RUN_CLIENTS) {
+    this->free_run_clients |= 1u << client;
+    this->free_run_waiting[client] = FREE_RUN_IDLE;
+  } else
+    client = -1;
+  pthread_mutex_unlock (&this->lock);
+
+  return client;
+}
+
+void _x_clock_client_free (metronom_clock_t *this, int client) {
+  if (client < 0)
+    return;
+  pthread_mutex_lock (&this->lock);
+  this->free_run_clients &= ~(1u << client);
+  pthread_cond_broadcast (&this->free_run_changed);
+  pthread_mutex_unlock (&this->lock);
+}
+
+void _x_clock_free_run_busy (metronom_clock_t *this, int client) {
+  if (client < 0 || !this->free_run)
+    return;
+  pthread_mutex_lock (&this->lock);
+  if (this->free_run_waiting[client] > this->free_run_vpts)
+    this->free_run_waiting[client] = this->free_run_vpts;
+  pthread_mutex_unlock (&this->lock);
+}
+
+void _x_clock_free_run_idle (metronom_clock_t *this, int client) {
+  if (client < 0 || !this->free_run)
+    return;
+  pthread_mutex_lock (&this->lock);
+  if (this->free_run_waiting[client] != FREE_RUN_IDLE) {
+    this->free_run_waiting[client] = FREE_RUN_IDLE;
+    pthread_cond_broadcast (&this->free_run_changed);
+  }
+  pthread_mutex_unlock (&this->lock);
+}
+
+static void add_usec (struct timespec *ts, const struct timeval *tv, int usec) {
+  ts->tv_sec  = tv->tv_sec + usec / 1000000;
+  ts->tv_nsec = (tv->tv_usec + usec % 1000000) * 1000;
+  if (ts->tv_nsec >= 1000000000) {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000;
+  }
+}
+
+int _x_clock_free_run_wait (metronom_clock_t *this, int client, int64_t vpts, int usec) {
+  struct timeval  tv;
+  struct timespec deadline, grace;
+  int             graced = 0, blocked = 0, ret;
+
+  if (!this->free_run)
+    return 0;
+
+  gettimeofday (&tv, NULL);
+  add_usec (&deadline, &tv, usec);
+  add_usec (&grace, &tv, usec < FREE_RUN_GRACE ? usec : FREE_RUN_GRACE);
+
+  pthread_mutex_lock (&this->lock);
+
+  if (client >= 0 && this->free_run_waiting[client] != vpts) {
+    this->free_run_waiting[client] = vpts;
+    pthread_cond_broadcast (&this->free_run_changed);
+  }
+
+  while (1) {
+    int busy = 0;
+
+    if (!this->free_run) {
+      ret = 0;
+      break;
+    }
+    if (this->free_run_vpts >= vpts) {
+      ret = 1;
+      break;
+    }
+
+    if (this->speed != XINE_SPEED_PAUSE) {
+      int64_t first = vpts;
+      int     i;
+
+      for (i = 0; i < FREE_RUN_CLIENTS; i++) {
+        int64_t other = this->free_run_waiting[i];
+        if (i == client || !(this->free_run_clients & (1u << i)) || other == FREE_RUN_IDLE)
+          continue;
+        if (other <= this->free_run_vpts)
+          busy = 1;
+        else if (other < first)
+          first = other;
+      }
+
+      if (first == vpts && (!busy || graced)) {
+        this->free_run_vpts = vpts;
+        pthread_cond_broadcast (&this->free_run_changed);
+        ret = 1;
+        break;
+      }
+    }
+
+    /* the other clients may be tasks, too */
+    if (!blocked) {
+      _x_executor_block_enter ();
+      blocked = 1;
+    }
+    if (busy && !graced) {
+      if (pthread_cond_timedwait (&this->free_run_changed, &this->lock, &grace) == ETIMEDOUT)
+        graced = 1;
+    } else if (pthread_cond_timedwait (&this->free_run_changed, &this->lock, &deadline) == ETIMEDOUT) {
+      ret = -1;
+      break;
+    }
+  }
+
+  pthread_mutex_unlock (&this->lock);
+  if (blocked)
+    _x_executor_block_leave ();
+  return ret;
+}
+
 static void metronom_exit (metronom_t *this) {
 
   pthread_mutex_destroy (&this->lock);
@@ -912,10 +1253,17 @@ static void metronom_clock_exit (metronom_clock_t *this) {
   pthread_cond_signal (&this->cancel);
   pthread_mutex_unlock (&this->lock);
 
-  pthread_join (this->sync_thread, NULL);
+  if (this->sync_task) {
+    _x_task_wake (this->sync_task);
+    _x_task_wait (this->sync_task);
+    free (this->sync_task);
+  } else {
+    pthread_join (this->sync_thread, NULL);
+  }
 
   pthread_mutex_destroy (&this->lock);
   pthread_cond_destroy (&this->cancel);
+  pthread_cond_destroy (&this->free_run_changed);
 
   for (scr = this->scr_list; scr < this->scr_list+MAX_SCR_PROVIDERS; scr++)
     if (*scr) (*scr)->exit(*scr);
@@ -998,13 +1346,27 @@ metronom_clock_t *_x_metronom_clock_init(xine_t *xine)
   this->xine                 = xine;
   this->scr_adjustable       = 1;
   this->scr_list             = calloc(MAX_SCR_PROVIDERS, sizeof(void*));
-  this->register_scr(this, unixscr_init());
 
   pthread_mutex_init (&this->lock, NULL);
   pthread_cond_init (&this->cancel, NULL);
+  pthread_cond_init (&this->free_run_changed, NULL);
+
+  this->register_scr(this, unixscr_init());
 
   this->thread_running       = 1;
 
+  /* run as a task on the shared engine threads */
+  if (xine->executor) {
+    metronom_sync_t *s = calloc (1, sizeof (metronom_sync_t));
+    if (s) {
+      _x_task_init (&s->task, xine->executor, metronom_sync_task_run);
+      s->clock        = this;
+      this->sync_task = &s->task;
+      _x_task_wake (this->sync_task);
+      return this;
+    }
+  }
+
   if ((err = pthread_create(&this->sync_thread, NULL,
 			    metronom_sync_loop, this)) != 0)
     xprintf(this->xine, XINE_VERBOSITY_NONE, "cannot create sync thread (%s)\n",
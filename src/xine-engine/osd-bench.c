@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2010 the xine-project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * osd-bench: the banded rle encoder of osd_show ().
+ *
+ * Paints random points, lines and rectangles on an osd object and shows
+ * it now and then, with a clear once in a while. Every shown overlay is
+ * compared with a fresh encode of the whole clipping box, and the area
+ * must be empty after each clear. Reported is the time per show for the
+ * bands and for encoding everything, and whether the rle differs (it
+ * must not). Build with "make osd-bench" in this directory.
+ */
+
+/* the renderer functions are static */
+#include "osd.c"
+
+#include <unistd.h>
+#include <sys/time.h>
+
+typedef struct {
+  video_overlay_manager_t  manager;
+  rle_elem_t              *rle;
+  int                      num_rle;
+  int                      shows;
+} bench_manager_t;
+
+typedef struct {
+  xine_video_port_t        port;
+  bench_manager_t          manager;
+} bench_port_t;
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static unsigned int next_rand (unsigned int *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+/* take over the rle of shown overlays, like video_overlay.c does */
+static int32_t bench_add_event (video_overlay_manager_t *this_gen, void *event_gen)
+{
+  bench_manager_t *this = (bench_manager_t *) this_gen;
+  video_overlay_event_t *event = (video_overlay_event_t *) event_gen;
+
+  if (event->event_type == OVERLAY_EVENT_SHOW) {
+    free (this->rle);
+    this->rle     = event->object.overlay->rle;
+    this->num_rle = event->object.overlay->num_rle;
+    event->object.overlay->rle = NULL;
+    this->shows++;
+  }
+  return 0;
+}
+
+static int32_t bench_get_handle (video_overlay_manager_t *this_gen, int object_type)
+{
+  return 1;
+}
+
+static video_overlay_manager_t *bench_get_overlay_manager (xine_video_port_t *port)
+{
+  return &((bench_port_t *) port)->manager.manager;
+}
+
+/* the clipping box, one line after the other */
+static int encode_all (osd_object_t *osd, rle_elem_t *rle)
+{
+  int x, y, n = 0;
+
+  for (y = osd->y1; y < osd->y2; y++) {
+    const uint8_t *c = osd->area + y * osd->width;
+
+    rle[n].len   = 1;
+    rle[n].color = c[osd->x1];
+    for (x = osd->x1 + 1; x < osd->x2; x++) {
+      if (c[x] == rle[n].color) {
+        rle[n].len++;
+      } else {
+        n++;
+        rle[n].len   = 1;
+        rle[n].color = c[x];
+      }
+    }
+    n++;
+  }
+  return n;
+}
+
+static int area_empty (osd_object_t *osd)
+{
+  int i;
+
+  for (i = 0; i < osd->width * osd->height; i++)
+    if (osd->area[i])
+      return 0;
+  return 1;
+}
+
+int main (int argc, char *argv[])
+{
+  int width = 720, height = 576, ops = 10000;
+  unsigned int seed = 1;
+  xine_t *xine;
+  xine_stream_t stream;
+  bench_port_t port;
+  bench_manager_t *manager = &port.manager;
+  osd_renderer_t *renderer;
+  osd_object_t *osd;
+  rle_elem_t *ref;
+  double t, t_bands = 0, t_all = 0;
+  int opt, i, checks = 0, same = 1, cleared = 1;
+
+  while ((opt = getopt (argc, argv, "w:h:n:s:")) != -1) {
+    switch (opt) {
+    case 'w':
+      width = atoi (optarg);
+      break;
+    case 'h':
+      height = atoi (optarg);
+      break;
+    case 'n':
+      ops = atoi (optarg);
+      break;
+    case 's':
+      seed = atoi (optarg);
+      break;
+    default:
+      fprintf (stderr, "\
+usage: %s [options]\n\
+options:\n\
+  -w WIDTH	osd width (default: 720)\n\
+  -h HEIGHT	osd height (default: 576)\n\
+  -n OPS	drawing operations (default: 10000)\n\
+  -s SEED	random seed (default: 1)\n", argv[0]);
+      return 1;
+    }
+  }
+  if (width < 16 || height < 16 || width > 4096 || height > 4096 || ops < 1) {
+    fputs ("osd-bench: invalid option\n", stderr);
+    return 1;
+  }
+
+  /* for the config, the fonts and the port ticket */
+  xine = xine_new ();
+  xine_set_flags (xine, XINE_FLAG_NO_WRITE_CACHE);
+  xine_init (xine);
+
+  /* just enough of a stream for osd_show () */
+  memset (&port, 0, sizeof (port));
+  port.port.get_overlay_manager = bench_get_overlay_manager;
+  manager->manager.add_event    = bench_add_event;
+  manager->manager.get_handle   = bench_get_handle;
+  memset (&stream, 0, sizeof (stream));
+  stream.xine      = xine;
+  stream.video_out = &port.port;
+
+  renderer = _x_osd_renderer_init (&stream);
+  osd = renderer->new_object (renderer, width, height);
+  ref = malloc (width * height * sizeof (rle_elem_t));
+  if (!osd || !ref) {
+    fputs ("osd-bench: out of memory\n", stderr);
+    return 1;
+  }
+
+  printf ("osd-bench: %dx%d osd, %d operations\n", width, height, ops);
+
+  for (i = 0; i < ops; i++) {
+    unsigned int op = next_rand (&seed) % 16;
+    int x1 = next_rand (&seed) % width;
+    int y1 = next_rand (&seed) % height;
+    int x2 = x1 + next_rand (&seed) % 128;
+    int y2 = y1 + next_rand (&seed) % 64;
+    int color = next_rand (&seed) % OVL_PALETTE_SIZE;
+
+    /* only points are clipped everywhere, rectangles at the right and
+     * at the bottom, lines starting outside are not reliable */
+    if (op < 6)
+      renderer->filled_rect (osd, x1, y1, x2, y2, color);
+    else if (op < 10)
+      renderer->line (osd, x1, y1, MIN (x2, width - 1), MIN (y2, height - 1), color);
+    else if (op < 14)
+      renderer->point (osd, x2 - 64, y2 - 32, color);
+    else if (op == 14 && next_rand (&seed) % 8 == 0) {
+      renderer->clear (osd);
+      cleared &= area_empty (osd);
+      continue;
+    }
+
+    if (op == 15 || next_rand (&seed) % 4 == 0) {
+      int num_rle;
+
+      t = now ();
+      renderer->show (osd, 0);
+      t_bands += now () - t;
+
+      if (!osd->area_touched || osd->x2 <= osd->x1 || osd->y2 <= osd->y1)
+        continue;
+
+      t = now ();
+      num_rle = encode_all (osd, ref);
+      t_all += now () - t;
+      checks++;
+
+      if (num_rle != manager->num_rle ||
+          memcmp (ref, manager->rle, num_rle * sizeof (rle_elem_t)))
+        same = 0;
+    }
+  }
+
+  if (checks) {
+    printf ("    bands    %8.2f us per show\n", t_bands * 1e6 / manager->shows);
+    printf ("    all      %8.2f us per show\n", t_all * 1e6 / checks);
+  }
+  printf ("osd-bench: %d shows, rle: %s, clear: %s\n", manager->shows,
+          same ? "same" : "DIFFERENT", cleared ? "empty" : "NOT EMPTY");
+
+  free (ref);
+  free (manager->rle);
+  renderer->free_object (osd);
+  renderer->close (renderer);
+  xine_exit (xine);
+
+  return same && cleared ? 0 : 1;
+}
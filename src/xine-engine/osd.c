@@ -209,16 +209,144 @@ struct osd_font_s {
   uint16_t         loaded;
 };
 
+#define OSD_BAND_LINES 16
+#define OSD_BAND_ALL   ((1 << OSD_BAND_LINES) - 1)
+
+struct osd_rle_band_s {
+  rle_elem_t *rle;
+  int         size;                      /* allocated rle objects */
+  int         row[OSD_BAND_LINES + 1];   /* first rle object of each line */
+  uint32_t    dirty;                     /* lines to be encoded again */
+  uint32_t    painted;                   /* lines painted on since last clear */
+};
+
 #ifdef HAVE_FT2
+/*
+ * rendered glyphs and shaped text are cached per font name and size,
+ * shared by all osd objects of a renderer using that font.
+ */
+#define OSD_GLYPH_BUCKETS  256
+#define OSD_GLYPH_MAX      1024  /* glyphs per cache */
+#define OSD_RUN_MAX        64    /* text runs per cache */
+#define OSD_FT2_CACHES     8     /* caches kept without users */
+
+typedef struct osd_glyph_s osd_glyph_t;
+
+struct osd_glyph_s {
+  osd_glyph_t *next;             /* hash chain */
+  FT_UInt      index;
+  unsigned     used;
+  int          left, top;        /* bitmap position relative to the pen */
+  int          advance;
+  int          width, rows;
+  uint8_t      bitmap[1];        /* 8 bit coverage, width x rows */
+};
+
+typedef struct {
+  uint32_t     hash;             /* 0 = unused */
+  unsigned     used;
+  char        *text;
+  char        *encoding;
+  int          num_glyphs;
+  FT_UInt     *index;
+  int         *pen;              /* glyph origins relative to the text start */
+  int          width;            /* see osd_get_text_size() */
+} osd_text_run_t;
+
+typedef struct osd_ft2cache_s {
+  struct osd_ft2cache_s *next;
+  char           *fontname;
+  int             size;
+  int             refs;
+  unsigned        stamp;
+  int             num_glyphs;
+  osd_glyph_t    *glyphs[OSD_GLYPH_BUCKETS];
+  osd_text_run_t  runs[OSD_RUN_MAX];
+  /* statistics */
+  unsigned        glyph_hits, glyph_misses;
+  unsigned        run_hits, run_misses;
+} osd_ft2cache_t;
+
 struct osd_ft2context_s {
   FT_Library library;
   FT_Face    face;
   int        size;
+  osd_ft2cache_t *cache;
 };
 
+static void osd_ft2cache_free (osd_renderer_t *this, osd_ft2cache_t *cache)
+{
+  int i;
+
+  xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG,
+          "osd: glyph cache %s/%d: %u hits, %u misses, text cache: %u hits, %u misses\n",
+          cache->fontname, cache->size, cache->glyph_hits, cache->glyph_misses,
+          cache->run_hits, cache->run_misses);
+
+  this->ft2stats.glyph_hits   += cache->glyph_hits;
+  this->ft2stats.glyph_misses += cache->glyph_misses;
+  this->ft2stats.text_hits    += cache->run_hits;
+  this->ft2stats.text_misses  += cache->run_misses;
+
+  for (i = 0; i < OSD_GLYPH_BUCKETS; i++) {
+    while (cache->glyphs[i]) {
+      osd_glyph_t *g = cache->glyphs[i];
+      cache->glyphs[i] = g->next;
+      free(g);
+    }
+  }
+  for (i = 0; i < OSD_RUN_MAX; i++) {
+    free(cache->runs[i].text);
+    free(cache->runs[i].encoding);
+    free(cache->runs[i].index);
+    free(cache->runs[i].pen);
+  }
+  free(cache->fontname);
+  free(cache);
+}
+
+/*
+ * find or create the cache for a font, called with osd_mutex held
+ */
+static osd_ft2cache_t *osd_ft2cache_ref (osd_renderer_t *this, const char *fontname, int size)
+{
+  osd_ft2cache_t *cache, **prev;
+  int unused = 0;
+
+  for (cache = this->ft2caches; cache; cache = cache->next) {
+    if (cache->size == size && !strcmp(cache->fontname, fontname)) {
+      cache->refs++;
+      return cache;
+    }
+  }
+
+  /* drop caches nobody uses any more */
+  prev = &this->ft2caches;
+  while ((cache = *prev)) {
+    if (!cache->refs && ++unused >= OSD_FT2_CACHES) {
+      *prev = cache->next;
+      osd_ft2cache_free(this, cache);
+    } else
+      prev = &cache->next;
+  }
+
+  cache = calloc(1, sizeof(osd_ft2cache_t));
+  if (!cache)
+    return NULL;
+  cache->fontname = strdup(fontname);
+  cache->size = size;
+  cache->refs = 1;
+  cache->next = this->ft2caches;
+  this->ft2caches = cache;
+
+  return cache;
+}
+
 static void osd_free_ft2 (osd_object_t *osd)
 {
   if( osd->ft2 ) {
+    if ( osd->ft2->cache )
+      osd->ft2->cache->refs--;
     if ( osd->ft2->face )
       FT_Done_Face (osd->ft2->face);
     if ( osd->ft2->library )
@@ -261,6 +389,8 @@ static osd_object_t *XINE_MALLOC osd_new_object (osd_renderer_t *this, int width
   osd->height = height;
   osd->area = calloc(width, height);
   osd->area_touched = 0;
+  /* without them, osd_show () falls back to encoding everything */
+  osd->rle_bands = calloc((height + OSD_BAND_LINES - 1) / OSD_BAND_LINES + 1, sizeof(osd_rle_band_t));
 
   osd->x1 = width;
   osd->y1 = height;
@@ -320,9 +450,27 @@ static argb_layer_t *argb_layer_create() {
 static void argb_layer_destroy(argb_layer_t *argb_layer) {
 
   pthread_mutex_destroy(&argb_layer->mutex);
+  free(argb_layer->tile_serial);
   free(argb_layer);
 }
 
+/* tile serials are compared across layers (a new layer may reuse the
+ * memory of a freed one), so they come from a single counter */
+static uint32_t argb_layer_next_serial(void) {
+
+  static pthread_mutex_t serial_mutex = PTHREAD_MUTEX_INITIALIZER;
+  static uint32_t serial;
+  uint32_t ret;
+
+  pthread_mutex_lock(&serial_mutex);
+  if (!++serial)
+    ++serial;
+  ret = serial;
+  pthread_mutex_unlock(&serial_mutex);
+
+  return ret;
+}
+
 void set_argb_layer_ptr(argb_layer_t **dst, argb_layer_t *src) {
 
   if (src) {
@@ -347,8 +495,117 @@ void set_argb_layer_ptr(argb_layer_t **dst, argb_layer_t *src) {
 
 
 /*
-#define DEBUG_RLE
-*/
+ * lines y1 to y2 - 1 of the work area have been painted on
+ */
+static void osd_touch (osd_object_t *osd, int y1, int y2) {
+  int band;
+
+  osd->area_touched = 1;
+
+  /* no bands (out of memory), osd_show () encodes it all */
+  if (!osd->rle_bands)
+    return;
+
+  if (y1 < 0)
+    y1 = 0;
+  if (y2 > osd->height)
+    y2 = osd->height;
+  for (band = y1 / OSD_BAND_LINES; band * OSD_BAND_LINES < y2; band++) {
+    int first = MAX(y1 - band * OSD_BAND_LINES, 0);
+    int last  = MIN(y2 - band * OSD_BAND_LINES, OSD_BAND_LINES);
+    uint32_t lines = (OSD_BAND_ALL >> (OSD_BAND_LINES - last)) & ~((1 << first) - 1);
+
+    osd->rle_bands[band].dirty   |= lines;
+    osd->rle_bands[band].painted |= lines;
+  }
+}
+
+/*
+ * rle encode the columns rle_x1 to rle_x2 - 1 of a line,
+ * returns the number of rle objects
+ */
+static int osd_encode_line (osd_object_t *osd, int y, rle_elem_t *rle_p) {
+  rle_elem_t rle, *start = rle_p;
+  uint8_t *c = osd->area + y * osd->width + osd->rle_x1;
+  int x, width = osd->rle_x2 - osd->rle_x1;
+
+  /* initialize a rle object with the first pixel's color */
+  rle.len = 1;
+  rle.color = *c++;
+
+  /* loop over the remaining pixels in the line */
+  for( x = 1; x < width; x++, c++ ) {
+    if( rle.color != *c ) {
+      *rle_p++ = rle;
+      rle.color = *c;
+      rle.len = 1;
+    } else {
+      rle.len++;
+    }
+  }
+  *rle_p++ = rle;
+
+  return rle_p - start;
+}
+
+/*
+ * rle encode the dirty lines of a band, the others are kept
+ */
+static int osd_encode_band (osd_object_t *osd, int band_num) {
+  osd_rle_band_t *band = &osd->rle_bands[band_num];
+  int y = band_num * OSD_BAND_LINES;
+  int lines = MIN(OSD_BAND_LINES, osd->height - y);
+  uint32_t all = OSD_BAND_ALL >> (OSD_BAND_LINES - lines);
+  int width = osd->rle_x2 - osd->rle_x1;
+  int i, n = 0;
+
+  if ((band->dirty & all) == all) {
+    for (i = 0; i < lines; i++) {
+      /* there will never be more rle objects than columns in a line */
+      if (band->size < n + width) {
+        int size = MAX(2 * band->size, n + width);
+        rle_elem_t *tmp = realloc(band->rle, size * sizeof(rle_elem_t));
+        if (!tmp)
+          return 0;
+        band->rle = tmp;
+        band->size = size;
+      }
+      band->row[i] = n;
+      n += osd_encode_line(osd, y + i, band->rle + n);
+    }
+  } else {
+    /* splice new lines between the unchanged ones */
+    int size = band->row[lines];
+    rle_elem_t *rle;
+
+    for (i = 0; i < lines; i++)
+      if (band->dirty & (1 << i))
+        size += width;
+    rle = malloc(size * sizeof(rle_elem_t));
+    if (!rle)
+      return 0;
+
+    for (i = 0; i < lines; i++) {
+      int old = band->row[i];
+      int len = band->row[i + 1] - old;
+
+      band->row[i] = n;
+      if (band->dirty & (1 << i)) {
+        n += osd_encode_line(osd, y + i, rle + n);
+      } else {
+        memcpy(rle + n, band->rle + old, len * sizeof(rle_elem_t));
+        n += len;
+      }
+    }
+    free(band->rle);
+    band->rle = rle;
+    band->size = size;
+  }
+  band->row[lines] = n;
+  band->dirty = 0;
+
+  return 1;
+}
 
 static int _osd_hide (osd_object_t *osd, int64_t vpts);
 
@@ -360,9 +617,8 @@ static int _osd_show (osd_object_t *osd, int64_t vpts, int unscaled ) {
 
   osd_renderer_t *this = osd->renderer;
   video_overlay_manager_t *ovl_manager;
-  rle_elem_t rle, *rle_p=0;
-  int x, y;
-  uint8_t *c;
+  rle_elem_t *rle, *rle_p;
+  int band, first, last, num_rle, y;
 
   lprintf("osd=%p vpts=%"PRId64"\n", osd, vpts);
 
@@ -393,10 +649,6 @@ static int _osd_show (osd_object_t *osd, int64_t vpts, int unscaled ) {
   if(osd->y1 < 0) osd->y1 = 0;
   if(osd->y2 < 0) osd->y2 = 0;
 
-#ifdef DEBUG_RLE
-  lprintf("osd_show %p rle starts\n", osd);
-#endif
-
   /* check if osd is valid (something drawn on it) */
   if( osd->x2 > osd->x1 && osd->y2 > osd->y1 ) {
 
@@ -404,6 +656,12 @@ static int _osd_show (osd_object_t *osd, int64_t vpts, int unscaled ) {
 
     memset( this->event.object.overlay, 0, sizeof(*this->event.object.overlay) );
 
+    if (osd->argb_layer) {
+      pthread_mutex_lock(&osd->argb_layer->mutex);
+      osd->argb_layer->ovl_x = osd->x1;
+      osd->argb_layer->ovl_y = osd->y1;
+      pthread_mutex_unlock(&osd->argb_layer->mutex);
+    }
     set_argb_layer_ptr(&this->event.object.overlay->argb_layer, osd->argb_layer);
 
     this->event.object.overlay->unscaled = unscaled;
@@ -425,54 +683,66 @@ static int _osd_show (osd_object_t *osd, int64_t vpts, int unscaled ) {
     this->event.object.overlay->hili_left   = 0;
     this->event.object.overlay->hili_right  = this->event.object.overlay->width;
 
-    /* there will be at least that many rle objects (one for each row) */
     this->event.object.overlay->num_rle = 0;
-    if (!osd->area_touched) {
-      /* avoid rle encoding when only argb_layer is modified */
-      this->event.object.overlay->data_size = 0;
-      rle_p = this->event.object.overlay->rle = NULL;
-    } else {
-      /* We will never need more rle objects than columns in any row
-         Rely on lazy page allocation to avoid us actually taking up
-         this much RAM */
-      this->event.object.overlay->data_size = osd->width * osd->height;
-      rle_p = this->event.object.overlay->rle =
-         malloc(this->event.object.overlay->data_size * sizeof(rle_elem_t) );
-
-      for( y = osd->y1; y < osd->y2; y++ ) {
-#ifdef DEBUG_RLE
-        lprintf("osd_show %p y = %d: ", osd, y);
-#endif
-        c = osd->area + y * osd->width + osd->x1;
+    this->event.object.overlay->data_size = 0;
+    this->event.object.overlay->rle = NULL;
+
+    /* avoid rle encoding when only argb_layer is modified */
+    if (osd->area_touched) {
+
+      rle = NULL;
+      num_rle = 0;
+
+      if (!osd->rle_bands) {
+        /* no bands (out of memory), encode it all */
+        osd->rle_x1 = osd->x1;
+        osd->rle_x2 = osd->x2;
+        rle = malloc((osd->y2 - osd->y1) * (osd->x2 - osd->x1) * sizeof(rle_elem_t));
+        if (rle) {
+          for (y = osd->y1; y < osd->y2; y++)
+            num_rle += osd_encode_line(osd, y, rle + num_rle);
+        }
+      } else {
 
-        /* initialize a rle object with the first pixel's color */
-        rle.len = 1;
-        rle.color = *c++;
+        /* band contents depend on the encoded columns */
+        if (osd->rle_x1 != osd->x1 || osd->rle_x2 != osd->x2) {
+          osd->rle_x1 = osd->x1;
+          osd->rle_x2 = osd->x2;
+          for (band = 0; band * OSD_BAND_LINES < osd->height; band++)
+            osd->rle_bands[band].dirty = OSD_BAND_ALL;
+        }
 
-        /* loop over the remaining pixels in the row */
-        for( x = osd->x1 + rle.len; x < osd->x2; x++, c++ ) {
-          if( rle.color != *c ) {
-#ifdef DEBUG_RLE
-            lprintf("(%d, %d), ", rle.len, rle.color);
-#endif
-            *rle_p++ = rle;
-            this->event.object.overlay->num_rle++;
+        first = osd->y1 / OSD_BAND_LINES;
+        last  = (osd->y2 - 1) / OSD_BAND_LINES;
 
-            rle.color = *c;
-            rle.len = 1;
-          } else {
-            rle.len++;
-          }
+        for (band = first; band <= last; band++) {
+          osd_rle_band_t *b = &osd->rle_bands[band];
+          int y1 = MAX(osd->y1 - band * OSD_BAND_LINES, 0);
+          int y2 = MIN(osd->y2 - band * OSD_BAND_LINES, OSD_BAND_LINES);
+
+          if (b->dirty && !osd_encode_band(osd, band))
+            break;
+          num_rle += b->row[y2] - b->row[y1];
+        }
+
+        if (band > last)
+          rle = malloc(num_rle * sizeof(rle_elem_t));
+
+        for (rle_p = rle, band = first; rle_p && band <= last; band++) {
+          osd_rle_band_t *b = &osd->rle_bands[band];
+          int y1 = MAX(osd->y1 - band * OSD_BAND_LINES, 0);
+          int y2 = MIN(osd->y2 - band * OSD_BAND_LINES, OSD_BAND_LINES);
+
+          memcpy(rle_p, b->rle + b->row[y1], (b->row[y2] - b->row[y1]) * sizeof(rle_elem_t));
+          rle_p += b->row[y2] - b->row[y1];
         }
-#ifdef DEBUG_RLE
-        lprintf("(%d, %d)\n", rle.len, rle.color);
-#endif
-        *rle_p++ = rle;
-        this->event.object.overlay->num_rle++;
       }
-#ifdef DEBUG_RLE
-      lprintf("osd_show %p rle ends\n", osd);
-#endif
+
+      if (rle) {
+        this->event.object.overlay->rle = rle;
+        this->event.object.overlay->data_size = num_rle;
+        this->event.object.overlay->num_rle = num_rle;
+      }
       lprintf("num_rle = %d\n", this->event.object.overlay->num_rle);
 
       memcpy(this->event.object.overlay->hili_color, osd->color, sizeof(osd->color));
@@ -563,11 +833,29 @@ static int osd_hide (osd_object_t *osd, int64_t vpts) {
  */
 
 static void osd_clear (osd_object_t *osd) {
+  int i;
+
   lprintf("osd=%p\n",osd);
 
   if (osd->area_touched) {
     osd->area_touched = 0;
-    memset(osd->area, 0, osd->width * osd->height);
+    if (!osd->rle_x2 || !osd->rle_bands) {
+      /* painted on directly, see osd.h */
+      memset(osd->area, 0, osd->width * osd->height);
+    } else {
+      for (i = 0; i * OSD_BAND_LINES < osd->height; i++) {
+        uint32_t painted = osd->rle_bands[i].painted;
+        int y;
+        for (y = 0; painted; y++, painted >>= 1)
+          if (painted & 1)
+            memset(osd->area + (i * OSD_BAND_LINES + y) * osd->width, 0, osd->width);
+      }
+    }
+  }
+
+  for (i = 0; osd->rle_bands && i * OSD_BAND_LINES < osd->height; i++) {
+    osd->rle_bands[i].dirty |= osd->rle_bands[i].painted;
+    osd->rle_bands[i].painted = 0;
   }
 
   osd->x1 = osd->width;
@@ -604,7 +892,7 @@ static void osd_point (osd_object_t *osd, int x, int y, int color) {
   osd->x2 = MAX(osd->x2, (x + 1));
   osd->y1 = MIN(osd->y1, y);
   osd->y2 = MAX(osd->y2, (y + 1));
-  osd->area_touched = 1;
+  osd_touch(osd, y, y + 1);
 
   c = osd->area + y * osd->width + x;
   *c = color;
@@ -664,7 +952,7 @@ static void osd_line (osd_object_t *osd,
   osd->x2 = MAX( osd->x2, x2 );
   osd->y1 = MIN( osd->y1, y1 );
   osd->y2 = MAX( osd->y2, y2 );
-  osd->area_touched = 1;
+  osd_touch(osd, y1, y2 + 1);
 
   dx = x2 - x1;
   dy = y2 - y1;
@@ -778,7 +1066,7 @@ static void osd_filled_rect (osd_object_t *osd,
   osd->x2 = MAX( osd->x2, dx );
   osd->y1 = MIN( osd->y1, y );
   osd->y2 = MAX( osd->y2, dy );
-  osd->area_touched = 1;
+  osd_touch(osd, y, dy);
 
   dx -= x;
   dy -= y;
@@ -1118,6 +1406,10 @@ static int osd_set_font_freetype2( osd_object_t *osd, const char *fontname, int
       FT_Done_Face (osd->ft2->face);
       osd->ft2->face = NULL;
   }
+  if (osd->ft2->cache) {
+    osd->ft2->cache->refs--;
+    osd->ft2->cache = NULL;
+  }
 
   do { /* while 0 */
 #ifdef HAVE_FONTCONFIG
@@ -1138,6 +1430,12 @@ static int osd_set_font_freetype2( osd_object_t *osd, const char *fontname, int
     return 0;
   }
 
+  osd->ft2->cache = osd_ft2cache_ref(osd->renderer, fontname, size);
+  if (!osd->ft2->cache) {
+    osd_free_ft2 (osd);
+    return 0;
+  }
+
   osd->ft2->size = size;
   return 1;
 }
@@ -1329,6 +1627,258 @@ static int osd_set_encoding (osd_object_t *osd, const char *encoding) {
 
 #define FONT_OVERLAP 1/10  /* overlap between consecutive characters */
 
+#ifdef HAVE_FT2
+/*
+ * get a rendered glyph from the font cache, called with osd_mutex held
+ */
+static osd_glyph_t *osd_ft2_get_glyph (osd_object_t *osd, FT_UInt index)
+{
+  osd_ft2cache_t *cache = osd->ft2->cache;
+  osd_glyph_t *g, **chain = &cache->glyphs[index % OSD_GLYPH_BUCKETS];
+  FT_GlyphSlot slot = osd->ft2->face->glyph;
+  int x, y;
+
+  for (g = *chain; g; g = g->next) {
+    if (g->index == index) {
+      cache->glyph_hits++;
+      g->used = ++cache->stamp;
+      return g;
+    }
+  }
+  cache->glyph_misses++;
+
+  if (FT_Load_Glyph(osd->ft2->face, index, FT_LOAD_FLAGS)) {
+    xprintf(osd->renderer->stream->xine, XINE_VERBOSITY_LOG, _("osd: error loading glyph\n"));
+    return NULL;
+  }
+
+  if (slot->format != ft_glyph_format_bitmap) {
+    if (FT_Render_Glyph(slot, ft_render_mode_normal))
+      xprintf(osd->renderer->stream->xine, XINE_VERBOSITY_LOG, _("osd: error in rendering glyph\n"));
+  }
+
+  /* drop the least recently used glyph */
+  if (cache->num_glyphs >= OSD_GLYPH_MAX) {
+    osd_glyph_t **oldest = NULL;
+    int i;
+
+    for (i = 0; i < OSD_GLYPH_BUCKETS; i++) {
+      osd_glyph_t **prev;
+      for (prev = &cache->glyphs[i]; *prev; prev = &(*prev)->next)
+        if (!oldest || (*prev)->used < (*oldest)->used)
+          oldest = prev;
+    }
+    g = *oldest;
+    *oldest = g->next;
+    free(g);
+    cache->num_glyphs--;
+  }
+
+  g = malloc(sizeof(osd_glyph_t) + slot->bitmap.width * slot->bitmap.rows);
+  if (!g)
+    return NULL;
+
+  g->index   = index;
+  g->used    = ++cache->stamp;
+  g->left    = slot->bitmap_left;
+  g->top     = slot->bitmap_top;
+  g->advance = slot->advance.x / 64;
+  g->width   = slot->bitmap.width;
+  g->rows    = slot->bitmap.rows;
+
+  for (y = 0; y < g->rows; y++) {
+    const uint8_t *src = (const uint8_t *)slot->bitmap.buffer + y * slot->bitmap.pitch;
+    uint8_t *dst = g->bitmap + y * g->width;
+    if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+      for (x = 0; x < g->width; x++)
+        dst[x] = (src[x >> 3] & (0x80 >> (x & 7))) ? 0xff : 0;
+    } else
+      memcpy(dst, src, g->width);
+  }
+
+  g->next = *chain;
+  *chain = g;
+  cache->num_glyphs++;
+
+  return g;
+}
+
+/*
+ * get glyph indices and positions of a text in the current encoding,
+ * called with osd_mutex held
+ */
+static osd_text_run_t *osd_ft2_get_run (osd_object_t *osd, const char *text)
+{
+  osd_ft2cache_t *cache = osd->ft2->cache;
+  osd_text_run_t *run = NULL;
+  const char *encoding = NULL;
+  const char *inbuf;
+  size_t inbytesleft;
+  uint32_t hash = 5381;
+  FT_Bool use_kerning = FT_HAS_KERNING(osd->ft2->face);
+  FT_UInt previous = 0;
+  int i, pen, first = 1, last_left = 0, last_width = 0, last_advance = 0;
+
+#ifdef HAVE_ICONV
+  encoding = osd->encoding;
+#endif
+
+  for (inbuf = text; *inbuf; inbuf++)
+    hash = hash * 33 + (uint8_t)*inbuf;
+  if (encoding)
+    for (inbuf = encoding; *inbuf; inbuf++)
+      hash = hash * 33 + (uint8_t)*inbuf;
+  if (!hash)
+    hash = 1;
+
+  for (i = 0; i < OSD_RUN_MAX; i++) {
+    osd_text_run_t *r = &cache->runs[i];
+    if (r->hash == hash && !strcmp(r->text, text) &&
+        (encoding ? (r->encoding && !strcmp(r->encoding, encoding)) : !r->encoding)) {
+      cache->run_hits++;
+      r->used = ++cache->stamp;
+      return r;
+    }
+    if (!run || r->used < run->used)
+      run = r;
+  }
+  cache->run_misses++;
+
+  /* reuse the least recently used slot */
+  run->hash = 0;
+  free(run->text);
+  free(run->encoding);
+  free(run->index);
+  free(run->pen);
+  run->text       = strdup(text);
+  run->encoding   = encoding ? strdup(encoding) : NULL;
+  inbytesleft     = strlen(text);
+  /* every character takes at least one byte */
+  run->index      = malloc((inbytesleft + 1) * sizeof(FT_UInt));
+  run->pen        = malloc((inbytesleft + 1) * sizeof(int));
+  run->num_glyphs = 0;
+  if (!run->text || (encoding && !run->encoding) || !run->index || !run->pen) {
+    run->used = 0;
+    return NULL;
+  }
+
+  inbuf = text;
+  pen = 0;
+
+  while (inbytesleft) {
+    osd_glyph_t *g;
+    uint16_t unicode;
+
+#ifdef HAVE_ICONV
+    unicode = osd_iconv_getunicode(osd->renderer->stream->xine, osd->cd, osd->encoding,
+                                   (ICONV_CONST char **)&inbuf, &inbytesleft);
+#else
+    unicode = inbuf[0];
+    inbuf++;
+    inbytesleft--;
+#endif
+
+    i = FT_Get_Char_Index(osd->ft2->face, unicode);
+
+    /* add kerning relative to the previous letter */
+    if (use_kerning && previous && i) {
+      FT_Vector delta;
+      FT_Get_Kerning(osd->ft2->face, previous, i, KERNING_DEFAULT, &delta);
+      pen += delta.x / 64;
+    }
+    previous = i;
+
+    g = osd_ft2_get_glyph(osd, i);
+    if (!g)
+      continue;
+
+    /* if the first letter has a bearing not on the basepoint shift, the
+     * whole output to be sure that we are inside the bounding box
+     */
+    if (first) pen -= g->left;
+    first = 0;
+
+    run->index[run->num_glyphs] = i;
+    run->pen[run->num_glyphs++] = pen;
+    pen += g->advance;
+
+    last_left    = g->left;
+    last_width   = g->width;
+    last_advance = g->advance;
+  }
+
+  /* for the last letter we must not use advance but the real width of the
+   * bitmap, including its left bearing
+   */
+  run->width = pen;
+  if (last_width)
+    run->width -= last_advance;
+  run->width += last_width + last_left;
+
+  run->hash = hash;
+  run->used = ++cache->stamp;
+
+  return run;
+}
+
+static void osd_ft2_render_text (osd_object_t *osd, int x1, int y1,
+                                 const char *text, int color_base,
+                                 int *top, int *bottom)
+{
+  osd_text_run_t *run = osd_ft2_get_run(osd, text);
+  int ascender = osd->ft2->face->size->metrics.ascender / 64;
+  int height = osd->ft2->face->size->metrics.height / 64;
+  int n, y;
+
+  if (!run)
+    return;
+
+  for (n = 0; n < run->num_glyphs; n++) {
+    osd_glyph_t *g = osd_ft2_get_glyph(osd, run->index[n]);
+    int x = x1 + run->pen[n];
+    uint8_t *dst;
+    const uint8_t *src;
+
+    if (!g)
+      continue;
+
+    /* we shift the whole glyph down by it's ascender so that the specified
+     * coordinate is the top left corner which is much more practical than
+     * the baseline as the user normally has no idea where the baseline is
+     */
+    y = y1 + ascender - g->top;
+    *top = MIN(*top, y);
+    *bottom = MAX(*bottom, y + g->rows);
+
+    dst = osd->area + y * osd->width;
+    src = g->bitmap;
+
+    for (y = 0; y < g->rows; y++) {
+      const uint8_t *s = src;
+      uint8_t *d = dst + x + g->left;
+
+      if (d >= osd->area + osd->width*osd->height)
+        break;
+
+      if (dst > osd->area)
+        while (s < src + g->width) {
+          if ((d >= dst) && (d < dst + osd->width) && *s)
+            *d = (uint8_t)(*s/25) + (uint8_t) color_base;
+
+          d++;
+          s++;
+        }
+
+      src += g->width;
+      dst += osd->width;
+    }
+
+    if( x + g->advance > osd->x2 ) osd->x2 = x + g->advance;
+    if( y1 + height > osd->y2 ) osd->y2 = y1 + height;
+  }
+}
+#endif
+
 /*
  * render text in current encoding on x,y position
  *  no \n yet
@@ -1339,17 +1889,12 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
   osd_renderer_t *this = osd->renderer;
   osd_font_t *font;
   int i, y;
+  int top = osd->height, bottom = 0;
   uint8_t *dst, *src;
   const char *inbuf;
   uint16_t unicode;
   size_t inbytesleft;
 
-#ifdef HAVE_FT2
-  FT_UInt previous = 0;
-  FT_Bool use_kerning = osd->ft2 && FT_HAS_KERNING(osd->ft2->face);
-  int first = 1;
-#endif
-
   lprintf("osd=%p (%d,%d) \"%s\"\n", osd, x1, y1, text);
 
   /* some sanity checks for the color indices */
@@ -1379,85 +1924,23 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
   if( y1 < osd->y1 ) osd->y1 = y1;
   osd->area_touched = 1;
 
-  inbuf = text;
-  inbytesleft = strlen(text);
+#ifdef HAVE_FT2
+  if (osd->ft2)
+    osd_ft2_render_text(osd, x1, y1, text, color_base, &top, &bottom);
+  else
+#endif
+  {
+    inbuf = text;
+    inbytesleft = strlen(text);
 
-  while( inbytesleft ) {
+    while( inbytesleft ) {
 #ifdef HAVE_ICONV
-    unicode = osd_iconv_getunicode(this->stream->xine, osd->cd, osd->encoding,
-                                   (ICONV_CONST char **)&inbuf, &inbytesleft);
+      unicode = osd_iconv_getunicode(this->stream->xine, osd->cd, osd->encoding,
+                                     (ICONV_CONST char **)&inbuf, &inbytesleft);
 #else
-    unicode = inbuf[0];
-    inbuf++;
-    inbytesleft--;
-#endif
-
-
-#ifdef HAVE_FT2
-    if (osd->ft2) {
-
-      FT_GlyphSlot slot = osd->ft2->face->glyph;
-
-      i = FT_Get_Char_Index( osd->ft2->face, unicode );
-
-      /* add kerning relative to the previous letter */
-      if (use_kerning && previous && i) {
-        FT_Vector delta;
-        FT_Get_Kerning(osd->ft2->face, previous, i, KERNING_DEFAULT, &delta);
-        x1 += delta.x / 64;
-      }
-      previous = i;
-
-      if (FT_Load_Glyph(osd->ft2->face, i, FT_LOAD_FLAGS)) {
-        xprintf(this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error loading glyph\n"));
-        continue;
-      }
-
-      if (slot->format != ft_glyph_format_bitmap) {
-        if (FT_Render_Glyph(slot, ft_render_mode_normal))
-          xprintf(this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error in rendering glyph\n"));
-      }
-
-      /* if the first letter has a bearing not on the basepoint shift, the
-       * whole output to be sure that we are inside the bounding box
-       */
-      if (first) x1 -= slot->bitmap_left;
-      first = 0;
-
-      /* we shift the whole glyph down by it's ascender so that the specified
-       * coordinate is the top left corner which is much more practical than
-       * the baseline as the user normally has no idea where the baseline is
-       */
-      dst = osd->area + (y1 + osd->ft2->face->size->metrics.ascender/64 - slot->bitmap_top) * osd->width;
-      src = (uint8_t*) slot->bitmap.buffer;
-
-      for (y = 0; y < slot->bitmap.rows; y++) {
-        uint8_t *s = src;
-        uint8_t *d = dst + x1 + slot->bitmap_left;
-
-        if (d >= osd->area + osd->width*osd->height)
-          break;
-
-        if (dst > osd->area)
-          while (s < src + slot->bitmap.width) {
-            if ((d >= dst) && (d < dst + osd->width) && *s)
-              *d = (uint8_t)(*s/25) + (uint8_t) color_base;
-
-            d++;
-            s++;
-          }
-
-        src += slot->bitmap.pitch;
-        dst += osd->width;
-
-      }
-
-      x1 += slot->advance.x / 64;
-      if( x1 > osd->x2 ) osd->x2 = x1;
-      if( y1 + osd->ft2->face->size->metrics.height/64 > osd->y2 ) osd->y2 = y1 + osd->ft2->face->size->metrics.height/64;
-
-    } else {
-
+      unicode = inbuf[0];
+      inbuf++;
+      inbytesleft--;
 #endif
 
       i = osd_search(font->fontchar, font->num_fontchars, unicode);
@@ -1467,6 +1950,9 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
              font->fontchar[i].height, x1, y1);
 
       if ( i != font->num_fontchars ) {
+        top = MIN(top, y1);
+        bottom = MAX(bottom, y1 + font->fontchar[i].height);
+
         dst = osd->area + y1 * osd->width;
         src = font->fontchar[i].bmp;
 
@@ -1494,13 +1980,12 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
         if( y1 + font->fontchar[i].height > osd->y2 )
           osd->y2 = y1 + font->fontchar[i].height;
       }
-
-#ifdef HAVE_FT2
-    } /* !(osd->ft2) */
-#endif
-
+    }
   }
 
+  if (top < bottom)
+    osd_touch(osd, top, bottom);
+
   pthread_mutex_unlock (&this->osd_mutex);
 
   return 1;
@@ -1518,13 +2003,6 @@ static int osd_get_text_size(osd_object_t *osd, const char *text, int *width, in
   uint16_t unicode;
   size_t inbytesleft;
 
-#ifdef HAVE_FT2
-  /* not all free type fonts provide kerning */
-  FT_Bool use_kerning = osd->ft2 && FT_HAS_KERNING(osd->ft2->face);
-  FT_UInt previous = 0;
-  int first_glyph = 1;
-#endif
-
   lprintf("osd=%p \"%s\"\n", osd, text);
 
   pthread_mutex_lock (&this->osd_mutex);
@@ -1547,52 +2025,29 @@ static int osd_get_text_size(osd_object_t *osd, const char *text, int *width, in
   *width = 0;
   *height = 0;
 
-  inbuf = text;
-  inbytesleft = strlen(text);
+#ifdef HAVE_FT2
+  if (osd->ft2) {
+    osd_text_run_t *run = osd_ft2_get_run(osd, text);
+
+    if (run)
+      *width = run->width;
+    *height = osd->ft2->face->size->metrics.height / 64;
+  } else
+#endif
+  {
+    inbuf = text;
+    inbytesleft = strlen(text);
 
-  while( inbytesleft ) {
+    while( inbytesleft ) {
 #ifdef HAVE_ICONV
-    unicode = osd_iconv_getunicode(this->stream->xine, osd->cd, osd->encoding,
-                                   (ICONV_CONST char **)&inbuf, &inbytesleft);
+      unicode = osd_iconv_getunicode(this->stream->xine, osd->cd, osd->encoding,
+                                     (ICONV_CONST char **)&inbuf, &inbytesleft);
 #else
-    unicode = inbuf[0];
-    inbuf++;
-    inbytesleft--;
+      unicode = inbuf[0];
+      inbuf++;
+      inbytesleft--;
 #endif
 
-#ifdef HAVE_FT2
-    if (osd->ft2) {
-      FT_GlyphSlot  slot = osd->ft2->face->glyph;
-
-      i = FT_Get_Char_Index( osd->ft2->face, unicode);
-
-      /* kerning add the relative to the previous letter */
-      if (use_kerning && previous && i) {
-        FT_Vector delta;
-        FT_Get_Kerning(osd->ft2->face, previous, i, KERNING_DEFAULT, &delta);
-        *width += delta.x / 64;
-      }
-      previous = i;
-
-      if (FT_Load_Glyph(osd->ft2->face, i, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING)) {
-        xprintf(this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error loading glyph %i\n"), i);
-        text++;
-        continue;
-      }
-
-      if (slot->format != ft_glyph_format_bitmap) {
-        if (FT_Render_Glyph(osd->ft2->face->glyph, ft_render_mode_normal))
-          xprintf(this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error in rendering\n"));
-      }
-      /* left shows the left edge relative to the base point. A positive value means the
-       * letter is shifted right, so we need to subtract the value from the width
-       */
-      if (first_glyph) *width -= slot->bitmap_left;
-      first_glyph = 0;
-      *width += slot->advance.x / 64;
-      text++;
-    } else {
-#endif
       i = osd_search(font->fontchar, font->num_fontchars, unicode);
 
       if ( i != font->num_fontchars ) {
@@ -1600,28 +2055,8 @@ static int osd_get_text_size(osd_object_t *osd, const char *text, int *width, in
           *height = font->fontchar[i].height;
         *width += font->fontchar[i].width - (font->fontchar[i].width * FONT_OVERLAP);
       }
-#ifdef HAVE_FT2
-    } /* !(osd->ft2) */
-#endif
-  }
-
-#ifdef HAVE_FT2
-  if (osd->ft2) {
-    /* if we have a true type font we need to do some corrections for the last
-     * letter. As this one is still in the gylph slot we can still work with
-     * it. For the last letter be must not use advance and width but the real
-     * width of the bitmap. We're right from the base point so we subtract the
-     * advance value that was added in the for-loop and add the width. We have
-     * to also add the left bearing because the letter might be shifted left or
-     * right and then the right edge is also shifted
-     */
-    if (osd->ft2->face->glyph->bitmap.width)
-        *width -= osd->ft2->face->glyph->advance.x / 64;
-    *width += osd->ft2->face->glyph->bitmap.width;
-    *width += osd->ft2->face->glyph->bitmap_left;
-    *height = osd->ft2->face->size->metrics.height / 64;
+    }
   }
-#endif
 
   pthread_mutex_unlock (&this->osd_mutex);
 
@@ -1683,6 +2118,7 @@ static void osd_free_object (osd_object_t *osd_to_close) {
   osd_renderer_t *this = osd_to_close->renderer;
   video_overlay_manager_t *ovl_manager;
   osd_object_t *osd, *last;
+  int i;
 
   if( osd_to_close->handle >= 0 ) {
     osd_hide(osd_to_close,0);
@@ -1715,6 +2151,9 @@ static void osd_free_object (osd_object_t *osd_to_close) {
   while( osd ) {
     if ( osd == osd_to_close ) {
       free( osd->area );
+      for (i = 0; osd->rle_bands && i * OSD_BAND_LINES < osd->height; i++)
+        free( osd->rle_bands[i].rle );
+      free( osd->rle_bands );
 
       osd_free_ft2 (osd);
       osd_free_encoding(osd);
@@ -1733,6 +2172,25 @@ static void osd_free_object (osd_object_t *osd_to_close) {
   pthread_mutex_unlock (&this->osd_mutex);
 }
 
+static void osd_get_cache_stats (osd_renderer_t *this, osd_cache_stats_t *stats) {
+#ifdef HAVE_FT2
+  osd_ft2cache_t *cache;
+#endif
+
+  pthread_mutex_lock (&this->osd_mutex);
+  *stats = this->ft2stats;
+#ifdef HAVE_FT2
+  for (cache = this->ft2caches; cache; cache = cache->next) {
+    stats->glyph_hits   += cache->glyph_hits;
+    stats->glyph_misses += cache->glyph_misses;
+    stats->text_hits    += cache->run_hits;
+    stats->text_misses  += cache->run_misses;
+    stats->glyphs       += cache->num_glyphs;
+  }
+#endif
+  pthread_mutex_unlock (&this->osd_mutex);
+}
+
 static void osd_renderer_close (osd_renderer_t *this) {
 
   while( this->osds )
@@ -1741,6 +2199,14 @@ static void osd_renderer_close (osd_renderer_t *this) {
   while( this->fonts )
     osd_renderer_unload_font( this, this->fonts->name );
 
+#ifdef HAVE_FT2
+  while( this->ft2caches ) {
+    osd_ft2cache_t *cache = this->ft2caches;
+    this->ft2caches = cache->next;
+    osd_ft2cache_free( this, cache );
+  }
+#endif
+
   pthread_mutex_destroy (&this->osd_mutex);
 
   free(this->event.object.overlay);
@@ -1769,7 +2235,7 @@ static void osd_draw_bitmap(osd_object_t *osd, uint8_t *bitmap,
   osd->x2 = MAX( osd->x2, x1+width );
   osd->y1 = MIN( osd->y1, y1 );
   osd->y2 = MAX( osd->y2, y1+height );
-  osd->area_touched = 1;
+  osd_touch(osd, y1, y1 + height);
 
   for( y=0; y<height; y++ ) {
     if ( palette_map ) {
@@ -1817,6 +2283,28 @@ static void osd_set_argb_buffer(osd_object_t *osd, uint32_t *argb_buffer,
 
   osd->argb_layer->buffer = argb_buffer;
 
+  /* tile change tracking */
+  if (!osd->argb_layer->tile_serial) {
+    osd->argb_layer->width  = osd->width;
+    osd->argb_layer->height = osd->height;
+    osd->argb_layer->tile_serial = calloc(
+      ((osd->width + ARGB_TILE_SIZE - 1) / ARGB_TILE_SIZE) * ((osd->height + ARGB_TILE_SIZE - 1) / ARGB_TILE_SIZE),
+      sizeof(uint32_t));
+  }
+  osd->argb_layer->serial = argb_layer_next_serial();
+  if (osd->argb_layer->tile_serial) {
+    int tiles_x = (osd->width + ARGB_TILE_SIZE - 1) / ARGB_TILE_SIZE;
+    int tx1 = MAX(dirty_x, 0) / ARGB_TILE_SIZE;
+    int ty1 = MAX(dirty_y, 0) / ARGB_TILE_SIZE;
+    int tx2 = (MIN(dirty_x + dirty_width, osd->width) + ARGB_TILE_SIZE - 1) / ARGB_TILE_SIZE;
+    int ty2 = (MIN(dirty_y + dirty_height, osd->height) + ARGB_TILE_SIZE - 1) / ARGB_TILE_SIZE;
+    int tx, ty;
+
+    for (ty = ty1; ty < ty2; ty++)
+      for (tx = tx1; tx < tx2; tx++)
+        osd->argb_layer->tile_serial[ty * tiles_x + tx] = osd->argb_layer->serial;
+  }
+
   pthread_mutex_unlock(&osd->argb_layer->mutex);
 }
 
@@ -1920,6 +2408,7 @@ osd_renderer_t *_x_osd_renderer_init( xine_stream_t *stream ) {
   this->get_capabilities   = osd_get_capabilities;
   this->set_extent         = osd_set_extent;
   this->set_video_window   = osd_set_video_window;
+  this->get_cache_stats    = osd_get_cache_stats;
 
   return this;
 }
@@ -43,6 +43,9 @@
 
 #define SPU_SLEEP_INTERVAL (90000/2)
 
+/* buffers a decoder task handles before giving other streams a turn */
+#define TASK_BATCH 16
+
 #ifndef SCHED_OTHER
 #define SCHED_OTHER 0
 #endif
@@ -70,6 +73,13 @@ int _x_spu_decoder_sleep(xine_stream_t *stream, int64_t next_spu_vpts)
   int64_t time, wait;
   int thread_vacant = 1;
 
+  /* shared decoder threads are never vacant */
+  if (stream->video_decoder_task) {
+    if (stream->xine->port_ticket->ticket_revoked)
+      stream->xine->port_ticket->renew(stream->xine->port_ticket, 0);
+    return 0;
+  }
+
   /* we wait until one second before the next SPU is due */
   next_spu_vpts -= 90000;
 
@@ -109,43 +119,64 @@ static void video_decoder_update_disable_flush_at_discontinuity(void *disable_de
   *(int *)disable_decoder_flush_at_discontinuity = entry->num_value;
 }
 
-static void *video_decoder_loop (void *stream_gen) {
-
-  buf_element_t   *buf;
-  xine_stream_t   *stream = (xine_stream_t *) stream_gen;
-  xine_ticket_t   *running_ticket = stream->xine->port_ticket;
-  int              running = 1;
-  int              streamtype;
-  int              prof_video_decode = -1;
-  int              prof_spu_decode = -1;
-  uint32_t         buftype_unknown = 0;
+/*
+ * decoder state that lives as long as the decoder thread, or the task
+ * when running on the shared decoder threads
+ */
+typedef struct {
+  xine_task_t      task;   /* must be first, see video_decoder_task_run() */
+  xine_stream_t   *stream;
+  int              running;
+  int              batch;
+  uint32_t         buftype_unknown;
   int              disable_decoder_flush_at_discontinuity;
+} video_decoder_state_t;
 
-#ifndef WIN32
-  errno = 0;
-  if (nice(-1) == -1 && errno)
-    xine_log(stream->xine, XINE_LOG_MSG, "video_decoder: can't raise nice priority by 1: %s\n", strerror(errno));
-#endif /* WIN32 */
+static void video_decoder_state_init (video_decoder_state_t *this, xine_stream_t *stream) {
 
-  if (prof_video_decode == -1)
-    prof_video_decode = xine_profiler_allocate_slot ("video decoder");
-  if (prof_spu_decode == -1)
-    prof_spu_decode = xine_profiler_allocate_slot ("spu decoder");
+  this->stream            = stream;
+  this->running           = 1;
+  this->buftype_unknown   = 0;
 
-  disable_decoder_flush_at_discontinuity = stream->xine->config->register_bool(stream->xine->config, "engine.decoder.disable_flush_at_discontinuity", 0,
+  this->disable_decoder_flush_at_discontinuity = stream->xine->config->register_bool(stream->xine->config, "engine.decoder.disable_flush_at_discontinuity", 0,
       _("disable decoder flush at discontinuity"),
       _("when watching live tv a discontinuity happens for example about every 26.5 hours due to a pts wrap.\n"
         "flushing the decoder at that time causes decoding errors for images after the pts wrap.\n"
         "to avoid the decoding errors, decoder flush at discontinuity should be disabled.\n\n"
         "WARNING: as the flush was introduced to fix some issues when playing DVD still images, it is\n"
         "likely that these issues may reappear in case they haven't been fixed differently meanwhile.\n"),
-        20, video_decoder_update_disable_flush_at_discontinuity, &disable_decoder_flush_at_discontinuity);
+        20, video_decoder_update_disable_flush_at_discontinuity, &this->disable_decoder_flush_at_discontinuity);
+}
 
-  while (running) {
+static xine_tracepoint_t tp_video_decode = XINE_TRACEPOINT ("video_decoder.decode");
+static xine_tracepoint_t tp_spu_decode   = XINE_TRACEPOINT ("spu_decoder.decode");
+
+/*
+ * handles buffers until BUF_CONTROL_QUIT. as a task, returns early
+ * when the fifo is empty or the batch is used up.
+ */
+static void video_decoder_run (video_decoder_state_t *this) {
+
+  buf_element_t   *buf;
+  xine_stream_t   *stream = this->stream;
+  xine_ticket_t   *running_ticket = stream->xine->port_ticket;
+  int              streamtype;
+  uint64_t         t;
+
+  while (this->running) {
 
     lprintf ("getting buffer...\n");
 
-    buf = stream->video_fifo->get (stream->video_fifo);
+    if (this->task.executor) {
+      if (!this->batch--) {
+        _x_task_wake (&this->task);
+        break;
+      }
+      buf = _x_fifo_buffer_try_get (stream->video_fifo);
+      if (!buf)
+        break;
+    } else
+      buf = stream->video_fifo->get (stream->video_fifo);
 
     _x_extra_info_merge( stream->video_decoder_extra_info, buf->extra_info );
     stream->video_decoder_extra_info->seek_count = stream->video_seek_count;
@@ -182,7 +213,7 @@ static void *video_decoder_loop (void *stream_gen) {
         stream->metronom->handle_video_discontinuity (stream->metronom,
 						      DISC_STREAMSTART, 0);
 
-      buftype_unknown = 0;
+      this->buftype_unknown = 0;
       break;
 
     case BUF_CONTROL_SPU_CHANNEL:
@@ -226,6 +257,7 @@ static void *video_decoder_loop (void *stream_gen) {
        * 3) slave stream: don't wait. get into an unblocked state asap to allow
        *    new master actions.
        */
+      _x_executor_block_enter ();
       while(1) {
         int num_bufs, num_streams;
 
@@ -251,6 +283,8 @@ static void *video_decoder_loop (void *stream_gen) {
 	       stream->finished_count_video);
 
       pthread_cond_broadcast (&stream->counter_changed);
+      if (stream->demux_task)
+        _x_task_wake (stream->demux_task);
 
       if (stream->audio_thread_created) {
 
@@ -266,6 +300,7 @@ static void *video_decoder_loop (void *stream_gen) {
       }
 
       pthread_mutex_unlock (&stream->counter_lock);
+      _x_executor_block_leave ();
 
       /* Wake up xine_play if it's waiting for a frame */
       pthread_mutex_lock (&stream->first_frame_lock);
@@ -291,7 +326,7 @@ static void *video_decoder_loop (void *stream_gen) {
       }
 
       running_ticket->release(running_ticket, 0);
-      running = 0;
+      this->running = 0;
       break;
 
     case BUF_CONTROL_RESET_DECODER:
@@ -324,7 +359,7 @@ static void *video_decoder_loop (void *stream_gen) {
         stream->video_decoder_plugin->discontinuity (stream->video_decoder_plugin);
         /* it might be a long time before we get back from a handle_video_discontinuity,
 	 * so we better flush the decoder before */
-        if (!disable_decoder_flush_at_discontinuity)
+        if (!this->disable_decoder_flush_at_discontinuity)
           stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
         running_ticket->release(running_ticket, 0);
       }
@@ -341,7 +376,7 @@ static void *video_decoder_loop (void *stream_gen) {
         stream->video_decoder_plugin->discontinuity (stream->video_decoder_plugin);
         /* it might be a long time before we get back from a handle_video_discontinuity,
 	 * so we better flush the decoder before */
-        if (!disable_decoder_flush_at_discontinuity)
+        if (!this->disable_decoder_flush_at_discontinuity)
           stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
         running_ticket->release(running_ticket, 0);
       }
@@ -386,7 +421,7 @@ static void *video_decoder_loop (void *stream_gen) {
         if (_x_stream_info_get(stream, XINE_STREAM_INFO_IGNORE_VIDEO))
           break;
 
-        xine_profiler_start_count (prof_video_decode);
+        t = xine_tp_start ();
 
         running_ticket->acquire(running_ticket, 0);
 
@@ -397,7 +432,7 @@ static void *video_decoder_loop (void *stream_gen) {
 
 	streamtype = (buf->type>>16) & 0xFF;
 
-        if( buf->type != buftype_unknown &&
+        if( buf->type != this->buftype_unknown &&
             (stream->video_decoder_streamtype != streamtype ||
             !stream->video_decoder_plugin) ) {
 
@@ -414,7 +449,7 @@ static void *video_decoder_loop (void *stream_gen) {
         if (stream->video_decoder_plugin)
           stream->video_decoder_plugin->decode_data (stream->video_decoder_plugin, buf);
 
-        if (buf->type != buftype_unknown &&
+        if (buf->type != this->buftype_unknown &&
             !_x_stream_info_get(stream, XINE_STREAM_INFO_VIDEO_HANDLED)) {
           xine_log (stream->xine, XINE_LOG_MSG,
                     _("video_decoder: no plugin available to handle '%s'\n"), _x_buf_video_name( buf->type ) );
@@ -422,7 +457,7 @@ static void *video_decoder_loop (void *stream_gen) {
           if( !_x_meta_info_get(stream, XINE_META_INFO_VIDEOCODEC))
 	    _x_meta_info_set_utf8(stream, XINE_META_INFO_VIDEOCODEC, _x_buf_video_name( buf->type ));
 
-          buftype_unknown = buf->type;
+          this->buftype_unknown = buf->type;
 
           /* fatal error - dispose plugin */
           if (stream->video_decoder_plugin) {
@@ -435,7 +470,7 @@ static void *video_decoder_loop (void *stream_gen) {
           running_ticket->renew(running_ticket, 0);
         running_ticket->release(running_ticket, 0);
 
-        xine_profiler_stop_count (prof_video_decode);
+        xine_tp_stop (tp_video_decode, t);
 
       } else if ( (buf->type & 0xFF000000) == BUF_SPU_BASE ) {
 
@@ -444,7 +479,7 @@ static void *video_decoder_loop (void *stream_gen) {
         if (_x_stream_info_get(stream, XINE_STREAM_INFO_IGNORE_SPU))
           break;
 
-        xine_profiler_start_count (prof_spu_decode);
+        t = xine_tp_start ();
 
         running_ticket->acquire(running_ticket, 0);
 
@@ -492,12 +527,12 @@ static void *video_decoder_loop (void *stream_gen) {
           running_ticket->renew(running_ticket, 0);
         running_ticket->release(running_ticket, 0);
 
-        xine_profiler_stop_count (prof_spu_decode);
+        xine_tp_stop (tp_spu_decode, t);
 
-      } else if (buf->type != buftype_unknown) {
+      } else if (buf->type != this->buftype_unknown) {
 	xine_log (stream->xine, XINE_LOG_MSG,
 		  _("video_decoder: error, unknown buffer type: %08x\n"), buf->type );
-	buftype_unknown = buf->type;
+	this->buftype_unknown = buf->type;
       }
 
       break;
@@ -506,10 +541,34 @@ static void *video_decoder_loop (void *stream_gen) {
 
     buf->free_buffer (buf);
   }
+}
+
+static void *video_decoder_loop (void *stream_gen) {
+
+  xine_stream_t         *stream = (xine_stream_t *) stream_gen;
+  video_decoder_state_t  state;
+
+#ifndef WIN32
+  errno = 0;
+  if (nice(-1) == -1 && errno)
+    xine_log(stream->xine, XINE_LOG_MSG, "video_decoder: can't raise nice priority by 1: %s\n", strerror(errno));
+#endif /* WIN32 */
+
+  memset (&state, 0, sizeof (state));
+  video_decoder_state_init (&state, stream);
+  video_decoder_run (&state);
 
   return NULL;
 }
 
+static void video_decoder_task_run (xine_task_t *task) {
+
+  video_decoder_state_t *this = (video_decoder_state_t *) task;
+
+  this->batch = TASK_BATCH;
+  video_decoder_run (this);
+}
+
 int _x_video_decoder_init (xine_stream_t *stream) {
 
   if (stream->video_out == NULL) {
@@ -549,6 +608,23 @@ int _x_video_decoder_init (xine_stream_t *stream) {
 
     stream->spu_track_map_entries = 0;
 
+    /* run as a task on the shared decoder threads */
+    if (stream->xine->executor) {
+      video_decoder_state_t *state = calloc (1, sizeof (video_decoder_state_t));
+      if (!state) {
+        stream->video_fifo->dispose (stream->video_fifo);
+        stream->video_fifo = NULL;
+        return 0;
+      }
+      video_decoder_state_init (state, stream);
+      _x_task_init (&state->task, stream->xine->executor, video_decoder_task_run);
+      stream->video_decoder_task   = &state->task;
+      /* the decoder is there, other stages test this */
+      stream->video_thread_created = 1;
+      _x_fifo_buffer_set_task (stream->video_fifo, stream->video_decoder_task);
+      return 1;
+    }
+
     pthread_attr_init(&pth_attrs);
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
     pthread_attr_getschedparam(&pth_attrs, &pth_params);
@@ -592,7 +668,13 @@ void _x_video_decoder_shutdown (xine_stream_t *stream) {
 
     lprintf ("shutdown...3\n");
 
-    pthread_join (stream->video_thread, &p);
+    if (stream->video_decoder_task) {
+      _x_task_wait (stream->video_decoder_task);
+      _x_fifo_buffer_set_task (stream->video_fifo, NULL);
+      free (stream->video_decoder_task);
+      stream->video_decoder_task = NULL;
+    } else
+      pthread_join (stream->video_thread, &p);
     stream->video_thread_created = 0;
 
     lprintf ("shutdown...4\n");
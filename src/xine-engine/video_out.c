@@ -26,6 +26,7 @@
 
 #include <signal.h>
 #include <sys/time.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -50,6 +51,7 @@
 #include <xine/metronom.h>
 #include <xine/xineutils.h>
 #include <yuv2rgb.h>
+#include "xine_private.h"
 
 #define NUM_FRAME_BUFFERS          15
 #define MAX_USEC_TO_SLEEP       20000
@@ -159,8 +161,26 @@ typedef struct {
   pthread_mutex_t           trigger_drawing_mutex;
   pthread_cond_t            trigger_drawing_cond;
   int                       trigger_drawing;
+
+  /* see _x_clock_free_run_wait() */
+  int                       clock_client;
+
+  /* output loop state, see video_out_step() */
+  xine_task_t               task;          /* instead of video_thread on xine->executor */
+  uint32_t                  loop_waiting:1;
+  uint32_t                  loop_paused:1;
+  int64_t                   next_frame_vpts;
+  int                       starved;
+  int                       disable_decoder_flush_from_video_out;
 } vos_t;
 
+static xine_tracepoint_t tp_get_frame_wait = XINE_TRACEPOINT ("video_out.get_frame.wait");
+static xine_tracepoint_t tp_frame_draw     = XINE_TRACEPOINT ("video_out.frame_draw");
+static xine_tracepoint_t tp_skipped        = XINE_TRACEPOINT ("video_out.skipped");
+static xine_tracepoint_t tp_discarded      = XINE_TRACEPOINT ("video_out.discarded");
+static xine_tracepoint_t tp_overlay        = XINE_TRACEPOINT ("video_out.overlay");
+static xine_tracepoint_t tp_display        = XINE_TRACEPOINT ("video_out.display");
+
 
 /*
  * frame queue (fifo) util functions
@@ -216,6 +236,7 @@ static void vo_append_to_img_buf_queue (img_buf_fifo_t *queue,
   pthread_mutex_unlock (&queue->mutex);
 }
 
+/* blocking: 1 waits for a frame, 0 up to 1 second, -1 not at all */
 static vo_frame_t *vo_remove_from_img_buf_queue_int (img_buf_fifo_t *queue, int blocking,
                                                      uint32_t width, uint32_t height,
                                                      double ratio, int format,
@@ -245,7 +266,7 @@ static vo_frame_t *vo_remove_from_img_buf_queue_int (img_buf_fifo_t *queue, int
 
       if( width && height ) {
         if( !img ) {
-          if( queue->num_buffers == 1 && !blocking && queue->num_buffers_max > 8) {
+          if( queue->num_buffers == 1 && blocking <= 0 && queue->num_buffers_max > 8) {
             /* non-blocking and only a single frame on fifo with different
              * format -> ignore it (give another chance of a frame format hit)
              * only if we have a lot of buffers at all.
@@ -267,8 +288,10 @@ static vo_frame_t *vo_remove_from_img_buf_queue_int (img_buf_fifo_t *queue, int
 #endif
 
     if(!img) {
-      if (blocking)
+      if (blocking > 0)
         pthread_cond_wait (&queue->not_empty, &queue->mutex);
+      else if (blocking < 0)
+        return NULL;
       else {
         struct timeval tv;
         struct timespec ts;
@@ -313,14 +336,14 @@ static vo_frame_t *vo_remove_from_img_buf_queue (img_buf_fifo_t *queue) {
   return img;
 }
 
-static vo_frame_t *vo_remove_from_img_buf_queue_nonblock (img_buf_fifo_t *queue,
+static vo_frame_t *vo_remove_from_img_buf_queue_nonblock (img_buf_fifo_t *queue, int blocking,
                                                           uint32_t width, uint32_t height,
                                                           double ratio, int format,
                                                           int flags) {
   vo_frame_t *img;
 
   pthread_mutex_lock (&queue->mutex);
-  img = vo_remove_from_img_buf_queue_int(queue, 0, width, height, ratio, format, flags);
+  img = vo_remove_from_img_buf_queue_int(queue, blocking, width, height, ratio, format, flags);
   pthread_mutex_unlock (&queue->mutex);
 
   return img;
@@ -696,10 +719,19 @@ static vo_frame_t *vo_get_frame (xine_video_port_t *this_gen,
 
   lprintf ("get_frame (%d x %d)\n", width, height);
 
-  while (!(img = vo_remove_from_img_buf_queue_nonblock (this->free_img_buf_queue,
-                 width, height, ratio, format, flags)))
-    if (this->xine->port_ticket->ticket_revoked)
-      this->xine->port_ticket->renew(this->xine->port_ticket, 1);
+  img = vo_remove_from_img_buf_queue_nonblock (this->free_img_buf_queue, -1,
+                 width, height, ratio, format, flags);
+  if (!img) {
+    uint64_t t = xine_tp_start ();
+    _x_executor_block_enter ();
+    do {
+      if (this->xine->port_ticket->ticket_revoked)
+        this->xine->port_ticket->renew(this->xine->port_ticket, 1);
+    } while (!(img = vo_remove_from_img_buf_queue_nonblock (this->free_img_buf_queue, 0,
+                 width, height, ratio, format, flags)));
+    _x_executor_block_leave ();
+    xine_tp_stop (tp_get_frame_wait, t);
+  }
 
   lprintf ("got a frame -> pthread_mutex_lock (&img->mutex)\n");
 
@@ -750,6 +782,8 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *stream) {
   int            frames_to_skip;
   int            duration;
 
+  xine_tp_hit (tp_frame_draw, 1);
+
   /* handle anonymous streams like NULL for easy checking */
   if (stream == XINE_ANON_STREAM) stream = NULL;
 
@@ -760,6 +794,7 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *stream) {
   if (stream) {
     _x_refcounter_inc(stream->refcounter);
     _x_extra_info_merge( img->extra_info, stream->video_decoder_extra_info );
+    _x_latency_stamp (img->extra_info, XINE_LATENCY_DECODED);
     stream->metronom->got_video_frame (stream->metronom, img);
   }
   this->current_duration = img->duration;
@@ -826,6 +861,10 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *stream) {
       }
     }
 
+    /* a free running clock waits for us */
+    if (frames_to_skip && this->clock->get_option (this->clock, CLOCK_FREE_RUN))
+      frames_to_skip = 0;
+
     lprintf ("delivery diff : %" PRId64 ", current vpts is %" PRId64 ", %d frames to skip\n",
 	     diff, cur_vpts, frames_to_skip);
 
@@ -921,6 +960,7 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *stream) {
     }
 
     this->num_frames_skipped++;
+    xine_tp_hit (tp_skipped, 1);
   }
 
   /*
@@ -1103,6 +1143,10 @@ static void expire_frames (vos_t *this, int64_t cur_vpts) {
   int64_t       diff;
   vo_frame_t   *img;
   int           duration;
+  int           free_run;
+
+  /* late frames are shown late, never dropped */
+  free_run = this->clock->get_option (this->clock, CLOCK_FREE_RUN);
 
   pthread_mutex_lock(&this->display_img_buf_queue->mutex);
 
@@ -1150,13 +1194,14 @@ static void expire_frames (vos_t *this, int64_t cur_vpts) {
     pts = img->vpts;
     diff = cur_vpts - pts;
 
-    if (diff > duration || this->discard_frames) {
+    if ((diff > duration && !free_run) || this->discard_frames) {
 
       if( !this->discard_frames ) {
         xine_log(this->xine, XINE_LOG_MSG,
 	         _("video_out: throwing away image with pts %" PRId64 " because it's too old (diff : %" PRId64 ").\n"), pts, diff);
 
         this->num_frames_discarded++;
+        xine_tp_hit (tp_discarded, 1);
       }
 
       img = vo_remove_from_img_buf_queue_int (this->display_img_buf_queue, 1, 0, 0, 0, 0, 0);
@@ -1363,15 +1408,24 @@ static void overlay_and_display_frame (vos_t *this,
   }
 
   if (this->overlay_source) {
+    uint64_t t = xine_tp_start ();
     this->overlay_source->multiple_overlay_blend (this->overlay_source,
 						  vpts,
 						  this->driver, img,
 						  this->video_loop_running && this->overlay_enabled);
+    xine_tp_stop (tp_overlay, t);
   }
 
   vo_grab_current_frame (this, img, vpts);
 
-  this->driver->display_frame (this->driver, img);
+  if (img->stream)
+    _x_latency_record (img->stream, XINE_LATENCY_VIDEO, img->extra_info);
+
+  {
+    uint64_t t = xine_tp_start ();
+    this->driver->display_frame (this->driver, img);
+    xine_tp_stop (tp_display, t);
+  }
 
   /*
    * Wake up xine_play if it's waiting for a frame
@@ -1435,57 +1489,85 @@ static int interruptable_sleep(vos_t *this, int usec_to_sleep)
 /* special loop for paused mode
  * needed to update screen due overlay changes, resize, window
  * movement, brightness adjusting etc.
+ * video_out_step() runs one pass every 20ms until the clock goes on.
  */
-static void paused_loop( vos_t *this, int64_t vpts )
+static void paused_loop_enter (vos_t *this)
 {
-  vo_frame_t   *img;
-
   pthread_mutex_lock( &this->free_img_buf_queue->mutex );
   /* prevent decoder thread from allocating new frames */
   this->free_img_buf_queue->locked_for_read = 1;
+  pthread_mutex_unlock( &this->free_img_buf_queue->mutex );
 
-  while (this->clock->speed == XINE_SPEED_PAUSE && this->video_loop_running) {
+  this->loop_paused = 1;
+}
 
-    /* we need at least one free frame to keep going */
-    if( this->display_img_buf_queue->first &&
-       !this->free_img_buf_queue->first ) {
+static void paused_loop (vos_t *this, int64_t vpts)
+{
+  vo_frame_t   *img;
 
-      img = vo_remove_from_img_buf_queue (this->display_img_buf_queue);
-      img->next = NULL;
-      this->free_img_buf_queue->first = img;
-      this->free_img_buf_queue->last  = img;
-      this->free_img_buf_queue->num_buffers = 1;
-    }
+  pthread_mutex_lock( &this->free_img_buf_queue->mutex );
 
-    /* set img_backup to play the same frame several times */
-    if( this->display_img_buf_queue->first && !this->img_backup ) {
-      this->img_backup = vo_remove_from_img_buf_queue (this->display_img_buf_queue);
-      this->redraw_needed = 1;
-    }
+  /* we need at least one free frame to keep going */
+  if( this->display_img_buf_queue->first &&
+     !this->free_img_buf_queue->first ) {
 
-    check_redraw_needed( this, vpts );
+    img = vo_remove_from_img_buf_queue (this->display_img_buf_queue);
+    img->next = NULL;
+    this->free_img_buf_queue->first = img;
+    this->free_img_buf_queue->last  = img;
+    this->free_img_buf_queue->num_buffers = 1;
+  }
 
-    if( this->redraw_needed && this->img_backup ) {
-      img = duplicate_frame (this, this->img_backup );
-      if( img ) {
-        /* extra info of the backup is thrown away, because it is not up to date */
-        _x_extra_info_reset(img->extra_info);
-        pthread_mutex_unlock( &this->free_img_buf_queue->mutex );
-        overlay_and_display_frame (this, img, vpts);
-        pthread_mutex_lock( &this->free_img_buf_queue->mutex );
-      }
-    }
+  /* set img_backup to play the same frame several times */
+  if( this->display_img_buf_queue->first && !this->img_backup ) {
+    this->img_backup = vo_remove_from_img_buf_queue (this->display_img_buf_queue);
+    this->redraw_needed = 1;
+  }
 
-    pthread_mutex_unlock( &this->free_img_buf_queue->mutex );
-    interruptable_sleep(this, 20000);
-    pthread_mutex_lock( &this->free_img_buf_queue->mutex );
+  check_redraw_needed( this, vpts );
+
+  if( this->redraw_needed && this->img_backup ) {
+    img = duplicate_frame (this, this->img_backup );
+    if( img ) {
+      /* extra info of the backup is thrown away, because it is not up to date */
+      _x_extra_info_reset(img->extra_info);
+      pthread_mutex_unlock( &this->free_img_buf_queue->mutex );
+      overlay_and_display_frame (this, img, vpts);
+      pthread_mutex_lock( &this->free_img_buf_queue->mutex );
+    }
   }
 
+  pthread_mutex_unlock( &this->free_img_buf_queue->mutex );
+}
+
+static void paused_loop_leave (vos_t *this)
+{
+  pthread_mutex_lock( &this->free_img_buf_queue->mutex );
   this->free_img_buf_queue->locked_for_read = 0;
 
   if( this->free_img_buf_queue->first )
     pthread_cond_signal (&this->free_img_buf_queue->not_empty);
   pthread_mutex_unlock( &this->free_img_buf_queue->mutex );
+
+  this->loop_paused = 0;
+}
+
+/* free-run: will the decoders deliver frames soon? */
+static int vo_frames_pending (vos_t *this) {
+  xine_list_iterator_t ite;
+  int                  pending = 0;
+
+  pthread_mutex_lock (&this->streams_lock);
+  for (ite = xine_list_front (this->streams); ite && !pending;
+       ite = xine_list_next (this->streams, ite)) {
+    xine_stream_t *stream = xine_list_get_value (this->streams, ite);
+    if (stream == XINE_ANON_STREAM) continue;
+    if (stream->video_fifo && stream->video_fifo->fifo_size > 0)
+      pending = 1;
+  }
+  pthread_mutex_unlock (&this->streams_lock);
+
+  return pending;
 }
 
 static void video_out_update_disable_flush_from_video_out(void *disable_decoder_flush_from_video_out, xine_cfg_entry_t *entry)
@@ -1493,22 +1575,9 @@ static void video_out_update_disable_flush_from_video_out(void *disable_decoder_
   *(int *)disable_decoder_flush_from_video_out = entry->num_value;
 }
 
-static void *video_out_loop (void *this_gen) {
-
-  int64_t            vpts, diff;
-  vo_frame_t        *img;
-  vos_t             *this = (vos_t *) this_gen;
-  int64_t            next_frame_vpts = 0;
-  int64_t            usec_to_sleep;
-  int                disable_decoder_flush_from_video_out;
+static void video_out_loop_init (vos_t *this) {
 
-#ifndef WIN32
-  errno = 0;
-  if (nice(-2) == -1 && errno)
-    xine_log(this->xine, XINE_LOG_MSG, "video_out: can't raise nice priority by 2: %s\n", strerror(errno));
-#endif /* WIN32 */
-
-  disable_decoder_flush_from_video_out = this->xine->config->register_bool(this->xine->config, "engine.decoder.disable_flush_from_video_out", 0,
+  this->disable_decoder_flush_from_video_out = this->xine->config->register_bool(this->xine->config, "engine.decoder.disable_flush_from_video_out", 0,
       _("disable decoder flush from video out"),
       _("video out causes a decoder flush when video out runs out of frames for displaying,\n"
         "because the decoder hasn't deliverd new frames for quite a while.\n"
@@ -1516,16 +1585,35 @@ static void *video_out_loop (void *this_gen) {
         "to avoid the decoding errors, decoder flush at video out should be disabled.\n\n"
         "WARNING: as the flush was introduced to fix some issues when playing DVD still images, it is\n"
         "likely that these issues may reappear in case they haven't been fixed differently meanwhile.\n"),
-        20, video_out_update_disable_flush_from_video_out, &disable_decoder_flush_from_video_out);
+        20, video_out_update_disable_flush_from_video_out, &this->disable_decoder_flush_from_video_out);
+}
 
-  /*
-   * here it is - the heart of xine (or rather: one of the hearts
-   * of xine) : the video output loop
-   */
+/*
+ * one pass of the output loop: display the frame that is due, or go on
+ * waiting for the next one. woken tells whether the last wait was cut
+ * short by vo_trigger_drawing(). returns usec to wait, 0 to go on now.
+ */
+static int video_out_step (vos_t *this, int woken) {
 
-  lprintf ("loop starting...\n");
+  int64_t            vpts, diff;
+  vo_frame_t        *img;
+  int64_t            usec_to_sleep;
+  int                free_run;
 
-  while ( this->video_loop_running ) {
+  if (this->loop_paused) {
+    vpts = this->clock->get_current_time (this->clock);
+    if (this->clock->speed == XINE_SPEED_PAUSE) {
+      paused_loop (this, vpts);
+      return 20000;
+    }
+    paused_loop_leave (this);
+  } else if (this->loop_waiting) {
+    /* honor trigger update only when a backup img is available */
+    if ((woken && this->img_backup) || this->discard_frames)
+      this->loop_waiting = 0;
+  }
+
+  if (!this->loop_waiting) {
 
     /*
      * get current time and find frame to display
@@ -1537,7 +1625,9 @@ static void *video_out_loop (void *this_gen) {
 
     expire_frames (this, vpts);
 
-    img = get_next_frame (this, vpts, &next_frame_vpts);
+    img = get_next_frame (this, vpts, &this->next_frame_vpts);
+
+    free_run = this->clock->get_option (this->clock, CLOCK_FREE_RUN);
 
     /*
      * if we have found a frame, display it
@@ -1560,7 +1650,7 @@ static void *video_out_loop (void *this_gen) {
      */
 
     diff = vpts - this->last_delivery_pts;
-    if (diff > 30000 && !this->display_img_buf_queue->first) {
+    if (diff > 30000 && !this->display_img_buf_queue->first && !free_run) {
       xine_list_iterator_t ite;
 
       pthread_mutex_lock(&this->streams_lock);
@@ -1568,7 +1658,7 @@ static void *video_out_loop (void *this_gen) {
            ite = xine_list_next(this->streams, ite)) {
 	xine_stream_t *stream = xine_list_get_value(this->streams, ite);
 	if (stream == XINE_ANON_STREAM) continue;
-        if (stream->video_decoder_plugin && stream->video_fifo && !disable_decoder_flush_from_video_out) {
+        if (stream->video_decoder_plugin && stream->video_fifo && !this->disable_decoder_flush_from_video_out) {
           buf_element_t *buf;
 
 	  lprintf ("flushing current video decoder plugin\n");
@@ -1589,48 +1679,80 @@ static void *video_out_loop (void *this_gen) {
      * wait until it's time to display next frame
      */
     if (img) {
-      next_frame_vpts = img->vpts + img->duration;
+      this->next_frame_vpts = img->vpts + img->duration;
     }
     /* else next_frame_vpts is returned by get_next_frame */
 
-    lprintf ("next_frame_vpts is %" PRId64 "\n", next_frame_vpts);
+    lprintf ("next_frame_vpts is %" PRId64 "\n", this->next_frame_vpts);
 
-    do {
-      vpts = this->clock->get_current_time (this->clock);
+    /*
+     * free-run: the clock jumps to the next frame as soon as all
+     * outputs are ready for it. when the decoder is behind, slow the
+     * clock down while it has data, otherwise let the other outputs go on.
+     */
+    if (free_run && this->clock->speed != XINE_SPEED_PAUSE) {
+      int64_t due = 0;
 
-      if (this->clock->speed == XINE_SPEED_PAUSE)
-        paused_loop (this, vpts);
+      pthread_mutex_lock (&this->display_img_buf_queue->mutex);
+      if (this->display_img_buf_queue->first)
+        due = this->display_img_buf_queue->first->vpts;
+      pthread_mutex_unlock (&this->display_img_buf_queue->mutex);
 
-      if (next_frame_vpts && this->clock->speed > 0) {
-        usec_to_sleep = (next_frame_vpts - vpts) * 100 * XINE_FINE_SPEED_NORMAL / (9 * this->clock->speed);
-      } else {
-        /* we don't know when the next frame is due, only wait a little */
-        usec_to_sleep = 1000;
-        next_frame_vpts = vpts; /* wait only once */
+      if (due) {
+        this->starved = 0;
+        _x_clock_free_run_wait (this->clock, this->clock_client, due, MAX_USEC_TO_SLEEP);
+        return 0;
       }
+      if (++this->starved <= 20 || vo_frames_pending (this))
+        _x_clock_free_run_busy (this->clock, this->clock_client);
+      else
+        _x_clock_free_run_idle (this->clock, this->clock_client);
+      return 1000;
+    }
+
+    this->loop_waiting = 1;
+  }
 
-      /* limit usec_to_sleep to maintain responsiveness */
-      if (usec_to_sleep > MAX_USEC_TO_SLEEP)
-        usec_to_sleep = MAX_USEC_TO_SLEEP;
+  vpts = this->clock->get_current_time (this->clock);
 
-      lprintf ("%" PRId64 " usec to sleep at master vpts %" PRId64 "\n", usec_to_sleep, vpts);
+  if (this->clock->speed == XINE_SPEED_PAUSE) {
+    paused_loop_enter (this);
+    paused_loop (this, vpts);
+    return 20000;
+  }
 
-      if ( (next_frame_vpts - vpts) > 2*90000 )
-        xprintf(this->xine, XINE_VERBOSITY_DEBUG,
-		"video_out: vpts/clock error, next_vpts=%" PRId64 " cur_vpts=%" PRId64 "\n", next_frame_vpts,vpts);
+  if (this->next_frame_vpts && this->clock->speed > 0) {
+    usec_to_sleep = (this->next_frame_vpts - vpts) * 100 * XINE_FINE_SPEED_NORMAL / (9 * this->clock->speed);
+  } else {
+    /* we don't know when the next frame is due, only wait a little */
+    usec_to_sleep = 1000;
+    this->next_frame_vpts = vpts; /* wait only once */
+  }
 
-      if (usec_to_sleep > 0)
-      {
-        /* honor trigger update only when a backup img is available */
-        if (0 == interruptable_sleep(this, usec_to_sleep) && this->img_backup)
-          break;
-      }
+  /* limit usec_to_sleep to maintain responsiveness */
+  if (usec_to_sleep > MAX_USEC_TO_SLEEP)
+    usec_to_sleep = MAX_USEC_TO_SLEEP;
 
-      if (this->discard_frames)
-        break;
+  lprintf ("%" PRId64 " usec to sleep at master vpts %" PRId64 "\n", usec_to_sleep, vpts);
 
-    } while ( (usec_to_sleep > 0) && this->video_loop_running);
-  }
+  if ( (this->next_frame_vpts - vpts) > 2*90000 )
+    xprintf(this->xine, XINE_VERBOSITY_DEBUG,
+	    "video_out: vpts/clock error, next_vpts=%" PRId64 " cur_vpts=%" PRId64 "\n", this->next_frame_vpts,vpts);
+
+  if (usec_to_sleep > 0)
+    return usec_to_sleep;
+
+  this->loop_waiting = 0;
+  return 0;
+}
+
+/* the loop has been stopped */
+static void video_out_loop_done (vos_t *this) {
+
+  vo_frame_t        *img;
+
+  if (this->loop_paused)
+    paused_loop_leave (this);
 
   /*
    * throw away undisplayed frames
@@ -1658,10 +1780,59 @@ static void *video_out_loop (void *this_gen) {
     this->last_frame = NULL;
   }
   pthread_mutex_unlock(&this->grab_lock);
+}
+
+static void *video_out_loop (void *this_gen) {
+
+  vos_t             *this = (vos_t *) this_gen;
+  int                usec_to_sleep, woken = 0;
+
+#ifndef WIN32
+  errno = 0;
+  if (nice(-2) == -1 && errno)
+    xine_log(this->xine, XINE_LOG_MSG, "video_out: can't raise nice priority by 2: %s\n", strerror(errno));
+#endif /* WIN32 */
+
+  /*
+   * here it is - the heart of xine (or rather: one of the hearts
+   * of xine) : the video output loop
+   */
+
+  lprintf ("loop starting...\n");
+
+  while ( this->video_loop_running ) {
+    usec_to_sleep = video_out_step (this, woken);
+    woken = usec_to_sleep > 0 && !interruptable_sleep (this, usec_to_sleep);
+  }
+
+  video_out_loop_done (this);
 
   return NULL;
 }
 
+/* the output loop as a task on xine->executor, its waits are timers */
+static void video_out_task_run (xine_task_t *task) {
+
+  vos_t             *this = (vos_t *) ((char *) task - offsetof (vos_t, task));
+  int                usec_to_sleep, woken;
+
+  pthread_mutex_lock (&this->trigger_drawing_mutex);
+  woken = this->trigger_drawing;
+  this->trigger_drawing = 0;
+  pthread_mutex_unlock (&this->trigger_drawing_mutex);
+
+  if (!this->video_loop_running) {
+    video_out_loop_done (this);
+    return;
+  }
+
+  usec_to_sleep = video_out_step (this, woken);
+  if (usec_to_sleep > 0)
+    _x_task_wake_after (task, usec_to_sleep);
+  else
+    _x_task_wake (task);
+}
+
 /*
  * public function for video processing frontends to manually
  * consume video frames
@@ -1682,17 +1853,30 @@ int xine_get_next_video_frame (xine_video_port_t *this_gen,
       continue;
     }
 
-    /* FIXME: ugly, use conditions and locks instead? */
-
     pthread_mutex_lock(&this->display_img_buf_queue->mutex);
     img = this->display_img_buf_queue->first;
     if (!img) {
-      pthread_mutex_unlock(&this->display_img_buf_queue->mutex);
+      struct timeval  tv;
+      struct timespec ts;
+
       if (stream != XINE_ANON_STREAM && stream->video_fifo->fifo_size == 0 &&
-          stream->demux_plugin->get_status(stream->demux_plugin) != DEMUX_OK)
+          stream->demux_plugin->get_status(stream->demux_plugin) != DEMUX_OK) {
         /* no further data can be expected here */
+        pthread_mutex_unlock(&this->display_img_buf_queue->mutex);
         return 0;
-      xine_usec_sleep (5000);
+      }
+
+      /* wake up with the next frame, look at the demuxer again after 5ms */
+      gettimeofday(&tv, NULL);
+      ts.tv_sec  = tv.tv_sec;
+      ts.tv_nsec = (tv.tv_usec + 5000) * 1000;
+      if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+      }
+      pthread_cond_timedwait(&this->display_img_buf_queue->not_empty,
+                             &this->display_img_buf_queue->mutex, &ts);
+      pthread_mutex_unlock(&this->display_img_buf_queue->mutex);
       continue;
     }
   }
@@ -1704,6 +1888,9 @@ int xine_get_next_video_frame (xine_video_port_t *this_gen,
   img = vo_remove_from_img_buf_queue_int (this->display_img_buf_queue, 1, 0, 0, 0, 0, 0);
   pthread_mutex_unlock(&this->display_img_buf_queue->mutex);
 
+  if (img->stream)
+    _x_latency_record (img->stream, XINE_LATENCY_VIDEO, img->extra_info);
+
   frame->vpts         = img->vpts;
   frame->duration     = img->duration;
   frame->width        = img->width;
@@ -2009,9 +2196,17 @@ static void vo_exit (xine_video_port_t *this_gen) {
 
     this->video_loop_running = 0;
 
-    pthread_join (this->video_thread, &p);
+    if (this->task.executor) {
+      _x_task_wake (&this->task);
+      _x_task_wait (&this->task);
+    } else {
+      pthread_join (this->video_thread, &p);
+    }
+    this->xine->config->unregister_callback (this->xine->config, "engine.decoder.disable_flush_from_video_out");
   }
 
+  _x_clock_client_free (this->clock, this->clock_client);
+
   vo_free_img_buffers (this_gen);
 
   this->driver->dispose (this->driver);
@@ -2098,6 +2293,7 @@ static void vo_flush (xine_video_port_t *this_gen) {
     pthread_mutex_unlock(&this->display_img_buf_queue->mutex);
 
     /* do not try this in paused mode */
+    _x_executor_block_enter ();
     while(this->clock->speed != XINE_SPEED_PAUSE) {
       pthread_mutex_lock(&this->display_img_buf_queue->mutex);
       img = this->display_img_buf_queue->first;
@@ -2106,6 +2302,7 @@ static void vo_flush (xine_video_port_t *this_gen) {
         break;
       xine_usec_sleep (20000); /* pthread_cond_t could be used here */
     }
+    _x_executor_block_leave ();
 
     pthread_mutex_lock(&this->display_img_buf_queue->mutex);
     this->discard_frames--;
@@ -2120,6 +2317,9 @@ static void vo_trigger_drawing (xine_video_port_t *this_gen) {
   this->trigger_drawing = 1;
   pthread_cond_signal (&this->trigger_drawing_cond);
   pthread_mutex_unlock (&this->trigger_drawing_mutex);
+
+  if (this->task.executor)
+    _x_task_wake (&this->task);
 }
 
 /* crop_frame() will allocate a new frame to copy in the given image
@@ -2202,6 +2402,7 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
 
   this->xine                  = xine;
   this->clock                 = xine->clock;
+  this->clock_client          = grabonly ? -1 : _x_clock_client_new (xine->clock);
   this->driver                = driver;
   this->streams               = xine_list_new();
 
@@ -2340,24 +2541,32 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
     this->video_opened         = 0;
     this->grab_only            = 0;
 
-    pthread_attr_init(&pth_attrs);
+    video_out_loop_init (this);
+
+    /* run as a task on the shared engine threads */
+    if (xine->executor) {
+      _x_task_init (&this->task, xine->executor, video_out_task_run);
+      _x_task_wake (&this->task);
+    } else {
+      pthread_attr_init(&pth_attrs);
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
-    pthread_attr_setscope(&pth_attrs, PTHREAD_SCOPE_SYSTEM);
+      pthread_attr_setscope(&pth_attrs, PTHREAD_SCOPE_SYSTEM);
 #endif
 
-    if ((err = pthread_create (&this->video_thread,
-			       &pth_attrs, video_out_loop, this)) != 0) {
+      if ((err = pthread_create (&this->video_thread,
+			         &pth_attrs, video_out_loop, this)) != 0) {
 
-      xprintf (this->xine, XINE_VERBOSITY_NONE, "video_out: can't create thread (%s)\n", strerror(err));
-      /* FIXME: how does this happen ? */
-      xprintf (this->xine, XINE_VERBOSITY_LOG,
-	       _("video_out: sorry, this should not happen. please restart xine.\n"));
-      _x_abort();
-    }
-    else
-      xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_out: thread created\n");
+        xprintf (this->xine, XINE_VERBOSITY_NONE, "video_out: can't create thread (%s)\n", strerror(err));
+        /* FIXME: how does this happen ? */
+        xprintf (this->xine, XINE_VERBOSITY_LOG,
+	         _("video_out: sorry, this should not happen. please restart xine.\n"));
+        _x_abort();
+      }
+      else
+        xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_out: thread created\n");
 
-    pthread_attr_destroy(&pth_attrs);
+      pthread_attr_destroy(&pth_attrs);
+    }
   }
 
   return &this->vo;
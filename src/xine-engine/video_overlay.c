@@ -39,14 +39,25 @@
 #define LOG_DEBUG
 */
 
+/* events are kept in a binary heap ordered by vpts. seq keeps events
+ * with the same vpts in the order they were added.
+ */
 typedef struct video_overlay_events_s {
-  video_overlay_event_t  *event;
-  uint32_t	next_event;
+  video_overlay_event_t  event;
+  uint32_t	seq;
 } video_overlay_events_t;
 
-typedef struct video_overlay_showing_s {
-  int32_t	handle; /* -1 means not allocated */
-} video_overlay_showing_t;
+/* objects are allocated in chunks that never move, so a handle can be
+ * looked up without holding objects_mutex.
+ */
+#define OBJECTS_PER_CHUNK  64
+#define MAX_OBJECT_CHUNKS  1024
+
+typedef struct video_overlay_slot_s {
+  video_overlay_object_t object;
+  int		showing;      /* index into showing list, -1 if not shown */
+  int		free_listed;  /* handle is on the free list */
+} video_overlay_slot_t;
 
 
 typedef struct video_overlay_s {
@@ -55,34 +66,58 @@ typedef struct video_overlay_s {
   xine_t                   *xine;
 
   pthread_mutex_t           events_mutex;
-  video_overlay_events_t    events[MAX_EVENTS];
+  video_overlay_events_t   *events;
+  int                       num_events, max_events;
+  uint32_t                  event_seq;
+
   pthread_mutex_t           objects_mutex;
-  video_overlay_object_t    objects[MAX_OBJECTS];
+  video_overlay_slot_t     *objects[MAX_OBJECT_CHUNKS];
+  int                       num_objects;
+  int32_t                  *free_handles;
+  int                       num_free, max_free;
+
   pthread_mutex_t           showing_mutex;
-  video_overlay_showing_t   showing[MAX_SHOWING];
+  int32_t                  *showing;     /* handles in blending order */
+  int                       num_showing, max_showing;
   int                       showing_changed;
 } video_overlay_t;
 
 
+static video_overlay_slot_t *get_slot( video_overlay_t *this, int32_t handle )
+{
+  if( handle < 0 || handle >= this->num_objects )
+    return NULL;
+  return &this->objects[handle / OBJECTS_PER_CHUNK][handle % OBJECTS_PER_CHUNK];
+}
+
+static void free_overlay( vo_overlay_t *overlay )
+{
+  set_argb_layer_ptr(&overlay->argb_layer, NULL);
+  free( overlay->rle );
+  free( overlay );
+}
+
 static void add_showing_handle( video_overlay_t *this, int32_t handle )
 {
-  int i;
+  video_overlay_slot_t *slot = get_slot(this, handle);
 
   pthread_mutex_lock( &this->showing_mutex );
   this->showing_changed++;
 
-  for( i = 0; i < MAX_SHOWING; i++ )
-    if( this->showing[i].handle == handle )
-      break; /* already showing */
-
-  if( i == MAX_SHOWING ) {
-    for( i = 0; i < MAX_SHOWING && this->showing[i].handle >= 0; i++ )
-      ;
-
-    if( i != MAX_SHOWING )
-      this->showing[i].handle = handle;
-    else
-      xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: error: no showing slots available\n");
+  if( slot && slot->showing < 0 ) {
+    if( this->num_showing == this->max_showing ) {
+      int n = this->max_showing ? 2 * this->max_showing : MAX_SHOWING;
+      int32_t *showing = realloc( this->showing, n * sizeof(int32_t) );
+      if( !showing ) {
+        xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: error: no showing slots available\n");
+        pthread_mutex_unlock( &this->showing_mutex );
+        return;
+      }
+      this->showing = showing;
+      this->max_showing = n;
+    }
+    slot->showing = this->num_showing;
+    this->showing[this->num_showing++] = handle;
   }
 
   pthread_mutex_unlock( &this->showing_mutex );
@@ -90,53 +125,98 @@ static void add_showing_handle( video_overlay_t *this, int32_t handle )
 
 static void remove_showing_handle( video_overlay_t *this, int32_t handle )
 {
-  int i;
+  video_overlay_slot_t *slot = get_slot(this, handle);
 
   pthread_mutex_lock( &this->showing_mutex );
   this->showing_changed++;
 
-  for( i = 0; i < MAX_SHOWING; i++ ) {
-    if( this->showing[i].handle == handle ) {
-      this->showing[i].handle = -1;
+  if( slot && slot->showing >= 0 ) {
+    int i;
+
+    /* keep the blending order of the others */
+    this->num_showing--;
+    for( i = slot->showing; i < this->num_showing; i++ ) {
+      this->showing[i] = this->showing[i + 1];
+      get_slot(this, this->showing[i])->showing = i;
     }
+    slot->showing = -1;
   }
 
   pthread_mutex_unlock( &this->showing_mutex );
 }
 
+static int event_before( const video_overlay_events_t *a, const video_overlay_events_t *b )
+{
+  if( a->event.vpts != b->event.vpts )
+    return a->event.vpts < b->event.vpts;
+  return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void events_sift_up( video_overlay_t *this, int n )
+{
+  video_overlay_events_t e = this->events[n];
+
+  while( n > 0 ) {
+    int parent = (n - 1) / 2;
+    if( !event_before(&e, &this->events[parent]) )
+      break;
+    this->events[n] = this->events[parent];
+    n = parent;
+  }
+  this->events[n] = e;
+}
+
+static void events_sift_down( video_overlay_t *this, int n )
+{
+  video_overlay_events_t e = this->events[n];
+
+  for (;;) {
+    int child = 2 * n + 1;
+    if( child >= this->num_events )
+      break;
+    if( child + 1 < this->num_events && event_before(&this->events[child + 1], &this->events[child]) )
+      child++;
+    if( !event_before(&this->events[child], &e) )
+      break;
+    this->events[n] = this->events[child];
+    n = child;
+  }
+  this->events[n] = e;
+}
+
+/* removes the first event, returns a copy of it */
+static video_overlay_event_t events_pop( video_overlay_t *this )
+{
+  video_overlay_event_t event = this->events[0].event;
+
+  if( --this->num_events > 0 ) {
+    this->events[0] = this->events[this->num_events];
+    events_sift_down(this, 0);
+  }
+  return event;
+}
+
 static void remove_events_handle( video_overlay_t *this, int32_t handle, int lock )
 {
-  uint32_t   last_event,this_event;
+  int i, n;
 
   if( lock )
     pthread_mutex_lock( &this->events_mutex );
 
-  this_event=0;
-  do {
-    last_event=this_event;
-    this_event=this->events[last_event].next_event;
-
-    while( this_event &&
-        this->events[this_event].event->object.handle == handle ) {
-      /* remove event from pts list */
-      this->events[last_event].next_event=
-        this->events[this_event].next_event;
-
+  for( i = n = 0; i < this->num_events; i++ ) {
+    if( this->events[i].event.object.handle == handle ) {
       /* free its overlay */
-      if( this->events[this_event].event->object.overlay ) {
-        if( this->events[this_event].event->object.overlay->rle )
-          free( this->events[this_event].event->object.overlay->rle );
-        free(this->events[this_event].event->object.overlay);
-        this->events[this_event].event->object.overlay = NULL;
-      }
-
-      /* mark as free */
-      this->events[this_event].next_event = 0;
-      this->events[this_event].event->event_type = OVERLAY_EVENT_NULL;
+      if( this->events[i].event.object.overlay )
+        free_overlay( this->events[i].event.object.overlay );
+    } else
+      this->events[n++] = this->events[i];
+  }
 
-      this_event=this->events[last_event].next_event;
-    }
-  } while ( this_event );
+  if( n != this->num_events ) {
+    this->num_events = n;
+    for( i = n / 2 - 1; i >= 0; i-- )
+      events_sift_down(this, i);
+  }
 
   if( lock )
     pthread_mutex_unlock( &this->events_mutex );
@@ -148,19 +228,52 @@ static void remove_events_handle( video_overlay_t *this, int32_t handle, int loc
  */
 static int32_t video_overlay_get_handle(video_overlay_manager_t *this_gen, int object_type ) {
   video_overlay_t *this = (video_overlay_t *) this_gen;
-  int n;
+  video_overlay_slot_t *slot;
+  int32_t n;
 
   pthread_mutex_lock( &this->objects_mutex );
 
-  for( n=0; n < MAX_OBJECTS && this->objects[n].handle > -1; n++ )
-    ;
+  /* handles revived by a SHOW event stay on the list, skip them */
+  do {
+    if( !this->num_free ) {
+      video_overlay_slot_t *chunk;
+      int i, chunk_num = this->num_objects / OBJECTS_PER_CHUNK;
+
+      if( chunk_num == MAX_OBJECT_CHUNKS ||
+          !(chunk = calloc(OBJECTS_PER_CHUNK, sizeof(video_overlay_slot_t))) ) {
+        pthread_mutex_unlock( &this->objects_mutex );
+        return -1;
+      }
+      if( this->max_free < this->num_objects + OBJECTS_PER_CHUNK ) {
+        int32_t *free_handles = realloc( this->free_handles,
+                                         (this->num_objects + OBJECTS_PER_CHUNK) * sizeof(int32_t) );
+        if( !free_handles ) {
+          free( chunk );
+          pthread_mutex_unlock( &this->objects_mutex );
+          return -1;
+        }
+        this->free_handles = free_handles;
+        this->max_free = this->num_objects + OBJECTS_PER_CHUNK;
+      }
+
+      /* hand out the lowest handles first */
+      for( i = OBJECTS_PER_CHUNK - 1; i >= 0; i-- ) {
+        chunk[i].object.handle = -1;
+        chunk[i].showing = -1;
+        chunk[i].free_listed = 1;
+        this->free_handles[this->num_free++] = this->num_objects + i;
+      }
+      this->objects[chunk_num] = chunk;
+      this->num_objects += OBJECTS_PER_CHUNK;
+    }
 
-  if (n == MAX_OBJECTS) {
-    n = -1;
-  } else {
-    this->objects[n].handle = n;
-    this->objects[n].object_type = object_type;
-  }
+    n = this->free_handles[--this->num_free];
+    slot = get_slot(this, n);
+    slot->free_listed = 0;
+  } while( slot->object.handle > -1 );
+
+  slot->object.handle = n;
+  slot->object.object_type = object_type;
 
   pthread_mutex_unlock( &this->objects_mutex );
   return n;
@@ -170,18 +283,22 @@ static int32_t video_overlay_get_handle(video_overlay_manager_t *this_gen, int o
   free a handle from the object pool (internal function)
  */
 static void internal_video_overlay_free_handle(video_overlay_t *this, int32_t handle) {
+  video_overlay_slot_t *slot = get_slot(this, handle);
 
-  pthread_mutex_lock( &this->objects_mutex );
+  if( !slot )
+    return;
 
-  if( this->objects[handle].overlay ) {
-    set_argb_layer_ptr(&this->objects[handle].overlay->argb_layer, NULL);
+  pthread_mutex_lock( &this->objects_mutex );
 
-    if( this->objects[handle].overlay->rle )
-      free( this->objects[handle].overlay->rle );
-    free( this->objects[handle].overlay );
-    this->objects[handle].overlay = NULL;
+  if( slot->object.overlay ) {
+    free_overlay( slot->object.overlay );
+    slot->object.overlay = NULL;
   }
-  this->objects[handle].handle = -1;
+  if( slot->object.handle > -1 && !slot->free_listed ) {
+    slot->free_listed = 1;
+    this->free_handles[this->num_free++] = handle;
+  }
+  slot->object.handle = -1;
 
   pthread_mutex_unlock( &this->objects_mutex );
 }
@@ -203,25 +320,20 @@ static void video_overlay_reset (video_overlay_t *this) {
   int i;
 
   pthread_mutex_lock (&this->events_mutex);
-  for (i=0; i < MAX_EVENTS; i++) {
-    if (this->events[i].event == NULL) {
-      this->events[i].event = calloc(1, sizeof(video_overlay_event_t));
-#ifdef LOG_DEBUG
-      printf ("video_overlay: MALLOC2: this->events[%d].event %p, len=%d\n",
-	      i,
-	      this->events[i].event,
-	      sizeof(video_overlay_event_t));
-#endif
-    }
-    this->events[i].event->event_type = 0;  /* Empty slot */
-    this->events[i].next_event = 0;
+  for (i=0; i < this->num_events; i++) {
+    if (this->events[i].event.object.overlay)
+      free_overlay(this->events[i].event.object.overlay);
   }
+  this->num_events = 0;
   pthread_mutex_unlock (&this->events_mutex);
 
-  for( i = 0; i < MAX_SHOWING; i++ )
-    this->showing[i].handle = -1;
+  pthread_mutex_lock (&this->showing_mutex);
+  for (i=0; i < this->num_showing; i++)
+    get_slot(this, this->showing[i])->showing = -1;
+  this->num_showing = 0;
+  pthread_mutex_unlock (&this->showing_mutex);
 
-  for (i=0; i < MAX_OBJECTS; i++) {
+  for (i=0; i < this->num_objects; i++) {
     internal_video_overlay_free_handle(this, i);
   }
 
@@ -255,68 +367,66 @@ static void video_overlay_init (video_overlay_manager_t *this_gen) {
 static int32_t video_overlay_add_event(video_overlay_manager_t *this_gen,  void *event_gen ) {
   video_overlay_event_t *event = (video_overlay_event_t *) event_gen;
   video_overlay_t *this = (video_overlay_t *) this_gen;
-  uint32_t   last_event,this_event,new_event;
+  video_overlay_events_t *new_event;
+  vo_overlay_t *overlay = NULL;
+  int32_t result;
+
+  if( event->object.overlay ) {
+    overlay = malloc(sizeof(vo_overlay_t));
+    if( !overlay ) {
+      xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay:No spare subtitle event slots\n");
+      return -1;
+    }
+  }
 
   pthread_mutex_lock (&this->events_mutex);
 
-  /* We skip the 0 entry because that is used as a pointer to the first event.*/
-  /* Find a free event slot */
-  for( new_event = 1; new_event<MAX_EVENTS &&
-       this->events[new_event].event->event_type > 0; new_event++ )
-    ;
-
-  if (new_event < MAX_EVENTS) {
-    /* Find position in event queue to be added. */
-    this_event=0;
-    /* Find where in the current queue to insert the event. I.E. Sort it. */
-    do {
-      last_event=this_event;
-      this_event=this->events[last_event].next_event;
-    } while ( this_event && this->events[this_event].event->vpts <= event->vpts );
-
-    this->events[last_event].next_event=new_event;
-    this->events[new_event].next_event=this_event;
-
-    /* memcpy everything except the actual image */
-    if ( this->events[new_event].event == NULL ) {
-      xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: error: event slot is NULL!\n");
+  if( this->num_events == this->max_events ) {
+    int n = this->max_events ? 2 * this->max_events : MAX_EVENTS;
+    video_overlay_events_t *events = realloc( this->events, n * sizeof(video_overlay_events_t) );
+    if( !events ) {
+      pthread_mutex_unlock (&this->events_mutex);
+      free( overlay );
+      xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay:No spare subtitle event slots\n");
+      return -1;
     }
-    this->events[new_event].event->event_type=event->event_type;
-    this->events[new_event].event->vpts=event->vpts;
-    this->events[new_event].event->object.handle=event->object.handle;
-    this->events[new_event].event->object.pts=event->object.pts;
+    this->events = events;
+    this->max_events = n;
+  }
 
-    if ( this->events[new_event].event->object.overlay ) {
-      xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: add_event: event->object.overlay was not freed!\n");
+  new_event = &this->events[this->num_events];
+  memset(new_event, 0, sizeof(*new_event));
+  /* memcpy everything except the actual image */
+  new_event->event.event_type=event->event_type;
+  new_event->event.vpts=event->vpts;
+  new_event->event.object.handle=event->object.handle;
+  new_event->event.object.pts=event->object.pts;
+  new_event->seq = this->event_seq++;
+  /* positive, but otherwise meaningless */
+  result = (new_event->seq & 0x3fffffff) + 1;
+
+  if( overlay ) {
+    int i;
+    for(i = 0; i < OVL_PALETTE_SIZE; i++) {
+      if(event->object.overlay->trans[i] >= OVL_MAX_OPACITY)
+        event->object.overlay->trans[i] = OVL_MAX_OPACITY;
+      if(event->object.overlay->hili_trans[i] >= OVL_MAX_OPACITY)
+        event->object.overlay->hili_trans[i] = OVL_MAX_OPACITY;
     }
 
-    if( event->object.overlay ) {
-      int i;
-      for(i = 0; i < OVL_PALETTE_SIZE; i++) {
-	if(event->object.overlay->trans[i] >= OVL_MAX_OPACITY)
-	  event->object.overlay->trans[i] = OVL_MAX_OPACITY;
-	if(event->object.overlay->hili_trans[i] >= OVL_MAX_OPACITY)
-	  event->object.overlay->hili_trans[i] = OVL_MAX_OPACITY;
-      }
-
-      this->events[new_event].event->object.overlay = calloc(1, sizeof(vo_overlay_t));
-      xine_fast_memcpy(this->events[new_event].event->object.overlay,
-           event->object.overlay, sizeof(vo_overlay_t));
+    new_event->event.object.overlay = overlay;
+    xine_fast_memcpy(overlay, event->object.overlay, sizeof(vo_overlay_t));
 
-      /* We took the callers rle and data, therefore it will be our job to free it */
-      /* clear callers overlay so it will not be freed twice */
-      memset(event->object.overlay,0,sizeof(vo_overlay_t));
-    } else {
-      this->events[new_event].event->object.overlay = NULL;
-    }
-  } else {
-    xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay:No spare subtitle event slots\n");
-    new_event = -1;
+    /* We took the callers rle and data, therefore it will be our job to free it */
+    /* clear callers overlay so it will not be freed twice */
+    memset(event->object.overlay,0,sizeof(vo_overlay_t));
   }
 
+  events_sift_up(this, this->num_events++);
+
   pthread_mutex_unlock (&this->events_mutex);
 
-  return new_event;
+  return result;
 }
 
 
@@ -347,46 +457,48 @@ static void video_overlay_print_overlay( vo_overlay_t *ovl ) {
 */
 static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
   int32_t      handle;
-  uint32_t     this_event;
+  video_overlay_event_t event;
+  video_overlay_object_t *object;
   int          processed = 0;
 
   pthread_mutex_lock (&this->events_mutex);
 
-  this_event=this->events[0].next_event;
-  while ( this_event && (vpts > this->events[this_event].event->vpts ||
+  while ( this->num_events && (vpts > this->events[0].event.vpts ||
           vpts == 0) ) {
+    event = events_pop(this);
     processed++;
-    handle=this->events[this_event].event->object.handle;
+    handle=event.object.handle;
 #ifdef LOG_DEBUG
     printf ("video_overlay: video_overlay_event: handle = %d\n", handle);
 #endif
     _x_assert(handle >= 0);
-    if ( handle < 0 ) break;
+    if ( !get_slot(this, handle) ) {
+      if (event.object.overlay != NULL)
+        free_overlay(event.object.overlay);
+      continue;
+    }
+    object = &get_slot(this, handle)->object;
 
-    switch( this->events[this_event].event->event_type ) {
+    switch( event.event_type ) {
       case OVERLAY_EVENT_SHOW:
 #ifdef LOG_DEBUG
         printf ("video_overlay: SHOW SPU NOW\n");
 #endif
-        if (this->events[this_event].event->object.overlay != NULL) {
+        if (event.object.overlay != NULL) {
 #ifdef LOG_DEBUG
-          video_overlay_print_overlay( this->events[this_event].event->object.overlay ) ;
+          video_overlay_print_overlay( event.object.overlay ) ;
 #endif
-          /* this->objects[handle].overlay is about to be
-           * overwritten by this event data. make sure we free it if needed.
+          /* object->overlay is about to be overwritten by this
+           * event data. make sure we free it if needed.
            */
           remove_showing_handle(this,handle);
-          internal_video_overlay_free_handle(this, handle);
-
-          this->objects[handle].handle = handle;
-          if( this->objects[handle].overlay ) {
-            xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: error: object->overlay was not freed!\n");
-          }
-          this->objects[handle].overlay =
-             this->events[this_event].event->object.overlay;
-          this->objects[handle].pts =
-             this->events[this_event].event->object.pts;
-          this->events[this_event].event->object.overlay = NULL;
+          pthread_mutex_lock( &this->objects_mutex );
+          if( object->overlay )
+            free_overlay( object->overlay );
+          object->handle = handle;
+          object->overlay = event.object.overlay;
+          object->pts = event.object.pts;
+          pthread_mutex_unlock( &this->objects_mutex );
 
           add_showing_handle( this, handle );
         }
@@ -397,14 +509,8 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
         printf ("video_overlay: HIDE SPU NOW\n");
 #endif
         /* free any overlay associated with this event */
-        if (this->events[this_event].event->object.overlay != NULL) {
-          set_argb_layer_ptr(&this->events[this_event].event->object.overlay->argb_layer, NULL);
-
-          if( this->events[this_event].event->object.overlay->rle != NULL )
-            free( this->events[this_event].event->object.overlay->rle );
-          free(this->events[this_event].event->object.overlay);
-          this->events[this_event].event->object.overlay = NULL;
-        }
+        if (event.object.overlay != NULL)
+          free_overlay(event.object.overlay);
         remove_showing_handle( this, handle );
         break;
 
@@ -413,17 +519,8 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
         printf ("video_overlay: FREE SPU NOW\n");
 #endif
         /* free any overlay associated with this event */
-        if( this->events[this_event].event->object.overlay != NULL) {
-          set_argb_layer_ptr(&this->events[this_event].event->object.overlay->argb_layer, NULL);
-
-          if( this->events[this_event].event->object.overlay->rle != NULL )
-            free( this->events[this_event].event->object.overlay->rle );
-          free(this->events[this_event].event->object.overlay);
-          this->events[this_event].event->object.overlay = NULL;
-        }
-        /* this avoid removing this_event from the queue
-         * (it will be removed at the end of this loop) */
-        this->events[this_event].event->object.handle = -1;
+        if (event.object.overlay != NULL)
+          free_overlay(event.object.overlay);
         remove_showing_handle(this,handle);
         remove_events_handle(this,handle,0);
         internal_video_overlay_free_handle( this, handle );
@@ -439,24 +536,23 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
         /* This code drops buttons, where the button PTS derived from the NAV
 	 * packet on DVDs does not match the SPU PTS. Practical experience shows,
 	 * that this is not necessary and causes problems with some DVDs */
-        if ( (this->events[this_event].event->object.pts !=
-                this->objects[handle].pts) ) {
+        if ( (event.object.pts != object->pts) ) {
           xprintf (this->xine, XINE_VERBOSITY_DEBUG,
 		   "video_overlay:MENU BUTTON DROPPED menu pts=%lld spu pts=%lld\n",
-            this->events[this_event].event->object.pts,
-            this->objects[handle].pts);
+            event.object.pts,
+            object->pts);
           break;
         }
 #endif
-        if ( (this->events[this_event].event->object.overlay != NULL) &&
-             (this->objects[handle].overlay) ) {
-          vo_overlay_t *overlay = this->objects[handle].overlay;
-          vo_overlay_t *event_overlay = this->events[this_event].event->object.overlay;
+        if ( (event.object.overlay != NULL) &&
+             (object->overlay) ) {
+          vo_overlay_t *overlay = object->overlay;
+          vo_overlay_t *event_overlay = event.object.overlay;
 
 #ifdef LOG_DEBUG
           printf ("video_overlay:overlay present\n");
 #endif
-          this->objects[handle].handle = handle;
+          object->handle = handle;
           overlay->hili_top = event_overlay->hili_top;
           overlay->hili_bottom = event_overlay->hili_bottom;
           overlay->hili_left = event_overlay->hili_left;
@@ -471,35 +567,26 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
           overlay->hili_trans[3] = event_overlay->hili_trans[3];
           overlay->hili_rgb_clut = event_overlay->hili_rgb_clut;
 #ifdef LOG_DEBUG
-          video_overlay_print_overlay( this->events[this_event].event->object.overlay ) ;
+          video_overlay_print_overlay( event.object.overlay ) ;
 #endif
           add_showing_handle( this, handle );
         } else {
           xprintf (this->xine, XINE_VERBOSITY_DEBUG, "video_overlay:overlay not present\n");
         }
 
-        if( this->events[this_event].event->object.overlay->rle ) {
-          xprintf (this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: warning EVENT_MENU_BUTTON with rle data\n");
-          free( this->events[this_event].event->object.overlay->rle );
-          this->events[this_event].event->object.overlay->rle = NULL;
-        }
-
-        if (this->events[this_event].event->object.overlay != NULL) {
-          free (this->events[this_event].event->object.overlay);
-          this->events[this_event].event->object.overlay = NULL;
+        if (event.object.overlay != NULL) {
+          if( event.object.overlay->rle )
+            xprintf (this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: warning EVENT_MENU_BUTTON with rle data\n");
+          free_overlay (event.object.overlay);
         }
         break;
 
       default:
         xprintf (this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: unhandled event type\n");
+        if (event.object.overlay != NULL)
+          free_overlay(event.object.overlay);
         break;
     }
-
-    this->events[0].next_event = this->events[this_event].next_event;
-    this->events[this_event].next_event = 0;
-    this->events[this_event].event->event_type = 0;
-
-    this_event=this->events[0].next_event;
   }
 
   pthread_mutex_unlock (&this->events_mutex);
@@ -514,26 +601,21 @@ static void video_overlay_multiple_overlay_blend (video_overlay_manager_t *this_
 						  vo_driver_t *output, vo_frame_t *vo_img, int enabled) {
   video_overlay_t *this = (video_overlay_t *) this_gen;
   int i;
-  int32_t  handle;
 
   /* Look at next events, if current video vpts > first event on queue, process the event
    * else just continue
    */
   video_overlay_event( this, vpts );
 
-  /* Scan through 5 entries and display any present.
+  /* display everything showing, in the order it was shown.
    */
   pthread_mutex_lock( &this->showing_mutex );
 
   if( output->overlay_begin )
     output->overlay_begin(output, vo_img, this->showing_changed);
 
-  for( i = 0; enabled && output->overlay_blend && i < MAX_SHOWING; i++ ) {
-    handle=this->showing[i].handle;
-    if (handle >= 0 ) {
-      output->overlay_blend(output, vo_img, this->objects[handle].overlay);
-    }
-  }
+  for( i = 0; enabled && output->overlay_blend && i < this->num_showing; i++ )
+    output->overlay_blend(output, vo_img, get_slot(this, this->showing[i])->object.overlay);
 
   if( output->overlay_end )
     output->overlay_end(output, vo_img);
@@ -571,19 +653,13 @@ static void video_overlay_dispose(video_overlay_manager_t *this_gen) {
   video_overlay_t *this = (video_overlay_t *) this_gen;
   int i;
 
-  for (i=0; i < MAX_EVENTS; i++) {
-    if (this->events[i].event != NULL) {
-      if (this->events[i].event->object.overlay != NULL) {
-        if (this->events[i].event->object.overlay->rle)
-          free (this->events[i].event->object.overlay->rle);
-        free (this->events[i].event->object.overlay);
-      }
-      free (this->events[i].event);
-    }
-  }
+  video_overlay_reset(this);
 
-  for (i=0; i < MAX_OBJECTS; i++)
-    internal_video_overlay_free_handle(this, i);
+  for (i=0; i < this->num_objects / OBJECTS_PER_CHUNK; i++)
+    free (this->objects[i]);
+  free (this->free_handles);
+  free (this->events);
+  free (this->showing);
 
   pthread_mutex_destroy (&this->events_mutex);
   pthread_mutex_destroy (&this->objects_mutex);
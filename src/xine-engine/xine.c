@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <errno.h>
 #if defined (__linux__) || defined (__GLIBC__)
 #include <endian.h>
 #elif defined (__FreeBSD__)
@@ -133,68 +134,158 @@ void _x_extra_info_merge( extra_info_t *dst, extra_info_t *src ) {
 
     if( src->vpts )
       dst->vpts = src->vpts;
+
+    if( src->latency[XINE_LATENCY_READ] )
+      memcpy( dst->latency, src->latency, sizeof(dst->latency) );
   }
 }
 
-static int acquire_allowed_to_block(xine_ticket_t *this) {
-  pthread_t own_id = pthread_self();
-  unsigned entry;
-  unsigned new_size;
+/*
+ * port tickets
+ *
+ * every thread keeps the number of tickets it holds in a record of its
+ * own. tickets_granted counts holding threads, not tickets, so only a
+ * thread's first acquire and last release touch shared state, and as
+ * long as no revocation is pending that is a single atomic operation.
+ *
+ * a revoker sets blocked, then waits for tickets_granted to drop
+ * to zero, i. e. for every holder to pass a point where it holds no
+ * ticket (a grace period). holders see blocked and take the slow path
+ * under this->lock, which works like the classic implementation.
+ */
 
-  for(entry = 0; entry < this->holder_thread_count; ++entry) {
-    if(pthread_equal(this->holder_threads[entry].holder, own_id)) {
-      /* This thread may already hold this ticket */
-      this->holder_threads[entry].count++;
-      return (this->holder_threads[entry].count == 1);
+#ifdef HAVE_SYNC_BUILTINS
+# define ticket_atomic_add(ptr, n) __sync_add_and_fetch (ptr, n)
+# define ticket_barrier()          __sync_synchronize ()
+#else
+static pthread_mutex_t ticket_atomic_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int ticket_atomic_add (int *ptr, int n) {
+  int r;
+  pthread_mutex_lock (&ticket_atomic_lock);
+  r = (*ptr += n);
+  pthread_mutex_unlock (&ticket_atomic_lock);
+  return r;
+}
+static int ticket_atomic_dummy;
+# define ticket_barrier() ticket_atomic_add (&ticket_atomic_dummy, 0)
+#endif
+
+typedef struct xine_ticket_holder_s xine_ticket_holder_t;
+
+struct xine_ticket_holder_s {
+  xine_ticket_t        *ticket;
+  xine_ticket_holder_t *next;
+  int                   count;   /* tickets held, nested ones included */
+};
+
+/* engine side of a ticket. the public struct keeps its layout, its
+ * holder_threads are unused. */
+typedef struct {
+  xine_ticket_t         ticket;
+
+  /* holders only take the lock while this is set (revocation pending) */
+  int                   blocked;
+  /* per thread xine_ticket_holder_t */
+  pthread_key_t         holder_key;
+  xine_ticket_holder_t *holders;
+} xine_ticket_private_t;
+
+static void ticket_holder_free (void *holder_gen) {
+  xine_ticket_holder_t  *holder = (xine_ticket_holder_t *)holder_gen;
+  xine_ticket_private_t *priv   = (xine_ticket_private_t *)holder->ticket;
+  xine_ticket_holder_t **h;
+
+  pthread_mutex_lock(&priv->ticket.lock);
+  for (h = &priv->holders; *h; h = &(*h)->next) {
+    if (*h == holder) {
+      *h = holder->next;
+      break;
     }
   }
-  /* If we get this far, this thread hasn't claimed this ticket before.
-     We need to give it a new entry in the list, then return true */
-  for(entry = 0; entry < this->holder_thread_count; ++entry) {
-    if(this->holder_threads[entry].count == 0) {
-      this->holder_threads[entry].holder = own_id;
-      this->holder_threads[entry].count = 1;
-      return 1;
-    }
+  pthread_mutex_unlock(&priv->ticket.lock);
+
+  if (holder->count) {
+    lprintf("BUG! Thread exited with %d tickets held\n", holder->count);
+    _x_assert(0);
   }
-  /* List too small. Realloc to larger size */
-  new_size = this->holder_thread_count * 2;
-  lprintf("Reallocing from %d to %d entries\n", this->holder_thread_count, new_size);
+  free(holder);
+}
 
-  this->holder_threads = realloc(this->holder_threads, sizeof(*this->holder_threads) * new_size);
-  memset(this->holder_threads + this->holder_thread_count, 0, this->holder_thread_count);
+static xine_ticket_holder_t *ticket_holder(xine_ticket_t *this) {
+  xine_ticket_private_t *priv   = (xine_ticket_private_t *)this;
+  xine_ticket_holder_t  *holder = pthread_getspecific(priv->holder_key);
 
-  /* Old size is equivalent to index of first newly allocated entry*/
-  this->holder_threads[this->holder_thread_count].count = 1;
-  this->holder_threads[this->holder_thread_count].holder = own_id;
-  this->holder_thread_count = new_size;
+  if (!holder) {
+    holder = calloc(1, sizeof(xine_ticket_holder_t));
+    _x_assert(holder);
+    holder->ticket = this;
+    pthread_mutex_lock(&this->lock);
+    holder->next  = priv->holders;
+    priv->holders = holder;
+    pthread_mutex_unlock(&this->lock);
+    pthread_setspecific(priv->holder_key, holder);
+  }
+  return holder;
+}
 
-  return 1;
+/* called with this->lock held */
+static void ticket_wait_issued(xine_ticket_t *this) {
+  _x_executor_block_enter();
+  pthread_cond_wait(&this->issued, &this->lock);
+  _x_executor_block_leave();
+}
+
+/* called with this->lock held */
+static void ticket_update_blocked(xine_ticket_t *this) {
+  ((xine_ticket_private_t *)this)->blocked =
+    this->ticket_revoked || this->pending_revocations || this->atomic_revoke;
 }
 
 static int ticket_acquire_internal(xine_ticket_t *this, int irrevocable, int nonblocking) {
+  xine_ticket_private_t *priv   = (xine_ticket_private_t *)this;
+  xine_ticket_holder_t  *holder = ticket_holder(this);
   int must_wait = 0;
 
+  /* nested: never blocks, this thread is counted already */
+  if (holder->count++) {
+    if (irrevocable)
+      ticket_atomic_add(&this->irrevocable_tickets, 1);
+    return 1;
+  }
+
+  ticket_atomic_add(&this->tickets_granted, 1);
+  if (!priv->blocked) {
+    if (irrevocable)
+      ticket_atomic_add(&this->irrevocable_tickets, 1);
+    return 1;
+  }
+
   pthread_mutex_lock(&this->lock);
-  int allowed_to_block = acquire_allowed_to_block(this);
 
+  /* before counting our own irrevocable ticket, which is not out yet */
   if (this->ticket_revoked && !this->irrevocable_tickets)
     must_wait = !nonblocking;
   else if (this->atomic_revoke && !pthread_equal(this->atomic_revoker_thread, pthread_self()))
     must_wait = 1;
 
-  if (must_wait && allowed_to_block) {
+  if (must_wait) {
+    /* not holding anything while waiting */
+    if (!ticket_atomic_add(&this->tickets_granted, -1) && this->ticket_revoked)
+      pthread_cond_broadcast(&this->revoked);
+
     if (nonblocking) {
+      holder->count--;
       pthread_mutex_unlock(&this->lock);
       return 0;
     }
 
-    pthread_cond_wait(&this->issued, &this->lock);
+    ticket_wait_issued(this);
+    ticket_atomic_add(&this->tickets_granted, 1);
   }
 
-  this->tickets_granted++;
   if (irrevocable)
-    this->irrevocable_tickets++;
+    ticket_atomic_add(&this->irrevocable_tickets, 1);
 
   pthread_mutex_unlock(&this->lock);
   return 1;
@@ -208,36 +299,31 @@ static void ticket_acquire(xine_ticket_t *this, int irrevocable) {
   ticket_acquire_internal(this, irrevocable, 0);
 }
 
-static int release_allowed_to_block(xine_ticket_t *this) {
-  pthread_t own_id = pthread_self();
-  unsigned entry;
+static void ticket_release_internal(xine_ticket_t *this, int irrevocable, int nonblocking) {
+  xine_ticket_holder_t *holder = ticket_holder(this);
 
-  for(entry = 0; entry < this->holder_thread_count; ++entry) {
-    if(pthread_equal(this->holder_threads[entry].holder, own_id)) {
-      this->holder_threads[entry].count--;
-      return this->holder_threads[entry].count == 0;
-    }
+  if (holder->count <= 0) {
+    lprintf("BUG! Ticket 0x%p released by a thread that never took it! Allowing code to continue\n", this);
+    _x_assert(0);
+    return;
   }
-  lprintf("BUG! Ticket 0x%p released by a thread that never took it! Allowing code to continue\n", this);
-  _x_assert(0);
-  return 1;
-}
 
-static void ticket_release_internal(xine_ticket_t *this, int irrevocable, int nonblocking) {
+  if (irrevocable)
+    ticket_atomic_add(&this->irrevocable_tickets, -1);
 
-  pthread_mutex_lock(&this->lock);
-  int allowed_to_block = release_allowed_to_block(this);
+  if (--holder->count)
+    return;
 
-  this->tickets_granted--;
-  if (irrevocable)
-    this->irrevocable_tickets--;
+  ticket_atomic_add(&this->tickets_granted, -1);
+  if (!((xine_ticket_private_t *)this)->blocked)
+    return;
+
+  pthread_mutex_lock(&this->lock);
 
   if (this->ticket_revoked && !this->tickets_granted)
     pthread_cond_broadcast(&this->revoked);
-  if (allowed_to_block) {
-    if (this->ticket_revoked && !this->irrevocable_tickets && !nonblocking)
-      pthread_cond_wait(&this->issued, &this->lock);
-  }
+  if (this->ticket_revoked && !this->irrevocable_tickets && !nonblocking)
+    ticket_wait_issued(this);
 
   pthread_mutex_unlock(&this->lock);
 }
@@ -254,15 +340,13 @@ static void ticket_renew(xine_ticket_t *this, int irrevocable) {
 
   pthread_mutex_lock(&this->lock);
 
-  this->tickets_granted--;
-
   _x_assert(this->ticket_revoked);
-  if (!this->tickets_granted)
+  if (!ticket_atomic_add(&this->tickets_granted, -1))
     pthread_cond_broadcast(&this->revoked);
   if (!this->irrevocable_tickets || !irrevocable)
-    pthread_cond_wait(&this->issued, &this->lock);
+    ticket_wait_issued(this);
 
-  this->tickets_granted++;
+  ticket_atomic_add(&this->tickets_granted, 1);
 
   pthread_mutex_unlock(&this->lock);
 }
@@ -277,6 +361,7 @@ static void ticket_issue(xine_ticket_t *this, int atomic) {
   if (!this->pending_revocations)
     pthread_cond_broadcast(&this->issued);
   this->atomic_revoke = 0;
+  ticket_update_blocked(this);
 
   pthread_mutex_unlock(&this->lock);
   pthread_mutex_unlock(&this->revoke_lock);
@@ -289,14 +374,17 @@ static void ticket_revoke(xine_ticket_t *this, int atomic) {
 
   this->pending_revocations++;
   this->ticket_revoked = 1;
-  if (this->tickets_granted)
+  ((xine_ticket_private_t *)this)->blocked = 1;
+  /* holders that did not see blocked yet are counted in tickets_granted */
+  ticket_barrier();
+  while (this->tickets_granted)
     pthread_cond_wait(&this->revoked, &this->lock);
-  _x_assert(!this->tickets_granted);
   this->ticket_revoked = 0;
   if (atomic) {
     this->atomic_revoke = 1;
     this->atomic_revoker_thread = pthread_self();
   }
+  ticket_update_blocked(this);
 
   pthread_mutex_unlock(&this->lock);
   if (!atomic)
@@ -332,6 +420,15 @@ static void ticket_unlock_port_rewiring(xine_ticket_t *this) {
 }
 
 static void ticket_dispose(xine_ticket_t *this) {
+  xine_ticket_private_t *priv = (xine_ticket_private_t *)this;
+  xine_ticket_holder_t  *holder, *next;
+
+  /* records of threads still alive, exited ones freed theirs */
+  pthread_key_delete(priv->holder_key);
+  for (holder = priv->holders; holder; holder = next) {
+    next = holder->next;
+    free(holder);
+  }
 
   pthread_mutex_destroy(&this->port_rewiring_lock);
   pthread_mutex_destroy(&this->lock);
@@ -339,14 +436,15 @@ static void ticket_dispose(xine_ticket_t *this) {
   pthread_cond_destroy(&this->issued);
   pthread_cond_destroy(&this->revoked);
 
-  free(this->holder_threads);
   free(this);
 }
 
 static xine_ticket_t *XINE_MALLOC ticket_init(void) {
-  xine_ticket_t *port_ticket;
+  xine_ticket_private_t *priv;
+  xine_ticket_t         *port_ticket;
 
-  port_ticket = calloc(1, sizeof(xine_ticket_t));
+  priv = calloc(1, sizeof(xine_ticket_private_t));
+  port_ticket = &priv->ticket;
 
   port_ticket->acquire_nonblocking  = ticket_acquire_nonblocking;
   port_ticket->acquire              = ticket_acquire;
@@ -358,8 +456,8 @@ static xine_ticket_t *XINE_MALLOC ticket_init(void) {
   port_ticket->lock_port_rewiring   = ticket_lock_port_rewiring;
   port_ticket->unlock_port_rewiring = ticket_unlock_port_rewiring;
   port_ticket->dispose              = ticket_dispose;
-  port_ticket->holder_thread_count = XINE_MAX_TICKET_HOLDER_THREADS;
-  port_ticket->holder_threads = calloc(XINE_MAX_TICKET_HOLDER_THREADS,sizeof(*port_ticket->holder_threads));
+
+  pthread_key_create(&priv->holder_key, ticket_holder_free);
 
   pthread_mutex_init(&port_ticket->lock, NULL);
   pthread_mutex_init(&port_ticket->revoke_lock, NULL);
@@ -716,7 +814,7 @@ xine_stream_t *xine_stream_new (xine_t *this,
    * event queues
    */
 
-  stream->event_queues = xine_list_new ();
+  xine_ilist_init (&stream->event_queues);
 
   /*
    * create a metronom
@@ -771,6 +869,8 @@ xine_stream_t *xine_stream_new (xine_t *this,
     return NULL;
   }
 
+  _x_latency_stream_init (stream);
+
   /*
    * register stream
    */
@@ -811,14 +911,15 @@ void _x_mrl_unescape(char *mrl) {
 
 void _x_flush_events_queues (xine_stream_t *stream) {
 
-  xine_list_iterator_t ite;
+  xine_ilist_node_t *node;
 
   pthread_mutex_lock (&stream->event_queues_lock);
 
   /* No events queue? */
-  for (ite = xine_list_front (stream->event_queues);
-       ite; ite = xine_list_next (stream->event_queues, ite)) {
-    xine_event_queue_t *queue = xine_list_get_value(stream->event_queues, ite);
+  for (node = xine_ilist_front (&stream->event_queues);
+       node; node = xine_ilist_next (&stream->event_queues, node)) {
+    xine_event_queue_private_t *priv = xine_ilist_entry (node, xine_event_queue_private_t, node);
+    xine_event_queue_t *queue = &priv->queue;
     pthread_mutex_lock (&queue->lock);
     pthread_mutex_unlock (&stream->event_queues_lock);
 
@@ -828,7 +929,7 @@ void _x_flush_events_queues (xine_stream_t *stream) {
      * currently executing their callback functions.
      */
     if (queue->listener_thread != NULL && !queue->callback_running) {
-      while (!xine_list_empty (queue->events)) {
+      while (priv->events_count) {
         pthread_cond_wait (&queue->events_processed, &queue->lock);
       }
     }
@@ -1405,6 +1506,8 @@ static int play_internal (xine_stream_t *stream, int start_pos, int start_time)
   /* demux_lock taken. now demuxer is suspended */
   _x_action_lower(stream);
   pthread_cond_signal(&stream->demux_resume);
+  if (stream->demux_task)
+    _x_task_wake (stream->demux_task);
 
   /* set normal speed again (now that demuxer/input pair is suspended)
    * some input plugin may have changed speed by itself, we must ensure
@@ -1547,10 +1650,13 @@ static void xine_dispose_internal (xine_stream_t *stream) {
 
   stream->metronom->exit (stream->metronom);
 
-  xine_list_delete(stream->event_queues);
-
   _x_refcounter_dispose(stream->refcounter);
 
+  if (stream->demux_task) {
+    _x_task_wait (stream->demux_task);
+    free (stream->demux_task);
+  }
+
   free (stream->current_extra_info);
   free (stream->video_decoder_extra_info);
   free (stream->audio_decoder_extra_info);
@@ -1595,6 +1701,18 @@ void xine_exit (xine_t *this) {
 
   xprintf (this, XINE_VERBOSITY_DEBUG, "xine_exit: bye!\n");
 
+  pthread_mutex_lock (&this->instrument_lock);
+  this->instrument_quit = 1;
+  pthread_cond_signal (&this->instrument_wake);
+  pthread_mutex_unlock (&this->instrument_lock);
+  if (this->instrument_running)
+    pthread_join (this->instrument_thread, NULL);
+  pthread_mutex_destroy (&this->instrument_lock);
+  pthread_cond_destroy (&this->instrument_wake);
+
+  _x_latency_trace_open (this, NULL);
+  pthread_mutex_destroy (&this->latency_lock);
+
   for (i = 0; i < XINE_LOG_NUM; i++)
     if ( this->log_buffers[i] )
       this->log_buffers[i]->dispose (this->log_buffers[i]);
@@ -1609,6 +1727,8 @@ void xine_exit (xine_t *this) {
   if(this->clock)
     this->clock->exit (this->clock);
 
+  _x_executor_delete (this->executor);
+
   if(this->config)
     this->config->dispose(this->config);
 
@@ -1644,6 +1764,10 @@ xine_t *xine_new (void) {
   this->clock          = NULL;
   this->port_ticket    = NULL;
 
+  pthread_mutex_init (&this->instrument_lock, NULL);
+  pthread_cond_init (&this->instrument_wake, NULL);
+  pthread_mutex_init (&this->latency_lock, NULL);
+
 #ifdef ENABLE_NLS
   /*
    * i18n
@@ -1720,6 +1844,72 @@ static void config_demux_strategy_cb (void *this_gen, xine_cfg_entry_t *entry) {
   this->demux_strategy = entry->num_value;
 }
 
+static void config_free_run_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  xine_t *this = (xine_t *)this_gen;
+
+  this->clock->set_option (this->clock, CLOCK_FREE_RUN, entry->num_value);
+}
+
+static void instrument_print (void *this_gen, const char *line) {
+  xine_t *this = (xine_t *)this_gen;
+
+  xine_log (this, XINE_LOG_TRACE, "%s\n", line);
+}
+
+static void *instrument_loop (void *this_gen) {
+  xine_t          *this = (xine_t *)this_gen;
+  struct timeval   tv;
+  struct timespec  ts;
+
+  pthread_mutex_lock (&this->instrument_lock);
+  while (!this->instrument_quit) {
+    if (!this->instrument_interval) {
+      pthread_cond_wait (&this->instrument_wake, &this->instrument_lock);
+      continue;
+    }
+    gettimeofday (&tv, NULL);
+    ts.tv_sec  = tv.tv_sec + this->instrument_interval;
+    ts.tv_nsec = tv.tv_usec * 1000;
+    if (pthread_cond_timedwait (&this->instrument_wake, &this->instrument_lock, &ts) != ETIMEDOUT)
+      continue;
+    pthread_mutex_unlock (&this->instrument_lock);
+    if (xine_instrument_enabled)
+      xine_instrument_dump (instrument_print, this);
+    pthread_mutex_lock (&this->instrument_lock);
+  }
+  pthread_mutex_unlock (&this->instrument_lock);
+  return NULL;
+}
+
+static void instrument_set_interval (xine_t *this, int interval) {
+  pthread_mutex_lock (&this->instrument_lock);
+  this->instrument_interval = interval > 0 ? interval : 0;
+  if (this->instrument_interval && !this->instrument_running)
+    this->instrument_running = !pthread_create (&this->instrument_thread, NULL, instrument_loop, this);
+  pthread_cond_signal (&this->instrument_wake);
+  pthread_mutex_unlock (&this->instrument_lock);
+}
+
+static void config_instrument_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  xine_instrument_enable (entry->num_value);
+}
+
+static void config_instrument_dump_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  xine_t *this = (xine_t *)this_gen;
+
+  instrument_set_interval (this, entry->num_value);
+}
+
+static void config_latency_trace_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  _x_latency_enabled = entry->num_value;
+}
+
+static void config_latency_trace_file_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  xine_t *this = (xine_t *)this_gen;
+
+  _x_latency_trace_open (this, entry->str_value);
+}
+
 static void config_save_cb (void *this_gen, xine_cfg_entry_t *entry) {
   xine_t *this = (xine_t *)this_gen;
   char homedir_trail_slash[strlen(xine_get_homedir()) + 2];
@@ -1755,6 +1945,7 @@ void xine_set_flags (xine_t *this, int flags)
 void xine_init (xine_t *this) {
   static const char *const demux_strategies[] = {"default", "reverse", "content",
 						 "extension", NULL};
+  int i;
 
   /* First of all, initialise libxdg-basedir as it's used by plugins. */
   setenv ("HOME", xine_get_homedir (), 0); /* libxdg-basedir needs $HOME */
@@ -1840,6 +2031,22 @@ void xine_init (xine_t *this) {
 	"connection is lost."),
       0, NULL, this);
 
+  /*
+   * shared engine threads
+   */
+  i = this->config->register_num(this->config,
+      "engine.decoder.shared_threads", 0,
+      _("number of engine threads shared by all streams"),
+      _("With 0, every stream demuxes, decodes and outputs audio and video in "
+	"threads of its own. Otherwise the demuxers, decoders and output loops of "
+	"all streams run on a common set of threads, with at most this many busy "
+	"at the same time. This keeps the number of threads low when a lot of "
+	"streams are open at once.\n"
+	"Takes effect after restarting xine."),
+      30, NULL, NULL);
+  if (i > 0)
+    this->executor = _x_executor_new (i);
+
   /*
    * keep track of all opened streams
    */
@@ -1853,6 +2060,60 @@ void xine_init (xine_t *this) {
 
   this->clock->start_clock (this->clock, 0);
 
+  /*
+   * free-run clock for batch jobs
+   */
+  i = this->config->register_bool(this->config,
+      "engine.performance.free_run", 0,
+      _("run as fast as possible"),
+      _("Instead of following real time, the clock advances whenever the audio and "
+	"video outputs are ready for their next frame. Playback keeps audio and video "
+	"in sync and does not drop frames, but runs as fast as decoding allows.\n"
+	"This is meant for transcoding, analysis and other batch jobs with outputs "
+	"that do not pace themselves. Audio drivers other than none and file still "
+	"play in real time."),
+      30, config_free_run_cb, this);
+  this->clock->set_option (this->clock, CLOCK_FREE_RUN, i);
+
+  /*
+   * instrumentation
+   */
+  i = this->config->register_bool(this->config,
+      "engine.performance.instrument", 0,
+      _("count and time events in the engine"),
+      _("Keeps counters and latency histograms of decoding, buffer waits, "
+	"frame output, dropped frames and the like. This costs a little time; "
+	"applications can read the counters with xine_instrument_snapshot()."),
+      30, config_instrument_cb, this);
+  xine_instrument_enable (i);
+
+  i = this->config->register_num(this->config,
+      "engine.performance.instrument_dump", 0,
+      _("seconds between instrumentation reports"),
+      _("With instrumentation enabled, the counters are written to the trace log "
+	"this often. 0 turns the reports off."),
+      30, config_instrument_dump_cb, this);
+  instrument_set_interval (this, i);
+
+  /*
+   * pipeline latency tracing
+   */
+  _x_latency_enabled = this->config->register_bool(this->config,
+      "engine.performance.latency_trace", 0,
+      _("trace the latency of every frame"),
+      _("Notes when data is read, queued for and taken by the decoder, decoded "
+	"and finally shown or played, and sums up the time between these stages "
+	"per stream. Applications can read the result with xine_get_latency()."),
+      30, config_latency_trace_cb, this);
+
+  _x_latency_trace_open (this, this->config->register_filename(this->config,
+      "engine.performance.latency_trace_file", "", XINE_CONFIG_STRING_IS_FILENAME,
+      _("file to write the latency trace to"),
+      _("With latency tracing enabled, the stages of every frame are written "
+	"to this file in chrome trace event format, to be viewed with "
+	"chrome://tracing or ui.perfetto.dev. Leave it empty for no file."),
+      30, config_latency_trace_file_cb, this));
+
   /*
    * tickets
    */
@@ -609,6 +609,17 @@ int xine_get_param (xine_stream_t *stream, int param) {
     stream->xine->port_ticket->release(stream->xine->port_ticket, 0);
     break;
 
+  case XINE_PARAM_AUDIO_CLOCK_DRIFT:
+  case XINE_PARAM_AUDIO_CLOCK_JITTER:
+    stream->xine->port_ticket->acquire(stream->xine->port_ticket, 0);
+    if (!stream->audio_out)
+      ret = 0;
+    else
+      ret = stream->audio_out->get_property (stream->audio_out,
+             param == XINE_PARAM_AUDIO_CLOCK_DRIFT ? AO_PROP_CLOCK_DRIFT : AO_PROP_CLOCK_JITTER);
+    stream->xine->port_ticket->release(stream->xine->port_ticket, 0);
+    break;
+
   case XINE_PARAM_EQ_30HZ:
   case XINE_PARAM_EQ_60HZ:
   case XINE_PARAM_EQ_125HZ:
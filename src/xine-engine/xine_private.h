@@ -99,6 +99,154 @@ int _x_audio_decoder_init           (xine_stream_t *stream) INTERNAL;
 void _x_audio_decoder_shutdown      (xine_stream_t *stream) INTERNAL;
 ///@}
 
+///@{
+/**
+ * @defgroup
+ * @brief shared engine threads (see executor.c)
+ */
+typedef struct xine_executor_s xine_executor_t;
+typedef struct xine_task_s     xine_task_t;
+
+struct xine_task_s {
+  /* does whatever work is pending right now, then returns */
+  void             (*run) (xine_task_t *task);
+
+  /* private to executor.c */
+  xine_executor_t   *executor;
+  int                state;
+  int64_t            due;        /* timer, usec since the epoch */
+  xine_task_t       *next;
+};
+
+xine_executor_t *_x_executor_new    (int max_running) INTERNAL;
+void _x_executor_delete             (xine_executor_t *executor) INTERNAL;
+
+void _x_task_init                   (xine_task_t *task, xine_executor_t *executor,
+                                     void (*run) (xine_task_t *task)) INTERNAL;
+/* schedule a run, or another one if the task is running right now */
+void _x_task_wake                   (xine_task_t *task) INTERNAL;
+/* schedule a run in usec unless woken earlier. from inside the run, arms
+ * the timer for when it returns */
+void _x_task_wake_after             (xine_task_t *task, int usec) INTERNAL;
+/* wait until the task is neither queued, running nor timed */
+void _x_task_wait                   (xine_task_t *task) INTERNAL;
+
+/* bracket waits that may depend on other tasks, no-ops outside executor threads */
+void _x_executor_block_enter        (void) INTERNAL;
+void _x_executor_block_leave        (void) INTERNAL;
+///@}
+
+///@{
+/**
+ * @defgroup
+ * @brief fifo access for stages running as tasks
+ *
+ * only valid for fifos from _x_fifo_buffer_new()
+ */
+/* task is woken when a buffer is put or inserted, NULL to stop that */
+void _x_fifo_buffer_set_task        (fifo_buffer_t *fifo, xine_task_t *task) INTERNAL;
+/* returns NULL instead of waiting when the fifo is empty */
+buf_element_t *_x_fifo_buffer_try_get (fifo_buffer_t *fifo) INTERNAL;
+/* returns 1 when buffer_pool_alloc () would not wait. otherwise returns 0
+ * and wakes task once num buffers are free. NULL task forgets the last one */
+int _x_fifo_buffer_wait_free        (fifo_buffer_t *fifo, int num, xine_task_t *task) INTERNAL;
+///@}
+
+///@{
+/**
+ * @defgroup
+ * @brief free-run clock (see CLOCK_FREE_RUN, metronom.c)
+ *
+ * output loops register as clients. in free-run mode the clock only
+ * advances when every busy client waits for a later vpts.
+ */
+/* returns a client id, or -1 when all are in use */
+int _x_clock_client_new             (metronom_clock_t *clock) INTERNAL;
+void _x_clock_client_free           (metronom_clock_t *clock, int client) INTERNAL;
+/* client has nothing to present, don't hold the clock back */
+void _x_clock_free_run_idle         (metronom_clock_t *clock, int client) INTERNAL;
+/* client will have something to present soon, slow the clock down */
+void _x_clock_free_run_busy         (metronom_clock_t *clock, int client) INTERNAL;
+/* wait until the clock reaches vpts.
+ * returns 0 when not in free-run mode, 1 when reached, -1 after usec timeout */
+int _x_clock_free_run_wait          (metronom_clock_t *clock, int client,
+                                     int64_t vpts, int usec) INTERNAL;
+///@}
+
+///@{
+/**
+ * @defgroup
+ * @brief pipeline latency tracing (see XINE_LATENCY_*, latency.c)
+ */
+/* engine.performance.latency_trace */
+extern int _x_latency_enabled INTERNAL;
+/* note the time a buffer or frame passes a stage */
+#define _x_latency_stamp(info, stage) \
+  do { if (_x_latency_enabled && (info)) (info)->latency[stage] = xine_instrument_now (); } while (0)
+/* stamp XINE_LATENCY_OUTPUT and account the frame to the stream */
+void _x_latency_record              (xine_stream_t *stream, int type, extra_info_t *info) INTERNAL;
+void _x_latency_stream_init         (xine_stream_t *stream) INTERNAL;
+/* (re)start the chrome trace, NULL or "" to stop it */
+void _x_latency_trace_open          (xine_t *xine, const char *filename) INTERNAL;
+///@}
+
+///@{
+/**
+ * @defgroup
+ * @brief engine side of an event queue (see events.c)
+ *
+ * xine_event_new_queue() allocates this, the public struct keeps its
+ * layout and its events list is unused.
+ */
+typedef struct {
+  xine_event_queue_t              queue;
+
+  xine_ilist_node_t               node;            /* in stream->event_queues */
+  /* ring of pending events */
+  xine_event_t                  **events;
+  int                             events_size;     /* power of 2 */
+  int                             events_first;
+  int                             events_count;
+  int                             waiting;         /* threads in xine_event_wait() */
+  xine_event_batch_listener_cb_t  batch_callback;
+} xine_event_queue_private_t;
+///@}
+
+///@{
+/**
+ * @defgroup
+ * @brief clock recovery (clock_recovery.c)
+ *
+ * estimates offset and drift of a clock against the master clock from
+ * noisy measurements, and the rate to correct it by. all times in pts.
+ */
+typedef struct {
+  /* tuning */
+  double   tau;       /* memory of the estimate */
+  double   pull;      /* time to pull the offset back to zero */
+  double   deadband;  /* offsets up to this are left alone */
+  double   max_rate;  /* largest correction, relative */
+  double   max_slew;  /* largest change of the correction per pts */
+  /* estimate */
+  double   offset;    /* measured clock ahead of the master */
+  double   drift;     /* rate error, relative: the offset grows by drift per pts */
+  double   jitter;    /* mean deviation of measurements from the prediction */
+  double   rate;      /* correction, the offset shrinks by rate per pts */
+  double   span;      /* time measured, up to tau */
+  int64_t  last_time;
+  int      samples;
+  int      outliers;
+  int      acquire;
+} xine_clock_recovery_t;
+
+void _x_clock_recovery_init         (xine_clock_recovery_t *cr, int64_t tau, int64_t pull,
+                                     double max_rate) INTERNAL;
+/* forget the offset, and the drift too unless keep_drift */
+void _x_clock_recovery_reset        (xine_clock_recovery_t *cr, int keep_drift) INTERNAL;
+/* feed a measured offset, returns the correction rate to apply from now on */
+double _x_clock_recovery_update     (xine_clock_recovery_t *cr, int64_t time, int64_t error) INTERNAL;
+///@}
+
 /**
  * @brief Benchmark available memcpy methods
  */
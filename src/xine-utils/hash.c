@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <xine/attributes.h>
+#include <xine/hash.h>
+
+#define MIN_BITS      3
+#define MAX_BITS     30
+
+/* key/value pair */
+typedef struct {
+  const void *key;        /* NULL: empty */
+  void       *value;
+} xine_hash_slot_t;
+
+struct xine_hash_s {
+  xine_hash_slot_t        *slots;
+  unsigned int             bits;
+  unsigned int             mask;
+  unsigned int             size;    /* elements */
+  unsigned int             used;    /* elements and removed marks */
+
+  xine_hash_func_t         hash;
+  xine_hash_compare_func_t compare;
+};
+
+/* key of removed elements. probing goes on past them. */
+static const char removed_key;
+#define REMOVED (&removed_key)
+
+/* Fibonacci hashing: the upper bits of the product are well mixed */
+static unsigned int xine_hash_index(const xine_hash_t *hash, const void *key) {
+  uint32_t h;
+
+  if (hash->hash) {
+    h = hash->hash(key);
+  } else {
+    uintptr_t v = (uintptr_t)key;
+#if UINTPTR_MAX > 0xffffffff
+    v ^= v >> 32;
+#endif
+    h = (uint32_t)v;
+  }
+  return (uint32_t)(h * 0x9E3779B1u) >> (32 - hash->bits);
+}
+
+static int xine_hash_equal(const xine_hash_t *hash, const void *key1, const void *key2) {
+  if (key1 == key2)
+    return 1;
+  return hash->compare && !hash->compare(key1, key2);
+}
+
+/* Returns the slot of key, or the empty one where it belongs */
+static xine_hash_slot_t *xine_hash_lookup(const xine_hash_t *hash, const void *key) {
+  unsigned int i = xine_hash_index(hash, key);
+
+  while (1) {
+    xine_hash_slot_t *slot = &hash->slots[i];
+
+    if (!slot->key)
+      return slot;
+    if (slot->key != REMOVED && xine_hash_equal(hash, slot->key, key))
+      return slot;
+    i = (i + 1) & hash->mask;
+  }
+}
+
+static int xine_hash_alloc(xine_hash_t *hash, unsigned int bits) {
+  xine_hash_slot_t *slots;
+
+  slots = calloc((size_t)1 << bits, sizeof(xine_hash_slot_t));
+  if (!slots)
+    return 0;
+  hash->slots = slots;
+  hash->bits  = bits;
+  hash->mask  = (1u << bits) - 1;
+  hash->used  = 0;
+  return 1;
+}
+
+/* Moves all elements into a new table, dropping removed marks */
+static int xine_hash_rehash(xine_hash_t *hash, unsigned int bits) {
+  xine_hash_slot_t *old_slots = hash->slots;
+  unsigned int      old_count = hash->mask + 1;
+  unsigned int      i;
+
+  if (!xine_hash_alloc(hash, bits)) {
+    hash->slots = old_slots;
+    return 0;
+  }
+  for (i = 0; i < old_count; i++) {
+    if (old_slots[i].key && old_slots[i].key != REMOVED) {
+      unsigned int j = xine_hash_index(hash, old_slots[i].key);
+
+      while (hash->slots[j].key)
+        j = (j + 1) & hash->mask;
+      hash->slots[j] = old_slots[i];
+      hash->used++;
+    }
+  }
+  free(old_slots);
+  return 1;
+}
+
+xine_hash_t *xine_hash_new(unsigned int initial_size,
+                           xine_hash_func_t hash_func, xine_hash_compare_func_t compare) {
+  xine_hash_t  *hash;
+  unsigned int  bits = MIN_BITS;
+
+  /* keep below 3/4 load */
+  while (bits < MAX_BITS && ((1u << bits) / 4) * 3 <= initial_size)
+    bits++;
+
+  hash = (xine_hash_t *)malloc(sizeof(xine_hash_t));
+  if (!hash)
+    return NULL;
+  if (!xine_hash_alloc(hash, bits)) {
+    free(hash);
+    return NULL;
+  }
+  hash->size    = 0;
+  hash->hash    = hash_func;
+  hash->compare = compare;
+
+  return hash;
+}
+
+void xine_hash_delete(xine_hash_t *hash) {
+  if (hash) {
+    free(hash->slots);
+    free(hash);
+  }
+}
+
+unsigned int xine_hash_size(const xine_hash_t *hash) {
+  return hash->size;
+}
+
+void xine_hash_clear(xine_hash_t *hash) {
+  memset(hash->slots, 0, (hash->mask + 1) * sizeof(xine_hash_slot_t));
+  hash->size = 0;
+  hash->used = 0;
+}
+
+int xine_hash_put(xine_hash_t *hash, const void *key, void *value) {
+  xine_hash_slot_t *slot = xine_hash_lookup(hash, key);
+  xine_hash_slot_t *mark;
+  unsigned int      i;
+
+  if (slot->key) {
+    slot->value = value;
+    return 0;
+  }
+
+  /* reuse the first removed mark on the way, so that removing and adding
+     keys again does not fill the table with marks */
+  for (i = xine_hash_index(hash, key); (mark = &hash->slots[i]) != slot; i = (i + 1) & hash->mask) {
+    if (mark->key == REMOVED) {
+      mark->key   = key;
+      mark->value = value;
+      hash->size++;
+      return 1;
+    }
+  }
+
+  if (hash->used + 1 > ((hash->mask + 1) / 4) * 3) {
+    /* grow when full of elements, just clean up when full of marks */
+    unsigned int bits = hash->bits;
+
+    if (hash->size + 1 > ((hash->mask + 1) / 8) * 3 && bits < MAX_BITS)
+      bits++;
+    if (!xine_hash_rehash(hash, bits))
+      return -1;
+    slot = xine_hash_lookup(hash, key);
+  }
+
+  slot->key   = key;
+  slot->value = value;
+  hash->size++;
+  hash->used++;
+  return 1;
+}
+
+xine_hash_iterator_t xine_hash_find(xine_hash_t *hash, const void *key) {
+  xine_hash_slot_t *slot = xine_hash_lookup(hash, key);
+
+  return slot->key ? (xine_hash_iterator_t)slot : NULL;
+}
+
+void *xine_hash_get(xine_hash_t *hash, const void *key) {
+  xine_hash_slot_t *slot = xine_hash_lookup(hash, key);
+
+  return slot->key ? slot->value : NULL;
+}
+
+void xine_hash_remove_at(xine_hash_t *hash, xine_hash_iterator_t ite) {
+  xine_hash_slot_t *slot = (xine_hash_slot_t *)ite;
+
+  if (slot && slot->key && slot->key != REMOVED) {
+    /* the end of a probe sequence needs no mark */
+    if (!hash->slots[(slot - hash->slots + 1) & hash->mask].key) {
+      slot->key = NULL;
+      hash->used--;
+    } else
+      slot->key = REMOVED;
+    slot->value = NULL;
+    hash->size--;
+  }
+}
+
+int xine_hash_remove(xine_hash_t *hash, const void *key) {
+  xine_hash_slot_t *slot = xine_hash_lookup(hash, key);
+
+  if (!slot->key)
+    return 0;
+  xine_hash_remove_at(hash, slot);
+  return 1;
+}
+
+xine_hash_iterator_t xine_hash_next(xine_hash_t *hash, xine_hash_iterator_t ite) {
+  xine_hash_slot_t *slot = ite ? (xine_hash_slot_t *)ite + 1 : hash->slots;
+  xine_hash_slot_t *end  = hash->slots + hash->mask + 1;
+
+  for (; slot < end; slot++)
+    if (slot->key && slot->key != REMOVED)
+      return (xine_hash_iterator_t)slot;
+  return NULL;
+}
+
+const void *xine_hash_get_key(xine_hash_t *hash, xine_hash_iterator_t ite) {
+  return ((xine_hash_slot_t *)ite)->key;
+}
+
+void *xine_hash_get_value(xine_hash_t *hash, xine_hash_iterator_t ite) {
+  return ((xine_hash_slot_t *)ite)->value;
+}
+
+/* djb2 */
+unsigned int xine_hash_str(const void *key) {
+  const unsigned char *s = (const unsigned char *)key;
+  unsigned int         h = 5381;
+
+  while (*s)
+    h = h * 33 + *s++;
+  return h;
+}
+
+int xine_hash_str_compare(const void *key1, const void *key2) {
+  return strcmp((const char *)key1, (const char *)key2);
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * instrumentation - per thread tracepoint counters
+ *
+ * Each thread that hits a tracepoint gets a block of counters, written
+ * by that thread only. Blocks are chained for snapshots; when a thread
+ * exits, its counters are added to the retired block. Resetting bumps
+ * an epoch, and each thread clears its own block when it notices.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#define LOG_MODULE "instrument"
+
+#include <xine/xineutils.h>
+#include <xine/instrument.h>
+
+typedef struct {
+  uint64_t hits;
+  uint64_t timed;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t histogram[XINE_TP_BUCKETS];
+} tp_counters_t;
+
+typedef struct instrument_block_s instrument_block_t;
+struct instrument_block_s {
+  instrument_block_t *next;
+  int                 epoch;
+  tp_counters_t       tp[XINE_TRACEPOINTS_MAX];
+};
+
+int xine_instrument_enabled = 0;
+
+static pthread_mutex_t     instrument_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t       instrument_key;
+static pthread_once_t      instrument_once = PTHREAD_ONCE_INIT;
+
+/* below protected by instrument_lock */
+static const char         *tp_names[XINE_TRACEPOINTS_MAX];
+static int                 tp_count = 1;  /* id 0 means unassigned */
+static instrument_block_t *blocks;
+static instrument_block_t  retired;
+static int                 epoch;
+
+static void block_add (instrument_block_t *dst, const instrument_block_t *src) {
+  int i, b;
+
+  for (i = 1; i < tp_count; i++) {
+    tp_counters_t       *d = &dst->tp[i];
+    const tp_counters_t *s = &src->tp[i];
+
+    d->hits     += s->hits;
+    d->timed    += s->timed;
+    d->total_ns += s->total_ns;
+    if (s->max_ns > d->max_ns)
+      d->max_ns = s->max_ns;
+    for (b = 0; b < XINE_TP_BUCKETS; b++)
+      d->histogram[b] += s->histogram[b];
+  }
+}
+
+static void block_free (void *block_gen) {
+  instrument_block_t  *block = (instrument_block_t *) block_gen;
+  instrument_block_t **b;
+
+  pthread_mutex_lock (&instrument_lock);
+  for (b = &blocks; *b; b = &(*b)->next) {
+    if (*b == block) {
+      *b = block->next;
+      break;
+    }
+  }
+  if (block->epoch == epoch)
+    block_add (&retired, block);
+  pthread_mutex_unlock (&instrument_lock);
+
+  free (block);
+}
+
+static void instrument_init (void) {
+  pthread_key_create (&instrument_key, block_free);
+}
+
+static instrument_block_t *get_block (void) {
+  instrument_block_t *block;
+
+  pthread_once (&instrument_once, instrument_init);
+
+  block = pthread_getspecific (instrument_key);
+  if (!block) {
+    block = calloc (1, sizeof (instrument_block_t));
+    if (!block)
+      return NULL;
+    pthread_mutex_lock (&instrument_lock);
+    block->epoch = epoch;
+    block->next  = blocks;
+    blocks       = block;
+    pthread_mutex_unlock (&instrument_lock);
+    pthread_setspecific (instrument_key, block);
+  } else if (block->epoch != epoch) {
+    /* reset since we last counted. a snapshot might add up our stale
+     * counters meanwhile, which is as good as any other race with it. */
+    memset (block->tp, 0, sizeof (block->tp));
+    block->epoch = epoch;
+  }
+  return block;
+}
+
+static int tp_register (xine_tracepoint_t *tp) {
+  int id;
+
+  pthread_mutex_lock (&instrument_lock);
+  if (!tp->id) {
+    for (id = 1; id < tp_count; id++)
+      if (!strcmp (tp_names[id], tp->name))
+        break;
+    if (id == tp_count) {
+      if (tp_count < XINE_TRACEPOINTS_MAX)
+        tp_names[tp_count++] = tp->name;
+      else
+        id = -1;
+    }
+    tp->id = id;
+  }
+  id = tp->id;
+  pthread_mutex_unlock (&instrument_lock);
+
+  return id;
+}
+
+static tp_counters_t *tp_counters (xine_tracepoint_t *tp) {
+  instrument_block_t *block;
+  int                 id = tp->id;
+
+  if (!id)
+    id = tp_register (tp);
+  if (id < 0 || !(block = get_block ()))
+    return NULL;
+  return &block->tp[id];
+}
+
+uint64_t xine_instrument_now (void) {
+#if _POSIX_TIMERS > 0 && defined(_POSIX_MONOTONIC_CLOCK) && defined(HAVE_POSIX_TIMERS)
+  struct timespec ts;
+
+  if (!clock_gettime (CLOCK_MONOTONIC, &ts))
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec + 1;
+#endif
+  {
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return (uint64_t) tv.tv_sec * 1000000000 + (uint64_t) tv.tv_usec * 1000 + 1;
+  }
+}
+
+void xine_tp_hit_int (xine_tracepoint_t *tp, int64_t n) {
+  tp_counters_t *c = tp_counters (tp);
+
+  if (c)
+    c->hits += n;
+}
+
+void xine_tp_time_int (xine_tracepoint_t *tp, uint64_t start) {
+  tp_counters_t *c;
+  uint64_t       ns, v;
+  int            bucket;
+
+  ns = xine_instrument_now () - start;
+  if (!(c = tp_counters (tp)))
+    return;
+
+  c->timed++;
+  c->total_ns += ns;
+  if (ns > c->max_ns)
+    c->max_ns = ns;
+
+  v = ns >> 11;
+#if defined(__GNUC__)
+  bucket = v ? 64 - __builtin_clzll (v) : 0;
+#else
+  for (bucket = 0; v; bucket++)
+    v >>= 1;
+#endif
+  if (bucket >= XINE_TP_BUCKETS)
+    bucket = XINE_TP_BUCKETS - 1;
+  c->histogram[bucket]++;
+}
+
+void xine_instrument_enable (int enable) {
+  xine_instrument_enabled = !!enable;
+}
+
+int xine_instrument_snapshot (xine_tp_stats_t *stats, int max) {
+  instrument_block_t *sum, *block;
+  int                 i, n;
+
+  sum = malloc (sizeof (instrument_block_t));
+  if (!sum)
+    return 0;
+
+  pthread_mutex_lock (&instrument_lock);
+
+  memcpy (sum, &retired, sizeof (instrument_block_t));
+  for (block = blocks; block; block = block->next)
+    if (block->epoch == epoch)
+      block_add (sum, block);
+
+  n = tp_count - 1;
+  if (n > max)
+    n = max;
+  for (i = 0; i < n; i++) {
+    stats[i].name     = tp_names[i + 1];
+    stats[i].hits     = sum->tp[i + 1].hits;
+    stats[i].timed    = sum->tp[i + 1].timed;
+    stats[i].total_ns = sum->tp[i + 1].total_ns;
+    stats[i].max_ns   = sum->tp[i + 1].max_ns;
+    memcpy (stats[i].histogram, sum->tp[i + 1].histogram, sizeof (stats[i].histogram));
+  }
+
+  pthread_mutex_unlock (&instrument_lock);
+
+  free (sum);
+  return n;
+}
+
+void xine_instrument_reset (void) {
+  pthread_mutex_lock (&instrument_lock);
+  memset (&retired, 0, sizeof (retired));
+  epoch++;
+  pthread_mutex_unlock (&instrument_lock);
+}
+
+uint64_t xine_tp_stats_percentile (const xine_tp_stats_t *stats, double fraction) {
+  uint64_t want, seen = 0;
+  int      b;
+
+  if (!stats->timed)
+    return 0;
+
+  want = fraction * stats->timed;
+  for (b = 0; b < XINE_TP_BUCKETS - 1; b++) {
+    seen += stats->histogram[b];
+    if (seen > want)
+      break;
+  }
+  /* upper limit of the bucket, but not more than seen at all */
+  if (b == XINE_TP_BUCKETS - 1)
+    return stats->max_ns;
+  return ((uint64_t) 2048 << b) < stats->max_ns ? ((uint64_t) 2048 << b) : stats->max_ns;
+}
+
+void xine_instrument_dump (void (*print) (void *data, const char *line), void *data) {
+  xine_tp_stats_t *stats;
+  char             line[160];
+  int              i, n;
+
+  stats = malloc (XINE_TRACEPOINTS_MAX * sizeof (xine_tp_stats_t));
+  if (!stats)
+    return;
+
+  n = xine_instrument_snapshot (stats, XINE_TRACEPOINTS_MAX);
+
+  snprintf (line, sizeof (line), "%-32s %10s %10s %10s %10s %10s %10s",
+            "tracepoint", "hits", "timed", "avg us", "p50 us", "p99 us", "max us");
+  print (data, line);
+
+  for (i = 0; i < n; i++) {
+    const xine_tp_stats_t *s = &stats[i];
+
+    if (!s->hits && !s->timed)
+      continue;
+    if (s->timed)
+      snprintf (line, sizeof (line), "%-32.32s %10" PRIu64 " %10" PRIu64 " %10.1f %10.1f %10.1f %10.1f",
+                s->name, s->hits, s->timed,
+                s->total_ns / 1000.0 / s->timed,
+                xine_tp_stats_percentile (s, 0.5) / 1000.0,
+                xine_tp_stats_percentile (s, 0.99) / 1000.0,
+                s->max_ns / 1000.0);
+    else
+      snprintf (line, sizeof (line), "%-32.32s %10" PRIu64, s->name, s->hits);
+    print (data, line);
+  }
+
+  free (stats);
+}
@@ -25,136 +25,80 @@
 #endif
 
 #include <stdio.h>
-#include <sys/time.h>
+#include <pthread.h>
 #include <xine/xineutils.h>
+#include <xine/instrument.h>
 
-#define MAX_ID 10
+/*
+ * the old slot based profiler, now a front end to the tracepoints of
+ * instrument.c. start times are kept per thread.
+ */
 
-#ifndef NDEBUG
+#define MAX_ID 10
 
-typedef struct {
-    uint64_t    p_times;
-    uint64_t    p_start;
-    long        p_calls;
-    const char *p_label;
-} xine_profiler_t;
+static xine_tracepoint_t profiler[MAX_ID];
+static pthread_mutex_t   profiler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t     profiler_key;
+static pthread_once_t    profiler_once = PTHREAD_ONCE_INIT;
 
-static xine_profiler_t profiler[MAX_ID];
+static void profiler_key_init (void) {
+  pthread_key_create (&profiler_key, free);
+}
 
-void xine_profiler_init () {
-  memset(profiler, 0, sizeof(profiler));
+void xine_profiler_init (void) {
+  xine_instrument_reset ();
+  xine_instrument_enable (1);
 }
 
 int xine_profiler_allocate_slot (const char *label) {
   int id;
 
-  for (id = 0; id < MAX_ID && profiler[id].p_label != NULL; id++)
+  pthread_mutex_lock (&profiler_lock);
+  for (id = 0; id < MAX_ID && profiler[id].name != NULL; id++)
     ;
+  if (id < MAX_ID)
+    profiler[id].name = label;
+  else
+    id = -1;
+  pthread_mutex_unlock (&profiler_lock);
 
-  if (id >= MAX_ID)
-    return -1;
-
-  profiler[id].p_label = label;
   return id;
 }
 
-
-#if defined(ARCH_X86_32)
-static __inline__ uint64_t rdtsc(void)
-{
-  unsigned long long int x;
-  __asm__ volatile ("rdtsc\n\t" : "=A" (x));
-  return x;
-}
-#elif defined(ARCH_X86_64)
-static __inline__ uint64_t rdtsc(void)
-{
-  unsigned long long int a, d;
-  __asm__ volatile ("rdtsc\n\t" : "=a" (a), "=d" (d));
-  return (d << 32) | (a & 0xffffffff);
-}
-#endif
-
 void xine_profiler_start_count (int id) {
-  if ( id >= MAX_ID || id < 0 ) return;
-
-#if defined(ARCH_X86) || defined(ARCH_X86_64)
-  profiler[id].p_start = rdtsc();
-#endif
-}
+  uint64_t *start;
 
-void xine_profiler_stop_count (int id) {
-  if ( id >= MAX_ID || id < 0 ) return;
+  if ( id >= MAX_ID || id < 0 || !xine_instrument_enabled ) return;
 
-#if defined(ARCH_X86) || defined(ARCH_X86_64)
-  profiler[id].p_times += rdtsc() - profiler[id].p_start;
-#endif
-  profiler[id].p_calls++;
+  pthread_once (&profiler_once, profiler_key_init);
+  start = pthread_getspecific (profiler_key);
+  if (!start) {
+    start = calloc (MAX_ID, sizeof (uint64_t));
+    if (!start)
+      return;
+    pthread_setspecific (profiler_key, start);
+  }
+  start[id] = xine_instrument_now ();
 }
 
-void xine_profiler_print_results (void) {
-  int i;
-
-#if defined(ARCH_X86) || defined(ARCH_X86_64)
-  static uint64_t cpu_speed;	/* cpu cyles/usec */
-
-  if (!cpu_speed) {
-    uint64_t tsc_start, tsc_end;
-    struct timeval tv_start, tv_end;
-
-    tsc_start = rdtsc();
-    gettimeofday(&tv_start, NULL);
-
-    xine_usec_sleep(100000);
-
-    tsc_end = rdtsc();
-    gettimeofday(&tv_end, NULL);
+void xine_profiler_stop_count (int id) {
+  uint64_t *start;
 
-    cpu_speed = (tsc_end - tsc_start) /
-	((tv_end.tv_sec - tv_start.tv_sec) * 1e6 +
-	 tv_end.tv_usec - tv_start.tv_usec);
-  }
-#endif
+  if ( id >= MAX_ID || id < 0 ) return;
 
-  printf ("\n\nPerformance analysis:\n\n"
-	  "%-3s %-24.24s %12s %9s %12s %9s\n"
-	  "----------------------------------------------------------------------------\n",
-	  "ID", "name", "cpu cycles", "calls", "cycles/call", "usec/call");
-  for (i=0; i<MAX_ID; i++) {
-    if (profiler[i].p_label) {
-      printf ("%2d: %-24.24s %12lld %9ld",
-	      i, profiler[i].p_label, profiler[i].p_times, profiler[i].p_calls);
-      if (profiler[i].p_calls) {
-	  printf(" %12lld", profiler[i].p_times / profiler[i].p_calls);
-#if defined(ARCH_X86) || defined(ARCH_X86_64)
-	  printf(" %9lld", profiler[i].p_times / (cpu_speed * profiler[i].p_calls));
-#endif
-      }
-      printf ("\n");
-    }
+  pthread_once (&profiler_once, profiler_key_init);
+  start = pthread_getspecific (profiler_key);
+  if (start && start[id]) {
+    xine_tp_time_int (&profiler[id], start[id]);
+    start[id] = 0;
   }
 }
 
-
-#else /* DEBUG */
-
-#define NO_PROFILER_MSG  {printf("xine's profiler is unavailable.\n");}
-
-/* Dummies */
-void xine_profiler_init (void) {
-  NO_PROFILER_MSG
-}
-int xine_profiler_allocate_slot (const char *label) {
-  return -1;
-}
-void xine_profiler_start_count (int id) {
-}
-void xine_profiler_stop_count (int id) {
+static void profiler_print_line (void *data, const char *line) {
+  printf ("%s\n", line);
 }
+
 void xine_profiler_print_results (void) {
-  NO_PROFILER_MSG
+  printf ("\n\nPerformance analysis:\n\n");
+  xine_instrument_dump (profiler_print_line, NULL);
 }
-
-#endif
-
-
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2000-2010 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+#include <xine/attributes.h>
+#include <xine/worker_pool.h>
+
+#define MAX_WORKER_THREADS 16
+
+struct xine_worker_pool_s {
+  pthread_t         *threads;
+  int                num_threads;
+
+  /* serializes xine_worker_pool_run() callers */
+  pthread_mutex_t    run_lock;
+
+  /* protects everything below */
+  pthread_mutex_t    lock;
+  pthread_cond_t     work_cond;
+  pthread_cond_t     done_cond;
+
+  xine_worker_job_t  job;
+  void              *data;
+  int                num_slices;
+  int                next_slice;   /* next slice to hand out */
+  int                pending;      /* slices not finished yet */
+
+  int                quit;
+};
+
+/* Takes the next slice of the current run and processes it.
+ * Called and returns with pool->lock held.
+ * Returns 0 if there was nothing left to hand out.
+ */
+static int xine_worker_pool_do_slice(xine_worker_pool_t *pool) {
+  int slice;
+
+  if (pool->next_slice >= pool->num_slices)
+    return 0;
+
+  slice = pool->next_slice++;
+  pthread_mutex_unlock(&pool->lock);
+
+  pool->job(pool->data, slice, pool->num_slices);
+
+  pthread_mutex_lock(&pool->lock);
+  if (!--pool->pending)
+    pthread_cond_signal(&pool->done_cond);
+  return 1;
+}
+
+static void *xine_worker_pool_loop(void *this_gen) {
+  xine_worker_pool_t *pool = (xine_worker_pool_t *)this_gen;
+
+  pthread_mutex_lock(&pool->lock);
+  while (!pool->quit) {
+    if (!xine_worker_pool_do_slice(pool))
+      pthread_cond_wait(&pool->work_cond, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+xine_worker_pool_t *xine_worker_pool_new(int num_threads) {
+  xine_worker_pool_t *pool;
+  int i;
+
+  if (num_threads <= 0) {
+    num_threads = 0;
+#ifdef _SC_NPROCESSORS_ONLN
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+#endif
+    if (num_threads < 0)
+      num_threads = 0;
+  }
+  if (num_threads > MAX_WORKER_THREADS)
+    num_threads = MAX_WORKER_THREADS;
+
+  pool = calloc(1, sizeof(xine_worker_pool_t));
+  if (!pool)
+    return NULL;
+
+  pthread_mutex_init(&pool->run_lock, NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_cond, NULL);
+  pthread_cond_init(&pool->done_cond, NULL);
+
+  if (num_threads)
+    pool->threads = calloc(num_threads, sizeof(pthread_t));
+
+  if (pool->threads) {
+    for (i = 0; i < num_threads; i++) {
+      if (pthread_create(&pool->threads[i], NULL, xine_worker_pool_loop, pool))
+        break;
+    }
+    pool->num_threads = i;
+  }
+
+  return pool;
+}
+
+void xine_worker_pool_delete(xine_worker_pool_t *pool) {
+  int i;
+
+  if (!pool)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = 1;
+  pthread_cond_broadcast(&pool->work_cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (i = 0; i < pool->num_threads; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  pthread_cond_destroy(&pool->done_cond);
+  pthread_cond_destroy(&pool->work_cond);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_mutex_destroy(&pool->run_lock);
+  free(pool->threads);
+  free(pool);
+}
+
+int xine_worker_pool_size(xine_worker_pool_t *pool) {
+  return pool ? pool->num_threads + 1 : 1;
+}
+
+void xine_worker_pool_run(xine_worker_pool_t *pool, int num_slices,
+                          xine_worker_job_t job, void *data) {
+  int i;
+
+  if (num_slices <= 0)
+    return;
+
+  if (!pool || !pool->num_threads || num_slices == 1) {
+    for (i = 0; i < num_slices; i++)
+      job(data, i, num_slices);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->run_lock);
+  pthread_mutex_lock(&pool->lock);
+
+  assert(!pool->pending);
+  pool->job        = job;
+  pool->data       = data;
+  pool->num_slices = num_slices;
+  pool->next_slice = 0;
+  pool->pending    = num_slices;
+  pthread_cond_broadcast(&pool->work_cond);
+
+  /* help out instead of just waiting */
+  while (xine_worker_pool_do_slice(pool))
+    ;
+  while (pool->pending)
+    pthread_cond_wait(&pool->done_cond, &pool->lock);
+
+  pool->job  = NULL;
+  pool->data = NULL;
+
+  pthread_mutex_unlock(&pool->lock);
+  pthread_mutex_unlock(&pool->run_lock);
+}
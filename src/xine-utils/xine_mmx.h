@@ -533,6 +533,56 @@ typedef	union {
 
 #define pmaddubsw_r2r(regs, regd)  mmx_r2r(pmaddubsw, regs, regd)
 
+/* AVX2 */
+
+typedef	union {
+	int64_t			q[4];	/* Quadword (64-bit) value */
+	uint64_t		uq[4];	/* Unsigned Quadword */
+	int32_t			d[8];	/* Doubleword (32-bit) values */
+	uint32_t		ud[8];	/* Unsigned Doubleword */
+	short			w[16];	/* Word (16-bit) values */
+	unsigned short		uw[16];	/* Unsigned Word */
+	char			b[32];	/* Byte (8-bit) values */
+	unsigned char		ub[32];	/* Unsigned Byte */
+} ATTR_ALIGN(32) avx_t;	/* On a 32 byte (256-bit) boundary */
+
+/* three operand forms with the destination as first source, so that
+ * vpaddd_r2r (ymm1, ymm0) adds ymm1 to ymm0 like paddd_r2r () does */
+#define	avx_r2r(op,regs,regd) \
+	__asm__ __volatile__ (#op " %" #regs ", %" #regd ", %" #regd)
+
+#define	avx_r2ri(op,regs,regd,imm) \
+	__asm__ __volatile__ (#op " %0, %%" #regs ", %%" #regd \
+			      : /* nothing */ \
+			      : "i" (imm) )
+
+#define	vzeroupper() __asm__ __volatile__ ("vzeroupper")
+
+#define	vmovd_m2r(var, reg)	mmx_m2r (vmovd, var, reg)
+
+#define	vmovdqa_r2r(regs, regd)	mmx_r2r (vmovdqa, regs, regd)
+
+#define	vmovdqu_m2r(var, reg)	mmx_m2r (vmovdqu, var, reg)
+#define	vmovdqu_r2m(reg, var)	mmx_r2m (vmovdqu, reg, var)
+
+#define	vpmovzxbw_m2r(var, reg)	mmx_m2r (vpmovzxbw, var, reg)
+#define	vpmovzxbd_m2r(var, reg)	mmx_m2r (vpmovzxbd, var, reg)
+
+#define	vpackssdw_r2r(regs, regd)	avx_r2r (vpackssdw, regs, regd)
+#define	vpackuswb_r2r(regs, regd)	avx_r2r (vpackuswb, regs, regd)
+
+#define	vpaddd_r2r(regs, regd)	avx_r2r (vpaddd, regs, regd)
+#define	vpaddw_r2r(regs, regd)	avx_r2r (vpaddw, regs, regd)
+#define	vpsubw_r2r(regs, regd)	avx_r2r (vpsubw, regs, regd)
+
+#define	vpmulhw_r2r(regs, regd)	avx_r2r (vpmulhw, regs, regd)
+#define	vpmullw_r2r(regs, regd)	avx_r2r (vpmullw, regs, regd)
+
+/* count in the low quadword of an xmm register */
+#define	vpsrld_r2r(regs, regd)	avx_r2r (vpsrld, regs, regd)
+
+#define	vpermq_r2r(regs, regd, imm)	avx_r2ri (vpermq, regs, regd, imm)
+
 
 #endif /*ARCH_X86 */
 